@@ -32,15 +32,26 @@ uint8_t CardType;
 CARDCONFIG CardConfig;
 uint8_t spi_div_low = 250;
 uint8_t spi_div_high = 10;
+static uint32_t spi_clock_high = 1000000;	/* Highest SSP clock for data transfers, 1MHz unless set */
+
+void SD_SetClockRate (uint32_t hz)
+{
+	if (hz) spi_clock_high = hz;
+}
 
 DSTATUS MMC_disk_initialize(void)
 {
-	/* Setting SPI Speed */
+	uint32_t div_high;
+
+	/* Setting SPI Speed, the divider must be even and between 2 and 254 */
 	spi_div_low  = SystemCoreClock / 400000; 					/* 400KHz */
-	spi_div_high = (SystemCoreClock + 1000000 - 1) / 1000000;	/* 1MHz */
+	div_high = (SystemCoreClock + spi_clock_high - 1) / spi_clock_high;
 
 	if(spi_div_low & 1) spi_div_low++;
-	if(spi_div_high & 1) spi_div_high++;
+	if(div_high < 2) div_high = 2;
+	if(div_high & 1) div_high++;
+	if(div_high > 254) div_high = 254;
+	spi_div_high = div_high;
 
 	if (SD_Init() && SD_ReadConfiguration()) status &= ~STA_NOINIT;
 
@@ -92,6 +92,7 @@ DRESULT MMC_disk_write(BYTE *buff, DWORD sector, UINT count);
 DRESULT MMC_disk_ioctl (BYTE cmd, void *buff);	/* Always add in diskio.c */
 
 /* Public functions */
+void        SD_SetClockRate (uint32_t hz);	/* Highest SPI clock after the next MMC_disk_initialize() */
 SD_BOOL     SD_Init (void);
 SD_BOOL     SD_ReadSector (uint32_t sect, uint8_t *buf, uint32_t cnt);
 SD_BOOL     SD_WriteSector (uint32_t sect, const uint8_t *buf, uint32_t cnt);
@@ -0,0 +1,347 @@
+/*
+ * Audio_Device.c
+ *
+ * Virtual USB Audio 1.0 capture and playback device, see Audio_Device.h.
+ */
+
+#include <string.h>
+
+#include "Audio_Device.h"
+
+#define MIN(a, b)					(((a) < (b)) ? (a) : (b))
+
+/* Control transfer stages */
+#define CONTROL_IDLE				0
+#define CONTROL_DATA_IN				1
+#define CONTROL_DATA_OUT			2
+#define CONTROL_STATUS_IN			3
+#define CONTROL_STALLED				4
+
+#define CAPTURE_INTERFACE			1
+#define PLAYBACK_INTERFACE			2
+#define LEVEL_SETTLE_FRAMES			100		/* playback level extremes are tracked once the host has primed its transfers */
+
+#define RATE_Q16(ppm)				((uint32_t) ((((uint64_t) AUDIO_DEVICE_SAMPLE_RATE << 16) * (1000000 + (ppm))) / 1000000000ULL))
+
+static const uint8_t DeviceDescriptor[] = {
+	18, 0x01, 0x10, 0x01, 0x00, 0x00, 0x00, 64,
+	0xC9, 0x1F, 0x0D, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01
+};
+
+static const uint8_t ConfigurationDescriptor[] = {
+	/* Configuration */
+	9, 0x02, 141, 0, 3, 1, 0, 0x80, 50,
+	/* Interface 0: Audio Control, header naming both streaming interfaces */
+	9, 0x04, 0, 0, 0, 0x01, 0x01, 0x00, 0,
+	10, 0x24, 0x01, 0x00, 0x01, 10, 0, 2, CAPTURE_INTERFACE, PLAYBACK_INTERFACE,
+	/* Interface 1: capture, alternate 1 streams */
+	9, 0x04, CAPTURE_INTERFACE, 0, 0, 0x01, 0x02, 0x00, 0,
+	9, 0x04, CAPTURE_INTERFACE, 1, 1, 0x01, 0x02, 0x00, 0,
+	7, 0x24, 0x01, 0, 1, 0x01, 0x00,
+	11, 0x24, 0x02, 0x01, 2, 2, 16, 1, 0x80, 0xBB, 0x00,
+	9, 0x05, 0x80 | AUDIO_DEVICE_CAPTURE_ENDPOINT, 0x05, AUDIO_DEVICE_PACKET_SIZE, 0, 1, 0, 0,
+	7, 0x25, 0x01, 0x01, 0, 0, 0,
+	/* Interface 2: playback, asynchronous OUT synchronised by the feedback endpoint */
+	9, 0x04, PLAYBACK_INTERFACE, 0, 0, 0x01, 0x02, 0x00, 0,
+	9, 0x04, PLAYBACK_INTERFACE, 1, 2, 0x01, 0x02, 0x00, 0,
+	7, 0x24, 0x01, 0, 1, 0x01, 0x00,
+	11, 0x24, 0x02, 0x01, 2, 2, 16, 1, 0x80, 0xBB, 0x00,
+	9, 0x05, AUDIO_DEVICE_PLAYBACK_ENDPOINT, 0x05, AUDIO_DEVICE_PACKET_SIZE, 0, 1, 0, 0x80 | AUDIO_DEVICE_FEEDBACK_ENDPOINT,
+	7, 0x25, 0x01, 0x01, 0, 0, 0,
+	9, 0x05, 0x80 | AUDIO_DEVICE_FEEDBACK_ENDPOINT, 0x01, 3, 0, 1, AUDIO_DEVICE_FEEDBACK_REFRESH, 0
+};
+
+static uint32_t GetLE32(const uint8_t *Data)
+{
+	return Data[0] | (Data[1] << 8) | (Data[2] << 16) | ((uint32_t) Data[3] << 24);
+}
+
+static void PutLE32(uint8_t *Data, uint32_t Value)
+{
+	Data[0] = Value;
+	Data[1] = Value >> 8;
+	Data[2] = Value >> 16;
+	Data[3] = Value >> 24;
+}
+
+/*==========================================================================*/
+/* Streaming endpoints                                                     */
+/*==========================================================================*/
+static OhciSim_Handshake_t CaptureIn(Audio_Device_t *Audio, uint8_t *Data, uint16_t MaxLength, uint16_t *Length)
+{
+	uint32_t Samples;
+	uint32_t i;
+
+	if (Audio->AltSetting[CAPTURE_INTERFACE] == 0)
+		return OHCISIM_NO_RESPONSE;
+
+	Audio->CaptureRemainder += Audio->CaptureRate;
+	Samples = MIN(Audio->CaptureRemainder >> 16, MaxLength / AUDIO_DEVICE_FRAME_SIZE);
+	Audio->CaptureRemainder &= 0xFFFF;
+
+	for (i = 0; i < Samples; i++)
+		PutLE32(&Data[i * AUDIO_DEVICE_FRAME_SIZE], Audio->CaptureIndex++);
+
+	*Length = Samples * AUDIO_DEVICE_FRAME_SIZE;
+	Audio->CapturePackets++;
+	return OHCISIM_ACK;
+}
+
+static OhciSim_Handshake_t PlaybackOut(Audio_Device_t *Audio, const uint8_t *Data, uint16_t Length)
+{
+	uint64_t Frame = OhciSim_GetFrameNumber();
+	uint32_t Sample;
+	uint32_t i;
+	int64_t  Level;
+
+	if (Audio->AltSetting[PLAYBACK_INTERFACE] == 0)
+		return OHCISIM_NO_RESPONSE;
+
+	if (!Audio->PlaybackStarted)
+	{
+		Audio->PlaybackStarted    = true;
+		Audio->PlaybackStartFrame = Frame;
+		Audio->PlaybackExpected   = GetLE32(Data);
+	}
+
+	/* Silence is the host running dry, anything else must continue the index pattern */
+	for (i = 0; (i + AUDIO_DEVICE_FRAME_SIZE) <= Length; i += AUDIO_DEVICE_FRAME_SIZE)
+	{
+		Sample = GetLE32(&Data[i]);
+		if ((Sample == 0) && (Audio->PlaybackExpected != 0))
+		{
+			Audio->PlaybackSilent++;
+			continue;
+		}
+		if (Sample != Audio->PlaybackExpected)
+			Audio->PlaybackGaps++;
+		Audio->PlaybackExpected = Sample + 1;
+	}
+
+	Audio->PlaybackReceived += Length / AUDIO_DEVICE_FRAME_SIZE;
+	Audio->PlaybackPackets++;
+
+	if ((Frame - Audio->PlaybackStartFrame) >= LEVEL_SETTLE_FRAMES)
+	{
+		Level = Audio_Device_GetPlaybackLevel(Audio);
+		if ((Audio->LevelMin == 0) && (Audio->LevelMax == 0))
+			Audio->LevelMin = Audio->LevelMax = Level;
+		if (Level < Audio->LevelMin)
+			Audio->LevelMin = Level;
+		if (Level > Audio->LevelMax)
+			Audio->LevelMax = Level;
+	}
+	return OHCISIM_ACK;
+}
+
+/* 10.14 sample frames per frame at the playback clock, what a device measures against SOF */
+static OhciSim_Handshake_t FeedbackIn(Audio_Device_t *Audio, uint8_t *Data, uint16_t MaxLength, uint16_t *Length)
+{
+	uint32_t Feedback = Audio->PlaybackRate >> 2;
+
+	if ((Audio->AltSetting[PLAYBACK_INTERFACE] == 0) || (MaxLength < 3))
+		return OHCISIM_NO_RESPONSE;
+
+	Data[0] = Feedback;
+	Data[1] = Feedback >> 8;
+	Data[2] = Feedback >> 16;
+	*Length = 3;
+	Audio->FeedbackPackets++;
+	return OHCISIM_ACK;
+}
+
+/*==========================================================================*/
+/* Control endpoint                                                        */
+/*==========================================================================*/
+static void ControlReply(Audio_Device_t *Audio, const uint8_t *Data, uint16_t Length, uint16_t wLength)
+{
+	Audio->ControlLength = MIN(MIN(Length, wLength), sizeof(Audio->ControlData));
+	memcpy(Audio->ControlData, Data, Audio->ControlLength);
+}
+
+static OhciSim_Handshake_t Setup(OhciSim_Device_t *Device, const uint8_t *Request)
+{
+	Audio_Device_t *Audio = (Audio_Device_t *) Device;
+	uint8_t  bmRequestType = Request[0];
+	uint8_t  bRequest = Request[1];
+	uint16_t wValue = Request[2] | (Request[3] << 8);
+	uint16_t wIndex = Request[4] | (Request[5] << 8);
+	uint16_t wLength = Request[6] | (Request[7] << 8);
+	uint8_t  Reply[3] = {0, 0, 0};
+	bool     Supported = true;
+
+	Audio->ControlLength = 0;
+	Audio->ControlOffset = 0;
+	Audio->PendingAddress = Device->Address;
+
+	switch ((bmRequestType << 8) | bRequest)
+	{
+	case 0x8006:	/* GET_DESCRIPTOR */
+		if ((wValue >> 8) == 0x01)
+			ControlReply(Audio, DeviceDescriptor, sizeof(DeviceDescriptor), wLength);
+		else if ((wValue >> 8) == 0x02)
+			ControlReply(Audio, ConfigurationDescriptor, sizeof(ConfigurationDescriptor), wLength);
+		else
+			Supported = false;
+		break;
+
+	case 0x0005:	/* SET_ADDRESS, takes effect after the status stage */
+		Audio->PendingAddress = wValue & 0x7F;
+		break;
+
+	case 0x0009:	/* SET_CONFIGURATION */
+		Audio->Configuration = wValue;
+		memset(Audio->AltSetting, 0, sizeof(Audio->AltSetting));
+		break;
+
+	case 0x8008:	/* GET_CONFIGURATION */
+		Reply[0] = Audio->Configuration;
+		ControlReply(Audio, Reply, 1, wLength);
+		break;
+
+	case 0x8000:	/* GET_STATUS */
+	case 0x8100:
+	case 0x8200:
+		ControlReply(Audio, Reply, 2, wLength);
+		break;
+
+	case 0x0201:	/* CLEAR_FEATURE(ENDPOINT_HALT), endpoints never halt */
+		break;
+
+	case 0x010B:	/* SET_INTERFACE, a streaming interface restarts its pattern */
+		if ((wIndex >= sizeof(Audio->AltSetting)) || (wValue > 1))
+		{
+			Supported = false;
+			break;
+		}
+		Audio->AltSetting[wIndex] = wValue;
+		if (wIndex == PLAYBACK_INTERFACE)
+			Audio->PlaybackStarted = false;
+		break;
+
+	case 0x2201:	/* SET_CUR on an endpoint (sampling frequency), there is a single rate */
+		break;
+
+	case 0xA281:	/* GET_CUR on an endpoint */
+		Reply[0] = AUDIO_DEVICE_SAMPLE_RATE & 0xFF;
+		Reply[1] = (AUDIO_DEVICE_SAMPLE_RATE >> 8) & 0xFF;
+		Reply[2] = AUDIO_DEVICE_SAMPLE_RATE >> 16;
+		ControlReply(Audio, Reply, 3, wLength);
+		break;
+
+	default:
+		Supported = false;
+		break;
+	}
+
+	if (!Supported)
+		Audio->ControlStage = CONTROL_STALLED;
+	else if (wLength && (bmRequestType & 0x80))
+		Audio->ControlStage = CONTROL_DATA_IN;
+	else if (wLength)
+		Audio->ControlStage = CONTROL_DATA_OUT;
+	else
+		Audio->ControlStage = CONTROL_STATUS_IN;
+
+	return OHCISIM_ACK;		/* SETUP is always acknowledged, errors stall the next stage */
+}
+
+static OhciSim_Handshake_t In(OhciSim_Device_t *Device, uint8_t Endpoint, uint8_t *Data, uint16_t MaxLength, uint16_t *Length)
+{
+	Audio_Device_t *Audio = (Audio_Device_t *) Device;
+	uint16_t Count;
+
+	if (Endpoint == AUDIO_DEVICE_CAPTURE_ENDPOINT)
+		return CaptureIn(Audio, Data, MaxLength, Length);
+	if (Endpoint == AUDIO_DEVICE_FEEDBACK_ENDPOINT)
+		return FeedbackIn(Audio, Data, MaxLength, Length);
+	if (Endpoint != 0)
+		return OHCISIM_STALL;
+
+	switch (Audio->ControlStage)
+	{
+	case CONTROL_DATA_IN:
+		Count = MIN(MaxLength, Audio->ControlLength - Audio->ControlOffset);
+		memcpy(Data, &Audio->ControlData[Audio->ControlOffset], Count);
+		Audio->ControlOffset += Count;
+		*Length = Count;
+		return OHCISIM_ACK;
+
+	case CONTROL_STATUS_IN:
+	case CONTROL_DATA_OUT:		/* status stage of an OUT request */
+		*Length = 0;
+		Device->Address = Audio->PendingAddress;
+		Audio->ControlStage = CONTROL_IDLE;
+		return OHCISIM_ACK;
+
+	case CONTROL_STALLED:
+		return OHCISIM_STALL;
+
+	default:
+		return OHCISIM_NAK;
+	}
+}
+
+static OhciSim_Handshake_t Out(OhciSim_Device_t *Device, uint8_t Endpoint, const uint8_t *Data, uint16_t Length)
+{
+	Audio_Device_t *Audio = (Audio_Device_t *) Device;
+
+	if (Endpoint == AUDIO_DEVICE_PLAYBACK_ENDPOINT)
+		return PlaybackOut(Audio, Data, Length);
+	if (Endpoint != 0)
+		return OHCISIM_STALL;
+
+	switch (Audio->ControlStage)
+	{
+	case CONTROL_DATA_IN:		/* status stage of an IN request */
+		Audio->ControlStage = CONTROL_IDLE;
+		return OHCISIM_ACK;
+
+	case CONTROL_DATA_OUT:		/* SET_CUR data, the single rate needs no storing */
+		return OHCISIM_ACK;
+
+	case CONTROL_STALLED:
+		return OHCISIM_STALL;
+
+	default:
+		return OHCISIM_ACK;
+	}
+}
+
+static void Reset(OhciSim_Device_t *Device)
+{
+	Audio_Device_t *Audio = (Audio_Device_t *) Device;
+
+	Device->Address       = 0;
+	Audio->Configuration  = 0;
+	Audio->ControlStage   = CONTROL_IDLE;
+	Audio->PlaybackStarted = false;
+	memset(Audio->AltSetting, 0, sizeof(Audio->AltSetting));
+}
+
+/*==========================================================================*/
+/* Public API                                                              */
+/*==========================================================================*/
+void Audio_Device_Init(Audio_Device_t *Audio, int32_t CapturePPM, int32_t PlaybackPPM)
+{
+	memset(Audio, 0, sizeof(Audio_Device_t));
+
+	Audio->CaptureRate  = RATE_Q16(CapturePPM);
+	Audio->PlaybackRate = RATE_Q16(PlaybackPPM);
+
+	Audio->Device.Reset = Reset;
+	Audio->Device.Setup = Setup;
+	Audio->Device.In    = In;
+	Audio->Device.Out   = Out;
+	Reset(&Audio->Device);
+}
+
+int64_t Audio_Device_GetPlaybackLevel(const Audio_Device_t *Audio)
+{
+	uint64_t Frames = OhciSim_GetFrameNumber() - Audio->PlaybackStartFrame;
+
+	if (!Audio->PlaybackStarted)
+		return 0;
+
+	return (int64_t) Audio->PlaybackReceived - (int64_t) ((Frames * Audio->PlaybackRate) >> 16);
+}
@@ -0,0 +1,71 @@
+/*
+ * Audio_Device.h
+ *
+ * Virtual full speed USB Audio 1.0 device for the OHCI model: a 48 kHz 16-bit
+ * stereo capture interface (isochronous IN) and a playback interface
+ * (asynchronous isochronous OUT with a 10.14 explicit feedback endpoint).
+ * Each direction runs from its own sample clock, offset from the bus SOF by a
+ * number of ppm, the way a codec crystal drifts against the host.
+ *
+ * Captured sample frames carry a running 32-bit index; played ones are
+ * checked for the same pattern, and the playback FIFO level of the device is
+ * tracked so that the effect of the feedback on it can be measured.
+ */
+
+#ifndef HOSTSIM_AUDIO_DEVICE_H_
+#define HOSTSIM_AUDIO_DEVICE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "OHCI_Model.h"
+
+#define AUDIO_DEVICE_SAMPLE_RATE		48000
+#define AUDIO_DEVICE_FRAME_SIZE			4		/* 16-bit stereo */
+#define AUDIO_DEVICE_PACKET_SIZE		196		/* 49 sample frames */
+#define AUDIO_DEVICE_CAPTURE_ENDPOINT	1
+#define AUDIO_DEVICE_PLAYBACK_ENDPOINT	2
+#define AUDIO_DEVICE_FEEDBACK_ENDPOINT	3
+#define AUDIO_DEVICE_FEEDBACK_REFRESH	2		/* feedback every 2^2 ms */
+
+typedef struct {
+	OhciSim_Device_t Device;		/* must stay first, the model hands it back to the callbacks */
+
+	/* Control endpoint */
+	uint8_t  ControlData[256];
+	uint16_t ControlLength;
+	uint16_t ControlOffset;
+	uint8_t  ControlStage;
+	uint8_t  PendingAddress;
+	uint8_t  Configuration;
+	uint8_t  AltSetting[3];
+
+	/* Capture: sample frames are produced at CaptureRate (Q16.16 per frame) */
+	uint32_t CaptureRate;
+	uint32_t CaptureRemainder;
+	uint32_t CaptureIndex;
+
+	/* Playback: sample frames are consumed at PlaybackRate (Q16.16 per frame) from the first packet on */
+	uint32_t PlaybackRate;
+	uint64_t PlaybackStartFrame;
+	uint64_t PlaybackReceived;
+	uint32_t PlaybackExpected;
+	bool     PlaybackStarted;
+	int64_t  LevelMin;
+	int64_t  LevelMax;
+
+	/* Statistics */
+	uint64_t CapturePackets;
+	uint64_t PlaybackPackets;
+	uint64_t PlaybackSilent;		/* sample frames of silence, the host ran out of samples */
+	uint64_t PlaybackGaps;			/* jumps in the played index pattern */
+	uint64_t FeedbackPackets;
+} Audio_Device_t;
+
+/* Resets the device; the ppm values offset each sample clock from the bus */
+void Audio_Device_Init(Audio_Device_t *Audio, int32_t CapturePPM, int32_t PlaybackPPM);
+
+/* Playback FIFO level in sample frames: received minus consumed so far */
+int64_t Audio_Device_GetPlaybackLevel(const Audio_Device_t *Audio);
+
+#endif /* HOSTSIM_AUDIO_DEVICE_H_ */
@@ -0,0 +1,302 @@
+/*
+ * CDC_Device.c
+ *
+ * Virtual CDC-ACM serial instrument, see CDC_Device.h.
+ */
+
+#include <string.h>
+
+#include "CDC_Device.h"
+
+#define MIN(a, b)					(((a) < (b)) ? (a) : (b))
+
+/* Control transfer stages */
+#define CONTROL_IDLE				0
+#define CONTROL_DATA_IN				1
+#define CONTROL_DATA_OUT			2
+#define CONTROL_STATUS_IN			3
+#define CONTROL_STALLED				4
+
+static const uint8_t DeviceDescriptor[] = {
+	18, 0x01, 0x10, 0x01, 0x02, 0x00, 0x00, 64,
+	0xC9, 0x1F, 0x0E, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01
+};
+
+static const uint8_t ConfigurationDescriptor[] = {
+	/* Configuration */
+	9, 0x02, 67, 0, 2, 1, 0, 0x80, 50,
+	/* Interface 0: CDC-ACM control with its functional descriptors and notification endpoint */
+	9, 0x04, 0, 0, 1, 0x02, 0x02, 0x01, 0,
+	5, 0x24, 0x00, 0x10, 0x01,
+	5, 0x24, 0x01, 0x00, 1,
+	4, 0x24, 0x02, 0x06,
+	5, 0x24, 0x06, 0, 1,
+	7, 0x05, 0x80 | CDC_DEVICE_NOTIFICATION_ENDPOINT, 0x03, 8, 0, 0xFF,
+	/* Interface 1: CDC data */
+	9, 0x04, 1, 0, 2, 0x0A, 0x00, 0x00, 0,
+	7, 0x05, CDC_DEVICE_OUT_ENDPOINT, 0x02, CDC_DEVICE_PACKET_SIZE, 0, 0,
+	7, 0x05, 0x80 | CDC_DEVICE_IN_ENDPOINT, 0x02, CDC_DEVICE_PACKET_SIZE, 0, 0
+};
+
+/*==========================================================================*/
+/* Data endpoints                                                          */
+/*==========================================================================*/
+/* Runs the instrument up to the current frame: what does not fit in the FIFO is lost */
+static void Produce(CDC_Device_t *Serial)
+{
+	uint64_t Frame = OhciSim_GetFrameNumber();
+	uint32_t Bytes;
+
+	if (!Serial->Running)
+		return;
+
+	for (; Serial->LastFrame < Frame; Serial->LastFrame++)
+	{
+		Serial->Remainder += Serial->Rate;
+		Bytes = Serial->Remainder >> 16;
+		Serial->Remainder &= 0xFFFF;
+		Serial->Produced += Bytes;
+
+		while (Bytes--)
+		{
+			if (Serial->FIFOCount == CDC_DEVICE_FIFO_SIZE)
+			{
+				Serial->SendIndex++;
+				Serial->Lost++;
+				continue;
+			}
+
+			Serial->FIFO[Serial->FIFOIn] = CDC_Device_Pattern(Serial->SendIndex++);
+			Serial->FIFOIn = (Serial->FIFOIn + 1) % CDC_DEVICE_FIFO_SIZE;
+			Serial->FIFOCount++;
+		}
+
+		if (Serial->FIFOCount > Serial->FIFOPeak)
+			Serial->FIFOPeak = Serial->FIFOCount;
+	}
+}
+
+static OhciSim_Handshake_t DataIn(CDC_Device_t *Serial, uint8_t *Data, uint16_t MaxLength, uint16_t *Length)
+{
+	uint16_t Count;
+
+	if (Serial->Configuration == 0)
+		return OHCISIM_STALL;
+
+	Produce(Serial);
+
+	if (Serial->FIFOCount == 0)
+	{
+		Serial->Naks++;
+		return OHCISIM_NAK;
+	}
+
+	Count = MIN(MIN(MaxLength, CDC_DEVICE_PACKET_SIZE), Serial->FIFOCount);
+	for (*Length = 0; *Length < Count; (*Length)++)
+	{
+		Data[*Length] = Serial->FIFO[Serial->FIFOOut];
+		Serial->FIFOOut = (Serial->FIFOOut + 1) % CDC_DEVICE_FIFO_SIZE;
+	}
+
+	Serial->FIFOCount -= Count;
+	Serial->Sent += Count;
+	return OHCISIM_ACK;
+}
+
+static OhciSim_Handshake_t DataOut(CDC_Device_t *Serial, const uint8_t *Data, uint16_t Length)
+{
+	uint16_t i;
+
+	if (Serial->Configuration == 0)
+		return OHCISIM_STALL;
+
+	for (i = 0; i < Length; i++)
+	{
+		if (Data[i] != CDC_Device_Pattern(Serial->ReceiveIndex))
+			Serial->ReceiveErrors++;
+		Serial->ReceiveIndex++;
+	}
+
+	Serial->Received += Length;
+	return OHCISIM_ACK;
+}
+
+/*==========================================================================*/
+/* Control endpoint                                                        */
+/*==========================================================================*/
+static void ControlReply(CDC_Device_t *Serial, const uint8_t *Data, uint16_t Length, uint16_t wLength)
+{
+	Serial->ControlLength = MIN(MIN(Length, wLength), sizeof(Serial->ControlData));
+	memcpy(Serial->ControlData, Data, Serial->ControlLength);
+}
+
+static OhciSim_Handshake_t Setup(OhciSim_Device_t *Device, const uint8_t *Request)
+{
+	CDC_Device_t *Serial = (CDC_Device_t *) Device;
+	uint8_t  bmRequestType = Request[0];
+	uint8_t  bRequest = Request[1];
+	uint16_t wValue = Request[2] | (Request[3] << 8);
+	uint16_t wLength = Request[6] | (Request[7] << 8);
+	uint8_t  Reply[2] = {0, 0};
+	bool     Supported = true;
+
+	Serial->ControlLength = 0;
+	Serial->ControlOffset = 0;
+	Serial->PendingAddress = Device->Address;
+
+	switch ((bmRequestType << 8) | bRequest)
+	{
+	case 0x8006:	/* GET_DESCRIPTOR */
+		if ((wValue >> 8) == 0x01)
+			ControlReply(Serial, DeviceDescriptor, sizeof(DeviceDescriptor), wLength);
+		else if ((wValue >> 8) == 0x02)
+			ControlReply(Serial, ConfigurationDescriptor, sizeof(ConfigurationDescriptor), wLength);
+		else
+			Supported = false;
+		break;
+
+	case 0x0005:	/* SET_ADDRESS, takes effect after the status stage */
+		Serial->PendingAddress = wValue & 0x7F;
+		break;
+
+	case 0x0009:	/* SET_CONFIGURATION */
+		Serial->Configuration = wValue;
+		break;
+
+	case 0x8008:	/* GET_CONFIGURATION */
+		Reply[0] = Serial->Configuration;
+		ControlReply(Serial, Reply, 1, wLength);
+		break;
+
+	case 0x8000:	/* GET_STATUS */
+	case 0x8100:
+	case 0x8200:
+		ControlReply(Serial, Reply, 2, wLength);
+		break;
+
+	case 0x0201:	/* CLEAR_FEATURE(ENDPOINT_HALT), endpoints never halt */
+		break;
+
+	case 0x2120:	/* SET_LINE_CODING, the data stage lands in LineCoding */
+		break;
+
+	case 0xA121:	/* GET_LINE_CODING */
+		ControlReply(Serial, Serial->LineCoding, sizeof(Serial->LineCoding), wLength);
+		break;
+
+	case 0x2122:	/* SET_CONTROL_LINE_STATE, the instrument starts sending once DTR is up */
+		Serial->LineState = wValue;
+		if ((wValue & 0x01) && !Serial->Running)
+		{
+			Serial->Running   = true;
+			Serial->LastFrame = OhciSim_GetFrameNumber();
+		}
+		break;
+
+	case 0x2123:	/* SEND_BREAK */
+		break;
+
+	default:
+		Supported = false;
+		break;
+	}
+
+	if (!Supported)
+		Serial->ControlStage = CONTROL_STALLED;
+	else if (wLength && (bmRequestType & 0x80))
+		Serial->ControlStage = CONTROL_DATA_IN;
+	else if (wLength)
+		Serial->ControlStage = CONTROL_DATA_OUT;
+	else
+		Serial->ControlStage = CONTROL_STATUS_IN;
+
+	return OHCISIM_ACK;		/* SETUP is always acknowledged, errors stall the next stage */
+}
+
+static OhciSim_Handshake_t In(OhciSim_Device_t *Device, uint8_t Endpoint, uint8_t *Data, uint16_t MaxLength, uint16_t *Length)
+{
+	CDC_Device_t *Serial = (CDC_Device_t *) Device;
+	uint16_t Count;
+
+	if (Endpoint == CDC_DEVICE_IN_ENDPOINT)
+		return DataIn(Serial, Data, MaxLength, Length);
+	if (Endpoint == CDC_DEVICE_NOTIFICATION_ENDPOINT)
+		return OHCISIM_NAK;		/* the serial state never changes */
+	if (Endpoint != 0)
+		return OHCISIM_STALL;
+
+	switch (Serial->ControlStage)
+	{
+	case CONTROL_DATA_IN:
+		Count = MIN(MaxLength, Serial->ControlLength - Serial->ControlOffset);
+		memcpy(Data, &Serial->ControlData[Serial->ControlOffset], Count);
+		Serial->ControlOffset += Count;
+		*Length = Count;
+		return OHCISIM_ACK;
+
+	case CONTROL_STATUS_IN:
+	case CONTROL_DATA_OUT:		/* status stage of an OUT request */
+		*Length = 0;
+		Device->Address = Serial->PendingAddress;
+		Serial->ControlStage = CONTROL_IDLE;
+		return OHCISIM_ACK;
+
+	case CONTROL_STALLED:
+		return OHCISIM_STALL;
+
+	default:
+		return OHCISIM_NAK;
+	}
+}
+
+static OhciSim_Handshake_t Out(OhciSim_Device_t *Device, uint8_t Endpoint, const uint8_t *Data, uint16_t Length)
+{
+	CDC_Device_t *Serial = (CDC_Device_t *) Device;
+
+	if (Endpoint == CDC_DEVICE_OUT_ENDPOINT)
+		return DataOut(Serial, Data, Length);
+	if (Endpoint != 0)
+		return OHCISIM_STALL;
+
+	switch (Serial->ControlStage)
+	{
+	case CONTROL_DATA_IN:		/* status stage of an IN request */
+		Serial->ControlStage = CONTROL_IDLE;
+		return OHCISIM_ACK;
+
+	case CONTROL_DATA_OUT:		/* SET_LINE_CODING data */
+		memcpy(Serial->LineCoding, Data, MIN(Length, sizeof(Serial->LineCoding)));
+		return OHCISIM_ACK;
+
+	case CONTROL_STALLED:
+		return OHCISIM_STALL;
+
+	default:
+		return OHCISIM_ACK;
+	}
+}
+
+static void Reset(OhciSim_Device_t *Device)
+{
+	CDC_Device_t *Serial = (CDC_Device_t *) Device;
+
+	Device->Address       = 0;
+	Serial->Configuration = 0;
+	Serial->ControlStage  = CONTROL_IDLE;
+}
+
+/*==========================================================================*/
+/* Public API                                                              */
+/*==========================================================================*/
+void CDC_Device_Init(CDC_Device_t *Serial, uint32_t BytesPerSecond)
+{
+	memset(Serial, 0, sizeof(CDC_Device_t));
+
+	Serial->Rate = (uint32_t) (((uint64_t) BytesPerSecond << 16) / 1000);
+
+	Serial->Device.Reset = Reset;
+	Serial->Device.Setup = Setup;
+	Serial->Device.In    = In;
+	Serial->Device.Out   = Out;
+	Reset(&Serial->Device);
+}
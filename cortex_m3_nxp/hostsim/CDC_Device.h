@@ -0,0 +1,75 @@
+/*
+ * CDC_Device.h
+ *
+ * Virtual full speed CDC-ACM device for the OHCI model, standing in for a
+ * USB-serial instrument: it produces a byte stream at a fixed rate into a
+ * transmit FIFO of limited size, which the host has to drain over the bulk IN
+ * endpoint before it overflows. Bytes that do not fit are lost and counted,
+ * the way a UART bridge drops what arrives while its buffer is full.
+ *
+ * Sent bytes follow a running index modulo 251, so gaps show up on the host;
+ * bytes written to the bulk OUT endpoint are checked for the same pattern.
+ */
+
+#ifndef HOSTSIM_CDC_DEVICE_H_
+#define HOSTSIM_CDC_DEVICE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "OHCI_Model.h"
+
+#define CDC_DEVICE_PACKET_SIZE			64
+#define CDC_DEVICE_IN_ENDPOINT			1
+#define CDC_DEVICE_OUT_ENDPOINT			2
+#define CDC_DEVICE_NOTIFICATION_ENDPOINT	3
+#define CDC_DEVICE_FIFO_SIZE			4096
+#define CDC_DEVICE_PATTERN_PERIOD		251
+
+typedef struct {
+	OhciSim_Device_t Device;		/* must stay first, the model hands it back to the callbacks */
+
+	/* Control endpoint */
+	uint8_t  ControlData[128];
+	uint16_t ControlLength;
+	uint16_t ControlOffset;
+	uint8_t  ControlStage;
+	uint8_t  PendingAddress;
+	uint8_t  Configuration;
+	uint8_t  LineCoding[7];
+	uint16_t LineState;
+
+	/* Transmit side: bytes are produced at Rate (Q16.16 per frame) from the first frame the line is up */
+	uint32_t Rate;
+	uint32_t Remainder;
+	uint64_t LastFrame;
+	bool     Running;
+	uint8_t  FIFO[CDC_DEVICE_FIFO_SIZE];
+	uint32_t FIFOIn;
+	uint32_t FIFOOut;
+	uint32_t FIFOCount;
+	uint32_t FIFOPeak;
+	uint32_t SendIndex;
+
+	/* Receive side */
+	uint32_t ReceiveIndex;
+
+	/* Statistics */
+	uint64_t Produced;				/* bytes the instrument produced */
+	uint64_t Lost;					/* bytes dropped on a full FIFO */
+	uint64_t Sent;					/* bytes sent to the host */
+	uint64_t Received;				/* bytes received from the host */
+	uint64_t ReceiveErrors;			/* received bytes out of pattern */
+	uint64_t Naks;					/* IN requests NAKed on an empty FIFO */
+} CDC_Device_t;
+
+/* Resets the device; it produces BytesPerSecond once the host sets the line state */
+void CDC_Device_Init(CDC_Device_t *Serial, uint32_t BytesPerSecond);
+
+/* Pattern byte of a given stream index */
+static inline uint8_t CDC_Device_Pattern(uint64_t Index)
+{
+	return (uint8_t) (Index % CDC_DEVICE_PATTERN_PERIOD);
+}
+
+#endif /* HOSTSIM_CDC_DEVICE_H_ */
@@ -0,0 +1,1726 @@
+/*
+ * DCD_Model.c
+ *
+ * Register, SIE, DMA engine and host model of the LPC17xx USB device
+ * controller, see DCD_Model.h.
+ */
+
+#define _GNU_SOURCE
+#include <semaphore.h>
+#include <signal.h>
+#include <stddef.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <x86intrin.h>
+
+#define  __INCLUDE_FROM_USB_DRIVER
+#include "Core/USBMode.h"
+#include "Core/StdRequestType.h"
+#include "Core/LPC/HAL/HAL_LPC.h"
+
+#include "DCD_Model.h"
+
+extern void DcdIrqHandler(uint8_t DeviceID);
+
+#define REGISTER_PAGE_SIZE			4096
+#define REG(member)					RegisterFile[offsetof(LPC_USB_TypeDef, member) / 4]
+#define OFFSET(member)				offsetof(LPC_USB_TypeDef, member)
+
+#define X86_EFLAGS_TF				0x100
+#define X86_PF_WRITE				0x2
+
+#define PHYSICAL_ENDPOINTS			32
+#define MAX_PACKET					1024
+#define SLICES_PER_FRAME			8
+#define SLICE_NS					(1000000 / SLICES_PER_FRAME)
+#define FRAME_BYTE_TIMES			1500	/* 12 Mbit/s for 1 ms, less the SOF */
+#define TRANSACTION_OVERHEAD		13		/* token, handshake, sync, CRC and inter-packet delays */
+#define BUS_RESET_FRAMES			10		/* USB 2.0 7.1.7.5: reset is driven for 10 ms */
+#define RESET_RECOVERY_FRAMES		10		/* USB 2.0 9.2.6.2 */
+#define SET_ADDRESS_FRAMES			2		/* USB 2.0 9.2.6.3 */
+#define MAX_IRQ_LOOPS				8		/* bound handler calls per slice for an interrupt that does not clear */
+#define DEFAULT_TIMEOUT_MS			5000
+#define MAX_TRAP_REGIONS			4		/* the device controller and other peripheral models */
+#define MAX_TRANSFERS				4		/* host transfers in progress at the same time, one per host thread */
+#define MAX_ISO_STREAMS				4		/* isochronous endpoints the host streams on */
+
+#define RX_PLEN_DV					0x00000400
+#define CTRL_LOG_ENDPOINT(Ctrl)		(((Ctrl) >> 2) & 0x0F)
+#define EP_RLZED_ALWAYS				0x00000003	/* the control endpoints are always realized */
+
+/* SIE command codes and phases (USBCmdCode bits 23:16 and 15:8) */
+#define SIE_PHASE_WRITE				0x01
+#define SIE_PHASE_READ				0x02
+#define SIE_PHASE_COMMAND			0x05
+#define SIE_SELECT_ENDPOINT			0x00
+#define SIE_SET_ENDPOINT_STATUS		0x40
+#define SIE_SET_ADDRESS				0xD0
+#define SIE_CONFIGURE_DEVICE		0xD8
+#define SIE_CLEAR_BUFFER			0xF2
+#define SIE_SET_MODE				0xF3
+#define SIE_READ_FRAME_NUMBER		0xF5
+#define SIE_VALIDATE_BUFFER			0xFA
+#define SIE_READ_ERROR_STATUS		0xFB
+#define SIE_READ_TEST_REGISTER		0xFD
+#define SIE_DEVICE_STATUS			0xFE
+#define SIE_GET_ERROR_CODE			0xFF
+#define SIE_TEST_REGISTER_VALUE		0xA50F
+
+/* DD_status values of a retired DMA descriptor */
+#define DD_STATUS_BEING_SERVICED	1
+#define DD_STATUS_NORMAL			2
+#define DD_STATUS_DATA_UNDERRUN		3
+#define DD_STATUS_DATA_OVERRUN		4
+
+/* Isochronous packet length word (Isochronous_packetsize_memory_address) */
+#define ISO_LENGTH_MASK				0x0000FFFF
+#define ISO_PACKET_VALID			0x00010000
+#define ISO_FRAME_SHIFT				17
+
+typedef enum {
+	TRANSFER_ATTACH,
+	TRANSFER_CONTROL,
+	TRANSFER_BULK_OUT,
+	TRANSFER_BULK_IN,
+} TransferType_t;
+
+typedef enum {
+	STAGE_SETUP,
+	STAGE_DATA,
+	STAGE_STATUS,
+} ControlStage_t;
+
+/* One transfer of the host thread, run from the slice handler */
+typedef struct {
+	TransferType_t  Type;
+	uint8_t         Endpoint;
+	uint16_t        MaxPacket;
+	const uint8_t  *Request;
+	uint8_t        *Data;
+	uint32_t        Length;
+	uint32_t        Done;
+	ControlStage_t  Stage;
+	bool            Reset;
+	uint64_t        Deadline;
+	DcdSim_Result_t Result;
+	sem_t           Completion;
+} Transfer_t;
+
+/* Registers of one peripheral model: the file, the code's view of it (PROT_NONE) and the
+ * model's handlers of an access */
+typedef struct {
+	volatile uint32_t *File;
+	uint8_t           *Trap;
+	uint32_t           Size;
+	void             (*Read)(uint32_t Offset);
+	void             (*Write)(uint32_t Offset, uint32_t Value);
+} TrapRegion_t;
+
+/* Packet buffers of one physical endpoint and the DMA descriptor it is working on */
+typedef struct {
+	uint16_t       MaxPacket;
+	uint8_t        Buffers;
+	uint8_t        Count;
+	uint8_t        Head;
+	bool           Setup;
+	bool           Stalled;
+	uint16_t       Length[2];
+	uint8_t        Data[2][MAX_PACKET];
+	PDMADescriptor Dd;
+	bool           DdRequested;		/* new DD request raised, not answered by a DD yet */
+	uint32_t       IsoOffset;		/* bytes of the isochronous DD's buffer used by its packets so far */
+} Endpoint_t;
+
+/* Isochronous stream of the host on one endpoint, run at the start of the frames */
+typedef struct {
+	volatile bool          Active;
+	uint8_t                PhyEP;
+	uint16_t               MaxPacket;
+	uint32_t               Interval;
+	DcdSim_IsoOutHandler_t Out;
+	DcdSim_IsoInHandler_t  In;
+	uint8_t                Data[MAX_PACKET];
+} IsoStream_t;
+
+/* State of the SIE command interface and of the slave mode data registers */
+typedef struct {
+	uint8_t  Command;
+	uint8_t  Selected;
+	uint8_t  ReadCount;
+	bool     Overwritten;		/* last Clear Buffer kept a SETUP not yet reported */
+	uint32_t CmdData;
+	uint32_t HandshakeBits;
+	uint8_t  RxEndpoint;
+	uint16_t RxOffset;
+	bool     RxActive;
+	uint8_t  TxEndpoint;
+	uint16_t TxLength;
+	uint16_t TxOffset;
+	uint8_t  TxData[MAX_PACKET];
+} SieContext_t;
+
+/* Register file, the stack's view of it (PROT_NONE) and the access being single-stepped */
+static volatile uint32_t *RegisterFile;
+static uint8_t *RegisterTrap;
+LPC_USB_TypeDef *DcdSim_Registers;
+
+static TrapRegion_t      TrapRegions[MAX_TRAP_REGIONS];
+static volatile uint32_t TrapRegionCount;
+static TrapRegion_t     *TrapRegion;
+static volatile bool     TrapPending;
+static uint32_t          TrapOffset;
+static bool              TrapIsWrite;
+static bool              TrapMaskedSlice;
+static uint32_t          TrapOldValue;
+
+/* Device controller state */
+static Endpoint_t        Endpoints[PHYSICAL_ENDPOINTS];
+static SieContext_t      Sie;
+static uint8_t           DeviceStatus;
+static uint8_t           DeviceAddress;
+static bool              DeviceConfigured;
+static bool              IrqEnabled;
+static volatile bool     IsrActive;
+static void            (*DeferredHandler)(void);
+static volatile bool     DeferredPending;
+static bool              DeferredActive;
+
+/* Host state */
+static Transfer_t * volatile PendingTransfers[MAX_TRANSFERS];
+static uint64_t          TransferIdleUntil[MAX_TRANSFERS];
+static uint32_t          FirstTransfer;
+static uint32_t          SliceBudget;
+static uint32_t          IsoBudgetDebt;
+static IsoStream_t       IsoStreams[MAX_ISO_STREAMS];
+static uint64_t          HostIdleUntil;
+static uint32_t          TimeoutFrames = DEFAULT_TIMEOUT_MS;
+static void            (*FrameHook)(uint64_t Frame);
+static void            (*SliceHook)(uint64_t Time);
+
+/* Time */
+static volatile uint64_t FrameNumber;
+static volatile uint64_t SliceNumber;
+static uint64_t          SlicePeriodNs;
+static volatile uint64_t SliceWallStart;
+static uint64_t          LastTime;
+
+static DcdSim_Stats_t    Stats;
+static uint64_t          ModelCycles;
+static uint64_t          TrapCycles;
+static uint64_t          SignalCycles;
+static volatile bool     Calibrating;
+
+uint64_t DcdSim_ReadTSC(void)
+{
+	return __rdtsc();
+}
+
+static uint64_t WallTime(void)
+{
+	struct timespec Now;
+
+	clock_gettime(CLOCK_MONOTONIC, &Now);
+	return ((uint64_t) Now.tv_sec * 1000000000ULL) + Now.tv_nsec;
+}
+
+/*==========================================================================*/
+/* Endpoints                                                               */
+/*==========================================================================*/
+static __INLINE bool IsInEndpoint(uint8_t PhyEP)
+{
+	return (PhyEP & 1) != 0;
+}
+
+static __INLINE bool IsIsochronous(uint8_t PhyEP)
+{
+	uint8_t Logical = PhyEP / 2;
+
+	return (Logical != 0) && ((Logical % 3) == 0);
+}
+
+/* Fixed endpoint map: logical endpoints 3, 6, 9 and 12 are isochronous, 1, 4, 7,
+ * 10 and 13 interrupt, the others bulk. Bulk and isochronous ones are double buffered.
+ */
+static uint8_t EndpointBuffers(uint8_t PhyEP)
+{
+	uint8_t Logical = PhyEP / 2;
+
+	if ((Logical == 0) || ((Logical % 3) == 1))
+		return 1;
+	return 2;
+}
+
+static void FlushEndpoint(Endpoint_t *Ep)
+{
+	Ep->Count = 0;
+	Ep->Head  = 0;
+	Ep->Setup = false;
+}
+
+static void PushPacket(Endpoint_t *Ep, const uint8_t *Data, uint16_t Length)
+{
+	uint8_t Slot = (Ep->Head + Ep->Count) % Ep->Buffers;
+
+	memcpy(Ep->Data[Slot], Data, Length);
+	Ep->Length[Slot] = Length;
+	Ep->Count++;
+}
+
+static void PopPacket(Endpoint_t *Ep)
+{
+	if (Ep->Count == 0)
+		return;
+	Ep->Head = (Ep->Head + 1) % Ep->Buffers;
+	Ep->Count--;
+	Ep->Setup = false;
+}
+
+/* Select Endpoint status byte */
+static uint8_t EndpointStatus(uint8_t PhyEP)
+{
+	Endpoint_t *Ep = &Endpoints[PhyEP];
+	uint8_t Status = 0;
+
+	/* FE: any buffer full for OUT endpoints, all buffers full for IN endpoints */
+	if (IsInEndpoint(PhyEP) ? (Ep->Count == Ep->Buffers) : (Ep->Count != 0))
+		Status |= EP_SEL_F;
+	if (Ep->Stalled)
+		Status |= EP_SEL_ST;
+	if (Ep->Setup)
+		Status |= EP_SEL_STP;
+	if (Ep->Count >= 1)
+		Status |= EP_SEL_B_1_FULL;
+	if (Ep->Count >= 2)
+		Status |= EP_SEL_B_2_FULL;
+	return Status;
+}
+
+static void UpdateEndpointInterrupt(void)
+{
+	uint32_t Pending = REG(USBEpIntSt) & REG(USBEpIntEn);
+
+	if (Pending & ~REG(USBEpIntPri))
+		REG(USBDevIntSt) |= EP_SLOW_INT;
+	if (Pending & REG(USBEpIntPri))
+		REG(USBDevIntSt) |= EP_FAST_INT;
+}
+
+/* A packet was received into or sent from the endpoint */
+static void EndpointEvent(uint8_t PhyEP)
+{
+	REG(USBEpIntSt) |= (1UL << PhyEP);
+	UpdateEndpointInterrupt();
+}
+
+static void BusReset(void)
+{
+	uint8_t PhyEP;
+
+	for (PhyEP = 0; PhyEP < PHYSICAL_ENDPOINTS; PhyEP++)
+	{
+		FlushEndpoint(&Endpoints[PhyEP]);
+		Endpoints[PhyEP].Stalled = false;
+	}
+	DeviceAddress = 0;
+	DeviceStatus |= DEV_RST;
+	REG(USBDevIntSt) |= DEV_STAT_INT;
+}
+
+/*==========================================================================*/
+/* DMA engine                                                              */
+/*==========================================================================*/
+static __INLINE PDMADescriptor DescriptorPointer(uint32_t Address)
+{
+	return (PDMADescriptor) (uintptr_t) Address;
+}
+
+static __INLINE uint32_t *Udca(void)
+{
+	return (uint32_t *) (uintptr_t) REG(USBUDCAH);
+}
+
+/* EpDMAEn or DMARSet: the engine fetches the DD the UDCA points to */
+static void ArmDescriptor(uint8_t PhyEP)
+{
+	Endpoint_t *Ep = &Endpoints[PhyEP];
+	PDMADescriptor Dd;
+
+	if ((PhyEP < 2) || !(REG(USBEpDMASt) & (1UL << PhyEP)) || (Udca() == NULL))
+		return;
+
+	Dd = DescriptorPointer(Udca()[PhyEP]);
+	if ((Dd == NULL) || Dd->Retired)
+		return;
+
+	Dd->Status = DD_STATUS_BEING_SERVICED;
+	Ep->Dd = Dd;
+	Ep->DdRequested = false;
+	Ep->IsoOffset = 0;
+}
+
+static void RetireDescriptor(uint8_t PhyEP, uint8_t Status)
+{
+	Endpoint_t *Ep = &Endpoints[PhyEP];
+	PDMADescriptor Dd = Ep->Dd;
+	PDMADescriptor Next = NULL;
+
+	Dd->Status  = Status;
+	Dd->Retired = 1;
+	Ep->Dd = NULL;
+
+	REG(USBEoTIntSt) |= (1UL << PhyEP);
+	Stats.DmaDescriptors++;
+
+	/* A chained descriptor is fetched right away, the UDCA then points to it */
+	if (Dd->NextDDValid && Dd->NextDD)
+	{
+		Next = DescriptorPointer(Dd->NextDD);
+		Udca()[PhyEP] = Dd->NextDD;
+		if (!Next->Retired)
+		{
+			Next->Status = DD_STATUS_BEING_SERVICED;
+			Ep->Dd = Next;
+			Ep->IsoOffset = 0;
+		}
+	}
+}
+
+/* Moves packets between the endpoint buffers and the memory of the armed descriptors */
+static void ServiceDma(uint8_t PhyEP)
+{
+	Endpoint_t *Ep = &Endpoints[PhyEP];
+	PDMADescriptor Dd;
+	uint16_t Length, Space;
+
+	if (IsIsochronous(PhyEP))
+		return;
+
+	if (IsInEndpoint(PhyEP))
+	{
+		while (((Dd = Ep->Dd) != NULL) && (Ep->Count < Ep->Buffers))
+		{
+			Length = MIN((uint16_t) (Dd->BufferLength - Dd->PresentCount), Ep->MaxPacket);
+			PushPacket(Ep, (const uint8_t *) Dd->BufferStartAddr + Dd->PresentCount, Length);
+			Dd->PresentCount += Length;
+
+			if (Dd->PresentCount == Dd->BufferLength)
+				RetireDescriptor(PhyEP, DD_STATUS_NORMAL);
+		}
+		return;
+	}
+
+	while (((Dd = Ep->Dd) != NULL) && (Ep->Count != 0))
+	{
+		Length = Ep->Length[Ep->Head];
+		Space  = Dd->BufferLength - Dd->PresentCount;
+
+		memcpy((uint8_t *) Dd->BufferStartAddr + Dd->PresentCount, Ep->Data[Ep->Head], MIN(Length, Space));
+		PopPacket(Ep);
+
+		if (Length > Space)
+		{
+			Dd->PresentCount = Dd->BufferLength;
+			RetireDescriptor(PhyEP, DD_STATUS_DATA_OVERRUN);
+		}
+		else
+		{
+			Dd->PresentCount += Length;
+			if (Dd->PresentCount == Dd->BufferLength)
+				RetireDescriptor(PhyEP, DD_STATUS_NORMAL);
+			else if (Length < Ep->MaxPacket)
+				RetireDescriptor(PhyEP, DD_STATUS_DATA_UNDERRUN);
+		}
+	}
+
+	/* A packet waits and there is no descriptor to take it. The engine asks once, until
+	 * a DD is armed; the software raises the request again through NDDRIntSet if need be. */
+	if ((Ep->Count != 0) && (Ep->Dd == NULL) && !Ep->DdRequested && (REG(USBEpDMASt) & (1UL << PhyEP)))
+	{
+		REG(USBNDDRIntSt) |= (1UL << PhyEP);
+		Ep->DdRequested = true;
+	}
+}
+
+/* Start of frame: an isochronous endpoint moves one packet per frame. The OUT packet received in the
+ * last frame goes to the DD, the IN packet of this frame is loaded from it; packets are stored back to
+ * back and each fills the length word of its frame, with the frame number. A frame without an OUT
+ * packet gets a word with Packet_valid clear. Without a DD the OUT packet is lost and the IN endpoint
+ * sends nothing, the engine asks for a DD once. PresentCount counts packets.
+ */
+static void ServiceIsoDma(uint8_t PhyEP)
+{
+	Endpoint_t *Ep = &Endpoints[PhyEP];
+	PDMADescriptor Dd = Ep->Dd;
+	uint32_t *Word;
+	uint8_t  *Data;
+	uint16_t Length = 0;
+	bool     Valid = false;
+
+	if (!IsInEndpoint(PhyEP) && (Ep->Count != 0))
+	{
+		Valid  = true;
+		Length = Ep->Length[(Ep->Head + Ep->Count - 1) % Ep->Buffers];
+	}
+
+	if ((Dd == NULL) || !(REG(USBEpDMASt) & (1UL << PhyEP)))
+	{
+		FlushEndpoint(Ep);
+		if ((REG(USBEpDMASt) & (1UL << PhyEP)) && !Ep->DdRequested)
+		{
+			REG(USBNDDRIntSt) |= (1UL << PhyEP);
+			Ep->DdRequested = true;
+		}
+		return;
+	}
+
+	Word = (uint32_t *) (uintptr_t) Dd->IsoBufferAddr + Dd->PresentCount;
+	Data = (uint8_t *) Dd->BufferStartAddr + Ep->IsoOffset;
+
+	if (IsInEndpoint(PhyEP))
+	{
+		/* A packet the host did not fetch in the last frame is dropped */
+		FlushEndpoint(Ep);
+		Length = MIN(*Word & ISO_LENGTH_MASK, Ep->MaxPacket);
+		PushPacket(Ep, Data, Length);
+		Valid = true;
+	}
+	else if (Valid)
+	{
+		memcpy(Data, Ep->Data[(Ep->Head + Ep->Count - 1) % Ep->Buffers], Length);
+		FlushEndpoint(Ep);
+	}
+
+	*Word = ((uint32_t) (FrameNumber & 0x7FFF) << ISO_FRAME_SHIFT) | (Valid ? ISO_PACKET_VALID : 0) | Length;
+	Ep->IsoOffset += Length;
+
+	if (++Dd->PresentCount == Dd->BufferLength)
+		RetireDescriptor(PhyEP, DD_STATUS_NORMAL);
+}
+
+static void ServiceAllIsoDma(void)
+{
+	uint8_t PhyEP;
+
+	for (PhyEP = 2; PhyEP < PHYSICAL_ENDPOINTS; PhyEP++)
+	{
+		if (IsIsochronous(PhyEP) && Endpoints[PhyEP].Buffers)
+			ServiceIsoDma(PhyEP);
+	}
+}
+
+static void ServiceAllDma(void)
+{
+	uint8_t PhyEP;
+
+	for (PhyEP = 2; PhyEP < PHYSICAL_ENDPOINTS; PhyEP++)
+	{
+		if (REG(USBEpDMASt) & (1UL << PhyEP))
+			ServiceDma(PhyEP);
+	}
+}
+
+static uint32_t DmaInterruptStatus(void)
+{
+	return (REG(USBEoTIntSt)    ? EOT_INT     : 0) |
+		   (REG(USBNDDRIntSt)   ? NDD_REQ_INT : 0) |
+		   (REG(USBSysErrIntSt) ? SYS_ERR_INT : 0);
+}
+
+/*==========================================================================*/
+/* SIE commands and slave mode registers                                   */
+/*==========================================================================*/
+static void SieCommandPhase(uint8_t Code)
+{
+	Endpoint_t *Ep;
+
+	Sie.Command   = Code;
+	Sie.ReadCount = 0;
+
+	if (Code < PHYSICAL_ENDPOINTS)
+	{
+		Sie.Selected = Code;
+	}
+	else if ((Code >= SIE_SET_ENDPOINT_STATUS) && (Code < SIE_SET_ENDPOINT_STATUS + PHYSICAL_ENDPOINTS))
+	{
+		Sie.Selected = Code - SIE_SET_ENDPOINT_STATUS;
+	}
+	else if (Code == SIE_CLEAR_BUFFER)
+	{
+		/* A SETUP which overwrote the packet being cleared stays until its interrupt is taken */
+		Ep = &Endpoints[Sie.Selected];
+		Sie.Overwritten = Ep->Setup && (REG(USBEpIntSt) & (1UL << Sie.Selected));
+		if (!Sie.Overwritten)
+			PopPacket(Ep);
+	}
+	else if (Code == SIE_VALIDATE_BUFFER)
+	{
+		Ep = &Endpoints[Sie.Selected];
+		if (IsInEndpoint(Sie.Selected) && (Ep->Count < Ep->Buffers))
+			PushPacket(Ep, Sie.TxData, Sie.TxLength);
+	}
+}
+
+static void SieWritePhase(uint8_t Data)
+{
+	uint8_t Code = Sie.Command;
+	Endpoint_t *Ep;
+
+	if ((Code >= SIE_SET_ENDPOINT_STATUS) && (Code < SIE_SET_ENDPOINT_STATUS + PHYSICAL_ENDPOINTS))
+	{
+		Ep = &Endpoints[Code - SIE_SET_ENDPOINT_STATUS];
+		if (Data & EP_STAT_CND_ST)		/* conditional stall of the control endpoint pair */
+		{
+			Endpoints[0].Stalled = true;
+			Endpoints[1].Stalled = true;
+		}
+		else
+		{
+			Ep->Stalled = (Data & EP_STAT_ST) != 0;
+		}
+		return;
+	}
+
+	switch (Code)
+	{
+	case SIE_SET_ADDRESS:
+		DeviceAddress = (Data & DEV_EN) ? (Data & DEV_ADDR_MASK) : 0;
+		break;
+
+	case SIE_CONFIGURE_DEVICE:
+		DeviceConfigured = (Data & CONF_DVICE) != 0;
+		break;
+
+	case SIE_DEVICE_STATUS:
+		DeviceStatus = (DeviceStatus & ~DEV_CON) | (Data & DEV_CON);
+		break;
+
+	case SIE_SET_MODE:
+	default:
+		break;
+	}
+}
+
+static uint32_t SieReadPhase(uint8_t Code)
+{
+	uint32_t Value = 0;
+
+	if (Code < PHYSICAL_ENDPOINTS)
+		return EndpointStatus(Code);
+
+	if ((Code >= SIE_SET_ENDPOINT_STATUS) && (Code < SIE_SET_ENDPOINT_STATUS + PHYSICAL_ENDPOINTS))
+	{
+		REG(USBEpIntSt) &= ~(1UL << (Code - SIE_SET_ENDPOINT_STATUS));
+		return EndpointStatus(Code - SIE_SET_ENDPOINT_STATUS);
+	}
+
+	switch (Code)
+	{
+	case SIE_DEVICE_STATUS:
+		Value = DeviceStatus;
+		DeviceStatus &= ~(DEV_CON_CH | DEV_SUS_CH | DEV_RST);
+		break;
+
+	case SIE_READ_FRAME_NUMBER:
+		Value = (Sie.ReadCount++ == 0) ? (FrameNumber & 0xFF) : ((FrameNumber >> 8) & 0x07);
+		break;
+
+	case SIE_READ_TEST_REGISTER:
+		Value = (Sie.ReadCount++ == 0) ? (SIE_TEST_REGISTER_VALUE & 0xFF) : (SIE_TEST_REGISTER_VALUE >> 8);
+		break;
+
+	case SIE_CLEAR_BUFFER:
+		Value = Sie.Overwritten ? CLR_BUF_PO : 0;
+		break;
+
+	case SIE_READ_ERROR_STATUS:
+	case SIE_GET_ERROR_CODE:
+	default:
+		break;
+	}
+	return Value;
+}
+
+static void CommandCodeWrite(uint32_t Value)
+{
+	uint8_t Phase = (Value >> 8) & 0xFF;
+	uint8_t Code  = (Value >> 16) & 0xFF;
+
+	if (Phase == SIE_PHASE_COMMAND)
+	{
+		SieCommandPhase(Code);
+	}
+	else if (Phase == SIE_PHASE_WRITE)
+	{
+		SieWritePhase(Code);
+	}
+	else if (Phase == SIE_PHASE_READ)
+	{
+		REG(USBCmdData) = SieReadPhase(Code);
+		REG(USBDevIntSt) |= CDFULL_INT;
+	}
+	REG(USBDevIntSt) |= CCEMTY_INT;
+}
+
+static void ControlWrite(uint32_t Value)
+{
+	uint8_t Logical = CTRL_LOG_ENDPOINT(Value);
+
+	REG(USBCtrl) = Value;
+
+	if (Value & CTRL_RD_EN)
+	{
+		Sie.RxEndpoint = 2 * Logical;
+		Sie.RxOffset   = 0;
+		Sie.RxActive   = true;
+	}
+	else
+	{
+		Sie.RxActive = false;
+	}
+
+	if (Value & CTRL_WR_EN)
+	{
+		Sie.TxEndpoint = (2 * Logical) + 1;
+		Sie.TxLength   = 0;
+		Sie.TxOffset   = 0;
+	}
+}
+
+static uint32_t ReceiveLength(void)
+{
+	Endpoint_t *Ep = &Endpoints[Sie.RxEndpoint];
+
+	if (!Sie.RxActive || (Ep->Count == 0))
+		return 0;
+	return Ep->Length[Ep->Head] | RX_PLEN_DV | PKT_RDY;
+}
+
+static uint32_t ReceiveData(void)
+{
+	Endpoint_t *Ep = &Endpoints[Sie.RxEndpoint];
+	uint32_t Value = 0;
+
+	if (Sie.RxActive && (Ep->Count != 0) && (Sie.RxOffset < Ep->Length[Ep->Head]))
+	{
+		memcpy(&Value, &Ep->Data[Ep->Head][Sie.RxOffset], MIN(4, Ep->Length[Ep->Head] - Sie.RxOffset));
+		Sie.RxOffset += 4;
+	}
+	return Value;
+}
+
+static void TransmitData(uint32_t Value)
+{
+	if (Sie.TxOffset + 4 <= MAX_PACKET)
+	{
+		memcpy(&Sie.TxData[Sie.TxOffset], &Value, 4);
+		Sie.TxOffset += 4;
+	}
+}
+
+static void ControllerReset(void)
+{
+	memset((void *) RegisterFile, 0, REGISTER_PAGE_SIZE);
+	memset(Endpoints, 0, sizeof(Endpoints));
+	memset(&Sie, 0, sizeof(Sie));
+
+	Endpoints[0].Buffers   = Endpoints[1].Buffers   = 1;
+	Endpoints[0].MaxPacket = Endpoints[1].MaxPacket = 8;
+	REG(USBReEp) = EP_RLZED_ALWAYS;
+	REG(USBDevIntSt) = CCEMTY_INT;
+
+	DeviceStatus     = 0;
+	DeviceAddress    = 0;
+	DeviceConfigured = false;
+}
+
+static void RegisterWrite(uint32_t Offset, uint32_t Value)
+{
+	uint8_t PhyEP;
+
+	switch (Offset)
+	{
+	case OFFSET(USBDevIntEn):
+	case OFFSET(USBEpIntEn):
+	case OFFSET(USBEpIntPri):
+	case OFFSET(USBDevIntPri):
+	case OFFSET(USBDMAIntEn):
+		RegisterFile[Offset / 4] = Value;
+		if (Offset == OFFSET(USBEpIntEn))
+			UpdateEndpointInterrupt();
+		break;
+
+	case OFFSET(USBDevIntClr):
+		REG(USBDevIntSt) &= ~Value;
+		break;
+
+	case OFFSET(USBDevIntSet):
+		REG(USBDevIntSt) |= Value;
+		break;
+
+	case OFFSET(USBCmdCode):
+		CommandCodeWrite(Value);
+		break;
+
+	case OFFSET(USBTxData):
+		TransmitData(Value);
+		break;
+
+	case OFFSET(USBTxPLen):
+		Sie.TxLength = MIN(Value & PKT_LNGTH_MASK, MAX_PACKET);
+		break;
+
+	case OFFSET(USBCtrl):
+		ControlWrite(Value);
+		break;
+
+	case OFFSET(USBEpIntClr):
+		REG(USBEpIntSt) &= ~Value;
+		/* Clearing an endpoint interrupt runs Select Endpoint/Clear Interrupt for it */
+		if (Value != 0)
+		{
+			PhyEP = __builtin_ctz(Value);
+			REG(USBCmdData) = EndpointStatus(PhyEP);
+			REG(USBDevIntSt) |= CDFULL_INT;
+		}
+		UpdateEndpointInterrupt();
+		break;
+
+	case OFFSET(USBEpIntSet):
+		REG(USBEpIntSt) |= Value;
+		UpdateEndpointInterrupt();
+		break;
+
+	case OFFSET(USBReEp):
+		REG(USBReEp) = Value | EP_RLZED_ALWAYS;
+		break;
+
+	case OFFSET(USBEpInd):
+		REG(USBEpInd) = Value & (PHYSICAL_ENDPOINTS - 1);
+		break;
+
+	case OFFSET(USBMaxPSize):
+		PhyEP = REG(USBEpInd);
+		REG(USBMaxPSize) = Value & PKT_LNGTH_MASK;
+		Endpoints[PhyEP].MaxPacket = MIN(Value & PKT_LNGTH_MASK, MAX_PACKET);
+		Endpoints[PhyEP].Buffers   = EndpointBuffers(PhyEP);
+		REG(USBDevIntSt) |= EP_RLZED_INT;
+		break;
+
+	case OFFSET(USBDMARSet):
+		for (PhyEP = 2; PhyEP < PHYSICAL_ENDPOINTS; PhyEP++)
+		{
+			if ((Value & (1UL << PhyEP)) && (Endpoints[PhyEP].Dd == NULL))
+				ArmDescriptor(PhyEP);
+		}
+		break;
+
+	case OFFSET(USBDMARClr):
+		break;
+
+	case OFFSET(USBUDCAH):
+		REG(USBUDCAH) = Value & ~0x7FUL;
+		break;
+
+	case OFFSET(USBEpDMAEn):
+		REG(USBEpDMASt) |= Value & ~3UL;
+		for (PhyEP = 2; PhyEP < PHYSICAL_ENDPOINTS; PhyEP++)
+		{
+			if ((Value & (1UL << PhyEP)) && (Endpoints[PhyEP].Dd == NULL))
+				ArmDescriptor(PhyEP);
+		}
+		break;
+
+	case OFFSET(USBEpDMADis):
+		REG(USBEpDMASt) &= ~Value;
+		for (PhyEP = 2; PhyEP < PHYSICAL_ENDPOINTS; PhyEP++)
+		{
+			if (Value & (1UL << PhyEP))
+			{
+				Endpoints[PhyEP].Dd = NULL;
+				Endpoints[PhyEP].DdRequested = false;
+			}
+		}
+		break;
+
+	case OFFSET(USBEoTIntClr):
+		REG(USBEoTIntSt) &= ~Value;
+		break;
+
+	case OFFSET(USBEoTIntSet):
+		REG(USBEoTIntSt) |= Value;
+		break;
+
+	case OFFSET(USBNDDRIntClr):
+		REG(USBNDDRIntSt) &= ~Value;
+		break;
+
+	case OFFSET(USBNDDRIntSet):
+		REG(USBNDDRIntSt) |= Value;
+		break;
+
+	case OFFSET(USBSysErrIntClr):
+		REG(USBSysErrIntSt) &= ~Value;
+		break;
+
+	case OFFSET(USBSysErrIntSet):
+		REG(USBSysErrIntSt) |= Value;
+		break;
+
+	case OFFSET(USBClkCtrl):
+		REG(USBClkCtrl) = Value;
+		REG(USBClkSt)   = Value;		/* clocks are available at once */
+		break;
+
+	default:							/* read only or not modelled */
+		break;
+	}
+}
+
+/* Registers whose value is produced by the read itself */
+static void RegisterRead(uint32_t Offset)
+{
+	switch (Offset)
+	{
+	case OFFSET(USBRxData):
+		REG(USBRxData) = ReceiveData();
+		break;
+
+	case OFFSET(USBRxPLen):
+		REG(USBRxPLen) = ReceiveLength();
+		break;
+
+	case OFFSET(USBDMAIntSt):
+		REG(USBDMAIntSt) = DmaInterruptStatus();
+		break;
+
+	default:
+		break;
+	}
+}
+
+/*==========================================================================*/
+/* Register access trapping                                                */
+/*==========================================================================*/
+static TrapRegion_t *FindTrapRegion(const uint8_t *Address)
+{
+	uint32_t i;
+
+	for (i = 0; i < TrapRegionCount; i++)
+	{
+		if ((Address >= TrapRegions[i].Trap) && (Address < TrapRegions[i].Trap + TrapRegions[i].Size))
+			return &TrapRegions[i];
+	}
+	return NULL;
+}
+
+/* A register access faults on the PROT_NONE page: open the page and single step the instruction */
+static void RegisterFaultHandler(int Signal, siginfo_t *Info, void *Context)
+{
+	ucontext_t *uc = (ucontext_t *) Context;
+	uint8_t *Address = (uint8_t *) Info->si_addr;
+	TrapRegion_t *Region = FindTrapRegion(Address);
+
+	if (TrapPending || (Region == NULL))
+	{
+		signal(SIGSEGV, SIG_DFL);		/* a real crash, fault again with the default action */
+		return;
+	}
+
+	TrapPending  = true;
+	TrapRegion   = Region;
+	TrapOffset   = (uint32_t) (Address - Region->Trap) & ~3UL;
+	TrapIsWrite  = (uc->uc_mcontext.gregs[REG_ERR] & X86_PF_WRITE) != 0;
+	TrapOldValue = Region->File[TrapOffset / 4];
+
+	if (!TrapIsWrite)
+		Region->Read(TrapOffset);
+
+	/* No slice may run between the access and its replay */
+	TrapMaskedSlice = !sigismember(&uc->uc_sigmask, SIGALRM);
+	if (TrapMaskedSlice)
+		sigaddset(&uc->uc_sigmask, SIGALRM);
+
+	mprotect(Region->Trap, Region->Size, PROT_READ | PROT_WRITE);
+	uc->uc_mcontext.gregs[REG_EFL] |= X86_EFLAGS_TF;
+}
+
+/* The access has been done on the open page: close it and replay a write through the model */
+static void RegisterStepHandler(int Signal, siginfo_t *Info, void *Context)
+{
+	ucontext_t *uc = (ucontext_t *) Context;
+	uint32_t Value;
+
+	if (!TrapPending)
+		return;
+
+	uc->uc_mcontext.gregs[REG_EFL] &= ~X86_EFLAGS_TF;
+	mprotect(TrapRegion->Trap, TrapRegion->Size, PROT_NONE);
+
+	if (TrapIsWrite)
+	{
+		Value = TrapRegion->File[TrapOffset / 4];
+		TrapRegion->File[TrapOffset / 4] = TrapOldValue;
+		TrapRegion->Write(TrapOffset, Value);
+	}
+
+	if (TrapMaskedSlice)
+		sigdelset(&uc->uc_sigmask, SIGALRM);
+
+	Stats.RegisterAccesses++;
+	TrapPending = false;
+}
+
+/*==========================================================================*/
+/* Host                                                                    */
+/*==========================================================================*/
+typedef enum {
+	HANDSHAKE_ACK,
+	HANDSHAKE_NAK,
+	HANDSHAKE_STALL,
+} Handshake_t;
+
+static bool Spend(uint32_t Length)
+{
+	uint32_t Cost = Length + TRANSACTION_OVERHEAD;
+
+	if (SliceBudget < Cost)
+		return false;
+	SliceBudget -= Cost;
+	return true;
+}
+
+static Handshake_t SetupTransaction(const uint8_t *Request)
+{
+	Endpoint_t *Ep = &Endpoints[0];
+
+	/* A SETUP is always accepted, it overwrites whatever the buffer holds */
+	FlushEndpoint(Ep);
+	PushPacket(Ep, Request, 8);
+	Ep->Setup = true;
+	Ep->Stalled = false;
+	Endpoints[1].Stalled = false;
+	FlushEndpoint(&Endpoints[1]);
+	EndpointEvent(0);
+	return HANDSHAKE_ACK;
+}
+
+static Handshake_t OutTransaction(uint8_t PhyEP, const uint8_t *Data, uint16_t Length)
+{
+	Endpoint_t *Ep = &Endpoints[PhyEP];
+
+	if (Ep->Stalled)
+		return HANDSHAKE_STALL;
+	if ((Ep->Buffers == 0) || (Ep->Count >= Ep->Buffers) || (Length > Ep->MaxPacket))
+		return HANDSHAKE_NAK;
+
+	PushPacket(Ep, Data, Length);
+	EndpointEvent(PhyEP);
+	if (PhyEP >= 2)
+		ServiceDma(PhyEP);
+	return HANDSHAKE_ACK;
+}
+
+static Handshake_t InTransaction(uint8_t PhyEP, uint8_t *Data, uint16_t MaxLength, uint16_t *Length)
+{
+	Endpoint_t *Ep = &Endpoints[PhyEP];
+
+	if (Ep->Stalled)
+		return HANDSHAKE_STALL;
+	if (Ep->Count == 0)
+		return HANDSHAKE_NAK;
+
+	*Length = MIN(Ep->Length[Ep->Head], MaxLength);
+	memcpy(Data, Ep->Data[Ep->Head], *Length);
+	PopPacket(Ep);
+	EndpointEvent(PhyEP);
+	if (PhyEP >= 2)
+		ServiceDma(PhyEP);
+	return HANDSHAKE_ACK;
+}
+
+/* Runs transactions of the transfer until it completes, is NAKed or the slice is used up.
+ * Returns true when the transfer has completed.
+ */
+static bool RunControl(Transfer_t *Transfer)
+{
+	const uint8_t *Request = Transfer->Request;
+	bool     DeviceToHost = (Request[0] & REQDIR_DEVICETOHOST) != 0;
+	uint16_t wLength = Request[6] | (Request[7] << 8);
+	uint16_t Length;
+	Handshake_t Handshake;
+
+	for (;;)
+	{
+		switch (Transfer->Stage)
+		{
+		case STAGE_SETUP:
+			if (!Spend(8))
+				return false;
+			SetupTransaction(Request);
+			Transfer->Stage = wLength ? STAGE_DATA : STAGE_STATUS;
+			break;
+
+		case STAGE_DATA:
+			Length = MIN(Endpoints[0].MaxPacket, wLength - Transfer->Done);
+			if (!Spend(Length))
+				return false;
+			if (DeviceToHost)
+				Handshake = InTransaction(1, Transfer->Data + Transfer->Done, Length, &Length);
+			else
+				Handshake = OutTransaction(0, Transfer->Data + Transfer->Done, Length);
+
+			if (Handshake == HANDSHAKE_STALL)
+			{
+				Transfer->Result = DCDSIM_STALL;
+				return true;
+			}
+			if (Handshake == HANDSHAKE_NAK)
+			{
+				Stats.Naks++;
+				return false;
+			}
+
+			Stats.Packets++;
+			Transfer->Done += Length;
+			if ((Transfer->Done == wLength) || (Length < Endpoints[0].MaxPacket))
+				Transfer->Stage = STAGE_STATUS;
+			break;
+
+		case STAGE_STATUS:
+			if (!Spend(0))
+				return false;
+			if (DeviceToHost)
+				Handshake = OutTransaction(0, NULL, 0);
+			else
+				Handshake = InTransaction(1, NULL, 0, &Length);
+
+			if (Handshake == HANDSHAKE_STALL)
+			{
+				Transfer->Result = DCDSIM_STALL;
+				return true;
+			}
+			if (Handshake == HANDSHAKE_NAK)
+			{
+				Stats.Naks++;
+				return false;
+			}
+
+			/* The device takes its new address once the status stage is over */
+			if ((Request[0] == (REQDIR_HOSTTODEVICE | REQTYPE_STANDARD | REQREC_DEVICE)) && (Request[1] == REQ_SetAddress))
+				HostIdleUntil = FrameNumber + SET_ADDRESS_FRAMES;
+
+			Transfer->Result = DCDSIM_OK;
+			return true;
+		}
+	}
+}
+
+static bool RunBulk(Transfer_t *Transfer)
+{
+	uint16_t Length;
+	Handshake_t Handshake;
+
+	for (;;)
+	{
+		Length = MIN(Transfer->MaxPacket, Transfer->Length - Transfer->Done);
+		if (!Spend(Length))
+			return false;
+
+		if (Transfer->Type == TRANSFER_BULK_OUT)
+			Handshake = OutTransaction(2 * Transfer->Endpoint, Transfer->Data + Transfer->Done, Length);
+		else
+			Handshake = InTransaction((2 * Transfer->Endpoint) + 1, Transfer->Data + Transfer->Done, Length, &Length);
+
+		if (Handshake == HANDSHAKE_STALL)
+		{
+			Transfer->Result = DCDSIM_STALL;
+			return true;
+		}
+		if (Handshake == HANDSHAKE_NAK)
+		{
+			Stats.Naks++;
+			return false;
+		}
+
+		Stats.Packets++;
+		Transfer->Done += Length;
+		if ((Transfer->Done == Transfer->Length) ||
+			((Transfer->Type == TRANSFER_BULK_IN) && (Length < Transfer->MaxPacket)))
+		{
+			Transfer->Result = DCDSIM_OK;
+			return true;
+		}
+	}
+}
+
+static bool RunAttach(Transfer_t *Transfer)
+{
+	if (!(DeviceStatus & DEV_CON))
+	{
+		Transfer->Result = DCDSIM_TIMEOUT;
+		return FrameNumber >= Transfer->Deadline;
+	}
+
+	if (!Transfer->Reset)
+	{
+		BusReset();
+		Transfer->Reset    = true;
+		Transfer->Deadline = FrameNumber + BUS_RESET_FRAMES + RESET_RECOVERY_FRAMES;
+		return false;
+	}
+
+	Transfer->Result = DCDSIM_OK;
+	return FrameNumber >= Transfer->Deadline;
+}
+
+static void RunTransferSlot(uint32_t Slot)
+{
+	Transfer_t *Transfer = PendingTransfers[Slot];
+	bool Complete;
+
+	if ((Transfer == NULL) || (FrameNumber < HostIdleUntil) || (FrameNumber < TransferIdleUntil[Slot]))
+		return;
+
+	if ((Transfer->Type != TRANSFER_ATTACH) && !(DeviceStatus & DEV_CON))
+	{
+		Transfer->Result = DCDSIM_NOT_CONNECTED;
+		Complete = true;
+	}
+	else if (Transfer->Type == TRANSFER_ATTACH)
+	{
+		Complete = RunAttach(Transfer);
+	}
+	else
+	{
+		Complete = (Transfer->Type == TRANSFER_CONTROL) ? RunControl(Transfer) : RunBulk(Transfer);
+
+		if (!Complete && (FrameNumber >= Transfer->Deadline))
+		{
+			Transfer->Result = DCDSIM_TIMEOUT;
+			Complete = true;
+		}
+	}
+
+	if (Complete)
+	{
+		/* Host controllers report completions at frame boundaries, so the next
+		 * transfer of the host thread never starts in the frame this one ended in.
+		 */
+		TransferIdleUntil[Slot] = FrameNumber + 1;
+
+		PendingTransfers[Slot] = NULL;
+		sem_post(&Transfer->Completion);
+	}
+}
+
+/* Isochronous packets go first in a frame, the bus time they take comes off the slices of the frame */
+static void RunIsoHost(void)
+{
+	IsoStream_t *Stream;
+	Endpoint_t  *Ep;
+	uint16_t     Length;
+	uint32_t     Cost, i;
+
+	if (!(DeviceStatus & DEV_CON) || (FrameNumber < HostIdleUntil))
+		return;
+
+	for (i = 0; i < MAX_ISO_STREAMS; i++)
+	{
+		Stream = &IsoStreams[i];
+		if (!Stream->Active || (FrameNumber % Stream->Interval))
+			continue;
+
+		Ep = &Endpoints[Stream->PhyEP];
+		if (Stream->Out)
+		{
+			Length = Stream->Out(Stream->Data, Stream->MaxPacket);
+			Length = MIN(Length, Stream->MaxPacket);
+			if (Ep->Buffers && (Length <= Ep->MaxPacket))
+			{
+				if (Ep->Count >= Ep->Buffers)
+					PopPacket(Ep);
+				PushPacket(Ep, Stream->Data, Length);
+				EndpointEvent(Stream->PhyEP);
+			}
+		}
+		else if (Ep->Count != 0)
+		{
+			Length = Ep->Length[Ep->Head];
+			memcpy(Stream->Data, Ep->Data[Ep->Head], Length);
+			PopPacket(Ep);
+			EndpointEvent(Stream->PhyEP);
+			Stream->In(Stream->Data, Length, true);
+		}
+		else
+		{
+			/* No answer to the token */
+			Length = 0;
+			Stream->In(NULL, 0, false);
+		}
+
+		Stats.Packets++;
+		Cost = Length + TRANSACTION_OVERHEAD;
+		if (SliceBudget >= Cost)
+		{
+			SliceBudget -= Cost;
+		}
+		else
+		{
+			IsoBudgetDebt += Cost - SliceBudget;
+			SliceBudget = 0;
+		}
+	}
+}
+
+/* Transfers of several host threads share the bus; each slice another one goes first */
+static void RunHost(void)
+{
+	uint32_t i;
+
+	for (i = 0; i < MAX_TRANSFERS; i++)
+		RunTransferSlot((FirstTransfer + i) % MAX_TRANSFERS);
+	FirstTransfer = (FirstTransfer + 1) % MAX_TRANSFERS;
+}
+
+/*==========================================================================*/
+/* Slices                                                                  */
+/*==========================================================================*/
+static bool InterruptPending(void)
+{
+	return IrqEnabled &&
+		   ((REG(USBDevIntSt) & REG(USBDevIntEn)) || (DmaInterruptStatus() & REG(USBDMAIntEn)));
+}
+
+/* Runs the USB interrupt handler and then the deferred one for as long as they are
+ * pending and unmasked. Returns the cycles spent in them.
+ */
+static uint64_t TakeInterrupts(void)
+{
+	SieContext_t Interrupted;
+	uint64_t IsrStart, IsrCycles = 0;
+	uint32_t Loops;
+
+	/* The interrupted code may be half way through an SIE command or a slave mode
+	 * packet access; the handler gets its own, as if it were masked around them */
+	Interrupted = Sie;
+	Interrupted.CmdData = REG(USBCmdData);
+	Interrupted.HandshakeBits = REG(USBDevIntSt) & (CCEMTY_INT | CDFULL_INT);
+
+	IsrActive = true;
+	for (Loops = 0; (Loops < MAX_IRQ_LOOPS) && InterruptPending(); Loops++)
+	{
+		Stats.Interrupts++;
+		IsrStart = DcdSim_ReadTSC();
+		DcdIrqHandler(0);				/* USB_IRQHandler() */
+		IsrCycles += DcdSim_ReadTSC() - IsrStart;
+		ServiceAllDma();
+	}
+	IsrActive = false;
+
+	/* The deferred interrupt is below the USB interrupt: the slices that come while it runs
+	 * preempt it, and their USB interrupt with them */
+	while (IrqEnabled && DeferredPending && !DeferredActive && DeferredHandler)
+	{
+		sigset_t Mask;
+
+		DeferredPending = false;
+		DeferredActive  = true;
+		Stats.DeferredInterrupts++;
+		IsrStart = DcdSim_ReadTSC();
+
+		sigemptyset(&Mask);
+		sigaddset(&Mask, SIGALRM);
+		pthread_sigmask(SIG_UNBLOCK, &Mask, NULL);
+		DeferredHandler();
+		pthread_sigmask(SIG_BLOCK, &Mask, NULL);
+
+		IsrCycles += DcdSim_ReadTSC() - IsrStart;
+		DeferredActive = false;
+	}
+
+	Sie = Interrupted;
+	REG(USBCmdData) = Interrupted.CmdData;
+	REG(USBDevIntSt) = (REG(USBDevIntSt) & ~(CCEMTY_INT | CDFULL_INT)) | Interrupted.HandshakeBits;
+
+	return IsrCycles;
+}
+
+static void SliceHandler(int Signal)
+{
+	uint64_t Start, IsrCycles;
+
+	if (Calibrating)
+		return;
+
+	Start = DcdSim_ReadTSC();
+
+	SliceWallStart = WallTime();
+	if ((++SliceNumber % SLICES_PER_FRAME) == 0)
+	{
+		FrameNumber++;
+		Stats.Frames++;
+		if (FrameHook)
+			FrameHook(FrameNumber);
+	}
+	if (SliceHook)
+		SliceHook(SliceNumber * SLICE_NS);
+
+	/* Bus time a slice leaves unused goes to the next slices of the frame, so a frame
+	 * carries as many packets as the real bus does */
+	if ((SliceNumber % SLICES_PER_FRAME) == 0)
+	{
+		SliceBudget   = 0;
+		IsoBudgetDebt = 0;
+	}
+	SliceBudget += FRAME_BYTE_TIMES / SLICES_PER_FRAME;
+	if (IsoBudgetDebt)
+	{
+		uint32_t Paid = MIN(IsoBudgetDebt, SliceBudget);
+
+		IsoBudgetDebt -= Paid;
+		SliceBudget   -= Paid;
+	}
+	if ((SliceNumber % SLICES_PER_FRAME) == 0)
+	{
+		ServiceAllIsoDma();
+		RunIsoHost();
+	}
+	ServiceAllDma();
+	RunHost();
+
+	IsrCycles = TakeInterrupts();
+
+	ModelCycles += (DcdSim_ReadTSC() - Start) - IsrCycles;
+}
+
+/*==========================================================================*/
+/* Public API                                                              */
+/*==========================================================================*/
+static void BlockSlices(sigset_t *Saved)
+{
+	sigset_t Mask;
+
+	sigemptyset(&Mask);
+	sigaddset(&Mask, SIGALRM);
+	pthread_sigmask(SIG_BLOCK, &Mask, Saved);
+}
+
+static void RestoreSlices(sigset_t *Saved)
+{
+	pthread_sigmask(SIG_SETMASK, Saved, NULL);
+}
+
+/* Cost of a trapped register access and of a slice signal, subtracted from the host's cycle counts */
+static void Calibrate(void)
+{
+	const uint32_t Rounds = 1000;
+	uint64_t Start;
+	uint32_t i;
+
+	Calibrating = true;
+
+	Start = DcdSim_ReadTSC();
+	for (i = 0; i < Rounds; i++)
+	{
+		(void) DcdSim_Registers->USBDevIntEn;
+	}
+	TrapCycles = (DcdSim_ReadTSC() - Start) / Rounds;
+
+	Start = DcdSim_ReadTSC();
+	for (i = 0; i < Rounds; i++)
+	{
+		raise(SIGALRM);
+	}
+	SignalCycles = (DcdSim_ReadTSC() - Start) / Rounds;
+
+	Stats.RegisterAccesses = 0;
+	Calibrating = false;
+}
+
+bool DcdSim_Init(uint32_t FramePeriodUS)
+{
+	struct sigaction Action;
+	struct itimerval Timer;
+	uint32_t SliceUS = MAX(FramePeriodUS / SLICES_PER_FRAME, 1);
+	int Fd;
+
+	Fd = memfd_create("dcdsim", 0);
+	if ((Fd < 0) || (ftruncate(Fd, REGISTER_PAGE_SIZE) != 0))
+		return false;
+
+	RegisterFile = mmap(NULL, REGISTER_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0);
+	RegisterTrap = mmap(NULL, REGISTER_PAGE_SIZE, PROT_NONE, MAP_SHARED, Fd, 0);
+	close(Fd);
+	if ((RegisterFile == MAP_FAILED) || (RegisterTrap == MAP_FAILED) || (TrapRegionCount == MAX_TRAP_REGIONS))
+		return false;
+	DcdSim_Registers = (LPC_USB_TypeDef *) RegisterTrap;
+	TrapRegions[TrapRegionCount] = (TrapRegion_t) {.File = RegisterFile, .Trap = RegisterTrap, .Size = REGISTER_PAGE_SIZE,
+												   .Read = RegisterRead, .Write = RegisterWrite};
+	TrapRegionCount++;
+
+	ControllerReset();
+
+	memset(&Action, 0, sizeof(Action));
+	sigemptyset(&Action.sa_mask);
+	sigaddset(&Action.sa_mask, SIGALRM);
+	Action.sa_flags = SA_SIGINFO;
+	Action.sa_sigaction = RegisterFaultHandler;
+	sigaction(SIGSEGV, &Action, NULL);
+	Action.sa_sigaction = RegisterStepHandler;
+	sigaction(SIGTRAP, &Action, NULL);
+
+	memset(&Action, 0, sizeof(Action));
+	sigemptyset(&Action.sa_mask);
+	Action.sa_flags = SA_RESTART;
+	Action.sa_handler = SliceHandler;
+	sigaction(SIGALRM, &Action, NULL);
+
+	Calibrate();
+
+	SlicePeriodNs  = (uint64_t) SliceUS * 1000;
+	SliceWallStart = WallTime();
+
+	Timer.it_interval.tv_sec  = SliceUS / 1000000;
+	Timer.it_interval.tv_usec = SliceUS % 1000000;
+	Timer.it_value = Timer.it_interval;
+	return setitimer(ITIMER_REAL, &Timer, NULL) == 0;
+}
+
+void DcdSim_DeInit(void)
+{
+	struct itimerval Timer;
+
+	memset(&Timer, 0, sizeof(Timer));
+	setitimer(ITIMER_REAL, &Timer, NULL);
+	signal(SIGALRM, SIG_IGN);
+}
+
+void DcdSim_SetInterruptEnable(bool Enable)
+{
+	sigset_t Saved;
+
+	IrqEnabled = Enable;
+
+	/* As with the NVIC, what became pending while masked is taken on unmasking, not
+	 * at the next slice: code which masks around nearly everything it does in a loop
+	 * would otherwise starve the handlers. The USB interrupt does not preempt itself. */
+	if (Enable && !IsrActive && (InterruptPending() || (DeferredPending && !DeferredActive)))
+	{
+		BlockSlices(&Saved);
+		TakeInterrupts();
+		RestoreSlices(&Saved);
+	}
+}
+
+void DcdSim_SetDeferredHandler(void (*Handler)(void))
+{
+	DeferredHandler = Handler;
+}
+
+void DcdSim_PendDeferredInterrupt(void)
+{
+	DeferredPending = true;
+}
+
+void DcdSim_SetFrameHook(void (*Hook)(uint64_t Frame))
+{
+	FrameHook = Hook;
+}
+
+void DcdSim_SetSliceHook(void (*Hook)(uint64_t Time))
+{
+	SliceHook = Hook;
+}
+
+void *DcdSim_MapRegisters(uint32_t Size, volatile uint32_t **File,
+						  void (*Read)(uint32_t Offset), void (*Write)(uint32_t Offset, uint32_t Value))
+{
+	TrapRegion_t *Region = &TrapRegions[TrapRegionCount];
+	int Fd;
+
+	Size = (Size + REGISTER_PAGE_SIZE - 1) & ~(REGISTER_PAGE_SIZE - 1);
+	if (TrapRegionCount == MAX_TRAP_REGIONS)
+		return NULL;
+
+	Fd = memfd_create("dcdsim-peripheral", 0);
+	if ((Fd < 0) || (ftruncate(Fd, Size) != 0))
+		return NULL;
+
+	Region->File = mmap(NULL, Size, PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0);
+	Region->Trap = mmap(NULL, Size, PROT_NONE, MAP_SHARED | MAP_32BIT, Fd, 0);
+	close(Fd);
+	if ((Region->File == MAP_FAILED) || (Region->Trap == MAP_FAILED))
+		return NULL;
+
+	Region->Size  = Size;
+	Region->Read  = Read;
+	Region->Write = Write;
+	TrapRegionCount++;
+
+	*File = Region->File;
+	return Region->Trap;
+}
+
+static void StartIso(uint8_t PhyEP, uint16_t MaxPacket, uint32_t Interval,
+					 DcdSim_IsoOutHandler_t Out, DcdSim_IsoInHandler_t In)
+{
+	IsoStream_t *Stream;
+	sigset_t Saved;
+	uint32_t i;
+
+	BlockSlices(&Saved);
+	for (i = 0; i < MAX_ISO_STREAMS; i++)
+	{
+		Stream = &IsoStreams[i];
+		if (!Stream->Active)
+		{
+			Stream->PhyEP     = PhyEP;
+			Stream->MaxPacket = MIN(MaxPacket, MAX_PACKET);
+			Stream->Interval  = MAX(Interval, 1);
+			Stream->Out       = Out;
+			Stream->In        = In;
+			__atomic_store_n(&Stream->Active, true, __ATOMIC_RELEASE);
+			break;
+		}
+	}
+	RestoreSlices(&Saved);
+}
+
+void DcdSim_StartIsoOut(uint8_t Endpoint, uint16_t MaxPacket, DcdSim_IsoOutHandler_t Handler)
+{
+	StartIso(2 * Endpoint, MaxPacket, 1, Handler, NULL);
+}
+
+void DcdSim_StartIsoIn(uint8_t Endpoint, uint16_t MaxPacket, uint32_t Interval, DcdSim_IsoInHandler_t Handler)
+{
+	StartIso((2 * Endpoint) + 1, MaxPacket, Interval, NULL, Handler);
+}
+
+void DcdSim_StopIso(uint8_t Endpoint, bool In)
+{
+	uint8_t  PhyEP = (2 * Endpoint) + (In ? 1 : 0);
+	sigset_t Saved;
+	uint32_t i;
+
+	BlockSlices(&Saved);
+	for (i = 0; i < MAX_ISO_STREAMS; i++)
+	{
+		if (IsoStreams[i].Active && (IsoStreams[i].PhyEP == PhyEP))
+			IsoStreams[i].Active = false;
+	}
+	RestoreSlices(&Saved);
+}
+
+void DcdSim_SetTimeout(uint32_t TimeoutMS)
+{
+	TimeoutFrames = TimeoutMS;
+}
+
+/* Hands the transfer to the slice handler and waits for it to complete */
+static DcdSim_Result_t RunTransfer(Transfer_t *Transfer)
+{
+	Transfer_t *Free;
+	sigset_t Saved;
+	uint32_t Slot;
+
+	sem_init(&Transfer->Completion, 0, 0);
+
+	BlockSlices(&Saved);
+	Transfer->Deadline = FrameNumber + TimeoutFrames;
+	for (Slot = 0; ; Slot = (Slot + 1) % MAX_TRANSFERS)
+	{
+		Free = NULL;
+		if (__atomic_compare_exchange_n(&PendingTransfers[Slot], &Free, Transfer, false,
+										__ATOMIC_RELEASE, __ATOMIC_RELAXED))
+			break;
+	}
+	RestoreSlices(&Saved);
+
+	while (sem_wait(&Transfer->Completion) != 0)
+	{
+	}
+	sem_destroy(&Transfer->Completion);
+	return Transfer->Result;
+}
+
+DcdSim_Result_t DcdSim_WaitForConnect(uint32_t TimeoutMS)
+{
+	Transfer_t Transfer = {.Type = TRANSFER_ATTACH};
+	uint32_t Saved = TimeoutFrames;
+	DcdSim_Result_t Result;
+
+	TimeoutFrames = TimeoutMS;
+	Result = RunTransfer(&Transfer);
+	TimeoutFrames = Saved;
+	return Result;
+}
+
+DcdSim_Result_t DcdSim_Control(const uint8_t *Request, void *Data, uint16_t *Actual)
+{
+	Transfer_t Transfer = {.Type = TRANSFER_CONTROL, .Request = Request, .Data = Data, .Stage = STAGE_SETUP};
+	DcdSim_Result_t Result;
+
+	Result = RunTransfer(&Transfer);
+	if (Actual)
+		*Actual = Transfer.Done;
+	return Result;
+}
+
+DcdSim_Result_t DcdSim_BulkOut(uint8_t Endpoint, const void *Data, uint32_t Length, uint16_t MaxPacket)
+{
+	Transfer_t Transfer = {.Type = TRANSFER_BULK_OUT, .Endpoint = Endpoint, .MaxPacket = MaxPacket,
+						   .Data = (uint8_t *) Data, .Length = Length};
+
+	return RunTransfer(&Transfer);
+}
+
+DcdSim_Result_t DcdSim_BulkIn(uint8_t Endpoint, void *Data, uint32_t Length, uint16_t MaxPacket, uint32_t *Actual)
+{
+	Transfer_t Transfer = {.Type = TRANSFER_BULK_IN, .Endpoint = Endpoint, .MaxPacket = MaxPacket,
+						   .Data = Data, .Length = Length};
+	DcdSim_Result_t Result;
+
+	Result = RunTransfer(&Transfer);
+	if (Actual)
+		*Actual = Transfer.Done;
+	return Result;
+}
+
+uint64_t DcdSim_GetFrameNumber(void)
+{
+	return FrameNumber;
+}
+
+uint64_t DcdSim_GetTime(void)
+{
+	uint64_t Slice, Elapsed, Time;
+
+	do {
+		Slice   = SliceNumber;
+		Elapsed = WallTime() - SliceWallStart;
+	} while (Slice != SliceNumber);
+
+	Elapsed = (Elapsed * SLICE_NS) / SlicePeriodNs;
+	Time = (Slice * SLICE_NS) + MIN(Elapsed, SLICE_NS - 1);
+
+	/* Interpolation restarts at each slice: never go back */
+	if (Time < LastTime)
+		Time = LastTime;
+	LastTime = Time;
+	return Time;
+}
+
+void DcdSim_GetStats(DcdSim_Stats_t *Result)
+{
+	sigset_t Saved;
+
+	BlockSlices(&Saved);
+	*Result = Stats;
+	Result->OverheadCycles = ModelCycles + (Stats.RegisterAccesses * TrapCycles) +
+							 (Stats.Frames * SLICES_PER_FRAME * SignalCycles);
+	RestoreSlices(&Saved);
+}
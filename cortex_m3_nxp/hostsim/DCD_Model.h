@@ -0,0 +1,137 @@
+/*
+ * DCD_Model.h
+ *
+ * Software model of the LPC17xx USB device controller, together with the
+ * host on the other end of the cable, for running the device stack (the
+ * LPC17xx DCD, the class drivers and the application above them) as a Linux
+ * process.
+ *
+ * The register block is trapped the same way as in OHCI_Model.h: every access
+ * faults on a PROT_NONE page, is single-stepped and replayed through the
+ * model, so the SIE command/data handshake, the slave mode control endpoint
+ * registers and the write-1-to-set/clear registers behave like the silicon.
+ * Registers whose value depends on the access (RxData, RxPLen, CmdData) are
+ * filled in before a read is stepped.
+ *
+ * A SIGALRM timer runs one eighth of a virtual 1 ms frame per tick. Each
+ * slice runs the DMA engine (UDCA and DMA descriptors, one transfer per
+ * endpoint, NextDD chaining), then the host's transactions within the full
+ * speed bandwidth of the slice, then DcdIrqHandler() like USB_IRQHandler()
+ * while an enabled interrupt is pending, then the deferred interrupt handler
+ * if the stack pended it. The host side is driven from another thread through
+ * blocking control and bulk transfer calls.
+ *
+ * Isochronous endpoints (logical 3, 6, 9 and 12) move one packet per frame:
+ * at the start of each frame the DMA engine takes the OUT packet of the last
+ * frame and loads the IN packet of this one, through isochronous DDs and
+ * their packet length words, and then the host's isochronous streams run
+ * ahead of the other transfers.
+ *
+ * Requires x86-64 Linux and a non-PIE build (-no-pie) so that the UDCA and
+ * DMA descriptor addresses the stack stores in 32-bit fields are valid
+ * pointers.
+ */
+
+#ifndef HOSTSIM_DCD_MODEL_H_
+#define HOSTSIM_DCD_MODEL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Outcome of a host transfer */
+typedef enum {
+	DCDSIM_OK,
+	DCDSIM_STALL,
+	DCDSIM_TIMEOUT,				/* the device NAKed for longer than the transfer's timeout */
+	DCDSIM_NOT_CONNECTED,
+} DcdSim_Result_t;
+
+typedef struct {
+	uint64_t Frames;			/* virtual 1 ms frames run */
+	uint64_t Packets;			/* data packets acknowledged by the device or the host */
+	uint64_t Naks;				/* transactions NAKed by the device */
+	uint64_t Interrupts;		/* calls into DcdIrqHandler() */
+	uint64_t DeferredInterrupts;	/* runs of the deferred interrupt handler */
+	uint64_t DmaDescriptors;	/* DMA descriptors retired */
+	uint64_t RegisterAccesses;	/* trapped register reads and writes */
+	uint64_t OverheadCycles;	/* TSC cycles spent in the model, trap round trips and slice signals included */
+} DcdSim_Stats_t;
+
+/* Maps the register page, installs the trap handlers and starts the slice timer.
+ * FramePeriodUS is the wall clock time given to one virtual frame.
+ */
+bool DcdSim_Init(uint32_t FramePeriodUS);
+void DcdSim_DeInit(void);
+
+/* Stand-in for the NVIC enable bit of USB_IRQn, used by the simulated HAL. Like the NVIC, an
+ * interrupt which became pending while disabled is taken as soon as it is enabled again. */
+void DcdSim_SetInterruptEnable(bool Enable);
+
+/* Stand-in for an interrupt below USB_IRQn which the stack pends to run Handler, sharing the
+ * enable of USB_IRQn. It runs at the end of the slice, after the USB interrupt; later slices,
+ * with their USB interrupt, preempt it, and it does not preempt itself.
+ */
+void DcdSim_SetDeferredHandler(void (*Handler)(void));
+void DcdSim_PendDeferredInterrupt(void);
+
+/* Called from the slice handler at the start of every frame, with the frame number */
+void DcdSim_SetFrameHook(void (*Hook)(uint64_t Frame));
+
+/* Called from the slice handler at the start of every slice, with the virtual time in ns,
+ * for the models of other peripherals to catch up with the USB bus. They may call the
+ * interrupt handlers of their peripherals from there.
+ */
+void DcdSim_SetSliceHook(void (*Hook)(uint64_t Time));
+
+/* Maps Size bytes (whole pages) of the registers of another peripheral model, trapped like
+ * the device controller's. Read is called before a read of the word at Offset is stepped,
+ * to put the value in the file; Write gets the value written to the word, with the file
+ * still holding the previous one. The pages lie below 4 GB, so a DMA address register can
+ * hold their address. Returns the address for the code under test (the file goes to File),
+ * or NULL.
+ */
+void *DcdSim_MapRegisters(uint32_t Size, volatile uint32_t **File,
+						  void (*Read)(uint32_t Offset), void (*Write)(uint32_t Offset, uint32_t Value));
+
+/* Host side, to be called from threads other than the one running the stack.
+ * Up to four threads may each have a transfer in progress; they share the bus
+ * like the transfers queued to a host controller.
+ * The host plugs in once the device has connected (SET_DEV_STAT CON), resets
+ * the bus and waits for the reset recovery time before it returns.
+ */
+DcdSim_Result_t DcdSim_WaitForConnect(uint32_t TimeoutMS);
+
+/* Control transfer to endpoint 0. Request is the 8 byte setup packet, Data holds
+ * the wLength bytes of the data stage in either direction, Actual (optional)
+ * receives the length of an IN data stage.
+ */
+DcdSim_Result_t DcdSim_Control(const uint8_t *Request, void *Data, uint16_t *Actual);
+
+/* Bulk transfers in MaxPacket sized packets. An IN transfer ends after Length
+ * bytes or on a short packet, its length goes to Actual (optional).
+ */
+DcdSim_Result_t DcdSim_BulkOut(uint8_t Endpoint, const void *Data, uint32_t Length, uint16_t MaxPacket);
+DcdSim_Result_t DcdSim_BulkIn(uint8_t Endpoint, void *Data, uint32_t Length, uint16_t MaxPacket, uint32_t *Actual);
+
+/* Isochronous streams of the host, run from the slice handler at the start of the frames. For an
+ * OUT endpoint the handler fills the packet of every frame and returns its length; an IN endpoint
+ * is polled every Interval frames and the handler gets the packet, Received false if the device
+ * sent none. Up to four endpoints stream at the same time.
+ */
+typedef uint16_t (*DcdSim_IsoOutHandler_t)(uint8_t *Data, uint16_t MaxPacket);
+typedef void     (*DcdSim_IsoInHandler_t)(const uint8_t *Data, uint16_t Length, bool Received);
+
+void DcdSim_StartIsoOut(uint8_t Endpoint, uint16_t MaxPacket, DcdSim_IsoOutHandler_t Handler);
+void DcdSim_StartIsoIn(uint8_t Endpoint, uint16_t MaxPacket, uint32_t Interval, DcdSim_IsoInHandler_t Handler);
+void DcdSim_StopIso(uint8_t Endpoint, bool In);
+
+/* NAK time after which a transfer gives up, 5 s by default */
+void DcdSim_SetTimeout(uint32_t TimeoutMS);
+
+uint64_t DcdSim_GetFrameNumber(void);
+/* Virtual time in ns, interpolated within the current slice from the wall clock */
+uint64_t DcdSim_GetTime(void);
+void DcdSim_GetStats(DcdSim_Stats_t *Stats);
+uint64_t DcdSim_ReadTSC(void);
+
+#endif /* HOSTSIM_DCD_MODEL_H_ */
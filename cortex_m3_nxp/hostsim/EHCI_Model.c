@@ -0,0 +1,728 @@
+/*
+ * EHCI_Model.c
+ *
+ * Register, root port and schedule processing model of the LPC18xx EHCI host
+ * controller, see EHCI_Model.h.
+ */
+
+#define _GNU_SOURCE
+#include <signal.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <x86intrin.h>
+
+#define  __INCLUDE_FROM_USB_DRIVER
+#include "Core/USBMode.h"
+
+/* The model shares the QH/qTD layouts with the driver */
+#define __LPC_EHCI_C__
+#include "Core/LPC/HCD/HCD.h"
+#include "Core/LPC/HCD/EHCI/EHCI.h"
+
+#include "EHCI_Model.h"
+
+#define REGISTER_PAGE_SIZE			4096
+#define REG(member)					RegisterFile[offsetof(LPC_USB0_Type, member) / 4]
+#define OFFSET(member)				offsetof(LPC_USB0_Type, member)
+
+#define X86_EFLAGS_TF				0x100
+#define X86_PF_WRITE				0x2
+
+#define HC_CAPLENGTH				0x40
+#define HC_HCSPARAMS				0x00010011UL	/* one port, port power control, one companion-less port */
+#define HC_PORTSC_HIGH_SPEED		(2UL << 26)		/* PSPD, LPC18xx derivation */
+#define HC_PORTSC_CHANGE_BITS		(EHC_PORTSC_ConnectStatusChange | EHC_PORTSC_PortEnableChange | EHC_PORTSC_OvercurrentChange)
+#define HC_USBSTS_INTERRUPT_BITS	(EHC_USBINTR_ALL)
+#define HC_FRINDEX_MASK				0x3FFF
+
+#define MICROFRAMES_PER_FRAME		8
+#define PORT_RESET_FRAMES			10		/* USB 2.0 7.1.7.5: root port reset is driven for 10 ms */
+#define MICROFRAME_BYTE_TIMES		7500	/* 480 Mbit/s over 125 us */
+#define HS_PACKET_OVERHEAD			64		/* token, handshake, sync, EOP and inter packet gaps of a high speed transaction */
+#define MAX_LIST_WALK				128		/* bound QH/qTD walks over corrupted lists */
+#define QH_TYPE						1
+
+/* qTD words as the controller sees them */
+#define QTD_NEXT					0
+#define QTD_ALTERNATE				1
+#define QTD_TOKEN					2
+#define QTD_PAGE0					3
+#define QTD_WORDS					8
+
+#define TOKEN_PING					(1UL << 0)
+#define TOKEN_TRANSACTION_ERROR		(1UL << 3)
+#define TOKEN_HALTED				(1UL << 6)
+#define TOKEN_ACTIVE				(1UL << 7)
+#define TOKEN_PID(t)				(((t) >> 8) & 3)
+#define TOKEN_CPAGE(t)				(((t) >> 12) & 7)
+#define TOKEN_CPAGE_MASK			(7UL << 12)
+#define TOKEN_IOC					(1UL << 15)
+#define TOKEN_BYTES(t)				(((t) >> 16) & 0x7FFF)
+#define TOKEN_BYTES_MASK			(0x7FFFUL << 16)
+#define TOKEN_TOGGLE				(1UL << 31)
+
+#define PID_OUT						0
+#define PID_IN						1
+#define PID_SETUP					2
+
+/* Register file, the driver's view of it (PROT_NONE) and the access being single-stepped */
+static volatile uint32_t *RegisterFile;
+static uint8_t *RegisterTrap;
+LPC_USB0_Type *EhciSim_Registers;
+
+static volatile bool     TrapPending;
+static uint32_t          TrapOffset;
+static bool              TrapIsWrite;
+static bool              TrapMaskedFrame;
+static uint32_t          TrapOldValue;
+
+/* Controller state not visible as a plain register value */
+static uint8_t           PortResetFrames;
+static bool              IrqEnabled;
+static EhciSim_Device_t *Device;
+
+static volatile uint64_t FrameNumber;
+static EhciSim_Stats_t   Stats;
+static uint64_t          ModelCycles;
+static uint64_t          TrapCycles;
+static uint64_t          SignalCycles;
+static volatile bool     Calibrating;
+
+uint64_t EhciSim_ReadTSC(void)
+{
+	return __rdtsc();
+}
+
+/*==========================================================================*/
+/* Register semantics                                                      */
+/*==========================================================================*/
+static void RaiseInterrupt(uint32_t Status)
+{
+	REG(USBSTS_H) |= Status;
+}
+
+static void PortWrite(uint32_t Value)
+{
+	uint32_t Port = REG(PORTSC1_H);
+
+	Port &= ~(Value & HC_PORTSC_CHANGE_BITS);				/* change bits are write 1 to clear */
+
+	if (!(Value & EHC_PORTSC_PortEnable))					/* the port can only be disabled by software */
+	{
+		Port &= ~EHC_PORTSC_PortEnable;
+	}
+	if ((Value & EHC_PORTSC_PortReset) && !(Port & EHC_PORTSC_PortReset) && (Port & EHC_PORTSC_CurrentConnectStatus))
+	{
+		Port = (Port | EHC_PORTSC_PortReset) & ~EHC_PORTSC_PortEnable;
+		PortResetFrames = PORT_RESET_FRAMES;
+	}
+
+	Port = (Port & ~(EHC_PORTSC_PortPowerControl | EHC_PORTSC_PortSuspend | EHC_PORTSC_ForcePortResume)) |
+		   (Value & (EHC_PORTSC_PortPowerControl | EHC_PORTSC_PortSuspend | EHC_PORTSC_ForcePortResume));
+
+	REG(PORTSC1_H) = Port;
+}
+
+static void HostControllerReset(void)
+{
+	REG(USBCMD_H)         = INT_THRESHOLD_CTRL;
+	REG(USBSTS_H)         = EHC_USBSTS_HCHalted;
+	REG(USBINTR_H)        = 0;
+	REG(FRINDEX_H)        = 0;
+	REG(PERIODICLISTBASE) = 0;
+	REG(ASYNCLISTADDR)    = 0;
+	REG(USBMODE_H)        = 0;
+	REG(PORTSC1_H)       &= EHC_PORTSC_CurrentConnectStatus;
+	if (REG(PORTSC1_H))
+		REG(PORTSC1_H) |= EHC_PORTSC_ConnectStatusChange | HC_PORTSC_HIGH_SPEED;
+
+	PortResetFrames = 0;
+}
+
+static void CommandWrite(uint32_t Value)
+{
+	uint32_t Status = REG(USBSTS_H);
+
+	if (Value & EHC_USBCMD_HostReset)
+	{
+		HostControllerReset();
+		return;
+	}
+
+	/* The doorbell stays set until the next micro-frame rings it */
+	REG(USBCMD_H) = (Value & ~EHC_USBCMD_IntAsyncAdvanceDoorbell) | (REG(USBCMD_H) & EHC_USBCMD_IntAsyncAdvanceDoorbell) |
+					(Value & EHC_USBCMD_IntAsyncAdvanceDoorbell);
+
+	/* Schedules and the run state follow their enables at once */
+	Status &= ~(EHC_USBSTS_HCHalted | EHC_USBSTS_AsyncScheduleStatus | EHC_USBSTS_PeriodScheduleStatus);
+	if (!(Value & EHC_USBCMD_RunStop))
+		Status |= EHC_USBSTS_HCHalted;
+	if (Value & EHC_USBCMD_AsynScheduleEnable)
+		Status |= EHC_USBSTS_AsyncScheduleStatus;
+	if (Value & EHC_USBCMD_PeriodScheduleEnable)
+		Status |= EHC_USBSTS_PeriodScheduleStatus;
+	REG(USBSTS_H) = Status;
+}
+
+static void RegisterWrite(uint32_t Offset, uint32_t Value)
+{
+	switch (Offset)
+	{
+	case OFFSET(USBCMD_H):
+		CommandWrite(Value);
+		break;
+
+	case OFFSET(USBSTS_H):
+		REG(USBSTS_H) &= ~(Value & HC_USBSTS_INTERRUPT_BITS);
+		break;
+
+	case OFFSET(USBINTR_H):
+		REG(USBINTR_H) = Value & EHC_USBINTR_ALL;
+		break;
+
+	case OFFSET(FRINDEX_H):
+		if (REG(USBSTS_H) & EHC_USBSTS_HCHalted)
+			REG(FRINDEX_H) = Value & HC_FRINDEX_MASK;
+		break;
+
+	case OFFSET(PERIODICLISTBASE):
+		REG(PERIODICLISTBASE) = Value & 0xFFFFF000UL;
+		break;
+
+	case OFFSET(ASYNCLISTADDR):
+		REG(ASYNCLISTADDR) = Value & 0xFFFFFFE0UL;
+		break;
+
+	case OFFSET(PORTSC1_H):
+		PortWrite(Value);
+		break;
+
+	case OFFSET(USBMODE_H):
+	case OFFSET(OTGSC):
+		RegisterFile[Offset / 4] = Value;
+		break;
+
+	default:							/* read only or not modelled */
+		break;
+	}
+}
+
+/*==========================================================================*/
+/* Register access trapping                                                */
+/*==========================================================================*/
+/* A register access faults on the PROT_NONE page: open the page and single step the instruction */
+static void RegisterFaultHandler(int Signal, siginfo_t *Info, void *Context)
+{
+	ucontext_t *uc = (ucontext_t *) Context;
+	uint8_t *Address = (uint8_t *) Info->si_addr;
+
+	if (TrapPending || (Address < RegisterTrap) || (Address >= RegisterTrap + REGISTER_PAGE_SIZE))
+	{
+		signal(SIGSEGV, SIG_DFL);		/* a real crash, fault again with the default action */
+		return;
+	}
+
+	TrapPending  = true;
+	TrapOffset   = (uint32_t) (Address - RegisterTrap) & ~3UL;
+	TrapIsWrite  = (uc->uc_mcontext.gregs[REG_ERR] & X86_PF_WRITE) != 0;
+	TrapOldValue = RegisterFile[TrapOffset / 4];
+
+	/* No frame may run between the access and its replay */
+	TrapMaskedFrame = !sigismember(&uc->uc_sigmask, SIGALRM);
+	if (TrapMaskedFrame)
+		sigaddset(&uc->uc_sigmask, SIGALRM);
+
+	mprotect(RegisterTrap, REGISTER_PAGE_SIZE, PROT_READ | PROT_WRITE);
+	uc->uc_mcontext.gregs[REG_EFL] |= X86_EFLAGS_TF;
+}
+
+/* The access has been done on the open page: close it and replay a write through the model */
+static void RegisterStepHandler(int Signal, siginfo_t *Info, void *Context)
+{
+	ucontext_t *uc = (ucontext_t *) Context;
+	uint32_t Value;
+
+	if (!TrapPending)
+		return;
+
+	uc->uc_mcontext.gregs[REG_EFL] &= ~X86_EFLAGS_TF;
+	mprotect(RegisterTrap, REGISTER_PAGE_SIZE, PROT_NONE);
+
+	if (TrapIsWrite)
+	{
+		Value = RegisterFile[TrapOffset / 4];
+		RegisterFile[TrapOffset / 4] = TrapOldValue;
+		RegisterWrite(TrapOffset, Value);
+	}
+
+	if (TrapMaskedFrame)
+		sigdelset(&uc->uc_sigmask, SIGALRM);
+
+	Stats.RegisterAccesses++;
+	TrapPending = false;
+}
+
+/*==========================================================================*/
+/* Schedule processing                                                     */
+/*==========================================================================*/
+/* QH and qTD links carry flags in their low 5 bits */
+static __INLINE uint32_t LinkPointer(uint32_t Link)
+{
+	return Link & 0xFFFFFFE0UL;
+}
+
+static __INLINE volatile uint32_t *QtdWords(uint32_t Link)
+{
+	return (volatile uint32_t *) (uintptr_t) LinkPointer(Link);
+}
+
+/* Copy a packet between the bus and the buffer pages of the overlay, a packet may cross into the next page */
+static void CopyPacket(volatile uint32_t *Overlay, uint32_t Token, uint8_t *Packet, uint16_t Length, bool ToMemory)
+{
+	uint32_t Page   = TOKEN_CPAGE(Token);
+	uint32_t Offset = Overlay[QTD_PAGE0] & 0xFFF;
+	uint16_t Done   = 0;
+
+	while ((Done < Length) && (Page < 5))
+	{
+		uint8_t *Address = (uint8_t *) (uintptr_t) ((Overlay[QTD_PAGE0 + Page] & 0xFFFFF000UL) + Offset);
+		uint16_t Chunk = MIN(Length - Done, 0x1000 - Offset);
+
+		if (ToMemory)
+			memcpy(Address, Packet + Done, Chunk);
+		else
+			memcpy(Packet + Done, Address, Chunk);
+
+		Done  += Chunk;
+		Offset = 0;
+		Page++;
+	}
+}
+
+/* Write the overlay's transfer state back to the qTD it came from and raise the interrupts it asks for */
+static void RetireQtd(PHCD_QHD Qh, volatile uint32_t *Overlay, uint32_t Token, uint32_t InterruptSource)
+{
+	volatile uint32_t *Qtd = QtdWords(Qh->CurrentQtd);
+
+	Overlay[QTD_TOKEN] = Token;
+	Qtd[QTD_PAGE0] = Overlay[QTD_PAGE0];
+	Qtd[QTD_TOKEN] = Token;
+	Stats.QtdsRetired++;
+
+	if (Token & TOKEN_HALTED)
+		RaiseInterrupt(EHC_USBSTS_UsbErrorInt | ((Token & TOKEN_IOC) ? (EHC_USBSTS_UsbInt | InterruptSource) : 0));
+	else if ((Token & TOKEN_IOC) || ((TOKEN_PID(Token) == PID_IN) && TOKEN_BYTES(Token)))	/* IOC or short packet */
+		RaiseInterrupt(EHC_USBSTS_UsbInt | InterruptSource);
+}
+
+/* Load the next qTD into an idle overlay, EHCI 4.10.2. Returns false if the queue has nothing to do. */
+static bool AdvanceQueue(PHCD_QHD Qh, volatile uint32_t *Overlay)
+{
+	uint32_t Token = Overlay[QTD_TOKEN];
+	uint32_t Link;
+	volatile uint32_t *Qtd;
+	uint32_t i;
+
+	if (Token & TOKEN_HALTED)
+		return false;
+	if (Token & TOKEN_ACTIVE)
+		return true;
+
+	/* A short packet leaves bytes in the overlay and takes the alternate link when there is one */
+	if (TOKEN_BYTES(Token) && !(Overlay[QTD_ALTERNATE] & LINK_TERMINATE))
+		Link = Overlay[QTD_ALTERNATE];
+	else
+		Link = Overlay[QTD_NEXT];
+
+	if (Link & LINK_TERMINATE)
+		return false;
+	Qtd = QtdWords(Link);
+	if (!(Qtd[QTD_TOKEN] & TOKEN_ACTIVE))
+		return false;
+
+	Qh->CurrentQtd = LinkPointer(Link);
+	for (i = 0; i < QTD_WORDS; i++)
+	{
+		if (i != QTD_TOKEN)
+			Overlay[i] = Qtd[i];
+	}
+
+	/* Without data toggle control the toggle stays with the queue head */
+	Token = Qtd[QTD_TOKEN];
+	if (!Qh->DataToggleControl)
+		Token = (Token & ~TOKEN_TOGGLE) | (Overlay[QTD_TOKEN] & TOKEN_TOGGLE);
+	Overlay[QTD_TOKEN] = Token;
+	return true;
+}
+
+/* Run one transaction for the qTD in the overlay of the QH.
+ * Returns the bus byte times used, 0 if the QH has nothing to do or the transaction does not fit.
+ */
+static uint32_t ServiceQueueHead(PHCD_QHD Qh, uint32_t Budget, uint32_t InterruptSource, bool *Progress)
+{
+	static uint8_t Packet[1024];
+	volatile uint32_t *Overlay = (volatile uint32_t *) &Qh->Overlay;
+	EhciSim_Handshake_t Handshake;
+	uint32_t Token;
+	uint32_t Remaining;
+	uint32_t Offset;
+	uint32_t Cost;
+	uint16_t MaxPacket = Qh->MaxPackageSize;
+	uint16_t PacketLength;
+	uint16_t Received = 0;
+	uint8_t  Pid;
+
+	if (!AdvanceQueue(Qh, Overlay))
+		return 0;
+
+	Token        = Overlay[QTD_TOKEN];
+	Pid          = TOKEN_PID(Token);
+	Remaining    = TOKEN_BYTES(Token);
+	PacketLength = MIN(Remaining, MaxPacket);
+
+	Cost = (uint32_t) ((Pid == PID_IN) ? MaxPacket : PacketLength) + HS_PACKET_OVERHEAD;
+	if (Cost > Budget)
+		return 0;
+
+	if ((Device == NULL) || !(REG(PORTSC1_H) & EHC_PORTSC_PortEnable) || (Qh->DeviceAddress != Device->Address))
+	{
+		Handshake = EHCISIM_NO_RESPONSE;
+	}
+	else if (Pid == PID_SETUP)
+	{
+		CopyPacket(Overlay, Token, Packet, 8, false);
+		Handshake = Device->Setup(Device, Packet);
+	}
+	else if (Pid == PID_OUT)
+	{
+		CopyPacket(Overlay, Token, Packet, PacketLength, false);
+		Handshake = Device->Out(Device, Qh->EndpointNumber, Packet, PacketLength);
+	}
+	else
+	{
+		Handshake = Device->In(Device, Qh->EndpointNumber, Packet, MaxPacket, &Received);
+	}
+
+	switch (Handshake)
+	{
+	case EHCISIM_NAK:
+		Stats.Naks++;
+		return Cost;
+
+	case EHCISIM_STALL:
+		RetireQtd(Qh, Overlay, (Token & ~TOKEN_ACTIVE) | TOKEN_HALTED, InterruptSource);
+		*Progress = true;
+		return Cost;
+
+	case EHCISIM_NO_RESPONSE:
+		RetireQtd(Qh, Overlay, (Token & ~TOKEN_ACTIVE) | TOKEN_HALTED | TOKEN_TRANSACTION_ERROR, InterruptSource);
+		*Progress = true;
+		return Cost;
+
+	case EHCISIM_ACK:
+	default:
+		break;
+	}
+
+	Stats.Packets++;
+	*Progress = true;
+	Token ^= TOKEN_TOGGLE;
+
+	if (Pid == PID_IN)
+	{
+		if (Received > Remaining)		/* babble */
+		{
+			RetireQtd(Qh, Overlay, (Token & ~TOKEN_ACTIVE) | TOKEN_HALTED, InterruptSource);
+			return Cost;
+		}
+		CopyPacket(Overlay, Token, Packet, Received, true);
+		PacketLength = Received;
+	}
+
+	/* Advance the current page and offset past the packet */
+	Remaining -= PacketLength;
+	Offset = (Overlay[QTD_PAGE0] & 0xFFF) + PacketLength;
+	Token  = (Token & ~(TOKEN_BYTES_MASK | TOKEN_CPAGE_MASK)) | (Remaining << 16) |
+			 ((uint32_t) MIN(TOKEN_CPAGE(Token) + (Offset >> 12), 4) << 12);
+	Overlay[QTD_PAGE0] = (Overlay[QTD_PAGE0] & 0xFFFFF000UL) | (Offset & 0xFFF);
+
+	if ((Remaining == 0) || ((Pid == PID_IN) && (PacketLength < MaxPacket)))	/* end of buffer or short packet */
+		RetireQtd(Qh, Overlay, Token & ~TOKEN_ACTIVE, InterruptSource);
+	else
+		Overlay[QTD_TOKEN] = Token;
+
+	return Cost;
+}
+
+/* Periodic frame list slot of the micro-frame: interrupt QHs whose S-mask has the micro-frame */
+static uint32_t ServicePeriodicList(uint32_t Budget)
+{
+	uint32_t Frame = REG(FRINDEX_H) >> 3;
+	uint32_t Micro = REG(FRINDEX_H) & EHC_UFRAME_MASK;
+	NextLinkPointer *List = (NextLinkPointer *) (uintptr_t) REG(PERIODICLISTBASE);
+	uint32_t Link;
+	uint32_t Used = 0;
+	uint32_t Walk;
+	bool     Progress = false;
+
+	if (List == NULL)
+		return 0;
+
+	for (Link = List[Frame % FRAME_LIST_SIZE].Link, Walk = 0; !(Link & LINK_TERMINATE) && (Walk < MAX_LIST_WALK); Walk++)
+	{
+		NextLinkPointer *Element = (NextLinkPointer *) (uintptr_t) LinkPointer(Link);
+
+		if (((Link >> 1) & 3) == QH_TYPE)
+		{
+			PHCD_QHD Qh = (PHCD_QHD) Element;
+
+			if (Qh->uFrameSMask & (1 << Micro))
+				Used += ServiceQueueHead(Qh, Budget - Used, EHC_USBSTS_UsbPeriodInt, &Progress);
+		}
+		Link = Element->Link;			/* iTDs and siTDs are not modelled, only walked over */
+	}
+	return Used;
+}
+
+/* Passes over the asynchronous ring, one transaction per QH and pass, until nothing moves or the micro-frame is full */
+static uint32_t ServiceAsyncList(uint32_t Budget)
+{
+	PHCD_QHD Head = (PHCD_QHD) (uintptr_t) REG(ASYNCLISTADDR);
+	PHCD_QHD Qh;
+	uint32_t Used = 0;
+	uint32_t Walk;
+	bool     Progress;
+
+	if (Head == NULL)
+		return 0;
+
+	do
+	{
+		Progress = false;
+		Qh = Head;
+		for (Walk = 0; Walk < MAX_LIST_WALK; Walk++)
+		{
+			Used += ServiceQueueHead(Qh, Budget - Used, EHC_USBSTS_UsbAsyncInt, &Progress);
+			if (Qh->Horizontal.Link & LINK_TERMINATE)
+				break;
+			Qh = (PHCD_QHD) (uintptr_t) LinkPointer(Qh->Horizontal.Link);
+			if (Qh == Head)
+				break;
+		}
+	} while (Progress && (Used < Budget));
+
+	return Used;
+}
+
+static void RunMicroFrame(void)
+{
+	uint32_t Budget = MICROFRAME_BYTE_TIMES;
+
+	if (REG(USBCMD_H) & EHC_USBCMD_IntAsyncAdvanceDoorbell)
+	{
+		REG(USBCMD_H) &= ~EHC_USBCMD_IntAsyncAdvanceDoorbell;
+		RaiseInterrupt(EHC_USBSTS_IntAsyncAdvance);
+	}
+
+	if (REG(USBSTS_H) & EHC_USBSTS_PeriodScheduleStatus)
+		Budget -= ServicePeriodicList(Budget);
+	if (REG(USBSTS_H) & EHC_USBSTS_AsyncScheduleStatus)
+		Budget -= ServiceAsyncList(Budget);
+
+	REG(FRINDEX_H) = (REG(FRINDEX_H) + 1) & HC_FRINDEX_MASK;
+}
+
+static void RunFrame(void)
+{
+	uint32_t i;
+
+	FrameNumber++;
+	Stats.Frames++;
+
+	if (PortResetFrames && !(--PortResetFrames))
+	{
+		/* The LPC18xx ends the reset itself and enables the port, no PEC */
+		REG(PORTSC1_H) = (REG(PORTSC1_H) & ~EHC_PORTSC_PortReset) | EHC_PORTSC_PortEnable | HC_PORTSC_HIGH_SPEED;
+		if (Device)
+			Device->Reset(Device);
+	}
+
+	if (REG(USBSTS_H) & EHC_USBSTS_HCHalted)
+		return;
+
+	for (i = 0; i < MICROFRAMES_PER_FRAME; i++)
+		RunMicroFrame();
+}
+
+static bool InterruptPending(void)
+{
+	return IrqEnabled && (REG(USBSTS_H) & REG(USBINTR_H) & EHC_USBINTR_ALL);
+}
+
+static void FrameHandler(int Signal)
+{
+	uint64_t Start, IsrStart, IsrEnd, Accesses;
+
+	if (Calibrating)
+		return;
+
+	Start = EhciSim_ReadTSC();
+	RunFrame();
+	IsrStart = IsrEnd = EhciSim_ReadTSC();
+
+	if (InterruptPending())
+	{
+		Stats.Interrupts++;
+		Accesses = Stats.RegisterAccesses;
+		HcdIrqHandler(0);				/* USB0_IRQHandler() */
+		IsrEnd = EhciSim_ReadTSC();
+		Stats.IsrCycles += (IsrEnd - IsrStart) - MIN(IsrEnd - IsrStart, (Stats.RegisterAccesses - Accesses) * TrapCycles);
+	}
+
+	ModelCycles += (IsrStart - Start) + (EhciSim_ReadTSC() - IsrEnd);
+}
+
+/*==========================================================================*/
+/* Public API                                                              */
+/*==========================================================================*/
+static void BlockFrames(sigset_t *Saved)
+{
+	sigset_t Mask;
+
+	sigemptyset(&Mask);
+	sigaddset(&Mask, SIGALRM);
+	sigprocmask(SIG_BLOCK, &Mask, Saved);
+}
+
+static void RestoreFrames(sigset_t *Saved)
+{
+	sigprocmask(SIG_SETMASK, Saved, NULL);
+}
+
+/* Cost of a trapped register access and of a frame signal, subtracted from the host's cycle counts */
+static void Calibrate(void)
+{
+	const uint32_t Rounds = 1000;
+	uint64_t Start;
+	uint32_t i;
+
+	Calibrating = true;
+
+	Start = EhciSim_ReadTSC();
+	for (i = 0; i < Rounds; i++)
+	{
+		(void) EhciSim_Registers->CAPLENGTH;
+	}
+	TrapCycles = (EhciSim_ReadTSC() - Start) / Rounds;
+
+	Start = EhciSim_ReadTSC();
+	for (i = 0; i < Rounds; i++)
+	{
+		raise(SIGALRM);
+	}
+	SignalCycles = (EhciSim_ReadTSC() - Start) / Rounds;
+
+	Stats.RegisterAccesses = 0;
+	Calibrating = false;
+}
+
+bool EhciSim_Init(uint32_t FramePeriodUS)
+{
+	struct sigaction Action;
+	struct itimerval Timer;
+	int Fd;
+
+	Fd = memfd_create("ehcisim", 0);
+	if ((Fd < 0) || (ftruncate(Fd, REGISTER_PAGE_SIZE) != 0))
+		return false;
+
+	RegisterFile = mmap(NULL, REGISTER_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0);
+	RegisterTrap = mmap(NULL, REGISTER_PAGE_SIZE, PROT_NONE, MAP_SHARED, Fd, 0);
+	close(Fd);
+	if ((RegisterFile == MAP_FAILED) || (RegisterTrap == MAP_FAILED))
+		return false;
+	EhciSim_Registers = (LPC_USB0_Type *) RegisterTrap;
+
+	REG(CAPLENGTH) = HC_CAPLENGTH;
+	REG(HCSPARAMS) = HC_HCSPARAMS;
+	REG(PORTSC1_H) = 0;
+	HostControllerReset();
+
+	memset(&Action, 0, sizeof(Action));
+	sigemptyset(&Action.sa_mask);
+	sigaddset(&Action.sa_mask, SIGALRM);
+	Action.sa_flags = SA_SIGINFO;
+	Action.sa_sigaction = RegisterFaultHandler;
+	sigaction(SIGSEGV, &Action, NULL);
+	Action.sa_sigaction = RegisterStepHandler;
+	sigaction(SIGTRAP, &Action, NULL);
+
+	memset(&Action, 0, sizeof(Action));
+	sigemptyset(&Action.sa_mask);
+	Action.sa_flags = SA_RESTART;
+	Action.sa_handler = FrameHandler;
+	sigaction(SIGALRM, &Action, NULL);
+
+	Calibrate();
+
+	Timer.it_interval.tv_sec  = FramePeriodUS / 1000000;
+	Timer.it_interval.tv_usec = FramePeriodUS % 1000000;
+	Timer.it_value = Timer.it_interval;
+	return setitimer(ITIMER_REAL, &Timer, NULL) == 0;
+}
+
+void EhciSim_DeInit(void)
+{
+	struct itimerval Timer;
+
+	memset(&Timer, 0, sizeof(Timer));
+	setitimer(ITIMER_REAL, &Timer, NULL);
+	signal(SIGALRM, SIG_IGN);
+}
+
+void EhciSim_Attach(EhciSim_Device_t *NewDevice)
+{
+	sigset_t Saved;
+
+	BlockFrames(&Saved);
+	Device = NewDevice;
+	REG(PORTSC1_H) |= EHC_PORTSC_CurrentConnectStatus | EHC_PORTSC_ConnectStatusChange | HC_PORTSC_HIGH_SPEED;
+	RaiseInterrupt(EHC_USBSTS_PortChangeDetect);
+	RestoreFrames(&Saved);
+}
+
+void EhciSim_Detach(void)
+{
+	sigset_t Saved;
+
+	BlockFrames(&Saved);
+	Device = NULL;
+	REG(PORTSC1_H) = (REG(PORTSC1_H) & ~(EHC_PORTSC_CurrentConnectStatus | EHC_PORTSC_PortEnable | EHC_PORTSC_PortSpeed)) |
+					 EHC_PORTSC_ConnectStatusChange;
+	RaiseInterrupt(EHC_USBSTS_PortChangeDetect);
+	RestoreFrames(&Saved);
+}
+
+void EhciSim_SetInterruptEnable(bool Enable)
+{
+	IrqEnabled = Enable;
+}
+
+uint64_t EhciSim_GetFrameNumber(void)
+{
+	return FrameNumber;
+}
+
+void EhciSim_GetStats(EhciSim_Stats_t *Result)
+{
+	sigset_t Saved;
+
+	BlockFrames(&Saved);
+	*Result = Stats;
+	Result->OverheadCycles = ModelCycles + (Stats.RegisterAccesses * TrapCycles) + (Stats.Frames * SignalCycles);
+	RestoreFrames(&Saved);
+}
@@ -0,0 +1,81 @@
+/*
+ * EHCI_Model.h
+ *
+ * Software model of the LPC18xx EHCI host controller for running the high
+ * speed host driver (EHCI.c) as a Linux process, the counterpart of
+ * OHCI_Model.h for the full speed parts.
+ *
+ * The register block lives on its own page which the driver sees through a
+ * PROT_NONE mapping: every register access faults, is single-stepped and
+ * replayed through the model, so the write-1-to-clear status bits, port reset
+ * and the schedule status bits behave like the silicon. A SIGALRM timer runs
+ * one virtual 1 ms frame of eight micro-frames per tick: every micro-frame
+ * walks the periodic frame list slot and the asynchronous ring within the
+ * high speed bandwidth of a micro-frame, executing qTDs through the queue head
+ * overlay as the EHCI does (alternate links on short packets included). At
+ * the end of the frame HcdIrqHandler() is called like USB0_IRQHandler(),
+ * which matches the 8 micro-frame interrupt threshold the driver programs.
+ *
+ * Only a high speed function on the root port is modelled: no split
+ * transactions, and iTDs/siTDs on the periodic list are skipped. Requires
+ * x86-64 Linux and a non-PIE build (-no-pie) so that the QH/qTD and buffer
+ * addresses the driver stores in 32-bit fields are valid pointers.
+ */
+
+#ifndef HOSTSIM_EHCI_MODEL_H_
+#define HOSTSIM_EHCI_MODEL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Handshake returned by a simulated function for one transaction */
+typedef enum {
+	EHCISIM_ACK,
+	EHCISIM_NAK,
+	EHCISIM_STALL,
+	EHCISIM_NO_RESPONSE,
+} EhciSim_Handshake_t;
+
+/* A high speed function attached to the root port */
+typedef struct EhciSim_Device {
+	uint8_t Address;		/* current function address, maintained by the device */
+
+	/* Bus reset of the port */
+	void (*Reset)(struct EhciSim_Device *Device);
+	/* SETUP transaction to endpoint 0, Request points to the 8 byte request */
+	EhciSim_Handshake_t (*Setup)(struct EhciSim_Device *Device, const uint8_t *Request);
+	/* OUT transaction carrying Length bytes */
+	EhciSim_Handshake_t (*Out)(struct EhciSim_Device *Device, uint8_t Endpoint, const uint8_t *Data, uint16_t Length);
+	/* IN transaction, the device returns up to MaxLength bytes in Data and their count in Length */
+	EhciSim_Handshake_t (*In)(struct EhciSim_Device *Device, uint8_t Endpoint, uint8_t *Data, uint16_t MaxLength, uint16_t *Length);
+} EhciSim_Device_t;
+
+typedef struct {
+	uint64_t Frames;			/* virtual 1 ms frames run */
+	uint64_t Packets;			/* data transactions acknowledged */
+	uint64_t Naks;				/* transactions NAKed by the device */
+	uint64_t QtdsRetired;		/* qTDs completed or halted */
+	uint64_t Interrupts;		/* calls into HcdIrqHandler() */
+	uint64_t RegisterAccesses;	/* trapped register reads and writes */
+	uint64_t IsrCycles;			/* TSC cycles spent in HcdIrqHandler(), register trap round trips excluded */
+	uint64_t OverheadCycles;	/* TSC cycles spent in the model, trap round trips and frame signals included */
+} EhciSim_Stats_t;
+
+/* Maps the register page, installs the trap handlers and starts the frame timer.
+ * FramePeriodUS is the wall clock time given to one virtual frame.
+ */
+bool EhciSim_Init(uint32_t FramePeriodUS);
+void EhciSim_DeInit(void);
+
+/* Plug/unplug the device on the root port (port change on the next access) */
+void EhciSim_Attach(EhciSim_Device_t *Device);
+void EhciSim_Detach(void);
+
+/* Stand-in for the NVIC enable bit of USB0_IRQn */
+void EhciSim_SetInterruptEnable(bool Enable);
+
+uint64_t EhciSim_GetFrameNumber(void);
+void EhciSim_GetStats(EhciSim_Stats_t *Stats);
+uint64_t EhciSim_ReadTSC(void);
+
+#endif /* HOSTSIM_EHCI_MODEL_H_ */
@@ -0,0 +1,28 @@
+/*
+ * FreeRTOS.h
+ *
+ * Host simulation shim. fatfs/src/ffconf.h includes the FreeRTOS headers for
+ * the semaphore type of _FS_REENTRANT; the benchmarks only link the disk
+ * drivers below FatFs, so that type is all they need (see semphr.h). The
+ * USB keyboard host also uses the port types and the few calls declared in
+ * task.h and semphr.h, which kbd_bench.c implements on the frame counter.
+ */
+
+#ifndef HOSTSIM_FREERTOS_H_
+#define HOSTSIM_FREERTOS_H_
+
+#include <stdint.h>
+
+typedef uint32_t portTickType;
+typedef long     portBASE_TYPE;
+
+#define pdFALSE										0
+#define pdTRUE										1
+#define portMAX_DELAY								((portTickType) 0xFFFFFFFFUL)
+#define portTICK_RATE_MS							((portTickType) 1)
+#define configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY	5
+
+/* The simulated interrupt returns to the code it interrupted, there is no task to switch to */
+#define portEND_SWITCHING_ISR(TaskWoken)			((void) (TaskWoken))
+
+#endif /* HOSTSIM_FREERTOS_H_ */
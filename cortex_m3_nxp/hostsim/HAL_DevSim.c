@@ -0,0 +1,51 @@
+/*
+ * HAL_DevSim.c
+ *
+ * USB HAL of the device simulation, replaces HAL_LPC17xx.c. There are no
+ * pins to set up; the clock handshake and the reset of the device controller
+ * go to the DCD model, and the interrupt enable is handed to it as well: it
+ * calls DcdIrqHandler() itself at the end of each slice. With
+ * INTERRUPT_CONTROL_ENDPOINT, control requests are processed in the model's
+ * deferred interrupt.
+ */
+
+#include "../lpcusblib/Drivers/USB/Core/LPC/HAL/HAL_LPC.h"
+#include "../lpcusblib/Drivers/USB/Core/USBTask.h"
+#include "DCD_Model.h"
+
+void HAL_USBInit(uint8_t corenum)
+{
+	LPC_USB->USBClkCtrl = 0x12;                 /* Dev, PortSel, AHB clock enable */
+	while ((LPC_USB->USBClkSt & 0x12) != 0x12);
+	HAL_Reset();
+#if defined(INTERRUPT_CONTROL_ENDPOINT)
+	DcdSim_SetDeferredHandler(USB_DeviceControlTask);
+#endif
+}
+
+void HAL_USBDeInit(uint8_t corenum)
+{
+	DcdSim_SetInterruptEnable(false);
+}
+
+void HAL_EnableUSBInterrupt(uint8_t corenum)
+{
+	DcdSim_SetInterruptEnable(true);
+}
+
+void HAL_DisableUSBInterrupt(uint8_t corenum)
+{
+	DcdSim_SetInterruptEnable(false);
+}
+
+void HAL_USBConnect(uint8_t corenum, uint32_t con)
+{
+	HAL17XX_USBConnect(con);
+}
+
+#if defined(INTERRUPT_CONTROL_ENDPOINT)
+void HAL_PendControlRequest(uint8_t corenum)
+{
+	DcdSim_PendDeferredInterrupt();
+}
+#endif
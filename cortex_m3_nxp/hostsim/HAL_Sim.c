@@ -0,0 +1,33 @@
+/*
+ * HAL_Sim.c
+ *
+ * USB HAL of the host simulation, replaces HAL_LPC17xx.c. There are no pins
+ * or clocks to set up; the interrupt enable is handed to the OHCI model which
+ * calls HcdIrqHandler() itself at the end of each frame.
+ */
+
+#include "../lpcusblib/Drivers/USB/Core/LPC/HAL/HAL_LPC.h"
+#include "OHCI_Model.h"
+
+void HAL_USBInit(uint8_t corenum)
+{
+}
+
+void HAL_USBDeInit(uint8_t corenum)
+{
+	OhciSim_SetInterruptEnable(false);
+}
+
+void HAL_EnableUSBInterrupt(uint8_t corenum)
+{
+	OhciSim_SetInterruptEnable(true);
+}
+
+void HAL_DisableUSBInterrupt(uint8_t corenum)
+{
+	OhciSim_SetInterruptEnable(false);
+}
+
+void HAL_USBConnect(uint8_t corenum, uint32_t con)
+{
+}
@@ -0,0 +1,260 @@
+/*
+ * HSDisk_Device.c
+ *
+ * Virtual high speed Bulk-Only mass storage device, see HSDisk_Device.h.
+ */
+
+#include <string.h>
+
+#include "HSDisk_Device.h"
+
+#define MIN(a, b)					(((a) < (b)) ? (a) : (b))
+
+/* Control transfer stages */
+#define CONTROL_IDLE				0
+#define CONTROL_DATA_IN				1
+#define CONTROL_DATA_OUT			2
+#define CONTROL_STATUS_IN			3
+#define CONTROL_STALLED				4
+
+/* Bulk-Only Transport stages */
+#define BOT_CBW						0
+#define BOT_DATA_IN					1
+#define BOT_CSW						2
+
+#define BOT_CBW_SIGNATURE			0x43425355UL
+#define BOT_CSW_SIGNATURE			0x53425355UL
+#define BOT_CBW_LENGTH				31
+#define BOT_CSW_LENGTH				13
+
+#define SCSI_READ_10				0x28
+
+static const uint8_t DeviceDescriptor[] = {
+	18, 0x01, 0x00, 0x02, 0x00, 0x00, 0x00, 64,
+	0xC9, 0x1F, 0x12, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01
+};
+
+static uint32_t GetLE32(const uint8_t *Data)
+{
+	return Data[0] | (Data[1] << 8) | (Data[2] << 16) | ((uint32_t) Data[3] << 24);
+}
+
+static uint32_t GetBE32(const uint8_t *Data)
+{
+	return ((uint32_t) Data[0] << 24) | (Data[1] << 16) | (Data[2] << 8) | Data[3];
+}
+
+static void PutLE32(uint8_t *Data, uint32_t Value)
+{
+	Data[0] = Value;
+	Data[1] = Value >> 8;
+	Data[2] = Value >> 16;
+	Data[3] = Value >> 24;
+}
+
+/*==========================================================================*/
+/* Bulk-Only Transport                                                     */
+/*==========================================================================*/
+/* Only READ(10) has a data stage, anything else completes at once */
+static void ExecuteCommand(HSDisk_Device_t *Disk, const uint8_t *Cbw)
+{
+	const uint8_t *Cdb = &Cbw[15];
+	uint32_t Expected = GetLE32(&Cbw[8]);
+	uint32_t Length = 0;
+
+	Disk->Tag    = GetLE32(&Cbw[4]);
+	Disk->Status = 0;
+	Disk->Commands++;
+
+	if (Cdb[0] == SCSI_READ_10)
+	{
+		Disk->Position = (uint64_t) GetBE32(&Cdb[2]) * HSDISK_DEVICE_BLOCK_SIZE;
+		Length = MIN(((Cdb[7] << 8) | Cdb[8]) * HSDISK_DEVICE_BLOCK_SIZE, Expected);
+		Length -= MIN(Length, Disk->ShortBy);
+	}
+
+	Disk->DataRemaining = Length;
+	Disk->Residue       = Expected - Length;
+	Disk->Stage         = Length ? BOT_DATA_IN : BOT_CSW;
+}
+
+static EhciSim_Handshake_t BulkIn(HSDisk_Device_t *Disk, uint8_t *Data, uint16_t MaxLength, uint16_t *Length)
+{
+	uint16_t Count;
+	uint16_t i;
+
+	if (Disk->Stage == BOT_CSW)
+	{
+		PutLE32(&Data[0], BOT_CSW_SIGNATURE);
+		PutLE32(&Data[4], Disk->Tag);
+		PutLE32(&Data[8], Disk->Residue);
+		Data[12] = Disk->Status;
+		*Length = BOT_CSW_LENGTH;
+		Disk->Stage = BOT_CBW;
+		return EHCISIM_ACK;
+	}
+
+	if (Disk->Stage != BOT_DATA_IN)
+		return EHCISIM_NAK;
+
+	Count = MIN(MaxLength, Disk->DataRemaining);
+	for (i = 0; i < Count; i++)
+		Data[i] = HSDisk_Device_Pattern(Disk->Position + i);
+
+	Disk->Position      += Count;
+	Disk->BytesRead     += Count;
+	Disk->DataRemaining -= Count;
+	*Length = Count;
+
+	/* A data stage cut short ends with a short packet, a zero length one if need be */
+	if ((Disk->DataRemaining == 0) && !((Count == MaxLength) && Disk->Residue))
+		Disk->Stage = BOT_CSW;
+	return EHCISIM_ACK;
+}
+
+static EhciSim_Handshake_t BulkOut(HSDisk_Device_t *Disk, const uint8_t *Data, uint16_t Length)
+{
+	if (Disk->Stage != BOT_CBW)
+		return EHCISIM_NAK;
+
+	if ((Length == BOT_CBW_LENGTH) && (GetLE32(Data) == BOT_CBW_SIGNATURE))
+		ExecuteCommand(Disk, Data);
+	return EHCISIM_ACK;
+}
+
+/*==========================================================================*/
+/* Control endpoint                                                        */
+/*==========================================================================*/
+static EhciSim_Handshake_t Setup(EhciSim_Device_t *Device, const uint8_t *Request)
+{
+	HSDisk_Device_t *Disk = (HSDisk_Device_t *) Device;
+	uint8_t  bmRequestType = Request[0];
+	uint8_t  bRequest = Request[1];
+	uint16_t wValue = Request[2] | (Request[3] << 8);
+	uint16_t wLength = Request[6] | (Request[7] << 8);
+	bool     Supported = true;
+
+	Disk->ControlLength = 0;
+	Disk->ControlOffset = 0;
+	Disk->PendingAddress = Device->Address;
+
+	switch ((bmRequestType << 8) | bRequest)
+	{
+	case 0x8006:	/* GET_DESCRIPTOR(DEVICE) */
+		if ((wValue >> 8) == 0x01)
+		{
+			Disk->ControlLength = MIN(sizeof(DeviceDescriptor), wLength);
+			memcpy(Disk->ControlData, DeviceDescriptor, Disk->ControlLength);
+		}
+		else
+		{
+			Supported = false;
+		}
+		break;
+
+	case 0x0005:	/* SET_ADDRESS, takes effect after the status stage */
+		Disk->PendingAddress = wValue & 0x7F;
+		break;
+
+	case 0x0009:	/* SET_CONFIGURATION */
+		Disk->Configuration = wValue;
+		Disk->Stage = BOT_CBW;
+		break;
+
+	default:
+		Supported = false;
+		break;
+	}
+
+	if (!Supported)
+		Disk->ControlStage = CONTROL_STALLED;
+	else if (wLength && (bmRequestType & 0x80))
+		Disk->ControlStage = CONTROL_DATA_IN;
+	else if (wLength)
+		Disk->ControlStage = CONTROL_DATA_OUT;
+	else
+		Disk->ControlStage = CONTROL_STATUS_IN;
+
+	return EHCISIM_ACK;		/* SETUP is always acknowledged, errors stall the next stage */
+}
+
+static EhciSim_Handshake_t In(EhciSim_Device_t *Device, uint8_t Endpoint, uint8_t *Data, uint16_t MaxLength, uint16_t *Length)
+{
+	HSDisk_Device_t *Disk = (HSDisk_Device_t *) Device;
+	uint16_t Count;
+
+	if ((Endpoint == HSDISK_DEVICE_IN_ENDPOINT) && Disk->Configuration)
+		return BulkIn(Disk, Data, MaxLength, Length);
+	if (Endpoint != 0)
+		return EHCISIM_STALL;
+
+	switch (Disk->ControlStage)
+	{
+	case CONTROL_DATA_IN:
+		Count = MIN(MaxLength, Disk->ControlLength - Disk->ControlOffset);
+		memcpy(Data, &Disk->ControlData[Disk->ControlOffset], Count);
+		Disk->ControlOffset += Count;
+		*Length = Count;
+		return EHCISIM_ACK;
+
+	case CONTROL_STATUS_IN:
+	case CONTROL_DATA_OUT:		/* status stage of an OUT request */
+		*Length = 0;
+		Device->Address = Disk->PendingAddress;
+		Disk->ControlStage = CONTROL_IDLE;
+		return EHCISIM_ACK;
+
+	case CONTROL_STALLED:
+		return EHCISIM_STALL;
+
+	default:
+		return EHCISIM_NAK;
+	}
+}
+
+static EhciSim_Handshake_t Out(EhciSim_Device_t *Device, uint8_t Endpoint, const uint8_t *Data, uint16_t Length)
+{
+	HSDisk_Device_t *Disk = (HSDisk_Device_t *) Device;
+
+	if ((Endpoint == HSDISK_DEVICE_OUT_ENDPOINT) && Disk->Configuration)
+		return BulkOut(Disk, Data, Length);
+	if (Endpoint != 0)
+		return EHCISIM_STALL;
+
+	switch (Disk->ControlStage)
+	{
+	case CONTROL_DATA_IN:		/* status stage of an IN request */
+		Disk->ControlStage = CONTROL_IDLE;
+		return EHCISIM_ACK;
+
+	case CONTROL_STALLED:
+		return EHCISIM_STALL;
+
+	default:
+		return EHCISIM_ACK;
+	}
+}
+
+static void Reset(EhciSim_Device_t *Device)
+{
+	HSDisk_Device_t *Disk = (HSDisk_Device_t *) Device;
+
+	Device->Address     = 0;
+	Disk->Configuration = 0;
+	Disk->ControlStage  = CONTROL_IDLE;
+	Disk->Stage         = BOT_CBW;
+}
+
+/*==========================================================================*/
+/* Public API                                                              */
+/*==========================================================================*/
+void HSDisk_Device_Init(HSDisk_Device_t *Disk)
+{
+	memset(Disk, 0, sizeof(HSDisk_Device_t));
+
+	Disk->Device.Reset = Reset;
+	Disk->Device.Setup = Setup;
+	Disk->Device.In    = In;
+	Disk->Device.Out   = Out;
+	Reset(&Disk->Device);
+}
@@ -0,0 +1,60 @@
+/*
+ * HSDisk_Device.h
+ *
+ * Virtual high speed Bulk-Only Transport mass storage device for the EHCI
+ * model. READ(10) is served from a pattern computed from the byte position on
+ * the medium, so no image is needed and the host can check every byte. The
+ * data stage of a READ can be cut short by a number of bytes: the device then
+ * ends it with a short packet and reports the residue in the CSW, as a
+ * device with a medium error would.
+ */
+
+#ifndef HOSTSIM_HSDISK_DEVICE_H_
+#define HOSTSIM_HSDISK_DEVICE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "EHCI_Model.h"
+
+#define HSDISK_DEVICE_BLOCK_SIZE		512
+#define HSDISK_DEVICE_PACKET_SIZE		512
+#define HSDISK_DEVICE_IN_ENDPOINT		1
+#define HSDISK_DEVICE_OUT_ENDPOINT		2
+#define HSDISK_DEVICE_PATTERN_PERIOD	251
+
+typedef struct {
+	EhciSim_Device_t Device;		/* must stay first, the model hands it back to the callbacks */
+
+	/* Control endpoint */
+	uint8_t  ControlData[64];
+	uint16_t ControlLength;
+	uint16_t ControlOffset;
+	uint8_t  ControlStage;
+	uint8_t  PendingAddress;
+	uint8_t  Configuration;
+
+	/* Bulk-Only Transport */
+	uint8_t  Stage;
+	uint32_t Tag;
+	uint32_t DataRemaining;			/* bytes the device still sends in the data stage */
+	uint32_t Residue;
+	uint8_t  Status;
+	uint64_t Position;				/* byte position on the medium of the next data byte */
+	uint32_t ShortBy;				/* bytes each READ data stage falls short by, 0 for none */
+
+	/* Statistics */
+	uint64_t Commands;
+	uint64_t BytesRead;
+} HSDisk_Device_t;
+
+/* Resets the device */
+void HSDisk_Device_Init(HSDisk_Device_t *Disk);
+
+/* Pattern byte at a byte position of the medium */
+static inline uint8_t HSDisk_Device_Pattern(uint64_t Position)
+{
+	return (uint8_t) (Position % HSDISK_DEVICE_PATTERN_PERIOD);
+}
+
+#endif /* HOSTSIM_HSDISK_DEVICE_H_ */
@@ -0,0 +1,423 @@
+/*
+ * Hub_Device.c
+ *
+ * Virtual full speed hub, see Hub_Device.h.
+ */
+
+#include <signal.h>
+#include <string.h>
+
+#include "Hub_Device.h"
+
+#define MIN(a, b)					(((a) < (b)) ? (a) : (b))
+
+/* Control transfer stages */
+#define CONTROL_IDLE				0
+#define CONTROL_DATA_IN				1
+#define CONTROL_DATA_OUT			2
+#define CONTROL_STATUS_IN			3
+#define CONTROL_STALLED				4
+
+/* wPortStatus and wPortChange bits */
+#define PORT_CONNECTION				0x0001
+#define PORT_ENABLE					0x0002
+#define PORT_RESET					0x0010
+#define PORT_POWER					0x0100
+#define PORT_LOW_SPEED				0x0200
+#define C_PORT_CONNECTION			0x0001
+#define C_PORT_RESET				0x0010
+
+/* Port feature selectors */
+#define FEATURE_PORT_ENABLE			1
+#define FEATURE_PORT_SUSPEND		2
+#define FEATURE_PORT_RESET			4
+#define FEATURE_PORT_POWER			8
+#define FEATURE_C_PORT_CONNECTION	16
+#define FEATURE_C_PORT_RESET		20
+
+#define POWER_ON_TO_POWER_GOOD		50		/* 2 ms units */
+
+static const uint8_t DeviceDescriptor[] = {
+	18, 0x01, 0x10, 0x01, 0x09, 0x00, 0x00, 64,
+	0xC9, 0x1F, 0x10, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01
+};
+
+static const uint8_t ConfigurationDescriptor[] = {
+	/* Configuration, self powered */
+	9, 0x02, 25, 0, 1, 1, 0, 0xC0, 0,
+	/* Interface: Hub */
+	9, 0x04, 0, 0, 1, 0x09, 0x00, 0x00, 0,
+	/* Status change interrupt IN, one byte covers the hub and seven ports */
+	7, 0x05, 0x80 | HUB_DEVICE_STATUS_ENDPOINT, 0x03, 1, 0, 12
+};
+
+/* Completes the port resets whose signalling time is over */
+static void UpdatePorts(Hub_Device_t *Hub)
+{
+	Hub_Device_Port_t *Port;
+	uint8_t i;
+
+	for (i = 0; i < Hub->Ports; i++)
+	{
+		Port = &Hub->Port[i];
+
+		if (!(Port->Status & PORT_RESET) || Port->ResetStuck || (OhciSim_GetFrameNumber() < Port->ResetDoneFrame))
+			continue;
+
+		Port->Status &= ~PORT_RESET;
+		Port->Change |= C_PORT_RESET;
+		if (Port->Function && (Port->Status & PORT_CONNECTION))
+		{
+			Port->Status |= PORT_ENABLE;
+			Port->Function->Reset(Port->Function);
+		}
+	}
+}
+
+/* Port power on, a plugged function is then seen as connected */
+static void PowerPort(Hub_Device_Port_t *Port)
+{
+	if (Port->Status & PORT_POWER)
+		return;
+
+	Port->Status |= PORT_POWER;
+	if (Port->Function)
+	{
+		Port->Status |= PORT_CONNECTION | (Port->Function->LowSpeed ? PORT_LOW_SPEED : 0);
+		Port->Change |= C_PORT_CONNECTION;
+	}
+}
+
+static bool PortFeature(Hub_Device_t *Hub, bool Set, uint8_t Index, uint16_t Feature)
+{
+	Hub_Device_Port_t *Port;
+
+	if ((Index < 1) || (Index > Hub->Ports))
+		return false;
+
+	Port = &Hub->Port[Index - 1];
+
+	if (Set)
+	{
+		switch (Feature)
+		{
+		case FEATURE_PORT_POWER:
+			PowerPort(Port);
+			return true;
+
+		case FEATURE_PORT_RESET:
+			if (Port->Status & PORT_POWER)
+			{
+				Port->Status = (Port->Status & ~PORT_ENABLE) | PORT_RESET;
+				Port->ResetDoneFrame = OhciSim_GetFrameNumber() + HUB_DEVICE_RESET_FRAMES;
+				Hub->PortResets++;
+			}
+			return true;
+
+		case FEATURE_PORT_SUSPEND:	/* ports are never really suspended */
+			return true;
+
+		default:
+			return false;
+		}
+	}
+
+	switch (Feature)
+	{
+	case FEATURE_PORT_POWER:
+		Port->Status = 0;
+		return true;
+
+	case FEATURE_PORT_ENABLE:
+		Port->Status &= ~PORT_ENABLE;
+		return true;
+
+	case FEATURE_PORT_SUSPEND:
+		return true;
+
+	default:
+		if ((Feature < FEATURE_C_PORT_CONNECTION) || (Feature > FEATURE_C_PORT_RESET))
+			return false;
+		Port->Change &= ~(1 << (Feature - FEATURE_C_PORT_CONNECTION));
+		return true;
+	}
+}
+
+/*==========================================================================*/
+/* Control endpoint                                                        */
+/*==========================================================================*/
+static void ControlReply(Hub_Device_t *Hub, const uint8_t *Data, uint16_t Length, uint16_t wLength)
+{
+	Hub->ControlLength = MIN(MIN(Length, wLength), sizeof(Hub->ControlData));
+	memcpy(Hub->ControlData, Data, Hub->ControlLength);
+}
+
+static OhciSim_Handshake_t Setup(OhciSim_Device_t *Device, const uint8_t *Request)
+{
+	Hub_Device_t *Hub = (Hub_Device_t *) Device;
+	uint8_t  bmRequestType = Request[0];
+	uint8_t  bRequest = Request[1];
+	uint16_t wValue = Request[2] | (Request[3] << 8);
+	uint8_t  wIndex = Request[4];
+	uint16_t wLength = Request[6] | (Request[7] << 8);
+	uint8_t  Reply[9] = {0};
+	bool     Supported = true;
+
+	Hub->ControlLength = 0;
+	Hub->ControlOffset = 0;
+	Hub->PendingAddress = Device->Address;
+	UpdatePorts(Hub);
+
+	switch ((bmRequestType << 8) | bRequest)
+	{
+	case 0x8006:	/* GET_DESCRIPTOR */
+		if ((wValue >> 8) == 0x01)
+			ControlReply(Hub, DeviceDescriptor, sizeof(DeviceDescriptor), wLength);
+		else if ((wValue >> 8) == 0x02)
+			ControlReply(Hub, ConfigurationDescriptor, sizeof(ConfigurationDescriptor), wLength);
+		else
+			Supported = false;
+		break;
+
+	case 0x0005:	/* SET_ADDRESS, takes effect after the status stage */
+		Hub->PendingAddress = wValue & 0x7F;
+		break;
+
+	case 0x0009:	/* SET_CONFIGURATION */
+		Hub->Configuration = wValue;
+		break;
+
+	case 0x8008:	/* GET_CONFIGURATION */
+		Reply[0] = Hub->Configuration;
+		ControlReply(Hub, Reply, 1, wLength);
+		break;
+
+	case 0x8000:	/* GET_STATUS, self powered */
+		Reply[0] = 0x01;
+		ControlReply(Hub, Reply, 2, wLength);
+		break;
+
+	case 0xA006:	/* GET_DESCRIPTOR(HUB) */
+		Reply[0] = 9;
+		Reply[1] = 0x29;
+		Reply[2] = Hub->Ports;
+		Reply[3] = 0x09;		/* per-port power switching and over-current protection */
+		Reply[5] = POWER_ON_TO_POWER_GOOD;
+		Reply[6] = 100;
+		Reply[8] = 0xFF;
+		ControlReply(Hub, Reply, 9, wLength);
+		break;
+
+	case 0xA000:	/* GET_STATUS(HUB), local power good and no over-current */
+		ControlReply(Hub, Reply, 4, wLength);
+		break;
+
+	case 0x2001:	/* CLEAR_FEATURE(C_HUB_LOCAL_POWER / C_HUB_OVER_CURRENT), never raised */
+		break;
+
+	case 0xA300:	/* GET_STATUS(PORT) */
+		if ((wIndex < 1) || (wIndex > Hub->Ports))
+		{
+			Supported = false;
+			break;
+		}
+		Reply[0] = Hub->Port[wIndex - 1].Status;
+		Reply[1] = Hub->Port[wIndex - 1].Status >> 8;
+		Reply[2] = Hub->Port[wIndex - 1].Change;
+		Reply[3] = Hub->Port[wIndex - 1].Change >> 8;
+		ControlReply(Hub, Reply, 4, wLength);
+		Hub->StatusRequests++;
+		break;
+
+	case 0x2303:	/* SET_FEATURE(PORT) */
+	case 0x2301:	/* CLEAR_FEATURE(PORT) */
+		Supported = PortFeature(Hub, bRequest == 0x03, wIndex, wValue);
+		break;
+
+	default:
+		Supported = false;
+		break;
+	}
+
+	if (!Supported)
+		Hub->ControlStage = CONTROL_STALLED;
+	else if (wLength && (bmRequestType & 0x80))
+		Hub->ControlStage = CONTROL_DATA_IN;
+	else if (wLength)
+		Hub->ControlStage = CONTROL_DATA_OUT;
+	else
+		Hub->ControlStage = CONTROL_STATUS_IN;
+
+	return OHCISIM_ACK;		/* SETUP is always acknowledged, errors stall the next stage */
+}
+
+/* Status change endpoint: bit n for a change on port n, NAK while nothing changed */
+static OhciSim_Handshake_t StatusIn(Hub_Device_t *Hub, uint8_t *Data, uint16_t *Length)
+{
+	uint8_t Bitmap = 0;
+	uint8_t i;
+
+	if (!Hub->Configuration)
+		return OHCISIM_NAK;
+
+	UpdatePorts(Hub);
+
+	for (i = 0; i < Hub->Ports; i++)
+	{
+		if (Hub->Port[i].Change)
+			Bitmap |= 1 << (i + 1);
+	}
+
+	if (!Bitmap)
+		return OHCISIM_NAK;
+
+	Data[0] = Bitmap;
+	*Length = 1;
+	Hub->ChangeReports++;
+	return OHCISIM_ACK;
+}
+
+static OhciSim_Handshake_t In(OhciSim_Device_t *Device, uint8_t Endpoint, uint8_t *Data, uint16_t MaxLength, uint16_t *Length)
+{
+	Hub_Device_t *Hub = (Hub_Device_t *) Device;
+	uint16_t Count;
+
+	if (Endpoint == HUB_DEVICE_STATUS_ENDPOINT)
+		return StatusIn(Hub, Data, Length);
+	if (Endpoint != 0)
+		return OHCISIM_STALL;
+
+	switch (Hub->ControlStage)
+	{
+	case CONTROL_DATA_IN:
+		Count = MIN(MaxLength, Hub->ControlLength - Hub->ControlOffset);
+		memcpy(Data, &Hub->ControlData[Hub->ControlOffset], Count);
+		Hub->ControlOffset += Count;
+		*Length = Count;
+		return OHCISIM_ACK;
+
+	case CONTROL_STATUS_IN:
+		*Length = 0;
+		Device->Address = Hub->PendingAddress;
+		Hub->ControlStage = CONTROL_IDLE;
+		return OHCISIM_ACK;
+
+	case CONTROL_STALLED:
+		return OHCISIM_STALL;
+
+	default:
+		return OHCISIM_NAK;
+	}
+}
+
+static OhciSim_Handshake_t Out(OhciSim_Device_t *Device, uint8_t Endpoint, const uint8_t *Data, uint16_t Length)
+{
+	Hub_Device_t *Hub = (Hub_Device_t *) Device;
+
+	if (Endpoint != 0)
+		return OHCISIM_STALL;
+
+	switch (Hub->ControlStage)
+	{
+	case CONTROL_DATA_IN:		/* status stage of an IN request */
+		Hub->ControlStage = CONTROL_IDLE;
+		return OHCISIM_ACK;
+
+	case CONTROL_STALLED:
+		return OHCISIM_STALL;
+
+	default:
+		return OHCISIM_ACK;
+	}
+}
+
+/* Only enabled ports pass traffic, a port in reset or disabled does not */
+static OhciSim_Device_t *Route(OhciSim_Device_t *Device, uint8_t Address)
+{
+	Hub_Device_t *Hub = (Hub_Device_t *) Device;
+	uint8_t i;
+
+	UpdatePorts(Hub);
+
+	for (i = 0; i < Hub->Ports; i++)
+	{
+		if (Hub->Port[i].Function && (Hub->Port[i].Status & PORT_ENABLE) && (Hub->Port[i].Function->Address == Address))
+			return Hub->Port[i].Function;
+	}
+
+	return NULL;
+}
+
+/* Bus reset of the hub's own upstream port: unconfigured, ports unpowered */
+static void Reset(OhciSim_Device_t *Device)
+{
+	Hub_Device_t *Hub = (Hub_Device_t *) Device;
+	uint8_t i;
+
+	Device->Address    = 0;
+	Hub->Configuration = 0;
+	Hub->ControlStage  = CONTROL_IDLE;
+
+	for (i = 0; i < Hub->Ports; i++)
+	{
+		Hub->Port[i].Status = 0;
+		Hub->Port[i].Change = 0;
+	}
+}
+
+/*==========================================================================*/
+/* Public API                                                              */
+/*==========================================================================*/
+void Hub_Device_Init(Hub_Device_t *Hub, uint8_t Ports)
+{
+	memset(Hub, 0, sizeof(Hub_Device_t));
+
+	Hub->Ports = MIN(Ports, HUB_DEVICE_PORTS);
+
+	Hub->Device.Reset = Reset;
+	Hub->Device.Setup = Setup;
+	Hub->Device.In    = In;
+	Hub->Device.Out   = Out;
+	Hub->Device.Route = Route;
+	Reset(&Hub->Device);
+}
+
+/* The frame timer runs the model from SIGALRM, keep it out while a port changes */
+static void BlockFrames(sigset_t *Saved)
+{
+	sigset_t Block;
+
+	sigemptyset(&Block);
+	sigaddset(&Block, SIGALRM);
+	sigprocmask(SIG_BLOCK, &Block, Saved);
+}
+
+void Hub_Device_Attach(Hub_Device_t *Hub, uint8_t Port, OhciSim_Device_t *Function)
+{
+	Hub_Device_Port_t *Info = &Hub->Port[Port - 1];
+	sigset_t Saved;
+
+	BlockFrames(&Saved);
+	Info->Function = Function;
+	if (Info->Status & PORT_POWER)
+	{
+		Info->Status = (Info->Status & ~PORT_LOW_SPEED) | PORT_CONNECTION | (Function->LowSpeed ? PORT_LOW_SPEED : 0);
+		Info->Change |= C_PORT_CONNECTION;
+	}
+	sigprocmask(SIG_SETMASK, &Saved, NULL);
+}
+
+void Hub_Device_Detach(Hub_Device_t *Hub, uint8_t Port)
+{
+	Hub_Device_Port_t *Info = &Hub->Port[Port - 1];
+	sigset_t Saved;
+
+	BlockFrames(&Saved);
+	Info->Function = NULL;
+	if (Info->Status & PORT_POWER)
+	{
+		Info->Status &= ~(PORT_CONNECTION | PORT_ENABLE | PORT_LOW_SPEED | PORT_RESET);
+		Info->Change |= C_PORT_CONNECTION;
+	}
+	sigprocmask(SIG_SETMASK, &Saved, NULL);
+}
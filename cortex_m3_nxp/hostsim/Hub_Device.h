@@ -0,0 +1,57 @@
+/*
+ * Hub_Device.h
+ *
+ * Virtual full speed hub for the OHCI model. Implements the standard requests
+ * needed for enumeration, the hub class requests issued by HubClassHost.c
+ * (hub descriptor, port status, port power and reset, change acknowledges)
+ * and the status change interrupt endpoint. Functions plugged into its ports
+ * are reached through the Route callback once their port is enabled.
+ */
+
+#ifndef HOSTSIM_HUB_DEVICE_H_
+#define HOSTSIM_HUB_DEVICE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "OHCI_Model.h"
+
+#define HUB_DEVICE_PORTS			4
+#define HUB_DEVICE_STATUS_ENDPOINT	1
+#define HUB_DEVICE_RESET_FRAMES		10		/* port reset signalling time */
+
+typedef struct {
+	OhciSim_Device_t *Function;		/* plugged into the port, NULL if empty */
+	uint16_t Status;				/* wPortStatus */
+	uint16_t Change;				/* wPortChange */
+	uint64_t ResetDoneFrame;
+	bool     ResetStuck;			/* the port never completes a reset */
+} Hub_Device_Port_t;
+
+typedef struct {
+	OhciSim_Device_t Device;		/* must stay first, the model hands it back to the callbacks */
+
+	/* Control endpoint */
+	uint8_t  ControlData[64];
+	uint16_t ControlLength;
+	uint16_t ControlOffset;
+	uint8_t  ControlStage;
+	uint8_t  PendingAddress;
+	uint8_t  Configuration;
+
+	uint8_t  Ports;
+	Hub_Device_Port_t Port[HUB_DEVICE_PORTS];	/* index 0 is port 1 */
+
+	/* Statistics */
+	uint64_t PortResets;
+	uint64_t StatusRequests;		/* GET_STATUS requests to a port */
+	uint64_t ChangeReports;			/* status change bitmaps sent on the interrupt endpoint */
+} Hub_Device_t;
+
+void Hub_Device_Init(Hub_Device_t *Hub, uint8_t Ports);
+
+/* Plug/unplug a function on a downstream port (1 to Ports), the hub reports the connect change */
+void Hub_Device_Attach(Hub_Device_t *Hub, uint8_t Port, OhciSim_Device_t *Function);
+void Hub_Device_Detach(Hub_Device_t *Hub, uint8_t Port);
+
+#endif /* HOSTSIM_HUB_DEVICE_H_ */
@@ -0,0 +1,240 @@
+/*
+ * Keyboard_Device.c
+ *
+ * Virtual boot protocol keyboard, see Keyboard_Device.h.
+ */
+
+#include <string.h>
+
+#include "Keyboard_Device.h"
+
+#define MIN(a, b)					(((a) < (b)) ? (a) : (b))
+
+/* Control transfer stages */
+#define CONTROL_IDLE				0
+#define CONTROL_DATA_IN				1
+#define CONTROL_DATA_OUT			2
+#define CONTROL_STATUS_IN			3
+#define CONTROL_STALLED				4
+
+#define REPORT_DESCRIPTOR_SIZE		63
+
+static const uint8_t DeviceDescriptor[] = {
+	18, 0x01, 0x10, 0x01, 0x00, 0x00, 0x00, 8,
+	0xC9, 0x1F, 0x11, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01
+};
+
+static const uint8_t ConfigurationDescriptor[] = {
+	/* Configuration */
+	9, 0x02, 34, 0, 1, 1, 0, 0xA0, 50,
+	/* Interface 0: HID, boot subclass, keyboard protocol */
+	9, 0x04, 0, 0, 1, 0x03, 0x01, 0x01, 0,
+	/* HID descriptor, one report descriptor */
+	9, 0x21, 0x11, 0x01, 0, 1, 0x22, REPORT_DESCRIPTOR_SIZE, 0,
+	7, 0x05, 0x80 | KEYBOARD_DEVICE_IN_ENDPOINT, 0x03, KEYBOARD_DEVICE_REPORT_SIZE, 0, KEYBOARD_DEVICE_INTERVAL
+};
+
+/*==========================================================================*/
+/* Interrupt endpoint                                                      */
+/*==========================================================================*/
+static OhciSim_Handshake_t ReportIn(Keyboard_Device_t *Keyboard, uint8_t *Data, uint16_t MaxLength, uint16_t *Length)
+{
+	uint32_t Tail = Keyboard->QueueTail;
+
+	if (Keyboard->Configuration == 0)
+		return OHCISIM_STALL;
+
+	Keyboard->Polls++;
+
+	if (Tail == Keyboard->QueueHead)
+		return OHCISIM_NAK;
+
+	*Length = MIN(MaxLength, KEYBOARD_DEVICE_REPORT_SIZE);
+	memcpy(Data, Keyboard->Queue[Tail % KEYBOARD_DEVICE_QUEUE_SIZE], *Length);
+	Keyboard->QueueTail = Tail + 1;
+	Keyboard->ReportsSent++;
+
+	return OHCISIM_ACK;
+}
+
+/*==========================================================================*/
+/* Control endpoint                                                        */
+/*==========================================================================*/
+static void ControlReply(Keyboard_Device_t *Keyboard, const uint8_t *Data, uint16_t Length, uint16_t wLength)
+{
+	Keyboard->ControlLength = MIN(MIN(Length, wLength), sizeof(Keyboard->ControlData));
+	memcpy(Keyboard->ControlData, Data, Keyboard->ControlLength);
+}
+
+static OhciSim_Handshake_t Setup(OhciSim_Device_t *Device, const uint8_t *Request)
+{
+	Keyboard_Device_t *Keyboard = (Keyboard_Device_t *) Device;
+	uint8_t  bmRequestType = Request[0];
+	uint8_t  bRequest = Request[1];
+	uint16_t wValue = Request[2] | (Request[3] << 8);
+	uint16_t wLength = Request[6] | (Request[7] << 8);
+	uint8_t  Reply[2] = {0, 0};
+	bool     Supported = true;
+
+	Keyboard->ControlLength = 0;
+	Keyboard->ControlOffset = 0;
+	Keyboard->PendingAddress = Device->Address;
+
+	switch ((bmRequestType << 8) | bRequest)
+	{
+	case 0x8006:	/* GET_DESCRIPTOR */
+		if ((wValue >> 8) == 0x01)
+			ControlReply(Keyboard, DeviceDescriptor, sizeof(DeviceDescriptor), wLength);
+		else if ((wValue >> 8) == 0x02)
+			ControlReply(Keyboard, ConfigurationDescriptor, sizeof(ConfigurationDescriptor), wLength);
+		else
+			Supported = false;
+		break;
+
+	case 0x0005:	/* SET_ADDRESS, takes effect after the status stage */
+		Keyboard->PendingAddress = wValue & 0x7F;
+		break;
+
+	case 0x0009:	/* SET_CONFIGURATION */
+		Keyboard->Configuration = wValue;
+		Keyboard->Protocol      = 1;
+		break;
+
+	case 0x8008:	/* GET_CONFIGURATION */
+		Reply[0] = Keyboard->Configuration;
+		ControlReply(Keyboard, Reply, 1, wLength);
+		break;
+
+	case 0x8000:	/* GET_STATUS */
+	case 0x8100:
+	case 0x8200:
+		ControlReply(Keyboard, Reply, 2, wLength);
+		break;
+
+	case 0x0201:	/* CLEAR_FEATURE(ENDPOINT_HALT), endpoints never halt */
+		break;
+
+	case 0x210A:	/* SET_IDLE */
+		break;
+
+	case 0x210B:	/* SET_PROTOCOL */
+		Keyboard->Protocol = wValue;
+		break;
+
+	default:
+		Supported = false;
+		break;
+	}
+
+	if (!Supported)
+		Keyboard->ControlStage = CONTROL_STALLED;
+	else if (wLength && (bmRequestType & 0x80))
+		Keyboard->ControlStage = CONTROL_DATA_IN;
+	else if (wLength)
+		Keyboard->ControlStage = CONTROL_DATA_OUT;
+	else
+		Keyboard->ControlStage = CONTROL_STATUS_IN;
+
+	return OHCISIM_ACK;		/* SETUP is always acknowledged, errors stall the next stage */
+}
+
+static OhciSim_Handshake_t In(OhciSim_Device_t *Device, uint8_t Endpoint, uint8_t *Data, uint16_t MaxLength, uint16_t *Length)
+{
+	Keyboard_Device_t *Keyboard = (Keyboard_Device_t *) Device;
+	uint16_t Count;
+
+	if (Endpoint == KEYBOARD_DEVICE_IN_ENDPOINT)
+		return ReportIn(Keyboard, Data, MaxLength, Length);
+	if (Endpoint != 0)
+		return OHCISIM_STALL;
+
+	switch (Keyboard->ControlStage)
+	{
+	case CONTROL_DATA_IN:
+		Count = MIN(MaxLength, Keyboard->ControlLength - Keyboard->ControlOffset);
+		memcpy(Data, &Keyboard->ControlData[Keyboard->ControlOffset], Count);
+		Keyboard->ControlOffset += Count;
+		*Length = Count;
+		return OHCISIM_ACK;
+
+	case CONTROL_STATUS_IN:
+	case CONTROL_DATA_OUT:		/* status stage of an OUT request */
+		*Length = 0;
+		Device->Address = Keyboard->PendingAddress;
+		Keyboard->ControlStage = CONTROL_IDLE;
+		return OHCISIM_ACK;
+
+	case CONTROL_STALLED:
+		return OHCISIM_STALL;
+
+	default:
+		return OHCISIM_NAK;
+	}
+}
+
+static OhciSim_Handshake_t Out(OhciSim_Device_t *Device, uint8_t Endpoint, const uint8_t *Data, uint16_t Length)
+{
+	Keyboard_Device_t *Keyboard = (Keyboard_Device_t *) Device;
+
+	if (Endpoint != 0)
+		return OHCISIM_STALL;
+
+	switch (Keyboard->ControlStage)
+	{
+	case CONTROL_DATA_IN:		/* status stage of an IN request */
+		Keyboard->ControlStage = CONTROL_IDLE;
+		return OHCISIM_ACK;
+
+	case CONTROL_STALLED:
+		return OHCISIM_STALL;
+
+	default:
+		return OHCISIM_ACK;
+	}
+}
+
+static void Reset(OhciSim_Device_t *Device)
+{
+	Keyboard_Device_t *Keyboard = (Keyboard_Device_t *) Device;
+
+	Device->Address         = 0;
+	Keyboard->Configuration = 0;
+	Keyboard->ControlStage  = CONTROL_IDLE;
+}
+
+/*==========================================================================*/
+/* Public API                                                              */
+/*==========================================================================*/
+void Keyboard_Device_Init(Keyboard_Device_t *Keyboard)
+{
+	memset(Keyboard, 0, sizeof(Keyboard_Device_t));
+
+	Keyboard->Device.LowSpeed = true;
+	Keyboard->Device.Reset    = Reset;
+	Keyboard->Device.Setup    = Setup;
+	Keyboard->Device.In       = In;
+	Keyboard->Device.Out      = Out;
+	Reset(&Keyboard->Device);
+}
+
+bool Keyboard_Device_QueueReport(Keyboard_Device_t *Keyboard, uint8_t Modifier, const uint8_t *KeyCodes, uint8_t KeyCount)
+{
+	uint32_t Head = Keyboard->QueueHead;
+	uint8_t *Report = Keyboard->Queue[Head % KEYBOARD_DEVICE_QUEUE_SIZE];
+
+	if ((Head - Keyboard->QueueTail) >= KEYBOARD_DEVICE_QUEUE_SIZE)
+		return false;
+
+	memset(Report, 0, KEYBOARD_DEVICE_REPORT_SIZE);
+	Report[0] = Modifier;
+	if (KeyCount)
+		memcpy(&Report[2], KeyCodes, MIN(KeyCount, 6));
+	Keyboard->QueueHead = Head + 1;
+
+	return true;
+}
+
+uint32_t Keyboard_Device_Pending(const Keyboard_Device_t *Keyboard)
+{
+	return Keyboard->QueueHead - Keyboard->QueueTail;
+}
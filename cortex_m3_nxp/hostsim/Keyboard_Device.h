@@ -0,0 +1,54 @@
+/*
+ * Keyboard_Device.h
+ *
+ * Virtual low speed boot protocol keyboard for the OHCI model. Reports queued
+ * by the bench are sent one per poll of the interrupt IN endpoint, which NAKs
+ * while the queue is empty, as a keyboard does while no key changes. Every
+ * poll and every report taken by the host is counted, so a host that keeps
+ * polling a pipe it no longer reads, or loses reports, shows up here.
+ */
+
+#ifndef HOSTSIM_KEYBOARD_DEVICE_H_
+#define HOSTSIM_KEYBOARD_DEVICE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "OHCI_Model.h"
+
+#define KEYBOARD_DEVICE_REPORT_SIZE		8
+#define KEYBOARD_DEVICE_IN_ENDPOINT		1
+#define KEYBOARD_DEVICE_INTERVAL		10		/* bInterval of the IN endpoint, frames */
+#define KEYBOARD_DEVICE_QUEUE_SIZE		256
+
+typedef struct {
+	OhciSim_Device_t Device;		/* must stay first, the model hands it back to the callbacks */
+
+	/* Control endpoint */
+	uint8_t  ControlData[64];
+	uint16_t ControlLength;
+	uint16_t ControlOffset;
+	uint8_t  ControlStage;
+	uint8_t  PendingAddress;
+	uint8_t  Configuration;
+	uint8_t  Protocol;				/* 0 boot, 1 report */
+
+	/* Reports, queued by the bench (head) and sent from the frame handler (tail) */
+	uint8_t  Queue[KEYBOARD_DEVICE_QUEUE_SIZE][KEYBOARD_DEVICE_REPORT_SIZE];
+	volatile uint32_t QueueHead;
+	volatile uint32_t QueueTail;
+
+	/* Statistics */
+	volatile uint64_t Polls;		/* IN transactions on the interrupt endpoint */
+	volatile uint64_t ReportsSent;
+} Keyboard_Device_t;
+
+void Keyboard_Device_Init(Keyboard_Device_t *Keyboard);
+
+/* Queues a boot report, false if the queue is full */
+bool Keyboard_Device_QueueReport(Keyboard_Device_t *Keyboard, uint8_t Modifier, const uint8_t *KeyCodes, uint8_t KeyCount);
+
+/* Reports queued but not yet taken by the host */
+uint32_t Keyboard_Device_Pending(const Keyboard_Device_t *Keyboard);
+
+#endif /* HOSTSIM_KEYBOARD_DEVICE_H_ */
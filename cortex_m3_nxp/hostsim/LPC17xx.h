@@ -0,0 +1,78 @@
+/*
+ * LPC17xx.h
+ *
+ * Host simulation shim for the CMSIS device header. Everything comes from the
+ * real header except LPC_USB, which is redirected to the register page of the
+ * OHCI model (see OHCI_Model.h) so the unmodified host stack drives the model,
+ * or of the device controller model (see DCD_Model.h) in device only builds.
+ * The UARTs and the GPDMA controller go to the UART model (see UART_Model.h),
+ * LPC_SC and LPC_PINCON to plain memory, and the NVIC enables of their
+ * interrupts to the model too. __get_IPSR() tells whether a simulated
+ * interrupt handler is running.
+ */
+
+#ifndef HOSTSIM_LPC17XX_H_
+#define HOSTSIM_LPC17XX_H_
+
+#include_next "LPC17xx.h"
+
+#undef LPC_USB
+
+#if defined(USB_DEVICE_ONLY)
+extern LPC_USB_TypeDef *DcdSim_Registers;
+#define LPC_USB		(DcdSim_Registers)
+#else
+extern LPC_USB_TypeDef *OhciSim_Registers;
+#define LPC_USB		(OhciSim_Registers)
+#endif
+
+#undef LPC_SC
+#undef LPC_PINCON
+#undef LPC_UART0
+#undef LPC_UART1
+#undef LPC_UART2
+#undef LPC_UART3
+#undef LPC_GPDMA
+#undef LPC_GPDMACH0
+#undef LPC_GPDMACH1
+#undef LPC_GPDMACH2
+#undef LPC_GPDMACH3
+#undef LPC_GPDMACH4
+#undef LPC_GPDMACH5
+#undef LPC_GPDMACH6
+#undef LPC_GPDMACH7
+
+extern LPC_SC_TypeDef      UartSim_SC;
+extern LPC_PINCON_TypeDef  UartSim_PINCON;
+extern LPC_UART_TypeDef   *UartSim_Ports[4];
+extern LPC_GPDMA_TypeDef  *UartSim_Gpdma;
+
+#define LPC_SC			(&UartSim_SC)
+#define LPC_PINCON		(&UartSim_PINCON)
+#define LPC_UART0		((LPC_UART0_TypeDef *) UartSim_Ports[0])
+#define LPC_UART1		((LPC_UART1_TypeDef *) UartSim_Ports[1])
+#define LPC_UART2		(UartSim_Ports[2])
+#define LPC_UART3		(UartSim_Ports[3])
+#define LPC_GPDMA		(UartSim_Gpdma)
+#define LPC_GPDMACH(n)	((LPC_GPDMACH_TypeDef *) ((uint8_t *) UartSim_Gpdma + 0x100 + (0x20 * (n))))
+#define LPC_GPDMACH0	LPC_GPDMACH(0)
+#define LPC_GPDMACH1	LPC_GPDMACH(1)
+#define LPC_GPDMACH2	LPC_GPDMACH(2)
+#define LPC_GPDMACH3	LPC_GPDMACH(3)
+#define LPC_GPDMACH4	LPC_GPDMACH(4)
+#define LPC_GPDMACH5	LPC_GPDMACH(5)
+#define LPC_GPDMACH6	LPC_GPDMACH(6)
+#define LPC_GPDMACH7	LPC_GPDMACH(7)
+
+void NvicSim_EnableIRQ(IRQn_Type IRQn);
+void NvicSim_DisableIRQ(IRQn_Type IRQn);
+
+#define NVIC_EnableIRQ(IRQn)	NvicSim_EnableIRQ(IRQn)
+#define NVIC_DisableIRQ(IRQn)	NvicSim_DisableIRQ(IRQn)
+
+/* Exception number of the running handler, for the builds that sleep in FreeRTOS (kbd_bench.c) */
+uint32_t NvicSim_GetIPSR(void);
+
+#define __get_IPSR()			NvicSim_GetIPSR()
+
+#endif /* HOSTSIM_LPC17XX_H_ */
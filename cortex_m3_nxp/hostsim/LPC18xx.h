@@ -0,0 +1,88 @@
+/*
+ * LPC18xx.h
+ *
+ * Host simulation stand-in for the LPC18xx CMSIS device header, which is not
+ * part of this tree. Only what the EHCI host driver needs is declared: the
+ * USB0 register block, laid out as on the silicon, and the core access
+ * qualifiers. LPC_USB0 and LPC_USB1 both lead to the register page of the
+ * EHCI model (see EHCI_Model.h) so the unmodified EHCI.c drives the model.
+ */
+
+#ifndef HOSTSIM_LPC18XX_H_
+#define HOSTSIM_LPC18XX_H_
+
+#include <stdint.h>
+
+#define __I		volatile const
+#define __O		volatile
+#define __IO	volatile
+
+#ifndef __INLINE
+#define __INLINE	inline
+#endif
+
+typedef struct {
+	__I  uint32_t RESERVED0[64];
+	__I  uint32_t CAPLENGTH;				/* 0x100 */
+	__I  uint32_t HCSPARAMS;
+	__I  uint32_t HCCPARAMS;
+	__I  uint32_t RESERVED1[5];
+	__I  uint32_t DCIVERSION;				/* 0x120 */
+	__I  uint32_t RESERVED2[7];
+	union {
+		__IO uint32_t USBCMD_H;				/* 0x140 */
+		__IO uint32_t USBCMD_D;
+	};
+	union {
+		__IO uint32_t USBSTS_H;				/* 0x144 */
+		__IO uint32_t USBSTS_D;
+	};
+	union {
+		__IO uint32_t USBINTR_H;			/* 0x148 */
+		__IO uint32_t USBINTR_D;
+	};
+	union {
+		__IO uint32_t FRINDEX_H;			/* 0x14C */
+		__I  uint32_t FRINDEX_D;
+	};
+	__I  uint32_t RESERVED3;
+	union {
+		__IO uint32_t PERIODICLISTBASE;		/* 0x154 */
+		__IO uint32_t DEVICEADDR;
+	};
+	union {
+		__IO uint32_t ASYNCLISTADDR;		/* 0x158 */
+		__IO uint32_t ENDPOINTLISTADDR;
+	};
+	__IO uint32_t TTCTRL;					/* 0x15C */
+	__IO uint32_t BURSTSIZE;				/* 0x160 */
+	__IO uint32_t TXFILLTUNING;				/* 0x164 */
+	__I  uint32_t RESERVED4[3];
+	__IO uint32_t BINTERVAL;				/* 0x174 */
+	__IO uint32_t ENDPTNAK;					/* 0x178 */
+	__IO uint32_t ENDPTNAKEN;				/* 0x17C */
+	__I  uint32_t RESERVED5;
+	union {
+		__IO uint32_t PORTSC1_H;			/* 0x184 */
+		__IO uint32_t PORTSC1_D;
+	};
+	__I  uint32_t RESERVED6[7];
+	__IO uint32_t OTGSC;					/* 0x1A4 */
+	union {
+		__IO uint32_t USBMODE_H;			/* 0x1A8 */
+		__IO uint32_t USBMODE_D;
+	};
+	__IO uint32_t ENDPTSETUPSTAT;			/* 0x1AC */
+	__IO uint32_t ENDPTPRIME;				/* 0x1B0 */
+	__IO uint32_t ENDPTFLUSH;				/* 0x1B4 */
+	__I  uint32_t ENDPTSTAT;				/* 0x1B8 */
+	__IO uint32_t ENDPTCOMPLETE;			/* 0x1BC */
+	__IO uint32_t ENDPTCTRL[6];				/* 0x1C0 */
+} LPC_USB0_Type;
+
+extern LPC_USB0_Type *EhciSim_Registers;
+
+#define LPC_USB0		(EhciSim_Registers)
+#define LPC_USB1_BASE	((uintptr_t) EhciSim_Registers)
+
+#endif /* HOSTSIM_LPC18XX_H_ */
@@ -0,0 +1,469 @@
+/*
+ * MSC_Device.c
+ *
+ * Virtual Bulk-Only Transport mass storage device, see MSC_Device.h.
+ */
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "MSC_Device.h"
+
+#define MIN(a, b)					(((a) < (b)) ? (a) : (b))
+
+/* Control transfer stages */
+#define CONTROL_IDLE				0
+#define CONTROL_DATA_IN				1
+#define CONTROL_DATA_OUT			2
+#define CONTROL_STATUS_IN			3
+#define CONTROL_STALLED				4
+
+/* Bulk-Only Transport stages */
+#define BOT_CBW						0
+#define BOT_DATA_IN					1
+#define BOT_DATA_OUT				2
+#define BOT_CSW						3
+
+#define BOT_CBW_SIGNATURE			0x43425355UL	/* "USBC" */
+#define BOT_CSW_SIGNATURE			0x53425355UL	/* "USBS" */
+#define BOT_CBW_LENGTH				31
+#define BOT_CSW_LENGTH				13
+
+#define SCSI_TEST_UNIT_READY		0x00
+#define SCSI_REQUEST_SENSE			0x03
+#define SCSI_INQUIRY				0x12
+#define SCSI_MODE_SENSE_6			0x1A
+#define SCSI_START_STOP_UNIT		0x1B
+#define SCSI_PREVENT_ALLOW_REMOVAL	0x1E
+#define SCSI_READ_CAPACITY_10		0x25
+#define SCSI_READ_10				0x28
+#define SCSI_WRITE_10				0x2A
+#define SCSI_VERIFY_10				0x2F
+#define SCSI_SYNCHRONIZE_CACHE		0x35
+
+#define SENSE_ILLEGAL_REQUEST		0x05
+#define ASC_INVALID_COMMAND			0x20
+#define ASC_LBA_OUT_OF_RANGE		0x21
+
+static const uint8_t DeviceDescriptor[] = {
+	18, 0x01, 0x10, 0x01, 0x00, 0x00, 0x00, MSC_DEVICE_PACKET_SIZE,
+	0xC9, 0x1F, 0x0C, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01
+};
+
+static const uint8_t ConfigurationDescriptor[] = {
+	/* Configuration */
+	9, 0x02, 32, 0, 1, 1, 0, 0x80, 50,
+	/* Interface: Mass Storage, SCSI transparent, Bulk-Only */
+	9, 0x04, 0, 0, 2, 0x08, 0x06, 0x50, 0,
+	/* Bulk IN */
+	7, 0x05, 0x80 | MSC_DEVICE_IN_ENDPOINT, 0x02, MSC_DEVICE_PACKET_SIZE, 0, 0,
+	/* Bulk OUT */
+	7, 0x05, MSC_DEVICE_OUT_ENDPOINT, 0x02, MSC_DEVICE_PACKET_SIZE, 0, 0
+};
+
+static uint32_t GetLE32(const uint8_t *Data)
+{
+	return Data[0] | (Data[1] << 8) | (Data[2] << 16) | ((uint32_t) Data[3] << 24);
+}
+
+static uint32_t GetBE32(const uint8_t *Data)
+{
+	return ((uint32_t) Data[0] << 24) | (Data[1] << 16) | (Data[2] << 8) | Data[3];
+}
+
+static void PutLE32(uint8_t *Data, uint32_t Value)
+{
+	Data[0] = Value;
+	Data[1] = Value >> 8;
+	Data[2] = Value >> 16;
+	Data[3] = Value >> 24;
+}
+
+static void PutBE32(uint8_t *Data, uint32_t Value)
+{
+	Data[0] = Value >> 24;
+	Data[1] = Value >> 16;
+	Data[2] = Value >> 8;
+	Data[3] = Value;
+}
+
+static void Fail(MSC_Device_t *Disk, uint8_t SenseKey, uint8_t SenseCode)
+{
+	Disk->Status    = 1;
+	Disk->SenseKey  = SenseKey;
+	Disk->SenseCode = SenseCode;
+}
+
+/*==========================================================================*/
+/* SCSI command set                                                        */
+/*==========================================================================*/
+static void ExecuteCommand(MSC_Device_t *Disk, const uint8_t *Cbw)
+{
+	const uint8_t *Cdb = &Cbw[15];
+	uint32_t Length = 0;
+	uint32_t Blocks;
+
+	Disk->Tag           = GetLE32(&Cbw[4]);
+	Disk->DataRemaining = GetLE32(&Cbw[8]);
+	Disk->Status        = 0;
+	Disk->MediaTransfer = false;
+	Disk->BufferOffset  = 0;
+	Disk->ReadyFrame    = 0;
+	memset(Disk->Buffer, 0, sizeof(Disk->Buffer));
+	Disk->Commands++;
+
+	switch (Cdb[0])
+	{
+	case SCSI_TEST_UNIT_READY:
+	case SCSI_START_STOP_UNIT:
+	case SCSI_PREVENT_ALLOW_REMOVAL:
+	case SCSI_VERIFY_10:
+	case SCSI_SYNCHRONIZE_CACHE:
+		break;
+
+	case SCSI_REQUEST_SENSE:
+		Disk->Buffer[0]  = 0x70;				/* current error, fixed format */
+		Disk->Buffer[2]  = Disk->SenseKey;
+		Disk->Buffer[7]  = 10;
+		Disk->Buffer[12] = Disk->SenseCode;
+		Disk->SenseKey   = Disk->SenseCode = 0;
+		Length = 18;
+		break;
+
+	case SCSI_INQUIRY:
+		Disk->Buffer[1] = 0x80;					/* removable medium */
+		Disk->Buffer[2] = 0x02;
+		Disk->Buffer[3] = 0x02;
+		Disk->Buffer[4] = 31;
+		memcpy(&Disk->Buffer[8], "LPCSIM  Virtual BOT Disk1.00", 28);
+		Length = 36;
+		break;
+
+	case SCSI_MODE_SENSE_6:
+		Disk->Buffer[0] = 3;
+		Length = 4;
+		break;
+
+	case SCSI_READ_CAPACITY_10:
+		PutBE32(&Disk->Buffer[0], Disk->Blocks - 1);
+		PutBE32(&Disk->Buffer[4], MSC_DEVICE_BLOCK_SIZE);
+		Length = 8;
+		break;
+
+	case SCSI_READ_10:
+	case SCSI_WRITE_10:
+		Disk->Lba = GetBE32(&Cdb[2]);
+		Blocks    = (Cdb[7] << 8) | Cdb[8];
+		if (((uint64_t) Disk->Lba + Blocks) > Disk->Blocks)
+		{
+			Fail(Disk, SENSE_ILLEGAL_REQUEST, ASC_LBA_OUT_OF_RANGE);
+			break;
+		}
+		Disk->MediaTransfer = true;
+		Disk->BufferLength  = (Cdb[0] == SCSI_READ_10) ? 0 : MSC_DEVICE_BLOCK_SIZE;
+		Disk->ReadyFrame    = OhciSim_GetFrameNumber() + Disk->AccessLatency;
+		Length = Blocks * MSC_DEVICE_BLOCK_SIZE;
+		break;
+
+	default:
+		Fail(Disk, SENSE_ILLEGAL_REQUEST, ASC_INVALID_COMMAND);
+		break;
+	}
+
+	/* Short responses are padded with zeros up to the length the host asked for */
+	Disk->Residue = (Disk->DataRemaining > Length) ? (Disk->DataRemaining - Length) : 0;
+	if (!Disk->MediaTransfer)
+		Disk->BufferLength = MIN(Disk->DataRemaining, sizeof(Disk->Buffer));
+
+	if (Disk->DataRemaining == 0)
+		Disk->Stage = BOT_CSW;
+	else
+		Disk->Stage = (Cbw[12] & 0x80) ? BOT_DATA_IN : BOT_DATA_OUT;
+}
+
+static OhciSim_Handshake_t BulkIn(MSC_Device_t *Disk, uint8_t *Data, uint16_t MaxLength, uint16_t *Length)
+{
+	uint16_t Count;
+
+	if (OhciSim_GetFrameNumber() < Disk->ReadyFrame)	/* medium still busy */
+		return OHCISIM_NAK;
+
+	if (Disk->Stage == BOT_CSW)
+	{
+		PutLE32(&Data[0], BOT_CSW_SIGNATURE);
+		PutLE32(&Data[4], Disk->Tag);
+		PutLE32(&Data[8], Disk->Residue);
+		Data[12] = Disk->Status;
+		*Length = BOT_CSW_LENGTH;
+		Disk->Stage = BOT_CBW;
+		return OHCISIM_ACK;
+	}
+
+	if (Disk->Stage != BOT_DATA_IN)
+		return OHCISIM_NAK;
+
+	if (Disk->BufferOffset == Disk->BufferLength)
+	{
+		if (Disk->MediaTransfer)
+		{
+			if (pread(Disk->ImageFd, Disk->Buffer, MSC_DEVICE_BLOCK_SIZE, (off_t) Disk->Lba * MSC_DEVICE_BLOCK_SIZE) != MSC_DEVICE_BLOCK_SIZE)
+				memset(Disk->Buffer, 0, MSC_DEVICE_BLOCK_SIZE);
+			Disk->Lba++;
+			Disk->BlocksRead++;
+		}
+		else
+		{
+			memset(Disk->Buffer, 0, sizeof(Disk->Buffer));
+		}
+		Disk->BufferLength = MIN(Disk->DataRemaining, sizeof(Disk->Buffer));
+		Disk->BufferOffset = 0;
+	}
+
+	Count = MIN(MaxLength, Disk->BufferLength - Disk->BufferOffset);
+	memcpy(Data, &Disk->Buffer[Disk->BufferOffset], Count);
+	Disk->BufferOffset  += Count;
+	Disk->DataRemaining -= Count;
+	*Length = Count;
+
+	if (Disk->DataRemaining == 0)
+		Disk->Stage = BOT_CSW;
+	return OHCISIM_ACK;
+}
+
+static OhciSim_Handshake_t BulkOut(MSC_Device_t *Disk, const uint8_t *Data, uint16_t Length)
+{
+	uint16_t Count;
+
+	if (Disk->Stage == BOT_CBW)
+	{
+		if ((Length == BOT_CBW_LENGTH) && (GetLE32(Data) == BOT_CBW_SIGNATURE))
+			ExecuteCommand(Disk, Data);
+		return OHCISIM_ACK;
+	}
+
+	if (Disk->Stage != BOT_DATA_OUT)
+		return OHCISIM_NAK;
+
+	while (Length)
+	{
+		Count = MIN(Length, Disk->BufferLength - Disk->BufferOffset);
+		memcpy(&Disk->Buffer[Disk->BufferOffset], Data, Count);
+		Disk->BufferOffset  += Count;
+		Disk->DataRemaining -= MIN(Count, Disk->DataRemaining);
+		Data   += Count;
+		Length -= Count;
+
+		if (Disk->BufferOffset == Disk->BufferLength)
+		{
+			if (Disk->MediaTransfer)
+			{
+				if (pwrite(Disk->ImageFd, Disk->Buffer, MSC_DEVICE_BLOCK_SIZE, (off_t) Disk->Lba * MSC_DEVICE_BLOCK_SIZE) != MSC_DEVICE_BLOCK_SIZE)
+					Fail(Disk, 0x03, 0x0C);		/* MEDIUM ERROR, WRITE ERROR */
+				Disk->Lba++;
+				Disk->BlocksWritten++;
+			}
+			Disk->BufferOffset = 0;
+		}
+	}
+
+	if (Disk->DataRemaining == 0)
+	{
+		Disk->Stage = BOT_CSW;
+		if (Disk->MediaTransfer)
+			Disk->ReadyFrame = OhciSim_GetFrameNumber() + Disk->AccessLatency;
+	}
+	return OHCISIM_ACK;
+}
+
+/*==========================================================================*/
+/* Control endpoint                                                        */
+/*==========================================================================*/
+static void ControlReply(MSC_Device_t *Disk, const uint8_t *Data, uint16_t Length, uint16_t wLength)
+{
+	Disk->ControlLength = MIN(MIN(Length, wLength), sizeof(Disk->ControlData));
+	memcpy(Disk->ControlData, Data, Disk->ControlLength);
+}
+
+static OhciSim_Handshake_t Setup(OhciSim_Device_t *Device, const uint8_t *Request)
+{
+	MSC_Device_t *Disk = (MSC_Device_t *) Device;
+	uint8_t  bmRequestType = Request[0];
+	uint8_t  bRequest = Request[1];
+	uint16_t wValue = Request[2] | (Request[3] << 8);
+	uint16_t wLength = Request[6] | (Request[7] << 8);
+	uint8_t  Reply[2] = {0, 0};
+	bool     Supported = true;
+
+	Disk->ControlLength = 0;
+	Disk->ControlOffset = 0;
+	Disk->PendingAddress = Device->Address;
+
+	switch ((bmRequestType << 8) | bRequest)
+	{
+	case 0x8006:	/* GET_DESCRIPTOR */
+		if ((wValue >> 8) == 0x01)
+			ControlReply(Disk, DeviceDescriptor, sizeof(DeviceDescriptor), wLength);
+		else if ((wValue >> 8) == 0x02)
+			ControlReply(Disk, ConfigurationDescriptor, sizeof(ConfigurationDescriptor), wLength);
+		else
+			Supported = false;
+		break;
+
+	case 0x0005:	/* SET_ADDRESS, takes effect after the status stage */
+		Disk->PendingAddress = wValue & 0x7F;
+		break;
+
+	case 0x0009:	/* SET_CONFIGURATION */
+		Disk->Configuration = wValue;
+		break;
+
+	case 0x8008:	/* GET_CONFIGURATION */
+		Reply[0] = Disk->Configuration;
+		ControlReply(Disk, Reply, 1, wLength);
+		break;
+
+	case 0x8000:	/* GET_STATUS */
+	case 0x8100:
+	case 0x8200:
+		ControlReply(Disk, Reply, 2, wLength);
+		break;
+
+	case 0x0201:	/* CLEAR_FEATURE(ENDPOINT_HALT), endpoints never halt */
+	case 0x010B:	/* SET_INTERFACE */
+		break;
+
+	case 0xA1FE:	/* GET MAX LUN */
+		ControlReply(Disk, Reply, 1, wLength);
+		break;
+
+	case 0x21FF:	/* Bulk-Only Mass Storage Reset */
+		Disk->Stage = BOT_CBW;
+		break;
+
+	default:
+		Supported = false;
+		break;
+	}
+
+	if (!Supported)
+		Disk->ControlStage = CONTROL_STALLED;
+	else if (wLength && (bmRequestType & 0x80))
+		Disk->ControlStage = CONTROL_DATA_IN;
+	else if (wLength)
+		Disk->ControlStage = CONTROL_DATA_OUT;
+	else
+		Disk->ControlStage = CONTROL_STATUS_IN;
+
+	return OHCISIM_ACK;		/* SETUP is always acknowledged, errors stall the next stage */
+}
+
+static OhciSim_Handshake_t In(OhciSim_Device_t *Device, uint8_t Endpoint, uint8_t *Data, uint16_t MaxLength, uint16_t *Length)
+{
+	MSC_Device_t *Disk = (MSC_Device_t *) Device;
+	uint16_t Count;
+
+	if (Endpoint == MSC_DEVICE_IN_ENDPOINT)
+		return BulkIn(Disk, Data, MaxLength, Length);
+	if (Endpoint != 0)
+		return OHCISIM_STALL;
+
+	switch (Disk->ControlStage)
+	{
+	case CONTROL_DATA_IN:
+		Count = MIN(MaxLength, Disk->ControlLength - Disk->ControlOffset);
+		memcpy(Data, &Disk->ControlData[Disk->ControlOffset], Count);
+		Disk->ControlOffset += Count;
+		*Length = Count;
+		return OHCISIM_ACK;
+
+	case CONTROL_STATUS_IN:
+		*Length = 0;
+		Device->Address = Disk->PendingAddress;
+		Disk->ControlStage = CONTROL_IDLE;
+		return OHCISIM_ACK;
+
+	case CONTROL_STALLED:
+		return OHCISIM_STALL;
+
+	default:
+		return OHCISIM_NAK;
+	}
+}
+
+static OhciSim_Handshake_t Out(OhciSim_Device_t *Device, uint8_t Endpoint, const uint8_t *Data, uint16_t Length)
+{
+	MSC_Device_t *Disk = (MSC_Device_t *) Device;
+
+	if (Endpoint == MSC_DEVICE_OUT_ENDPOINT)
+		return BulkOut(Disk, Data, Length);
+	if (Endpoint != 0)
+		return OHCISIM_STALL;
+
+	switch (Disk->ControlStage)
+	{
+	case CONTROL_DATA_IN:		/* status stage of an IN request */
+		Disk->ControlStage = CONTROL_IDLE;
+		return OHCISIM_ACK;
+
+	case CONTROL_DATA_OUT:		/* no supported request carries OUT data, accept and drop it */
+		return OHCISIM_ACK;
+
+	case CONTROL_STALLED:
+		return OHCISIM_STALL;
+
+	default:
+		return OHCISIM_ACK;
+	}
+}
+
+static void Reset(OhciSim_Device_t *Device)
+{
+	MSC_Device_t *Disk = (MSC_Device_t *) Device;
+
+	Device->Address     = 0;
+	Disk->Configuration = 0;
+	Disk->ControlStage  = CONTROL_IDLE;
+	Disk->Stage         = BOT_CBW;
+	Disk->ReadyFrame    = 0;
+}
+
+/*==========================================================================*/
+/* Public API                                                              */
+/*==========================================================================*/
+bool MSC_Device_Init(MSC_Device_t *Disk, const char *ImagePath, uint32_t SizeMB, uint32_t AccessLatency)
+{
+	struct stat Info;
+
+	memset(Disk, 0, sizeof(MSC_Device_t));
+
+	Disk->ImageFd = open(ImagePath, O_RDWR | O_CREAT, 0644);
+	if (Disk->ImageFd < 0)
+		return false;
+
+	if ((fstat(Disk->ImageFd, &Info) != 0) ||
+		((Info.st_size < (off_t) SizeMB << 20) && (ftruncate(Disk->ImageFd, (off_t) SizeMB << 20) != 0)) ||
+		(fstat(Disk->ImageFd, &Info) != 0))
+	{
+		close(Disk->ImageFd);
+		return false;
+	}
+
+	Disk->Blocks        = Info.st_size / MSC_DEVICE_BLOCK_SIZE;
+	Disk->AccessLatency = AccessLatency;
+
+	Disk->Device.Reset = Reset;
+	Disk->Device.Setup = Setup;
+	Disk->Device.In    = In;
+	Disk->Device.Out   = Out;
+	Reset(&Disk->Device);
+
+	return Disk->Blocks != 0;
+}
+
+void MSC_Device_Close(MSC_Device_t *Disk)
+{
+	close(Disk->ImageFd);
+}
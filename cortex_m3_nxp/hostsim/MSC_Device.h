@@ -0,0 +1,63 @@
+/*
+ * MSC_Device.h
+ *
+ * Virtual full speed Bulk-Only Transport mass storage device for the OHCI
+ * model, backed by a disk image file. Implements the standard requests needed
+ * for enumeration, GET MAX LUN, BOT reset and the SCSI commands issued by
+ * MassStorageClassHost.c.
+ */
+
+#ifndef HOSTSIM_MSC_DEVICE_H_
+#define HOSTSIM_MSC_DEVICE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "OHCI_Model.h"
+
+#define MSC_DEVICE_BLOCK_SIZE		512
+#define MSC_DEVICE_PACKET_SIZE		64
+#define MSC_DEVICE_IN_ENDPOINT		1
+#define MSC_DEVICE_OUT_ENDPOINT		2
+
+typedef struct {
+	OhciSim_Device_t Device;		/* must stay first, the model hands it back to the callbacks */
+
+	int      ImageFd;
+	uint32_t Blocks;
+	uint32_t AccessLatency;			/* frames the medium needs before a READ/WRITE completes */
+
+	/* Control endpoint */
+	uint8_t  ControlData[64];
+	uint16_t ControlLength;
+	uint16_t ControlOffset;
+	uint8_t  ControlStage;
+	uint8_t  PendingAddress;
+	uint8_t  Configuration;
+
+	/* Bulk-Only Transport */
+	uint8_t  Stage;
+	uint32_t Tag;
+	uint32_t DataRemaining;			/* bytes left in the data stage announced by the CBW */
+	uint32_t Residue;
+	uint8_t  Status;
+	uint8_t  SenseKey;
+	uint8_t  SenseCode;
+	uint64_t ReadyFrame;
+	uint32_t Lba;
+	uint8_t  Buffer[MSC_DEVICE_BLOCK_SIZE];
+	uint16_t BufferLength;
+	uint16_t BufferOffset;
+	bool     MediaTransfer;			/* data stage is READ/WRITE to the image, not Buffer */
+
+	/* Statistics */
+	uint64_t Commands;
+	uint64_t BlocksRead;
+	uint64_t BlocksWritten;
+} MSC_Device_t;
+
+/* Opens (or creates with SizeMB megabytes) the image file and resets the device */
+bool MSC_Device_Init(MSC_Device_t *Disk, const char *ImagePath, uint32_t SizeMB, uint32_t AccessLatency);
+void MSC_Device_Close(MSC_Device_t *Disk);
+
+#endif /* HOSTSIM_MSC_DEVICE_H_ */
@@ -0,0 +1,826 @@
+/*
+ * OHCI_Model.c
+ *
+ * Register, root hub and list processing model of the LPC17xx OHCI host
+ * controller, see OHCI_Model.h.
+ */
+
+#define _GNU_SOURCE
+#include <signal.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <x86intrin.h>
+
+#define  __INCLUDE_FROM_USB_DRIVER
+#include "Core/USBMode.h"
+
+/* The model shares the ED/TD/HCCA layouts with the driver */
+#define __LPC_OHCI_C__
+#include "Core/LPC/HCD/HCD.h"
+#include "Core/LPC/HCD/OHCI/OHCI.h"
+
+#include "OHCI_Model.h"
+
+#define REGISTER_PAGE_SIZE			4096
+#define REG(member)					RegisterFile[offsetof(LPC_USB_TypeDef, member) / 4]
+#define OFFSET(member)				offsetof(LPC_USB_TypeDef, member)
+
+#define X86_EFLAGS_TF				0x100
+#define X86_PF_WRITE				0x2
+
+#define HC_REVISION_1_0				0x10
+#define HC_RH_DESCRIPTORA_RESET		(0x02000000UL | HC_RH_DESCRIPTORA_NoOverCurrentProtection | HC_RH_DESCRIPTORA_NoPowerSwitching | 1)
+#define HC_LS_THRESHOLD_RESET		0x628
+#define HC_RH_PORT_CHANGE_BITS		0x001F0000UL
+#define HC_RH_STATUS_ClearRemoteWakeupEnable	0x80000000UL
+
+#define PORT_RESET_FRAMES			10		/* USB 2.0 7.1.7.5: root port reset is driven for 10 ms */
+#define SOF_BYTE_TIMES				6		/* SOF token, sync and EOP at the start of every frame */
+#define MAX_LIST_WALK				128		/* bound ED/TD walks over corrupted lists */
+#define DONE_QUEUE_NO_INTERRUPT		7
+
+/* Condition codes written to retired TDs */
+#define CC_NoError					0
+#define CC_Stall					4
+#define CC_DeviceNotResponding		5
+#define CC_DataOverrun				8
+#define CC_DataUnderrun				9
+
+#define TD_PID_SETUP				0
+#define TD_PID_OUT					1
+#define TD_PID_IN					2
+
+/* Register file, the stack's view of it (PROT_NONE) and the access being single-stepped */
+static volatile uint32_t *RegisterFile;
+static uint8_t *RegisterTrap;
+LPC_USB_TypeDef *OhciSim_Registers;
+
+static volatile bool     TrapPending;
+static uint32_t          TrapOffset;
+static bool              TrapIsWrite;
+static bool              TrapMaskedFrame;
+static uint32_t          TrapOldValue;
+
+/* Controller state not visible as a plain register value */
+static uint32_t          InterruptEnable;
+static uint32_t          DoneHead;
+static uint8_t           DoneCounter = DONE_QUEUE_NO_INTERRUPT;
+static uint8_t           PortResetFrames;
+static bool              ControlListActive;
+static bool              BulkListActive;
+static bool              IrqEnabled;
+static OhciSim_Device_t *Device;
+
+static volatile uint64_t FrameNumber;
+static OhciSim_Stats_t   Stats;
+static uint64_t          ModelCycles;
+static uint64_t          TrapCycles;
+static uint64_t          SignalCycles;
+static volatile bool     Calibrating;
+static volatile bool     InIsr;
+
+uint64_t OhciSim_ReadTSC(void)
+{
+	return __rdtsc();
+}
+
+/*==========================================================================*/
+/* Register semantics                                                      */
+/*==========================================================================*/
+static void RaiseInterrupt(uint32_t Status)
+{
+	REG(HcInterruptStatus) |= Status;
+}
+
+static void PortWrite(uint32_t Value)
+{
+	uint32_t Port = REG(HcRhPortStatus1);
+
+	if (Value & HC_RH_PORT_STATUS_CurrentConnectStatus)		/* ClearPortEnable */
+	{
+		Port &= ~HC_RH_PORT_STATUS_PowerEnableStatus;
+	}
+	if (Value & HC_RH_PORT_STATUS_PowerEnableStatus)		/* SetPortEnable */
+	{
+		if (Port & HC_RH_PORT_STATUS_CurrentConnectStatus)
+			Port |= HC_RH_PORT_STATUS_PowerEnableStatus;
+		else
+			Port |= HC_RH_PORT_STATUS_ConnectStatusChange;
+	}
+	if ((Value & HC_RH_PORT_STATUS_PortSuspendStatus) && (Port & HC_RH_PORT_STATUS_CurrentConnectStatus))
+	{
+		Port |= HC_RH_PORT_STATUS_PortSuspendStatus;
+	}
+	if ((Value & HC_RH_PORT_STATUS_PortOverCurrentIndicator) && (Port & HC_RH_PORT_STATUS_PortSuspendStatus))	/* ClearSuspendStatus */
+	{
+		Port &= ~HC_RH_PORT_STATUS_PortSuspendStatus;
+		Port |= HC_RH_PORT_STATUS_PortSuspendStatusChange;
+	}
+	if (Value & HC_RH_PORT_STATUS_PortResetStatus)			/* SetPortReset */
+	{
+		if (Port & HC_RH_PORT_STATUS_CurrentConnectStatus)
+		{
+			Port |= HC_RH_PORT_STATUS_PortResetStatus;
+			PortResetFrames = PORT_RESET_FRAMES;
+		}
+		else
+		{
+			Port |= HC_RH_PORT_STATUS_ConnectStatusChange;
+		}
+	}
+	if (Value & HC_RH_PORT_STATUS_PortPowerStatus)			/* SetPortPower */
+	{
+		Port |= HC_RH_PORT_STATUS_PortPowerStatus;
+	}
+	if (Value & HC_RH_PORT_STATUS_LowSpeedDeviceAttached)	/* ClearPortPower, ignored: no power switching */
+	{
+	}
+
+	Port &= ~(Value & HC_RH_PORT_CHANGE_BITS);				/* change bits are write 1 to clear */
+
+	if ((Port & ~REG(HcRhPortStatus1)) & HC_RH_PORT_CHANGE_BITS)
+	{
+		RaiseInterrupt(HC_INTERRUPT_RootHubStatusChange);
+	}
+	REG(HcRhPortStatus1) = Port;
+}
+
+static void HostControllerReset(void)
+{
+	REG(HcControl)          = 0;
+	REG(HcCommandStatus)    = 0;
+	REG(HcInterruptStatus)  = 0;
+	REG(HcHCCA)             = 0;
+	REG(HcPeriodCurrentED)  = 0;
+	REG(HcControlHeadED)    = 0;
+	REG(HcControlCurrentED) = 0;
+	REG(HcBulkHeadED)       = 0;
+	REG(HcBulkCurrentED)    = 0;
+	REG(HcDoneHead)         = 0;
+	REG(HcFmInterval)       = FRAME_INTERVAL;
+	REG(HcFmRemaining)      = 0;
+	REG(HcFmNumber)         = 0;
+	REG(HcPeriodicStart)    = 0;
+	REG(HcLSTreshold)       = HC_LS_THRESHOLD_RESET;
+
+	InterruptEnable = 0;
+	REG(HcInterruptEnable)  = 0;
+	REG(HcInterruptDisable) = 0;
+
+	DoneHead          = 0;
+	DoneCounter       = DONE_QUEUE_NO_INTERRUPT;
+	ControlListActive = false;
+	BulkListActive    = false;
+}
+
+static void RegisterWrite(uint32_t Offset, uint32_t Value)
+{
+	switch (Offset)
+	{
+	case OFFSET(HcControl):
+	case OFFSET(HcFmInterval):
+	case OFFSET(HcPeriodicStart):
+	case OFFSET(HcLSTreshold):
+	case OFFSET(HcRhDescriptorB):
+		RegisterFile[Offset / 4] = Value;
+		break;
+
+	case OFFSET(HcCommandStatus):
+		if (Value & HC_COMMAND_STATUS_HostControllerReset)
+			HostControllerReset();
+		REG(HcCommandStatus) |= Value & (HC_COMMAND_STATUS_ControlListFilled | HC_COMMAND_STATUS_BulkListFilled);
+		break;
+
+	case OFFSET(HcInterruptStatus):
+		REG(HcInterruptStatus) &= ~Value;
+		break;
+
+	case OFFSET(HcInterruptEnable):
+		InterruptEnable |= Value & HC_INTERRUPT_ALL;
+		REG(HcInterruptEnable) = REG(HcInterruptDisable) = InterruptEnable;
+		break;
+
+	case OFFSET(HcInterruptDisable):
+		InterruptEnable &= ~Value;
+		REG(HcInterruptEnable) = REG(HcInterruptDisable) = InterruptEnable;
+		break;
+
+	case OFFSET(HcHCCA):
+		REG(HcHCCA) = Value & 0xFFFFFF00UL;
+		break;
+
+	case OFFSET(HcControlHeadED):
+	case OFFSET(HcControlCurrentED):
+	case OFFSET(HcBulkHeadED):
+	case OFFSET(HcBulkCurrentED):
+		RegisterFile[Offset / 4] = Value & 0xFFFFFFF0UL;
+		break;
+
+	case OFFSET(HcRhDescriptorA):
+		REG(HcRhDescriptorA) = (Value & ~HC_RH_DESCRIPTORA_NumberDownstreamPorts) | (REG(HcRhDescriptorA) & HC_RH_DESCRIPTORA_NumberDownstreamPorts);
+		break;
+
+	case OFFSET(HcRhStatus):
+		if (Value & HC_RH_STATUS_LocalPowerStatusChange)	/* SetGlobalPower */
+			REG(HcRhPortStatus1) |= HC_RH_PORT_STATUS_PortPowerStatus;
+		if (Value & HC_RH_STATUS_DeviceRemoteWakeupEnable)
+			REG(HcRhStatus) |= HC_RH_STATUS_DeviceRemoteWakeupEnable;
+		if (Value & HC_RH_STATUS_ClearRemoteWakeupEnable)
+			REG(HcRhStatus) &= ~HC_RH_STATUS_DeviceRemoteWakeupEnable;
+		break;
+
+	case OFFSET(HcRhPortStatus1):
+		PortWrite(Value);
+		break;
+
+	case OFFSET(OTGClkCtrl):
+		REG(OTGClkCtrl) = Value;
+		REG(OTGClkSt)   = Value;		/* clocks are available at once */
+		break;
+
+	case OFFSET(OTGStCtrl):
+		REG(OTGStCtrl) = Value;
+		break;
+
+	default:							/* read only or not modelled */
+		break;
+	}
+}
+
+/*==========================================================================*/
+/* Register access trapping                                                */
+/*==========================================================================*/
+/* A register access faults on the PROT_NONE page: open the page and single step the instruction */
+static void RegisterFaultHandler(int Signal, siginfo_t *Info, void *Context)
+{
+	ucontext_t *uc = (ucontext_t *) Context;
+	uint8_t *Address = (uint8_t *) Info->si_addr;
+
+	if (TrapPending || (Address < RegisterTrap) || (Address >= RegisterTrap + REGISTER_PAGE_SIZE))
+	{
+		signal(SIGSEGV, SIG_DFL);		/* a real crash, fault again with the default action */
+		return;
+	}
+
+	TrapPending  = true;
+	TrapOffset   = (uint32_t) (Address - RegisterTrap) & ~3UL;
+	TrapIsWrite  = (uc->uc_mcontext.gregs[REG_ERR] & X86_PF_WRITE) != 0;
+	TrapOldValue = RegisterFile[TrapOffset / 4];
+
+	/* Frames come from the handler the ISR runs in: a driver polling for SOF from
+	 * there (HcdCancelTransfer() on a disconnect) sees the frame boundary pass */
+	if (InIsr && !TrapIsWrite && (TrapOffset == OFFSET(HcInterruptStatus)))
+		RegisterFile[TrapOffset / 4] |= HC_INTERRUPT_StartofFrame;
+
+	/* No frame may run between the access and its replay */
+	TrapMaskedFrame = !sigismember(&uc->uc_sigmask, SIGALRM);
+	if (TrapMaskedFrame)
+		sigaddset(&uc->uc_sigmask, SIGALRM);
+
+	mprotect(RegisterTrap, REGISTER_PAGE_SIZE, PROT_READ | PROT_WRITE);
+	uc->uc_mcontext.gregs[REG_EFL] |= X86_EFLAGS_TF;
+}
+
+/* The access has been done on the open page: close it and replay a write through the model */
+static void RegisterStepHandler(int Signal, siginfo_t *Info, void *Context)
+{
+	ucontext_t *uc = (ucontext_t *) Context;
+	uint32_t Value;
+
+	if (!TrapPending)
+		return;
+
+	uc->uc_mcontext.gregs[REG_EFL] &= ~X86_EFLAGS_TF;
+	mprotect(RegisterTrap, REGISTER_PAGE_SIZE, PROT_NONE);
+
+	if (TrapIsWrite)
+	{
+		Value = RegisterFile[TrapOffset / 4];
+		RegisterFile[TrapOffset / 4] = TrapOldValue;
+		RegisterWrite(TrapOffset, Value);
+	}
+
+	if (TrapMaskedFrame)
+		sigdelset(&uc->uc_sigmask, SIGALRM);
+
+	Stats.RegisterAccesses++;
+	TrapPending = false;
+}
+
+/*==========================================================================*/
+/* List processing                                                         */
+/*==========================================================================*/
+/* ED and TD links carry flags in their low 4 bits */
+static __INLINE uint32_t ListPointer(uint32_t Link)
+{
+	return Link & 0xFFFFFFF0UL;
+}
+
+static __INLINE PHC_ED EdPointer(uint32_t Address)
+{
+	return (PHC_ED) (uintptr_t) ListPointer(Address);
+}
+
+static __INLINE PHC_GTD TdPointer(uint32_t Address)
+{
+	return (PHC_GTD) (uintptr_t) ListPointer(Address);
+}
+
+/* Move the head TD of the ED onto the done queue */
+static void RetireTd(PHC_ED Ed, PHC_GTD Td, uint8_t ConditionCode, uint8_t Toggle)
+{
+	uint32_t Halted = (ConditionCode != CC_NoError) ? 1 : 0;
+
+	Td->ConditionCode = ConditionCode;
+	Ed->HeadP.HeadTD  = ListPointer(Td->NextTD) | (Toggle << 1) | Halted;
+
+	Td->NextTD = DoneHead;
+	DoneHead   = (uint32_t) (uintptr_t) Td;
+
+	if (Halted)
+		DoneCounter = 0;
+	else if (Td->DelayInterrupt < DoneCounter)
+		DoneCounter = Td->DelayInterrupt;
+}
+
+/* The function that answers to Address: the device on port 1 or, through a hub model, one behind it */
+static OhciSim_Device_t *FunctionAt(uint8_t Address)
+{
+	if ((Device == NULL) || !(REG(HcRhPortStatus1) & HC_RH_PORT_STATUS_PowerEnableStatus))
+		return NULL;
+	if (Device->Address == Address)
+		return Device;
+	return Device->Route ? Device->Route(Device, Address) : NULL;
+}
+
+/* Run one transaction for the TD at the head of the ED.
+ * Returns the bus byte times used, 0 if the ED has nothing to do or does not fit in the frame.
+ */
+static uint32_t ServiceEndpoint(PHC_ED Ed, uint32_t Budget, bool *Progress)
+{
+	static uint8_t Packet[1024];
+	OhciSim_Handshake_t Handshake;
+	OhciSim_Device_t *Function;
+	PHC_GTD  Td;
+	uint32_t Remaining;
+	uint16_t PacketLength;
+	uint16_t Received = 0;
+	uint32_t Cost;
+	uint8_t  Pid;
+	uint8_t  Toggle;
+
+	if (Ed->Skip || Ed->Format || Ed->HeadP.Halted || (ListPointer(Ed->HeadP.HeadTD) == ListPointer(Ed->TailP)))
+		return 0;
+
+	Td        = TdPointer(Ed->HeadP.HeadTD);
+	Pid       = (Ed->Direction == 1) ? TD_PID_OUT : (Ed->Direction == 2) ? TD_PID_IN : Td->DirectionPID;
+	Toggle    = (Td->DataToggle & 2) ? (Td->DataToggle & 1) : Ed->HeadP.ToggleCarry;
+	Remaining = Td->CurrentBufferPointer ? (uint32_t) (Td->BufferEnd - Td->CurrentBufferPointer + 1) : 0;
+	PacketLength = MIN(Remaining, Ed->MaxPackageSize);
+
+	Cost = (uint32_t) (PacketLength + INTERRUPT_PROTOCOL_OVERHEAD) * (Ed->Speed ? LOW_SPEED_BANDWIDTH_FACTOR : 1);
+	if (Cost > Budget)
+		return 0;
+
+	if ((Function = FunctionAt(Ed->FunctionAddr)) == NULL)
+	{
+		Handshake = OHCISIM_NO_RESPONSE;
+	}
+	else if (Pid == TD_PID_SETUP)
+	{
+		Handshake = Function->Setup(Function, (const uint8_t *) Td->CurrentBufferPointer);
+	}
+	else if (Pid == TD_PID_OUT)
+	{
+		Handshake = Function->Out(Function, Ed->EndpointNumber, (const uint8_t *) Td->CurrentBufferPointer, PacketLength);
+	}
+	else
+	{
+		Handshake = Function->In(Function, Ed->EndpointNumber, Packet, Ed->MaxPackageSize, &Received);
+	}
+
+	switch (Handshake)
+	{
+	case OHCISIM_NAK:
+		Stats.Naks++;
+		return Cost;
+
+	case OHCISIM_STALL:
+		RetireTd(Ed, Td, CC_Stall, Toggle);
+		*Progress = true;
+		return Cost;
+
+	case OHCISIM_NO_RESPONSE:
+		RetireTd(Ed, Td, CC_DeviceNotResponding, Toggle);
+		*Progress = true;
+		return Cost;
+
+	case OHCISIM_ACK:
+	default:
+		break;
+	}
+
+	Stats.Packets++;
+	*Progress = true;
+	Toggle ^= 1;
+	Td->DataToggle = 2 | Toggle;
+
+	if (Pid == TD_PID_IN)
+	{
+		if (Received > Remaining)
+		{
+			RetireTd(Ed, Td, CC_DataOverrun, Toggle);
+			return Cost;
+		}
+		memcpy((void *) Td->CurrentBufferPointer, Packet, Received);
+		PacketLength = Received;
+	}
+
+	Remaining -= PacketLength;
+	Td->CurrentBufferPointer = Remaining ? (Td->CurrentBufferPointer + PacketLength) : NULL;
+
+	if ((Remaining == 0) || (PacketLength < Ed->MaxPackageSize))	/* end of buffer or short packet */
+	{
+		RetireTd(Ed, Td, (Remaining && !Td->BufferRounding) ? CC_DataUnderrun : CC_NoError, Toggle);
+	}
+
+	return Cost;
+}
+
+/* Move the head ITD of an isochronous ED onto the done queue, packet errors never halt the ED */
+static void RetireItd(PHC_ED Ed, PHCD_IsoTransferDescriptor Itd, uint8_t ConditionCode)
+{
+	Itd->ConditionCode = ConditionCode;
+	Ed->HeadP.HeadTD   = ListPointer(Itd->NextTD) | (Ed->HeadP.HeadTD & 0x2);
+
+	Itd->NextTD = DoneHead;
+	DoneHead    = (uint32_t) (uintptr_t) Itd;
+
+	if (Itd->DelayInterrupt < DoneCounter)
+		DoneCounter = Itd->DelayInterrupt;
+}
+
+/* Run the isochronous transaction the head ITD of the ED has for the current frame.
+ * ITDs whose frames have all passed are retired with DataOverrun first, as the OHCI does.
+ * Returns the bus byte times used.
+ */
+static uint32_t ServiceIsoEndpoint(PHC_ED Ed, uint32_t Budget)
+{
+	static uint8_t Packet[1024];
+	OhciSim_Handshake_t Handshake;
+	OhciSim_Device_t *Function;
+	PHCD_IsoTransferDescriptor Itd;
+	uint32_t Walk;
+	uint32_t Start;
+	uint32_t End;
+	uint16_t Received = 0;
+	uint16_t Length;
+	uint32_t Cost;
+	int16_t  Relative;
+	uint8_t  ConditionCode;
+
+	for (Walk = 0; Walk < MAX_LIST_WALK; Walk++)
+	{
+		if (Ed->Skip || Ed->HeadP.Halted || (ListPointer(Ed->HeadP.HeadTD) == ListPointer(Ed->TailP)))
+			return 0;
+
+		Itd      = (PHCD_IsoTransferDescriptor) (uintptr_t) ListPointer(Ed->HeadP.HeadTD);
+		Relative = (int16_t) ((uint16_t) REG(HcFmNumber) - Itd->StartingFrame);
+
+		if (Relative < 0)
+			return 0;
+		if (Relative <= Itd->FrameCount)
+			break;
+		RetireItd(Ed, Itd, CC_DataOverrun);
+	}
+	if (Walk == MAX_LIST_WALK)
+		return 0;
+
+	/* Packet bounds from this and the next offset, bit 12 selects the page of BufferEnd */
+	Start = ((Itd->OffsetPSW[Relative] & 0x1000) ? (Itd->BufferEnd & 0xFFFFF000UL) : Itd->BufferPage0) | (Itd->OffsetPSW[Relative] & 0xFFF);
+	if (Relative < Itd->FrameCount)
+		End = ((Itd->OffsetPSW[Relative + 1] & 0x1000) ? (Itd->BufferEnd & 0xFFFFF000UL) : Itd->BufferPage0) | (Itd->OffsetPSW[Relative + 1] & 0xFFF);
+	else
+		End = Itd->BufferEnd + 1;
+	Length = (uint16_t) (End - Start);
+
+	Cost = Length + INTERRUPT_PROTOCOL_OVERHEAD;
+	if (Cost > Budget)
+		return 0;
+
+	if ((Function = FunctionAt(Ed->FunctionAddr)) == NULL)
+		Handshake = OHCISIM_NO_RESPONSE;
+	else if (Ed->Direction == 1)
+		Handshake = Function->Out(Function, Ed->EndpointNumber, (const uint8_t *) (uintptr_t) Start, Length);
+	else
+		Handshake = Function->In(Function, Ed->EndpointNumber, Packet, Ed->MaxPackageSize, &Received);
+
+	/* Isochronous functions never NAK or STALL, anything but data is a missed packet */
+	if (Handshake != OHCISIM_ACK)
+	{
+		ConditionCode = CC_DeviceNotResponding;
+		Received = 0;
+	}
+	else if (Ed->Direction == 1)
+	{
+		ConditionCode = CC_NoError;
+		Stats.Packets++;
+	}
+	else
+	{
+		ConditionCode = (Received > Length) ? CC_DataOverrun : (Received < Length) ? CC_DataUnderrun : CC_NoError;
+		Received = MIN(Received, Length);
+		memcpy((void *) (uintptr_t) Start, Packet, Received);
+		Cost = Received + INTERRUPT_PROTOCOL_OVERHEAD;
+		Stats.Packets++;
+	}
+
+	/* IN packet status words carry the received size, OUT ones 0 */
+	Itd->OffsetPSW[Relative] = (uint16_t) ((ConditionCode << 12) | ((Ed->Direction == 1) ? 0 : Received));
+
+	if (Relative == Itd->FrameCount)
+		RetireItd(Ed, Itd, CC_NoError);
+
+	return Cost;
+}
+
+/* One pass over a control or bulk list, one transaction per ED */
+static uint32_t ServiceList(uint32_t Head, uint32_t Budget, bool *Progress, bool *Filled)
+{
+	uint32_t Used = 0;
+	uint32_t Walk;
+	PHC_ED   Ed;
+
+	for (Ed = EdPointer(Head), Walk = 0; (Ed != NULL) && (Walk < MAX_LIST_WALK); Ed = EdPointer(Ed->NextED), Walk++)
+	{
+		if (!Ed->Skip && !Ed->HeadP.Halted && (ListPointer(Ed->HeadP.HeadTD) != ListPointer(Ed->TailP)))
+			*Filled = true;
+		Used += ServiceEndpoint(Ed, Budget - Used, Progress);
+	}
+	return Used;
+}
+
+static void RunFrame(void)
+{
+	HC_HCCA *Hcca = (HC_HCCA *) (uintptr_t) REG(HcHCCA);
+	uint32_t Budget = FRAME_BYTE_TIMES - SOF_BYTE_TIMES;
+	uint32_t Walk;
+	bool     Progress = false;
+	bool     ControlFilled = false;
+	bool     BulkFilled = false;
+	PHC_ED   Ed;
+
+	FrameNumber++;
+	Stats.Frames++;
+
+	if (PortResetFrames && !(--PortResetFrames))
+	{
+		REG(HcRhPortStatus1) = (REG(HcRhPortStatus1) & ~HC_RH_PORT_STATUS_PortResetStatus) |
+							   HC_RH_PORT_STATUS_PowerEnableStatus | HC_RH_PORT_STATUS_PortResetStatusChange;
+		RaiseInterrupt(HC_INTERRUPT_RootHubStatusChange);
+		if (Device)
+			Device->Reset(Device);
+	}
+
+	if (((REG(HcControl) & HC_CONTROL_HostControllerFunctionalState) >> 6) != HC_HOST_OPERATIONAL || (Hcca == NULL))
+		return;
+
+	/* Start of frame */
+	REG(HcFmNumber)    = (REG(HcFmNumber) + 1) & HC_FM_NUMBER;
+	REG(HcFmRemaining) = REG(HcFmInterval) & HC_FM_REMAIN;
+	*(volatile uint16_t *) &Hcca->HccaFrameNumber = (uint16_t) REG(HcFmNumber);
+	RaiseInterrupt(HC_INTERRUPT_StartofFrame);
+	if ((DoneCounter != DONE_QUEUE_NO_INTERRUPT) && DoneCounter)
+		DoneCounter--;
+
+	/* Periodic list: one transaction per interrupt or isochronous ED reached from this frame's HCCA slot */
+	if (REG(HcControl) & HC_CONTROL_PeriodListEnable)
+	{
+		for (Ed = EdPointer(Hcca->HccaIntTable[REG(HcFmNumber) & 0x1F]), Walk = 0; (Ed != NULL) && (Walk < MAX_LIST_WALK); Ed = EdPointer(Ed->NextED), Walk++)
+		{
+			if (!Ed->Format)
+				Budget -= ServiceEndpoint(Ed, Budget, &Progress);
+			else if (REG(HcControl) & HC_CONTROL_IsochronousEnable)
+				Budget -= ServiceIsoEndpoint(Ed, Budget);
+		}
+	}
+
+	/* Control and bulk lists are only walked while their list filled bit says there is work */
+	if (REG(HcCommandStatus) & HC_COMMAND_STATUS_ControlListFilled)
+	{
+		REG(HcCommandStatus) &= ~HC_COMMAND_STATUS_ControlListFilled;
+		ControlListActive = true;
+	}
+	if (REG(HcCommandStatus) & HC_COMMAND_STATUS_BulkListFilled)
+	{
+		REG(HcCommandStatus) &= ~HC_COMMAND_STATUS_BulkListFilled;
+		BulkListActive = true;
+	}
+
+	do
+	{
+		Progress = false;
+		if (ControlListActive && (REG(HcControl) & HC_CONTROL_ControlListEnable))
+			Budget -= ServiceList(REG(HcControlHeadED), Budget, &Progress, &ControlFilled);
+		if (BulkListActive && (REG(HcControl) & HC_CONTROL_BulkListEnable))
+			Budget -= ServiceList(REG(HcBulkHeadED), Budget, &Progress, &BulkFilled);
+	} while (Progress);
+
+	/* A list found with TDs keeps being serviced next frame, an empty one waits for the driver */
+	ControlListActive = ControlFilled;
+	BulkListActive = BulkFilled;
+	if (ControlFilled)
+		REG(HcCommandStatus) |= HC_COMMAND_STATUS_ControlListFilled;
+	if (BulkFilled)
+		REG(HcCommandStatus) |= HC_COMMAND_STATUS_BulkListFilled;
+
+	/* Done queue write back, only once the driver has acknowledged the previous one */
+	if (DoneHead && (DoneCounter == 0) && !(REG(HcInterruptStatus) & HC_INTERRUPT_WritebackDoneHead))
+	{
+		*(volatile uint32_t *) &Hcca->HccaDoneHead = DoneHead;
+		DoneHead    = 0;
+		DoneCounter = DONE_QUEUE_NO_INTERRUPT;
+		RaiseInterrupt(HC_INTERRUPT_WritebackDoneHead);
+	}
+}
+
+static bool InterruptPending(void)
+{
+	return IrqEnabled && (InterruptEnable & HC_INTERRUPT_MasterInterruptEnable) &&
+		   (REG(HcInterruptStatus) & InterruptEnable & ~HC_INTERRUPT_MasterInterruptEnable);
+}
+
+static void FrameHandler(int Signal)
+{
+	uint64_t Start, IsrStart, IsrEnd;
+
+	if (Calibrating)
+		return;
+
+	Start = OhciSim_ReadTSC();
+	RunFrame();
+	IsrStart = IsrEnd = OhciSim_ReadTSC();
+
+	if (InterruptPending())
+	{
+		Stats.Interrupts++;
+		InIsr = true;
+		HcdIrqHandler(0);				/* USB_IRQHandler() */
+		InIsr = false;
+		IsrEnd = OhciSim_ReadTSC();
+	}
+
+	ModelCycles += (IsrStart - Start) + (OhciSim_ReadTSC() - IsrEnd);
+}
+
+/*==========================================================================*/
+/* Public API                                                              */
+/*==========================================================================*/
+static void BlockFrames(sigset_t *Saved)
+{
+	sigset_t Mask;
+
+	sigemptyset(&Mask);
+	sigaddset(&Mask, SIGALRM);
+	sigprocmask(SIG_BLOCK, &Mask, Saved);
+}
+
+static void RestoreFrames(sigset_t *Saved)
+{
+	sigprocmask(SIG_SETMASK, Saved, NULL);
+}
+
+/* Cost of a trapped register access and of a frame signal, subtracted from the host's cycle counts */
+static void Calibrate(void)
+{
+	const uint32_t Rounds = 1000;
+	uint64_t Start;
+	uint32_t i;
+
+	Calibrating = true;
+
+	Start = OhciSim_ReadTSC();
+	for (i = 0; i < Rounds; i++)
+	{
+		(void) OhciSim_Registers->HcRevision;
+	}
+	TrapCycles = (OhciSim_ReadTSC() - Start) / Rounds;
+
+	Start = OhciSim_ReadTSC();
+	for (i = 0; i < Rounds; i++)
+	{
+		raise(SIGALRM);
+	}
+	SignalCycles = (OhciSim_ReadTSC() - Start) / Rounds;
+
+	Stats.RegisterAccesses = 0;
+	Calibrating = false;
+}
+
+bool OhciSim_Init(uint32_t FramePeriodUS)
+{
+	struct sigaction Action;
+	struct itimerval Timer;
+	int Fd;
+
+	Fd = memfd_create("ohcisim", 0);
+	if ((Fd < 0) || (ftruncate(Fd, REGISTER_PAGE_SIZE) != 0))
+		return false;
+
+	RegisterFile = mmap(NULL, REGISTER_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0);
+	RegisterTrap = mmap(NULL, REGISTER_PAGE_SIZE, PROT_NONE, MAP_SHARED, Fd, 0);
+	close(Fd);
+	if ((RegisterFile == MAP_FAILED) || (RegisterTrap == MAP_FAILED))
+		return false;
+	OhciSim_Registers = (LPC_USB_TypeDef *) RegisterTrap;
+
+	HostControllerReset();
+	REG(HcRevision)      = HC_REVISION_1_0;
+	REG(HcRhDescriptorA) = HC_RH_DESCRIPTORA_RESET;
+	REG(HcRhPortStatus1) = HC_RH_PORT_STATUS_PortPowerStatus;
+
+	memset(&Action, 0, sizeof(Action));
+	sigemptyset(&Action.sa_mask);
+	sigaddset(&Action.sa_mask, SIGALRM);
+	Action.sa_flags = SA_SIGINFO;
+	Action.sa_sigaction = RegisterFaultHandler;
+	sigaction(SIGSEGV, &Action, NULL);
+	Action.sa_sigaction = RegisterStepHandler;
+	sigaction(SIGTRAP, &Action, NULL);
+
+	memset(&Action, 0, sizeof(Action));
+	sigemptyset(&Action.sa_mask);
+	Action.sa_flags = SA_RESTART;
+	Action.sa_handler = FrameHandler;
+	sigaction(SIGALRM, &Action, NULL);
+
+	Calibrate();
+
+	Timer.it_interval.tv_sec  = FramePeriodUS / 1000000;
+	Timer.it_interval.tv_usec = FramePeriodUS % 1000000;
+	Timer.it_value = Timer.it_interval;
+	return setitimer(ITIMER_REAL, &Timer, NULL) == 0;
+}
+
+void OhciSim_DeInit(void)
+{
+	struct itimerval Timer;
+
+	memset(&Timer, 0, sizeof(Timer));
+	setitimer(ITIMER_REAL, &Timer, NULL);
+	signal(SIGALRM, SIG_IGN);
+}
+
+void OhciSim_Attach(OhciSim_Device_t *NewDevice)
+{
+	sigset_t Saved;
+
+	BlockFrames(&Saved);
+	Device = NewDevice;
+	REG(HcRhPortStatus1) = (REG(HcRhPortStatus1) & ~HC_RH_PORT_STATUS_LowSpeedDeviceAttached) |
+						   HC_RH_PORT_STATUS_CurrentConnectStatus | HC_RH_PORT_STATUS_ConnectStatusChange |
+						   (Device->LowSpeed ? HC_RH_PORT_STATUS_LowSpeedDeviceAttached : 0);
+	RaiseInterrupt(HC_INTERRUPT_RootHubStatusChange);
+	RestoreFrames(&Saved);
+}
+
+void OhciSim_Detach(void)
+{
+	sigset_t Saved;
+
+	BlockFrames(&Saved);
+	Device = NULL;
+	REG(HcRhPortStatus1) = (REG(HcRhPortStatus1) & ~(HC_RH_PORT_STATUS_CurrentConnectStatus | HC_RH_PORT_STATUS_PowerEnableStatus |
+												 HC_RH_PORT_STATUS_LowSpeedDeviceAttached)) | HC_RH_PORT_STATUS_ConnectStatusChange;
+	RaiseInterrupt(HC_INTERRUPT_RootHubStatusChange);
+	RestoreFrames(&Saved);
+}
+
+void OhciSim_SetInterruptEnable(bool Enable)
+{
+	IrqEnabled = Enable;
+}
+
+uint64_t OhciSim_GetFrameNumber(void)
+{
+	return FrameNumber;
+}
+
+bool OhciSim_InInterrupt(void)
+{
+	return InIsr;
+}
+
+void OhciSim_GetStats(OhciSim_Stats_t *Result)
+{
+	sigset_t Saved;
+
+	BlockFrames(&Saved);
+	*Result = Stats;
+	Result->OverheadCycles = ModelCycles + (Stats.RegisterAccesses * TrapCycles) + (Stats.Frames * SignalCycles);
+	RestoreFrames(&Saved);
+}
@@ -0,0 +1,81 @@
+/*
+ * OHCI_Model.h
+ *
+ * Software model of the LPC17xx OHCI host controller for running the host
+ * stack (HCD.c/OHCI.c and the class drivers above it) as a Linux process.
+ *
+ * The register block lives on its own page which the stack sees through a
+ * PROT_NONE mapping: every register access faults, is single-stepped and
+ * replayed through the model, so write-1-to-set/clear registers, port reset
+ * and the list-filled bits behave like the silicon. A SIGALRM timer runs one
+ * virtual 1 ms frame per tick: it walks the periodic, control and bulk lists
+ * within the full speed bandwidth of a frame, retires TDs onto the done queue,
+ * writes it back to the HCCA and calls HcdIrqHandler() like USB_IRQHandler().
+ *
+ * Requires x86-64 Linux and a non-PIE build (-no-pie) so that the ED/TD
+ * addresses the stack stores in 32-bit fields are valid pointers. Isochronous
+ * TDs run one packet per frame from their StartingFrame; late ones are retired
+ * with DataOverrun and a device that does not ACK leaves a DeviceNotResponding
+ * packet status word.
+ */
+
+#ifndef HOSTSIM_OHCI_MODEL_H_
+#define HOSTSIM_OHCI_MODEL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Handshake returned by a simulated function for one transaction */
+typedef enum {
+	OHCISIM_ACK,
+	OHCISIM_NAK,
+	OHCISIM_STALL,
+	OHCISIM_NO_RESPONSE,
+} OhciSim_Handshake_t;
+
+/* A full or low speed function attached to root hub port 1, or to a port of a hub model there */
+typedef struct OhciSim_Device {
+	uint8_t Address;		/* current function address, maintained by the device */
+	bool    LowSpeed;
+
+	/* Bus reset of the port */
+	void (*Reset)(struct OhciSim_Device *Device);
+	/* SETUP transaction to endpoint 0, Request points to the 8 byte request */
+	OhciSim_Handshake_t (*Setup)(struct OhciSim_Device *Device, const uint8_t *Request);
+	/* OUT transaction carrying Length bytes */
+	OhciSim_Handshake_t (*Out)(struct OhciSim_Device *Device, uint8_t Endpoint, const uint8_t *Data, uint16_t Length);
+	/* IN transaction, the device returns up to MaxLength bytes in Data and their count in Length */
+	OhciSim_Handshake_t (*In)(struct OhciSim_Device *Device, uint8_t Endpoint, uint8_t *Data, uint16_t MaxLength, uint16_t *Length);
+	/* Optional, for a hub: the function behind it that answers to Address, NULL if none does */
+	struct OhciSim_Device *(*Route)(struct OhciSim_Device *Device, uint8_t Address);
+} OhciSim_Device_t;
+
+typedef struct {
+	uint64_t Frames;			/* virtual 1 ms frames run */
+	uint64_t Packets;			/* data transactions acknowledged */
+	uint64_t Naks;				/* transactions NAKed by the device */
+	uint64_t Interrupts;		/* calls into HcdIrqHandler() */
+	uint64_t RegisterAccesses;	/* trapped register reads and writes */
+	uint64_t OverheadCycles;	/* TSC cycles spent in the model, trap round trips and frame signals included */
+} OhciSim_Stats_t;
+
+/* Maps the register page, installs the trap handlers and starts the frame timer.
+ * FramePeriodUS is the wall clock time given to one virtual frame.
+ */
+bool OhciSim_Init(uint32_t FramePeriodUS);
+void OhciSim_DeInit(void);
+
+/* Plug/unplug the device on port 1 (connect status change on the next frame) */
+void OhciSim_Attach(OhciSim_Device_t *Device);
+void OhciSim_Detach(void);
+
+/* Stand-in for the NVIC enable bit of USB_IRQn, used by the simulated HAL */
+void OhciSim_SetInterruptEnable(bool Enable);
+
+uint64_t OhciSim_GetFrameNumber(void);
+/* True while the simulated USB_IRQHandler() runs */
+bool OhciSim_InInterrupt(void);
+void OhciSim_GetStats(OhciSim_Stats_t *Stats);
+uint64_t OhciSim_ReadTSC(void);
+
+#endif /* HOSTSIM_OHCI_MODEL_H_ */
@@ -0,0 +1,302 @@
+/*
+ * Printer_Device.c
+ *
+ * Virtual bidirectional printer, see Printer_Device.h.
+ */
+
+#include <string.h>
+
+#include "Printer_Device.h"
+
+#define MIN(a, b)					(((a) < (b)) ? (a) : (b))
+
+/* Control transfer stages */
+#define CONTROL_IDLE				0
+#define CONTROL_DATA_IN				1
+#define CONTROL_DATA_OUT			2
+#define CONTROL_STATUS_IN			3
+#define CONTROL_STALLED				4
+
+/* Port status bits */
+#define PORTSTATUS_NOTERROR			(1 << 3)
+#define PORTSTATUS_SELECT			(1 << 4)
+#define PORTSTATUS_PAPEREMPTY		(1 << 5)
+
+static const uint8_t DeviceDescriptor[] = {
+	18, 0x01, 0x10, 0x01, 0x00, 0x00, 0x00, 64,
+	0xC9, 0x1F, 0x0F, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01
+};
+
+static const uint8_t ConfigurationDescriptor[] = {
+	/* Configuration */
+	9, 0x02, 32, 0, 1, 1, 0, 0xC0, 1,
+	/* Interface 0: printer, bidirectional */
+	9, 0x04, 0, 0, 2, 0x07, 0x01, 0x02, 0,
+	7, 0x05, PRINTER_DEVICE_OUT_ENDPOINT, 0x02, PRINTER_DEVICE_PACKET_SIZE, 0, 0,
+	7, 0x05, 0x80 | PRINTER_DEVICE_IN_ENDPOINT, 0x02, PRINTER_DEVICE_PACKET_SIZE, 0, 0
+};
+
+/* IEEE 1284 device ID, preceded by its big endian length */
+static const char DeviceID[] = "MFG:Virtual;MDL:Spool Test;CMD:PCL,PJL;CLS:PRINTER;";
+
+/*==========================================================================*/
+/* Data endpoints                                                          */
+/*==========================================================================*/
+/* Runs the print engine up to the current frame */
+static void Print(Printer_Device_t *Printer)
+{
+	uint64_t Frame = OhciSim_GetFrameNumber();
+	uint32_t Bytes;
+
+	for (; Printer->LastFrame < Frame; Printer->LastFrame++)
+	{
+		if (Printer->PaperOut)
+		{
+			if (Printer->LastFrame < Printer->PaperBackFrame)
+				continue;
+			Printer->PaperOut = false;
+		}
+
+		if (Printer->Rate == 0)
+		{
+			Printer->Fill = 0;
+			continue;
+		}
+
+		Printer->Remainder += Printer->Rate;
+		Bytes = Printer->Remainder >> 16;
+		Printer->Remainder &= 0xFFFF;
+		Printer->Fill -= MIN(Printer->Fill, Bytes);
+	}
+}
+
+static OhciSim_Handshake_t DataOut(Printer_Device_t *Printer, const uint8_t *Data, uint16_t Length)
+{
+	uint16_t i;
+
+	if (Printer->Configuration == 0)
+		return OHCISIM_STALL;
+
+	Print(Printer);
+
+	if (Printer->Fill + Length > PRINTER_DEVICE_BUFFER_SIZE)
+	{
+		Printer->Naks++;
+		return OHCISIM_NAK;
+	}
+
+	for (i = 0; i < Length; i++)
+	{
+		if (Data[i] != Printer_Device_Pattern(Printer->JobIndex))
+			Printer->ReceiveErrors++;
+		Printer->JobIndex++;
+	}
+
+	Printer->Fill     += Length;
+	Printer->Received += Length;
+	if (Printer->Fill > Printer->FillPeak)
+		Printer->FillPeak = Printer->Fill;
+
+	if (Printer->PaperOutAt && (Printer->JobIndex >= Printer->PaperOutAt))
+	{
+		Printer->PaperOut       = true;
+		Printer->PaperBackFrame = OhciSim_GetFrameNumber() + Printer->PaperOutFrames;
+		Printer->PaperOutAt     = 0;
+	}
+
+	return OHCISIM_ACK;
+}
+
+/*==========================================================================*/
+/* Control endpoint                                                        */
+/*==========================================================================*/
+static void ControlReply(Printer_Device_t *Printer, const uint8_t *Data, uint16_t Length, uint16_t wLength)
+{
+	Printer->ControlLength = MIN(MIN(Length, wLength), sizeof(Printer->ControlData));
+	memcpy(Printer->ControlData, Data, Printer->ControlLength);
+}
+
+static OhciSim_Handshake_t Setup(OhciSim_Device_t *Device, const uint8_t *Request)
+{
+	Printer_Device_t *Printer = (Printer_Device_t *) Device;
+	uint8_t  bmRequestType = Request[0];
+	uint8_t  bRequest = Request[1];
+	uint16_t wValue = Request[2] | (Request[3] << 8);
+	uint16_t wLength = Request[6] | (Request[7] << 8);
+	uint8_t  Reply[2 + sizeof(DeviceID)] = {0, 0};
+	bool     Supported = true;
+
+	Printer->ControlLength = 0;
+	Printer->ControlOffset = 0;
+	Printer->PendingAddress = Device->Address;
+
+	switch ((bmRequestType << 8) | bRequest)
+	{
+	case 0x8006:	/* GET_DESCRIPTOR */
+		if ((wValue >> 8) == 0x01)
+			ControlReply(Printer, DeviceDescriptor, sizeof(DeviceDescriptor), wLength);
+		else if ((wValue >> 8) == 0x02)
+			ControlReply(Printer, ConfigurationDescriptor, sizeof(ConfigurationDescriptor), wLength);
+		else
+			Supported = false;
+		break;
+
+	case 0x0005:	/* SET_ADDRESS, takes effect after the status stage */
+		Printer->PendingAddress = wValue & 0x7F;
+		break;
+
+	case 0x0009:	/* SET_CONFIGURATION, the engine starts with an empty buffer */
+		Printer->Configuration = wValue;
+		Printer->LastFrame     = OhciSim_GetFrameNumber();
+		Printer->Fill          = 0;
+		break;
+
+	case 0x8008:	/* GET_CONFIGURATION */
+		Reply[0] = Printer->Configuration;
+		ControlReply(Printer, Reply, 1, wLength);
+		break;
+
+	case 0x8000:	/* GET_STATUS */
+	case 0x8100:
+	case 0x8200:
+		ControlReply(Printer, Reply, 2, wLength);
+		break;
+
+	case 0x0201:	/* CLEAR_FEATURE(ENDPOINT_HALT), endpoints never halt */
+		break;
+
+	case 0x010B:	/* SET_INTERFACE */
+		Printer->AlternateSetting = wValue;
+		break;
+
+	case 0xA100:	/* GET_DEVICE_ID */
+		Reply[0] = (sizeof(DeviceID) - 1 + 2) >> 8;
+		Reply[1] = (sizeof(DeviceID) - 1 + 2) & 0xFF;
+		memcpy(&Reply[2], DeviceID, sizeof(DeviceID) - 1);
+		ControlReply(Printer, Reply, sizeof(DeviceID) - 1 + 2, wLength);
+		break;
+
+	case 0xA101:	/* GET_PORT_STATUS */
+		Print(Printer);
+		Printer->StatusRequests++;
+		if (Printer->PaperOut)
+		{
+			Printer->PaperOutStatus++;
+			Reply[0] = PORTSTATUS_SELECT | PORTSTATUS_PAPEREMPTY;
+		}
+		else
+		{
+			Reply[0] = PORTSTATUS_SELECT | PORTSTATUS_NOTERROR;
+		}
+		ControlReply(Printer, Reply, 1, wLength);
+		break;
+
+	case 0x2102:	/* SOFT_RESET, the buffered data is dropped */
+		Printer->Fill = 0;
+		break;
+
+	default:
+		Supported = false;
+		break;
+	}
+
+	if (!Supported)
+		Printer->ControlStage = CONTROL_STALLED;
+	else if (wLength && (bmRequestType & 0x80))
+		Printer->ControlStage = CONTROL_DATA_IN;
+	else if (wLength)
+		Printer->ControlStage = CONTROL_DATA_OUT;
+	else
+		Printer->ControlStage = CONTROL_STATUS_IN;
+
+	return OHCISIM_ACK;		/* SETUP is always acknowledged, errors stall the next stage */
+}
+
+static OhciSim_Handshake_t In(OhciSim_Device_t *Device, uint8_t Endpoint, uint8_t *Data, uint16_t MaxLength, uint16_t *Length)
+{
+	Printer_Device_t *Printer = (Printer_Device_t *) Device;
+	uint16_t Count;
+
+	if (Endpoint == PRINTER_DEVICE_IN_ENDPOINT)
+		return OHCISIM_NAK;		/* nothing to report on the back channel */
+	if (Endpoint != 0)
+		return OHCISIM_STALL;
+
+	switch (Printer->ControlStage)
+	{
+	case CONTROL_DATA_IN:
+		Count = MIN(MaxLength, Printer->ControlLength - Printer->ControlOffset);
+		memcpy(Data, &Printer->ControlData[Printer->ControlOffset], Count);
+		Printer->ControlOffset += Count;
+		*Length = Count;
+		return OHCISIM_ACK;
+
+	case CONTROL_STATUS_IN:
+	case CONTROL_DATA_OUT:		/* status stage of an OUT request */
+		*Length = 0;
+		Device->Address = Printer->PendingAddress;
+		Printer->ControlStage = CONTROL_IDLE;
+		return OHCISIM_ACK;
+
+	case CONTROL_STALLED:
+		return OHCISIM_STALL;
+
+	default:
+		return OHCISIM_NAK;
+	}
+}
+
+static OhciSim_Handshake_t Out(OhciSim_Device_t *Device, uint8_t Endpoint, const uint8_t *Data, uint16_t Length)
+{
+	Printer_Device_t *Printer = (Printer_Device_t *) Device;
+
+	if (Endpoint == PRINTER_DEVICE_OUT_ENDPOINT)
+		return DataOut(Printer, Data, Length);
+	if (Endpoint != 0)
+		return OHCISIM_STALL;
+
+	switch (Printer->ControlStage)
+	{
+	case CONTROL_DATA_IN:		/* status stage of an IN request */
+		Printer->ControlStage = CONTROL_IDLE;
+		return OHCISIM_ACK;
+
+	case CONTROL_STALLED:
+		return OHCISIM_STALL;
+
+	default:
+		return OHCISIM_ACK;
+	}
+}
+
+static void Reset(OhciSim_Device_t *Device)
+{
+	Printer_Device_t *Printer = (Printer_Device_t *) Device;
+
+	Device->Address        = 0;
+	Printer->Configuration = 0;
+	Printer->ControlStage  = CONTROL_IDLE;
+}
+
+/*==========================================================================*/
+/* Public API                                                              */
+/*==========================================================================*/
+void Printer_Device_Init(Printer_Device_t *Printer, uint32_t BytesPerSecond, uint64_t PaperOutAt, uint32_t PaperOutMS)
+{
+	memset(Printer, 0, sizeof(Printer_Device_t));
+
+	Printer->Rate           = (uint32_t) (((uint64_t) BytesPerSecond << 16) / 1000);
+	Printer->PaperOutAt     = PaperOutAt;
+	Printer->PaperOutFrames = PaperOutMS;
+
+	Printer->Device.Reset = Reset;
+	Printer->Device.Setup = Setup;
+	Printer->Device.In    = In;
+	Printer->Device.Out   = Out;
+	Reset(&Printer->Device);
+}
+
+void Printer_Device_NewJob(Printer_Device_t *Printer)
+{
+	Printer->JobIndex = 0;
+}
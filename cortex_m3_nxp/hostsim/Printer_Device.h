@@ -0,0 +1,74 @@
+/*
+ * Printer_Device.h
+ *
+ * Virtual full speed bidirectional printer for the OHCI model. Data written to
+ * the bulk OUT endpoint lands in an input buffer of limited size, which the
+ * print engine empties at a fixed rate; while the buffer has no room for a
+ * packet the printer NAKs, which is all the flow control a USB printer has.
+ * The engine can run out of paper once, at a given byte of the job, and then
+ * stands still for a while with the paper empty bit set in its port status.
+ *
+ * Received bytes are checked against a running index modulo 251, so lost,
+ * repeated or reordered data shows up on the device side.
+ */
+
+#ifndef HOSTSIM_PRINTER_DEVICE_H_
+#define HOSTSIM_PRINTER_DEVICE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "OHCI_Model.h"
+
+#define PRINTER_DEVICE_PACKET_SIZE		64
+#define PRINTER_DEVICE_IN_ENDPOINT		1
+#define PRINTER_DEVICE_OUT_ENDPOINT		2
+#define PRINTER_DEVICE_BUFFER_SIZE		8192
+#define PRINTER_DEVICE_PATTERN_PERIOD	251
+
+typedef struct {
+	OhciSim_Device_t Device;		/* must stay first, the model hands it back to the callbacks */
+
+	/* Control endpoint */
+	uint8_t  ControlData[128];
+	uint16_t ControlLength;
+	uint16_t ControlOffset;
+	uint8_t  ControlStage;
+	uint8_t  PendingAddress;
+	uint8_t  Configuration;
+	uint8_t  AlternateSetting;
+
+	/* Print engine: the input buffer drains at Rate (Q16.16 bytes per frame), 0 for at once */
+	uint32_t Rate;
+	uint32_t Remainder;
+	uint64_t LastFrame;
+	uint32_t Fill;
+	uint32_t FillPeak;
+	uint64_t PaperOutAt;			/* byte of the job at which the paper runs out, 0 for never */
+	uint32_t PaperOutFrames;		/* frames until the paper is refilled */
+	uint64_t PaperBackFrame;
+	bool     PaperOut;
+
+	uint64_t JobIndex;				/* pattern index of the next byte of the job */
+
+	/* Statistics */
+	uint64_t Received;				/* bytes taken from the host */
+	uint64_t ReceiveErrors;			/* received bytes out of pattern */
+	uint64_t Naks;					/* OUT packets refused on a full buffer */
+	uint64_t StatusRequests;		/* GET_PORT_STATUS requests */
+	uint64_t PaperOutStatus;		/* of which answered with the paper empty */
+} Printer_Device_t;
+
+/* Resets the printer; it prints BytesPerSecond (0 unlimited) and runs out of paper for PaperOutMS at byte PaperOutAt (0 never) */
+void Printer_Device_Init(Printer_Device_t *Printer, uint32_t BytesPerSecond, uint64_t PaperOutAt, uint32_t PaperOutMS);
+
+/* Starts checking a new job from the first pattern byte */
+void Printer_Device_NewJob(Printer_Device_t *Printer);
+
+/* Pattern byte of a given job index */
+static inline uint8_t Printer_Device_Pattern(uint64_t Index)
+{
+	return (uint8_t) (Index % PRINTER_DEVICE_PATTERN_PERIOD);
+}
+
+#endif /* HOSTSIM_PRINTER_DEVICE_H_ */
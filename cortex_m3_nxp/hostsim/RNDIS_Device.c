@@ -0,0 +1,529 @@
+/*
+ * RNDIS_Device.c
+ *
+ * Virtual RNDIS Ethernet device, see RNDIS_Device.h.
+ */
+
+#include <string.h>
+
+#include "RNDIS_Device.h"
+
+#define MIN(a, b)					(((a) < (b)) ? (a) : (b))
+
+/* Control transfer stages */
+#define CONTROL_IDLE				0
+#define CONTROL_DATA_IN				1
+#define CONTROL_DATA_OUT			2
+#define CONTROL_STATUS_IN			3
+#define CONTROL_STALLED				4
+
+/* RNDIS messages */
+#define PACKET_MSG					0x00000001UL
+#define INITIALIZE_MSG				0x00000002UL
+#define QUERY_MSG					0x00000004UL
+#define SET_MSG						0x00000005UL
+#define KEEPALIVE_MSG				0x00000008UL
+#define COMPLETION					0x80000000UL
+#define STATUS_SUCCESS				0x00000000UL
+#define STATUS_NOT_SUPPORTED		0xC00000BBUL
+#define OID_GEN_CURRENT_PACKET_FILTER	0x0001010EUL
+
+static const uint8_t DeviceDescriptor[] = {
+	18, 0x01, 0x10, 0x01, 0x02, 0x00, 0x00, 64,
+	0xC9, 0x1F, 0x0F, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01
+};
+
+static const uint8_t ConfigurationDescriptor[] = {
+	/* Configuration */
+	9, 0x02, 67, 0, 2, 1, 0, 0x80, 50,
+	/* Interface 0: RNDIS control (CDC ACM, vendor specific protocol) with its notification endpoint */
+	9, 0x04, 0, 0, 1, 0x02, 0x02, 0xFF, 0,
+	5, 0x24, 0x00, 0x10, 0x01,
+	5, 0x24, 0x01, 0x00, 1,
+	4, 0x24, 0x02, 0x00,
+	5, 0x24, 0x06, 0, 1,
+	7, 0x05, 0x80 | RNDIS_DEVICE_NOTIFICATION_ENDPOINT, 0x03, 8, 0, 0x01,
+	/* Interface 1: CDC data */
+	9, 0x04, 1, 0, 2, 0x0A, 0x00, 0x00, 0,
+	7, 0x05, RNDIS_DEVICE_OUT_ENDPOINT, 0x02, RNDIS_DEVICE_PACKET_SIZE, 0, 0,
+	7, 0x05, 0x80 | RNDIS_DEVICE_IN_ENDPOINT, 0x02, RNDIS_DEVICE_PACKET_SIZE, 0, 0
+};
+
+static uint32_t Get32(const uint8_t *Data)
+{
+	return Data[0] | (Data[1] << 8) | (Data[2] << 16) | ((uint32_t) Data[3] << 24);
+}
+
+static void Put32(uint8_t *Data, uint32_t Value)
+{
+	Data[0] = Value;
+	Data[1] = Value >> 8;
+	Data[2] = Value >> 16;
+	Data[3] = Value >> 24;
+}
+
+/*==========================================================================*/
+/* Frames                                                                  */
+/*==========================================================================*/
+void RNDIS_Device_BuildFrame(uint8_t *Frame, uint16_t Length, uint32_t Sequence)
+{
+	static const uint8_t Header[14] = {
+		0x02, 0x00, 0x00, 0x00, 0x00, 0x01,		/* destination */
+		0x02, 0x00, 0x00, 0x00, 0x00, 0x02,		/* source */
+		0x88, 0xB5								/* local experimental EtherType */
+	};
+	uint16_t i;
+
+	memcpy(Frame, Header, sizeof(Header));
+	Put32(&Frame[14], Sequence);
+	for (i = 18; i < Length; i++)
+		Frame[i] = (uint8_t) (Sequence + i);
+}
+
+int64_t RNDIS_Device_CheckFrame(const uint8_t *Frame, uint16_t Length)
+{
+	uint32_t Sequence;
+	uint16_t i;
+
+	if ((Length < RNDIS_DEVICE_FRAME_MIN) || (Length > RNDIS_DEVICE_FRAME_MAX) || (Frame[12] != 0x88) || (Frame[13] != 0xB5))
+		return -1;
+
+	Sequence = Get32(&Frame[14]);
+	for (i = 18; i < Length; i++)
+	{
+		if (Frame[i] != (uint8_t) (Sequence + i))
+			return -1;
+	}
+
+	return Sequence;
+}
+
+static uint16_t FrameLengthOf(const RNDIS_Device_t *Ethernet, uint32_t Sequence)
+{
+	return Ethernet->FrameLength ? Ethernet->FrameLength : RNDIS_Device_FrameLength(Sequence);
+}
+
+/*==========================================================================*/
+/* Data endpoints                                                          */
+/*==========================================================================*/
+/* Runs the wire up to the current frame: what does not fit in the receive queue is dropped */
+static void Arrive(RNDIS_Device_t *Ethernet)
+{
+	uint64_t Frame = OhciSim_GetFrameNumber();
+	uint32_t Frames;
+
+	if (!Ethernet->Running)
+		return;
+
+	for (; Ethernet->LastFrame < Frame; Ethernet->LastFrame++)
+	{
+		Ethernet->Remainder += Ethernet->Rate;
+		Frames = Ethernet->Remainder >> 16;
+		Ethernet->Remainder &= 0xFFFF;
+
+		while (Frames--)
+		{
+			Ethernet->Arrived++;
+
+			if (Ethernet->QueueCount == RNDIS_DEVICE_QUEUE_DEPTH)
+			{
+				/* The sequence number moves on, the host sees the gap */
+				Ethernet->Dropped++;
+				Ethernet->NextSequence++;
+				continue;
+			}
+
+			Ethernet->Queue[(Ethernet->QueueHead + Ethernet->QueueCount) % RNDIS_DEVICE_QUEUE_DEPTH] = Ethernet->NextSequence++;
+			Ethernet->QueueCount++;
+		}
+	}
+}
+
+/* Packs the waiting frames into the next IN transfer, as many as the batch limits allow */
+static void BuildTransfer(RNDIS_Device_t *Ethernet)
+{
+	uint32_t Limit = MIN(Ethernet->HostMaxTransferSize, RNDIS_DEVICE_TRANSFER_MAX);
+	uint32_t Packets = 0;
+	uint32_t Sequence;
+	uint16_t Length;
+	uint8_t  *Message;
+
+	Ethernet->TransferLength = 0;
+	Ethernet->TransferOffset = 0;
+
+	while (Ethernet->QueueCount && (Packets < Ethernet->MaxPacketsPerTransfer))
+	{
+		Sequence = Ethernet->Queue[Ethernet->QueueHead];
+		Length   = FrameLengthOf(Ethernet, Sequence);
+
+		if (Ethernet->TransferLength + RNDIS_DEVICE_HEADER_SIZE + Length > Limit)
+			break;
+
+		Message = &Ethernet->Transfer[Ethernet->TransferLength];
+		memset(Message, 0, RNDIS_DEVICE_HEADER_SIZE);
+		Put32(&Message[0], PACKET_MSG);
+		Put32(&Message[4], RNDIS_DEVICE_HEADER_SIZE + Length);
+		Put32(&Message[8], RNDIS_DEVICE_HEADER_SIZE - 8);
+		Put32(&Message[12], Length);
+		RNDIS_Device_BuildFrame(&Message[RNDIS_DEVICE_HEADER_SIZE], Length, Sequence);
+
+		Ethernet->TransferLength += RNDIS_DEVICE_HEADER_SIZE + Length;
+		Ethernet->QueueHead = (Ethernet->QueueHead + 1) % RNDIS_DEVICE_QUEUE_DEPTH;
+		Ethernet->QueueCount--;
+		Packets++;
+	}
+
+	Ethernet->Sent += Packets;
+	if (Packets)
+		Ethernet->SentTransfers++;
+
+	/* A transfer ending on a packet boundary is closed with a zero length packet, unless it filled the host buffer */
+	Ethernet->TransferZLP = !(Ethernet->TransferLength % RNDIS_DEVICE_PACKET_SIZE) && (Ethernet->TransferLength < Limit);
+}
+
+static OhciSim_Handshake_t DataIn(RNDIS_Device_t *Ethernet, uint8_t *Data, uint16_t MaxLength, uint16_t *Length)
+{
+	uint16_t Count;
+
+	if (Ethernet->Configuration == 0)
+		return OHCISIM_STALL;
+
+	if (Ethernet->TransferOffset == Ethernet->TransferLength)
+	{
+		if (Ethernet->TransferLength && Ethernet->TransferZLP)
+		{
+			Ethernet->TransferLength = Ethernet->TransferOffset = 0;
+			*Length = 0;
+			return OHCISIM_ACK;
+		}
+
+		Arrive(Ethernet);
+		BuildTransfer(Ethernet);
+
+		if (!Ethernet->TransferLength)
+		{
+			Ethernet->Naks++;
+			return OHCISIM_NAK;
+		}
+	}
+
+	Count = MIN(MIN(MaxLength, RNDIS_DEVICE_PACKET_SIZE), Ethernet->TransferLength - Ethernet->TransferOffset);
+	memcpy(Data, &Ethernet->Transfer[Ethernet->TransferOffset], Count);
+	Ethernet->TransferOffset += Count;
+	*Length = Count;
+
+	if ((Ethernet->TransferOffset == Ethernet->TransferLength) && !Ethernet->TransferZLP)
+		Ethernet->TransferLength = Ethernet->TransferOffset = 0;
+
+	return OHCISIM_ACK;
+}
+
+/* Checks the messages of a complete OUT transfer */
+static void ParseTransfer(RNDIS_Device_t *Ethernet)
+{
+	uint32_t Alignment = 1UL << Ethernet->PacketAlignmentFactor;
+	uint32_t Offset = 0;
+	uint32_t Packets = 0;
+	uint32_t MessageLength, DataOffset, DataLength;
+	const uint8_t *Message;
+	int64_t  Sequence;
+
+	while (Offset + 8 <= Ethernet->OutLength)
+	{
+		Message = &Ethernet->OutTransfer[Offset];
+		MessageLength = Get32(&Message[4]);
+
+		if ((Offset % Alignment) || (Get32(&Message[0]) != PACKET_MSG) || (MessageLength < RNDIS_DEVICE_HEADER_SIZE) ||
+			(MessageLength > Ethernet->OutLength - Offset))
+		{
+			Ethernet->ReceiveErrors++;
+			break;
+		}
+
+		DataOffset = Get32(&Message[8]) + 8;
+		DataLength = Get32(&Message[12]);
+		Sequence   = (DataOffset + DataLength <= MessageLength) ? RNDIS_Device_CheckFrame(&Message[DataOffset], DataLength) : -1;
+
+		if (Sequence != Ethernet->ReceiveSequence)
+			Ethernet->ReceiveErrors++;
+
+		Ethernet->ReceiveSequence = (Sequence >= 0) ? (uint32_t) Sequence + 1 : Ethernet->ReceiveSequence + 1;
+		Ethernet->Received++;
+		Packets++;
+		Offset += MessageLength;
+	}
+
+	/* Only a single padding byte may follow the last message */
+	if ((Offset < Ethernet->OutLength) && ((Ethernet->OutLength - Offset > 1) || Ethernet->OutTransfer[Offset]))
+		Ethernet->ReceiveErrors++;
+
+	if (Packets > Ethernet->MaxPacketsPerTransfer)
+		Ethernet->ReceiveErrors++;
+
+	if (Packets)
+		Ethernet->ReceivedTransfers++;
+}
+
+static OhciSim_Handshake_t DataOut(RNDIS_Device_t *Ethernet, const uint8_t *Data, uint16_t Length)
+{
+	if (Ethernet->Configuration == 0)
+		return OHCISIM_STALL;
+
+	if (Ethernet->OutLength + Length > MIN(Ethernet->MaxTransferSize, RNDIS_DEVICE_TRANSFER_MAX))
+	{
+		/* Longer than the device said it accepts */
+		Ethernet->ReceiveErrors++;
+		Ethernet->OutLength = 0;
+		return OHCISIM_ACK;
+	}
+
+	memcpy(&Ethernet->OutTransfer[Ethernet->OutLength], Data, Length);
+	Ethernet->OutLength += Length;
+
+	if (Length < RNDIS_DEVICE_PACKET_SIZE)
+	{
+		ParseTransfer(Ethernet);
+		Ethernet->OutLength = 0;
+	}
+
+	return OHCISIM_ACK;
+}
+
+/*==========================================================================*/
+/* Encapsulated commands                                                   */
+/*==========================================================================*/
+static void Command(RNDIS_Device_t *Ethernet)
+{
+	const uint8_t *Message = Ethernet->ControlData;
+	uint8_t *Response = Ethernet->Response;
+	uint32_t Type = Get32(&Message[0]);
+	uint32_t Oid;
+
+	memset(Response, 0, sizeof(Ethernet->Response));
+	Put32(&Response[0], Type | COMPLETION);
+	Put32(&Response[8], Get32(&Message[8]));		/* RequestId */
+	Put32(&Response[12], STATUS_SUCCESS);
+	Ethernet->ResponseLength = 16;
+
+	switch (Type)
+	{
+	case INITIALIZE_MSG:
+		Ethernet->HostMaxTransferSize = Get32(&Message[20]);
+		Ethernet->Initialized = true;
+		Put32(&Response[16], 1);					/* MajorVersion */
+		Put32(&Response[20], 0);
+		Put32(&Response[24], 1);					/* DeviceFlags: connectionless */
+		Put32(&Response[28], 0);					/* Medium: 802.3 */
+		Put32(&Response[32], Ethernet->MaxPacketsPerTransfer);
+		Put32(&Response[36], Ethernet->MaxTransferSize);
+		Put32(&Response[40], Ethernet->PacketAlignmentFactor);
+		Ethernet->ResponseLength = 52;
+		break;
+
+	case QUERY_MSG:
+		/* Every OID reads as a 32-bit value of 1 */
+		Put32(&Response[16], 4);					/* InformationBufferLength */
+		Put32(&Response[20], 16);					/* InformationBufferOffset */
+		Put32(&Response[24], 1);
+		Ethernet->ResponseLength = 28;
+		break;
+
+	case SET_MSG:
+		Oid = Get32(&Message[12]);
+		if ((Oid == OID_GEN_CURRENT_PACKET_FILTER) && Get32(&Message[28 + 0]) && !Ethernet->Running)
+		{
+			/* The wire comes up once the host accepts frames */
+			Ethernet->Running   = true;
+			Ethernet->LastFrame = OhciSim_GetFrameNumber();
+		}
+		break;
+
+	case KEEPALIVE_MSG:
+		break;
+
+	default:
+		Put32(&Response[12], STATUS_NOT_SUPPORTED);
+		break;
+	}
+
+	Put32(&Response[4], Ethernet->ResponseLength);
+}
+
+/*==========================================================================*/
+/* Control endpoint                                                        */
+/*==========================================================================*/
+static void ControlReply(RNDIS_Device_t *Ethernet, const uint8_t *Data, uint16_t Length, uint16_t wLength)
+{
+	Ethernet->ControlLength = MIN(MIN(Length, wLength), sizeof(Ethernet->ControlData));
+	memcpy(Ethernet->ControlData, Data, Ethernet->ControlLength);
+}
+
+static OhciSim_Handshake_t Setup(OhciSim_Device_t *Device, const uint8_t *Request)
+{
+	RNDIS_Device_t *Ethernet = (RNDIS_Device_t *) Device;
+	uint8_t  bmRequestType = Request[0];
+	uint8_t  bRequest = Request[1];
+	uint16_t wValue = Request[2] | (Request[3] << 8);
+	uint16_t wLength = Request[6] | (Request[7] << 8);
+	uint8_t  Reply[2] = {0, 0};
+	bool     Supported = true;
+
+	Ethernet->ControlLength = 0;
+	Ethernet->ControlOffset = 0;
+	Ethernet->PendingAddress = Device->Address;
+
+	switch ((bmRequestType << 8) | bRequest)
+	{
+	case 0x8006:	/* GET_DESCRIPTOR */
+		if ((wValue >> 8) == 0x01)
+			ControlReply(Ethernet, DeviceDescriptor, sizeof(DeviceDescriptor), wLength);
+		else if ((wValue >> 8) == 0x02)
+			ControlReply(Ethernet, ConfigurationDescriptor, sizeof(ConfigurationDescriptor), wLength);
+		else
+			Supported = false;
+		break;
+
+	case 0x0005:	/* SET_ADDRESS, takes effect after the status stage */
+		Ethernet->PendingAddress = wValue & 0x7F;
+		break;
+
+	case 0x0009:	/* SET_CONFIGURATION */
+		Ethernet->Configuration = wValue;
+		break;
+
+	case 0x8008:	/* GET_CONFIGURATION */
+		Reply[0] = Ethernet->Configuration;
+		ControlReply(Ethernet, Reply, 1, wLength);
+		break;
+
+	case 0x8000:	/* GET_STATUS */
+	case 0x8100:
+	case 0x8200:
+		ControlReply(Ethernet, Reply, 2, wLength);
+		break;
+
+	case 0x0201:	/* CLEAR_FEATURE(ENDPOINT_HALT), endpoints never halt */
+		break;
+
+	case 0x2100:	/* SEND_ENCAPSULATED_COMMAND, the data stage lands in ControlData */
+		Supported = (wLength <= sizeof(Ethernet->ControlData));
+		break;
+
+	case 0xA101:	/* GET_ENCAPSULATED_RESPONSE */
+		ControlReply(Ethernet, Ethernet->Response, Ethernet->ResponseLength, wLength);
+		Ethernet->ResponseLength = 0;
+		break;
+
+	default:
+		Supported = false;
+		break;
+	}
+
+	if (!Supported)
+		Ethernet->ControlStage = CONTROL_STALLED;
+	else if (wLength && (bmRequestType & 0x80))
+		Ethernet->ControlStage = CONTROL_DATA_IN;
+	else if (wLength)
+		Ethernet->ControlStage = CONTROL_DATA_OUT;
+	else
+		Ethernet->ControlStage = CONTROL_STATUS_IN;
+
+	return OHCISIM_ACK;		/* SETUP is always acknowledged, errors stall the next stage */
+}
+
+static OhciSim_Handshake_t In(OhciSim_Device_t *Device, uint8_t Endpoint, uint8_t *Data, uint16_t MaxLength, uint16_t *Length)
+{
+	RNDIS_Device_t *Ethernet = (RNDIS_Device_t *) Device;
+	uint16_t Count;
+
+	if (Endpoint == RNDIS_DEVICE_IN_ENDPOINT)
+		return DataIn(Ethernet, Data, MaxLength, Length);
+	if (Endpoint == RNDIS_DEVICE_NOTIFICATION_ENDPOINT)
+		return OHCISIM_NAK;		/* the host polls for responses */
+	if (Endpoint != 0)
+		return OHCISIM_STALL;
+
+	switch (Ethernet->ControlStage)
+	{
+	case CONTROL_DATA_IN:
+		Count = MIN(MaxLength, Ethernet->ControlLength - Ethernet->ControlOffset);
+		memcpy(Data, &Ethernet->ControlData[Ethernet->ControlOffset], Count);
+		Ethernet->ControlOffset += Count;
+		*Length = Count;
+		return OHCISIM_ACK;
+
+	case CONTROL_DATA_OUT:		/* status stage of an OUT request, the command is complete */
+		Command(Ethernet);
+		/* fall through */
+	case CONTROL_STATUS_IN:
+		*Length = 0;
+		Device->Address = Ethernet->PendingAddress;
+		Ethernet->ControlStage = CONTROL_IDLE;
+		return OHCISIM_ACK;
+
+	case CONTROL_STALLED:
+		return OHCISIM_STALL;
+
+	default:
+		return OHCISIM_NAK;
+	}
+}
+
+static OhciSim_Handshake_t Out(OhciSim_Device_t *Device, uint8_t Endpoint, const uint8_t *Data, uint16_t Length)
+{
+	RNDIS_Device_t *Ethernet = (RNDIS_Device_t *) Device;
+
+	if (Endpoint == RNDIS_DEVICE_OUT_ENDPOINT)
+		return DataOut(Ethernet, Data, Length);
+	if (Endpoint != 0)
+		return OHCISIM_STALL;
+
+	switch (Ethernet->ControlStage)
+	{
+	case CONTROL_DATA_IN:		/* status stage of an IN request */
+		Ethernet->ControlStage = CONTROL_IDLE;
+		return OHCISIM_ACK;
+
+	case CONTROL_DATA_OUT:		/* encapsulated command data */
+		Length = MIN(Length, sizeof(Ethernet->ControlData) - Ethernet->ControlLength);
+		memcpy(&Ethernet->ControlData[Ethernet->ControlLength], Data, Length);
+		Ethernet->ControlLength += Length;
+		return OHCISIM_ACK;
+
+	case CONTROL_STALLED:
+		return OHCISIM_STALL;
+
+	default:
+		return OHCISIM_ACK;
+	}
+}
+
+static void Reset(OhciSim_Device_t *Device)
+{
+	RNDIS_Device_t *Ethernet = (RNDIS_Device_t *) Device;
+
+	Device->Address         = 0;
+	Ethernet->Configuration = 0;
+	Ethernet->ControlStage  = CONTROL_IDLE;
+}
+
+/*==========================================================================*/
+/* Public API                                                              */
+/*==========================================================================*/
+void RNDIS_Device_Init(RNDIS_Device_t *Ethernet, uint32_t FramesPerSecond, uint16_t FrameLength,
+					   uint32_t MaxPacketsPerTransfer, uint32_t MaxTransferSize, uint32_t PacketAlignmentFactor)
+{
+	memset(Ethernet, 0, sizeof(RNDIS_Device_t));
+
+	Ethernet->Rate                  = (uint32_t) (((uint64_t) FramesPerSecond << 16) / 1000);
+	Ethernet->FrameLength           = FrameLength;
+	Ethernet->MaxPacketsPerTransfer = MaxPacketsPerTransfer ? MaxPacketsPerTransfer : 1;
+	Ethernet->MaxTransferSize       = MaxTransferSize;
+	Ethernet->PacketAlignmentFactor = PacketAlignmentFactor;
+
+	Ethernet->Device.Reset = Reset;
+	Ethernet->Device.Setup = Setup;
+	Ethernet->Device.In    = In;
+	Ethernet->Device.Out   = Out;
+	Reset(&Ethernet->Device);
+}
@@ -0,0 +1,104 @@
+/*
+ * RNDIS_Device.h
+ *
+ * Virtual full speed RNDIS Ethernet device for the OHCI model, standing in
+ * for a USB Ethernet dongle or a tethered modem. It answers the encapsulated
+ * INITIALIZE/QUERY/SET/KEEPALIVE commands on the control endpoint, receives
+ * frames from the wire at a fixed rate into a receive queue of limited depth
+ * and sends them to the host over the bulk IN endpoint, batching as many
+ * REMOTE_NDIS_PACKET_MSG messages per transfer as the host's maximum transfer
+ * size and the device's own batch limit allow. Frames that arrive while the
+ * queue is full are dropped and counted, like a MAC without a free descriptor.
+ *
+ * Frames carry a running sequence number and a payload derived from it, so
+ * the host can check that nothing is lost or corrupted; transfers written to
+ * the bulk OUT endpoint are parsed message by message and checked the same
+ * way, along with the alignment the device asked for.
+ */
+
+#ifndef HOSTSIM_RNDIS_DEVICE_H_
+#define HOSTSIM_RNDIS_DEVICE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "OHCI_Model.h"
+
+#define RNDIS_DEVICE_PACKET_SIZE		64
+#define RNDIS_DEVICE_IN_ENDPOINT		1
+#define RNDIS_DEVICE_OUT_ENDPOINT		2
+#define RNDIS_DEVICE_NOTIFICATION_ENDPOINT	3
+#define RNDIS_DEVICE_QUEUE_DEPTH		16			/* frames waiting to be sent to the host */
+#define RNDIS_DEVICE_FRAME_MIN			60
+#define RNDIS_DEVICE_FRAME_MAX			1500			/* ETHERNET_FRAME_SIZE_MAX of the class driver */
+#define RNDIS_DEVICE_HEADER_SIZE		44			/* REMOTE_NDIS_PACKET_MSG header */
+#define RNDIS_DEVICE_TRANSFER_MAX		16384
+
+typedef struct {
+	OhciSim_Device_t Device;		/* must stay first, the model hands it back to the callbacks */
+
+	/* Control endpoint and encapsulated commands */
+	uint8_t  ControlData[2048];
+	uint16_t ControlLength;
+	uint16_t ControlOffset;
+	uint8_t  ControlStage;
+	uint8_t  PendingAddress;
+	uint8_t  Configuration;
+	uint8_t  Response[128];
+	uint16_t ResponseLength;
+	bool     Initialized;
+
+	/* Device parameters given to the host in the INITIALIZE response */
+	uint32_t MaxPacketsPerTransfer;
+	uint32_t MaxTransferSize;
+	uint32_t PacketAlignmentFactor;
+	uint32_t HostMaxTransferSize;	/* from the INITIALIZE message */
+
+	/* Receive side: frames arrive at Rate (Q16.16 per frame) once the packet filter is set */
+	uint32_t Rate;
+	uint32_t Remainder;
+	uint64_t LastFrame;
+	bool     Running;
+	uint16_t FrameLength;			/* 0 for lengths varying with the sequence number */
+	uint32_t Queue[RNDIS_DEVICE_QUEUE_DEPTH];	/* sequence numbers of the waiting frames */
+	uint32_t QueueHead;
+	uint32_t QueueCount;
+	uint32_t NextSequence;			/* sequence number of the next frame from the wire */
+	uint8_t  Transfer[RNDIS_DEVICE_TRANSFER_MAX];
+	uint32_t TransferLength;
+	uint32_t TransferOffset;
+	bool     TransferZLP;
+
+	/* Transmit side: host transfers are collected until their short packet */
+	uint8_t  OutTransfer[RNDIS_DEVICE_TRANSFER_MAX];
+	uint32_t OutLength;
+	uint32_t ReceiveSequence;
+
+	/* Statistics */
+	uint64_t Arrived;				/* frames from the wire */
+	uint64_t Dropped;				/* frames dropped on a full queue */
+	uint64_t Sent;					/* frames sent to the host */
+	uint64_t SentTransfers;			/* bulk IN transfers they took */
+	uint64_t Received;				/* frames received from the host */
+	uint64_t ReceivedTransfers;		/* bulk OUT transfers they came in */
+	uint64_t ReceiveErrors;			/* frames out of sequence or corrupted, malformed or misaligned messages */
+	uint64_t Naks;					/* IN requests NAKed on an empty queue */
+} RNDIS_Device_t;
+
+/* Resets the device; FramesPerSecond arrive from the wire once the host sets the packet filter, FrameLength 0 varies them */
+void RNDIS_Device_Init(RNDIS_Device_t *Ethernet, uint32_t FramesPerSecond, uint16_t FrameLength,
+					   uint32_t MaxPacketsPerTransfer, uint32_t MaxTransferSize, uint32_t PacketAlignmentFactor);
+
+/* Length of frame Sequence when the frame length varies */
+static inline uint16_t RNDIS_Device_FrameLength(uint32_t Sequence)
+{
+	return RNDIS_DEVICE_FRAME_MIN + (uint16_t) ((Sequence * 2654435761u) % (RNDIS_DEVICE_FRAME_MAX - RNDIS_DEVICE_FRAME_MIN + 1));
+}
+
+/* Fills frame Sequence of the given length: Ethernet header, sequence number, then a payload derived from it */
+void RNDIS_Device_BuildFrame(uint8_t *Frame, uint16_t Length, uint32_t Sequence);
+
+/* Checks a frame built by RNDIS_Device_BuildFrame(), returning its sequence number or -1 if corrupted */
+int64_t RNDIS_Device_CheckFrame(const uint8_t *Frame, uint16_t Length);
+
+#endif /* HOSTSIM_RNDIS_DEVICE_H_ */
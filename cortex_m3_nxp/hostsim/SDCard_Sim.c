@@ -0,0 +1,450 @@
+/*
+ * SDCard_Sim.c
+ *
+ * SPI mode SDHC card model behind the lpc17xx_spi.h API, see SDCard_Sim.h.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "lpc17xx_spi.h"
+#include "diskio.h"
+#include "sdcard.h"
+
+#include "DCD_Model.h"
+#include "SDCard_Sim.h"
+
+#define SD_BLOCK_SIZE				512
+#define SD_BLOCK_WITH_CRC			(SD_BLOCK_SIZE + 2)
+#define SD_UNIT_SECTORS				1024		/* CSD v2: capacity is (C_SIZE + 1) * 512 KB */
+
+#define TOKEN_START_BLOCK			0xFE
+#define TOKEN_START_MULTI_WRITE		0xFC
+#define TOKEN_STOP_TRAN				0xFD
+#define DATA_RESPONSE_ACCEPTED		0x05
+
+/* Card timing, in ns */
+#define READ_ACCESS_NS				250000		/* command to first data token */
+#define READ_NEXT_BLOCK_NS			10000		/* between the blocks of CMD18 */
+#define WRITE_PROGRAM_NS			100000		/* busy after each block */
+#define WRITE_STOP_NS				500000		/* busy after the Stop Tran token */
+#define STOP_TRANSMISSION_NS		20000		/* busy after CMD12 */
+#define ACMD41_CALLS_TO_READY		2
+
+typedef enum {
+	RX_IDLE,
+	RX_COMMAND,
+	RX_WRITE_TOKEN,
+	RX_WRITE_DATA,
+} RxState_t;
+
+static struct {
+	uint8_t  *Storage;
+	uint32_t  Sectors;
+	uint8_t   Csd[16];
+
+	bool      Selected;
+	bool      Idle;
+	bool      AppCommand;
+	uint32_t  OpCondCalls;
+
+	/* MOSI side */
+	RxState_t RxState;
+	uint8_t   Command[6];
+	uint8_t   CommandLength;
+	uint32_t  WriteLba;
+	bool      WriteMulti;
+	uint16_t  WriteOffset;
+	uint8_t   WriteBlock[SD_BLOCK_WITH_CRC];
+
+	/* MISO side */
+	uint8_t   Queue[96];
+	uint8_t   QueueHead;
+	uint8_t   QueueLength;
+	uint64_t  BusyUntil;
+	uint64_t  BusyAfterQueue;
+	bool      ReadActive;
+	bool      ReadMulti;
+	uint32_t  ReadLba;
+	int32_t   ReadOffset;					/* -1 while waiting for the data token */
+	uint64_t  ReadyAt;
+
+	/* Timing */
+	uint64_t  ByteNs;
+	uint64_t  SpiTime;
+
+	SdSim_Stats_t Stats;
+} Card;
+
+static void Queue(const uint8_t *Data, uint8_t Length)
+{
+	memcpy(&Card.Queue[Card.QueueHead + Card.QueueLength], Data, Length);
+	Card.QueueLength += Length;
+}
+
+static void QueueByte(uint8_t Data)
+{
+	Queue(&Data, 1);
+}
+
+/* R1 after the Ncr byte */
+static void QueueR1(uint8_t R1)
+{
+	QueueByte(0xFF);
+	QueueByte(R1 | (Card.Idle ? R1_IN_IDLE_STATE : 0));
+}
+
+/* Data block of a register, after a gap */
+static void QueueDataBlock(const uint8_t *Data, uint8_t Length)
+{
+	QueueByte(0xFF);
+	QueueByte(TOKEN_START_BLOCK);
+	Queue(Data, Length);
+	QueueByte(0xFF);
+	QueueByte(0xFF);
+}
+
+static void SetBusy(uint64_t Now, uint64_t Duration)
+{
+	Card.BusyUntil = Now + Card.ByteNs + Duration;
+	Card.Stats.BusyNs += Duration;
+}
+
+static void ExecuteCommand(uint64_t Now)
+{
+	static const uint8_t IfCond[4] = {0x00, 0x00, 0x01, 0xAA};
+	static const uint8_t Cid[16] = {0x03, 'S', 'D', 'S', 'I', 'M', 0x01, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x01, 0x0A, 0x01};
+	uint8_t  Index = Card.Command[0] & 0x3F;
+	uint32_t Arg = ((uint32_t) Card.Command[1] << 24) | ((uint32_t) Card.Command[2] << 16) |
+				   ((uint32_t) Card.Command[3] << 8) | Card.Command[4];
+	bool     AppCommand = Card.AppCommand;
+	uint8_t  Ocr[4] = {0x40, 0xFF, 0x80, 0x00};
+	uint8_t  Status[64];
+
+	Card.AppCommand = false;
+	Card.Stats.Commands++;
+
+	if (AppCommand && (Index == SD_SEND_OP_COND))
+	{
+		if (++Card.OpCondCalls >= ACMD41_CALLS_TO_READY)
+			Card.Idle = false;
+		QueueR1(R1_NO_ERROR);
+		return;
+	}
+
+	if (AppCommand && (Index == SD_STATUS))
+	{
+		memset(Status, 0, sizeof(Status));
+		Status[10] = 0x40;				/* AU_SIZE 4: 256 sectors */
+		QueueR1(R1_NO_ERROR);
+		QueueByte(0x00);				/* second byte of R2 */
+		QueueDataBlock(Status, sizeof(Status));
+		return;
+	}
+
+	switch (Index)
+	{
+	case GO_IDLE_STATE:
+		Card.Idle = true;
+		Card.OpCondCalls = 0;
+		Card.ReadActive = false;
+		QueueR1(R1_NO_ERROR);
+		break;
+
+	case SEND_IF_COND:
+		QueueR1(R1_NO_ERROR);
+		Queue(IfCond, sizeof(IfCond));
+		break;
+
+	case APP_CMD:
+		Card.AppCommand = true;
+		QueueR1(R1_NO_ERROR);
+		break;
+
+	case READ_OCR:
+		if (!Card.Idle)
+			Ocr[0] |= 0x80;				/* power up done */
+		QueueR1(R1_NO_ERROR);
+		Queue(Ocr, sizeof(Ocr));
+		break;
+
+	case SEND_CSD:
+	case SEND_CID:
+		QueueR1(R1_NO_ERROR);
+		QueueDataBlock((Index == SEND_CSD) ? Card.Csd : Cid, 16);
+		break;
+
+	case SET_BLOCKLEN:
+		QueueR1((Arg == SD_BLOCK_SIZE) ? R1_NO_ERROR : R1_PARA_ERROR);
+		break;
+
+	case READ_SINGLE_BLOCK:
+	case READ_MULTIPLE_BLOCK:
+		if (Arg >= Card.Sectors)
+		{
+			QueueR1(R1_ADDRESS_ERROR);
+			break;
+		}
+		QueueR1(R1_NO_ERROR);
+		Card.ReadActive = true;
+		Card.ReadMulti  = (Index == READ_MULTIPLE_BLOCK);
+		Card.ReadLba    = Arg;
+		Card.ReadOffset = -1;
+		Card.ReadyAt    = Now + READ_ACCESS_NS;
+		Card.Stats.BusyNs += READ_ACCESS_NS;
+		break;
+
+	case STOP_TRANSMISSION:
+		Card.ReadActive  = false;
+		Card.QueueHead   = 0;
+		Card.QueueLength = 0;
+		QueueByte(0xFF);				/* stuff byte */
+		QueueR1(R1_NO_ERROR);
+		Card.BusyAfterQueue = STOP_TRANSMISSION_NS;
+		break;
+
+	case WRITE_SINGLE_BLOCK:
+	case WRITE_MULTIPLE_BLOCK:
+		if (Arg >= Card.Sectors)
+		{
+			QueueR1(R1_ADDRESS_ERROR);
+			break;
+		}
+		QueueR1(R1_NO_ERROR);
+		Card.RxState    = RX_WRITE_TOKEN;
+		Card.WriteMulti = (Index == WRITE_MULTIPLE_BLOCK);
+		Card.WriteLba   = Arg;
+		break;
+
+	default:
+		QueueR1(R1_ILLEGAL_CMD);
+		break;
+	}
+}
+
+/* Byte the card drives on MISO at time Now */
+static uint8_t CardOutput(uint64_t Now)
+{
+	uint8_t Data;
+
+	if (Now < Card.BusyUntil)
+		return 0x00;
+
+	if (Card.QueueLength)
+	{
+		Data = Card.Queue[Card.QueueHead++];
+		if (--Card.QueueLength == 0)
+		{
+			Card.QueueHead = 0;
+			if (Card.BusyAfterQueue)
+			{
+				SetBusy(Now, Card.BusyAfterQueue);
+				Card.BusyAfterQueue = 0;
+			}
+		}
+		return Data;
+	}
+
+	if (Card.ReadActive)
+	{
+		if (Card.ReadOffset < 0)
+		{
+			if (Now < Card.ReadyAt)
+				return 0xFF;
+			Card.ReadOffset = 0;
+			return TOKEN_START_BLOCK;
+		}
+
+		Data = (Card.ReadOffset < SD_BLOCK_SIZE) ? Card.Storage[((uint64_t) Card.ReadLba * SD_BLOCK_SIZE) + Card.ReadOffset] : 0xFF;
+		if (++Card.ReadOffset == SD_BLOCK_WITH_CRC)
+		{
+			Card.Stats.BlocksRead++;
+			if (Card.ReadMulti && (Card.ReadLba + 1 < Card.Sectors))
+			{
+				Card.ReadLba++;
+				Card.ReadOffset = -1;
+				Card.ReadyAt = Now + Card.ByteNs + READ_NEXT_BLOCK_NS;
+				Card.Stats.BusyNs += READ_NEXT_BLOCK_NS;
+			}
+			else
+			{
+				Card.ReadActive = false;
+			}
+		}
+		return Data;
+	}
+
+	return 0xFF;
+}
+
+/* Byte the host drives on MOSI at time Now */
+static void CardInput(uint8_t Data, uint64_t Now)
+{
+	switch (Card.RxState)
+	{
+	case RX_IDLE:
+		if ((Data & 0xC0) == 0x40)
+		{
+			Card.Command[0] = Data;
+			Card.CommandLength = 1;
+			Card.RxState = RX_COMMAND;
+		}
+		break;
+
+	case RX_COMMAND:
+		Card.Command[Card.CommandLength++] = Data;
+		if (Card.CommandLength == sizeof(Card.Command))
+		{
+			Card.RxState = RX_IDLE;
+			ExecuteCommand(Now);
+		}
+		break;
+
+	case RX_WRITE_TOKEN:
+		if ((Data == TOKEN_START_BLOCK) || (Data == TOKEN_START_MULTI_WRITE))
+		{
+			Card.WriteOffset = 0;
+			Card.RxState = RX_WRITE_DATA;
+		}
+		else if ((Data == TOKEN_STOP_TRAN) && Card.WriteMulti)
+		{
+			Card.RxState = RX_IDLE;
+			SetBusy(Now, WRITE_STOP_NS);
+		}
+		break;
+
+	case RX_WRITE_DATA:
+		Card.WriteBlock[Card.WriteOffset++] = Data;
+		if (Card.WriteOffset < SD_BLOCK_WITH_CRC)
+			break;
+
+		if (Card.WriteLba < Card.Sectors)
+		{
+			memcpy(&Card.Storage[(uint64_t) Card.WriteLba * SD_BLOCK_SIZE], Card.WriteBlock, SD_BLOCK_SIZE);
+			Card.Stats.BlocksWritten++;
+		}
+		QueueByte(DATA_RESPONSE_ACCEPTED);
+		Card.BusyAfterQueue = WRITE_PROGRAM_NS;
+
+		Card.WriteLba++;
+		Card.RxState = Card.WriteMulti ? RX_WRITE_TOKEN : RX_IDLE;
+		break;
+	}
+}
+
+static uint8_t Exchange(uint8_t Data, uint64_t Now)
+{
+	uint8_t Received;
+
+	if (!Card.Selected)
+		return 0xFF;
+
+	Received = CardOutput(Now);
+	CardInput(Data, Now);
+	return Received;
+}
+
+/* Start of the next transfer on the bus: the SSP is idle until the CPU writes to it */
+static uint64_t SpiBegin(void)
+{
+	uint64_t Now = DcdSim_GetTime();
+
+	if (Card.SpiTime < Now)
+		Card.SpiTime = Now;
+	return Card.SpiTime;
+}
+
+/* Waits until Bytes bytes have been clocked out */
+static void SpiWait(uint32_t Bytes)
+{
+	Card.SpiTime += Bytes * Card.ByteNs;
+	while (DcdSim_GetTime() < Card.SpiTime)
+	{
+	}
+}
+
+bool SdSim_Init(uint32_t SizeMB)
+{
+	uint32_t CSize = (SizeMB * 2) - 1;
+
+	memset(&Card, 0, sizeof(Card));
+	Card.Sectors = (CSize + 1) * SD_UNIT_SECTORS;
+	Card.Storage = calloc(Card.Sectors, SD_BLOCK_SIZE);
+	if ((SizeMB == 0) || (Card.Storage == NULL))
+		return false;
+
+	Card.Csd[0] = 0x40;					/* CSD structure v2.0 */
+	Card.Csd[5] = 0x59;					/* READ_BL_LEN 512 */
+	Card.Csd[7] = (CSize >> 16) & 0x3F;
+	Card.Csd[8] = (CSize >> 8) & 0xFF;
+	Card.Csd[9] = CSize & 0xFF;
+
+	Card.Idle = true;
+	Card.ByteNs = 8000;
+	return true;
+}
+
+void SdSim_GetStats(SdSim_Stats_t *Stats)
+{
+	*Stats = Card.Stats;
+}
+
+/*==========================================================================*/
+/* lpc17xx_spi.h                                                           */
+/*==========================================================================*/
+void SPI_Init(void)
+{
+	Card.Selected = false;
+}
+
+void SPI_ConfigClockRate(uint32_t SPI_CLOCKRATE)
+{
+	Card.ByteNs = (8000000000ULL * SPI_CLOCKRATE) / SystemCoreClock;
+}
+
+void SPI_CS_Low(void)
+{
+	Card.Selected = true;
+}
+
+void SPI_CS_High(void)
+{
+	Card.Selected = false;
+	Card.RxState = RX_IDLE;
+	Card.ReadActive = false;
+	Card.QueueLength = 0;
+	Card.QueueHead = 0;
+}
+
+uint8_t SPI_SendByte(uint8_t data)
+{
+	uint8_t Received = Exchange(data, SpiBegin());
+
+	SpiWait(1);
+	return Received;
+}
+
+uint8_t SPI_RecvByte(void)
+{
+	return SPI_SendByte(0xFF);
+}
+
+void SPI_SendBlock_FIFO(const uint8_t *buf, uint32_t len)
+{
+	uint64_t Start = SpiBegin();
+	uint32_t i;
+
+	for (i = 0; i < len; i++)
+		Exchange(buf[i], Start + (i * Card.ByteNs));
+	SpiWait(len);
+}
+
+void SPI_RecvBlock_FIFO(uint8_t *buf, uint32_t len)
+{
+	uint64_t Start = SpiBegin();
+	uint32_t i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = Exchange(0xFF, Start + (i * Card.ByteNs));
+	SpiWait(len);
+}
@@ -0,0 +1,30 @@
+/*
+ * SDCard_Sim.h
+ *
+ * Virtual SDHC card on the SSP port, for running fatfs/user_config/sdcard.c
+ * as a Linux process. SDCard_Sim.c replaces lpc17xx_spi.c: each SPI byte is
+ * exchanged with a model of the card's SPI mode (commands, responses, data
+ * tokens, read access latency and programming busy time) and takes its time
+ * at the configured SSP clock on the virtual clock of the DCD model, so the
+ * card and the USB bus share one time base.
+ */
+
+#ifndef HOSTSIM_SDCARD_SIM_H_
+#define HOSTSIM_SDCARD_SIM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+	uint64_t Commands;
+	uint64_t BlocksRead;
+	uint64_t BlocksWritten;
+	uint64_t BusyNs;			/* virtual time the card spent reading or programming */
+} SdSim_Stats_t;
+
+/* Allocates a card of SizeMB megabytes (a multiple of 512 KB), filled with zeros */
+bool SdSim_Init(uint32_t SizeMB);
+
+void SdSim_GetStats(SdSim_Stats_t *Stats);
+
+#endif /* HOSTSIM_SDCARD_SIM_H_ */
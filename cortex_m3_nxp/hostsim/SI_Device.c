@@ -0,0 +1,419 @@
+/*
+ * SI_Device.c
+ *
+ * Virtual PTP camera, see SI_Device.h.
+ */
+
+#include <string.h>
+
+#include "SI_Device.h"
+
+#define MIN(a, b)					(((a) < (b)) ? (a) : (b))
+
+/* Control transfer stages */
+#define CONTROL_IDLE				0
+#define CONTROL_DATA_IN				1
+#define CONTROL_DATA_OUT			2
+#define CONTROL_STATUS_IN			3
+#define CONTROL_STALLED				4
+
+/* Bulk-only transport phases */
+#define PHASE_COMMAND				0
+#define PHASE_DATA_IN				1
+#define PHASE_RESPONSE				2
+
+#define CONTAINER_COMMAND			1
+#define CONTAINER_DATA				2
+#define CONTAINER_RESPONSE			3
+
+#define RESPONSE_OK					0x2001
+#define RESPONSE_SESSION_NOT_OPEN	0x2003
+#define RESPONSE_NOT_SUPPORTED		0x2005
+#define RESPONSE_INVALID_HANDLE		0x2009
+
+static const uint8_t DeviceDescriptor[] = {
+	18, 0x01, 0x10, 0x01, 0x00, 0x00, 0x00, 64,
+	0xC9, 0x1F, 0x10, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01
+};
+
+static const uint8_t ConfigurationDescriptor[] = {
+	/* Configuration */
+	9, 0x02, 39, 0, 1, 1, 0, 0x80, 50,
+	/* Interface 0: Still Image, bulk-only */
+	9, 0x04, 0, 0, 3, 0x06, 0x01, 0x01, 0,
+	7, 0x05, 0x80 | SI_DEVICE_IN_ENDPOINT, 0x02, SI_DEVICE_PACKET_SIZE, 0, 0,
+	7, 0x05, SI_DEVICE_OUT_ENDPOINT, 0x02, SI_DEVICE_PACKET_SIZE, 0, 0,
+	7, 0x05, 0x80 | SI_DEVICE_EVENTS_ENDPOINT, 0x03, 8, 0, 0x10
+};
+
+static void Put16(uint8_t *Buffer, uint16_t Value)
+{
+	Buffer[0] = Value;
+	Buffer[1] = Value >> 8;
+}
+
+static void Put32(uint8_t *Buffer, uint32_t Value)
+{
+	Put16(Buffer, Value);
+	Put16(Buffer + 2, Value >> 16);
+}
+
+static uint32_t Get32(const uint8_t *Buffer)
+{
+	return Buffer[0] | (Buffer[1] << 8) | (Buffer[2] << 16) | ((uint32_t) Buffer[3] << 24);
+}
+
+/*==========================================================================*/
+/* Bulk-only transport                                                     */
+/*==========================================================================*/
+static void BuildHeader(SI_Device_t *Camera, uint8_t Type, uint16_t Code, uint32_t Length)
+{
+	Put32(&Camera->Header[0], Length);
+	Put16(&Camera->Header[4], Type);
+	Put16(&Camera->Header[6], Code);
+	Put32(&Camera->Header[8], Camera->TransactionID);
+}
+
+static void StartResponse(SI_Device_t *Camera, uint16_t Code)
+{
+	Camera->ResponseCode = Code;
+	Camera->Phase        = PHASE_RESPONSE;
+}
+
+static void StartData(SI_Device_t *Camera, uint32_t HeaderLength, uint32_t PayloadLength)
+{
+	BuildHeader(Camera, CONTAINER_DATA, Camera->Operation, HeaderLength + PayloadLength);
+	Camera->HeaderLength    = HeaderLength;
+	Camera->ContainerLength = HeaderLength + PayloadLength;
+	Camera->Offset          = 0;
+	Camera->ZLP             = !(Camera->ContainerLength % SI_DEVICE_PACKET_SIZE);
+	Camera->ResponseCode    = RESPONSE_OK;
+	Camera->Phase           = PHASE_DATA_IN;
+}
+
+static void Command(SI_Device_t *Camera, const uint8_t *Data, uint16_t Length)
+{
+	uint32_t Handle;
+	uint32_t i;
+
+	if ((Length < 12) || (Get32(Data) != Length) || ((Data[4] | (Data[5] << 8)) != CONTAINER_COMMAND))
+	{
+		Camera->ProtocolErrors++;
+		return;
+	}
+
+	Camera->Commands++;
+	Camera->Operation     = Data[6] | (Data[7] << 8);
+	Camera->TransactionID = Get32(&Data[8]);
+	Handle                = (Length >= 16) ? Get32(&Data[12]) : 0;
+
+	switch (Camera->Operation)
+	{
+	case 0x1002:	/* OpenSession */
+		Camera->SessionOpen = true;
+		StartResponse(Camera, RESPONSE_OK);
+		break;
+
+	case 0x1003:	/* CloseSession */
+		StartResponse(Camera, Camera->SessionOpen ? RESPONSE_OK : RESPONSE_SESSION_NOT_OPEN);
+		Camera->SessionOpen = false;
+		break;
+
+	case 0x1007:	/* GetObjectHandles: the whole container fits in the header buffer */
+		if (!Camera->SessionOpen)
+		{
+			StartResponse(Camera, RESPONSE_SESSION_NOT_OPEN);
+			break;
+		}
+
+		Put32(&Camera->Header[12], Camera->Objects);
+		for (i = 0; i < Camera->Objects; i++)
+			Put32(&Camera->Header[16 + 4 * i], SI_DEVICE_HANDLE_BASE + i);
+		StartData(Camera, 16 + 4 * Camera->Objects, 0);
+		break;
+
+	case 0x1009:	/* GetObject */
+		if (!Camera->SessionOpen)
+		{
+			StartResponse(Camera, RESPONSE_SESSION_NOT_OPEN);
+			break;
+		}
+
+		Camera->Object = Handle - SI_DEVICE_HANDLE_BASE;
+		if ((Handle < SI_DEVICE_HANDLE_BASE) || (Camera->Object >= Camera->Objects))
+		{
+			StartResponse(Camera, RESPONSE_INVALID_HANDLE);
+			break;
+		}
+
+		StartData(Camera, 12, Camera->ObjectSize[Camera->Object]);
+
+		/* The header keeps the full length, the container ends early */
+		Camera->ContainerLength -= MIN(Camera->ShortBy, Camera->ObjectSize[Camera->Object]);
+		Camera->ZLP              = !(Camera->ContainerLength % SI_DEVICE_PACKET_SIZE);
+		Camera->ShortBy          = 0;
+		break;
+
+	default:
+		StartResponse(Camera, RESPONSE_NOT_SUPPORTED);
+		break;
+	}
+}
+
+/* Payload bytes the rate limit lets through in this frame */
+static uint32_t Credit(SI_Device_t *Camera)
+{
+	uint64_t Frame = OhciSim_GetFrameNumber();
+
+	if (!Camera->Rate)
+		return UINT32_MAX;
+
+	for (; Camera->LastFrame < Frame; Camera->LastFrame++)
+	{
+		Camera->Remainder += Camera->Rate;
+		Camera->Credit     = MIN(Camera->Credit + (Camera->Remainder >> 16), 4 * SI_DEVICE_PACKET_SIZE + (Camera->Rate >> 16));
+		Camera->Remainder &= 0xFFFF;
+	}
+
+	return Camera->Credit;
+}
+
+static OhciSim_Handshake_t DataIn(SI_Device_t *Camera, uint8_t *Data, uint16_t MaxLength, uint16_t *Length)
+{
+	uint32_t Count;
+	uint32_t Offset;
+	uint32_t Handle;
+
+	if (Camera->Configuration == 0)
+		return OHCISIM_STALL;
+
+	if (Camera->Phase == PHASE_RESPONSE)
+	{
+		BuildHeader(Camera, CONTAINER_RESPONSE, Camera->ResponseCode, 12);
+		memcpy(Data, Camera->Header, 12);
+		*Length = 12;
+		Camera->Phase = PHASE_COMMAND;
+		return OHCISIM_ACK;
+	}
+
+	if (Camera->Phase != PHASE_DATA_IN)
+	{
+		Camera->Naks++;
+		return OHCISIM_NAK;
+	}
+
+	if (Camera->Offset == Camera->ContainerLength)
+	{
+		/* Only the zero length packet ending a container of whole packets is left */
+		*Length = 0;
+		Camera->ZLP = false;
+		Camera->Phase = PHASE_RESPONSE;
+		return OHCISIM_ACK;
+	}
+
+	Count = MIN(MIN(MaxLength, SI_DEVICE_PACKET_SIZE), Camera->ContainerLength - Camera->Offset);
+
+	if ((Camera->Offset + Count > Camera->HeaderLength) && (Credit(Camera) < Count))
+	{
+		Camera->Naks++;
+		return OHCISIM_NAK;
+	}
+
+	Handle = SI_DEVICE_HANDLE_BASE + Camera->Object;
+	for (*Length = 0; *Length < Count; (*Length)++, Camera->Offset++)
+	{
+		if (Camera->Offset < Camera->HeaderLength)
+		{
+			Data[*Length] = Camera->Header[Camera->Offset];
+			continue;
+		}
+
+		Offset = Camera->Offset - Camera->HeaderLength;
+		Data[*Length] = SI_Device_Pattern(Handle, Offset);
+		Camera->DataBytes++;
+		if (Camera->Rate)
+			Camera->Credit--;
+	}
+
+	if ((Camera->Offset == Camera->ContainerLength) && !Camera->ZLP)
+		Camera->Phase = PHASE_RESPONSE;
+
+	return OHCISIM_ACK;
+}
+
+static OhciSim_Handshake_t DataOut(SI_Device_t *Camera, const uint8_t *Data, uint16_t Length)
+{
+	if (Camera->Configuration == 0)
+		return OHCISIM_STALL;
+
+	if (Camera->Phase != PHASE_COMMAND)
+	{
+		Camera->ProtocolErrors++;
+		return OHCISIM_ACK;
+	}
+
+	Command(Camera, Data, Length);
+	return OHCISIM_ACK;
+}
+
+/*==========================================================================*/
+/* Control endpoint                                                        */
+/*==========================================================================*/
+static void ControlReply(SI_Device_t *Camera, const uint8_t *Data, uint16_t Length, uint16_t wLength)
+{
+	Camera->ControlLength = MIN(MIN(Length, wLength), sizeof(Camera->ControlData));
+	memcpy(Camera->ControlData, Data, Camera->ControlLength);
+}
+
+static OhciSim_Handshake_t Setup(OhciSim_Device_t *Device, const uint8_t *Request)
+{
+	SI_Device_t *Camera = (SI_Device_t *) Device;
+	uint8_t  bmRequestType = Request[0];
+	uint8_t  bRequest = Request[1];
+	uint16_t wValue = Request[2] | (Request[3] << 8);
+	uint16_t wLength = Request[6] | (Request[7] << 8);
+	uint8_t  Reply[2] = {0, 0};
+	bool     Supported = true;
+
+	Camera->ControlLength = 0;
+	Camera->ControlOffset = 0;
+	Camera->PendingAddress = Device->Address;
+
+	switch ((bmRequestType << 8) | bRequest)
+	{
+	case 0x8006:	/* GET_DESCRIPTOR */
+		if ((wValue >> 8) == 0x01)
+			ControlReply(Camera, DeviceDescriptor, sizeof(DeviceDescriptor), wLength);
+		else if ((wValue >> 8) == 0x02)
+			ControlReply(Camera, ConfigurationDescriptor, sizeof(ConfigurationDescriptor), wLength);
+		else
+			Supported = false;
+		break;
+
+	case 0x0005:	/* SET_ADDRESS, takes effect after the status stage */
+		Camera->PendingAddress = wValue & 0x7F;
+		break;
+
+	case 0x0009:	/* SET_CONFIGURATION */
+		Camera->Configuration = wValue;
+		Camera->Phase         = PHASE_COMMAND;
+		break;
+
+	case 0x8008:	/* GET_CONFIGURATION */
+		Reply[0] = Camera->Configuration;
+		ControlReply(Camera, Reply, 1, wLength);
+		break;
+
+	case 0x8000:	/* GET_STATUS */
+	case 0x8100:
+	case 0x8200:
+		ControlReply(Camera, Reply, 2, wLength);
+		break;
+
+	case 0x0201:	/* CLEAR_FEATURE(ENDPOINT_HALT), endpoints never halt */
+		break;
+
+	default:
+		Supported = false;
+		break;
+	}
+
+	if (!Supported)
+		Camera->ControlStage = CONTROL_STALLED;
+	else if (wLength && (bmRequestType & 0x80))
+		Camera->ControlStage = CONTROL_DATA_IN;
+	else if (wLength)
+		Camera->ControlStage = CONTROL_DATA_OUT;
+	else
+		Camera->ControlStage = CONTROL_STATUS_IN;
+
+	return OHCISIM_ACK;		/* SETUP is always acknowledged, errors stall the next stage */
+}
+
+static OhciSim_Handshake_t In(OhciSim_Device_t *Device, uint8_t Endpoint, uint8_t *Data, uint16_t MaxLength, uint16_t *Length)
+{
+	SI_Device_t *Camera = (SI_Device_t *) Device;
+	uint16_t Count;
+
+	if (Endpoint == SI_DEVICE_IN_ENDPOINT)
+		return DataIn(Camera, Data, MaxLength, Length);
+	if (Endpoint == SI_DEVICE_EVENTS_ENDPOINT)
+		return OHCISIM_NAK;		/* the camera never raises events */
+	if (Endpoint != 0)
+		return OHCISIM_STALL;
+
+	switch (Camera->ControlStage)
+	{
+	case CONTROL_DATA_IN:
+		Count = MIN(MaxLength, Camera->ControlLength - Camera->ControlOffset);
+		memcpy(Data, &Camera->ControlData[Camera->ControlOffset], Count);
+		Camera->ControlOffset += Count;
+		*Length = Count;
+		return OHCISIM_ACK;
+
+	case CONTROL_STATUS_IN:
+	case CONTROL_DATA_OUT:		/* status stage of an OUT request */
+		*Length = 0;
+		Device->Address = Camera->PendingAddress;
+		Camera->ControlStage = CONTROL_IDLE;
+		return OHCISIM_ACK;
+
+	case CONTROL_STALLED:
+		return OHCISIM_STALL;
+
+	default:
+		return OHCISIM_NAK;
+	}
+}
+
+static OhciSim_Handshake_t Out(OhciSim_Device_t *Device, uint8_t Endpoint, const uint8_t *Data, uint16_t Length)
+{
+	SI_Device_t *Camera = (SI_Device_t *) Device;
+
+	if (Endpoint == SI_DEVICE_OUT_ENDPOINT)
+		return DataOut(Camera, Data, Length);
+	if (Endpoint != 0)
+		return OHCISIM_STALL;
+
+	switch (Camera->ControlStage)
+	{
+	case CONTROL_DATA_IN:		/* status stage of an IN request */
+		Camera->ControlStage = CONTROL_IDLE;
+		return OHCISIM_ACK;
+
+	case CONTROL_STALLED:
+		return OHCISIM_STALL;
+
+	default:
+		return OHCISIM_ACK;
+	}
+}
+
+static void Reset(OhciSim_Device_t *Device)
+{
+	SI_Device_t *Camera = (SI_Device_t *) Device;
+
+	Device->Address       = 0;
+	Camera->Configuration = 0;
+	Camera->ControlStage  = CONTROL_IDLE;
+	Camera->Phase         = PHASE_COMMAND;
+	Camera->SessionOpen   = false;
+}
+
+/*==========================================================================*/
+/* Public API                                                              */
+/*==========================================================================*/
+void SI_Device_Init(SI_Device_t *Camera, const uint32_t *ObjectSizes, uint32_t Objects, uint32_t BytesPerSecond)
+{
+	memset(Camera, 0, sizeof(SI_Device_t));
+
+	Camera->Objects = MIN(Objects, SI_DEVICE_MAX_OBJECTS);
+	memcpy(Camera->ObjectSize, ObjectSizes, Camera->Objects * sizeof(uint32_t));
+	Camera->Rate = (uint32_t) (((uint64_t) BytesPerSecond << 16) / 1000);
+
+	Camera->Device.Reset = Reset;
+	Camera->Device.Setup = Setup;
+	Camera->Device.In    = In;
+	Camera->Device.Out   = Out;
+	Reset(&Camera->Device);
+}
@@ -0,0 +1,83 @@
+/*
+ * SI_Device.h
+ *
+ * Virtual full speed PTP camera for the OHCI model. It implements the Still
+ * Image bulk-only transport: command containers arrive on the bulk OUT
+ * endpoint, data and response containers go back over the bulk IN endpoint,
+ * the data container ending with a zero length packet when it fills its last
+ * packet. OpenSession, CloseSession, GetObjectHandles and GetObject are
+ * answered; anything else gets OperationNotSupported.
+ *
+ * Objects are generated on the fly from their handle and offset, so they can
+ * be of any size and checked byte by byte on the host. The data phase can be
+ * limited to a byte rate, as the camera reading its own card would, and the
+ * next object can be cut short of the length its container header declares.
+ */
+
+#ifndef HOSTSIM_SI_DEVICE_H_
+#define HOSTSIM_SI_DEVICE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "OHCI_Model.h"
+
+#define SI_DEVICE_PACKET_SIZE			64
+#define SI_DEVICE_IN_ENDPOINT			1
+#define SI_DEVICE_OUT_ENDPOINT			2
+#define SI_DEVICE_EVENTS_ENDPOINT		3
+#define SI_DEVICE_MAX_OBJECTS			32
+#define SI_DEVICE_HANDLE_BASE			0x00010000	/* handle of object 0 */
+
+typedef struct {
+	OhciSim_Device_t Device;		/* must stay first, the model hands it back to the callbacks */
+
+	/* Control endpoint */
+	uint8_t  ControlData[128];
+	uint16_t ControlLength;
+	uint16_t ControlOffset;
+	uint8_t  ControlStage;
+	uint8_t  PendingAddress;
+	uint8_t  Configuration;
+
+	/* Objects */
+	uint32_t ObjectSize[SI_DEVICE_MAX_OBJECTS];
+	uint32_t Objects;
+	bool     SessionOpen;
+
+	/* Transaction in progress */
+	uint8_t  Phase;
+	uint16_t Operation;
+	uint32_t TransactionID;
+	uint16_t ResponseCode;
+	uint32_t Object;				/* index of the object being sent */
+	uint8_t  Header[12 + 4 + 4 * SI_DEVICE_MAX_OBJECTS];	/* container header, or the whole container of a handle list */
+	uint32_t HeaderLength;
+	uint32_t ContainerLength;		/* header and payload */
+	uint32_t Offset;				/* bytes of the container sent */
+	bool     ZLP;					/* a zero length packet is still owed after the container */
+	uint32_t ShortBy;				/* payload bytes the next GetObject leaves out, 0 for none */
+
+	/* Data phase rate limit: Q16.16 bytes per frame, 0 for none */
+	uint32_t Rate;
+	uint32_t Remainder;
+	uint32_t Credit;
+	uint64_t LastFrame;
+
+	/* Statistics */
+	uint64_t Commands;
+	uint64_t DataBytes;				/* payload bytes sent */
+	uint64_t Naks;					/* IN requests NAKed by the rate limit or with nothing to send */
+	uint64_t ProtocolErrors;		/* malformed or unexpected containers */
+} SI_Device_t;
+
+/* Resets the camera with Objects objects of the given sizes; BytesPerSecond limits the data phase, 0 for none */
+void SI_Device_Init(SI_Device_t *Camera, const uint32_t *ObjectSizes, uint32_t Objects, uint32_t BytesPerSecond);
+
+/* Byte at Offset of the object with the given handle */
+static inline uint8_t SI_Device_Pattern(uint32_t Handle, uint32_t Offset)
+{
+	return (uint8_t) ((Offset * 7) ^ (Offset >> 8) ^ (Offset >> 16) ^ (Handle * 31));
+}
+
+#endif /* HOSTSIM_SI_DEVICE_H_ */
@@ -0,0 +1,872 @@
+/*
+ * UART_Model.c
+ *
+ * Register, FIFO, line timing and GPDMA model of the LPC17xx UARTs, see
+ * UART_Model.h.
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include <LPC17xx.h>		/* the shim next to this file, through the include path */
+
+#include "DCD_Model.h"
+#include "UART_Model.h"
+
+#define PAGE_BYTES					4096
+#define GPDMA_PAGE					UARTSIM_PORTS		/* the GPDMA registers follow the pages of the UARTs */
+#define FIFO_DEPTH					16
+#define LINE_QUEUE					4096				/* characters queued by the remote, a power of two */
+#define GPDMA_CHANNELS				8
+#define CHANNEL_BASE				0x100
+#define CHANNEL_STRIDE				0x20
+#define MAX_IRQ_LOOPS				32					/* bound handler calls per event for an interrupt that does not clear */
+#define FRAMING_TOLERANCE			0.04				/* remote rate error the receiver still samples right */
+#define TIMEOUT_CHARACTERS			4					/* character timeout: 3.5 to 4.5 character times */
+
+#define UART_OFFSET(member)			offsetof(LPC_UART_TypeDef, member)
+#define DMA_OFFSET(member)			offsetof(LPC_GPDMA_TypeDef, member)
+#define CHANNEL_OFFSET(member)		offsetof(LPC_GPDMACH_TypeDef, member)
+#define DMA_REG(member)				RegisterFile[((GPDMA_PAGE * PAGE_BYTES) + DMA_OFFSET(member)) / 4]
+#define CHANNEL_REG(Ch, member)		RegisterFile[((GPDMA_PAGE * PAGE_BYTES) + CHANNEL_BASE + ((Ch) * CHANNEL_STRIDE) + \
+												  CHANNEL_OFFSET(member)) / 4]
+
+#define LCR_DLAB					0x80
+#define LCR_PARITY_ENABLE			0x08
+#define LCR_TWO_STOP_BITS			0x04
+#define FCR_FIFO_ENABLE				0x01
+#define FCR_RX_RESET				0x02
+#define FCR_TX_RESET				0x04
+#define FCR_DMA_MODE				0x08
+#define FCR_KEPT					0xC9
+#define IER_RBR_INT					0x01
+#define IER_THRE_INT				0x02
+#define IER_RLS_INT					0x04
+#define IER_KEPT					0x307
+#define IIR_NONE					0x01
+#define IIR_RLS						0x06
+#define IIR_RDA						0x04
+#define IIR_CTI						0x0C
+#define IIR_THRE					0x02
+#define IIR_FIFOS_ENABLED			0xC0
+#define LSR_RDR						0x01
+#define LSR_OE						0x02
+#define LSR_FE						0x08
+#define LSR_THRE					0x20
+#define LSR_TEMT					0x40
+#define LSR_RXFE					0x80
+
+#define DMA_CONFIG_ENABLE			(1UL << 0)
+#define DMA_CONFIG_SRC_PERIPHERAL(Config)	(((Config) >> 1) & 0x1F)
+#define DMA_CONFIG_DEST_PERIPHERAL(Config)	(((Config) >> 6) & 0x1F)
+#define DMA_CONFIG_FLOW(Config)		(((Config) >> 11) & 0x07)
+#define DMA_CONFIG_IE				(1UL << 14)
+#define DMA_CONFIG_ITC				(1UL << 15)
+#define DMA_CONFIG_HALT				(1UL << 18)
+#define DMA_CONTROL_SIZE			0x00000FFFUL
+#define DMA_CONTROL_SI				(1UL << 26)
+#define DMA_CONTROL_DI				(1UL << 27)
+#define DMA_CONTROL_I				(1UL << 31)
+#define DMA_FLOW_M2P				1
+#define DMA_FLOW_P2M				2
+#define DMA_PERIPHERAL_UART0_TX		8					/* UARTn Tx is 8 + 2n, Rx 9 + 2n */
+#define DMA_PERIPHERAL_UART3_RX		15
+#define DMA_FAULT_TX				0x01				/* Port_t.DmaFaults */
+#define DMA_FAULT_RX				0x02
+
+typedef enum {
+	EVENT_NONE,
+	EVENT_TX_DONE,				/* the stop bit of the character in the shift register ends */
+	EVENT_RX_DONE,				/* the stop bit of a character of the remote ends */
+	EVENT_TIMEOUT,				/* character timeout */
+} Event_t;
+
+typedef struct {
+	/* Registers held by the model */
+	uint8_t  Dll;
+	uint8_t  Dlm;
+	uint16_t Ier;
+	uint8_t  Lcr;
+	uint8_t  Fcr;
+	uint8_t  Fdr;
+	uint8_t  LineStatus;		/* OE until LSR is read */
+	bool     ThrePending;
+	bool     TimeoutPending;
+
+	/* FIFOs and shift register */
+	uint8_t  RxData[FIFO_DEPTH];
+	uint8_t  RxError[FIFO_DEPTH];
+	uint8_t  RxHead;
+	uint8_t  RxCount;
+	uint8_t  TxData[FIFO_DEPTH];
+	uint8_t  TxHead;
+	uint8_t  TxCount;
+	bool     Shifting;
+	uint8_t  ShiftData;
+	uint64_t ShiftEnd;
+	uint64_t RxActivity;		/* last character received or read, for the character timeout */
+	uint64_t CharNs;			/* character time, 0 while the divisor latch is 0 */
+
+	/* Remote end */
+	uint32_t RemoteBaud;
+	bool     Loopback;
+	void   (*Sink)(uint8_t Port, uint8_t Data);
+	uint8_t  Line[LINE_QUEUE];
+	uint32_t LineHead;			/* written by the bench thread */
+	uint32_t LineTail;			/* written by the slices */
+	uint64_t LineFree;			/* end of the last character the remote sent */
+	bool     LineIdle;			/* nothing was queued at the end of the last slice */
+
+	uint8_t  DmaFaults;			/* failures asked for by UartSim_FailDma(), DMA_FAULT_* */
+
+	UartSim_Stats_t Stats;
+} Port_t;
+
+extern uint32_t SystemCoreClock;
+
+extern void UART0_IRQHandler(void) __attribute__((weak));
+extern void UART1_IRQHandler(void) __attribute__((weak));
+extern void UART2_IRQHandler(void) __attribute__((weak));
+extern void UART3_IRQHandler(void) __attribute__((weak));
+extern void DMA_IRQHandler(void) __attribute__((weak));
+
+static void (* const PortHandlers[UARTSIM_PORTS])(void) = {
+	UART0_IRQHandler, UART1_IRQHandler, UART2_IRQHandler, UART3_IRQHandler,
+};
+
+/* The code under test's view of the peripherals, see LPC17xx.h */
+LPC_UART_TypeDef   *UartSim_Ports[UARTSIM_PORTS];
+LPC_GPDMA_TypeDef  *UartSim_Gpdma;
+LPC_SC_TypeDef      UartSim_SC;
+LPC_PINCON_TypeDef  UartSim_PINCON;
+
+static volatile uint32_t *RegisterFile;
+static Port_t            Ports[UARTSIM_PORTS];
+static uint32_t          DmaRawTC;
+static uint32_t          DmaRawErr;
+static uint32_t          DmaEnabled;
+static uint64_t          DmaInterrupts;
+static volatile uint64_t NvicEnabled;
+static uint64_t          ModelTime;
+static bool              Replaying;
+
+/*==========================================================================*/
+/* Line timing                                                             */
+/*==========================================================================*/
+static uint32_t PeripheralClock(uint8_t Port)
+{
+	static const uint8_t Dividers[4] = {4, 1, 2, 8};
+	uint32_t Select;
+
+	switch (Port)
+	{
+	case 0:  Select = UartSim_SC.PCLKSEL0 >> 6;  break;
+	case 1:  Select = UartSim_SC.PCLKSEL0 >> 8;  break;
+	case 2:  Select = UartSim_SC.PCLKSEL1 >> 16; break;
+	default: Select = UartSim_SC.PCLKSEL1 >> 18; break;
+	}
+	return SystemCoreClock / Dividers[Select & 3];
+}
+
+static double BaudRate(uint8_t Port)
+{
+	Port_t  *P = &Ports[Port];
+	uint32_t Divisor = (P->Dlm << 8) | P->Dll;
+	uint32_t DivAdd  = P->Fdr & 0x0F;
+	uint32_t Mul     = P->Fdr >> 4;
+
+	if (Divisor == 0)
+		return 0;
+	if (Mul == 0)
+		Mul = 1;
+	return PeripheralClock(Port) / (16.0 * Divisor * (1.0 + ((double) DivAdd / Mul)));
+}
+
+/* Start, data, parity and stop bits of a character */
+static uint32_t FrameBits(uint8_t Lcr)
+{
+	uint32_t Bits = 1 + 5 + (Lcr & 3) + 1;
+
+	if (Lcr & LCR_PARITY_ENABLE)
+		Bits++;
+	if (Lcr & LCR_TWO_STOP_BITS)
+		Bits++;
+	return Bits;
+}
+
+static void UpdateTiming(uint8_t Port)
+{
+	Port_t *P = &Ports[Port];
+	double  Baud = BaudRate(Port);
+
+	P->CharNs = Baud ? (uint64_t) ((FrameBits(P->Lcr) * 1e9 / Baud) + 0.5) : 0;
+}
+
+static uint64_t RemoteCharNs(Port_t *P)
+{
+	return (uint64_t) ((FrameBits(P->Lcr) * 1e9 / P->RemoteBaud) + 0.5);
+}
+
+/* Virtual time of an access: the event being replayed, or the interpolated time of the slice */
+static uint64_t Now(void)
+{
+	uint64_t Time;
+
+	if (Replaying)
+		return ModelTime;
+	Time = DcdSim_GetTime();
+	return (Time > ModelTime) ? Time : ModelTime;
+}
+
+/*==========================================================================*/
+/* FIFOs                                                                   */
+/*==========================================================================*/
+static uint8_t TriggerLevel(Port_t *P)
+{
+	static const uint8_t Levels[4] = {1, 4, 8, 14};
+
+	return Levels[P->Fcr >> 6];
+}
+
+/* The next character moves from the FIFO into the shift register */
+static void StartShift(Port_t *P, uint64_t Time)
+{
+	P->ShiftData = P->TxData[P->TxHead];
+	P->TxHead = (P->TxHead + 1) % FIFO_DEPTH;
+	P->TxCount--;
+	P->Shifting = true;
+	P->ShiftEnd = Time + P->CharNs;
+	if (P->TxCount == 0)
+		P->ThrePending = true;
+}
+
+static void PushTx(Port_t *P, uint8_t Data, uint64_t Time)
+{
+	if (P->TxCount == FIFO_DEPTH)
+		return;					/* written to a full FIFO: lost */
+
+	P->TxData[(P->TxHead + P->TxCount) % FIFO_DEPTH] = Data;
+	P->TxCount++;
+	P->ThrePending = false;
+	if (!P->Shifting && P->CharNs)
+		StartShift(P, Time);
+}
+
+static uint8_t PopRx(Port_t *P, uint64_t Time)
+{
+	uint8_t Data;
+
+	if (P->RxCount == 0)
+		return 0;
+
+	Data = P->RxData[P->RxHead];
+	P->RxHead = (P->RxHead + 1) % FIFO_DEPTH;
+	P->RxCount--;
+	P->RxActivity = Time;
+	P->TimeoutPending = false;
+	return Data;
+}
+
+static void Receive(Port_t *P, uint8_t Data, uint8_t Error, uint64_t Time)
+{
+	uint8_t Slot;
+
+	P->RxActivity = Time;
+	if (P->RxCount == FIFO_DEPTH)
+	{
+		P->LineStatus |= LSR_OE;
+		P->Stats.Overruns++;
+		return;
+	}
+
+	Slot = (P->RxHead + P->RxCount) % FIFO_DEPTH;
+	P->RxData[Slot]  = Data;
+	P->RxError[Slot] = Error;
+	P->RxCount++;
+	P->Stats.Received++;
+	if (Error)
+		P->Stats.FramingErrors++;
+}
+
+static uint8_t LineStatus(Port_t *P)
+{
+	uint8_t Status = P->LineStatus;
+	uint8_t i;
+
+	if (P->RxCount)
+		Status |= LSR_RDR | P->RxError[P->RxHead];
+	if (P->TxCount == 0)
+		Status |= LSR_THRE;
+	if ((P->TxCount == 0) && !P->Shifting)
+		Status |= LSR_TEMT;
+	for (i = 0; i < P->RxCount; i++)
+	{
+		if (P->RxError[(P->RxHead + i) % FIFO_DEPTH])
+			Status |= LSR_RXFE;
+	}
+	return Status;
+}
+
+static uint8_t InterruptId(Port_t *P)
+{
+	if ((P->Ier & IER_RLS_INT) && ((P->LineStatus & LSR_OE) || (P->RxCount && P->RxError[P->RxHead])))
+		return IIR_RLS;
+	if ((P->Ier & IER_RBR_INT) && (P->RxCount >= TriggerLevel(P)))
+		return IIR_RDA;
+	if ((P->Ier & IER_RBR_INT) && P->TimeoutPending)
+		return IIR_CTI;
+	if ((P->Ier & IER_THRE_INT) && P->ThrePending)
+		return IIR_THRE;
+	return IIR_NONE;
+}
+
+/*==========================================================================*/
+/* GPDMA                                                                   */
+/*==========================================================================*/
+static void UpdateDmaStatus(void)
+{
+	uint32_t TCMask = 0, ErrMask = 0;
+	uint8_t  Ch;
+
+	for (Ch = 0; Ch < GPDMA_CHANNELS; Ch++)
+	{
+		if (CHANNEL_REG(Ch, DMACCConfig) & DMA_CONFIG_ITC)
+			TCMask |= (1UL << Ch);
+		if (CHANNEL_REG(Ch, DMACCConfig) & DMA_CONFIG_IE)
+			ErrMask |= (1UL << Ch);
+	}
+
+	DMA_REG(DMACRawIntTCStat)  = DmaRawTC;
+	DMA_REG(DMACRawIntErrStat) = DmaRawErr;
+	DMA_REG(DMACIntTCStat)     = DmaRawTC & TCMask;
+	DMA_REG(DMACIntErrStat)    = DmaRawErr & ErrMask;
+	DMA_REG(DMACIntStat)       = (DmaRawTC & TCMask) | (DmaRawErr & ErrMask);
+	DMA_REG(DMACEnbldChns)     = DmaEnabled;
+}
+
+/* Terminal count: the next linked list item is loaded, or the channel stops */
+static void FinishDescriptor(uint8_t Ch)
+{
+	uint32_t Lli = CHANNEL_REG(Ch, DMACCLLI) & ~3UL;
+	const uint32_t *Item;
+
+	if (CHANNEL_REG(Ch, DMACCControl) & DMA_CONTROL_I)
+		DmaRawTC |= (1UL << Ch);
+
+	if (Lli)
+	{
+		Item = (const uint32_t *) (uintptr_t) Lli;
+		CHANNEL_REG(Ch, DMACCSrcAddr)  = Item[0];
+		CHANNEL_REG(Ch, DMACCDestAddr) = Item[1];
+		CHANNEL_REG(Ch, DMACCLLI)      = Item[2];
+		CHANNEL_REG(Ch, DMACCControl)  = Item[3];
+	}
+	else
+	{
+		CHANNEL_REG(Ch, DMACCConfig) &= ~DMA_CONFIG_ENABLE;
+		DmaEnabled &= ~(1UL << Ch);
+	}
+}
+
+/* A failure UartSim_FailDma() asked for: the channel stops with an error */
+static bool FailTransfer(Port_t *P, uint8_t Ch, uint8_t Fault)
+{
+	if (!(__atomic_fetch_and(&P->DmaFaults, (uint8_t) ~Fault, __ATOMIC_ACQ_REL) & Fault))
+		return false;
+
+	DmaRawErr |= (1UL << Ch);
+	CHANNEL_REG(Ch, DMACCConfig) &= ~DMA_CONFIG_ENABLE;
+	DmaEnabled &= ~(1UL << Ch);
+	return true;
+}
+
+/* Moves the bytes the UART requests, for a channel with a UART as its peripheral */
+static void ServiceChannel(uint8_t Ch, uint64_t Time)
+{
+	uint32_t Config, Control, Peripheral, Flow, Address;
+	bool     IsTransmit;
+	Port_t  *P;
+
+	while ((DmaEnabled & (1UL << Ch)) && (DMA_REG(DMACConfig) & 1))
+	{
+		Config  = CHANNEL_REG(Ch, DMACCConfig);
+		Control = CHANNEL_REG(Ch, DMACCControl);
+		Flow    = DMA_CONFIG_FLOW(Config);
+		Peripheral = (Flow == DMA_FLOW_M2P) ? DMA_CONFIG_DEST_PERIPHERAL(Config) : DMA_CONFIG_SRC_PERIPHERAL(Config);
+
+		if ((Config & DMA_CONFIG_HALT) ||
+			(Peripheral < DMA_PERIPHERAL_UART0_TX) || (Peripheral > DMA_PERIPHERAL_UART3_RX) ||
+			(UartSim_SC.DMAREQSEL & (1UL << (Peripheral - DMA_PERIPHERAL_UART0_TX))))
+			return;
+
+		P = &Ports[(Peripheral - DMA_PERIPHERAL_UART0_TX) / 2];
+		IsTransmit = ((Peripheral & 1) == 0);
+		if ((P->Fcr & (FCR_FIFO_ENABLE | FCR_DMA_MODE)) != (FCR_FIFO_ENABLE | FCR_DMA_MODE))
+			return;
+
+		if (IsTransmit && (Flow == DMA_FLOW_M2P))
+		{
+			if ((P->TxCount < FIFO_DEPTH) && FailTransfer(P, Ch, DMA_FAULT_TX))
+				return;
+
+			while ((Control & DMA_CONTROL_SIZE) && (P->TxCount < FIFO_DEPTH))
+			{
+				Address = CHANNEL_REG(Ch, DMACCSrcAddr);
+				PushTx(P, *(const uint8_t *) (uintptr_t) Address, Time);
+				if (Control & DMA_CONTROL_SI)
+					CHANNEL_REG(Ch, DMACCSrcAddr) = Address + 1;
+				Control--;
+				P->Stats.DmaBytes++;
+			}
+		}
+		else if (!IsTransmit && (Flow == DMA_FLOW_P2M))
+		{
+			/* The receiver requests at the trigger level or on a character timeout */
+			if ((P->RxCount < TriggerLevel(P)) && !P->TimeoutPending)
+				return;
+			if (FailTransfer(P, Ch, DMA_FAULT_RX))
+				return;
+
+			while ((Control & DMA_CONTROL_SIZE) && P->RxCount)
+			{
+				Address = CHANNEL_REG(Ch, DMACCDestAddr);
+				*(uint8_t *) (uintptr_t) Address = PopRx(P, Time);
+				if (Control & DMA_CONTROL_DI)
+					CHANNEL_REG(Ch, DMACCDestAddr) = Address + 1;
+				Control--;
+				P->Stats.DmaBytes++;
+			}
+		}
+		else
+		{
+			return;
+		}
+
+		CHANNEL_REG(Ch, DMACCControl) = Control;
+		if (Control & DMA_CONTROL_SIZE)
+			return;
+		FinishDescriptor(Ch);
+	}
+}
+
+static void ServiceChannels(uint64_t Time)
+{
+	uint8_t Ch;
+
+	for (Ch = 0; Ch < GPDMA_CHANNELS; Ch++)
+		ServiceChannel(Ch, Time);
+	UpdateDmaStatus();
+}
+
+/*==========================================================================*/
+/* Interrupts                                                              */
+/*==========================================================================*/
+void NvicSim_EnableIRQ(IRQn_Type IRQn)
+{
+	__atomic_or_fetch(&NvicEnabled, 1ULL << IRQn, __ATOMIC_RELAXED);
+}
+
+void NvicSim_DisableIRQ(IRQn_Type IRQn)
+{
+	__atomic_and_fetch(&NvicEnabled, ~(1ULL << IRQn), __ATOMIC_RELAXED);
+}
+
+static bool IrqEnabled(IRQn_Type IRQn)
+{
+	return (NvicEnabled & (1ULL << IRQn)) != 0;
+}
+
+static void DeliverInterrupts(void)
+{
+	uint32_t Loops;
+	uint8_t  Port;
+
+	for (Port = 0; Port < UARTSIM_PORTS; Port++)
+	{
+		for (Loops = 0; (Loops < MAX_IRQ_LOOPS) && PortHandlers[Port] && IrqEnabled(UART0_IRQn + Port) &&
+						(InterruptId(&Ports[Port]) != IIR_NONE); Loops++)
+		{
+			Ports[Port].Stats.Interrupts++;
+			PortHandlers[Port]();
+			ServiceChannels(ModelTime);
+		}
+	}
+
+	for (Loops = 0; (Loops < MAX_IRQ_LOOPS) && DMA_IRQHandler && IrqEnabled(DMA_IRQn) && DMA_REG(DMACIntStat); Loops++)
+	{
+		DmaInterrupts++;
+		DMA_IRQHandler();
+		ServiceChannels(ModelTime);
+	}
+}
+
+/*==========================================================================*/
+/* Events                                                                  */
+/*==========================================================================*/
+static uint32_t LineCount(Port_t *P)
+{
+	return __atomic_load_n(&P->LineHead, __ATOMIC_ACQUIRE) - P->LineTail;
+}
+
+/* Earliest event of the port, with its time */
+static Event_t NextEvent(Port_t *P, uint64_t *Time)
+{
+	Event_t  Event = EVENT_NONE;
+	uint64_t When;
+
+	*Time = UINT64_MAX;
+	if (P->Shifting)
+	{
+		*Time = P->ShiftEnd;
+		Event = EVENT_TX_DONE;
+	}
+
+	if (!P->Loopback && P->RemoteBaud && LineCount(P))
+	{
+		When = P->LineFree + RemoteCharNs(P);
+		if (When < *Time)
+		{
+			*Time = When;
+			Event = EVENT_RX_DONE;
+		}
+	}
+
+	if (P->RxCount && !P->TimeoutPending && P->CharNs)
+	{
+		When = P->RxActivity + (TIMEOUT_CHARACTERS * P->CharNs);
+		if (When < *Time)
+		{
+			*Time = When;
+			Event = EVENT_TIMEOUT;
+		}
+	}
+	return Event;
+}
+
+static void RunEvent(uint8_t Port, Event_t Event, uint64_t Time)
+{
+	Port_t *P = &Ports[Port];
+	double  Local, Error;
+	uint8_t Data;
+
+	switch (Event)
+	{
+	case EVENT_TX_DONE:
+		Data = P->ShiftData;
+		P->Shifting = false;
+		P->Stats.Sent++;
+		if (P->Loopback)
+			Receive(P, Data, 0, Time);
+		else if (P->Sink)
+			P->Sink(Port, Data);
+		if (P->TxCount && P->CharNs)
+			StartShift(P, Time);
+		break;
+
+	case EVENT_RX_DONE:
+		Data = P->Line[P->LineTail % LINE_QUEUE];
+		__atomic_store_n(&P->LineTail, P->LineTail + 1, __ATOMIC_RELEASE);
+		P->LineFree = Time;
+
+		/* The receiver samples mid-bit from the start bit edge: too large a rate error misses the stop bit */
+		Local = BaudRate(Port);
+		Error = Local ? ((double) P->RemoteBaud / Local) - 1.0 : 1.0;
+		Receive(P, Data, ((Error > FRAMING_TOLERANCE) || (Error < -FRAMING_TOLERANCE)) ? LSR_FE : 0, Time);
+		break;
+
+	case EVENT_TIMEOUT:
+		P->TimeoutPending = true;
+		break;
+
+	default:
+		break;
+	}
+}
+
+/* Replays the events up to the start of the slice in time order */
+static void SliceHook(uint64_t Time)
+{
+	Event_t  Event, Earliest;
+	uint64_t When, EarliestTime;
+	uint8_t  Port, EarliestPort = 0;
+
+	Replaying = true;
+
+	/* Characters queued on an idle line start at the earliest at the start of the slice */
+	for (Port = 0; Port < UARTSIM_PORTS; Port++)
+	{
+		if (Ports[Port].LineIdle && (Ports[Port].LineFree < ModelTime))
+			Ports[Port].LineFree = ModelTime;
+	}
+
+	for (;;)
+	{
+		Earliest = EVENT_NONE;
+		EarliestTime = UINT64_MAX;
+		for (Port = 0; Port < UARTSIM_PORTS; Port++)
+		{
+			Event = NextEvent(&Ports[Port], &When);
+			if ((Event != EVENT_NONE) && (When < EarliestTime))
+			{
+				Earliest = Event;
+				EarliestTime = When;
+				EarliestPort = Port;
+			}
+		}
+		if ((Earliest == EVENT_NONE) || (EarliestTime > Time))
+			break;
+
+		ModelTime = (EarliestTime > ModelTime) ? EarliestTime : ModelTime;
+		RunEvent(EarliestPort, Earliest, ModelTime);
+		ServiceChannels(ModelTime);
+		DeliverInterrupts();
+	}
+
+	ModelTime = (Time > ModelTime) ? Time : ModelTime;
+	ServiceChannels(ModelTime);
+	DeliverInterrupts();
+
+	for (Port = 0; Port < UARTSIM_PORTS; Port++)
+		Ports[Port].LineIdle = (LineCount(&Ports[Port]) == 0);
+
+	Replaying = false;
+}
+
+/*==========================================================================*/
+/* Registers                                                               */
+/*==========================================================================*/
+static void DmaRegisterWrite(uint32_t Offset, uint32_t Value)
+{
+	volatile uint32_t *Word = &RegisterFile[((GPDMA_PAGE * PAGE_BYTES) + Offset) / 4];
+	uint32_t Old = *Word;
+	uint8_t  Ch;
+
+	if (Offset == DMA_OFFSET(DMACIntTCClear))
+	{
+		DmaRawTC &= ~Value;
+	}
+	else if (Offset == DMA_OFFSET(DMACIntErrClr))
+	{
+		DmaRawErr &= ~Value;
+	}
+	else if ((Offset >= CHANNEL_BASE) && (Offset < CHANNEL_BASE + (GPDMA_CHANNELS * CHANNEL_STRIDE)))
+	{
+		Ch = (Offset - CHANNEL_BASE) / CHANNEL_STRIDE;
+		*Word = Value;
+		if (((Offset - CHANNEL_BASE) % CHANNEL_STRIDE) == CHANNEL_OFFSET(DMACCConfig))
+		{
+			if ((Value & DMA_CONFIG_ENABLE) && !(Old & DMA_CONFIG_ENABLE))
+			{
+				DmaEnabled |= (1UL << Ch);
+				ServiceChannel(Ch, Now());
+			}
+			else if (!(Value & DMA_CONFIG_ENABLE))
+			{
+				DmaEnabled &= ~(1UL << Ch);
+			}
+		}
+	}
+	else
+	{
+		*Word = Value;
+	}
+
+	UpdateDmaStatus();
+}
+
+static void RegisterWrite(uint32_t Offset, uint32_t Value)
+{
+	uint32_t Page = Offset / PAGE_BYTES;
+	uint32_t Reg  = Offset % PAGE_BYTES;
+	Port_t  *P = &Ports[Page % UARTSIM_PORTS];
+
+	if (Page == GPDMA_PAGE)
+	{
+		DmaRegisterWrite(Reg, Value);
+		return;
+	}
+
+	switch (Reg)
+	{
+	case UART_OFFSET(THR):
+		if (P->Lcr & LCR_DLAB)
+		{
+			P->Dll = Value;
+			UpdateTiming(Page);
+		}
+		else
+		{
+			PushTx(P, Value, Now());
+		}
+		break;
+
+	case UART_OFFSET(IER):
+		if (P->Lcr & LCR_DLAB)
+		{
+			P->Dlm = Value;
+			UpdateTiming(Page);
+		}
+		else
+		{
+			/* Enabling the THRE interrupt with an empty FIFO raises it */
+			if ((Value & IER_THRE_INT) && !(P->Ier & IER_THRE_INT) && (P->TxCount == 0))
+				P->ThrePending = true;
+			P->Ier = Value & IER_KEPT;
+		}
+		break;
+
+	case UART_OFFSET(FCR):
+		if (Value & FCR_RX_RESET)
+		{
+			P->RxCount = 0;
+			P->TimeoutPending = false;
+		}
+		if (Value & FCR_TX_RESET)
+			P->TxCount = 0;
+		P->Fcr = Value & FCR_KEPT;
+		break;
+
+	case UART_OFFSET(LCR):
+		P->Lcr = Value;
+		UpdateTiming(Page);
+		break;
+
+	case UART_OFFSET(FDR):
+		P->Fdr = Value;
+		UpdateTiming(Page);
+		break;
+
+	default:
+		RegisterFile[Offset / 4] = Value;
+		break;
+	}
+}
+
+/* Registers whose value is produced by the read itself */
+static void RegisterRead(uint32_t Offset)
+{
+	uint32_t Page = Offset / PAGE_BYTES;
+	uint32_t Reg  = Offset % PAGE_BYTES;
+	Port_t  *P = &Ports[Page % UARTSIM_PORTS];
+	volatile uint32_t *Word = &RegisterFile[Offset / 4];
+	uint8_t  Id;
+
+	if (Page == GPDMA_PAGE)
+	{
+		UpdateDmaStatus();
+		return;
+	}
+
+	switch (Reg)
+	{
+	case UART_OFFSET(RBR):
+		*Word = (P->Lcr & LCR_DLAB) ? P->Dll : PopRx(P, Now());
+		break;
+
+	case UART_OFFSET(IER):
+		*Word = (P->Lcr & LCR_DLAB) ? P->Dlm : P->Ier;
+		break;
+
+	case UART_OFFSET(IIR):
+		Id = InterruptId(P);
+		if (Id == IIR_THRE)
+			P->ThrePending = false;
+		*Word = Id | ((P->Fcr & FCR_FIFO_ENABLE) ? IIR_FIFOS_ENABLED : 0);
+		break;
+
+	case UART_OFFSET(LCR):
+		*Word = P->Lcr;
+		break;
+
+	case UART_OFFSET(LSR):
+		*Word = LineStatus(P);
+		P->LineStatus = 0;
+		break;
+
+	case UART_OFFSET(FDR):
+		*Word = P->Fdr;
+		break;
+
+	case UART_OFFSET(FIFOLVL):
+		*Word = P->RxCount | (P->TxCount << 8);
+		break;
+
+	default:
+		break;
+	}
+}
+
+/*==========================================================================*/
+/* Public API                                                              */
+/*==========================================================================*/
+bool UartSim_Init(void)
+{
+	uint8_t *Registers;
+	uint8_t  Port;
+
+	memset(Ports, 0, sizeof(Ports));
+	Registers = DcdSim_MapRegisters((UARTSIM_PORTS + 1) * PAGE_BYTES, &RegisterFile, RegisterRead, RegisterWrite);
+	if (Registers == NULL)
+		return false;
+
+	for (Port = 0; Port < UARTSIM_PORTS; Port++)
+	{
+		UartSim_Ports[Port] = (LPC_UART_TypeDef *) (Registers + (Port * PAGE_BYTES));
+		Ports[Port].Fdr = 0x10;							/* reset value: MULVAL 1, DIVADDVAL 0 */
+		Ports[Port].Dll = 1;
+		RegisterFile[((Port * PAGE_BYTES) + UART_OFFSET(TER)) / 4] = 0x80;
+		UpdateTiming(Port);
+	}
+	UartSim_Gpdma = (LPC_GPDMA_TypeDef *) (Registers + (GPDMA_PAGE * PAGE_BYTES));
+
+	DcdSim_SetSliceHook(SliceHook);
+	return true;
+}
+
+void UartSim_Connect(uint8_t Port, uint32_t Baud, bool Loopback, void (*Sink)(uint8_t Port, uint8_t Data))
+{
+	Ports[Port].RemoteBaud = Baud;
+	Ports[Port].Loopback   = Loopback;
+	Ports[Port].Sink       = Sink;
+}
+
+uint32_t UartSim_Send(uint8_t Port, const void *Data, uint32_t Length)
+{
+	Port_t  *P = &Ports[Port];
+	uint32_t Head = P->LineHead;
+	uint32_t Free = LINE_QUEUE - (Head - __atomic_load_n(&P->LineTail, __ATOMIC_ACQUIRE));
+	uint32_t i;
+
+	if (Length > Free)
+		Length = Free;
+	for (i = 0; i < Length; i++)
+		P->Line[(Head + i) % LINE_QUEUE] = ((const uint8_t *) Data)[i];
+
+	__atomic_store_n(&P->LineHead, Head + Length, __ATOMIC_RELEASE);
+	return Length;
+}
+
+uint32_t UartSim_Pending(uint8_t Port)
+{
+	return LineCount(&Ports[Port]);
+}
+
+double UartSim_GetBaudRate(uint8_t Port)
+{
+	return BaudRate(Port);
+}
+
+void UartSim_GetStats(uint8_t Port, UartSim_Stats_t *Stats)
+{
+	*Stats = Ports[Port].Stats;
+}
+
+uint64_t UartSim_GetDmaInterrupts(void)
+{
+	return DmaInterrupts;
+}
+
+void UartSim_FailDma(uint8_t Port, bool Receive)
+{
+	__atomic_or_fetch(&Ports[Port].DmaFaults, Receive ? DMA_FAULT_RX : DMA_FAULT_TX, __ATOMIC_ACQ_REL);
+}
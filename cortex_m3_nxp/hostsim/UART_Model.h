@@ -0,0 +1,80 @@
+/*
+ * UART_Model.h
+ *
+ * Software model of the LPC17xx UARTs 0 to 3 and of the GPDMA controller, for
+ * running src/uart.c and the code above it as a Linux process next to the
+ * device controller model (DCD_Model.h). The registers are trapped through
+ * DcdSim_MapRegisters(); LPC17xx.h redirects LPC_UARTn, LPC_GPDMA and
+ * LPC_GPDMACHn to them, LPC_SC and LPC_PINCON to plain memory and
+ * NVIC_EnableIRQ()/NVIC_DisableIRQ() to the model.
+ *
+ * Time follows the DCD model: at every slice the model replays the events of
+ * the slice in virtual time order. Characters leave the transmit FIFO and
+ * arrive in the 16 byte receive FIFO at the rate set by the divisor latch, the
+ * fractional divider, the line control register and the PCLK of the port, the
+ * receive FIFO overruns, the character timeout fires, the GPDMA channels move
+ * bytes on the UART DMA requests (LLI chaining, terminal count and the error
+ * interrupt of a failed transfer included),
+ * and the interrupt handlers (UARTn_IRQHandler, DMA_IRQHandler) are called at
+ * the event that raised their interrupt, while the NVIC enable is set. Register
+ * accesses of the code under test see the state of the last slice, except
+ * that THR writes and channel enables take effect at once.
+ *
+ * The remote end of each UART is the bench: it gets the characters sent and
+ * sends characters at its own baud rate, or the port is looped back. A remote
+ * rate more than 4% off the UART's gives framing errors. Modem lines, break,
+ * auto-baud, IrDA and RS-485 are not modelled.
+ */
+
+#ifndef HOSTSIM_UART_MODEL_H_
+#define HOSTSIM_UART_MODEL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define UARTSIM_PORTS				4
+
+typedef struct {
+	uint64_t Sent;				/* characters shifted out */
+	uint64_t Received;			/* characters put into the receive FIFO */
+	uint64_t Overruns;			/* characters lost on a full receive FIFO */
+	uint64_t FramingErrors;		/* characters received with a framing error */
+	uint64_t Interrupts;		/* calls into the UART interrupt handler */
+	uint64_t DmaBytes;			/* bytes the GPDMA moved to or from the FIFOs */
+} UartSim_Stats_t;
+
+/* Maps the registers and hooks the slices of the DCD model. SystemCoreClock
+ * must be set before, PCLKSEL is read at each divisor change.
+ */
+bool UartSim_Init(void);
+
+/* The remote end of Port. Sink (optional) gets each character the UART sends,
+ * when its stop bit ends; Baud is the rate the remote sends at. A looped back
+ * port receives its own characters instead, at its own rate.
+ */
+void UartSim_Connect(uint8_t Port, uint32_t Baud, bool Loopback, void (*Sink)(uint8_t Port, uint8_t Data));
+
+/* Queues characters for the remote to send, back to back from the next slice
+ * on. Returns how many fitted in the queue of the line. Not for looped back
+ * ports; one thread per port.
+ */
+uint32_t UartSim_Send(uint8_t Port, const void *Data, uint32_t Length);
+
+/* Characters still queued on the line to the UART */
+uint32_t UartSim_Pending(uint8_t Port);
+
+/* Rate the UART's divisors give, in bits per second, 0 if they are not set */
+double UartSim_GetBaudRate(uint8_t Port);
+
+void UartSim_GetStats(uint8_t Port, UartSim_Stats_t *Stats);
+
+/* Calls into DMA_IRQHandler, for all channels */
+uint64_t UartSim_GetDmaInterrupts(void);
+
+/* The next transfer of the GPDMA channel serving the transmitter (Receive
+ * false) or the receiver of Port fails with a bus error: the channel stops
+ * without moving the byte and its error interrupt is raised.
+ */
+void UartSim_FailDma(uint8_t Port, bool Receive);
+
+#endif /* HOSTSIM_UART_MODEL_H_ */
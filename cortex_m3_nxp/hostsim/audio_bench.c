@@ -0,0 +1,301 @@
+/*
+ * audio_bench.c
+ *
+ * Isochronous audio streaming test without hardware. Two Audio host class
+ * instances (AudioClassHost.c) stream from and to the virtual Audio 1.0 device
+ * (Audio_Device.c) through the OHCI model, capture on one streaming interface
+ * and asynchronous playback with explicit feedback on the other. The
+ * application side takes every block of the FIFOs with a random stall, as if
+ * it was writing the capture to an SD card, so the run shows how much latency
+ * the double buffer absorbs before samples are lost.
+ *
+ * Build on x86-64 Linux, from cortex_m3_nxp/:
+ *
+ *   gcc -std=gnu99 -O2 -no-pie -fno-pie \
+ *       -D__LPC17XX__ -D__CODE_RED -DUSB_HOST_ONLY -DUSE_FREERTOS_DELAY=0 \
+ *       -Ihostsim -I../CMSIS_CORE_LPC17xx/inc \
+ *       -Ilpcusblib/Drivers/USB -Ilpcusblib/Drivers/USB/Class/Host \
+ *       hostsim/audio_bench.c hostsim/Audio_Device.c hostsim/OHCI_Model.c hostsim/HAL_Sim.c \
+ *       lpcusblib/Drivers/USB/Core/[A-Z]*.c lpcusblib/Drivers/USB/Core/LPC/[A-Z]*.c \
+ *       lpcusblib/Drivers/USB/Core/LPC/HCD/HCD.c lpcusblib/Drivers/USB/Core/LPC/HCD/OHCI/OHCI.c \
+ *       lpcusblib/Drivers/USB/Class/Host/AudioClassHost.c \
+ *       -o audio_bench
+ *
+ * Usage: audio_bench [-s seconds] [-f FIFO bytes] [-w max stall ms] [-c capture ppm] [-p playback ppm] [-t us per frame]
+ *
+ * Unlike msc_bench the application loop must keep up with the frames in wall
+ * clock time: frame periods much below the default 1000 us starve it and show
+ * up as overruns and underruns.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "USB.h"
+#include "AudioClassHost.h"
+
+#include "OHCI_Model.h"
+#include "Audio_Device.h"
+
+#define ENUMERATION_TIMEOUT_FRAMES		10000
+
+static USB_ClassInfo_Audio_Host_t Capture_Audio_Interface = {
+	.Config = {
+		.DataINPipeNumber   = 1,
+		.DataOUTPipeNumber  = 0,
+		.FeedbackPipeNumber = 0,
+		.PortNumber = 0,
+	},
+};
+
+static USB_ClassInfo_Audio_Host_t Playback_Audio_Interface = {
+	.Config = {
+		.DataINPipeNumber   = 0,
+		.DataOUTPipeNumber  = 2,
+		.FeedbackPipeNumber = 3,
+		.PortNumber = 0,
+	},
+};
+
+static Audio_Device_t VirtualAudio;
+static volatile bool Enumerated;
+static volatile bool EnumerationError;
+
+static Audio_Host_Stream_t CaptureStream;
+static Audio_Host_Stream_t PlaybackStream;
+static uint32_t CaptureExpected;
+static uint64_t CaptureSamples;
+static uint64_t CaptureGaps;
+static uint32_t PlaybackIndex;
+
+/*==========================================================================*/
+/* Host stack events                                                       */
+/*==========================================================================*/
+void EVENT_USB_Host_DeviceEnumerationComplete(const uint8_t corenum)
+{
+	uint16_t ConfigDescriptorSize;
+	uint8_t  ConfigDescriptorData[512];
+
+	if (USB_Host_GetDeviceConfigDescriptor(corenum, 1, &ConfigDescriptorSize, ConfigDescriptorData,
+										   sizeof(ConfigDescriptorData)) != HOST_GETCONFIG_Successful) {
+		printf("Error Retrieving Configuration Descriptor.\n");
+		EnumerationError = true;
+		return;
+	}
+
+	if ((Audio_Host_ConfigurePipes(&Capture_Audio_Interface, ConfigDescriptorSize, ConfigDescriptorData) != AUDIO_ENUMERROR_NoError) ||
+		(Audio_Host_ConfigurePipes(&Playback_Audio_Interface, ConfigDescriptorSize, ConfigDescriptorData) != AUDIO_ENUMERROR_NoError)) {
+		printf("Attached Device Not a Valid Audio Device.\n");
+		EnumerationError = true;
+		return;
+	}
+
+	if (USB_Host_SetDeviceConfiguration(corenum, 1) != HOST_SENDCONTROL_Successful) {
+		printf("Error Setting Device Configuration.\n");
+		EnumerationError = true;
+		return;
+	}
+
+	Enumerated = true;
+}
+
+void EVENT_USB_Host_HostError(const uint8_t corenum, const uint8_t ErrorCode)
+{
+	printf("Host Mode Error %d on port %d\n", ErrorCode, corenum);
+	EnumerationError = true;
+}
+
+void EVENT_USB_Host_DeviceEnumerationFailed(const uint8_t corenum,
+											const uint8_t ErrorCode,
+											const uint8_t SubErrorCode)
+{
+	printf("Dev Enum Error %d/%d on port %d in state %d\n", ErrorCode, SubErrorCode, corenum, USB_HostState[corenum]);
+	EnumerationError = true;
+}
+
+/*==========================================================================*/
+/* Application side of the FIFOs                                           */
+/*==========================================================================*/
+static void VerifyCapture(const uint8_t *Block, uint16_t Length)
+{
+	uint32_t Sample;
+	uint16_t i;
+
+	for (i = 0; i < Length; i += AUDIO_DEVICE_FRAME_SIZE)
+	{
+		Sample = Block[i] | (Block[i + 1] << 8) | (Block[i + 2] << 16) | ((uint32_t) Block[i + 3] << 24);
+		if (CaptureSamples && (Sample != CaptureExpected))
+			CaptureGaps++;
+		CaptureExpected = Sample + 1;
+		CaptureSamples++;
+	}
+}
+
+static void FillPlayback(uint8_t *Block, uint16_t Length)
+{
+	uint16_t i;
+
+	for (i = 0; i < Length; i += AUDIO_DEVICE_FRAME_SIZE)
+	{
+		Block[i]     = PlaybackIndex;
+		Block[i + 1] = PlaybackIndex >> 8;
+		Block[i + 2] = PlaybackIndex >> 16;
+		Block[i + 3] = PlaybackIndex >> 24;
+		PlaybackIndex++;
+	}
+}
+
+static uint8_t StartStream(USB_ClassInfo_Audio_Host_t *Interface, uint8_t DataPipeIndex, Audio_Host_Stream_t *Stream, uint8_t *FIFO, uint16_t FIFOSize)
+{
+	uint8_t SampleRate[3] = {AUDIO_DEVICE_SAMPLE_RATE & 0xFF, (AUDIO_DEVICE_SAMPLE_RATE >> 8) & 0xFF, AUDIO_DEVICE_SAMPLE_RATE >> 16};
+
+	if ((Audio_Host_StartStopStreaming(Interface, true) != HOST_SENDCONTROL_Successful) ||
+		(Audio_Host_GetSetEndpointProperty(Interface, DataPipeIndex, AUDIO_REQ_SetCurrent, AUDIO_EPCONTROL_SamplingFreq,
+										   sizeof(SampleRate), SampleRate) != HOST_SENDCONTROL_Successful))
+	{
+		return AUDIO_STREAM_PipeError;
+	}
+
+	return Audio_Host_StartStream(Interface, DataPipeIndex, Stream, FIFO, FIFOSize, AUDIO_DEVICE_SAMPLE_RATE, AUDIO_DEVICE_FRAME_SIZE);
+}
+
+/*==========================================================================*/
+/* Main                                                                    */
+/*==========================================================================*/
+static bool EnumerateAudio(void)
+{
+	uint64_t Start = OhciSim_GetFrameNumber();
+
+	OhciSim_Attach(&VirtualAudio.Device);
+
+	while (!Enumerated && !EnumerationError)
+	{
+		USB_USBTask();
+
+		if ((OhciSim_GetFrameNumber() - Start) > ENUMERATION_TIMEOUT_FRAMES)
+		{
+			printf("Enumeration timed out in host state %d\n", USB_HostState[0]);
+			return false;
+		}
+	}
+
+	if (EnumerationError)
+		return false;
+
+	printf("Enumerated in %llu frames: capture pipe %u bytes, playback pipe %u bytes, feedback pipe %u bytes every %u ms\n",
+		   (unsigned long long) (OhciSim_GetFrameNumber() - Start), Capture_Audio_Interface.State.DataINPipeSize,
+		   Playback_Audio_Interface.State.DataOUTPipeSize, Playback_Audio_Interface.State.FeedbackPipeSize,
+		   1 << Playback_Audio_Interface.State.FeedbackRefresh);
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t Seconds = 10;
+	uint32_t FIFOSize = 4096;
+	uint32_t MaxStall = 8;
+	int32_t  CapturePPM = 300;
+	int32_t  PlaybackPPM = -500;
+	uint32_t FramePeriodUS = 1000;
+	uint64_t Start, End;
+	uint64_t CaptureBusy = 0, PlaybackBusy = 0;
+	uint64_t Frame;
+	uint8_t  *CaptureFIFO, *PlaybackFIFO, *Block;
+	uint8_t  ErrorCode;
+	int64_t  Level;
+	int Option;
+
+	while ((Option = getopt(argc, argv, "s:f:w:c:p:t:")) != -1)
+	{
+		switch (Option)
+		{
+		case 's': Seconds = atoi(optarg); break;
+		case 'f': FIFOSize = atoi(optarg); break;
+		case 'w': MaxStall = atoi(optarg); break;
+		case 'c': CapturePPM = atoi(optarg); break;
+		case 'p': PlaybackPPM = atoi(optarg); break;
+		case 't': FramePeriodUS = atoi(optarg); break;
+		default:
+			fprintf(stderr, "usage: %s [-s seconds] [-f FIFO bytes] [-w max stall ms] [-c capture ppm] [-p playback ppm] [-t us per frame]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	if ((FIFOSize < 2 * AUDIO_DEVICE_FRAME_SIZE) || (FIFOSize > 65532) || (FIFOSize % (2 * AUDIO_DEVICE_FRAME_SIZE)) || (FramePeriodUS < 1))
+	{
+		fprintf(stderr, "FIFO must be a multiple of %u bytes up to 64K, frame period at least 1 us\n", 2 * AUDIO_DEVICE_FRAME_SIZE);
+		return 2;
+	}
+
+	Audio_Device_Init(&VirtualAudio, CapturePPM, PlaybackPPM);
+	CaptureFIFO  = malloc(FIFOSize);
+	PlaybackFIFO = malloc(FIFOSize);
+
+	if ((CaptureFIFO == NULL) || (PlaybackFIFO == NULL) || !OhciSim_Init(FramePeriodUS))
+	{
+		fprintf(stderr, "cannot start the OHCI model\n");
+		return 1;
+	}
+
+	USB_Init();
+
+	if (!EnumerateAudio())
+		return 1;
+
+	srand(1);
+	FillPlayback(PlaybackFIFO, FIFOSize / 2);
+
+	if (((ErrorCode = StartStream(&Capture_Audio_Interface, 1, &CaptureStream, CaptureFIFO, FIFOSize)) != AUDIO_STREAM_NoError) ||
+		((ErrorCode = StartStream(&Playback_Audio_Interface, 2, &PlaybackStream, PlaybackFIFO, FIFOSize)) != AUDIO_STREAM_NoError))
+	{
+		printf("Cannot start the streams: error %u\n", ErrorCode);
+		return 1;
+	}
+
+	printf("%u s, %u byte FIFOs (%.1f ms per block), stalls up to %u ms, capture clock %+d ppm, playback clock %+d ppm\n\n",
+		   Seconds, FIFOSize, (FIFOSize / 2.0) / (AUDIO_DEVICE_SAMPLE_RATE / 1000 * AUDIO_DEVICE_FRAME_SIZE), MaxStall, CapturePPM, PlaybackPPM);
+
+	/* Each block taken keeps the application busy for a random number of frames, like a slow SD card write */
+	Start = OhciSim_GetFrameNumber();
+	End   = Start + (uint64_t) Seconds * 1000;
+	while ((Frame = OhciSim_GetFrameNumber()) < End)
+	{
+		if ((Frame >= CaptureBusy) && ((Block = Audio_Host_GetStreamBlock(&CaptureStream)) != NULL))
+		{
+			VerifyCapture(Block, CaptureStream.BlockSize);
+			Audio_Host_ReleaseStreamBlock(&CaptureStream);
+			CaptureBusy = Frame + (MaxStall ? (uint32_t) rand() % (MaxStall + 1) : 0);
+		}
+
+		if ((Frame >= PlaybackBusy) && ((Block = Audio_Host_GetStreamBlock(&PlaybackStream)) != NULL))
+		{
+			FillPlayback(Block, PlaybackStream.BlockSize);
+			Audio_Host_ReleaseStreamBlock(&PlaybackStream);
+			PlaybackBusy = Frame + (MaxStall ? (uint32_t) rand() % (MaxStall + 1) : 0);
+		}
+	}
+
+	Level = Audio_Device_GetPlaybackLevel(&VirtualAudio);
+	Audio_Host_StopStream(&CaptureStream);
+	Audio_Host_StopStream(&PlaybackStream);
+
+	printf("%-9s %9s %9s %9s %9s %9s %9s %s\n", "stream", "samples", "rate Hz", "overruns", "underruns", "lost", "gaps", "result");
+	printf("%-9s %9llu %9u %9u %9u %9u %9llu %s\n", "capture", (unsigned long long) CaptureSamples,
+		   Audio_Host_GetStreamSampleRate(&CaptureStream), CaptureStream.Overruns, CaptureStream.Underruns,
+		   CaptureStream.LostPackets, (unsigned long long) CaptureGaps,
+		   (CaptureGaps || CaptureStream.Overruns || CaptureStream.LostPackets) ? "GLITCHED" : "ok");
+	printf("%-9s %9llu %9u %9u %9u %9u %9llu %s\n", "playback", (unsigned long long) VirtualAudio.PlaybackReceived,
+		   Audio_Host_GetStreamSampleRate(&PlaybackStream), PlaybackStream.Overruns, PlaybackStream.Underruns,
+		   PlaybackStream.LostPackets, (unsigned long long) VirtualAudio.PlaybackGaps,
+		   (VirtualAudio.PlaybackGaps || VirtualAudio.PlaybackSilent || PlaybackStream.Underruns || PlaybackStream.LostPackets) ? "GLITCHED" : "ok");
+	printf("\nfeedback: %u updates taken of %llu sent; device playback FIFO level %lld frames at the end, %lld..%lld during the run\n",
+		   PlaybackStream.FeedbackUpdates, (unsigned long long) VirtualAudio.FeedbackPackets, (long long) Level,
+		   (long long) VirtualAudio.LevelMin, (long long) VirtualAudio.LevelMax);
+
+	OhciSim_Detach();
+	OhciSim_DeInit();
+	free(CaptureFIFO);
+	free(PlaybackFIFO);
+	return 0;
+}
@@ -0,0 +1,421 @@
+/*
+ * audiodev_bench.c
+ *
+ * USB speaker benchmark without hardware. The unmodified device stack (the
+ * LPC17xx DCD, AudioClassDevice.c and USBAudioDevice.c) runs against the
+ * device controller model (DCD_Model.c). A host thread enumerates the device,
+ * selects the streaming alternate setting and sets the sample rate as the
+ * audio driver of a PC does; then the host streams 48 kHz stereo, one packet
+ * per frame, sized from the rate the device asks for on its feedback endpoint.
+ * A DAC model takes the samples from the device a millisecond at a time at
+ * its own clock, offset from the bus by a number of ppm the way a crystal
+ * drifts, and checks that they come out complete and in order.
+ *
+ * Build on x86-64 Linux, from cortex_m3_nxp/:
+ *
+ *   gcc -std=gnu99 -O2 -no-pie -fno-pie \
+ *       -D__LPC17XX__ -D__CODE_RED -DUSB_DEVICE_ONLY -DUSE_FREERTOS_DELAY=0 \
+ *       -Wno-int-to-pointer-cast -Wno-pointer-to-int-cast \
+ *       -Ihostsim -I../CMSIS_CORE_LPC17xx/inc -Iinc \
+ *       -Ilpcusblib/Drivers/USB -Ilpcusblib/Drivers/USB/Class/Device -Ilpcusblib/user_config/device \
+ *       hostsim/audiodev_bench.c hostsim/DCD_Model.c hostsim/HAL_DevSim.c \
+ *       lpcusblib/Drivers/USB/Core/[A-Z]*.c lpcusblib/Drivers/USB/Core/LPC/[A-Z]*.c \
+ *       lpcusblib/Drivers/USB/Core/LPC/DCD/LPC17XX/Endpoint_LPC17xx.c \
+ *       lpcusblib/Drivers/USB/Class/Device/AudioClassDevice.c \
+ *       lpcusblib/user_config/device/USBAudioDevice.c lpcusblib/user_config/device/USBAudioDescriptors.c \
+ *       -lpthread -o audiodev_bench
+ *
+ * Usage: audiodev_bench [-s seconds per test] [-p ppm] [-F] [-t us per frame]
+ *
+ * Each test restarts the stream (alternate setting 0, then 1) and runs with
+ * the DAC at 0, +ppm and -ppm. -F makes the host ignore the feedback and send
+ * at the nominal rate, as an adaptive sink would expect: the FIFO then drifts
+ * into samples dropped or silence inserted once the difference adds up to half
+ * of it.
+ *
+ * Sample frames carry a running 32-bit index, so a dropped sample shows as a
+ * gap; silence is the all zero frame the index never takes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <signal.h>
+
+#include "USBAudioDevice.h"
+
+#include "DCD_Model.h"
+
+#define SETTLE_FRAMES				2			/* frames given to the device after SET_CONFIGURATION */
+#define CONVERGE_FRAMES				2000		/* frames before the measurement, for the FIFO to settle */
+#define DAC_BLOCK_FRAMES			(AUDIO_SAMPLE_FREQUENCY / 1000)
+#define NOMINAL_RATE				(((uint32_t) AUDIO_SAMPLE_FREQUENCY << 16) / 1000)	/* samples per frame, 16.16 */
+
+typedef struct {
+	int32_t  PPM;
+	uint32_t Dropped, Inserted, Lost;
+	uint32_t Gaps, Corrupt;
+	uint32_t LevelMin, LevelMax;
+	double   HostRate;
+	uint64_t Interrupts, Descriptors, Frames;
+} Result_t;
+
+uint32_t SystemCoreClock = 100000000;
+
+static volatile bool HostDone;
+static int      ExitCode;
+static uint32_t TestSeconds = 10;
+static int32_t  TestPPM = 300;
+static bool     IgnoreFeedback;
+
+/* Host stream */
+static uint32_t HostIndex = 1;
+static uint32_t HostRemainder;
+static volatile uint32_t HostRate;
+static uint32_t FeedbackPackets;
+
+/* DAC model, run from the slice hook */
+static volatile int32_t DacPPM;
+static volatile bool    DacResync;
+static volatile bool    DacMeasuring;
+static uint64_t DacLastTime;
+static double   DacPending;
+static uint32_t DacExpected;
+static uint32_t DacGaps, DacCorrupt;
+static uint32_t DacLevelMin, DacLevelMax;
+
+/*==========================================================================*/
+/* Host                                                                    */
+/*==========================================================================*/
+static DcdSim_Result_t ControlRequest(uint8_t RequestType, uint8_t Request, uint16_t Value, uint16_t Index,
+									  void *Data, uint16_t Length, uint16_t *Actual)
+{
+	const uint8_t Setup[8] = {RequestType, Request, Value & 0xFF, Value >> 8, Index & 0xFF, Index >> 8,
+							  Length & 0xFF, Length >> 8};
+
+	return DcdSim_Control(Setup, Data, Actual);
+}
+
+static void WaitFrames(uint64_t Frames)
+{
+	uint64_t End = DcdSim_GetFrameNumber() + Frames;
+
+	while (DcdSim_GetFrameNumber() < End)
+		usleep(100);
+}
+
+static bool Enumerate(void)
+{
+	uint8_t  Descriptor[256];
+	uint16_t Actual;
+	uint16_t TotalLength;
+	uint64_t Start;
+
+	if (DcdSim_WaitForConnect(2000) != DCDSIM_OK)
+	{
+		printf("Device did not connect\n");
+		return false;
+	}
+	Start = DcdSim_GetFrameNumber();
+
+	if ((ControlRequest(REQDIR_DEVICETOHOST, REQ_GetDescriptor, DTYPE_Device << 8, 0, Descriptor, 8, &Actual) != DCDSIM_OK) ||
+		(ControlRequest(REQDIR_HOSTTODEVICE, REQ_SetAddress, 1, 0, NULL, 0, NULL) != DCDSIM_OK) ||
+		(ControlRequest(REQDIR_DEVICETOHOST, REQ_GetDescriptor, DTYPE_Device << 8, 0, Descriptor, 18, &Actual) != DCDSIM_OK) ||
+		(Actual != 18) ||
+		(ControlRequest(REQDIR_DEVICETOHOST, REQ_GetDescriptor, DTYPE_Configuration << 8, 0, Descriptor, 9, &Actual) != DCDSIM_OK))
+	{
+		printf("Enumeration failed\n");
+		return false;
+	}
+
+	TotalLength = MIN(Descriptor[2] | (Descriptor[3] << 8), sizeof(Descriptor));
+	if ((ControlRequest(REQDIR_DEVICETOHOST, REQ_GetDescriptor, DTYPE_Configuration << 8, 0, Descriptor, TotalLength, &Actual) != DCDSIM_OK) ||
+		(Actual != TotalLength) ||
+		(ControlRequest(REQDIR_HOSTTODEVICE, REQ_SetConfiguration, 1, 0, NULL, 0, NULL) != DCDSIM_OK))
+	{
+		printf("Configuration failed\n");
+		return false;
+	}
+
+	/* The device configures its endpoints after the status stage of SET_CONFIGURATION;
+	 * a request that comes in meanwhile is taken for an unsupported one and stalled
+	 */
+	WaitFrames(SETTLE_FRAMES);
+
+	printf("Enumerated in %llu frames, %u configuration bytes\n",
+		   (unsigned long long) (DcdSim_GetFrameNumber() - Start), TotalLength);
+	return true;
+}
+
+/* Selects the alternate setting of the streaming interface, and sets and reads back the sample
+ * rate once streaming, as the audio driver of the host does before the first packet */
+static bool SelectStreaming(bool Enable)
+{
+	uint8_t  Rate[3] = {(uint8_t) AUDIO_SAMPLE_FREQUENCY, (uint8_t) (AUDIO_SAMPLE_FREQUENCY >> 8),
+						(uint8_t) (AUDIO_SAMPLE_FREQUENCY >> 16)};
+	uint8_t  Current[3] = {0};
+	uint16_t Actual;
+
+	if (ControlRequest(REQDIR_HOSTTODEVICE | REQTYPE_STANDARD | REQREC_INTERFACE, REQ_SetInterface,
+					   Enable ? 1 : 0, 1, NULL, 0, NULL) != DCDSIM_OK)
+	{
+		printf("SET_INTERFACE failed\n");
+		return false;
+	}
+
+	if (Enable &&
+		((ControlRequest(REQDIR_HOSTTODEVICE | REQTYPE_CLASS | REQREC_ENDPOINT, AUDIO_REQ_SetCurrent,
+						 AUDIO_EPCONTROL_SamplingFreq << 8, ENDPOINT_DIR_OUT | AUDIO_STREAM_EPNUM,
+						 Rate, sizeof(Rate), NULL) != DCDSIM_OK) ||
+		 (ControlRequest(REQDIR_DEVICETOHOST | REQTYPE_CLASS | REQREC_ENDPOINT, AUDIO_REQ_GetCurrent,
+						 AUDIO_EPCONTROL_SamplingFreq << 8, ENDPOINT_DIR_OUT | AUDIO_STREAM_EPNUM,
+						 Current, sizeof(Current), &Actual) != DCDSIM_OK) ||
+		 (Actual != sizeof(Current)) || memcmp(Rate, Current, sizeof(Rate))))
+	{
+		printf("Sample rate not taken\n");
+		return false;
+	}
+	return true;
+}
+
+/* Packet of a frame: the whole sample frames due at the rate the device asks for */
+static uint16_t StreamOut(uint8_t *Data, uint16_t MaxPacket)
+{
+	uint32_t Frames, i;
+
+	HostRemainder += IgnoreFeedback ? NOMINAL_RATE : HostRate;
+	Frames = MIN(HostRemainder >> 16, MaxPacket / AUDIO_SAMPLE_FRAME_SIZE);
+	HostRemainder &= 0xFFFF;
+
+	for (i = 0; i < Frames; i++)
+	{
+		memcpy(&Data[i * AUDIO_SAMPLE_FRAME_SIZE], &HostIndex, sizeof(HostIndex));
+		HostIndex = HostIndex + 1 ? HostIndex + 1 : 1;
+	}
+	return Frames * AUDIO_SAMPLE_FRAME_SIZE;
+}
+
+/* Feedback: samples per frame in 10.14 fixed point */
+static void FeedbackIn(const uint8_t *Data, uint16_t Length, bool Received)
+{
+	if (!Received || (Length < AUDIO_DEVICE_FEEDBACK_SIZE))
+		return;
+
+	HostRate = (Data[0] | (Data[1] << 8) | ((uint32_t) Data[2] << 16)) << 2;
+	FeedbackPackets++;
+}
+
+/*==========================================================================*/
+/* DAC                                                                     */
+/*==========================================================================*/
+static void DacBlock(void)
+{
+	uint32_t Block[DAC_BLOCK_FRAMES];
+	uint16_t Frames, Level, i;
+
+	Frames = Speaker_ReadSamples((int16_t *) Block, DAC_BLOCK_FRAMES);
+
+	if (DacResync)
+	{
+		DacExpected = 0;
+		DacResync   = false;
+	}
+
+	for (i = 0; i < Frames; i++)
+	{
+		if (DacExpected && (Block[i] != DacExpected))
+			DacGaps++;
+		DacExpected = Block[i] + 1 ? Block[i] + 1 : 1;
+	}
+	for (; i < DAC_BLOCK_FRAMES; i++)
+	{
+		if (Block[i] != 0)
+			DacCorrupt++;
+	}
+
+	if (DacMeasuring)
+	{
+		Level = Audio_Device_GetStreamLevel(Speaker_GetStream());
+		DacLevelMin = MIN(DacLevelMin, Level);
+		DacLevelMax = MAX(DacLevelMax, Level);
+	}
+}
+
+/* The DAC clock runs DacPPM off the bus; it takes a millisecond of samples whenever one is due */
+static void DacHook(uint64_t Time)
+{
+	DacPending += (double) (Time - DacLastTime) * AUDIO_SAMPLE_FREQUENCY * (1.0 + DacPPM / 1e6) / 1e9;
+	DacLastTime = Time;
+
+	while (DacPending >= DAC_BLOCK_FRAMES)
+	{
+		DacPending -= DAC_BLOCK_FRAMES;
+		DacBlock();
+	}
+}
+
+/*==========================================================================*/
+/* Tests                                                                   */
+/*==========================================================================*/
+static bool RunTest(int32_t PPM, Result_t *Result)
+{
+	const Audio_Device_Stream_t *Stream = Speaker_GetStream();
+	DcdSim_Stats_t Start, End;
+	uint32_t Dropped, Inserted, Lost;
+	uint32_t Sent;
+
+	memset(Result, 0, sizeof(Result_t));
+	Result->PPM   = PPM;
+	DacPPM        = PPM;
+	HostRate      = NOMINAL_RATE;
+	HostRemainder = 0;
+	DacResync     = true;
+
+	if (!SelectStreaming(true))
+		return false;
+
+	DcdSim_StartIsoIn(AUDIO_FEEDBACK_EPNUM, AUDIO_DEVICE_FEEDBACK_SIZE, 1 << AUDIO_FEEDBACK_REFRESH, FeedbackIn);
+	DcdSim_StartIsoOut(AUDIO_STREAM_EPNUM, AUDIO_STREAM_EPSIZE, StreamOut);
+
+	WaitFrames(CONVERGE_FRAMES);
+
+	Dropped     = Stream->DroppedSamples;
+	Inserted    = Stream->InsertedSamples;
+	Lost        = Stream->LostPackets;
+	DacGaps     = 0;
+	DacCorrupt  = 0;
+	DacLevelMin = 0xFFFF;
+	DacLevelMax = 0;
+	Sent        = HostIndex;
+	DcdSim_GetStats(&Start);
+	DacMeasuring = true;
+
+	WaitFrames(TestSeconds * 1000);
+
+	DacMeasuring = false;
+	DcdSim_GetStats(&End);
+	Sent = HostIndex - Sent;
+	Result->Dropped      = Stream->DroppedSamples - Dropped;
+	Result->Inserted     = Stream->InsertedSamples - Inserted;
+	Result->Lost         = Stream->LostPackets - Lost;
+	Result->Gaps         = DacGaps;
+	Result->Corrupt      = DacCorrupt;
+	Result->LevelMin     = DacLevelMin;
+	Result->LevelMax     = DacLevelMax;
+	Result->Interrupts   = End.Interrupts - Start.Interrupts;
+	Result->Descriptors  = End.DmaDescriptors - Start.DmaDescriptors;
+	Result->Frames       = End.Frames - Start.Frames;
+	Result->HostRate     = Result->Frames ? (Sent * 1000.0) / Result->Frames : 0;
+
+	DcdSim_StopIso(AUDIO_STREAM_EPNUM, false);
+	DcdSim_StopIso(AUDIO_FEEDBACK_EPNUM, true);
+	return SelectStreaming(false);
+}
+
+static bool PrintResult(const Result_t *Result)
+{
+	bool Clean = !Result->Dropped && !Result->Inserted && !Result->Lost && !Result->Gaps && !Result->Corrupt;
+
+	printf("%+6d %9.1f %9.1f %8u %6u %6u %6u %5u-%-5u %9.2f %8.2f  %s\n", Result->PPM,
+		   AUDIO_SAMPLE_FREQUENCY * (1.0 + Result->PPM / 1e6), Result->HostRate,
+		   Result->Dropped, Result->Inserted, Result->Lost, Result->Gaps,
+		   Result->LevelMin, Result->LevelMax,
+		   (double) Result->Interrupts / (Result->Frames ? Result->Frames : 1),
+		   (double) Result->Descriptors / (Result->Frames ? Result->Frames : 1),
+		   Result->Corrupt ? "CORRUPT" : (Clean ? "ok" : (IgnoreFeedback ? "drift" : "FAILED")));
+
+	return Clean || IgnoreFeedback;
+}
+
+static void *HostThread(void *Argument)
+{
+	const int32_t PPMs[3] = {0, TestPPM, -TestPPM};
+	Result_t Result;
+	bool     Passed = true;
+	uint32_t i;
+
+	ExitCode = 1;
+	if (Enumerate())
+	{
+		printf("%u s per test, %u frame FIFO (target %u), %s\n\n", TestSeconds,
+			   SPEAKER_FIFO_MS * (AUDIO_SAMPLE_FREQUENCY / 1000), SPEAKER_FIFO_MS * (AUDIO_SAMPLE_FREQUENCY / 1000) / 2,
+			   IgnoreFeedback ? "host ignores the feedback" : "host follows the feedback");
+		printf("%6s %9s %9s %8s %6s %6s %6s %11s %9s %8s\n",
+			   "ppm", "DAC Hz", "host Hz", "dropped", "insert", "lost", "gaps", "level", "irqs/frm", "DDs/frm");
+
+		for (i = 0; i < 3; i++)
+		{
+			if (!RunTest(PPMs[i], &Result))
+			{
+				Passed = false;
+				break;
+			}
+			Passed &= PrintResult(&Result);
+		}
+
+		printf("\n%u feedback packets read\n", FeedbackPackets);
+		if (Passed)
+			ExitCode = 0;
+	}
+
+	HostDone = true;
+	return NULL;
+}
+
+/*==========================================================================*/
+/* Main                                                                    */
+/*==========================================================================*/
+int main(int argc, char *argv[])
+{
+	uint32_t FramePeriodUS = 200;
+	pthread_t Host;
+	sigset_t Mask, Saved;
+	int Option;
+
+	while ((Option = getopt(argc, argv, "s:p:Ft:")) != -1)
+	{
+		switch (Option)
+		{
+		case 's': TestSeconds = atoi(optarg); break;
+		case 'p': TestPPM = atoi(optarg); break;
+		case 'F': IgnoreFeedback = true; break;
+		case 't': FramePeriodUS = atoi(optarg); break;
+		default:
+			fprintf(stderr, "usage: %s [-s seconds per test] [-p ppm] [-F] [-t us per frame]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	if ((TestSeconds < 1) || (TestPPM < 0) || (TestPPM > 5000) || (FramePeriodUS < 8))
+	{
+		fprintf(stderr, "at least 1 s per test, 0 to 5000 ppm, frame period at least 8 us\n");
+		return 2;
+	}
+
+	if (!DcdSim_Init(FramePeriodUS))
+	{
+		fprintf(stderr, "cannot start the device controller model\n");
+		return 1;
+	}
+
+	Speaker_DeviceInit();
+	DcdSim_SetSliceHook(DacHook);
+
+	/* Slices must only interrupt the thread running the device stack */
+	sigemptyset(&Mask);
+	sigaddset(&Mask, SIGALRM);
+	pthread_sigmask(SIG_BLOCK, &Mask, &Saved);
+	pthread_create(&Host, NULL, HostThread, NULL);
+	pthread_sigmask(SIG_SETMASK, &Saved, NULL);
+
+	while (!HostDone)
+	{
+		Speaker_DeviceTask();
+	}
+
+	pthread_join(Host, NULL);
+	DcdSim_DeInit();
+	return ExitCode;
+}
@@ -0,0 +1,320 @@
+/*
+ * cdc_bench.c
+ *
+ * CDC host receive test without hardware. The CDC host class driver
+ * (CDCClassHost.c) reads the virtual serial instrument (CDC_Device.c), which
+ * produces a fixed byte rate into a 4 KB transmit FIFO, through the OHCI model.
+ * Two receive paths can be compared:
+ *
+ *   -m byte   CDC_Host_BytesReceived()/CDC_Host_ReceiveByte() polling, a byte
+ *             per call on the IN pipe
+ *   -m ring   CDC_Host_StartReceiving(): bulk IN transfers kept queued by the
+ *             USB interrupt into a ring buffer, read with CDC_Host_Read()
+ *
+ * The application takes the data with a random stall after each read, as if it
+ * was writing it to an SD card. The device FIFO overflowing shows up as lost
+ * bytes; the TSC cycles spent in the receive calls that returned data give
+ * the CPU cost per byte.
+ * A block is also written with CDC_Host_Write() before receiving starts.
+ *
+ * Build on x86-64 Linux, from cortex_m3_nxp/:
+ *
+ *   gcc -std=gnu99 -O2 -no-pie -fno-pie \
+ *       -D__LPC17XX__ -D__CODE_RED -DUSB_HOST_ONLY -DUSE_FREERTOS_DELAY=0 \
+ *       -Ihostsim -I../CMSIS_CORE_LPC17xx/inc \
+ *       -Ilpcusblib/Drivers/USB -Ilpcusblib/Drivers/USB/Class/Host \
+ *       hostsim/cdc_bench.c hostsim/CDC_Device.c hostsim/OHCI_Model.c hostsim/HAL_Sim.c \
+ *       lpcusblib/Drivers/USB/Core/[A-Z]*.c lpcusblib/Drivers/USB/Core/LPC/[A-Z]*.c \
+ *       lpcusblib/Drivers/USB/Core/LPC/HCD/HCD.c lpcusblib/Drivers/USB/Core/LPC/HCD/OHCI/OHCI.c \
+ *       lpcusblib/Drivers/USB/Class/Host/CDCClassHost.c \
+ *       -o cdc_bench
+ *
+ * Usage: cdc_bench [-m byte|ring] [-s seconds] [-r bytes per second] [-b ring bytes] [-w max stall ms] [-x write bytes] [-t us per frame]
+ *
+ * As with audio_bench the application loop runs in wall clock time against
+ * the frames, keep the frame period at the default 1000 us.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "USB.h"
+#include "CDCClassHost.h"
+
+#include "OHCI_Model.h"
+#include "CDC_Device.h"
+
+#define ENUMERATION_TIMEOUT_FRAMES		10000
+#define READ_CHUNK						4096
+
+static USB_ClassInfo_CDC_Host_t Serial_CDC_Interface = {
+	.Config = {
+		.DataINPipeNumber       = 1,
+		.DataINPipeDoubleBank   = false,
+		.DataOUTPipeNumber      = 2,
+		.DataOUTPipeDoubleBank  = false,
+		.NotificationPipeNumber = 3,
+		.NotificationPipeDoubleBank = false,
+		.PortNumber = 0,
+	},
+};
+
+static CDC_Device_t VirtualSerial;
+static volatile bool Enumerated;
+static volatile bool EnumerationError;
+
+static uint64_t Received;
+static uint64_t ReceiveIndex;
+static uint64_t ReceiveGaps;
+
+/*==========================================================================*/
+/* Host stack events                                                       */
+/*==========================================================================*/
+void EVENT_USB_Host_DeviceEnumerationComplete(const uint8_t corenum)
+{
+	uint16_t ConfigDescriptorSize;
+	uint8_t  ConfigDescriptorData[512];
+
+	if (USB_Host_GetDeviceConfigDescriptor(corenum, 1, &ConfigDescriptorSize, ConfigDescriptorData,
+										   sizeof(ConfigDescriptorData)) != HOST_GETCONFIG_Successful) {
+		printf("Error Retrieving Configuration Descriptor.\n");
+		EnumerationError = true;
+		return;
+	}
+
+	if (CDC_Host_ConfigurePipes(&Serial_CDC_Interface, ConfigDescriptorSize, ConfigDescriptorData) != CDC_ENUMERROR_NoError) {
+		printf("Attached Device Not a Valid CDC Class Device.\n");
+		EnumerationError = true;
+		return;
+	}
+
+	if (USB_Host_SetDeviceConfiguration(corenum, 1) != HOST_SENDCONTROL_Successful) {
+		printf("Error Setting Device Configuration.\n");
+		EnumerationError = true;
+		return;
+	}
+
+	Enumerated = true;
+}
+
+void EVENT_USB_Host_HostError(const uint8_t corenum, const uint8_t ErrorCode)
+{
+	printf("Host Mode Error %d on port %d\n", ErrorCode, corenum);
+	EnumerationError = true;
+}
+
+void EVENT_USB_Host_DeviceEnumerationFailed(const uint8_t corenum,
+											const uint8_t ErrorCode,
+											const uint8_t SubErrorCode)
+{
+	printf("Dev Enum Error %d/%d on port %d in state %d\n", ErrorCode, SubErrorCode, corenum, USB_HostState[corenum]);
+	EnumerationError = true;
+}
+
+/*==========================================================================*/
+/* Application side                                                        */
+/*==========================================================================*/
+static void VerifyData(const uint8_t *Data, uint32_t Length)
+{
+	uint32_t i;
+
+	for (i = 0; i < Length; i++)
+	{
+		if (Data[i] != CDC_Device_Pattern(ReceiveIndex))
+		{
+			/* Resynchronise on the byte received, the device dropped the ones in between */
+			ReceiveGaps++;
+			ReceiveIndex += (Data[i] + CDC_DEVICE_PATTERN_PERIOD - CDC_Device_Pattern(ReceiveIndex)) % CDC_DEVICE_PATTERN_PERIOD;
+		}
+		ReceiveIndex++;
+	}
+
+	Received += Length;
+}
+
+static bool WriteBlock(uint32_t Length)
+{
+	uint8_t *Block = malloc(Length);
+	uint8_t  ErrorCode;
+	uint64_t Start;
+	uint32_t i;
+
+	if (Block == NULL)
+		return false;
+
+	for (i = 0; i < Length; i++)
+		Block[i] = CDC_Device_Pattern(i);
+
+	Start = OhciSim_GetFrameNumber();
+	ErrorCode = CDC_Host_Write(&Serial_CDC_Interface, Block, Length);
+
+	/* The last transfer may still be on the bus */
+	while ((VirtualSerial.Received < Length) && ((OhciSim_GetFrameNumber() - Start) < 1000))
+		USB_USBTask();
+
+	printf("write: %u bytes in %llu frames, error %u, device got %llu bytes, %llu out of pattern: %s\n",
+		   Length, (unsigned long long) (OhciSim_GetFrameNumber() - Start), ErrorCode,
+		   (unsigned long long) VirtualSerial.Received, (unsigned long long) VirtualSerial.ReceiveErrors,
+		   ((ErrorCode == PIPE_RWSTREAM_NoError) && (VirtualSerial.Received == Length) && !VirtualSerial.ReceiveErrors) ? "ok" : "FAILED");
+	free(Block);
+	return true;
+}
+
+/*==========================================================================*/
+/* Main                                                                    */
+/*==========================================================================*/
+static bool EnumerateSerial(void)
+{
+	uint64_t Start = OhciSim_GetFrameNumber();
+
+	OhciSim_Attach(&VirtualSerial.Device);
+
+	while (!Enumerated && !EnumerationError)
+	{
+		USB_USBTask();
+
+		if ((OhciSim_GetFrameNumber() - Start) > ENUMERATION_TIMEOUT_FRAMES)
+		{
+			printf("Enumeration timed out in host state %d\n", USB_HostState[0]);
+			return false;
+		}
+	}
+
+	if (EnumerationError)
+		return false;
+
+	printf("Enumerated in %llu frames: data IN pipe %u bytes, data OUT pipe %u bytes\n",
+		   (unsigned long long) (OhciSim_GetFrameNumber() - Start), Serial_CDC_Interface.State.DataINPipeSize,
+		   Serial_CDC_Interface.State.DataOUTPipeSize);
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	bool     Ring = true;
+	uint32_t Seconds = 10;
+	uint32_t Rate = 400000;
+	uint32_t RingSize = 16384;
+	uint32_t MaxStall = 10;
+	uint32_t WriteSize = 8192;
+	uint32_t FramePeriodUS = 1000;
+	uint64_t Start, End, Frame;
+	uint64_t Busy = 0;
+	uint64_t Cycles = 0, Calls = 0, T0;
+	uint8_t  *RingBuffer;
+	uint8_t  Chunk[READ_CHUNK];
+	uint32_t Count;
+	int16_t  Byte;
+	uint8_t  ErrorCode;
+	int Option;
+
+	while ((Option = getopt(argc, argv, "m:s:r:b:w:x:t:")) != -1)
+	{
+		switch (Option)
+		{
+		case 'm': Ring = (strcmp(optarg, "byte") != 0); break;
+		case 's': Seconds = atoi(optarg); break;
+		case 'r': Rate = atoi(optarg); break;
+		case 'b': RingSize = atoi(optarg); break;
+		case 'w': MaxStall = atoi(optarg); break;
+		case 'x': WriteSize = atoi(optarg); break;
+		case 't': FramePeriodUS = atoi(optarg); break;
+		default:
+			fprintf(stderr, "usage: %s [-m byte|ring] [-s seconds] [-r bytes per second] [-b ring bytes] [-w max stall ms] [-x write bytes] [-t us per frame]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	if ((RingSize < 2) || (RingSize > 65535) || (FramePeriodUS < 1))
+	{
+		fprintf(stderr, "ring buffer must be 2 to 65535 bytes, frame period at least 1 us\n");
+		return 2;
+	}
+
+	CDC_Device_Init(&VirtualSerial, Rate);
+	RingBuffer = malloc(RingSize);
+
+	if ((RingBuffer == NULL) || !OhciSim_Init(FramePeriodUS))
+	{
+		fprintf(stderr, "cannot start the OHCI model\n");
+		return 1;
+	}
+
+	USB_Init();
+
+	if (!EnumerateSerial())
+		return 1;
+
+	if (WriteSize && !WriteBlock(WriteSize))
+		return 1;
+
+	if (Ring && ((ErrorCode = CDC_Host_StartReceiving(&Serial_CDC_Interface, RingBuffer, RingSize)) != CDC_RECEIVE_NoError))
+	{
+		printf("Cannot start receiving: error %u\n", ErrorCode);
+		return 1;
+	}
+
+	/* DTR up starts the instrument */
+	if (CDC_Host_SendControlLineStateChange(&Serial_CDC_Interface) != HOST_SENDCONTROL_Successful)
+	{
+		printf("Cannot set the control lines\n");
+		return 1;
+	}
+
+	printf("%s path, %u s at %u bytes/s, %u byte ring buffer, stalls up to %u ms\n\n",
+		   Ring ? "ring" : "byte", Seconds, Rate, RingSize, MaxStall);
+
+	Start = OhciSim_GetFrameNumber();
+	End   = Start + (uint64_t) Seconds * 1000;
+	while ((Frame = OhciSim_GetFrameNumber()) < End)
+	{
+		CDC_Host_USBTask(&Serial_CDC_Interface);
+		USB_USBTask();
+
+		if (Frame < Busy)
+			continue;
+
+		T0 = OhciSim_ReadTSC();
+		if (Ring)
+		{
+			Count = CDC_Host_Read(&Serial_CDC_Interface, Chunk, sizeof(Chunk));
+			Calls++;
+		}
+		else
+		{
+			for (Count = 0; (Count < sizeof(Chunk)) && CDC_Host_BytesReceived(&Serial_CDC_Interface); Count++)
+			{
+				if ((Byte = CDC_Host_ReceiveByte(&Serial_CDC_Interface)) < 0)
+					break;
+				Chunk[Count] = Byte;
+				Calls += 2;
+			}
+			Calls++;
+		}
+		if (Count)
+		{
+			Cycles += OhciSim_ReadTSC() - T0;
+			VerifyData(Chunk, Count);
+			Busy = Frame + (MaxStall ? (uint32_t) rand() % (MaxStall + 1) : 0);
+		}
+	}
+
+	if (Ring)
+		CDC_Host_StopReceiving(&Serial_CDC_Interface);
+
+	printf("%-6s %10s %10s %10s %8s %10s %10s %7s %s\n", "path", "produced", "received", "lost", "gaps", "kB/s", "calls", "cyc/B", "result");
+	printf("%-6s %10llu %10llu %10llu %8llu %10.1f %10llu %7.1f %s\n", Ring ? "ring" : "byte",
+		   (unsigned long long) VirtualSerial.Produced, (unsigned long long) Received, (unsigned long long) VirtualSerial.Lost,
+		   (unsigned long long) ReceiveGaps, Received / (Seconds * 1000.0), (unsigned long long) Calls,
+		   Received ? (double) Cycles / Received : 0.0,
+		   (VirtualSerial.Lost || ReceiveGaps || Serial_CDC_Interface.State.Receive.Error) ? "LOST DATA" : "ok");
+	printf("\ndevice FIFO peak %u of %u bytes, %llu IN NAKs\n", VirtualSerial.FIFOPeak, CDC_DEVICE_FIFO_SIZE,
+		   (unsigned long long) VirtualSerial.Naks);
+
+	OhciSim_Detach();
+	OhciSim_DeInit();
+	free(RingBuffer);
+	return 0;
+}
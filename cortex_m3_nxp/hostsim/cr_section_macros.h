@@ -0,0 +1,17 @@
+/*
+ * cr_section_macros.h
+ *
+ * Host simulation stand-in for the Code Red section macros. The USB RAM
+ * section has no meaning on the build host, so everything lands in .bss.
+ */
+
+#ifndef HOSTSIM_CR_SECTION_MACROS_H_
+#define HOSTSIM_CR_SECTION_MACROS_H_
+
+#define __DATA(x)
+#define __BSS(x)
+#define __NOINIT(x)
+#define __RAMFUNC(x)
+#define __SECTION(t,x)
+
+#endif /* HOSTSIM_CR_SECTION_MACROS_H_ */
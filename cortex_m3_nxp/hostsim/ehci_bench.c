@@ -0,0 +1,381 @@
+/*
+ * ehci_bench.c
+ *
+ * High speed bulk benchmark of the EHCI host driver without hardware. EHCI.c
+ * drives the EHCI model (EHCI_Model.c) which talks to a virtual Bulk-Only disk
+ * (HSDisk_Device.c). The bench speaks Bulk-Only Transport through the HCD API
+ * itself, as the pipe layer would, and reads the disk with READ(10) commands
+ * of a given size in two ways:
+ *
+ *   chained  the data stage is one HcdDataTransfer() per 63.5 KB (the longest
+ *            transfer whose count fits 16 bits), the driver queues each as a
+ *            chain of qTDs which completes with a single interrupt
+ *   4k       the data stage is split into 4 KB HcdDataTransfer() calls, each
+ *            waited for, as a driver that queues one qTD per transfer must
+ *
+ * Throughput is given in virtual bus time; interrupts and cycles per MB are
+ * the host CPU cost of the data, HcdIrqHandler() and the queueing calls
+ * (HcdDataTransfer()) counted apart. A short packet test then ends data
+ * stages early, with a short packet and with a zero length packet, and checks
+ * that the residue is right and that the next transfer on the pipe runs, and
+ * a transfer of 64 KB has to be refused.
+ *
+ * Build on x86-64 Linux, from cortex_m3_nxp/:
+ *
+ *   gcc -std=gnu99 -O2 -no-pie -fno-pie \
+ *       -D__LPC18XX__ -D__CODE_RED -DUSB_HOST_ONLY -DUSB_PORT=0 -DUSE_FREERTOS_DELAY=0 \
+ *       -Wno-int-to-pointer-cast -Wno-pointer-to-int-cast \
+ *       -Ihostsim -Ilpcusblib/Drivers/USB \
+ *       hostsim/ehci_bench.c hostsim/HSDisk_Device.c hostsim/EHCI_Model.c \
+ *       lpcusblib/Drivers/USB/Core/LPC/HCD/HCD.c lpcusblib/Drivers/USB/Core/LPC/HCD/EHCI/EHCI.c \
+ *       -o ehci_bench
+ *
+ * Usage: ehci_bench [-m MB per test] [-s READ size in KB, may be repeated] [-t us per frame]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "USB.h"
+#include "Core/LPC/HCD/HCD.h"
+
+#include "EHCI_Model.h"
+#include "HSDisk_Device.h"
+
+#define ATTACH_TIMEOUT_FRAMES			1000
+#define TRANSFER_TIMEOUT_FRAMES			1000
+#define DEVICE_ADDRESS					1
+#define SPLIT_SIZE						4096
+#define CHAINED_SIZE					(0x10000 - HSDISK_DEVICE_PACKET_SIZE)	/* whole packets, counted in 16 bits */
+#define MAX_READ_SIZE					(256 * 1024)
+#define MAX_READ_SIZES					8
+
+typedef enum {
+	MODE_CHAINED,
+	MODE_SPLIT,
+} Mode_t;
+
+static HSDisk_Device_t VirtualDisk;
+static volatile bool   Attached;
+
+static uint32_t ControlPipe;
+static uint32_t InPipe;
+static uint32_t OutPipe;
+static uint32_t Tag;
+
+static uint8_t  ReadBuffer[MAX_READ_SIZE] __attribute__((aligned(4096)));
+static uint8_t  Cbw[31] __attribute__((aligned(32)));
+static uint8_t  Csw[64] __attribute__((aligned(32)));
+static uint8_t  ControlBuffer[64] __attribute__((aligned(32)));
+
+static uint64_t QueueCycles;
+
+/*==========================================================================*/
+/* Host stack glue                                                         */
+/*==========================================================================*/
+/* Called by the driver's port change interrupt */
+void USB_Host_Enumerate(uint8_t HostID)
+{
+	Attached = true;
+}
+
+void USB_Host_DeEnumerate(uint8_t HostID)
+{
+	Attached = false;
+}
+
+/*==========================================================================*/
+/* Transfers                                                               */
+/*==========================================================================*/
+static HCD_STATUS WaitForPipe(uint32_t PipeHandle)
+{
+	uint64_t Start = EhciSim_GetFrameNumber();
+	HCD_STATUS Status;
+
+	while ((Status = HcdGetPipeStatus(PipeHandle)) == HCD_STATUS_TRANSFER_QUEUED)
+	{
+		if ((EhciSim_GetFrameNumber() - Start) > TRANSFER_TIMEOUT_FRAMES)
+			return HCD_STATUS_TRANSFER_DeviceNotResponding;
+	}
+
+	return Status;
+}
+
+static HCD_STATUS Transfer(uint32_t PipeHandle, uint8_t *Buffer, uint32_t Length, uint16_t *Actual)
+{
+	uint64_t Start = EhciSim_ReadTSC();
+	HCD_STATUS Status = HcdDataTransfer(PipeHandle, Buffer, Length, Actual);
+
+	QueueCycles += EhciSim_ReadTSC() - Start;
+	return (Status == HCD_STATUS_OK) ? WaitForPipe(PipeHandle) : Status;
+}
+
+static HCD_STATUS ControlRequest(uint8_t bmRequestType, uint8_t bRequest, uint16_t wValue, uint16_t wLength)
+{
+	static USB_Request_Header_t Request __attribute__((aligned(32)));
+
+	Request.bmRequestType = bmRequestType;
+	Request.bRequest      = bRequest;
+	Request.wValue        = wValue;
+	Request.wIndex        = 0;
+	Request.wLength       = wLength;
+
+	return HcdControlTransfer(ControlPipe, &Request, ControlBuffer);
+}
+
+/* One READ(10) command: CBW, data stage of Length bytes split as Mode says, CSW; false on a transfer or CSW error */
+static bool Read(uint32_t Lba, uint32_t Length, Mode_t Mode, uint32_t *Received, uint32_t *Residue)
+{
+	uint32_t Blocks = Length / HSDISK_DEVICE_BLOCK_SIZE;
+	uint32_t Offset;
+	uint32_t Chunk;
+	uint16_t Actual;
+
+	memset(Cbw, 0, sizeof(Cbw));
+	Cbw[0] = 'U'; Cbw[1] = 'S'; Cbw[2] = 'B'; Cbw[3] = 'C';
+	memcpy(&Cbw[4], &Tag, 4);
+	memcpy(&Cbw[8], &Length, 4);
+	Cbw[12] = 0x80;
+	Cbw[14] = 10;
+	Cbw[15] = 0x28;
+	Cbw[17] = Lba >> 24; Cbw[18] = Lba >> 16; Cbw[19] = Lba >> 8; Cbw[20] = Lba;
+	Cbw[22] = Blocks >> 8; Cbw[23] = Blocks;
+
+	if (Transfer(OutPipe, Cbw, sizeof(Cbw), &Actual) != HCD_STATUS_OK)
+		return false;
+
+	*Received = 0;
+	for (Offset = 0; Offset < Length; Offset += Chunk)
+	{
+		Chunk = MIN((Mode == MODE_CHAINED) ? CHAINED_SIZE : SPLIT_SIZE, Length - Offset);
+		if (Transfer(InPipe, &ReadBuffer[Offset], Chunk, &Actual) != HCD_STATUS_OK)
+			return false;
+
+		*Received += Actual;
+		if (Actual != Chunk)
+		{
+			*Received = Offset + Actual;
+			break;
+		}
+	}
+
+	if (Transfer(InPipe, Csw, 13, &Actual) != HCD_STATUS_OK)
+		return false;
+
+	memcpy(Residue, &Csw[8], 4);
+	return (Actual == 13) && (memcmp(Csw, "USBS", 4) == 0) && (memcmp(&Csw[4], &Tag, 4) == 0) && (Csw[12] == 0);
+}
+
+static uint32_t Verify(uint32_t Lba, uint32_t Length)
+{
+	uint64_t Position = (uint64_t) Lba * HSDISK_DEVICE_BLOCK_SIZE;
+	uint32_t Errors = 0;
+	uint32_t i;
+
+	for (i = 0; i < Length; i++)
+	{
+		if (ReadBuffer[i] != HSDisk_Device_Pattern(Position + i))
+			Errors++;
+	}
+
+	return Errors;
+}
+
+/*==========================================================================*/
+/* Main                                                                    */
+/*==========================================================================*/
+static bool Enumerate(void)
+{
+	uint64_t Start = EhciSim_GetFrameNumber();
+
+	EhciSim_Attach(&VirtualDisk.Device);
+
+	while (!Attached)
+	{
+		if ((EhciSim_GetFrameNumber() - Start) > ATTACH_TIMEOUT_FRAMES)
+		{
+			printf("no port change on attach\n");
+			return false;
+		}
+	}
+
+	HcdRhPortReset(0, 0);
+
+	if ((HcdOpenPipe(0, 0, HIGH_SPEED, 0, CONTROL_TRANSFER, SETUP_TRANSFER, 64, 0, 1, 0, 0, &ControlPipe) != HCD_STATUS_OK) ||
+		(ControlRequest(0x80, 0x06, 0x0100, 18) != HCD_STATUS_OK) ||
+		(ControlRequest(0x00, 0x05, DEVICE_ADDRESS, 0) != HCD_STATUS_OK))
+	{
+		printf("addressing failed\n");
+		return false;
+	}
+
+	HcdClosePipe(ControlPipe);
+
+	if ((HcdOpenPipe(0, DEVICE_ADDRESS, HIGH_SPEED, 0, CONTROL_TRANSFER, SETUP_TRANSFER, 64, 0, 1, 0, 0, &ControlPipe) != HCD_STATUS_OK) ||
+		(ControlRequest(0x00, 0x09, 1, 0) != HCD_STATUS_OK) ||
+		(HcdOpenPipe(0, DEVICE_ADDRESS, HIGH_SPEED, HSDISK_DEVICE_IN_ENDPOINT, BULK_TRANSFER, IN_TRANSFER,
+					 HSDISK_DEVICE_PACKET_SIZE, 0, 1, 0, 0, &InPipe) != HCD_STATUS_OK) ||
+		(HcdOpenPipe(0, DEVICE_ADDRESS, HIGH_SPEED, HSDISK_DEVICE_OUT_ENDPOINT, BULK_TRANSFER, OUT_TRANSFER,
+					 HSDISK_DEVICE_PACKET_SIZE, 0, 1, 0, 0, &OutPipe) != HCD_STATUS_OK))
+	{
+		printf("configuration failed\n");
+		return false;
+	}
+
+	return true;
+}
+
+/* Short data stages: a short packet, then a zero length packet, each followed by its CSW */
+static uint32_t ShortPacketTest(void)
+{
+	static const uint32_t ShortBy[] = {1000, 4096};
+	uint32_t Failures = 0;
+	uint32_t Received, Residue, Errors;
+	uint32_t Length = 64 * 1024 - HSDISK_DEVICE_BLOCK_SIZE;
+	bool     Ok;
+	int      i, Mode;
+
+	printf("\n%-8s %8s %9s %9s %8s %s\n", "mode", "short by", "received", "residue", "errors", "result");
+
+	for (Mode = MODE_CHAINED; Mode <= MODE_SPLIT; Mode++)
+	{
+		for (i = 0; i < 2; i++)
+		{
+			VirtualDisk.ShortBy = ShortBy[i];
+			Tag++;
+			Ok = Read(i * 1000, Length, (Mode_t) Mode, &Received, &Residue) &&
+				 (Received == Length - ShortBy[i]) && (Residue == ShortBy[i]);
+			Errors = Verify(i * 1000, Length - ShortBy[i]);
+
+			printf("%-8s %8u %9u %9u %8u ", (Mode == MODE_CHAINED) ? "chained" : "4k", ShortBy[i],
+				   Received, Residue, Errors);
+
+			/* the next command on the same pipes must run normally */
+			VirtualDisk.ShortBy = 0;
+			Tag++;
+			Ok = Ok && (Errors == 0) && Read(0, SPLIT_SIZE, (Mode_t) Mode, &Received, &Residue) &&
+				 (Residue == 0) && (Received == SPLIT_SIZE) && (Verify(0, SPLIT_SIZE) == 0);
+			if (!Ok)
+				Failures++;
+
+			printf("%s\n", Ok ? "ok" : "FAILED");
+		}
+	}
+
+	return Failures;
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t ReadSize[MAX_READ_SIZES] = {4 * 1024, 64 * 1024, 256 * 1024};
+	uint32_t ReadSizes = 3;
+	uint32_t TestMB = 8;
+	uint32_t FramePeriodUS = 200;
+	uint32_t Failures = 0;
+	uint32_t Received, Residue, Errors;
+	uint32_t Lba, Size, Commands, i;
+	uint16_t Actual;
+	uint64_t Start, Frames, Bytes, Isr, Interrupts, Queue;
+	EhciSim_Stats_t Before, After;
+	bool     Ok, CustomSizes = false;
+	int      Mode;
+	int      Option;
+
+	while ((Option = getopt(argc, argv, "m:s:t:")) != -1)
+	{
+		switch (Option)
+		{
+		case 'm': TestMB = atoi(optarg); break;
+		case 's':
+			if (!CustomSizes)
+				ReadSizes = 0;
+			CustomSizes = true;
+			if (ReadSizes < MAX_READ_SIZES)
+				ReadSize[ReadSizes++] = MIN(atoi(optarg) * 1024, MAX_READ_SIZE);
+			break;
+		case 't': FramePeriodUS = atoi(optarg); break;
+		default:
+			fprintf(stderr, "usage: %s [-m MB per test] [-s READ size in KB, may be repeated] [-t us per frame]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	HSDisk_Device_Init(&VirtualDisk);
+
+	if ((FramePeriodUS < 1) || !EhciSim_Init(FramePeriodUS))
+	{
+		fprintf(stderr, "cannot start the EHCI model\n");
+		return 1;
+	}
+
+	HcdInitDriver(0);
+	EhciSim_SetInterruptEnable(true);
+
+	if (!Enumerate())
+		return 1;
+
+	printf("%u MB per test, %u us per frame\n\n", TestMB, FramePeriodUS);
+	printf("%-8s %8s %8s %9s %8s %10s %12s %12s %s\n", "mode", "READ", "commands", "kB/s", "errors",
+		   "irqs/MB", "isr cyc/MB", "queue cyc/MB", "result");
+
+	for (i = 0; i < ReadSizes; i++)
+	{
+		Size = ReadSize[i] - (ReadSize[i] % HSDISK_DEVICE_BLOCK_SIZE);
+		if (Size == 0)
+			continue;
+
+		for (Mode = MODE_CHAINED; Mode <= MODE_SPLIT; Mode++)
+		{
+			Commands    = (uint32_t) (((uint64_t) TestMB << 20) / Size);
+			Errors      = 0;
+			Ok          = true;
+			Bytes       = 0;
+			QueueCycles = 0;
+
+			EhciSim_GetStats(&Before);
+			Start = EhciSim_GetFrameNumber();
+
+			for (Lba = 0; Ok && (Lba < Commands * (Size / HSDISK_DEVICE_BLOCK_SIZE)); Lba += Size / HSDISK_DEVICE_BLOCK_SIZE)
+			{
+				Tag++;
+				Ok = Read(Lba, Size, (Mode_t) Mode, &Received, &Residue) && (Residue == 0) &&
+					 (Received == Size);
+				Errors += Verify(Lba, Size);
+				Bytes  += Size;
+			}
+
+			Frames = EhciSim_GetFrameNumber() - Start;
+			EhciSim_GetStats(&After);
+
+			Interrupts = After.Interrupts - Before.Interrupts;
+			Isr        = After.IsrCycles - Before.IsrCycles;
+			Queue      = QueueCycles;
+
+			Ok = Ok && (Errors == 0);
+			if (!Ok)
+				Failures++;
+
+			printf("%-8s %7uK %8u %9.1f %8u %10.1f %12.0f %12.0f %s\n", (Mode == MODE_CHAINED) ? "chained" : "4k",
+				   Size / 1024, Commands, Frames ? (double) Bytes / Frames : 0.0, Errors,
+				   (double) Interrupts * (1 << 20) / Bytes, (double) Isr * (1 << 20) / Bytes,
+				   (double) Queue * (1 << 20) / Bytes, Ok ? "ok" : "FAILED");
+		}
+	}
+
+	Failures += ShortPacketTest();
+
+	/* the count could not tell how much of a 64 KB transfer was done */
+	Ok = (HcdDataTransfer(InPipe, ReadBuffer, 0x10000, &Actual) == HCD_STATUS_PARAMETER_INVALID);
+	Tag++;
+	Ok = Ok && Read(0, SPLIT_SIZE, MODE_CHAINED, &Received, &Residue) && (Residue == 0) &&
+		 (Received == SPLIT_SIZE) && (Verify(0, SPLIT_SIZE) == 0);
+	if (!Ok)
+		Failures++;
+	printf("\n64 KB transfer refused, pipe still runs: %s\n", Ok ? "ok" : "FAILED");
+
+	EhciSim_DeInit();
+	printf("\n%s\n", Failures ? "FAILED" : "passed");
+	return Failures ? 1 : 0;
+}
@@ -0,0 +1,261 @@
+/*
+ * hid_bench.c
+ *
+ * HID report plan check without hardware. Report descriptors with signed,
+ * unsigned and mixed-width fields are parsed by the unmodified HIDParser.c
+ * and compiled with USB_CompileHIDReportPlan(). Random reports are then
+ * decoded twice: by USB_ExtractHIDReportFields() from the plan, and item by
+ * item with USB_GetHIDReportItemInfo(), sign extended here from the
+ * signedness the descriptor declares. Every value must agree. The time per
+ * report of both ways is given in host nanoseconds.
+ *
+ * The descriptors cover a logical minimum and maximum of different item
+ * sizes (a one byte -100 with a two byte 1000), one bit to 30 bit fields,
+ * fields spanning five bytes, a field in the last bytes of the report that
+ * a word load would overrun, and reports with report IDs.
+ *
+ * Build on x86-64 Linux, from cortex_m3_nxp/:
+ *
+ *   gcc -std=gnu99 -O2 -no-pie -fno-pie \
+ *       -D__LPC17XX__ -D__CODE_RED -DUSB_HOST_ONLY -DUSE_FREERTOS_DELAY=0 \
+ *       -Ihostsim -I../CMSIS_CORE_LPC17xx/inc \
+ *       -Ilpcusblib/Drivers/USB -Ilpcusblib/Drivers/USB/Class/Host \
+ *       hostsim/hid_bench.c lpcusblib/Drivers/USB/Class/Common/HIDParser.c \
+ *       -o hid_bench
+ *
+ * Usage: hid_bench [-n reports per descriptor]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "USB.h"
+
+#define MAX_REPORT_BYTES			32
+
+typedef struct {
+	const char    *Name;
+	const uint8_t *Descriptor;
+	uint16_t       DescriptorSize;
+	const bool    *Signed;			/* per compiled field, what the descriptor declares */
+	uint8_t        Fields;
+	const uint8_t *ReportIDs;		/* NULL without report IDs */
+	uint8_t        ReportIDCount;
+} Case_t;
+
+/* One report: buttons, a 3 bit signed axis, padding, 16 bit field with a one byte minimum of -100 and a two byte
+ * maximum of 1000, unsigned 12 bit, signed 20 bit with four byte limits, unsigned 8 bit, 3 bit unsigned, a 30 bit
+ * signed field at bit shift 3 spanning five bytes, and a 4 bit signed field in the last report byte */
+static const uint8_t MixedDescriptor[] = {
+	0x05, 0x01, 0x09, 0x04, 0xA1, 0x01,
+	0x05, 0x09, 0x19, 0x01, 0x29, 0x03, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x03, 0x81, 0x02,
+	0x05, 0x01, 0x09, 0x30, 0x15, 0xFC, 0x25, 0x03, 0x75, 0x03, 0x95, 0x01, 0x81, 0x02,
+	0x75, 0x02, 0x95, 0x01, 0x81, 0x01,
+	0x09, 0x31, 0x15, 0x9C, 0x26, 0xE8, 0x03, 0x75, 0x10, 0x81, 0x02,
+	0x09, 0x32, 0x15, 0x00, 0x26, 0xFF, 0x0F, 0x75, 0x0C, 0x81, 0x02,
+	0x09, 0x33, 0x17, 0xE0, 0x5E, 0xF8, 0xFF, 0x27, 0x20, 0xA1, 0x07, 0x00, 0x75, 0x14, 0x81, 0x02,
+	0x09, 0x34, 0x15, 0x00, 0x26, 0xFF, 0x00, 0x75, 0x08, 0x81, 0x02,
+	0x09, 0x35, 0x15, 0x00, 0x25, 0x07, 0x75, 0x03, 0x81, 0x02,
+	0x09, 0x36, 0x16, 0xFF, 0xFF, 0x27, 0xFF, 0xFF, 0xFF, 0x1F, 0x75, 0x1E, 0x81, 0x02,
+	0x09, 0x37, 0x15, 0xF8, 0x25, 0x07, 0x75, 0x04, 0x81, 0x02,
+	0xC0
+};
+
+static const bool MixedSigned[] = { false, false, false, true, true, false, true, false, false, true, true };
+
+/* Two reports selected by ID: a full range 16 bit signed and an 8 bit unsigned field, then a 24 bit signed field */
+static const uint8_t ReportIDDescriptor[] = {
+	0x05, 0x01, 0x09, 0x05, 0xA1, 0x01,
+	0x85, 0x01,
+	0x09, 0x30, 0x16, 0x00, 0x80, 0x26, 0xFF, 0x7F, 0x75, 0x10, 0x95, 0x01, 0x81, 0x02,
+	0x09, 0x31, 0x15, 0x00, 0x26, 0xFF, 0x00, 0x75, 0x08, 0x81, 0x02,
+	0x85, 0x02,
+	0x09, 0x32, 0x17, 0x00, 0x00, 0x80, 0xFF, 0x27, 0xFF, 0xFF, 0x7F, 0x00, 0x75, 0x18, 0x81, 0x02,
+	0xC0
+};
+
+static const bool    ReportIDSigned[] = { true, false, true };
+static const uint8_t ReportIDs[] = { 1, 2 };
+
+static const Case_t Cases[] = {
+	{ "mixed widths", MixedDescriptor, sizeof(MixedDescriptor), MixedSigned, sizeof(MixedSigned), NULL, 0 },
+	{ "report IDs", ReportIDDescriptor, sizeof(ReportIDDescriptor), ReportIDSigned, sizeof(ReportIDSigned),
+	  ReportIDs, sizeof(ReportIDs) },
+};
+
+static HID_ReportInfo_t ParserData;
+static HID_ReportPlan_t Plan;
+static uint32_t Failures;
+
+bool CALLBACK_HIDParser_FilterHIDReportItem(HID_ReportItem_t* const CurrentItem)
+{
+	return true;
+}
+
+static uint32_t Random(void)
+{
+	static uint32_t State = 0x12345678;
+
+	State ^= State << 13;
+	State ^= State >> 17;
+	State ^= State << 5;
+	return State;
+}
+
+static uint64_t Nanoseconds(void)
+{
+	struct timespec Now;
+
+	clock_gettime(CLOCK_MONOTONIC, &Now);
+	return (uint64_t) Now.tv_sec * 1000000000ULL + Now.tv_nsec;
+}
+
+static void Check(const char *Name, bool Passed)
+{
+	printf("%-44s %s\n", Name, Passed ? "ok" : "FAILED");
+	if (!Passed)
+		Failures++;
+}
+
+/* The report items the plan was compiled from, in plan order */
+static uint8_t PlanItems(HID_ReportItem_t **Items)
+{
+	uint8_t Count = 0;
+	uint8_t i;
+
+	for (i = 0; i < ParserData.TotalReportItems; i++)
+	{
+		HID_ReportItem_t *Item = &ParserData.ReportItems[i];
+
+		if ((Item->ItemType == HID_REPORT_ITEM_In) && !(Item->ItemFlags & HID_IOF_CONSTANT) &&
+			Item->Attributes.BitSize && (Item->Attributes.BitSize <= 32))
+		{
+			Items[Count++] = Item;
+		}
+	}
+	return Count;
+}
+
+static int32_t SignExtend(uint32_t Value, uint8_t BitSize)
+{
+	if ((BitSize < 32) && (Value & (1UL << (BitSize - 1))))
+		Value |= ~((1UL << BitSize) - 1);
+	return (int32_t) Value;
+}
+
+static void RunCase(const Case_t *Case, uint32_t Reports)
+{
+	HID_ReportItem_t *Items[HID_MAX_PLAN_FIELDS];
+	uint8_t  Report[MAX_REPORT_BYTES];
+	int32_t  Values[HID_MAX_PLAN_FIELDS];
+	bool     InReport[HID_MAX_PLAN_FIELDS];
+	uint16_t ReportSize;
+	uint8_t  ItemCount, ReportID, f;
+	uint32_t n, i, Mismatches = 0, SignErrors = 0;
+	uint64_t PlanTime = 0, ItemTime = 0, Start;
+	bool     Parsed;
+
+	printf("\n%s\n", Case->Name);
+
+	Parsed = (USB_ProcessHIDReport(Case->Descriptor, Case->DescriptorSize, &ParserData) == HID_PARSE_Successful) &&
+			 (USB_CompileHIDReportPlan(&ParserData, HID_REPORT_ITEM_In, &Plan) == HID_PARSE_Successful);
+	ItemCount = PlanItems(Items);
+	Check("descriptor parsed and plan compiled", Parsed && (Plan.TotalFields == Case->Fields) && (ItemCount == Case->Fields));
+	if (!Parsed || (Plan.TotalFields != Case->Fields) || (ItemCount != Case->Fields))
+		return;
+
+	for (f = 0; f < Plan.TotalFields; f++)
+	{
+		if ((Plan.Fields[f].Signed != Case->Signed[f]) || (Items[f]->Attributes.LogicalSigned != Case->Signed[f]))
+			SignErrors++;
+	}
+	Check("signedness taken from the logical minimum", SignErrors == 0);
+
+	for (n = 0; n < Reports; n++)
+	{
+		ReportID = Case->ReportIDCount ? Case->ReportIDs[n % Case->ReportIDCount] : 0;
+		ReportSize = (USB_GetHIDReportSize(&ParserData, ReportID, HID_REPORT_ITEM_In) + (ReportID ? 1 : 0));
+
+		for (i = 0; i < MAX_REPORT_BYTES; i++)
+			Report[i] = Random();
+		if (ReportID)
+			Report[0] = ReportID;
+
+		memset(Values, 0, sizeof(Values));
+		Start = Nanoseconds();
+		USB_ExtractHIDReportFields(&Plan, Report, ReportSize, Values);
+		PlanTime += Nanoseconds() - Start;
+
+		Start = Nanoseconds();
+		for (f = 0; f < ItemCount; f++)
+			InReport[f] = USB_GetHIDReportItemInfo(Report, Items[f]);
+		ItemTime += Nanoseconds() - Start;
+
+		for (f = 0; f < ItemCount; f++)
+		{
+			int32_t Expected;
+
+			if (!InReport[f])
+				continue;
+
+			Expected = Case->Signed[f] ? SignExtend(Items[f]->Value, Items[f]->Attributes.BitSize) : (int32_t) Items[f]->Value;
+			if (Values[f] != Expected)
+				Mismatches++;
+		}
+	}
+
+	Check("plan matches USB_GetHIDReportItemInfo()", Mismatches == 0);
+	printf("  %u reports, %.0f ns per report from the plan, %.0f ns item by item\n", Reports,
+		   (double) PlanTime / Reports, (double) ItemTime / Reports);
+}
+
+/* The example of a field whose limits are encoded with different sizes */
+static void CheckNegativeSmallMinimum(void)
+{
+	uint8_t Report[13] = {0};
+	int32_t Values[HID_MAX_PLAN_FIELDS];
+
+	USB_ProcessHIDReport(MixedDescriptor, sizeof(MixedDescriptor), &ParserData);
+	USB_CompileHIDReportPlan(&ParserData, HID_REPORT_ITEM_In, &Plan);
+
+	Report[1] = 0x9C;		/* the 16 bit field starts at bit 8 */
+	Report[2] = 0xFF;
+	USB_ExtractHIDReportFields(&Plan, Report, sizeof(Report), Values);
+	Check("0xFF9C with minimum -100, maximum 1000 is -100", Values[4] == -100);
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t Reports = 100000;
+	uint32_t c;
+	int Option;
+
+	while ((Option = getopt(argc, argv, "n:")) != -1)
+	{
+		switch (Option)
+		{
+		case 'n': Reports = atoi(optarg); break;
+		default:
+			fprintf(stderr, "usage: %s [-n reports per descriptor]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	if (Reports < 1)
+	{
+		fprintf(stderr, "reports must be at least 1\n");
+		return 2;
+	}
+
+	for (c = 0; c < sizeof(Cases) / sizeof(Cases[0]); c++)
+		RunCase(&Cases[c], Reports);
+
+	printf("\n");
+	CheckNegativeSmallMinimum();
+
+	printf("\n%u failures\n", Failures);
+	return Failures ? 1 : 0;
+}
@@ -0,0 +1,375 @@
+/*
+ * hub_bench.c
+ *
+ * Hub class host check without hardware. The unmodified host stack with
+ * HubClassHost.c drives the OHCI model (OHCI_Model.c), which has a virtual
+ * four port hub (Hub_Device.c) on its root port with virtual Bulk-Only disks
+ * (MSC_Device.c) on the hub's ports. Each cycle plugs the hub in and checks
+ * that HUB_Host_USBTask():
+ *
+ *   - powers the ports and enumerates the disks through port reset and
+ *     status change reports, each at its own address,
+ *   - reports a port whose reset never completes as failed,
+ *   - lets both disks transfer with interleaved commands,
+ *   - closes the pipes and frees the address of an unplugged disk, leaves the
+ *     other disk running, and enumerates it again when plugged back in.
+ *
+ * The hub is then unplugged; the next cycle must find every pipe, endpoint
+ * and address free again.
+ *
+ * Build on x86-64 Linux, from cortex_m3_nxp/:
+ *
+ *   gcc -std=gnu99 -O2 -no-pie -fno-pie \
+ *       -D__LPC17XX__ -D__CODE_RED -DUSB_HOST_ONLY -DUSE_FREERTOS_DELAY=0 \
+ *       -Ihostsim -I../CMSIS_CORE_LPC17xx/inc \
+ *       -Ilpcusblib/Drivers/USB -Ilpcusblib/Drivers/USB/Class/Host \
+ *       hostsim/hub_bench.c hostsim/Hub_Device.c hostsim/MSC_Device.c hostsim/OHCI_Model.c hostsim/HAL_Sim.c \
+ *       lpcusblib/Drivers/USB/Core/[A-Z]*.c lpcusblib/Drivers/USB/Core/LPC/[A-Z]*.c \
+ *       lpcusblib/Drivers/USB/Core/LPC/HCD/HCD.c lpcusblib/Drivers/USB/Core/LPC/HCD/OHCI/OHCI.c \
+ *       lpcusblib/Drivers/USB/Class/Host/HubClassHost.c lpcusblib/Drivers/USB/Class/Host/MassStorageClassHost.c \
+ *       -o hub_bench
+ *
+ * Usage: hub_bench [-c plug cycles] [-n sectors per disk] [-t us per frame]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "USB.h"
+#include "HubClassHost.h"
+#include "MassStorageClassHost.h"
+
+#include "OHCI_Model.h"
+#include "Hub_Device.h"
+#include "MSC_Device.h"
+
+#define TIMEOUT_FRAMES				10000
+#define DISK_A_PORT					1
+#define STUCK_PORT					2
+#define DISK_B_PORT					3
+#define BLOCKS_PER_COMMAND			8
+#define IMAGE_MB					1
+
+static USB_ClassInfo_HUB_Host_t Hub_Interface = {
+	.Config = {
+		.StatusPipeNumber = 1,
+		.PortNumber = 0,
+	},
+};
+
+/* One mass storage instance per hub port, each with its own pipe numbers */
+static USB_ClassInfo_MS_Host_t Disk_MS_Interface[HUB_HOST_MAX_PORTS] = {
+	{ .Config = { .DataINPipeNumber = 2, .DataOUTPipeNumber = 3, .PortNumber = 0 } },
+	{ .Config = { .DataINPipeNumber = 4, .DataOUTPipeNumber = 5, .PortNumber = 0 } },
+	{ .Config = { .DataINPipeNumber = 6, .DataOUTPipeNumber = 7, .PortNumber = 0 } },
+	{ .Config = { .DataINPipeNumber = 8, .DataOUTPipeNumber = 9, .PortNumber = 0 } },
+};
+
+static Hub_Device_t VirtualHub;
+static MSC_Device_t DiskA;
+static MSC_Device_t DiskB;
+static MSC_Device_t DiskStuck;
+
+static volatile bool HubReady;
+static volatile bool HostError;
+static bool    DiskReady[HUB_HOST_MAX_PORTS + 1];
+static uint8_t PortError[HUB_HOST_MAX_PORTS + 1];
+static uint32_t Detached[HUB_HOST_MAX_PORTS + 1];
+static uint32_t Failures;
+
+/*==========================================================================*/
+/* Host stack events                                                       */
+/*==========================================================================*/
+void EVENT_USB_Host_DeviceEnumerationComplete(const uint8_t corenum)
+{
+	uint8_t  ConfigDescriptorData[256];
+	uint16_t ConfigDescriptorSize;
+
+	if (USB_Host_GetDeviceConfigDescriptor(corenum, 1, &ConfigDescriptorSize, ConfigDescriptorData,
+										   sizeof(ConfigDescriptorData)) != HOST_GETCONFIG_Successful) {
+		printf("Error Retrieving Configuration Descriptor.\n");
+		HostError = true;
+		return;
+	}
+
+	if (HUB_Host_ConfigurePipes(&Hub_Interface, ConfigDescriptorSize, ConfigDescriptorData) != HUB_ENUMERROR_NoError) {
+		printf("Attached Device Not a Valid Hub.\n");
+		HostError = true;
+		return;
+	}
+
+	if (USB_Host_SetDeviceConfiguration(corenum, 1) != HOST_SENDCONTROL_Successful) {
+		printf("Error Setting Device Configuration.\n");
+		HostError = true;
+		return;
+	}
+
+	HubReady = true;
+}
+
+void EVENT_USB_Host_HostError(const uint8_t corenum, const uint8_t ErrorCode)
+{
+	printf("Host Mode Error %d on port %d\n", ErrorCode, corenum);
+	HostError = true;
+}
+
+void EVENT_USB_Host_DeviceEnumerationFailed(const uint8_t corenum,
+											const uint8_t ErrorCode,
+											const uint8_t SubErrorCode)
+{
+	printf("Dev Enum Error %d/%d on port %d in state %d\n", ErrorCode, SubErrorCode, corenum, USB_HostState[corenum]);
+	HostError = true;
+}
+
+/* Configures the disk on a hub port, as an application would from this event */
+void EVENT_HUB_Host_DeviceAttached(USB_ClassInfo_HUB_Host_t* const HUBInterfaceInfo, const uint8_t Port)
+{
+	USB_ClassInfo_MS_Host_t* Disk = &Disk_MS_Interface[Port - 1];
+	uint8_t  portnum = HUBInterfaceInfo->Config.PortNumber;
+	uint8_t  ConfigDescriptorData[256];
+	uint16_t ConfigDescriptorSize;
+	uint8_t  MaxLUNIndex;
+
+	HUB_Host_SelectDevice(HUBInterfaceInfo, Port);
+	Disk->Config.PortNumber = portnum;
+
+	if ((USB_Host_GetDeviceConfigDescriptor(portnum, 1, &ConfigDescriptorSize, ConfigDescriptorData,
+											sizeof(ConfigDescriptorData)) != HOST_GETCONFIG_Successful) ||
+		(MS_Host_ConfigurePipes(Disk, ConfigDescriptorSize, ConfigDescriptorData) != MS_ENUMERROR_NoError) ||
+		(USB_Host_SetDeviceConfiguration(portnum, 1) != HOST_SENDCONTROL_Successful) ||
+		MS_Host_GetMaxLUN(Disk, &MaxLUNIndex) ||
+		MS_Host_TestUnitReady(Disk, 0))
+	{
+		printf("Port %u: mass storage setup failed\n", Port);
+		PortError[Port] = 0xFF;
+		return;
+	}
+
+	printf("Port %u: disk at address %u\n", Port, HUBInterfaceInfo->State.Ports[Port - 1].Address);
+	DiskReady[Port] = true;
+}
+
+void EVENT_HUB_Host_DeviceDetached(USB_ClassInfo_HUB_Host_t* const HUBInterfaceInfo, const uint8_t Port)
+{
+	Disk_MS_Interface[Port - 1].State.IsActive = false;
+	DiskReady[Port] = false;
+	Detached[Port]++;
+}
+
+void EVENT_HUB_Host_DeviceEnumerationFailed(USB_ClassInfo_HUB_Host_t* const HUBInterfaceInfo, const uint8_t Port,
+											const uint8_t ErrorCode)
+{
+	PortError[Port] = ErrorCode;
+}
+
+/*==========================================================================*/
+/* Checks                                                                  */
+/*==========================================================================*/
+static void Check(const char *Name, bool Passed)
+{
+	printf("%-44s %s\n", Name, Passed ? "ok" : "FAILED");
+	if (!Passed)
+		Failures++;
+}
+
+static void Service(void)
+{
+	HUB_Host_USBTask(&Hub_Interface);
+	USB_USBTask();
+}
+
+/* Runs the host until Done() holds, false on a timeout or host error */
+static bool RunUntil(bool (*Done)(void))
+{
+	uint64_t Start = OhciSim_GetFrameNumber();
+
+	while (!Done())
+	{
+		Service();
+
+		if (HostError || ((OhciSim_GetFrameNumber() - Start) > TIMEOUT_FRAMES))
+			return false;
+	}
+	return true;
+}
+
+static bool HubAndDisksReady(void)
+{
+	return HubReady && DiskReady[DISK_A_PORT] && DiskReady[DISK_B_PORT] && PortError[STUCK_PORT];
+}
+
+static bool DiskAGone(void)
+{
+	return Detached[DISK_A_PORT] != 0;
+}
+
+static bool DiskAReady(void)
+{
+	return DiskReady[DISK_A_PORT];
+}
+
+static bool HostUnattached(void)
+{
+	return (USB_HostState[0] == HOST_STATE_Unattached) && !Hub_Interface.State.IsActive;
+}
+
+static void FillSector(uint8_t Port, uint32_t Lba, uint8_t *Sector)
+{
+	uint32_t i;
+
+	for (i = 0; i < MSC_DEVICE_BLOCK_SIZE; i++)
+		Sector[i] = (uint8_t) (Port * 31 + Lba * 7 + i);
+}
+
+/* Writes and reads back Sectors on each listed port, one command per disk in turn */
+static bool TransferInterleaved(const uint8_t *Ports, uint8_t PortCount, uint32_t Sectors)
+{
+	static uint8_t Buffer[BLOCKS_PER_COMMAND * MSC_DEVICE_BLOCK_SIZE];
+	static uint8_t Expected[MSC_DEVICE_BLOCK_SIZE];
+	uint32_t Lba, Count, i;
+	uint8_t  p;
+	int      Pass;
+
+	for (Pass = 0; Pass < 2; Pass++)
+	{
+		for (Lba = 0; Lba < Sectors; Lba += Count)
+		{
+			Count = MIN(BLOCKS_PER_COMMAND, Sectors - Lba);
+
+			for (p = 0; p < PortCount; p++)
+			{
+				USB_ClassInfo_MS_Host_t* Disk = &Disk_MS_Interface[Ports[p] - 1];
+
+				if (Pass == 0)
+				{
+					for (i = 0; i < Count; i++)
+						FillSector(Ports[p], Lba + i, &Buffer[i * MSC_DEVICE_BLOCK_SIZE]);
+					if (MS_Host_WriteDeviceBlocks(Disk, 0, Lba, Count, MSC_DEVICE_BLOCK_SIZE, Buffer))
+						return false;
+				}
+				else
+				{
+					if (MS_Host_ReadDeviceBlocks(Disk, 0, Lba, Count, MSC_DEVICE_BLOCK_SIZE, Buffer))
+						return false;
+					for (i = 0; i < Count; i++)
+					{
+						FillSector(Ports[p], Lba + i, Expected);
+						if (memcmp(Expected, &Buffer[i * MSC_DEVICE_BLOCK_SIZE], MSC_DEVICE_BLOCK_SIZE))
+							return false;
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+static void RunCycle(uint32_t Cycle, uint32_t Sectors)
+{
+	static const uint8_t BothDisks[] = { DISK_A_PORT, DISK_B_PORT };
+	static const uint8_t DiskBOnly[] = { DISK_B_PORT };
+	uint64_t Start;
+	uint8_t  AddressA;
+
+	printf("\nCycle %u\n", Cycle);
+
+	HubReady = HostError = false;
+	memset(DiskReady, 0, sizeof(DiskReady));
+	memset(PortError, 0, sizeof(PortError));
+	memset(Detached, 0, sizeof(Detached));
+
+	VirtualHub.PortResets = VirtualHub.StatusRequests = VirtualHub.ChangeReports = 0;
+	Start = OhciSim_GetFrameNumber();
+	OhciSim_Attach(&VirtualHub.Device);
+	Check("hub and disks enumerated", RunUntil(HubAndDisksReady));
+	printf("  %llu frames, %llu port resets, %llu status requests, %llu change reports\n",
+		   (unsigned long long) (OhciSim_GetFrameNumber() - Start), (unsigned long long) VirtualHub.PortResets,
+		   (unsigned long long) VirtualHub.StatusRequests, (unsigned long long) VirtualHub.ChangeReports);
+	Check("stuck port reported as reset failure", PortError[STUCK_PORT] == HUB_PORTERROR_ResetFailed);
+	Check("disks have distinct addresses",
+		  Hub_Interface.State.Ports[DISK_A_PORT - 1].Address && Hub_Interface.State.Ports[DISK_B_PORT - 1].Address &&
+		  (Hub_Interface.State.Ports[DISK_A_PORT - 1].Address != Hub_Interface.State.Ports[DISK_B_PORT - 1].Address) &&
+		  (Hub_Interface.State.Ports[DISK_A_PORT - 1].Address != USB_HOST_DEVICEADDRESS));
+
+	if (!DiskReady[DISK_A_PORT] || !DiskReady[DISK_B_PORT])
+		return;
+
+	Check("interleaved transfers to both disks", TransferInterleaved(BothDisks, 2, Sectors));
+
+	AddressA = Hub_Interface.State.Ports[DISK_A_PORT - 1].Address;
+	Hub_Device_Detach(&VirtualHub, DISK_A_PORT);
+	Check("unplugged disk detached", RunUntil(DiskAGone) && !Hub_Interface.State.Ports[DISK_A_PORT - 1].Address);
+	Check("its pipes closed", (PipeInfo[0][Disk_MS_Interface[DISK_A_PORT - 1].Config.DataINPipeNumber].Buffer == NULL) &&
+							  (PipeInfo[0][Disk_MS_Interface[DISK_A_PORT - 1].Config.DataOUTPipeNumber].Buffer == NULL));
+	Check("other disk still transfers", TransferInterleaved(DiskBOnly, 1, Sectors));
+
+	Hub_Device_Attach(&VirtualHub, DISK_A_PORT, &DiskA.Device);
+	Check("replugged disk enumerated again", RunUntil(DiskAReady));
+	Check("its address was reused", Hub_Interface.State.Ports[DISK_A_PORT - 1].Address == AddressA);
+	Check("transfers to both disks after replug", TransferInterleaved(BothDisks, 2, Sectors));
+
+	OhciSim_Detach();
+	Check("hub unplugged, ports released", RunUntil(HostUnattached) && (Detached[DISK_A_PORT] == 1));
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t Cycles = 3;
+	uint32_t Sectors = 64;
+	uint32_t FramePeriodUS = 1000;
+	uint32_t Cycle;
+	int Option;
+
+	while ((Option = getopt(argc, argv, "c:n:t:")) != -1)
+	{
+		switch (Option)
+		{
+		case 'c': Cycles = atoi(optarg); break;
+		case 'n': Sectors = atoi(optarg); break;
+		case 't': FramePeriodUS = atoi(optarg); break;
+		default:
+			fprintf(stderr, "usage: %s [-c plug cycles] [-n sectors per disk] [-t us per frame]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	if ((Sectors < 1) || (Sectors > (IMAGE_MB << 11)) || (FramePeriodUS < 1))
+	{
+		fprintf(stderr, "sectors must be 1-%u, frame period at least 1 us\n", IMAGE_MB << 11);
+		return 2;
+	}
+
+	if (!MSC_Device_Init(&DiskA, "hub_bench_a.img", IMAGE_MB, 0) ||
+		!MSC_Device_Init(&DiskB, "hub_bench_b.img", IMAGE_MB, 0) ||
+		!MSC_Device_Init(&DiskStuck, "hub_bench_a.img", IMAGE_MB, 0))
+	{
+		fprintf(stderr, "cannot open the disk images\n");
+		return 1;
+	}
+
+	Hub_Device_Init(&VirtualHub, HUB_DEVICE_PORTS);
+	VirtualHub.Port[STUCK_PORT - 1].ResetStuck = true;
+	Hub_Device_Attach(&VirtualHub, DISK_A_PORT, &DiskA.Device);
+	Hub_Device_Attach(&VirtualHub, STUCK_PORT, &DiskStuck.Device);
+	Hub_Device_Attach(&VirtualHub, DISK_B_PORT, &DiskB.Device);
+
+	if (!OhciSim_Init(FramePeriodUS))
+	{
+		fprintf(stderr, "cannot start the OHCI model\n");
+		return 1;
+	}
+
+	USB_Init();
+
+	for (Cycle = 1; Cycle <= Cycles; Cycle++)
+		RunCycle(Cycle, Sectors);
+
+	printf("\n%u failures\n", Failures);
+
+	OhciSim_DeInit();
+	MSC_Device_Close(&DiskA);
+	MSC_Device_Close(&DiskB);
+	MSC_Device_Close(&DiskStuck);
+	return Failures ? 1 : 0;
+}
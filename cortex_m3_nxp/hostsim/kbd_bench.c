@@ -0,0 +1,370 @@
+/*
+ * kbd_bench.c
+ *
+ * Keyboard host report path test without hardware. The unmodified keyboard
+ * host (USBKeyboardHost.c over HIDClassHost.c) enumerates the virtual boot
+ * keyboard (Keyboard_Device.c) through the OHCI model and streams its
+ * interrupt IN pipe with Pipe_StartINStream(). Text is then typed on the
+ * keyboard, a press and a release report per character, and read back with
+ * KeyboardHost_GetKeyEvent() while USB_USBTask() is not called at all, so
+ * every report has to come through the completion callback of the pipe,
+ * queued again by the interrupt.
+ *
+ * Each plug cycle types the text and checks it back, then types it again and
+ * unplugs the keyboard halfway through: no key event may arrive after the
+ * unplug, and the next cycle must enumerate and stream as the first did.
+ *
+ * The FreeRTOS calls of the keyboard host are implemented here on the frame
+ * counter (see FreeRTOS.h), and the stack is built with USE_FREERTOS_DELAY so
+ * its waits sleep in vTaskDelay() as on the board. usbHostKeyboard() never
+ * returns, so its loop, KeyboardHost_USBTask(), is run here instead; its
+ * report semaphore stays NULL and the single binary semaphore below stands
+ * for it. Enumeration has to finish within 100 frames of the waits the host
+ * makes itself, so the loop must not add its polling period to them.
+ *
+ * Build on x86-64 Linux, from cortex_m3_nxp/:
+ *
+ *   gcc -std=gnu99 -O2 -no-pie -fno-pie \
+ *       -D__LPC17XX__ -D__CODE_RED -DUSB_HOST_ONLY -DUSE_FREERTOS_DELAY=1 \
+ *       -Ihostsim -I../CMSIS_CORE_LPC17xx/inc -Iinc \
+ *       -Ilpcusblib/Drivers/USB -Ilpcusblib/Drivers/USB/Class/Host -Ilpcusblib/user_config/host \
+ *       hostsim/kbd_bench.c hostsim/Keyboard_Device.c hostsim/OHCI_Model.c hostsim/HAL_Sim.c \
+ *       lpcusblib/Drivers/USB/Core/[A-Z]*.c lpcusblib/Drivers/USB/Core/LPC/[A-Z]*.c \
+ *       lpcusblib/Drivers/USB/Core/LPC/HCD/HCD.c lpcusblib/Drivers/USB/Core/LPC/HCD/OHCI/OHCI.c \
+ *       lpcusblib/Drivers/USB/Class/Host/HIDClassHost.c lpcusblib/Drivers/USB/Class/Common/HIDParser.c \
+ *       lpcusblib/user_config/host/USBKeyboardHost.c \
+ *       -o kbd_bench
+ *
+ * Usage: kbd_bench [-c plug cycles] [-t us per frame] [-v]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "USBKeyboardHost.h"
+#include "uart.h"
+
+#include "OHCI_Model.h"
+#include "Keyboard_Device.h"
+
+#define TIMEOUT_FRAMES				10000
+/* The waits of the host itself: device settle, connect, two root hub port resets of 800 ms
+   with 200 ms of recovery each, and the wait after SET_ADDRESS; then 100 frames of slack */
+#define ENUMERATION_WAIT_MS			(HOST_DEVICE_SETTLE_DELAY_MS + 100 + 2 * (800 + 200) + 100)
+#define ENUMERATION_FRAMES			(ENUMERATION_WAIT_MS + 100)
+#define EVENT_WAIT_TICKS			200			/* longest gap between two key events of the typed text */
+#define QUIET_TICKS					100			/* time given to stray events after the unplug */
+
+static const char Text[] = "The quick brown fox jumps over the lazy dog 1234567890\n";
+
+static Keyboard_Device_t VirtualKeyboard;
+static char     Console[4096];
+static uint32_t ConsoleLength;
+static bool     Verbose;
+static uint32_t Failures;
+
+static volatile sig_atomic_t SemaphoreGiven;
+
+/*==========================================================================*/
+/* FreeRTOS and UART stand-ins                                             */
+/*==========================================================================*/
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+	return (SemaphoreHandle_t) &SemaphoreGiven;
+}
+
+portBASE_TYPE xSemaphoreTake(SemaphoreHandle_t Semaphore, portTickType Wait)
+{
+	uint64_t Start = OhciSim_GetFrameNumber();
+
+	while (!SemaphoreGiven)
+	{
+		if ((Wait != portMAX_DELAY) && ((OhciSim_GetFrameNumber() - Start) >= Wait))
+			return pdFALSE;
+		usleep(50);
+	}
+
+	SemaphoreGiven = 0;
+	return pdTRUE;
+}
+
+portBASE_TYPE xSemaphoreGiveFromISR(SemaphoreHandle_t Semaphore, portBASE_TYPE *TaskWoken)
+{
+	SemaphoreGiven = 1;
+	*TaskWoken = pdTRUE;
+	return pdTRUE;
+}
+
+void vTaskDelay(portTickType Ticks)
+{
+	uint64_t Start = OhciSim_GetFrameNumber();
+
+	while ((OhciSim_GetFrameNumber() - Start) < Ticks)
+		usleep(50);
+}
+
+portBASE_TYPE xTaskGetSchedulerState(void)
+{
+	return taskSCHEDULER_RUNNING;
+}
+
+uint32_t NvicSim_GetIPSR(void)
+{
+	return OhciSim_InInterrupt() ? (USB_IRQn + 16) : 0;
+}
+
+/* Console of the keyboard host, kept to find its messages */
+void UARTSendStr(uint32_t portNum, char *BufferPtr)
+{
+	uint32_t Length = strlen(BufferPtr);
+
+	if (Verbose)
+		fputs(BufferPtr, stdout);
+
+	if (ConsoleLength + Length >= sizeof(Console))
+		ConsoleLength = 0;
+	memcpy(&Console[ConsoleLength], BufferPtr, Length + 1);
+	ConsoleLength += Length;
+}
+
+void UARTPutChar(uint32_t portNum, char c)
+{
+	char String[2] = {c, 0};
+
+	UARTSendStr(portNum, String);
+}
+
+/*==========================================================================*/
+/* Keyboard side                                                           */
+/*==========================================================================*/
+static void Check(const char *Name, bool Passed)
+{
+	printf("  %-52s %s\n", Name, Passed ? "ok" : "FAILED");
+	if (!Passed)
+		Failures++;
+}
+
+static bool ConsoleSays(const char *Message)
+{
+	return strstr(Console, Message) != NULL;
+}
+
+/* Usage ID and shift state of a character of the text */
+static uint8_t KeyCodeOf(char c, bool *Shift)
+{
+	*Shift = false;
+
+	if ((c >= 'a') && (c <= 'z'))
+		return HID_KEYBOARD_SC_A + (c - 'a');
+	if ((c >= 'A') && (c <= 'Z'))
+	{
+		*Shift = true;
+		return HID_KEYBOARD_SC_A + (c - 'A');
+	}
+	if ((c >= '1') && (c <= '9'))
+		return HID_KEYBOARD_SC_1_AND_EXCLAMATION + (c - '1');
+	if (c == '0')
+		return HID_KEYBOARD_SC_0_AND_CLOSING_PARENTHESIS;
+	if (c == ' ')
+		return HID_KEYBOARD_SC_SPACE;
+	return HID_KEYBOARD_SC_ENTER;
+}
+
+/* A press and a release report per character, with a phantom (rollover) report on every tenth key held down */
+static uint32_t TypeText(const char *String)
+{
+	static const uint8_t Rollover[6] = {
+		HID_KEYBOARD_SC_ERROR_ROLLOVER, HID_KEYBOARD_SC_ERROR_ROLLOVER, HID_KEYBOARD_SC_ERROR_ROLLOVER,
+		HID_KEYBOARD_SC_ERROR_ROLLOVER, HID_KEYBOARD_SC_ERROR_ROLLOVER, HID_KEYBOARD_SC_ERROR_ROLLOVER
+	};
+	uint32_t Reports = 0;
+	uint32_t i;
+
+	for (i = 0; String[i]; i++)
+	{
+		bool    Shift;
+		uint8_t KeyCode = KeyCodeOf(String[i], &Shift);
+		uint8_t Modifier = Shift ? HID_KEYBOARD_MODIFER_LEFTSHIFT : 0;
+
+		Keyboard_Device_QueueReport(&VirtualKeyboard, Modifier, &KeyCode, 1);
+		Reports++;
+		if ((i % 10) == 9)
+		{
+			Keyboard_Device_QueueReport(&VirtualKeyboard, Modifier, Rollover, sizeof(Rollover));
+			Reports++;
+		}
+		Keyboard_Device_QueueReport(&VirtualKeyboard, 0, NULL, 0);
+		Reports++;
+	}
+
+	return Reports;
+}
+
+/* Character of a press event, as KeyboardHost_Task() prints it */
+static char CharacterOf(const KeyboardHost_KeyEvent_t *Event)
+{
+	bool Shift = (Event->Modifiers & (HID_KEYBOARD_MODIFER_LEFTSHIFT | HID_KEYBOARD_MODIFER_RIGHTSHIFT)) != 0;
+
+	if ((Event->KeyCode >= HID_KEYBOARD_SC_A) && (Event->KeyCode <= HID_KEYBOARD_SC_Z))
+		return (Event->KeyCode - HID_KEYBOARD_SC_A) + (Shift ? 'A' : 'a');
+	if ((Event->KeyCode >= HID_KEYBOARD_SC_1_AND_EXCLAMATION) && (Event->KeyCode < HID_KEYBOARD_SC_0_AND_CLOSING_PARENTHESIS))
+		return (Event->KeyCode - HID_KEYBOARD_SC_1_AND_EXCLAMATION) + '1';
+	if (Event->KeyCode == HID_KEYBOARD_SC_0_AND_CLOSING_PARENTHESIS)
+		return '0';
+	if (Event->KeyCode == HID_KEYBOARD_SC_SPACE)
+		return ' ';
+	if (Event->KeyCode == HID_KEYBOARD_SC_ENTER)
+		return '\n';
+	return 0;
+}
+
+/* Reads key events until Length characters came or no event comes for Wait ticks */
+static uint32_t ReadText(char *Buffer, uint32_t Length, portTickType Wait, uint32_t *Presses, uint32_t *Releases)
+{
+	KeyboardHost_KeyEvent_t Event;
+	uint32_t Count = 0;
+
+	*Presses = *Releases = 0;
+
+	while ((Count < Length) && KeyboardHost_GetKeyEvent(&Event, Wait))
+	{
+		char c;
+
+		if (!(Event.Pressed))
+		{
+			(*Releases)++;
+			continue;
+		}
+
+		(*Presses)++;
+		if ((c = CharacterOf(&Event)) != 0)
+			Buffer[Count++] = c;
+	}
+
+	Buffer[Count] = 0;
+	return Count;
+}
+
+/*==========================================================================*/
+/* Main                                                                    */
+/*==========================================================================*/
+static bool Enumerate(uint64_t *Frames)
+{
+	uint64_t Start = OhciSim_GetFrameNumber();
+
+	ConsoleLength = 0;
+	Console[0] = 0;
+	OhciSim_Attach(&VirtualKeyboard.Device);
+
+	/* The loop of usbHostKeyboard() */
+	while (!ConsoleSays("Keyboard Enumerated.") && ((OhciSim_GetFrameNumber() - Start) < TIMEOUT_FRAMES))
+	{
+		KeyboardHost_USBTask();
+	}
+
+	*Frames = OhciSim_GetFrameNumber() - Start;
+	return ConsoleSays("Keyboard Enumerated.");
+}
+
+static void RunCycle(uint32_t Cycle)
+{
+	char     Typed[sizeof(Text) * 2];
+	uint32_t Reports, Received, Presses, Releases, Shifts;
+	uint64_t Start, Frames, Sent, Polls;
+	KeyboardHost_KeyEvent_t Event;
+
+	printf("\ncycle %u\n", Cycle);
+
+	Check("keyboard enumerated and report stream started", Enumerate(&Frames));
+	if (!ConsoleSays("Keyboard Enumerated."))
+		return;
+	Check("enumerated within 100 frames of the host's own waits", Frames < ENUMERATION_FRAMES);
+	printf("  enumerated in %llu frames\n", (unsigned long long) Frames);
+	Check("boot protocol selected", VirtualKeyboard.Protocol == 0);
+
+	/* The whole text through the interrupt, USB_USBTask() is not called from here on */
+	Sent    = VirtualKeyboard.ReportsSent;
+	Polls   = VirtualKeyboard.Polls;
+	Start   = OhciSim_GetFrameNumber();
+	Reports = TypeText(Text);
+	Shifts  = 1;			/* the capital T */
+
+	Received = ReadText(Typed, sizeof(Text) - 1, EVENT_WAIT_TICKS, &Presses, &Releases);
+	Frames   = OhciSim_GetFrameNumber() - Start;
+	/* The release of the last key and its shift come after the last character */
+	while (KeyboardHost_GetKeyEvent(&Event, EVENT_WAIT_TICKS))
+	{
+		if (Event.Pressed)
+			Presses++;
+		else
+			Releases++;
+	}
+	Sent  = VirtualKeyboard.ReportsSent - Sent;
+	Polls = VirtualKeyboard.Polls - Polls;
+
+	Check("typed text read back from the key events", (Received == sizeof(Text) - 1) && !strcmp(Typed, Text));
+	Check("every report taken, one per poll at most", (Sent == Reports) && (Polls >= Sent));
+	Check("a release for every press, rollover ignored", (Presses == sizeof(Text) - 1 + Shifts) && (Releases == Presses));
+	printf("  last character after %llu frames, %.1f frames per report at a %u frame interval\n",
+		   (unsigned long long) Frames, (double) Frames / (Reports - 1), KEYBOARD_DEVICE_INTERVAL);
+
+	/* Again, unplugged halfway through */
+	TypeText(Text);
+	ReadText(Typed, (sizeof(Text) - 1) / 2, EVENT_WAIT_TICKS, &Presses, &Releases);
+	OhciSim_Detach();
+
+	Start = OhciSim_GetFrameNumber();
+	while (!ConsoleSays("Device Unattached") && ((OhciSim_GetFrameNumber() - Start) < TIMEOUT_FRAMES))
+		KeyboardHost_USBTask();
+	Check("unplug seen by the keyboard host", ConsoleSays("Device Unattached"));
+
+	/* Reports already in the queue are still handed out, nothing may follow them */
+	while (KeyboardHost_GetKeyEvent(&Event, 0)) {}
+	Check("no key event after the unplug", !KeyboardHost_GetKeyEvent(&Event, QUIET_TICKS));
+	Check("report pipe closed", PipeInfo[0][1].PipeHandle == 0);
+
+	/* What the keyboard had left to send is lost with it */
+	VirtualKeyboard.QueueTail = VirtualKeyboard.QueueHead;
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t Cycles = 3;
+	uint32_t FramePeriodUS = 1000;
+	uint32_t c;
+	int Option;
+
+	while ((Option = getopt(argc, argv, "c:t:v")) != -1)
+	{
+		switch (Option)
+		{
+		case 'c': Cycles = atoi(optarg); break;
+		case 't': FramePeriodUS = atoi(optarg); break;
+		case 'v': Verbose = true; break;
+		default:
+			fprintf(stderr, "usage: %s [-c plug cycles] [-t us per frame] [-v]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	Keyboard_Device_Init(&VirtualKeyboard);
+
+	if ((FramePeriodUS < 1) || !OhciSim_Init(FramePeriodUS))
+	{
+		fprintf(stderr, "cannot start the OHCI model\n");
+		return 1;
+	}
+
+	USB_Init();
+
+	for (c = 1; c <= Cycles; c++)
+		RunCycle(c);
+
+	printf("\n%u failures\n", Failures);
+
+	OhciSim_DeInit();
+	return Failures ? 1 : 0;
+}
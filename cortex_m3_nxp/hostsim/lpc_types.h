@@ -0,0 +1,15 @@
+/*
+ * lpc_types.h
+ *
+ * Host simulation stand-in for the NXP peripheral library type header, which
+ * is not part of this tree. Declares the types the EHCI host driver uses.
+ */
+
+#ifndef HOSTSIM_LPC_TYPES_H_
+#define HOSTSIM_LPC_TYPES_H_
+
+#include <stdint.h>
+
+typedef enum {FALSE = 0, TRUE = !FALSE} Bool;
+
+#endif /* HOSTSIM_LPC_TYPES_H_ */
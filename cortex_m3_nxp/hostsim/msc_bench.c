@@ -0,0 +1,392 @@
+/*
+ * msc_bench.c
+ *
+ * Mass storage host benchmark without hardware. The unmodified host stack
+ * (Host_LPC.c, HCD.c, OHCI.c, MassStorageClassHost.c) drives the OHCI model
+ * (OHCI_Model.c) which talks to a virtual Bulk-Only disk (MSC_Device.c).
+ * Throughput and commands per second are given in virtual bus time, so they
+ * measure how well a change keeps the 12 Mbit/s bus busy; cycles per sector
+ * is the host CPU time spent outside the model, completion polling included.
+ *
+ * Build on x86-64 Linux, from cortex_m3_nxp/:
+ *
+ *   gcc -std=gnu99 -O2 -no-pie -fno-pie \
+ *       -D__LPC17XX__ -D__CODE_RED -DUSB_HOST_ONLY -DUSE_FREERTOS_DELAY=0 \
+ *       -Ihostsim -I../CMSIS_CORE_LPC17xx/inc \
+ *       -Ilpcusblib/Drivers/USB -Ilpcusblib/Drivers/USB/Class/Host \
+ *       hostsim/msc_bench.c hostsim/MSC_Device.c hostsim/OHCI_Model.c hostsim/HAL_Sim.c \
+ *       lpcusblib/Drivers/USB/Core/[A-Z]*.c lpcusblib/Drivers/USB/Core/LPC/[A-Z]*.c \
+ *       lpcusblib/Drivers/USB/Core/LPC/HCD/HCD.c lpcusblib/Drivers/USB/Core/LPC/HCD/OHCI/OHCI.c \
+ *       lpcusblib/Drivers/USB/Class/Host/MassStorageClassHost.c \
+ *       -o msc_bench
+ *
+ * Usage: msc_bench [-i image] [-s image MB] [-m MB per test] [-b blocks per command]
+ *                  [-S blocks per streamed command] [-t us per frame] [-l access latency in frames]
+ *
+ * The image is created (sparse) when it does not exist. The write test fills
+ * the tested range with a pattern which the read tests then verify. The disk
+ * is then unplugged and plugged back in: the second enumeration finds its
+ * configuration descriptor in the host's cache and configures in fewer frames.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "USB.h"
+#include "MassStorageClassHost.h"
+
+#include "OHCI_Model.h"
+#include "MSC_Device.h"
+
+#define ENUMERATION_TIMEOUT_FRAMES		10000
+
+typedef struct {
+	uint64_t        Tsc;
+	OhciSim_Stats_t Sim;
+	uint64_t        Commands;
+} Sample_t;
+
+static USB_ClassInfo_MS_Host_t Disk_MS_Interface = {
+	.Config = {
+		.DataINPipeNumber       = 1,
+		.DataINPipeDoubleBank   = false,
+
+		.DataOUTPipeNumber      = 2,
+		.DataOUTPipeDoubleBank  = false,
+		.PortNumber = 0,
+	},
+};
+
+static MSC_Device_t VirtualDisk;
+static volatile bool Enumerated;
+static volatile bool EnumerationError;
+static uint64_t ConfigureFrames;	/* spent in EVENT_USB_Host_DeviceEnumerationComplete() */
+
+static uint64_t ExcludedCycles;		/* pattern generation and verification, not part of the stack */
+static uint64_t VerifyErrors;
+static uint32_t StreamLba;
+static uint32_t StreamOffset;
+
+/*==========================================================================*/
+/* Host stack events                                                       */
+/*==========================================================================*/
+void EVENT_USB_Host_DeviceEnumerationComplete(const uint8_t corenum)
+{
+	USB_Host_IndexedConfig_t* Config;
+
+	ConfigureFrames = OhciSim_GetFrameNumber();
+
+	if (USB_Host_GetIndexedConfigDescriptor(corenum, 1, &Config) != HOST_GETCONFIG_Successful) {
+		printf("Error Retrieving Configuration Descriptor.\n");
+		EnumerationError = true;
+		return;
+	}
+
+	Disk_MS_Interface.Config.PortNumber = corenum;
+	if (MS_Host_ConfigurePipesIndexed(&Disk_MS_Interface, Config) != MS_ENUMERROR_NoError) {
+		printf("Attached Device Not a Valid Mass Storage Device.\n");
+		EnumerationError = true;
+		return;
+	}
+
+	if (USB_Host_SetDeviceConfiguration(corenum, 1) != HOST_SENDCONTROL_Successful) {
+		printf("Error Setting Device Configuration.\n");
+		EnumerationError = true;
+		return;
+	}
+
+	ConfigureFrames = OhciSim_GetFrameNumber() - ConfigureFrames;
+	Enumerated = true;
+}
+
+void EVENT_USB_Host_HostError(const uint8_t corenum, const uint8_t ErrorCode)
+{
+	printf("Host Mode Error %d on port %d\n", ErrorCode, corenum);
+	EnumerationError = true;
+}
+
+void EVENT_USB_Host_DeviceEnumerationFailed(const uint8_t corenum,
+											const uint8_t ErrorCode,
+											const uint8_t SubErrorCode)
+{
+	printf("Dev Enum Error %d/%d on port %d in state %d\n", ErrorCode, SubErrorCode, corenum, USB_HostState[corenum]);
+	EnumerationError = true;
+}
+
+/*==========================================================================*/
+/* Measurement                                                             */
+/*==========================================================================*/
+static void TakeSample(Sample_t *Sample)
+{
+	OhciSim_GetStats(&Sample->Sim);
+	Sample->Commands = VirtualDisk.Commands;
+	Sample->Tsc = OhciSim_ReadTSC();
+}
+
+static void Report(const char *Name, const Sample_t *Start, const Sample_t *End, uint32_t Sectors, uint8_t ErrorCode)
+{
+	uint64_t Frames   = End->Sim.Frames - Start->Sim.Frames;
+	uint64_t Commands = End->Commands - Start->Commands;
+	int64_t  Host     = (int64_t) (End->Tsc - Start->Tsc) - (int64_t) (End->Sim.OverheadCycles - Start->Sim.OverheadCycles) - (int64_t) ExcludedCycles;
+	double   Seconds  = (Frames ? Frames : 1) / 1000.0;
+
+	/* The model overhead and the excluded cycles are measured separately, their sum can
+	   exceed a short run when the host is preempted */
+	if (Host < 0)
+		Host = 0;
+
+	printf("%-8s %8u %9.3f %9.1f %12.0f %10.2f %8llu %6llu %s\n", Name, Sectors,
+		   ((double) Sectors * MSC_DEVICE_BLOCK_SIZE) / Seconds / 1e6,
+		   Commands / Seconds,
+		   Sectors ? (double) Host / Sectors : 0.0,
+		   Sectors ? (double) (End->Sim.RegisterAccesses - Start->Sim.RegisterAccesses) / Sectors : 0.0,
+		   (unsigned long long) (End->Sim.Naks - Start->Sim.Naks),
+		   (unsigned long long) Frames,
+		   ErrorCode ? "FAILED" : (VerifyErrors ? "MISMATCH" : "ok"));
+}
+
+static void FillSector(uint32_t Lba, uint8_t *Sector)
+{
+	uint32_t i;
+
+	for (i = 0; i < MSC_DEVICE_BLOCK_SIZE; i++)
+		Sector[i] = (uint8_t) (Lba * 7 + i + (i >> 8));
+}
+
+static void VerifySectors(uint32_t Lba, const uint8_t *Data, uint32_t Length)
+{
+	uint8_t  Expected[MSC_DEVICE_BLOCK_SIZE];
+	uint64_t Start = OhciSim_ReadTSC();
+
+	while (Length >= MSC_DEVICE_BLOCK_SIZE)
+	{
+		FillSector(Lba++, Expected);
+		if (memcmp(Expected, Data, MSC_DEVICE_BLOCK_SIZE))
+			VerifyErrors++;
+		Data   += MSC_DEVICE_BLOCK_SIZE;
+		Length -= MSC_DEVICE_BLOCK_SIZE;
+	}
+	ExcludedCycles += OhciSim_ReadTSC() - Start;
+}
+
+/* MS_Host_ReadDeviceBlocksStream() chunks need not be sector aligned, verify through a staging sector */
+static void StreamChunk(const uint8_t* const Data, const uint16_t Length, void* const Context)
+{
+	static uint8_t Sector[MSC_DEVICE_BLOCK_SIZE];
+	uint16_t Count;
+	uint16_t Done = 0;
+
+	while (Done < Length)
+	{
+		Count = MIN(Length - Done, MSC_DEVICE_BLOCK_SIZE - StreamOffset);
+		memcpy(&Sector[StreamOffset], &Data[Done], Count);
+		StreamOffset += Count;
+		Done += Count;
+		if (StreamOffset == MSC_DEVICE_BLOCK_SIZE)
+		{
+			VerifySectors(StreamLba++, Sector, MSC_DEVICE_BLOCK_SIZE);
+			StreamOffset = 0;
+		}
+	}
+}
+
+/*==========================================================================*/
+/* Tests                                                                   */
+/*==========================================================================*/
+static void TestWrite(uint32_t Sectors, uint8_t BlocksPerCommand, uint8_t *Buffer)
+{
+	Sample_t Start, End;
+	uint8_t  ErrorCode = 0;
+	uint32_t Lba, Count, i;
+	uint64_t Fill;
+
+	ExcludedCycles = VerifyErrors = 0;
+	TakeSample(&Start);
+	for (Lba = 0; (Lba < Sectors) && !ErrorCode; Lba += Count)
+	{
+		Count = MIN(BlocksPerCommand, Sectors - Lba);
+
+		Fill = OhciSim_ReadTSC();
+		for (i = 0; i < Count; i++)
+			FillSector(Lba + i, &Buffer[i * MSC_DEVICE_BLOCK_SIZE]);
+		ExcludedCycles += OhciSim_ReadTSC() - Fill;
+
+		ErrorCode = MS_Host_WriteDeviceBlocks(&Disk_MS_Interface, 0, Lba, Count, MSC_DEVICE_BLOCK_SIZE, Buffer);
+	}
+	TakeSample(&End);
+	Report("write", &Start, &End, Sectors, ErrorCode);
+}
+
+static void TestRead(uint32_t Sectors, uint8_t BlocksPerCommand, uint8_t *Buffer)
+{
+	Sample_t Start, End;
+	uint8_t  ErrorCode = 0;
+	uint32_t Lba, Count;
+
+	ExcludedCycles = VerifyErrors = 0;
+	TakeSample(&Start);
+	for (Lba = 0; (Lba < Sectors) && !ErrorCode; Lba += Count)
+	{
+		Count = MIN(BlocksPerCommand, Sectors - Lba);
+		ErrorCode = MS_Host_ReadDeviceBlocks(&Disk_MS_Interface, 0, Lba, Count, MSC_DEVICE_BLOCK_SIZE, Buffer);
+		if (!ErrorCode)
+			VerifySectors(Lba, Buffer, Count * MSC_DEVICE_BLOCK_SIZE);
+	}
+	TakeSample(&End);
+	Report("read", &Start, &End, Sectors, ErrorCode);
+}
+
+static void TestStream(uint32_t Sectors, uint16_t BlocksPerCommand)
+{
+	Sample_t Start, End;
+	uint8_t  ErrorCode = 0;
+	uint32_t Lba, Count;
+
+	ExcludedCycles = VerifyErrors = 0;
+	StreamLba = StreamOffset = 0;
+	TakeSample(&Start);
+	for (Lba = 0; (Lba < Sectors) && !ErrorCode; Lba += Count)
+	{
+		Count = MIN(BlocksPerCommand, Sectors - Lba);
+		ErrorCode = MS_Host_ReadDeviceBlocksStream(&Disk_MS_Interface, 0, Lba, Count, MSC_DEVICE_BLOCK_SIZE, StreamChunk, NULL);
+	}
+	TakeSample(&End);
+	Report("stream", &Start, &End, Sectors, ErrorCode);
+}
+
+/*==========================================================================*/
+/* Main                                                                    */
+/*==========================================================================*/
+static bool EnumerateDisk(void)
+{
+	uint64_t Start = OhciSim_GetFrameNumber();
+	SCSI_Capacity_t Capacity;
+	uint8_t MaxLUNIndex;
+
+	Enumerated = false;
+	OhciSim_Attach(&VirtualDisk.Device);
+
+	while (!Enumerated && !EnumerationError)
+	{
+		MS_Host_USBTask(&Disk_MS_Interface);
+		USB_USBTask();
+
+		if ((OhciSim_GetFrameNumber() - Start) > ENUMERATION_TIMEOUT_FRAMES)
+		{
+			printf("Enumeration timed out in host state %d\n", USB_HostState[0]);
+			return false;
+		}
+	}
+
+	if (EnumerationError ||
+		MS_Host_GetMaxLUN(&Disk_MS_Interface, &MaxLUNIndex) ||
+		MS_Host_TestUnitReady(&Disk_MS_Interface, 0) ||
+		MS_Host_ReadDeviceCapacity(&Disk_MS_Interface, 0, &Capacity))
+	{
+		printf("Mass storage setup failed\n");
+		return false;
+	}
+
+	printf("Enumerated in %llu frames, %llu of them configuring: %lu blocks of %lu bytes\n",
+		   (unsigned long long) (OhciSim_GetFrameNumber() - Start), (unsigned long long) ConfigureFrames,
+		   (unsigned long) Capacity.Blocks, (unsigned long) Capacity.BlockSize);
+	return true;
+}
+
+/* Unplugs and plugs the disk back in, it then enumerates from the cached configuration descriptor */
+static bool ReattachDisk(void)
+{
+	uint64_t Start = OhciSim_GetFrameNumber();
+
+	OhciSim_Detach();
+
+	while (USB_HostState[0] != HOST_STATE_Unattached)
+	{
+		USB_USBTask();
+
+		if ((OhciSim_GetFrameNumber() - Start) > ENUMERATION_TIMEOUT_FRAMES)
+		{
+			printf("Detach timed out in host state %d\n", USB_HostState[0]);
+			return false;
+		}
+	}
+
+	printf("\nRe-attached: ");
+	return EnumerateDisk();
+}
+
+int main(int argc, char *argv[])
+{
+	const char *Image = "msc_bench.img";
+	uint32_t ImageMB = 16;
+	uint32_t TestMB = 2;
+	uint32_t BlocksPerCommand = 8;
+	uint32_t StreamBlocks = 128;
+	uint32_t FramePeriodUS = 1000;
+	uint32_t AccessLatency = 0;
+	uint32_t Sectors;
+	uint8_t *Buffer;
+	int Option;
+
+	while ((Option = getopt(argc, argv, "i:s:m:b:S:t:l:")) != -1)
+	{
+		switch (Option)
+		{
+		case 'i': Image = optarg; break;
+		case 's': ImageMB = atoi(optarg); break;
+		case 'm': TestMB = atoi(optarg); break;
+		case 'b': BlocksPerCommand = atoi(optarg); break;
+		case 'S': StreamBlocks = atoi(optarg); break;
+		case 't': FramePeriodUS = atoi(optarg); break;
+		case 'l': AccessLatency = atoi(optarg); break;
+		default:
+			fprintf(stderr, "usage: %s [-i image] [-s image MB] [-m MB per test] [-b blocks per command]\n"
+							"       [-S blocks per streamed command] [-t us per frame] [-l access latency in frames]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	if ((BlocksPerCommand < 1) || (BlocksPerCommand > 255) || (StreamBlocks < 1) || (StreamBlocks > 65535) || (FramePeriodUS < 1))
+	{
+		fprintf(stderr, "blocks per command must be 1-255, streamed 1-65535, frame period at least 1 us\n");
+		return 2;
+	}
+
+	if (!MSC_Device_Init(&VirtualDisk, Image, ImageMB, AccessLatency))
+	{
+		fprintf(stderr, "cannot open image %s\n", Image);
+		return 1;
+	}
+
+	Sectors = MIN((uint64_t) TestMB << 11, VirtualDisk.Blocks);
+	Buffer = malloc(BlocksPerCommand * MSC_DEVICE_BLOCK_SIZE);
+
+	if ((Buffer == NULL) || !OhciSim_Init(FramePeriodUS))
+	{
+		fprintf(stderr, "cannot start the OHCI model\n");
+		return 1;
+	}
+
+	USB_Init();
+
+	if (!EnumerateDisk())
+		return 1;
+
+	printf("%u sectors per test, %u blocks per command, %u per streamed command, %u us per frame, latency %u frames\n\n",
+		   Sectors, BlocksPerCommand, StreamBlocks, FramePeriodUS, AccessLatency);
+	printf("%-8s %8s %9s %9s %12s %10s %8s %6s\n", "test", "sectors", "MB/s", "cmds/s", "cycles/sect", "regs/sect", "naks", "frames");
+
+	TestWrite(Sectors, BlocksPerCommand, Buffer);
+	TestRead(Sectors, BlocksPerCommand, Buffer);
+	TestStream(Sectors, StreamBlocks);
+
+	if (!ReattachDisk())
+		return 1;
+
+	OhciSim_Detach();
+	OhciSim_DeInit();
+	MSC_Device_Close(&VirtualDisk);
+	free(Buffer);
+	return 0;
+}
@@ -0,0 +1,491 @@
+/*
+ * msd_bench.c
+ *
+ * SD card reader benchmark without hardware. The unmodified device stack
+ * (the LPC17xx DCD, MassStorageClassDevice.c and USBMassStorageDevice.c
+ * with sdcard.c below it) runs against the device controller model
+ * (DCD_Model.c) on one side and the SD card model (SDCard_Sim.c) on the
+ * other; a host thread enumerates the device and moves data with Bulk-Only
+ * Transport commands. Throughput is given in virtual time, which both the
+ * USB bus and the SSP clock follow, so it shows how well the SD card reads
+ * (writes) overlap the USB transfers of the previous (next) chunk.
+ *
+ * Build on x86-64 Linux, from cortex_m3_nxp/:
+ *
+ *   gcc -std=gnu99 -O2 -no-pie -fno-pie \
+ *       -D__LPC17XX__ -D__CODE_RED -DUSB_DEVICE_ONLY -DUSE_FREERTOS_DELAY=0 \
+ *       -Wno-int-to-pointer-cast -Wno-pointer-to-int-cast \
+ *       -Ihostsim -I../CMSIS_CORE_LPC17xx/inc \
+ *       -Ilpcusblib/Drivers/USB -Ilpcusblib/Drivers/USB/Class/Device -Ilpcusblib/user_config/device \
+ *       -Ifatfs/user_config -Ifatfs/src \
+ *       hostsim/msd_bench.c hostsim/DCD_Model.c hostsim/HAL_DevSim.c hostsim/SDCard_Sim.c \
+ *       lpcusblib/Drivers/USB/Core/[A-Z]*.c lpcusblib/Drivers/USB/Core/LPC/[A-Z]*.c \
+ *       lpcusblib/Drivers/USB/Core/LPC/DCD/LPC17XX/Endpoint_LPC17xx.c \
+ *       lpcusblib/Drivers/USB/Class/Device/MassStorageClassDevice.c \
+ *       lpcusblib/user_config/device/USBMassStorageDevice.c lpcusblib/user_config/device/USBMassStorageDescriptors.c \
+ *       fatfs/user_config/sdcard.c \
+ *       -lpthread -o msd_bench
+ *
+ * Add -DSDMSC_OVERLAP=0 to move each chunk across the card and the bus in
+ * turn, for comparison, and -DINTERRUPT_CONTROL_ENDPOINT to have control
+ * requests processed in their own interrupt rather than from the main loop.
+ *
+ * Usage: msd_bench [-s card MB] [-m MB per test] [-b blocks per command]
+ *                  [-d SSP clock divider] [-t us per frame]
+ *                  [-c frames between control requests]
+ *
+ * Every register access of the DCD is trapped, so a virtual frame gets 4 ms of
+ * wall time by default (-t) for the device to keep up with the host the way
+ * the real CPU does; with less, the stack is still busy with one control
+ * request when the host sends the next and stalls it.
+ *
+ * While the write and read tests run, a second host thread sends a
+ * GET_STATUS request every few frames (-c, 0 for none) and reports how long
+ * the device takes to complete them while its main loop is busy with the card.
+ *
+ * The write test fills the tested range with a pattern which the read test
+ * then verifies. A READ(10) past the end of the card checks the error path:
+ * STALL of the data stage, CLEAR_FEATURE(ENDPOINT_HALT), failed CSW and the
+ * sense data.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <signal.h>
+
+#include "USBMassStorageDevice.h"
+#include "diskio.h"
+#include "sdcard.h"
+#include "lpc17xx_spi.h"
+#include "rtc.h"
+
+#include "DCD_Model.h"
+#include "SDCard_Sim.h"
+
+#define BLOCK_SIZE					512
+#define PACKET_SIZE					MASS_STORAGE_IO_EPSIZE
+#define CBW_LENGTH					31
+#define CSW_LENGTH					13
+#define CBW_SIGNATURE				0x43425355UL
+#define CSW_SIGNATURE				0x53425355UL
+#define DISK_TIMER_FRAMES			10			/* disk_timerproc() runs every 10 ms */
+
+typedef struct {
+	DcdSim_Stats_t Sim;
+	SdSim_Stats_t  Card;
+	uint64_t       Time;
+	uint64_t       Commands;
+} Sample_t;
+
+uint32_t SystemCoreClock = 100000000;
+
+static volatile bool HostDone;
+static int      ExitCode;
+static uint32_t CardMB = 32;
+static uint32_t TestMB = 1;
+static uint32_t BlocksPerCommand = 64;
+static uint32_t Tag;
+static uint64_t Commands;
+static uint64_t VerifyErrors;
+static uint32_t ControlPeriod = 10;
+static volatile bool TransfersDone;
+
+rtctime RTCGetTime(void)
+{
+	rtctime Time = {.rtc_mday = 1, .rtc_mon = 1, .rtc_year = 2012};
+
+	return Time;
+}
+
+static void FrameHook(uint64_t Frame)
+{
+	if ((Frame % DISK_TIMER_FRAMES) == 0)
+		disk_timerproc();
+}
+
+/*==========================================================================*/
+/* Host                                                                    */
+/*==========================================================================*/
+static void PutLE32(uint8_t *Data, uint32_t Value)
+{
+	Data[0] = Value;
+	Data[1] = Value >> 8;
+	Data[2] = Value >> 16;
+	Data[3] = Value >> 24;
+}
+
+static uint32_t GetLE32(const uint8_t *Data)
+{
+	return Data[0] | (Data[1] << 8) | (Data[2] << 16) | ((uint32_t) Data[3] << 24);
+}
+
+static DcdSim_Result_t ControlRequest(uint8_t RequestType, uint8_t Request, uint16_t Value, uint16_t Index,
+									  void *Data, uint16_t Length, uint16_t *Actual)
+{
+	const uint8_t Setup[8] = {RequestType, Request, Value & 0xFF, Value >> 8, Index & 0xFF, Index >> 8,
+							  Length & 0xFF, Length >> 8};
+
+	return DcdSim_Control(Setup, Data, Actual);
+}
+
+static DcdSim_Result_t ClearHalt(uint8_t EndpointAddress)
+{
+	return ControlRequest(REQDIR_HOSTTODEVICE | REQTYPE_STANDARD | REQREC_ENDPOINT, REQ_ClearFeature,
+						  FEATURE_SEL_EndpointHalt, EndpointAddress, NULL, 0, NULL);
+}
+
+/* Runs one Bulk-Only Transport command. Returns the CSW status (0 passed, 1 failed),
+ * or -1 if the transport itself failed.
+ */
+static int BotCommand(const uint8_t *Cdb, uint8_t CdbLength, bool DataIn, void *Data, uint32_t Length, uint32_t *Residue)
+{
+	uint8_t  Cbw[CBW_LENGTH] = {0};
+	uint8_t  Csw[CSW_LENGTH];
+	uint32_t Actual;
+	DcdSim_Result_t Result;
+
+	PutLE32(&Cbw[0], CBW_SIGNATURE);
+	PutLE32(&Cbw[4], ++Tag);
+	PutLE32(&Cbw[8], Length);
+	Cbw[12] = DataIn ? MS_COMMAND_DIR_DATA_IN : MS_COMMAND_DIR_DATA_OUT;
+	Cbw[14] = CdbLength;
+	memcpy(&Cbw[15], Cdb, CdbLength);
+	Commands++;
+
+	if (DcdSim_BulkOut(MASS_STORAGE_OUT_EPNUM, Cbw, sizeof(Cbw), PACKET_SIZE) != DCDSIM_OK)
+		return -1;
+
+	if (Length)
+	{
+		if (DataIn)
+			Result = DcdSim_BulkIn(MASS_STORAGE_IN_EPNUM, Data, Length, PACKET_SIZE, &Actual);
+		else
+			Result = DcdSim_BulkOut(MASS_STORAGE_OUT_EPNUM, Data, Length, PACKET_SIZE);
+
+		/* BOT 6.7.2/6.7.3: a stalled data stage is cleared and the CSW is read anyway */
+		if ((Result == DCDSIM_STALL) &&
+			(ClearHalt(DataIn ? (ENDPOINT_DIR_IN | MASS_STORAGE_IN_EPNUM) : MASS_STORAGE_OUT_EPNUM) != DCDSIM_OK))
+			return -1;
+		if ((Result != DCDSIM_OK) && (Result != DCDSIM_STALL))
+			return -1;
+	}
+
+	Result = DcdSim_BulkIn(MASS_STORAGE_IN_EPNUM, Csw, sizeof(Csw), PACKET_SIZE, &Actual);
+	if (Result == DCDSIM_STALL)
+	{
+		if (ClearHalt(ENDPOINT_DIR_IN | MASS_STORAGE_IN_EPNUM) != DCDSIM_OK)
+			return -1;
+		Result = DcdSim_BulkIn(MASS_STORAGE_IN_EPNUM, Csw, sizeof(Csw), PACKET_SIZE, &Actual);
+	}
+
+	if ((Result != DCDSIM_OK) || (Actual != CSW_LENGTH) ||
+		(GetLE32(&Csw[0]) != CSW_SIGNATURE) || (GetLE32(&Csw[4]) != Tag))
+	{
+		printf("bad CSW for command %02X\n", Cdb[0]);
+		return -1;
+	}
+
+	if (Residue)
+		*Residue = GetLE32(&Csw[8]);
+	return Csw[12];
+}
+
+static int ReadWrite10(uint8_t Opcode, uint32_t Lba, uint16_t Blocks, void *Data)
+{
+	const uint8_t Cdb[10] = {Opcode, 0, Lba >> 24, Lba >> 16, Lba >> 8, Lba, 0, Blocks >> 8, Blocks, 0};
+
+	return BotCommand(Cdb, sizeof(Cdb), Opcode == SCSI_CMD_READ_10, Data, (uint32_t) Blocks * BLOCK_SIZE, NULL);
+}
+
+static bool Enumerate(uint32_t *Blocks)
+{
+	uint8_t  Descriptor[256];
+	uint8_t  Response[36];
+	uint8_t  MaxLun;
+	uint16_t Actual;
+	uint16_t TotalLength;
+	uint64_t Start;
+	const uint8_t TestUnitReady[6] = {SCSI_CMD_TEST_UNIT_READY};
+	const uint8_t Inquiry[6] = {SCSI_CMD_INQUIRY, 0, 0, 0, sizeof(Response), 0};
+	const uint8_t ReadCapacity[10] = {SCSI_CMD_READ_CAPACITY_10};
+
+	if (DcdSim_WaitForConnect(2000) != DCDSIM_OK)
+	{
+		printf("Device did not connect\n");
+		return false;
+	}
+	Start = DcdSim_GetFrameNumber();
+
+	if ((ControlRequest(REQDIR_DEVICETOHOST, REQ_GetDescriptor, DTYPE_Device << 8, 0, Descriptor, 8, &Actual) != DCDSIM_OK) ||
+		(ControlRequest(REQDIR_HOSTTODEVICE, REQ_SetAddress, 1, 0, NULL, 0, NULL) != DCDSIM_OK) ||
+		(ControlRequest(REQDIR_DEVICETOHOST, REQ_GetDescriptor, DTYPE_Device << 8, 0, Descriptor, 18, &Actual) != DCDSIM_OK) ||
+		(Actual != 18) ||
+		(ControlRequest(REQDIR_DEVICETOHOST, REQ_GetDescriptor, DTYPE_Configuration << 8, 0, Descriptor, 9, &Actual) != DCDSIM_OK))
+	{
+		printf("Enumeration failed\n");
+		return false;
+	}
+
+	TotalLength = MIN(Descriptor[2] | (Descriptor[3] << 8), sizeof(Descriptor));
+	if ((ControlRequest(REQDIR_DEVICETOHOST, REQ_GetDescriptor, DTYPE_Configuration << 8, 0, Descriptor, TotalLength, &Actual) != DCDSIM_OK) ||
+		(Actual != TotalLength) ||
+		(ControlRequest(REQDIR_HOSTTODEVICE, REQ_SetConfiguration, 1, 0, NULL, 0, NULL) != DCDSIM_OK) ||
+		(ControlRequest(REQDIR_DEVICETOHOST | REQTYPE_CLASS | REQREC_INTERFACE, MS_REQ_GetMaxLUN, 0, 0, &MaxLun, 1, &Actual) != DCDSIM_OK))
+	{
+		printf("Configuration failed\n");
+		return false;
+	}
+
+	if ((BotCommand(Inquiry, sizeof(Inquiry), true, Response, sizeof(Response), NULL) != 0) ||
+		(BotCommand(TestUnitReady, sizeof(TestUnitReady), false, NULL, 0, NULL) != 0) ||
+		(BotCommand(ReadCapacity, sizeof(ReadCapacity), true, Response, 8, NULL) != 0))
+	{
+		printf("Mass storage setup failed\n");
+		return false;
+	}
+
+	*Blocks = ((Response[0] << 24) | (Response[1] << 16) | (Response[2] << 8) | Response[3]) + 1;
+	printf("Enumerated in %llu frames: %u blocks of %u bytes, %u LUN(s)\n",
+		   (unsigned long long) (DcdSim_GetFrameNumber() - Start), *Blocks,
+		   (Response[6] << 8) | Response[7], MaxLun + 1);
+	return true;
+}
+
+/*==========================================================================*/
+/* Measurement                                                             */
+/*==========================================================================*/
+static void TakeSample(Sample_t *Sample)
+{
+	DcdSim_GetStats(&Sample->Sim);
+	SdSim_GetStats(&Sample->Card);
+	Sample->Time = DcdSim_GetTime();
+	Sample->Commands = Commands;
+}
+
+static void Report(const char *Name, const Sample_t *Start, const Sample_t *End, uint32_t Sectors, bool Failed)
+{
+	double Seconds = (End->Time - Start->Time) / 1e9;
+
+	printf("%-8s %8u %9.3f %9.1f %10.1f %8llu %8llu %8llu %s\n", Name, Sectors,
+		   ((double) Sectors * BLOCK_SIZE) / Seconds / 1e6,
+		   (End->Commands - Start->Commands) / Seconds,
+		   100.0 * (End->Card.BusyNs - Start->Card.BusyNs) / (End->Time - Start->Time),
+		   (unsigned long long) (End->Sim.DmaDescriptors - Start->Sim.DmaDescriptors),
+		   (unsigned long long) (End->Sim.Naks - Start->Sim.Naks),
+		   (unsigned long long) (End->Sim.Frames - Start->Sim.Frames),
+		   Failed ? "FAILED" : (VerifyErrors ? "MISMATCH" : "ok"));
+}
+
+static void FillSector(uint32_t Lba, uint8_t *Sector)
+{
+	uint32_t i;
+
+	for (i = 0; i < BLOCK_SIZE; i++)
+		Sector[i] = (uint8_t) (Lba * 7 + i + (i >> 8));
+}
+
+static bool TestWrite(uint32_t Sectors, uint8_t *Buffer)
+{
+	Sample_t Start, End;
+	uint32_t Lba, Count, i;
+	int Status = 0;
+
+	VerifyErrors = 0;
+	TakeSample(&Start);
+	for (Lba = 0; (Lba < Sectors) && (Status == 0); Lba += Count)
+	{
+		Count = MIN(BlocksPerCommand, Sectors - Lba);
+		for (i = 0; i < Count; i++)
+			FillSector(Lba + i, &Buffer[i * BLOCK_SIZE]);
+		Status = ReadWrite10(SCSI_CMD_WRITE_10, Lba, Count, Buffer);
+	}
+	TakeSample(&End);
+	Report("write", &Start, &End, Sectors, Status != 0);
+	return Status == 0;
+}
+
+static bool TestRead(uint32_t Sectors, uint8_t *Buffer)
+{
+	uint8_t  Expected[BLOCK_SIZE];
+	Sample_t Start, End;
+	uint32_t Lba, Count, i;
+	int Status = 0;
+
+	VerifyErrors = 0;
+	TakeSample(&Start);
+	for (Lba = 0; (Lba < Sectors) && (Status == 0); Lba += Count)
+	{
+		Count = MIN(BlocksPerCommand, Sectors - Lba);
+		memset(Buffer, 0, Count * BLOCK_SIZE);
+		Status = ReadWrite10(SCSI_CMD_READ_10, Lba, Count, Buffer);
+		for (i = 0; (i < Count) && (Status == 0); i++)
+		{
+			FillSector(Lba + i, Expected);
+			if (memcmp(Expected, &Buffer[i * BLOCK_SIZE], BLOCK_SIZE))
+				VerifyErrors++;
+		}
+	}
+	TakeSample(&End);
+	Report("read", &Start, &End, Sectors, Status != 0);
+	return (Status == 0) && (VerifyErrors == 0);
+}
+
+/* GET_STATUS every ControlPeriod frames until the transfer tests are done, timed in virtual time */
+static void *ControlThread(void *Argument)
+{
+	uint8_t  Status[2];
+	uint16_t Actual;
+	uint64_t Start, Latency, Total = 0, Max = 0, Next;
+	uint32_t Requests = 0, Failed = 0;
+
+	while (!TransfersDone)
+	{
+		Next  = DcdSim_GetFrameNumber() + ControlPeriod;
+		Start = DcdSim_GetTime();
+		if ((ControlRequest(REQDIR_DEVICETOHOST | REQTYPE_STANDARD | REQREC_DEVICE, REQ_GetStatus, 0, 0,
+							Status, sizeof(Status), &Actual) != DCDSIM_OK) || (Actual != sizeof(Status)))
+		{
+			Failed++;
+		}
+		Latency = DcdSim_GetTime() - Start;
+		Total  += Latency;
+		Max     = MAX(Max, Latency);
+		Requests++;
+
+		while (!TransfersDone && (DcdSim_GetFrameNumber() < Next))
+			usleep(100);
+	}
+
+	printf("%u GET_STATUS during the transfers: %.2f ms on average, %.2f ms at most, %u failed\n",
+		   Requests, Requests ? (Total / 1e6) / Requests : 0.0, Max / 1e6, Failed);
+	return (void *) (uintptr_t) (Failed != 0);
+}
+
+/* READ(10) past the last block: the data stage stalls, the CSW fails and the sense says why */
+static bool TestOutOfRange(uint32_t Blocks, uint8_t *Buffer)
+{
+	const uint8_t RequestSense[6] = {SCSI_CMD_REQUEST_SENSE, 0, 0, 0, 18, 0};
+	uint8_t  Sense[18];
+	uint32_t Residue = 0;
+	int Status;
+
+	Status = ReadWrite10(SCSI_CMD_READ_10, Blocks - 1, 2, Buffer);
+	if ((Status != 1) || (BotCommand(RequestSense, sizeof(RequestSense), true, Sense, sizeof(Sense), &Residue) != 0))
+	{
+		printf("out of range read: status %d, REQUEST SENSE failed\n", Status);
+		return false;
+	}
+
+	printf("out of range read: status %d, sense %02X/%02X\n", Status, Sense[2] & 0x0F, Sense[12]);
+	return ((Sense[2] & 0x0F) == SCSI_SENSE_KEY_ILLEGAL_REQUEST) &&
+		   (Sense[12] == SCSI_ASENSE_LOGICAL_BLOCK_ADDRESS_OUT_OF_RANGE);
+}
+
+static void *HostThread(void *Argument)
+{
+	uint32_t Blocks, Sectors;
+	uint8_t *Buffer = malloc(BlocksPerCommand * BLOCK_SIZE);
+	pthread_t Control;
+	void    *ControlFailed = NULL;
+	bool     Passed;
+
+	ExitCode = 1;
+	if ((Buffer != NULL) && Enumerate(&Blocks))
+	{
+		Sectors = MIN((uint64_t) TestMB << 11, Blocks);
+
+		printf("%u sectors per test, %u blocks per command, SSP clock %u kHz, chunks of %u blocks, %s\n\n",
+			   Sectors, BlocksPerCommand, (unsigned) (SystemCoreClock / spi_div_high / 1000),
+			   SDMSC_CHUNK_BLOCKS, SDMSC_OVERLAP ? "overlapped" : "not overlapped");
+		printf("%-8s %8s %9s %9s %10s %8s %8s %8s\n", "test", "sectors", "MB/s", "cmds/s", "card busy%", "DDs", "naks", "frames");
+
+		if (ControlPeriod)
+			pthread_create(&Control, NULL, ControlThread, NULL);
+		Passed = TestWrite(Sectors, Buffer) & TestRead(Sectors, Buffer);
+		TransfersDone = true;
+		if (ControlPeriod)
+			pthread_join(Control, &ControlFailed);
+
+		if (Passed & TestOutOfRange(Blocks, Buffer) & (ControlFailed == NULL))
+			ExitCode = 0;
+	}
+
+	free(Buffer);
+	HostDone = true;
+	return NULL;
+}
+
+/*==========================================================================*/
+/* Main                                                                    */
+/*==========================================================================*/
+int main(int argc, char *argv[])
+{
+	uint32_t FramePeriodUS = 4000;
+	uint32_t Divider = 0;
+	pthread_t Host;
+	sigset_t Mask, Saved;
+	int Option;
+
+	while ((Option = getopt(argc, argv, "s:m:b:d:t:c:")) != -1)
+	{
+		switch (Option)
+		{
+		case 's': CardMB = atoi(optarg); break;
+		case 'm': TestMB = atoi(optarg); break;
+		case 'b': BlocksPerCommand = atoi(optarg); break;
+		case 'd': Divider = atoi(optarg); break;
+		case 't': FramePeriodUS = atoi(optarg); break;
+		case 'c': ControlPeriod = atoi(optarg); break;
+		default:
+			fprintf(stderr, "usage: %s [-s card MB] [-m MB per test] [-b blocks per command]\n"
+							"       [-d SSP clock divider] [-t us per frame] [-c frames between control requests]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	if ((BlocksPerCommand < 1) || (BlocksPerCommand > 128) || (FramePeriodUS < 8) ||
+		(Divider && ((Divider < 2) || (Divider > 254) || (Divider & 1))))
+	{
+		fprintf(stderr, "blocks per command must be 1-128, frame period at least 8 us, divider even 2-254\n");
+		return 2;
+	}
+
+	if (!SdSim_Init(CardMB) || !DcdSim_Init(FramePeriodUS))
+	{
+		fprintf(stderr, "cannot start the SD card or device controller model\n");
+		return 1;
+	}
+	DcdSim_SetFrameHook(FrameHook);
+
+	SDMSC_DeviceInit();
+	if (MMC_disk_status() & STA_NOINIT)
+	{
+		fprintf(stderr, "SD card initialization failed\n");
+		return 1;
+	}
+
+	if (Divider)
+	{
+		spi_div_high = Divider;
+		SPI_ConfigClockRate(SPI_CLOCKRATE_HIGH);
+	}
+
+	/* Slices must only interrupt the thread running the device stack */
+	sigemptyset(&Mask);
+	sigaddset(&Mask, SIGALRM);
+	pthread_sigmask(SIG_BLOCK, &Mask, &Saved);
+	pthread_create(&Host, NULL, HostThread, NULL);
+	pthread_sigmask(SIG_SETMASK, &Saved, NULL);
+
+	while (!HostDone)
+	{
+		SDMSC_DeviceTask();
+	}
+
+	pthread_join(Host, NULL);
+	DcdSim_DeInit();
+	return ExitCode;
+}
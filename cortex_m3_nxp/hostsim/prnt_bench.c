@@ -0,0 +1,308 @@
+/*
+ * prnt_bench.c
+ *
+ * Printer host spooling test without hardware. The Printer host class driver
+ * (PrinterClassHost.c) sends a print job to the virtual printer
+ * (Printer_Device.c) through the OHCI model, the job coming block by block
+ * from a source that takes -w microseconds per block, as f_read() from the SD
+ * card would. Two ways of sending are compared on the same job:
+ *
+ *   sync    read a block, PRNT_Host_SendData() it, read the next one: the bus
+ *           idles while the card is read and the card while the bus runs
+ *   spool   PRNT_Host_SpoolStream(): the next block is read while the previous
+ *           one is on the bus
+ *
+ * The printer checks every byte it receives. With -r it prints at a limited
+ * rate and NAKs once its buffer is full; with -p it runs out of paper at that
+ * byte of each job for -d milliseconds, during which the spooler backs off and
+ * polls the port status instead of spinning on the pipe.
+ *
+ * Build on x86-64 Linux, from cortex_m3_nxp/:
+ *
+ *   gcc -std=gnu99 -O2 -no-pie -fno-pie \
+ *       -D__LPC17XX__ -D__CODE_RED -DUSB_HOST_ONLY -DUSE_FREERTOS_DELAY=0 \
+ *       -Ihostsim -I../CMSIS_CORE_LPC17xx/inc \
+ *       -Ilpcusblib/Drivers/USB -Ilpcusblib/Drivers/USB/Class/Host \
+ *       hostsim/prnt_bench.c hostsim/Printer_Device.c hostsim/OHCI_Model.c hostsim/HAL_Sim.c \
+ *       lpcusblib/Drivers/USB/Core/[A-Z]*.c lpcusblib/Drivers/USB/Core/LPC/[A-Z]*.c \
+ *       lpcusblib/Drivers/USB/Core/LPC/HCD/HCD.c lpcusblib/Drivers/USB/Core/LPC/HCD/OHCI/OHCI.c \
+ *       lpcusblib/Drivers/USB/Class/Host/PrinterClassHost.c \
+ *       -o prnt_bench
+ *
+ * Usage: prnt_bench [-s job bytes] [-r printer bytes per second, 0 unlimited] [-w us per block read] [-p paper out byte, 0 never] [-d paper out ms] [-t us per frame]
+ *
+ * The source runs in wall clock time against the frames, keep the frame
+ * period at the default 1000 us.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "USB.h"
+#include "PrinterClassHost.h"
+
+#include "OHCI_Model.h"
+#include "Printer_Device.h"
+
+#define ENUMERATION_TIMEOUT_FRAMES		10000
+
+static USB_ClassInfo_PRNT_Host_t Printer_PRNT_Interface = {
+	.Config = {
+		.DataINPipeNumber       = 1,
+		.DataINPipeDoubleBank   = false,
+		.DataOUTPipeNumber      = 2,
+		.DataOUTPipeDoubleBank  = false,
+		.PortNumber = 0,
+	},
+};
+
+static Printer_Device_t VirtualPrinter;
+static volatile bool Enumerated;
+static volatile bool EnumerationError;
+
+/* Job source */
+typedef struct {
+	uint32_t Length;
+	uint32_t Offset;
+	uint32_t ReadUS;
+	uint32_t Blocks;
+} Job_t;
+
+/*==========================================================================*/
+/* Host stack events                                                       */
+/*==========================================================================*/
+void EVENT_USB_Host_DeviceEnumerationComplete(const uint8_t corenum)
+{
+	uint16_t ConfigDescriptorSize;
+	uint8_t  ConfigDescriptorData[512];
+	char     DeviceIDString[128];
+
+	if (USB_Host_GetDeviceConfigDescriptor(corenum, 1, &ConfigDescriptorSize, ConfigDescriptorData,
+										   sizeof(ConfigDescriptorData)) != HOST_GETCONFIG_Successful) {
+		printf("Error Retrieving Configuration Descriptor.\n");
+		EnumerationError = true;
+		return;
+	}
+
+	if (PRNT_Host_ConfigurePipes(&Printer_PRNT_Interface, ConfigDescriptorSize, ConfigDescriptorData) != PRNT_ENUMERROR_NoError) {
+		printf("Attached Device Not a Valid Printer Class Device.\n");
+		EnumerationError = true;
+		return;
+	}
+
+	if (USB_Host_SetDeviceConfiguration(corenum, 1) != HOST_SENDCONTROL_Successful) {
+		printf("Error Setting Device Configuration.\n");
+		EnumerationError = true;
+		return;
+	}
+
+	if (PRNT_Host_SetBidirectionalMode(&Printer_PRNT_Interface) != HOST_SENDCONTROL_Successful) {
+		printf("Error Setting Bidirectional Mode.\n");
+		EnumerationError = true;
+		return;
+	}
+
+	if (PRNT_Host_GetDeviceID(&Printer_PRNT_Interface, DeviceIDString, sizeof(DeviceIDString)) == HOST_SENDCONTROL_Successful)
+		printf("Printer ID: %s\n", DeviceIDString);
+
+	Enumerated = true;
+}
+
+void EVENT_USB_Host_HostError(const uint8_t corenum, const uint8_t ErrorCode)
+{
+	printf("Host Mode Error %d on port %d\n", ErrorCode, corenum);
+	EnumerationError = true;
+}
+
+void EVENT_USB_Host_DeviceEnumerationFailed(const uint8_t corenum,
+											const uint8_t ErrorCode,
+											const uint8_t SubErrorCode)
+{
+	printf("Dev Enum Error %d/%d on port %d in state %d\n", ErrorCode, SubErrorCode, corenum, USB_HostState[corenum]);
+	EnumerationError = true;
+}
+
+/*==========================================================================*/
+/* Application side                                                        */
+/*==========================================================================*/
+static void WaitUS(uint32_t Microseconds)
+{
+	struct timespec Start, Now;
+
+	clock_gettime(CLOCK_MONOTONIC, &Start);
+	do
+		clock_gettime(CLOCK_MONOTONIC, &Now);
+	while (((Now.tv_sec - Start.tv_sec) * 1000000L + (Now.tv_nsec - Start.tv_nsec) / 1000) < Microseconds);
+}
+
+/* Next block of the job, taking ReadUS like f_read() from the card */
+static uint16_t ReadJob(uint8_t* const Buffer, const uint16_t Size, void* const Context)
+{
+	Job_t *Job = (Job_t *) Context;
+	uint16_t Length = MIN(Size, Job->Length - Job->Offset);
+	uint16_t i;
+
+	if (!Length)
+		return 0;
+
+	WaitUS(Job->ReadUS);
+
+	for (i = 0; i < Length; i++)
+		Buffer[i] = Printer_Device_Pattern(Job->Offset + i);
+
+	Job->Offset += Length;
+	Job->Blocks++;
+	return Length;
+}
+
+/* The same job, a block read and then sent at a time */
+static uint8_t SendJob(Job_t *Job, uint32_t *BytesSent)
+{
+	static uint8_t Block[PRNT_HOST_SPOOL_CHUNK_SIZE];
+	uint16_t Length;
+	uint8_t  ErrorCode;
+
+	*BytesSent = 0;
+
+	while ((Length = ReadJob(Block, sizeof(Block), Job)) != 0)
+	{
+		if ((ErrorCode = PRNT_Host_SendData(&Printer_PRNT_Interface, Block, Length)) != PIPE_RWSTREAM_NoError)
+			return ErrorCode;
+
+		*BytesSent += Length;
+	}
+
+	return PIPE_RWSTREAM_NoError;
+}
+
+/*==========================================================================*/
+/* Main                                                                    */
+/*==========================================================================*/
+static bool EnumeratePrinter(void)
+{
+	uint64_t Start = OhciSim_GetFrameNumber();
+
+	OhciSim_Attach(&VirtualPrinter.Device);
+
+	while (!Enumerated && !EnumerationError)
+	{
+		USB_USBTask();
+
+		if ((OhciSim_GetFrameNumber() - Start) > ENUMERATION_TIMEOUT_FRAMES)
+		{
+			printf("Enumeration timed out in host state %d\n", USB_HostState[0]);
+			return false;
+		}
+	}
+
+	return !EnumerationError;
+}
+
+int main(int argc, char *argv[])
+{
+	static const char* const ModeName[] = {"sync", "spool"};
+	uint32_t JobLength = 512 * 1024;
+	uint32_t PrinterRate = 0;
+	uint32_t ReadUS = 1500;
+	uint32_t PaperOutAt = 0;
+	uint32_t PaperOutMS = 500;
+	uint32_t FramePeriodUS = 1000;
+	uint32_t Failures = 0;
+	uint32_t BytesSent;
+	uint64_t Start, Frames, Naks, Received, Errors, Polls;
+	uint8_t  ErrorCode;
+	uint8_t  PortStatus;
+	bool     Failed;
+	Job_t    Job;
+	int      Mode;
+	int      Option;
+
+	while ((Option = getopt(argc, argv, "s:r:w:p:d:t:")) != -1)
+	{
+		switch (Option)
+		{
+		case 's': JobLength = atoi(optarg); break;
+		case 'r': PrinterRate = atoi(optarg); break;
+		case 'w': ReadUS = atoi(optarg); break;
+		case 'p': PaperOutAt = atoi(optarg); break;
+		case 'd': PaperOutMS = atoi(optarg); break;
+		case 't': FramePeriodUS = atoi(optarg); break;
+		default:
+			fprintf(stderr, "usage: %s [-s job bytes] [-r printer bytes per second, 0 unlimited] [-w us per block read] [-p paper out byte, 0 never] [-d paper out ms] [-t us per frame]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	Printer_Device_Init(&VirtualPrinter, PrinterRate, 0, PaperOutMS);
+
+	if ((FramePeriodUS < 1) || !OhciSim_Init(FramePeriodUS))
+	{
+		fprintf(stderr, "cannot start the OHCI model\n");
+		return 1;
+	}
+
+	USB_Init();
+
+	if (!EnumeratePrinter())
+		return 1;
+
+	printf("%u byte job, printer %u B/s, %u us per %u byte block read, paper out at %u for %u ms\n\n",
+		   JobLength, PrinterRate, ReadUS, PRNT_HOST_SPOOL_CHUNK_SIZE, PaperOutAt, PaperOutMS);
+	printf("%-6s %9s %9s %7s %8s %9s %9s %8s %6s %s\n", "mode", "sent", "printed", "errors", "frames", "kB/s", "naks", "backoffs", "polls", "result");
+
+	for (Mode = 0; Mode < 2; Mode++)
+	{
+		memset(&Job, 0, sizeof(Job));
+		Job.Length = JobLength;
+		Job.ReadUS = ReadUS;
+
+		/* Let the printer finish the previous job, its engine runs when it is spoken to */
+		while (VirtualPrinter.Fill || VirtualPrinter.PaperOut)
+			PRNT_Host_GetPortStatus(&Printer_PRNT_Interface, &PortStatus);
+
+		Printer_Device_NewJob(&VirtualPrinter);
+		VirtualPrinter.PaperOutAt = PaperOutAt;
+		Printer_PRNT_Interface.State.SpoolBackoffs = 0;
+		Printer_PRNT_Interface.State.PortStatus    = 0;
+
+		Naks     = VirtualPrinter.Naks;
+		Received = VirtualPrinter.Received;
+		Errors   = VirtualPrinter.ReceiveErrors;
+		Polls    = VirtualPrinter.StatusRequests;
+		Start    = OhciSim_GetFrameNumber();
+
+		if (Mode == 0)
+			ErrorCode = SendJob(&Job, &BytesSent);
+		else
+			ErrorCode = PRNT_Host_SpoolStream(&Printer_PRNT_Interface, ReadJob, &Job, &BytesSent);
+
+		Frames   = OhciSim_GetFrameNumber() - Start;
+		Received = VirtualPrinter.Received - Received;
+		Errors   = VirtualPrinter.ReceiveErrors - Errors;
+		Naks     = VirtualPrinter.Naks - Naks;
+		Polls    = VirtualPrinter.StatusRequests - Polls;
+
+		Failed = ErrorCode || Errors || (BytesSent != JobLength) || (Received != JobLength);
+		if (Failed)
+			Failures++;
+
+		printf("%-6s %9u %9llu %7llu %8llu %9.1f %9llu %8u %6llu %s", ModeName[Mode], BytesSent,
+			   (unsigned long long) Received, (unsigned long long) Errors, (unsigned long long) Frames,
+			   Frames ? (double) Received / Frames : 0.0, (unsigned long long) Naks,
+			   Printer_PRNT_Interface.State.SpoolBackoffs, (unsigned long long) Polls, Failed ? "FAILED" : "ok");
+		if (ErrorCode)
+			printf(" (error %u)", ErrorCode);
+		if (Printer_PRNT_Interface.State.PortStatus & PRNT_PORTSTATUS_PAPEREMPTY)
+			printf(" (paper empty seen)");
+		printf("\n");
+	}
+
+	printf("\nprinter buffer peak %u of %u bytes, %u failures\n", VirtualPrinter.FillPeak, PRINTER_DEVICE_BUFFER_SIZE, Failures);
+
+	OhciSim_Detach();
+	OhciSim_DeInit();
+	return Failures ? 1 : 0;
+}
@@ -0,0 +1,383 @@
+/*
+ * rndis_bench.c
+ *
+ * RNDIS host packet I/O test without hardware. The RNDIS host class driver
+ * (RNDISClassHost.c) exchanges Ethernet frames with the virtual USB Ethernet
+ * device (RNDIS_Device.c) through the OHCI model, receiving frames the device
+ * gets from the wire at a fixed rate and sending frames at another. Two
+ * paths can be compared:
+ *
+ *   -m copy    RNDIS_Host_IsPacketReceived()/ReadPacket()/SendPacket(),
+ *              frames copied out of and into the stream buffers
+ *   -m zero    RNDIS_Host_GetPacket()/ReleasePacket() and AllocPacket(),
+ *              frames used and built in place
+ *
+ * The pipe based ReadPacket() of the non streaming driver is left out: its IN
+ * transfers are sized by packet rather than by message, and it loses step
+ * with the batched transfers of this device within the first few frames.
+ *
+ * The device batches as many frames per bulk IN transfer as the host's
+ * maximum transfer size (-H) and its own limit (-p) allow. Frames the device
+ * drops on its full receive queue show up as lost; the TSC cycles spent in the
+ * receive and send calls give the CPU cost per frame.
+ *
+ * Build on x86-64 Linux, from cortex_m3_nxp/:
+ *
+ *   gcc -std=gnu99 -O2 -no-pie -fno-pie \
+ *       -D__LPC17XX__ -D__CODE_RED -DUSB_HOST_ONLY -DUSE_FREERTOS_DELAY=0 \
+ *       -Ihostsim -I../CMSIS_CORE_LPC17xx/inc \
+ *       -Ilpcusblib/Drivers/USB -Ilpcusblib/Drivers/USB/Class/Host \
+ *       hostsim/rndis_bench.c hostsim/RNDIS_Device.c hostsim/OHCI_Model.c hostsim/HAL_Sim.c \
+ *       lpcusblib/Drivers/USB/Core/[A-Z]*.c lpcusblib/Drivers/USB/Core/LPC/[A-Z]*.c \
+ *       lpcusblib/Drivers/USB/Core/LPC/HCD/HCD.c lpcusblib/Drivers/USB/Core/LPC/HCD/OHCI/OHCI.c \
+ *       lpcusblib/Drivers/USB/Class/Host/RNDISClassHost.c \
+ *       -o rndis_bench
+ *
+ * Usage: rndis_bench [-m copy|zero] [-s seconds] [-r rx frames/s] [-x tx frames/s] [-l frame bytes, 0 varied]
+ *                    [-p device packets per transfer] [-T device max transfer] [-a alignment factor] [-H host max transfer]
+ *                    [-w max stall ms] [-t us per frame]
+ *
+ * As with audio_bench the application loop runs in wall clock time against
+ * the frames, keep the frame period at the default 1000 us.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "USB.h"
+#include "RNDISClassHost.h"
+
+#include "OHCI_Model.h"
+#include "RNDIS_Device.h"
+
+#define ENUMERATION_TIMEOUT_FRAMES		10000
+
+#define SEND_BURST_MAX					8			/* frames sent per pass before receiving again */
+
+enum { PATH_COPY, PATH_ZERO };
+
+/* The configuration is const, main() fills it in once the host maximum transfer size is known */
+static USB_ClassInfo_RNDIS_Host_t Ethernet_RNDIS_Interface;
+
+static RNDIS_Device_t VirtualEthernet;
+static volatile bool Enumerated;
+static volatile bool EnumerationError;
+
+static uint64_t Received;
+static uint64_t ReceivedBytes;
+static uint64_t ReceiveSequence;
+static uint64_t ReceiveGaps;
+static uint64_t ReceiveErrors;
+
+/*==========================================================================*/
+/* Host stack events                                                       */
+/*==========================================================================*/
+void EVENT_USB_Host_DeviceEnumerationComplete(const uint8_t corenum)
+{
+	uint16_t ConfigDescriptorSize;
+	uint8_t  ConfigDescriptorData[512];
+	uint32_t PacketFilter = REMOTE_NDIS_PACKET_DIRECTED | REMOTE_NDIS_PACKET_BROADCAST;
+
+	if (USB_Host_GetDeviceConfigDescriptor(corenum, 1, &ConfigDescriptorSize, ConfigDescriptorData,
+										   sizeof(ConfigDescriptorData)) != HOST_GETCONFIG_Successful) {
+		printf("Error Retrieving Configuration Descriptor.\n");
+		EnumerationError = true;
+		return;
+	}
+
+	if (RNDIS_Host_ConfigurePipes(&Ethernet_RNDIS_Interface, ConfigDescriptorSize, ConfigDescriptorData) != RNDIS_ENUMERROR_NoError) {
+		printf("Attached Device Not a Valid RNDIS Class Device.\n");
+		EnumerationError = true;
+		return;
+	}
+
+	if (USB_Host_SetDeviceConfiguration(corenum, 1) != HOST_SENDCONTROL_Successful) {
+		printf("Error Setting Device Configuration.\n");
+		EnumerationError = true;
+		return;
+	}
+
+	if (RNDIS_Host_InitializeDevice(&Ethernet_RNDIS_Interface) != HOST_SENDCONTROL_Successful) {
+		printf("Error Initializing Device.\n");
+		EnumerationError = true;
+		return;
+	}
+
+	if (RNDIS_Host_SetRNDISProperty(&Ethernet_RNDIS_Interface, OID_GEN_CURRENT_PACKET_FILTER,
+									&PacketFilter, sizeof(PacketFilter)) != HOST_SENDCONTROL_Successful) {
+		printf("Error Setting Device Packet Filter.\n");
+		EnumerationError = true;
+		return;
+	}
+
+	Enumerated = true;
+}
+
+void EVENT_USB_Host_HostError(const uint8_t corenum, const uint8_t ErrorCode)
+{
+	printf("Host Mode Error %d on port %d\n", ErrorCode, corenum);
+	EnumerationError = true;
+}
+
+void EVENT_USB_Host_DeviceEnumerationFailed(const uint8_t corenum,
+											const uint8_t ErrorCode,
+											const uint8_t SubErrorCode)
+{
+	printf("Dev Enum Error %d/%d on port %d in state %d\n", ErrorCode, SubErrorCode, corenum, USB_HostState[corenum]);
+	EnumerationError = true;
+}
+
+/*==========================================================================*/
+/* Application side                                                        */
+/*==========================================================================*/
+static void VerifyFrame(const uint8_t *Frame, uint16_t Length)
+{
+	int64_t Sequence = RNDIS_Device_CheckFrame(Frame, Length);
+
+	if (Sequence < 0)
+	{
+		ReceiveErrors++;
+		return;
+	}
+
+	/* The device dropped the frames in between */
+	if ((uint64_t) Sequence != ReceiveSequence)
+		ReceiveGaps++;
+
+	ReceiveSequence = Sequence + 1;
+	Received++;
+	ReceivedBytes += Length;
+}
+
+/* Takes every frame waiting, returns the number taken */
+static uint32_t ReceiveFrames(int Path)
+{
+	static uint8_t Frame[RNDIS_DEVICE_FRAME_MAX];
+	RNDIS_Host_Packet_t Packet;
+	uint16_t Length;
+	uint32_t Count = 0;
+
+	if (Path == PATH_ZERO)
+	{
+		while (RNDIS_Host_GetPacket(&Ethernet_RNDIS_Interface, &Packet))
+		{
+			VerifyFrame(Packet.Data, Packet.Length);
+			RNDIS_Host_ReleasePacket(&Ethernet_RNDIS_Interface, &Packet);
+			Count++;
+		}
+	}
+	else
+	{
+		while (RNDIS_Host_IsPacketReceived(&Ethernet_RNDIS_Interface))
+		{
+			if ((RNDIS_Host_ReadPacket(&Ethernet_RNDIS_Interface, Frame, &Length) != PIPE_RWSTREAM_NoError) || !Length)
+				break;
+
+			VerifyFrame(Frame, Length);
+			Count++;
+		}
+	}
+
+	return Count;
+}
+
+static bool SendFrame(int Path, uint32_t Sequence, uint16_t Length)
+{
+	static uint8_t Frame[RNDIS_DEVICE_FRAME_MAX];
+	uint8_t *Packet;
+
+	if (Path == PATH_ZERO)
+	{
+		if ((Packet = RNDIS_Host_AllocPacket(&Ethernet_RNDIS_Interface, Length)) == NULL)
+			return false;
+
+		RNDIS_Device_BuildFrame(Packet, Length, Sequence);
+		return true;
+	}
+
+	RNDIS_Device_BuildFrame(Frame, Length, Sequence);
+	return RNDIS_Host_SendPacket(&Ethernet_RNDIS_Interface, Frame, Length) == PIPE_RWSTREAM_NoError;
+}
+
+/*==========================================================================*/
+/* Main                                                                    */
+/*==========================================================================*/
+static bool EnumerateEthernet(void)
+{
+	uint64_t Start = OhciSim_GetFrameNumber();
+
+	OhciSim_Attach(&VirtualEthernet.Device);
+
+	while (!Enumerated && !EnumerationError)
+	{
+		USB_USBTask();
+
+		if ((OhciSim_GetFrameNumber() - Start) > ENUMERATION_TIMEOUT_FRAMES)
+		{
+			printf("Enumeration timed out in host state %d\n", USB_HostState[0]);
+			return false;
+		}
+	}
+
+	if (EnumerationError)
+		return false;
+
+	printf("Enumerated in %llu frames: device takes %u bytes and %u packets per transfer, alignment 2^%u\n",
+		   (unsigned long long) (OhciSim_GetFrameNumber() - Start), Ethernet_RNDIS_Interface.State.DeviceMaxPacketSize,
+		   Ethernet_RNDIS_Interface.State.DeviceMaxPacketsPerTransfer, Ethernet_RNDIS_Interface.State.DevicePacketAlignmentFactor);
+	return true;
+}
+
+int main(int argc, char *argv[])
+{
+	static const char *PathNames[] = { "copy", "zero" };
+	int      Path = PATH_ZERO;
+	uint32_t Seconds = 10;
+	uint32_t RxRate = 500;
+	uint32_t TxRate = 300;
+	uint32_t FrameLength = 0;
+	uint32_t DevicePackets = 8;
+	uint32_t DeviceTransfer = 4096;
+	uint32_t Alignment = 2;
+	uint32_t HostMaxTransfer = 1600;
+	uint32_t MaxStall = 5;
+	uint32_t FramePeriodUS = 1000;
+	uint64_t Start, End, Frame, Wait;
+	uint64_t Busy = 0;
+	uint64_t RxCycles = 0, TxCycles = 0, T0;
+	uint64_t Sent = 0, SentBytes = 0, SendFailures = 0;
+	uint32_t Burst;
+	uint16_t Length;
+	uint8_t  ErrorCode;
+	int Option;
+
+	while ((Option = getopt(argc, argv, "m:s:r:x:l:p:T:a:H:w:t:")) != -1)
+	{
+		switch (Option)
+		{
+		case 'm': Path = !strcmp(optarg, "copy") ? PATH_COPY : PATH_ZERO; break;
+		case 's': Seconds = atoi(optarg); break;
+		case 'r': RxRate = atoi(optarg); break;
+		case 'x': TxRate = atoi(optarg); break;
+		case 'l': FrameLength = atoi(optarg); break;
+		case 'p': DevicePackets = atoi(optarg); break;
+		case 'T': DeviceTransfer = atoi(optarg); break;
+		case 'a': Alignment = atoi(optarg); break;
+		case 'H': HostMaxTransfer = atoi(optarg); break;
+		case 'w': MaxStall = atoi(optarg); break;
+		case 't': FramePeriodUS = atoi(optarg); break;
+		default:
+			fprintf(stderr, "usage: %s [-m copy|zero] [-s seconds] [-r rx frames/s] [-x tx frames/s] [-l frame bytes, 0 varied]\n"
+							"       [-p device packets per transfer] [-T device max transfer] [-a alignment factor] [-H host max transfer]\n"
+							"       [-w max stall ms] [-t us per frame]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	if ((FrameLength && ((FrameLength < RNDIS_DEVICE_FRAME_MIN) || (FrameLength > RNDIS_DEVICE_FRAME_MAX))) || (FramePeriodUS < 1) ||
+		(DeviceTransfer > RNDIS_DEVICE_TRANSFER_MAX))
+	{
+		fprintf(stderr, "frames must be %u to %u bytes, device transfers up to %u bytes, frame period at least 1 us\n",
+				RNDIS_DEVICE_FRAME_MIN, RNDIS_DEVICE_FRAME_MAX, RNDIS_DEVICE_TRANSFER_MAX);
+		return 2;
+	}
+
+	memcpy(&Ethernet_RNDIS_Interface, &(USB_ClassInfo_RNDIS_Host_t) {
+		.Config = {
+			.DataINPipeNumber       = 1,
+			.DataINPipeDoubleBank   = false,
+			.DataOUTPipeNumber      = 2,
+			.DataOUTPipeDoubleBank  = false,
+			.NotificationPipeNumber = 3,
+			.NotificationPipeDoubleBank = false,
+			.HostMaxPacketSize      = HostMaxTransfer,
+			.PortNumber = 0,
+		},
+	}, sizeof(Ethernet_RNDIS_Interface));
+
+	RNDIS_Device_Init(&VirtualEthernet, RxRate, FrameLength, DevicePackets, DeviceTransfer, Alignment);
+
+	if (!OhciSim_Init(FramePeriodUS))
+	{
+		fprintf(stderr, "cannot start the OHCI model\n");
+		return 1;
+	}
+
+	USB_Init();
+
+	if (!EnumerateEthernet())
+		return 1;
+
+	if ((ErrorCode = RNDIS_Host_StartStreaming(&Ethernet_RNDIS_Interface)) != RNDIS_STREAM_NoError)
+	{
+		printf("Cannot start streaming: error %u\n", ErrorCode);
+		return 1;
+	}
+
+	printf("%s path, %u s, %u frames/s in, %u frames/s out, %s frames, host transfers up to %u bytes, stalls up to %u ms\n\n",
+		   PathNames[Path], Seconds, RxRate, TxRate, FrameLength ? "fixed" : "varied", Ethernet_RNDIS_Interface.Config.HostMaxPacketSize,
+		   MaxStall);
+
+	Start = OhciSim_GetFrameNumber();
+	End   = Start + (uint64_t) Seconds * 1000;
+	while ((Frame = OhciSim_GetFrameNumber()) < End)
+	{
+		RNDIS_Host_USBTask(&Ethernet_RNDIS_Interface);
+		USB_USBTask();
+
+		if (Frame < Busy)
+			continue;
+
+		T0 = OhciSim_ReadTSC();
+		if (ReceiveFrames(Path))
+		{
+			RxCycles += OhciSim_ReadTSC() - T0;
+			Busy = Frame + (MaxStall ? (uint32_t) rand() % (MaxStall + 1) : 0);
+		}
+
+		/* Frames go out at TxRate, those due while the application was stalled go out back to back in bursts */
+		T0 = OhciSim_ReadTSC();
+		for (Burst = 0; (Burst < SEND_BURST_MAX) && (Sent < ((Frame - Start) * TxRate) / 1000); Burst++)
+		{
+			Length = FrameLength ? FrameLength : RNDIS_Device_FrameLength(Sent + 0x5A5A);
+			if (!SendFrame(Path, Sent, Length))
+			{
+				SendFailures++;
+				break;
+			}
+			Sent++;
+			SentBytes += Length;
+		}
+		TxCycles += OhciSim_ReadTSC() - T0;
+	}
+
+	/* Let the last batch reach the device */
+	RNDIS_Host_FlushPackets(&Ethernet_RNDIS_Interface);
+	for (Wait = OhciSim_GetFrameNumber(); (VirtualEthernet.Received < Sent) && (OhciSim_GetFrameNumber() - Wait < 100); )
+		USB_USBTask();
+
+	printf("%-6s %-3s %9s %9s %9s %8s %8s %9s %9s %8s %s\n", "path", "dir", "frames", "done", "lost", "errors", "kB/s", "per xfer", "cyc/frame", "failed", "result");
+	printf("%-6s %-3s %9llu %9llu %9llu %8llu %8.1f %9.2f %9.0f %8s %s\n", PathNames[Path], "in",
+		   (unsigned long long) VirtualEthernet.Arrived, (unsigned long long) Received,
+		   (unsigned long long) VirtualEthernet.Dropped, (unsigned long long) ReceiveErrors,
+		   ReceivedBytes / (Seconds * 1000.0),
+		   VirtualEthernet.SentTransfers ? (double) VirtualEthernet.Sent / VirtualEthernet.SentTransfers : 0.0,
+		   Received ? (double) RxCycles / Received : 0.0, "-",
+		   (VirtualEthernet.Dropped || ReceiveGaps || ReceiveErrors || Ethernet_RNDIS_Interface.State.Receive.Error) ? "LOST FRAMES" : "ok");
+	printf("%-6s %-3s %9llu %9llu %9llu %8llu %8.1f %9.2f %9.0f %8llu %s\n", PathNames[Path], "out",
+		   (unsigned long long) Sent, (unsigned long long) VirtualEthernet.Received,
+		   (unsigned long long) (Sent - VirtualEthernet.Received), (unsigned long long) VirtualEthernet.ReceiveErrors,
+		   SentBytes / (Seconds * 1000.0),
+		   VirtualEthernet.ReceivedTransfers ? (double) VirtualEthernet.Received / VirtualEthernet.ReceivedTransfers : 0.0,
+		   Sent ? (double) TxCycles / Sent : 0.0, (unsigned long long) SendFailures,
+		   ((VirtualEthernet.Received != Sent) || VirtualEthernet.ReceiveErrors || SendFailures) ? "LOST FRAMES" : "ok");
+	printf("\ndevice: %llu IN NAKs\n", (unsigned long long) VirtualEthernet.Naks);
+
+	RNDIS_Host_StopStreaming(&Ethernet_RNDIS_Interface);
+
+	OhciSim_Detach();
+	OhciSim_DeInit();
+	return 0;
+}
@@ -0,0 +1,639 @@
+/*
+ * rndisdev_bench.c
+ *
+ * USB Ethernet gadget benchmark without hardware. The unmodified device stack
+ * (the LPC17xx DCD, RNDISClassDevice.c and USBRNDISDevice.c) runs against the
+ * device controller model (DCD_Model.c). A host thread enumerates the device
+ * and brings the adapter up as the RNDIS host driver of a PC does; then one
+ * thread sends a stream of datagrams to the UDP echo service of the device
+ * while another reads the echoes back and checks them, as a network test
+ * tool would. Everything runs in virtual time, so the throughput is compared
+ * with what the full speed bus carries.
+ *
+ * Build on x86-64 Linux, from cortex_m3_nxp/:
+ *
+ *   gcc -std=gnu99 -O2 -no-pie -fno-pie \
+ *       -D__LPC17XX__ -D__CODE_RED -DUSB_DEVICE_ONLY -DUSE_FREERTOS_DELAY=0 \
+ *       -Wno-int-to-pointer-cast -Wno-pointer-to-int-cast \
+ *       -Ihostsim -I../CMSIS_CORE_LPC17xx/inc -Iinc \
+ *       -Ilpcusblib/Drivers/USB -Ilpcusblib/Drivers/USB/Class/Device -Ilpcusblib/user_config/device \
+ *       hostsim/rndisdev_bench.c hostsim/DCD_Model.c hostsim/HAL_DevSim.c \
+ *       lpcusblib/Drivers/USB/Core/[A-Z]*.c lpcusblib/Drivers/USB/Core/LPC/[A-Z]*.c \
+ *       lpcusblib/Drivers/USB/Core/LPC/DCD/LPC17XX/Endpoint_LPC17xx.c \
+ *       lpcusblib/Drivers/USB/Class/Device/RNDISClassDevice.c \
+ *       lpcusblib/user_config/device/USBRNDISDevice.c lpcusblib/user_config/device/USBRNDISDescriptors.c \
+ *       -lpthread -o rndisdev_bench
+ *
+ * Usage: rndisdev_bench [-n datagrams] [-s payload bytes] [-H host max transfer] [-t us per frame]
+ *
+ * -H is the largest IN transfer the host accepts, which it gives the device in
+ * its initialize message; the device batches the replies up to it. Give it
+ * -H 1600 (one message) for comparison.
+ *
+ * The host model reports completions at frame boundaries, so each thread runs
+ * at most one transfer per frame, like a host driver that queues a single URB:
+ * small datagrams measure that, at 1000 frames/s, rather than the device.
+ *
+ * The host first checks the ARP reply and that a malformed packet message is
+ * dropped and counted. The stream test checks that every datagram comes back
+ * in order and intact. The latency test then pings the idle device.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <signal.h>
+
+#include "USBRNDISDevice.h"
+
+#include "DCD_Model.h"
+
+#define PACKET_SIZE					RNDIS_TXRX_EPSIZE
+#define LATENCY_PROBES				8
+#define SETTLE_FRAMES				2			/* frames given to the device after SET_CONFIGURATION */
+#define BUS_PAYLOAD_PER_FRAME		(19 * 64)	/* bulk bytes a full speed frame carries at most */
+
+#define MESSAGE_HEADER_SIZE			sizeof(RNDIS_Packet_Message_t)
+#define ETH_HEADER_SIZE				14
+#define IP_HEADER_SIZE				20
+#define UDP_HEADER_SIZE				8
+#define ICMP_HEADER_SIZE			8
+#define FRAME_OVERHEAD				(ETH_HEADER_SIZE + IP_HEADER_SIZE + UDP_HEADER_SIZE)
+#define PING_PAYLOAD				56
+#define HOST_PORT					40000
+
+typedef struct {
+	DcdSim_Stats_t Sim;
+	uint64_t       Time;
+} Sample_t;
+
+uint32_t SystemCoreClock = 100000000;
+
+static const uint8_t HostIP[4]    = {10, 0, 0, 1};
+static const uint8_t DeviceIP[4]  = RNDIS_DEVICE_IP_ADDRESS;
+static const uint8_t DeviceMAC[6] = RNDIS_DEVICE_MAC_ADDRESS;
+static uint8_t       HostMAC[6];
+
+static volatile bool HostDone;
+static int      ExitCode;
+static uint32_t Datagrams = 2000;
+static uint32_t PayloadSize = ETHERNET_FRAME_SIZE_MAX - FRAME_OVERHEAD;
+static uint32_t HostMaxTransfer = 16384;
+static uint32_t RequestId;
+static uint32_t InTransfers;
+static uint32_t Mismatches;
+static uint64_t BytesOut, BytesIn;
+static bool     WriteFailed;
+static bool     ReadFailed;
+
+/*==========================================================================*/
+/* Frames                                                                  */
+/*==========================================================================*/
+static void Put32(uint8_t *p, uint32_t Value)
+{
+	p[0] = Value;
+	p[1] = Value >> 8;
+	p[2] = Value >> 16;
+	p[3] = Value >> 24;
+}
+
+static uint32_t Get32(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static uint16_t Checksum(const uint8_t *Data, uint32_t Length)
+{
+	uint32_t Sum = 0, i;
+
+	for (i = 0; i + 1 < Length; i += 2)
+		Sum += (Data[i] << 8) | Data[i + 1];
+	if (Length & 1)
+		Sum += Data[Length - 1] << 8;
+	while (Sum >> 16)
+		Sum = (Sum & 0xFFFF) + (Sum >> 16);
+	return ~Sum;
+}
+
+static uint32_t EthernetHeader(uint8_t *Frame, const uint8_t *Destination, uint16_t Type)
+{
+	memcpy(&Frame[0], Destination, 6);
+	memcpy(&Frame[6], HostMAC, 6);
+	Frame[12] = Type >> 8;
+	Frame[13] = Type;
+	return ETH_HEADER_SIZE;
+}
+
+static uint32_t IPHeader(uint8_t *Ip, uint8_t Protocol, uint16_t PayloadLength)
+{
+	uint16_t Sum;
+
+	memset(Ip, 0, IP_HEADER_SIZE);
+	Ip[0] = 0x45;
+	Ip[2] = (IP_HEADER_SIZE + PayloadLength) >> 8;
+	Ip[3] = (IP_HEADER_SIZE + PayloadLength);
+	Ip[8] = 64;
+	Ip[9] = Protocol;
+	memcpy(&Ip[12], HostIP, 4);
+	memcpy(&Ip[16], DeviceIP, 4);
+	Sum = Checksum(Ip, IP_HEADER_SIZE);
+	Ip[10] = Sum >> 8;
+	Ip[11] = Sum;
+	return IP_HEADER_SIZE;
+}
+
+/* Wraps a frame in a packet message, padded by a byte as the host driver does
+ * when it would end on a whole packet; returns the transfer length
+ */
+static uint32_t PacketMessage(uint8_t *Message, uint32_t FrameLength)
+{
+	uint32_t Length = MESSAGE_HEADER_SIZE + FrameLength;
+
+	memset(Message, 0, MESSAGE_HEADER_SIZE);
+	Put32(&Message[0], REMOTE_NDIS_PACKET_MSG);
+	Put32(&Message[4], Length);
+	Put32(&Message[8], MESSAGE_HEADER_SIZE - sizeof(RNDIS_Message_Header_t));
+	Put32(&Message[12], FrameLength);
+
+	if (!(Length % PACKET_SIZE))
+		Message[Length++] = 0;
+	return Length;
+}
+
+static void FillPayload(uint8_t *Payload, uint32_t Sequence)
+{
+	uint32_t i;
+
+	Put32(Payload, Sequence);
+	for (i = 4; i < PayloadSize; i++)
+		Payload[i] = (uint8_t) (Sequence * 13 + i);
+}
+
+/* UDP datagram to the echo service, in a packet message */
+static uint32_t EchoRequest(uint8_t *Message, uint32_t Sequence)
+{
+	uint8_t *Frame = &Message[MESSAGE_HEADER_SIZE];
+	uint8_t *Udp;
+	uint32_t Length;
+
+	Length = EthernetHeader(Frame, DeviceMAC, 0x0800);
+	Length += IPHeader(&Frame[Length], 17, UDP_HEADER_SIZE + PayloadSize);
+	Udp = &Frame[Length];
+	Udp[0] = HOST_PORT >> 8;
+	Udp[1] = HOST_PORT & 0xFF;
+	Udp[2] = 0;
+	Udp[3] = RNDIS_ECHO_PORT;
+	Udp[4] = (UDP_HEADER_SIZE + PayloadSize) >> 8;
+	Udp[5] = (UDP_HEADER_SIZE + PayloadSize);
+	Udp[6] = 0;		/* no checksum */
+	Udp[7] = 0;
+	FillPayload(&Udp[UDP_HEADER_SIZE], Sequence);
+
+	return PacketMessage(Message, Length + UDP_HEADER_SIZE + PayloadSize);
+}
+
+/* Checks the echo of datagram Sequence */
+static bool EchoReply(const uint8_t *Frame, uint32_t Length, uint32_t Sequence)
+{
+	static uint8_t Payload[ETHERNET_FRAME_SIZE_MAX];
+	const uint8_t *Ip  = &Frame[ETH_HEADER_SIZE];
+	const uint8_t *Udp = &Ip[IP_HEADER_SIZE];
+
+	FillPayload(Payload, Sequence);
+
+	return (Length == FRAME_OVERHEAD + PayloadSize) &&
+		   !memcmp(&Frame[0], HostMAC, 6) && !memcmp(&Frame[6], DeviceMAC, 6) &&
+		   !memcmp(&Ip[12], DeviceIP, 4) && !memcmp(&Ip[16], HostIP, 4) && !Checksum(Ip, IP_HEADER_SIZE) &&
+		   (Udp[0] == 0) && (Udp[1] == RNDIS_ECHO_PORT) && (((Udp[2] << 8) | Udp[3]) == HOST_PORT) &&
+		   !memcmp(&Udp[UDP_HEADER_SIZE], Payload, PayloadSize);
+}
+
+/* Finds the next packet message of an IN transfer; the frame and its length go to
+ * Frame and FrameLength, the offset of the message after it is returned (0 at the end)
+ */
+static uint32_t NextMessage(const uint8_t *Transfer, uint32_t Length, uint32_t Offset,
+							const uint8_t **Frame, uint32_t *FrameLength)
+{
+	uint32_t MessageLength, DataOffset;
+
+	if ((Length - Offset) < MESSAGE_HEADER_SIZE)
+		return 0;
+
+	MessageLength = Get32(&Transfer[Offset + 4]);
+	DataOffset    = Get32(&Transfer[Offset + 8]) + sizeof(RNDIS_Message_Header_t);
+	*FrameLength  = Get32(&Transfer[Offset + 12]);
+	*Frame        = &Transfer[Offset + DataOffset];
+
+	if ((Get32(&Transfer[Offset]) != REMOTE_NDIS_PACKET_MSG) || (MessageLength > (Length - Offset)) ||
+		(DataOffset + *FrameLength > MessageLength))
+	{
+		return 0;
+	}
+	return Offset + MessageLength;
+}
+
+/*==========================================================================*/
+/* Host                                                                    */
+/*==========================================================================*/
+static DcdSim_Result_t ControlRequest(uint8_t RequestType, uint8_t Request, uint16_t Value, uint16_t Index,
+									  void *Data, uint16_t Length, uint16_t *Actual)
+{
+	const uint8_t Setup[8] = {RequestType, Request, Value & 0xFF, Value >> 8, Index & 0xFF, Index >> 8,
+							  Length & 0xFF, Length >> 8};
+
+	return DcdSim_Control(Setup, Data, Actual);
+}
+
+/* Sends a control message and fetches its completion, the status of which is returned
+ * (the completion itself goes to Response)
+ */
+static uint32_t RNDISCommand(uint8_t *Message, uint16_t Length, uint8_t *Response)
+{
+	uint16_t Actual;
+
+	Put32(&Message[4], Length);
+	Put32(&Message[8], ++RequestId);
+	if ((ControlRequest(REQDIR_HOSTTODEVICE | REQTYPE_CLASS | REQREC_INTERFACE, RNDIS_REQ_SendEncapsulatedCommand,
+						0, 0, Message, Length, NULL) != DCDSIM_OK) ||
+		(ControlRequest(REQDIR_DEVICETOHOST | REQTYPE_CLASS | REQREC_INTERFACE, RNDIS_REQ_GetEncapsulatedResponse,
+						0, 0, Response, RNDIS_MESSAGE_BUFFER_SIZE, &Actual) != DCDSIM_OK) ||
+		(Actual < 16) || (Get32(&Response[0]) != (Get32(&Message[0]) | 0x80000000)) ||
+		(Get32(&Response[8]) != RequestId))
+	{
+		return REMOTE_NDIS_STATUS_FAILURE;
+	}
+	return Get32(&Response[12]);
+}
+
+static bool Query(uint32_t Oid, void *Value, uint32_t Length)
+{
+	uint8_t Message[28] = {0}, Response[RNDIS_MESSAGE_BUFFER_SIZE];
+
+	Put32(&Message[0], REMOTE_NDIS_QUERY_MSG);
+	Put32(&Message[12], Oid);
+	if ((RNDISCommand(Message, sizeof(Message), Response) != REMOTE_NDIS_STATUS_SUCCESS) ||
+		(Get32(&Response[16]) != Length))
+	{
+		return false;
+	}
+
+	memcpy(Value, &Response[8 + Get32(&Response[20])], Length);
+	return true;
+}
+
+static uint32_t QueryCounter(uint32_t Oid)
+{
+	uint8_t Value[4];
+
+	return Query(Oid, Value, sizeof(Value)) ? Get32(Value) : 0xFFFFFFFF;
+}
+
+static bool Enumerate(void)
+{
+	uint8_t  Descriptor[256];
+	uint16_t Actual;
+	uint16_t TotalLength;
+	uint64_t Start, Configured;
+
+	if (DcdSim_WaitForConnect(2000) != DCDSIM_OK)
+	{
+		printf("Device did not connect\n");
+		return false;
+	}
+	Start = DcdSim_GetFrameNumber();
+
+	if ((ControlRequest(REQDIR_DEVICETOHOST, REQ_GetDescriptor, DTYPE_Device << 8, 0, Descriptor, 8, &Actual) != DCDSIM_OK) ||
+		(ControlRequest(REQDIR_HOSTTODEVICE, REQ_SetAddress, 1, 0, NULL, 0, NULL) != DCDSIM_OK) ||
+		(ControlRequest(REQDIR_DEVICETOHOST, REQ_GetDescriptor, DTYPE_Device << 8, 0, Descriptor, 18, &Actual) != DCDSIM_OK) ||
+		(Actual != 18) ||
+		(ControlRequest(REQDIR_DEVICETOHOST, REQ_GetDescriptor, DTYPE_Configuration << 8, 0, Descriptor, 9, &Actual) != DCDSIM_OK))
+	{
+		printf("Enumeration failed\n");
+		return false;
+	}
+
+	TotalLength = MIN(Descriptor[2] | (Descriptor[3] << 8), sizeof(Descriptor));
+	if ((ControlRequest(REQDIR_DEVICETOHOST, REQ_GetDescriptor, DTYPE_Configuration << 8, 0, Descriptor, TotalLength, &Actual) != DCDSIM_OK) ||
+		(Actual != TotalLength) ||
+		(ControlRequest(REQDIR_HOSTTODEVICE, REQ_SetConfiguration, 1, 0, NULL, 0, NULL) != DCDSIM_OK))
+	{
+		printf("Configuration failed\n");
+		return false;
+	}
+
+	/* The device configures its endpoints after the status stage of SET_CONFIGURATION;
+	 * a request that comes in meanwhile is taken for an unsupported one and stalled
+	 */
+	Configured = DcdSim_GetFrameNumber();
+	while (DcdSim_GetFrameNumber() < Configured + SETTLE_FRAMES)
+		usleep(100);
+
+	printf("Enumerated in %llu frames, %u configuration bytes\n",
+		   (unsigned long long) (DcdSim_GetFrameNumber() - Start), TotalLength);
+	return true;
+}
+
+/* What the RNDIS host driver does once the device is configured */
+static bool BringUp(void)
+{
+	uint8_t Message[32] = {0}, Response[RNDIS_MESSAGE_BUFFER_SIZE];
+
+	Put32(&Message[0], REMOTE_NDIS_INITIALIZE_MSG);
+	Put32(&Message[12], 1);
+	Put32(&Message[16], 0);
+	Put32(&Message[20], HostMaxTransfer);
+	if (RNDISCommand(Message, 24, Response) != REMOTE_NDIS_STATUS_SUCCESS)
+	{
+		printf("RNDIS initialize failed\n");
+		return false;
+	}
+	printf("Device takes %u message(s) and %u bytes per transfer\n", Get32(&Response[32]), Get32(&Response[36]));
+
+	if (!Query(OID_802_3_CURRENT_ADDRESS, HostMAC, sizeof(HostMAC)))
+	{
+		printf("MAC address query failed\n");
+		return false;
+	}
+
+	memset(Message, 0, sizeof(Message));
+	Put32(&Message[0], REMOTE_NDIS_SET_MSG);
+	Put32(&Message[12], OID_GEN_CURRENT_PACKET_FILTER);
+	Put32(&Message[16], 4);
+	Put32(&Message[20], 20);
+	Put32(&Message[28], REMOTE_NDIS_PACKET_DIRECTED | REMOTE_NDIS_PACKET_MULTICAST | REMOTE_NDIS_PACKET_BROADCAST);
+	if (RNDISCommand(Message, sizeof(Message), Response) != REMOTE_NDIS_STATUS_SUCCESS)
+	{
+		printf("Packet filter set failed\n");
+		return false;
+	}
+
+	printf("Adapter up, host end %02X:%02X:%02X:%02X:%02X:%02X\n",
+		   HostMAC[0], HostMAC[1], HostMAC[2], HostMAC[3], HostMAC[4], HostMAC[5]);
+	return true;
+}
+
+/* Sends one frame (or a raw message) and reads the one that comes back */
+static bool Exchange(uint8_t *Message, uint32_t Length, const uint8_t **Frame, uint32_t *FrameLength)
+{
+	static uint8_t Transfer[RNDIS_DEVICE_FRAME_BUFFER_SIZE];
+	uint32_t Actual;
+
+	return (DcdSim_BulkOut(RNDIS_RX_EPNUM, Message, Length, PACKET_SIZE) == DCDSIM_OK) &&
+		   (DcdSim_BulkIn(RNDIS_TX_EPNUM, Transfer, sizeof(Transfer), PACKET_SIZE, &Actual) == DCDSIM_OK) &&
+		   NextMessage(Transfer, Actual, 0, Frame, FrameLength);
+}
+
+static bool TestArp(void)
+{
+	static const uint8_t Broadcast[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+	uint8_t Message[128] = {0}, *Arp;
+	const uint8_t *Reply;
+	uint32_t Length, ReplyLength;
+
+	/* Malformed: no packet message, which the device must drop and count */
+	Put32(&Message[0], 0x99);
+	Put32(&Message[4], MESSAGE_HEADER_SIZE);
+	if (DcdSim_BulkOut(RNDIS_RX_EPNUM, Message, MESSAGE_HEADER_SIZE, PACKET_SIZE) != DCDSIM_OK)
+	{
+		printf("Malformed message not taken\n");
+		return false;
+	}
+
+	Length = EthernetHeader(&Message[MESSAGE_HEADER_SIZE], Broadcast, 0x0806);
+	Arp = &Message[MESSAGE_HEADER_SIZE + Length];
+	memset(Arp, 0, 28);
+	Arp[1] = 1;					/* Ethernet */
+	Arp[2] = 0x08;				/* IPv4 */
+	Arp[4] = 6;
+	Arp[5] = 4;
+	Arp[7] = 1;					/* request */
+	memcpy(&Arp[8], HostMAC, 6);
+	memcpy(&Arp[14], HostIP, 4);
+	memcpy(&Arp[24], DeviceIP, 4);
+
+	if (!Exchange(Message, PacketMessage(Message, Length + 28), &Reply, &ReplyLength) ||
+		(ReplyLength != Length + 28) || (Reply[ETH_HEADER_SIZE + 7] != 2) ||
+		memcmp(&Reply[ETH_HEADER_SIZE + 8], DeviceMAC, 6) || memcmp(&Reply[ETH_HEADER_SIZE + 14], DeviceIP, 4) ||
+		memcmp(&Reply[ETH_HEADER_SIZE + 18], HostMAC, 6) || memcmp(&Reply[ETH_HEADER_SIZE + 24], HostIP, 4))
+	{
+		printf("ARP failed\n");
+		return false;
+	}
+
+	if (QueryCounter(OID_GEN_RCV_ERROR) != 1)
+	{
+		printf("Malformed message not counted\n");
+		return false;
+	}
+
+	printf("ARP: %u.%u.%u.%u is at %02X:%02X:%02X:%02X:%02X:%02X, malformed message dropped\n\n",
+		   DeviceIP[0], DeviceIP[1], DeviceIP[2], DeviceIP[3],
+		   Reply[22], Reply[23], Reply[24], Reply[25], Reply[26], Reply[27]);
+	return true;
+}
+
+static void *WriterThread(void *Argument)
+{
+	static uint8_t Message[RNDIS_DEVICE_FRAME_BUFFER_SIZE];
+	uint32_t Sequence, Length;
+
+	/* One message per transfer, as the host driver sends them */
+	for (Sequence = 0; Sequence < Datagrams; Sequence++)
+	{
+		Length = EchoRequest(Message, Sequence);
+		if (DcdSim_BulkOut(RNDIS_RX_EPNUM, Message, Length, PACKET_SIZE) != DCDSIM_OK)
+		{
+			printf("OUT transfer failed after %u datagrams\n", Sequence);
+			WriteFailed = true;
+			break;
+		}
+		BytesOut += Length;
+	}
+	return NULL;
+}
+
+static void *ReaderThread(void *Argument)
+{
+	uint8_t *Transfer = malloc(HostMaxTransfer);
+	const uint8_t *Frame;
+	uint32_t Received = 0, Actual, Offset, FrameLength;
+
+	while ((Transfer != NULL) && (Received < Datagrams))
+	{
+		if (DcdSim_BulkIn(RNDIS_TX_EPNUM, Transfer, HostMaxTransfer, PACKET_SIZE, &Actual) != DCDSIM_OK)
+		{
+			printf("IN transfer failed after %u datagrams\n", Received);
+			ReadFailed = true;
+			break;
+		}
+
+		InTransfers++;
+		BytesIn += Actual;
+		for (Offset = 0; (Offset = NextMessage(Transfer, Actual, Offset, &Frame, &FrameLength)) != 0; Received++)
+		{
+			if (!EchoReply(Frame, FrameLength, Received))
+				Mismatches++;
+		}
+	}
+
+	free(Transfer);
+	return NULL;
+}
+
+/*==========================================================================*/
+/* Measurement                                                             */
+/*==========================================================================*/
+static void TakeSample(Sample_t *Sample)
+{
+	DcdSim_GetStats(&Sample->Sim);
+	Sample->Time = DcdSim_GetTime();
+}
+
+static bool TestStream(void)
+{
+	Sample_t  Start, End;
+	pthread_t Writer, Reader;
+	double    Seconds;
+	uint32_t  Sent, Received;
+
+	TakeSample(&Start);
+	pthread_create(&Reader, NULL, ReaderThread, NULL);
+	pthread_create(&Writer, NULL, WriterThread, NULL);
+	pthread_join(Writer, NULL);
+	pthread_join(Reader, NULL);
+	TakeSample(&End);
+
+	Seconds  = (End.Time - Start.Time) / 1e9;
+	Sent     = QueryCounter(OID_GEN_XMIT_OK);
+	Received = QueryCounter(OID_GEN_RCV_OK);
+
+	printf("%-8s %8s %9s %9s %6s %8s %9s %8s %8s %8s\n",
+		   "test", "frames", "frames/s", "kB/s", "bus%", "IN xfers", "frms/xfer", "DDs", "naks", "frames");
+	printf("%-8s %8u %9.0f %9.2f %6.1f %8u %9.2f %8llu %8llu %8llu %s\n", "stream", Datagrams,
+		   Datagrams / Seconds, (double) Datagrams * PayloadSize / Seconds / 1e3,
+		   100.0 * (BytesOut + BytesIn) / Seconds / (BUS_PAYLOAD_PER_FRAME * 1e3),
+		   InTransfers, (double) Datagrams / (InTransfers ? InTransfers : 1),
+		   (unsigned long long) (End.Sim.DmaDescriptors - Start.Sim.DmaDescriptors),
+		   (unsigned long long) (End.Sim.Naks - Start.Sim.Naks),
+		   (unsigned long long) (End.Sim.Frames - Start.Sim.Frames),
+		   (WriteFailed || ReadFailed) ? "FAILED" : (Mismatches ? "MISMATCH" : "ok"));
+	printf("device   %u frames received, %u sent (ARP included)\n", Received, Sent);
+
+	return !WriteFailed && !ReadFailed && !Mismatches;
+}
+
+/* Pings of the idle device: two transfers and the turn around in the task */
+static bool TestLatency(void)
+{
+	static uint8_t Message[RNDIS_DEVICE_FRAME_BUFFER_SIZE];
+	uint8_t *Frame = &Message[MESSAGE_HEADER_SIZE], *Icmp;
+	const uint8_t *Reply;
+	uint32_t Length, ReplyLength, i;
+	uint64_t Start, Total = 0, Worst = 0, Elapsed;
+	uint16_t Sum;
+
+	for (i = 0; i < LATENCY_PROBES; i++)
+	{
+		Length = EthernetHeader(Frame, DeviceMAC, 0x0800);
+		Length += IPHeader(&Frame[Length], 1, ICMP_HEADER_SIZE + PING_PAYLOAD);
+		Icmp = &Frame[Length];
+		memset(Icmp, 0, ICMP_HEADER_SIZE);
+		Icmp[0] = 8;			/* echo request */
+		Icmp[7] = i;
+		memset(&Icmp[ICMP_HEADER_SIZE], 0x5A ^ i, PING_PAYLOAD);
+		Sum = Checksum(Icmp, ICMP_HEADER_SIZE + PING_PAYLOAD);
+		Icmp[2] = Sum >> 8;
+		Icmp[3] = Sum;
+
+		Start = DcdSim_GetTime();
+		if (!Exchange(Message, PacketMessage(Message, Length + ICMP_HEADER_SIZE + PING_PAYLOAD), &Reply, &ReplyLength) ||
+			(ReplyLength != Length + ICMP_HEADER_SIZE + PING_PAYLOAD) || (Reply[Length] != 0) || (Reply[Length + 7] != i) ||
+			Checksum(&Reply[Length], ICMP_HEADER_SIZE + PING_PAYLOAD))
+		{
+			printf("ping %u failed\n", i);
+			return false;
+		}
+
+		Elapsed = DcdSim_GetTime() - Start;
+		Total  += Elapsed;
+		Worst   = MAX(Worst, Elapsed);
+	}
+
+	printf("ping     %u probes: mean %.2f ms, worst %.2f ms\n", LATENCY_PROBES, Total / 1e6 / LATENCY_PROBES, Worst / 1e6);
+	return true;
+}
+
+static void *HostThread(void *Argument)
+{
+	ExitCode = 1;
+	if (Enumerate() && BringUp())
+	{
+		printf("%u datagrams of %u bytes to the echo service, %u byte IN transfers, %u frame buffers\n",
+			   Datagrams, PayloadSize, HostMaxTransfer, RNDIS_DEVICE_FRAME_BUFFERS);
+
+		if (TestArp() && TestStream() & TestLatency())
+			ExitCode = 0;
+	}
+
+	HostDone = true;
+	return NULL;
+}
+
+/*==========================================================================*/
+/* Main                                                                    */
+/*==========================================================================*/
+int main(int argc, char *argv[])
+{
+	uint32_t FramePeriodUS = 4000;
+	pthread_t Host;
+	sigset_t Mask, Saved;
+	int Option;
+
+	while ((Option = getopt(argc, argv, "n:s:H:t:")) != -1)
+	{
+		switch (Option)
+		{
+		case 'n': Datagrams = atoi(optarg); break;
+		case 's': PayloadSize = atoi(optarg); break;
+		case 'H': HostMaxTransfer = atoi(optarg); break;
+		case 't': FramePeriodUS = atoi(optarg); break;
+		default:
+			fprintf(stderr, "usage: %s [-n datagrams] [-s payload bytes] [-H host max transfer] [-t us per frame]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	if ((Datagrams < 1) || (PayloadSize < 4) || (PayloadSize > ETHERNET_FRAME_SIZE_MAX - FRAME_OVERHEAD) ||
+		(HostMaxTransfer < RNDIS_DEVICE_FRAME_BUFFER_SIZE) || (FramePeriodUS < 8))
+	{
+		fprintf(stderr, "at least 1 datagram, 4 to %u payload bytes, host max transfer at least %u, frame period at least 8 us\n",
+				ETHERNET_FRAME_SIZE_MAX - FRAME_OVERHEAD, (unsigned) RNDIS_DEVICE_FRAME_BUFFER_SIZE);
+		return 2;
+	}
+
+	if (!DcdSim_Init(FramePeriodUS))
+	{
+		fprintf(stderr, "cannot start the device controller model\n");
+		return 1;
+	}
+
+	RNDIS_DeviceInit();
+
+	/* Slices must only interrupt the thread running the device stack */
+	sigemptyset(&Mask);
+	sigaddset(&Mask, SIGALRM);
+	pthread_sigmask(SIG_BLOCK, &Mask, &Saved);
+	pthread_create(&Host, NULL, HostThread, NULL);
+	pthread_sigmask(SIG_SETMASK, &Saved, NULL);
+
+	while (!HostDone)
+	{
+		RNDIS_DeviceTask();
+	}
+
+	pthread_join(Host, NULL);
+	DcdSim_DeInit();
+	return ExitCode;
+}
@@ -0,0 +1,19 @@
+/*
+ * semphr.h
+ *
+ * Host simulation shim, see FreeRTOS.h.
+ */
+
+#ifndef HOSTSIM_SEMPHR_H_
+#define HOSTSIM_SEMPHR_H_
+
+#include "FreeRTOS.h"
+
+typedef void *SemaphoreHandle_t;
+
+/* Binary semaphores, for the benches that link code using them */
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+portBASE_TYPE xSemaphoreTake(SemaphoreHandle_t Semaphore, portTickType Wait);
+portBASE_TYPE xSemaphoreGiveFromISR(SemaphoreHandle_t Semaphore, portBASE_TYPE *TaskWoken);
+
+#endif /* HOSTSIM_SEMPHR_H_ */
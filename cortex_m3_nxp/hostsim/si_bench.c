@@ -0,0 +1,324 @@
+/*
+ * si_bench.c
+ *
+ * Still Image host object download test without hardware. The Still Image
+ * host class driver (StillImageClassHost.c) lists and downloads the objects
+ * of the virtual PTP camera (SI_Device.c) through the OHCI model with
+ * SI_Host_GetObject(), the way USBStillImageHost.c feeds them to f_write().
+ *
+ * The objects cover the edge cases of the data phase (empty, ending in the
+ * packet that carries the container header, filling their last packet so
+ * that a zero length packet follows) along with one large object (-b). Every
+ * byte is checked against the camera's pattern, and every full 4 KB block
+ * is "written to the card" by waiting -w microseconds, to show the card write
+ * overlapping the transfer of the next chunk: with the overlap a download
+ * takes well under the sum of the bus time and the write time.
+ * An invalid handle is asked for last, to check that the session stays in
+ * step after a failed operation, then an object the camera sends short of the
+ * length it declared, which must be reported with the bytes really received.
+ *
+ * Build on x86-64 Linux, from cortex_m3_nxp/:
+ *
+ *   gcc -std=gnu99 -O2 -no-pie -fno-pie \
+ *       -D__LPC17XX__ -D__CODE_RED -DUSB_HOST_ONLY -DUSE_FREERTOS_DELAY=0 \
+ *       -Ihostsim -I../CMSIS_CORE_LPC17xx/inc \
+ *       -Ilpcusblib/Drivers/USB -Ilpcusblib/Drivers/USB/Class/Host \
+ *       hostsim/si_bench.c hostsim/SI_Device.c hostsim/OHCI_Model.c hostsim/HAL_Sim.c \
+ *       lpcusblib/Drivers/USB/Core/[A-Z]*.c lpcusblib/Drivers/USB/Core/LPC/[A-Z]*.c \
+ *       lpcusblib/Drivers/USB/Core/LPC/HCD/HCD.c lpcusblib/Drivers/USB/Core/LPC/HCD/OHCI/OHCI.c \
+ *       lpcusblib/Drivers/USB/Class/Host/StillImageClassHost.c \
+ *       -o si_bench
+ *
+ * Usage: si_bench [-b large object bytes] [-r camera bytes per second, 0 unlimited] [-w us per 4 KB block written] [-t us per frame]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "USB.h"
+#include "StillImageClassHost.h"
+
+#include "OHCI_Model.h"
+#include "SI_Device.h"
+
+#define ENUMERATION_TIMEOUT_FRAMES		10000
+#define WRITE_BLOCK						4096
+
+static USB_ClassInfo_SI_Host_t DigitalCamera_SI_Interface = {
+	.Config = {
+		.DataINPipeNumber       = 1,
+		.DataINPipeDoubleBank   = false,
+		.DataOUTPipeNumber      = 2,
+		.DataOUTPipeDoubleBank  = false,
+		.EventsPipeNumber       = 3,
+		.EventsPipeDoubleBank   = false,
+		.PortNumber = 0,
+	},
+};
+
+static SI_Device_t VirtualCamera;
+static volatile bool Enumerated;
+static volatile bool EnumerationError;
+
+/* Download in progress */
+typedef struct {
+	uint32_t Handle;
+	uint32_t Size;					/* from the container header */
+	uint32_t Received;
+	uint32_t Errors;
+	uint32_t Fill;					/* bytes of the block being staged */
+	uint32_t Blocks;				/* blocks written */
+	uint32_t WriteUS;
+} Download_t;
+
+static uint32_t Handles[SI_DEVICE_MAX_OBJECTS];
+static uint32_t HandleCount;
+
+/*==========================================================================*/
+/* Host stack events                                                       */
+/*==========================================================================*/
+void EVENT_USB_Host_DeviceEnumerationComplete(const uint8_t corenum)
+{
+	uint16_t ConfigDescriptorSize;
+	uint8_t  ConfigDescriptorData[512];
+
+	if (USB_Host_GetDeviceConfigDescriptor(corenum, 1, &ConfigDescriptorSize, ConfigDescriptorData,
+										   sizeof(ConfigDescriptorData)) != HOST_GETCONFIG_Successful) {
+		printf("Error Retrieving Configuration Descriptor.\n");
+		EnumerationError = true;
+		return;
+	}
+
+	if (SI_Host_ConfigurePipes(&DigitalCamera_SI_Interface, ConfigDescriptorSize, ConfigDescriptorData) != SI_ENUMERROR_NoError) {
+		printf("Attached Device Not a Valid Still Image Class Device.\n");
+		EnumerationError = true;
+		return;
+	}
+
+	if (USB_Host_SetDeviceConfiguration(corenum, 1) != HOST_SENDCONTROL_Successful) {
+		printf("Error Setting Device Configuration.\n");
+		EnumerationError = true;
+		return;
+	}
+
+	if (SI_Host_OpenSession(&DigitalCamera_SI_Interface) != PIPE_RWSTREAM_NoError) {
+		printf("Could not open PIMA session.\n");
+		EnumerationError = true;
+		return;
+	}
+
+	Enumerated = true;
+}
+
+void EVENT_USB_Host_HostError(const uint8_t corenum, const uint8_t ErrorCode)
+{
+	printf("Host Mode Error %d on port %d\n", ErrorCode, corenum);
+	EnumerationError = true;
+}
+
+void EVENT_USB_Host_DeviceEnumerationFailed(const uint8_t corenum,
+											const uint8_t ErrorCode,
+											const uint8_t SubErrorCode)
+{
+	printf("Dev Enum Error %d/%d on port %d in state %d\n", ErrorCode, SubErrorCode, corenum, USB_HostState[corenum]);
+	EnumerationError = true;
+}
+
+/*==========================================================================*/
+/* Application side                                                        */
+/*==========================================================================*/
+static void WaitUS(uint32_t Microseconds)
+{
+	struct timespec Start, Now;
+
+	clock_gettime(CLOCK_MONOTONIC, &Start);
+	do
+		clock_gettime(CLOCK_MONOTONIC, &Now);
+	while (((Now.tv_sec - Start.tv_sec) * 1000000L + (Now.tv_nsec - Start.tv_nsec) / 1000) < Microseconds);
+}
+
+/* Checks the chunk and stages it, a full block takes WriteUS to write out like f_write() to the card */
+static void ObjectChunk(const uint8_t* const Chunk, const uint16_t Length, void* const Context)
+{
+	Download_t *Object = (Download_t *) Context;
+	uint16_t i;
+
+	for (i = 0; i < Length; i++)
+	{
+		if (Chunk[i] != SI_Device_Pattern(Object->Handle, Object->Received + i))
+			Object->Errors++;
+	}
+
+	Object->Received += Length;
+	Object->Fill     += Length;
+
+	while (Object->Fill >= WRITE_BLOCK)
+	{
+		Object->Fill -= WRITE_BLOCK;
+		Object->Blocks++;
+		WaitUS(Object->WriteUS);
+	}
+}
+
+static void HandlesChunk(const uint8_t* const Chunk, const uint16_t Length, void* const Context)
+{
+	uint32_t *Offset = (uint32_t *) Context;
+	uint16_t i;
+
+	/* The count comes first, then the handles, little endian */
+	for (i = 0; i < Length; i++, (*Offset)++)
+	{
+		if ((*Offset >= 4) && ((*Offset - 4) / 4 < SI_DEVICE_MAX_OBJECTS))
+			Handles[(*Offset - 4) / 4] |= (uint32_t) Chunk[i] << (8 * ((*Offset - 4) % 4));
+	}
+
+	HandleCount = (*Offset >= 4) ? MIN((*Offset - 4) / 4, SI_DEVICE_MAX_OBJECTS) : 0;
+}
+
+static bool ListObjects(void)
+{
+	uint32_t Params[3] = {0xFFFFFFFF, 0, 0};
+	uint32_t Offset = 0;
+	uint8_t  ErrorCode;
+
+	if ((ErrorCode = SI_Host_SendCommand(&DigitalCamera_SI_Interface, 0x1007, 3, Params)) ||
+		(ErrorCode = SI_Host_ReadDataStream(&DigitalCamera_SI_Interface, HandlesChunk, &Offset, NULL)) ||
+		(ErrorCode = SI_Host_ReceiveResponse(&DigitalCamera_SI_Interface)))
+	{
+		printf("GetObjectHandles failed: error %u\n", ErrorCode);
+		return false;
+	}
+
+	return true;
+}
+
+/*==========================================================================*/
+/* Main                                                                    */
+/*==========================================================================*/
+static bool EnumerateCamera(void)
+{
+	uint64_t Start = OhciSim_GetFrameNumber();
+
+	OhciSim_Attach(&VirtualCamera.Device);
+
+	while (!Enumerated && !EnumerationError)
+	{
+		USB_USBTask();
+
+		if ((OhciSim_GetFrameNumber() - Start) > ENUMERATION_TIMEOUT_FRAMES)
+		{
+			printf("Enumeration timed out in host state %d\n", USB_HostState[0]);
+			return false;
+		}
+	}
+
+	return !EnumerationError;
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t ObjectSizes[] = { 0, 1, 51, 52, 53, 116, 500, 4084, 4096, 5000, 65536, 1024 * 1024 };
+	uint32_t Objects = sizeof(ObjectSizes) / sizeof(ObjectSizes[0]);
+	uint32_t CameraRate = 0;
+	uint32_t WriteUS = 0;
+	uint32_t FramePeriodUS = 1000;
+	uint64_t Start, Frames;
+	uint64_t TotalBytes = 0, TotalFrames = 0;
+	uint32_t Failures = 0;
+	uint32_t i;
+	uint8_t  ErrorCode;
+	Download_t Object;
+	int Option;
+
+	while ((Option = getopt(argc, argv, "b:r:w:t:")) != -1)
+	{
+		switch (Option)
+		{
+		case 'b': ObjectSizes[Objects - 1] = atoi(optarg); break;
+		case 'r': CameraRate = atoi(optarg); break;
+		case 'w': WriteUS = atoi(optarg); break;
+		case 't': FramePeriodUS = atoi(optarg); break;
+		default:
+			fprintf(stderr, "usage: %s [-b large object bytes] [-r camera bytes per second, 0 unlimited] [-w us per 4 KB block written] [-t us per frame]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	SI_Device_Init(&VirtualCamera, ObjectSizes, Objects, CameraRate);
+
+	if ((FramePeriodUS < 1) || !OhciSim_Init(FramePeriodUS))
+	{
+		fprintf(stderr, "cannot start the OHCI model\n");
+		return 1;
+	}
+
+	USB_Init();
+
+	if (!EnumerateCamera() || !ListObjects())
+		return 1;
+
+	printf("%u objects, camera %s, %u us per %u byte block written\n\n", HandleCount,
+		   CameraRate ? "rate limited" : "unlimited", WriteUS, WRITE_BLOCK);
+	printf("%-10s %9s %9s %8s %8s %9s %8s %s\n", "handle", "size", "received", "errors", "frames", "kB/s", "blocks", "result");
+
+	for (i = 0; i < HandleCount; i++)
+	{
+		memset(&Object, 0, sizeof(Object));
+		Object.Handle  = Handles[i];
+		Object.WriteUS = WriteUS;
+
+		Start     = OhciSim_GetFrameNumber();
+		ErrorCode = SI_Host_GetObject(&DigitalCamera_SI_Interface, Object.Handle, ObjectChunk, &Object, &Object.Size);
+		Frames    = OhciSim_GetFrameNumber() - Start;
+
+		TotalBytes  += Object.Received;
+		TotalFrames += Frames;
+
+		if (ErrorCode || Object.Errors || (Object.Size != ObjectSizes[i]) || (Object.Received != Object.Size))
+			Failures++;
+
+		printf("%08X   %9u %9u %8u %8llu %9.1f %8u %s", Object.Handle, Object.Size, Object.Received, Object.Errors,
+			   (unsigned long long) Frames, Frames ? (double) Object.Received / Frames : 0.0, Object.Blocks,
+			   (ErrorCode || Object.Errors || (Object.Size != ObjectSizes[i]) || (Object.Received != Object.Size)) ? "FAILED" : "ok");
+		if (ErrorCode)
+			printf(" (error %u)", ErrorCode);
+		printf("\n");
+	}
+
+	/* A failed operation must leave the session usable */
+	memset(&Object, 0, sizeof(Object));
+	ErrorCode = SI_Host_GetObject(&DigitalCamera_SI_Interface, 0xDEAD, ObjectChunk, &Object, &Object.Size);
+	printf("\ninvalid handle: error %u, %u bytes delivered %s\n", ErrorCode, Object.Received,
+		   ((ErrorCode == SI_ERROR_LOGICAL_CMD_FAILED) && !Object.Received) ? "ok" : "FAILED");
+	if ((ErrorCode != SI_ERROR_LOGICAL_CMD_FAILED) || Object.Received)
+		Failures++;
+
+	/* A data phase ended before its declared length is an error, with the bytes delivered reported */
+	memset(&Object, 0, sizeof(Object));
+	Object.Handle         = Handles[9];
+	VirtualCamera.ShortBy = 1000;
+	ErrorCode = SI_Host_GetObject(&DigitalCamera_SI_Interface, Object.Handle, ObjectChunk, &Object, &Object.Size);
+	printf("short object: error %u, size %u, %u bytes delivered %s\n", ErrorCode, Object.Size, Object.Received,
+		   ((ErrorCode == PIPE_RWSTREAM_IncompleteTransfer) && (Object.Size == ObjectSizes[9] - 1000) &&
+			(Object.Received == Object.Size) && !Object.Errors) ? "ok" : "FAILED");
+	if ((ErrorCode != PIPE_RWSTREAM_IncompleteTransfer) || (Object.Size != ObjectSizes[9] - 1000) ||
+		(Object.Received != Object.Size) || Object.Errors)
+		Failures++;
+
+	ErrorCode = SI_Host_CloseSession(&DigitalCamera_SI_Interface);
+	printf("close session: error %u %s\n", ErrorCode, ErrorCode ? "FAILED" : "ok");
+	if (ErrorCode)
+		Failures++;
+
+	printf("\n%llu bytes in %llu frames, %.1f kB/s, camera protocol errors %llu, %u failures\n",
+		   (unsigned long long) TotalBytes, (unsigned long long) TotalFrames,
+		   TotalFrames ? (double) TotalBytes / TotalFrames : 0.0,
+		   (unsigned long long) VirtualCamera.ProtocolErrors, Failures);
+
+	OhciSim_Detach();
+	OhciSim_DeInit();
+	return Failures ? 1 : 0;
+}
@@ -0,0 +1,18 @@
+/*
+ * task.h
+ *
+ * Host simulation shim, see FreeRTOS.h.
+ */
+
+#ifndef HOSTSIM_TASK_H_
+#define HOSTSIM_TASK_H_
+
+#include "FreeRTOS.h"
+
+#define taskSCHEDULER_NOT_STARTED	1
+#define taskSCHEDULER_RUNNING		2
+
+void vTaskDelay(portTickType Ticks);
+portBASE_TYPE xTaskGetSchedulerState(void);
+
+#endif /* HOSTSIM_TASK_H_ */
@@ -0,0 +1,599 @@
+/*
+ * uart_bench.c
+ *
+ * UART driver benchmark without hardware. src/uart.c runs against the UART
+ * model (UART_Model.c), which takes its time from the slices of the device
+ * controller model (DCD_Model.c); no USB device is attached. The bench is the
+ * application: it sends text on UART0 (or the port of -p) the way a logger
+ * does, and the remote end of the line checks every character that arrives.
+ *
+ * Build on x86-64 Linux, from cortex_m3_nxp/:
+ *
+ *   gcc -std=gnu99 -O2 -no-pie -fno-pie \
+ *       -D__LPC17XX__ -D__CODE_RED -DUSB_DEVICE_ONLY -DUSE_FREERTOS_DELAY=0 \
+ *       -Wno-int-to-pointer-cast -Wno-pointer-to-int-cast \
+ *       -Ihostsim -I../CMSIS_CORE_LPC17xx/inc -Iinc \
+ *       -Ilpcusblib/Drivers/USB -Ilpcusblib/Drivers/USB/Class/Device -Ilpcusblib/user_config/device \
+ *       hostsim/uart_bench.c hostsim/DCD_Model.c hostsim/UART_Model.c src/uart.c \
+ *       -lpthread -lm -o uart_bench
+ *
+ * Usage: uart_bench [-p port] [-b baud] [-n lines] [-t us per frame]
+ *
+ * The buffers are the default sizes of uart.h; UART2 has none unless it is
+ * given some, e.g. -DUART2_BUFSIZE=0x40, for -p 2.
+ *
+ * First the rates the driver sets for common baud rates are compared with the
+ * divisor latch alone, (PCLK / 16) / baud, at the PCLK of the port (CCLK).
+ * The remote end then sends at the nominal rate asked for.
+ *
+ * As in vcom_bench, every register access is trapped: above 230400 baud the
+ * receive interrupts take longer than the 2 ms of wall time a virtual frame
+ * gets by default, and the reader falls behind. Give it -t 40000 there.
+ *
+ * The log test sends a line of LINE_LENGTH characters every LOG_PERIOD_MS and
+ * times how long each UARTSendStr() call keeps the application, in virtual
+ * time. The burst test then queues BURST_BYTES back to back, first through
+ * UARTTransmit(), which takes what fits in the transmit buffer and returns,
+ * then through UARTSend(), which waits for room; the line should stay busy
+ * from the first character to the last.
+ *
+ * The receive test has the remote send RX_BYTES back to back at each trigger
+ * level while the application reads them with UARTReceive(); the tail short of
+ * the trigger level comes in on the character timeout. The error test holds
+ * the interrupt off until the receive FIFO overruns, has the remote send at a
+ * rate too far off for the receiver and fills the receive buffer without
+ * reading it, and checks the counters UARTGetErrors() returns.
+ *
+ * The DMA tests repeat the burst with UARTTransmitDMA() on, then stream
+ * DMA_RX_BYTES into UARTReceiveDMA() with the application calling
+ * UARTReceiveDMAIdle() every IDLE_PERIOD_US, counting the callbacks and
+ * checking the bytes; last, a short message on an idle line is timed from its
+ * first character to the callback that hands its last one over. The DMA
+ * error test then fails a transfer of the transmit channel, whose run has to
+ * be given up and the next message sent whole, and one of the receive
+ * channel, after which the interrupt has to take the characters over.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+#include <LPC17xx.h>
+#include "uart.h"
+
+#include "DCD_Model.h"
+#include "UART_Model.h"
+
+#define LINE_LENGTH					100			/* characters per log line, the line feed included */
+#define LOG_PERIOD_MS				20
+#define BURST_BYTES					8192
+#define RX_BYTES					4096
+#define FIFO_DEPTH					16
+#define DMA_RX_BYTES				32768
+#define DMA_RX_BUFFER				512			/* two halves of 256 */
+#define IDLE_PERIOD_US				1000
+#define IDLE_MESSAGE				10
+#define DMA_ERROR_BYTES				64
+#define MAX_BUFSIZE					0x1000		/* largest receive buffer the error test fills */
+
+typedef struct {
+	UartSim_Stats_t Uart;
+	uint64_t        DmaInterrupts;
+	uint64_t        Time;
+} Sample_t;
+
+uint32_t SystemCoreClock = 100000000;
+
+static uint32_t Port;
+static uint32_t Baud = 115200;
+static uint32_t RemoteBaud;
+static uint32_t LogLines = 100;
+static uint32_t RxBufferSize;
+static uint32_t TxBufferSize;
+
+static const uint32_t RxBufferSizes[4] = {UART0_BUFSIZE, UART1_BUFSIZE, UART2_BUFSIZE, UART3_BUFSIZE};
+static const uint32_t TxBufferSizes[4] = {UART0_TX_BUFSIZE, UART1_TX_BUFSIZE, UART2_TX_BUFSIZE, UART3_TX_BUFSIZE};
+
+/* What the remote end should see, and how far it got */
+static uint8_t          *Expected;
+static uint32_t          ExpectedLength;
+static volatile uint32_t Arrived;
+static volatile uint32_t Mismatches;
+static volatile uint64_t LastArrival;
+static volatile bool     Discard;		/* arrivals only counted, see TestDmaErrors() */
+static volatile uint32_t Discarded;
+
+/* No USB device in this bench: the DCD model only provides the time */
+void DcdIrqHandler(uint8_t DeviceID)
+{
+}
+
+static void Sink(uint8_t Port, uint8_t Data)
+{
+	if (Discard)
+	{
+		Discarded++;
+		return;
+	}
+	if ((Arrived >= ExpectedLength) || (Expected[Arrived] != Data))
+		Mismatches++;
+	Arrived++;
+	LastArrival = DcdSim_GetTime();
+}
+
+static void Expect(const void *Data, uint32_t Length)
+{
+	memcpy(&Expected[ExpectedLength], Data, Length);
+	ExpectedLength += Length;
+}
+
+static void TakeSample(Sample_t *Sample)
+{
+	UartSim_GetStats(Port, &Sample->Uart);
+	Sample->DmaInterrupts = UartSim_GetDmaInterrupts();
+	Sample->Time = DcdSim_GetTime();
+}
+
+static void PrintHeader(void)
+{
+	printf("%-8s %8s %9s %7s %11s %11s %8s %8s %8s\n",
+		   "test", "bytes", "kB/s", "line%", "blocked ms", "worst ms", "uart irq", "dma irq", "irq/B");
+}
+
+static void PrintResult(const char *Test, uint32_t Bytes, const Sample_t *Start, const Sample_t *End,
+						double LineBusy, double Blocked, double Worst)
+{
+	uint64_t Interrupts = End->Uart.Interrupts - Start->Uart.Interrupts;
+	uint64_t DmaInterrupts = End->DmaInterrupts - Start->DmaInterrupts;
+
+	printf("%-8s %8u %9.2f %7.1f %11.3f %11.3f %8llu %8llu %8.3f %s\n", Test, Bytes,
+		   Bytes / ((End->Time - Start->Time) / 1e9) / 1e3, 100.0 * LineBusy,
+		   Blocked / 1e6, Worst / 1e6, (unsigned long long) Interrupts, (unsigned long long) DmaInterrupts,
+		   (double) (Interrupts + DmaInterrupts) / Bytes,
+		   (Mismatches || (Arrived != ExpectedLength)) ? "MISMATCH" : "ok");
+}
+
+/* Waits for the remote to get everything queued so far */
+static void Drain(void)
+{
+	UARTFlush(Port);
+	while (Arrived < ExpectedLength)
+		usleep(100);
+}
+
+/*==========================================================================*/
+/* Tests                                                                   */
+/*==========================================================================*/
+static bool TestLog(void)
+{
+	char     Line[LINE_LENGTH + 1];
+	uint64_t Next, Called, Elapsed, Total = 0, Worst = 0;
+	Sample_t Start, End;
+	uint32_t i;
+
+	TakeSample(&Start);
+	Next = Start.Time;
+	for (i = 0; i < LogLines; i++)
+	{
+		while (DcdSim_GetTime() < Next)
+			;
+		Next += LOG_PERIOD_MS * 1000000ULL;
+
+		snprintf(Line, sizeof(Line), "%06llu.%03llu log line %5u ", (unsigned long long) (Next / 1000000000ULL),
+				 (unsigned long long) ((Next / 1000000ULL) % 1000), i);
+		memset(&Line[strlen(Line)], 'a' + (i % 26), LINE_LENGTH - 1 - strlen(Line));
+		Line[LINE_LENGTH - 1] = '\n';
+		Line[LINE_LENGTH] = '\0';
+
+		Expect(Line, LINE_LENGTH - 1);
+		Expect("\r\n", 2);
+
+		Called = DcdSim_GetTime();
+		UARTSendStr(Port, Line);
+		Elapsed = DcdSim_GetTime() - Called;
+		Total  += Elapsed;
+		Worst   = (Elapsed > Worst) ? Elapsed : Worst;
+	}
+	Drain();
+	TakeSample(&End);
+
+	PrintResult("log", LogLines * (LINE_LENGTH + 1), &Start, &End,
+				(LogLines * (LINE_LENGTH + 1) * 10.0 / UartSim_GetBaudRate(Port)) / ((End.Time - Start.Time) / 1e9),
+				(double) Total / LogLines, Worst);
+	return !Mismatches && (Arrived == ExpectedLength);
+}
+
+static bool TestBurst(const char *Test)
+{
+	uint8_t  *Block = &Expected[ExpectedLength];
+	uint32_t  Queued, i;
+	uint64_t  Called, Blocked;
+	Sample_t  Start, End;
+
+	for (i = 0; i < BURST_BYTES; i++)
+		Block[i] = (uint8_t) (i * 7 + (i >> 8));
+	ExpectedLength += BURST_BYTES;
+
+	TakeSample(&Start);
+	Called = DcdSim_GetTime();
+	Queued = UARTTransmit(Port, Block, BURST_BYTES);
+	UARTSend(Port, &Block[Queued], BURST_BYTES - Queued);
+	Blocked = DcdSim_GetTime() - Called;
+	Drain();
+	TakeSample(&End);
+	End.Time = LastArrival;
+
+	if (Queued != TxBufferSize)
+		printf("UARTTransmit() queued %u bytes of %u, the transmit buffer holds %u\n", Queued, BURST_BYTES, TxBufferSize);
+
+	PrintResult(Test, BURST_BYTES, &Start, &End,
+				(BURST_BYTES * 10.0 / UartSim_GetBaudRate(Port)) / ((End.Time - Start.Time) / 1e9),
+				Blocked, Blocked);
+	return !Mismatches && (Arrived == ExpectedLength) && (Queued == TxBufferSize);
+}
+
+static uint64_t CharacterNs(void)
+{
+	return (uint64_t) (10e9 / UartSim_GetBaudRate(Port));
+}
+
+static void WaitNs(uint64_t Ns)
+{
+	uint64_t End = DcdSim_GetTime() + Ns;
+
+	while (DcdSim_GetTime() < End)
+		;
+}
+
+/* Reads until Length bytes came or the line has been idle for a while */
+static uint32_t ReadBack(uint8_t *Buffer, uint32_t Length)
+{
+	uint32_t Count = 0, Got;
+	uint64_t Idle = DcdSim_GetTime();
+
+	while (Count < Length)
+	{
+		Got = UARTReceive(Port, &Buffer[Count], Length - Count);
+		Count += Got;
+		if (Got || UartSim_Pending(Port))
+			Idle = DcdSim_GetTime();
+		else if (DcdSim_GetTime() - Idle > 64 * CharacterNs())
+			break;
+	}
+	return Count;
+}
+
+static bool TestReceive(void)
+{
+	static const uint8_t Levels[] = {1, 4, 8, 14};
+	uint8_t      Sent[RX_BYTES], Read[RX_BYTES];
+	UARTErrors_t Before, After;
+	Sample_t     Start, End;
+	uint32_t     Count, i, l;
+	bool         Ok = true, Match;
+
+	printf("\n%-8s %8s %8s %8s %8s %8s %8s\n", "trigger", "bytes", "uart irq", "irq/B", "overrun", "framing", "dropped");
+	for (l = 0; l < sizeof(Levels); l++)
+	{
+		for (i = 0; i < RX_BYTES; i++)
+			Sent[i] = (uint8_t) (i * 13 + l + (i >> 8));
+
+		UARTSetRxTrigger(Port, Levels[l]);
+		UARTGetErrors(Port, &Before);
+		TakeSample(&Start);
+		UartSim_Send(Port, Sent, RX_BYTES);
+		Count = ReadBack(Read, RX_BYTES);
+		TakeSample(&End);
+		UARTGetErrors(Port, &After);
+		After.overrun -= Before.overrun;
+		After.framing -= Before.framing;
+		After.dropped -= Before.dropped;
+
+		Match = (Count == RX_BYTES) && !memcmp(Sent, Read, RX_BYTES) && !After.overrun && !After.framing && !After.dropped;
+		printf("%-8u %8u %8llu %8.3f %8u %8u %8u %s\n", Levels[l], Count,
+			   (unsigned long long) (End.Uart.Interrupts - Start.Uart.Interrupts),
+			   (double) (End.Uart.Interrupts - Start.Uart.Interrupts) / RX_BYTES,
+			   After.overrun, After.framing, After.dropped, Match ? "ok" : "MISMATCH");
+		Ok &= Match;
+	}
+	return Ok;
+}
+
+static bool TestErrors(void)
+{
+	uint8_t         Data[MAX_BUFSIZE + 64], Read[MAX_BUFSIZE + 64];
+	UARTErrors_t    Before, After;
+	UartSim_Stats_t Model[2];
+	uint32_t        Count, Length, i;
+	bool            Overrun, Framing, Dropped;
+
+	for (i = 0; i < sizeof(Data); i++)
+		Data[i] = (uint8_t) (i + 1);
+
+	/* The handler held off for 48 characters: the FIFO keeps the first 16 */
+	UARTGetErrors(Port, &Before);
+	UartSim_GetStats(Port, &Model[0]);
+	NVIC_DisableIRQ((IRQn_Type) (UART0_IRQn + Port));
+	UartSim_Send(Port, Data, 3 * FIFO_DEPTH);
+	while (UartSim_Pending(Port))
+		;
+	WaitNs(2 * CharacterNs());
+	NVIC_EnableIRQ((IRQn_Type) (UART0_IRQn + Port));
+	Count = ReadBack(Read, sizeof(Read));
+	UARTGetErrors(Port, &After);
+	UartSim_GetStats(Port, &Model[1]);
+	Overrun = (Count == FIFO_DEPTH) && !memcmp(Data, Read, FIFO_DEPTH) && (After.overrun == Before.overrun + 1);
+	printf("\noverrun  %u of %u characters read, %u lost in the FIFO, overrun counted %u time(s) %s\n",
+		   Count, 3 * FIFO_DEPTH, (uint32_t) (Model[1].Overruns - Model[0].Overruns),
+		   After.overrun - Before.overrun, Overrun ? "ok" : "MISMATCH");
+
+	/* The remote 6% fast: every character has a framing error, and is still kept */
+	Before = After;
+	UartSim_Connect(Port, RemoteBaud + (RemoteBaud * 6) / 100, false, Sink);
+	UartSim_Send(Port, Data, FIFO_DEPTH);
+	Count = ReadBack(Read, sizeof(Read));
+	UartSim_Connect(Port, RemoteBaud, false, Sink);
+	UARTGetErrors(Port, &After);
+	Framing = (Count == FIFO_DEPTH) && (After.framing == Before.framing + FIFO_DEPTH);
+	printf("framing  %u characters read, %u framing errors counted %s\n",
+		   Count, After.framing - Before.framing, Framing ? "ok" : "MISMATCH");
+
+	/* Nobody reading: the receive buffer fills up and the rest is dropped */
+	Before = After;
+	Length = RxBufferSize + 64;
+	UartSim_Send(Port, Data, Length);
+	while (UartSim_Pending(Port))
+		;
+	WaitNs(8 * CharacterNs());
+	Count = ReadBack(Read, Length);
+	UARTGetErrors(Port, &After);
+	Dropped = (Count == RxBufferSize) && !memcmp(Data, Read, RxBufferSize) &&
+			  (After.dropped == Before.dropped + Length - RxBufferSize) && (After.overrun == Before.overrun);
+	printf("dropped  %u of %u characters read, %u dropped on the full %u byte buffer %s\n",
+		   Count, Length, After.dropped - Before.dropped, RxBufferSize, Dropped ? "ok" : "MISMATCH");
+
+	return Overrun && Framing && Dropped;
+}
+
+static bool TestRates(void)
+{
+	static const uint32_t Rates[] = {9600, 115200, 230400, 460800, 921600, 1500000};
+	uint32_t Pclk = SystemCoreClock, Divisor, i;
+	double   Plain, Fractional, PlainError, Error;
+	bool     Ok = true;
+
+	printf("%-8s %11s %9s %11s %9s\n", "baud", "DL only", "ppm", "DL+FDR", "ppm");
+	for (i = 0; i < sizeof(Rates) / sizeof(Rates[0]); i++)
+	{
+		Divisor = (Pclk / 16) / Rates[i];
+		Plain = Divisor ? (Pclk / 16.0) / Divisor : 0;
+		UARTBaudrate(Port, Rates[i]);
+		Fractional = UartSim_GetBaudRate(Port);
+
+		PlainError = 1e6 * (Plain - Rates[i]) / Rates[i];
+		Error = 1e6 * (Fractional - Rates[i]) / Rates[i];
+		printf("%-8u %11.0f %9.0f %11.0f %9.0f %s\n", Rates[i], Plain, PlainError, Fractional, Error,
+			   ((Error < 5000) && (Error > -5000) && (fabs(Error) <= fabs(PlainError))) ? "ok" : "OFF");
+		Ok &= (Error < 5000) && (Error > -5000) && (fabs(Error) <= fabs(PlainError));
+	}
+	printf("\n");
+
+	UARTBaudrate(Port, Baud);
+	return Ok;
+}
+
+/* What the callbacks of the DMA receiver handed over */
+static uint8_t           DmaRxBuffer[DMA_RX_BUFFER];
+static uint8_t          *DmaRead;
+static volatile uint32_t DmaReadCount;
+static volatile uint32_t DmaCallbacks;
+
+static void DmaReceived(uint32_t portNum, uint8_t *data, uint32_t length)
+{
+	if (DmaReadCount + length <= DMA_RX_BYTES)
+		memcpy(&DmaRead[DmaReadCount], data, length);
+	DmaReadCount += length;
+	DmaCallbacks++;
+}
+
+/* Feeds the line and runs the idle check until Length bytes were handed over */
+static uint32_t DmaReceive(const uint8_t *Data, uint32_t Length, uint32_t *IdleFlushes)
+{
+	uint32_t Sent = 0, Flushed = 0;
+	uint64_t NextCheck = DcdSim_GetTime(), Idle = DcdSim_GetTime();
+
+	while (DmaReadCount < Length)
+	{
+		if (Sent < Length)
+			Sent += UartSim_Send(Port, &Data[Sent], Length - Sent);
+
+		if (DcdSim_GetTime() >= NextCheck)
+		{
+			NextCheck = DcdSim_GetTime() + (IDLE_PERIOD_US * 1000ULL);
+			if (UARTReceiveDMAIdle(Port))
+				Flushed++;
+		}
+
+		if ((Sent < Length) || UartSim_Pending(Port))
+			Idle = DcdSim_GetTime();
+		else if (DcdSim_GetTime() - Idle > 4 * IDLE_PERIOD_US * 1000ULL)
+			break;
+	}
+	*IdleFlushes = Flushed;
+	return DmaReadCount;
+}
+
+static bool TestDma(void)
+{
+	uint8_t  Data[DMA_RX_BYTES];
+	Sample_t Start, End;
+	uint32_t Count, Flushes, i;
+	uint64_t Sent;
+	bool     Stream, Idle;
+
+	printf("\n");
+	PrintHeader();
+	UARTTransmitDMA(Port, 1);
+	if (!TestBurst("dma tx"))
+		return false;
+	UARTTransmitDMA(Port, 0);
+
+	for (i = 0; i < DMA_RX_BYTES; i++)
+		Data[i] = (uint8_t) (i * 11 + (i >> 9));
+	DmaRead = malloc(DMA_RX_BYTES);
+	DmaReadCount = 0;
+	DmaCallbacks = 0;
+
+	/* The FIFO must reach its trigger level well within an idle period */
+	UARTSetRxTrigger(Port, 8);
+	UARTReceiveDMA(Port, DmaRxBuffer, sizeof(DmaRxBuffer), DmaReceived);
+	TakeSample(&Start);
+	Count = DmaReceive(Data, DMA_RX_BYTES, &Flushes);
+	TakeSample(&End);
+
+	Stream = (Count == DMA_RX_BYTES) && !memcmp(Data, DmaRead, DMA_RX_BYTES) &&
+			 (End.Uart.Overruns == Start.Uart.Overruns) && (End.Uart.Interrupts == Start.Uart.Interrupts);
+	printf("\n%-8s %8s %9s %7s %8s %8s %8s %8s %8s\n",
+		   "test", "bytes", "kB/s", "line%", "uart irq", "dma irq", "calls", "B/call", "idle");
+	printf("%-8s %8u %9.2f %7.1f %8llu %8llu %8u %8.1f %8u %s\n", "dma rx", Count,
+		   Count / ((End.Time - Start.Time) / 1e9) / 1e3,
+		   100.0 * (Count * 10.0 / UartSim_GetBaudRate(Port)) / ((End.Time - Start.Time) / 1e9),
+		   (unsigned long long) (End.Uart.Interrupts - Start.Uart.Interrupts),
+		   (unsigned long long) (End.DmaInterrupts - Start.DmaInterrupts),
+		   DmaCallbacks, (double) Count / (DmaCallbacks ? DmaCallbacks : 1), Flushes, Stream ? "ok" : "MISMATCH");
+
+	/* A short message on an idle line: the idle check hands it over */
+	DmaReadCount = 0;
+	Sent = DcdSim_GetTime();
+	Count = DmaReceive(Data, IDLE_MESSAGE, &Flushes);
+	Idle = (Count == IDLE_MESSAGE) && !memcmp(Data, DmaRead, IDLE_MESSAGE);
+	printf("idle     %u bytes handed over %.3f ms after the first was sent: %.3f ms on the line, "
+		   "idle check every %.3f ms %s\n", Count, (DcdSim_GetTime() - Sent) / 1e6,
+		   IDLE_MESSAGE * CharacterNs() / 1e6, IDLE_PERIOD_US / 1e3, Idle ? "ok" : "MISMATCH");
+
+	UARTReceiveDMA(Port, NULL, 0, NULL);
+	free(DmaRead);
+	return Stream && Idle;
+}
+
+/* Transfers failing with a bus error on each channel */
+static bool TestDmaErrors(void)
+{
+	uint8_t  Message[DMA_ERROR_BYTES], Read[DMA_ERROR_BYTES];
+	uint64_t Interrupts;
+	uint32_t Callbacks, Count, i;
+	bool     Transmit, Receive;
+
+	for (i = 0; i < sizeof(Message); i++)
+		Message[i] = (uint8_t) ('0' + (i % 64));
+
+	/* The failed run is lost, what the remote got of the message is only counted */
+	UARTTransmitDMA(Port, 1);
+	Interrupts = UartSim_GetDmaInterrupts();
+	Discarded = 0;
+	Discard = true;
+	UartSim_FailDma(Port, false);
+	UARTSend(Port, Message, sizeof(Message));
+	WaitNs((sizeof(Message) + 2) * CharacterNs());
+	Discard = false;
+
+	/* Without the error interrupt the ring would wait for the stopped channel forever */
+	if (UartSim_GetDmaInterrupts() == Interrupts)
+	{
+		printf("\ndma err  tx: no interrupt for the failed run MISMATCH\n");
+		return false;
+	}
+
+	Expect(Message, sizeof(Message));
+	UARTSend(Port, Message, sizeof(Message));
+	Drain();
+	UARTTransmitDMA(Port, 0);
+	Transmit = (Discarded < sizeof(Message)) && (UartSim_GetDmaInterrupts() > Interrupts) &&
+			   !Mismatches && (Arrived == ExpectedLength);
+	printf("\ndma err  tx: %u of %u characters lost with the failed run, next message %s\n",
+		   (uint32_t) sizeof(Message) - Discarded, (uint32_t) sizeof(Message), Transmit ? "ok" : "MISMATCH");
+
+	/* The receiver goes back to the interrupt, no callback comes */
+	DmaCallbacks = 0;
+	UARTReceiveDMA(Port, DmaRxBuffer, sizeof(DmaRxBuffer), DmaReceived);
+	Interrupts = UartSim_GetDmaInterrupts();
+	UartSim_FailDma(Port, true);
+	UartSim_Send(Port, Message, sizeof(Message));
+	Count = ReadBack(Read, sizeof(Read));
+	Callbacks = DmaCallbacks;
+	UARTReceiveDMA(Port, NULL, 0, NULL);
+	Receive = (Count == sizeof(Message)) && !memcmp(Message, Read, sizeof(Message)) && (Callbacks == 0) &&
+			  (UartSim_GetDmaInterrupts() > Interrupts);
+	printf("         rx: %u of %u characters read through the interrupt, %u callbacks %s\n",
+		   Count, (uint32_t) sizeof(Message), Callbacks, Receive ? "ok" : "MISMATCH");
+
+	return Transmit && Receive;
+}
+
+/*==========================================================================*/
+/* Main                                                                    */
+/*==========================================================================*/
+int main(int argc, char *argv[])
+{
+	uint32_t FramePeriodUS = 2000;
+	int ExitCode = 0;
+	int Option;
+
+	while ((Option = getopt(argc, argv, "p:b:n:t:")) != -1)
+	{
+		switch (Option)
+		{
+		case 'p': Port = atoi(optarg); break;
+		case 'b': Baud = atoi(optarg); break;
+		case 'n': LogLines = atoi(optarg); break;
+		case 't': FramePeriodUS = atoi(optarg); break;
+		default:
+			fprintf(stderr, "usage: %s [-p port] [-b baud] [-n lines] [-t us per frame]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	if ((Port > 3) || (Baud < 1200) || (LogLines < 1) || (FramePeriodUS < 8))
+	{
+		fprintf(stderr, "port 0 to 3, baud at least 1200, at least 1 line, frame period at least 8 us\n");
+		return 2;
+	}
+
+	Expected = malloc(LogLines * (LINE_LENGTH + 1) + (2 * BURST_BYTES) + DMA_ERROR_BYTES);
+	if ((Expected == NULL) || !DcdSim_Init(FramePeriodUS) || !UartSim_Init())
+	{
+		fprintf(stderr, "cannot start the device controller or UART model\n");
+		return 1;
+	}
+
+	/* PCLK of the port at CCLK, as the examples set it */
+	if (Port < 2)
+		UartSim_SC.PCLKSEL0 |= 1 << (6 + (2 * Port));
+	else
+		UartSim_SC.PCLKSEL1 |= 1 << (16 + (2 * (Port - 2)));
+	RxBufferSize = RxBufferSizes[Port];
+	TxBufferSize = TxBufferSizes[Port];
+	if ((RxBufferSize > MAX_BUFSIZE) || !UARTInit(Port, Baud))
+	{
+		fprintf(stderr, "UART%u has no buffers, or more than %u bytes of receive buffer\n", Port, MAX_BUFSIZE);
+		return 1;
+	}
+
+	RemoteBaud = Baud;
+	UartSim_Connect(Port, RemoteBaud, false, Sink);
+
+	printf("UART%u at %.0f baud (%u asked), %u byte transmit buffer, %u byte bursts, %u byte receive buffer\n\n",
+		   Port, UartSim_GetBaudRate(Port), Baud, TxBufferSize, UART_TX_BURST, RxBufferSize);
+	if (!TestRates())
+		ExitCode = 1;
+
+	PrintHeader();
+	if (!TestLog() || !TestBurst("burst") || !TestReceive() || !TestErrors() || !TestDma() || !TestDmaErrors())
+		ExitCode = 1;
+
+	DcdSim_DeInit();
+	free(Expected);
+	return ExitCode;
+}
@@ -0,0 +1,347 @@
+/*
+ * vcom_bench.c
+ *
+ * USB to UART bridge benchmark without hardware. The unmodified device stack
+ * (the LPC17xx DCD, CDCClassDevice.c and USBVirtualSerialDevice.c with
+ * src/uart.c below it) runs against the device controller model
+ * (DCD_Model.c) on the USB side and the UART model (UART_Model.c) on the
+ * other, with the UART looped back. A host thread enumerates the device and
+ * opens the port; then one thread writes a pattern to the OUT endpoint while
+ * another reads it back from the IN endpoint, as a terminal program with a
+ * loopback plug would. Everything runs in virtual time, so the throughput is
+ * compared with what the line carries at the rate the divisors give.
+ *
+ * Build on x86-64 Linux, from cortex_m3_nxp/:
+ *
+ *   gcc -std=gnu99 -O2 -no-pie -fno-pie \
+ *       -D__LPC17XX__ -D__CODE_RED -DUSB_DEVICE_ONLY -DUSE_FREERTOS_DELAY=0 \
+ *       -Wno-int-to-pointer-cast -Wno-pointer-to-int-cast \
+ *       -Ihostsim -I../CMSIS_CORE_LPC17xx/inc -Iinc \
+ *       -Ilpcusblib/Drivers/USB -Ilpcusblib/Drivers/USB/Class/Device -Ilpcusblib/user_config/device \
+ *       hostsim/vcom_bench.c hostsim/DCD_Model.c hostsim/HAL_DevSim.c hostsim/UART_Model.c src/uart.c \
+ *       lpcusblib/Drivers/USB/Core/[A-Z]*.c lpcusblib/Drivers/USB/Core/LPC/[A-Z]*.c \
+ *       lpcusblib/Drivers/USB/Core/LPC/DCD/LPC17XX/Endpoint_LPC17xx.c \
+ *       lpcusblib/Drivers/USB/Class/Device/CDCClassDevice.c \
+ *       lpcusblib/user_config/device/USBVirtualSerialDevice.c lpcusblib/user_config/device/USBVirtualSerialDescriptors.c \
+ *       -lpthread -o vcom_bench
+ *
+ * Add -DVCOM_FLUSH_LATENCY_MS=0 to send the bytes from the UART at every call
+ * of the task, for comparison.
+ *
+ * Usage: vcom_bench [-b baud] [-n bytes] [-t us per frame]
+ *
+ * Every register access of the DCD and the UART is trapped, so a virtual frame
+ * gets 4 ms of wall time by default (-t) for the device to keep up. That is
+ * enough up to 230400 baud; above it the receive interrupts alone take longer
+ * than that, the receive buffer of the UART driver overflows in wall time and
+ * the reader waits for bytes that never come. Give it -t 16000 there.
+ *
+ * The stream test checks that every byte comes back in order. The latency test
+ * then sends single bytes on an idle line and times their return, which the
+ * latency timer of the IN direction bounds.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <signal.h>
+
+#include "USBVirtualSerialDevice.h"
+#include "uart.h"
+
+#include "DCD_Model.h"
+#include "UART_Model.h"
+
+#define PACKET_SIZE					CDC_TXRX_EPSIZE
+#define WRITE_CHUNK					512			/* bytes per OUT transfer of the writer */
+#define READ_CHUNK					4096		/* bytes asked for per IN transfer of the reader */
+#define LATENCY_PROBES				8
+#define SETTLE_FRAMES				2			/* frames given to the device after SET_CONFIGURATION */
+
+typedef struct {
+	DcdSim_Stats_t  Sim;
+	UartSim_Stats_t Uart;
+	uint64_t        Time;
+} Sample_t;
+
+uint32_t SystemCoreClock = 100000000;
+
+static volatile bool HostDone;
+static int      ExitCode;
+static uint32_t Baud = 115200;
+static uint32_t StreamBytes = 16384;
+static uint8_t *Expected;
+static uint32_t InTransfers;
+static uint32_t Mismatches;
+static bool     WriteFailed;
+static bool     ReadFailed;
+
+/*==========================================================================*/
+/* Host                                                                    */
+/*==========================================================================*/
+static DcdSim_Result_t ControlRequest(uint8_t RequestType, uint8_t Request, uint16_t Value, uint16_t Index,
+									  void *Data, uint16_t Length, uint16_t *Actual)
+{
+	const uint8_t Setup[8] = {RequestType, Request, Value & 0xFF, Value >> 8, Index & 0xFF, Index >> 8,
+							  Length & 0xFF, Length >> 8};
+
+	return DcdSim_Control(Setup, Data, Actual);
+}
+
+static bool Enumerate(void)
+{
+	uint8_t  Descriptor[256];
+	uint8_t  LineCoding[7] = {Baud, Baud >> 8, Baud >> 16, Baud >> 24, CDC_LINEENCODING_OneStopBit, CDC_PARITY_None, 8};
+	uint16_t Actual;
+	uint16_t TotalLength;
+	uint64_t Start, Configured;
+
+	if (DcdSim_WaitForConnect(2000) != DCDSIM_OK)
+	{
+		printf("Device did not connect\n");
+		return false;
+	}
+	Start = DcdSim_GetFrameNumber();
+
+	if ((ControlRequest(REQDIR_DEVICETOHOST, REQ_GetDescriptor, DTYPE_Device << 8, 0, Descriptor, 8, &Actual) != DCDSIM_OK) ||
+		(ControlRequest(REQDIR_HOSTTODEVICE, REQ_SetAddress, 1, 0, NULL, 0, NULL) != DCDSIM_OK) ||
+		(ControlRequest(REQDIR_DEVICETOHOST, REQ_GetDescriptor, DTYPE_Device << 8, 0, Descriptor, 18, &Actual) != DCDSIM_OK) ||
+		(Actual != 18) ||
+		(ControlRequest(REQDIR_DEVICETOHOST, REQ_GetDescriptor, DTYPE_Configuration << 8, 0, Descriptor, 9, &Actual) != DCDSIM_OK))
+	{
+		printf("Enumeration failed\n");
+		return false;
+	}
+
+	TotalLength = MIN(Descriptor[2] | (Descriptor[3] << 8), sizeof(Descriptor));
+	if ((ControlRequest(REQDIR_DEVICETOHOST, REQ_GetDescriptor, DTYPE_Configuration << 8, 0, Descriptor, TotalLength, &Actual) != DCDSIM_OK) ||
+		(Actual != TotalLength) ||
+		(ControlRequest(REQDIR_HOSTTODEVICE, REQ_SetConfiguration, 1, 0, NULL, 0, NULL) != DCDSIM_OK))
+	{
+		printf("Configuration failed\n");
+		return false;
+	}
+
+	/* The device configures its endpoints after the status stage of SET_CONFIGURATION;
+	 * a request that comes in meanwhile is taken for an unsupported one and stalled
+	 */
+	Configured = DcdSim_GetFrameNumber();
+	while (DcdSim_GetFrameNumber() < Configured + SETTLE_FRAMES)
+		usleep(100);
+
+	/* What a terminal program does when it opens the port */
+	if ((ControlRequest(REQDIR_HOSTTODEVICE | REQTYPE_CLASS | REQREC_INTERFACE, CDC_REQ_SetLineEncoding, 0, 0,
+						LineCoding, sizeof(LineCoding), NULL) != DCDSIM_OK) ||
+		(ControlRequest(REQDIR_DEVICETOHOST | REQTYPE_CLASS | REQREC_INTERFACE, CDC_REQ_GetLineEncoding, 0, 0,
+						Descriptor, sizeof(LineCoding), &Actual) != DCDSIM_OK) ||
+		(Actual != sizeof(LineCoding)) || memcmp(Descriptor, LineCoding, sizeof(LineCoding)) ||
+		(ControlRequest(REQDIR_HOSTTODEVICE | REQTYPE_CLASS | REQREC_INTERFACE, CDC_REQ_SetControlLineState,
+						CDC_CONTROL_LINE_OUT_DTR | CDC_CONTROL_LINE_OUT_RTS, 0, NULL, 0, NULL) != DCDSIM_OK))
+	{
+		printf("Opening the port failed\n");
+		return false;
+	}
+
+	printf("Enumerated and opened in %llu frames, %u configuration bytes\n",
+		   (unsigned long long) (DcdSim_GetFrameNumber() - Start), TotalLength);
+	return true;
+}
+
+static void *WriterThread(void *Argument)
+{
+	uint32_t Sent, Chunk;
+
+	for (Sent = 0; Sent < StreamBytes; Sent += Chunk)
+	{
+		Chunk = MIN(WRITE_CHUNK, StreamBytes - Sent);
+		if (DcdSim_BulkOut(CDC_RX_EPNUM, &Expected[Sent], Chunk, PACKET_SIZE) != DCDSIM_OK)
+		{
+			printf("OUT transfer failed after %u bytes\n", Sent);
+			WriteFailed = true;
+			break;
+		}
+	}
+	return NULL;
+}
+
+static void *ReaderThread(void *Argument)
+{
+	uint8_t  Buffer[READ_CHUNK];
+	uint32_t Received = 0, Actual, i;
+
+	while (Received < StreamBytes)
+	{
+		if (DcdSim_BulkIn(CDC_TX_EPNUM, Buffer, sizeof(Buffer), PACKET_SIZE, &Actual) != DCDSIM_OK)
+		{
+			printf("IN transfer failed after %u bytes\n", Received);
+			ReadFailed = true;
+			break;
+		}
+
+		InTransfers++;
+		for (i = 0; (i < Actual) && (Received + i < StreamBytes); i++)
+		{
+			if (Buffer[i] != Expected[Received + i])
+				Mismatches++;
+		}
+		Received += Actual;
+	}
+
+	if (Received > StreamBytes)
+		Mismatches += Received - StreamBytes;
+	return NULL;
+}
+
+/*==========================================================================*/
+/* Measurement                                                             */
+/*==========================================================================*/
+static void TakeSample(Sample_t *Sample)
+{
+	DcdSim_GetStats(&Sample->Sim);
+	UartSim_GetStats(VCOM_UART_PORT, &Sample->Uart);
+	Sample->Time = DcdSim_GetTime();
+}
+
+static bool TestStream(void)
+{
+	Sample_t  Start, End;
+	pthread_t Writer, Reader;
+	double    Seconds, LineRate;
+	uint32_t  i;
+
+	for (i = 0; i < StreamBytes; i++)
+		Expected[i] = (uint8_t) (i * 7 + (i >> 8));
+
+	TakeSample(&Start);
+	pthread_create(&Reader, NULL, ReaderThread, NULL);
+	pthread_create(&Writer, NULL, WriterThread, NULL);
+	pthread_join(Writer, NULL);
+	pthread_join(Reader, NULL);
+	TakeSample(&End);
+
+	Seconds  = (End.Time - Start.Time) / 1e9;
+	LineRate = UartSim_GetBaudRate(VCOM_UART_PORT) / 10;		/* 8N1 */
+
+	printf("%-8s %8s %9s %7s %8s %9s %8s %8s %8s %8s\n",
+		   "test", "bytes", "kB/s", "line%", "IN xfers", "B/IN xfer", "uart irq", "dma B", "overruns", "naks");
+	printf("%-8s %8u %9.2f %7.1f %8u %9.1f %8llu %8llu %8llu %8llu %s\n", "stream", StreamBytes,
+		   StreamBytes / Seconds / 1e3, 100.0 * (StreamBytes / Seconds) / LineRate,
+		   InTransfers, (double) StreamBytes / (InTransfers ? InTransfers : 1),
+		   (unsigned long long) (End.Uart.Interrupts - Start.Uart.Interrupts),
+		   (unsigned long long) (End.Uart.DmaBytes - Start.Uart.DmaBytes),
+		   (unsigned long long) (End.Uart.Overruns - Start.Uart.Overruns),
+		   (unsigned long long) (End.Sim.Naks - Start.Sim.Naks),
+		   (WriteFailed || ReadFailed) ? "FAILED" : (Mismatches ? "MISMATCH" : "ok"));
+
+	return !WriteFailed && !ReadFailed && !Mismatches;
+}
+
+/* Single bytes on an idle line: the time to come back is the character time twice
+ * over (the DMA and the loopback), plus the wait for the IN packet to be sent
+ */
+static bool TestLatency(void)
+{
+	uint8_t  Byte, Echo[PACKET_SIZE];
+	uint32_t Actual, i;
+	uint64_t Start, Total = 0, Worst = 0, Elapsed;
+
+	for (i = 0; i < LATENCY_PROBES; i++)
+	{
+		Byte = 0xA5 ^ i;
+		Start = DcdSim_GetTime();
+		if ((DcdSim_BulkOut(CDC_RX_EPNUM, &Byte, 1, PACKET_SIZE) != DCDSIM_OK) ||
+			(DcdSim_BulkIn(CDC_TX_EPNUM, Echo, sizeof(Echo), PACKET_SIZE, &Actual) != DCDSIM_OK) ||
+			(Actual != 1) || (Echo[0] != Byte))
+		{
+			printf("latency probe %u failed\n", i);
+			return false;
+		}
+
+		Elapsed = DcdSim_GetTime() - Start;
+		Total  += Elapsed;
+		Worst   = MAX(Worst, Elapsed);
+	}
+
+	printf("latency  %u probes: mean %.2f ms, worst %.2f ms, latency timer %u ms, character %.3f ms\n",
+		   LATENCY_PROBES, Total / 1e6 / LATENCY_PROBES, Worst / 1e6, VCOM_FLUSH_LATENCY_MS,
+		   10e3 / UartSim_GetBaudRate(VCOM_UART_PORT));
+	return true;
+}
+
+static void *HostThread(void *Argument)
+{
+	ExitCode = 1;
+	if (Enumerate())
+	{
+		printf("UART%u at %.0f baud (%u asked), looped back, %u byte TX ring, %u byte receive buffer\n\n",
+			   VCOM_UART_PORT, UartSim_GetBaudRate(VCOM_UART_PORT), Baud, VCOM_TX_RING_SIZE, UART_BUFSIZE);
+
+		if (TestStream() & TestLatency())
+			ExitCode = 0;
+	}
+
+	HostDone = true;
+	return NULL;
+}
+
+/*==========================================================================*/
+/* Main                                                                    */
+/*==========================================================================*/
+int main(int argc, char *argv[])
+{
+	uint32_t FramePeriodUS = 4000;
+	pthread_t Host;
+	sigset_t Mask, Saved;
+	int Option;
+
+	while ((Option = getopt(argc, argv, "b:n:t:")) != -1)
+	{
+		switch (Option)
+		{
+		case 'b': Baud = atoi(optarg); break;
+		case 'n': StreamBytes = atoi(optarg); break;
+		case 't': FramePeriodUS = atoi(optarg); break;
+		default:
+			fprintf(stderr, "usage: %s [-b baud] [-n bytes] [-t us per frame]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	if ((Baud < 1200) || (StreamBytes < 1) || (FramePeriodUS < 8))
+	{
+		fprintf(stderr, "baud at least 1200, at least 1 byte, frame period at least 8 us\n");
+		return 2;
+	}
+
+	Expected = malloc(StreamBytes);
+	if ((Expected == NULL) || !DcdSim_Init(FramePeriodUS) || !UartSim_Init())
+	{
+		fprintf(stderr, "cannot start the device controller or UART model\n");
+		return 1;
+	}
+
+	/* PCLK of the bridged UART at CCLK, as main_ex_device_vcom.c sets it */
+	UartSim_SC.PCLKSEL0 |= 1 << (6 + (2 * VCOM_UART_PORT));
+	UartSim_Connect(VCOM_UART_PORT, 0, true, NULL);
+
+	VCOM_DeviceInit();
+
+	/* Slices must only interrupt the thread running the device stack */
+	sigemptyset(&Mask);
+	sigaddset(&Mask, SIGALRM);
+	pthread_sigmask(SIG_BLOCK, &Mask, &Saved);
+	pthread_create(&Host, NULL, HostThread, NULL);
+	pthread_sigmask(SIG_SETMASK, &Saved, NULL);
+
+	while (!HostDone)
+	{
+		VCOM_DeviceTask();
+	}
+
+	pthread_join(Host, NULL);
+	DcdSim_DeInit();
+	free(Expected);
+	return ExitCode;
+}
@@ -50,22 +50,141 @@
 #define LSR_TEMT		0x40
 #define LSR_RXFE		0x80
 
+#define LCR_WORD_LENGTH_5	0x00
+#define LCR_WORD_LENGTH_6	0x01
+#define LCR_WORD_LENGTH_7	0x02
+#define LCR_WORD_LENGTH_8	0x03
+#define LCR_STOP_BITS_2		0x04
+#define LCR_PARITY_ENABLE	0x08
+#define LCR_PARITY_ODD		0x00
+#define LCR_PARITY_EVEN		0x10
+#define LCR_PARITY_MARK		0x20
+#define LCR_PARITY_SPACE	0x30
+#define LCR_DLAB			0x80
+
+#define FCR_FIFO_ENABLE		0x01
+#define FCR_RX_RESET		0x02
+#define FCR_TX_RESET		0x04
+#define FCR_DMA_MODE		0x08
+#define FCR_TRIGGER_1		0x00
+#define FCR_TRIGGER_4		0x40
+#define FCR_TRIGGER_8		0x80
+#define FCR_TRIGGER_14		0xC0
+
+/* Receive buffer of a port, filled by the interrupt handler; a power of two.
+ * UARTn_BUFSIZE sizes the buffer of UARTn, UART_BUFSIZE is the default of
+ * UART0, UART1 and UART3. UART2 has none unless the application sizes it: a
+ * port whose receive buffer is 0 has no buffers at all and UARTInit()
+ * refuses it. */
+#if !defined(UART_BUFSIZE)
 #define UART_BUFSIZE	0x40
+#endif
+
+#if !defined(UART0_BUFSIZE)
+#define UART0_BUFSIZE	UART_BUFSIZE
+#endif
+#if !defined(UART1_BUFSIZE)
+#define UART1_BUFSIZE	UART_BUFSIZE
+#endif
+#if !defined(UART2_BUFSIZE)
+#define UART2_BUFSIZE	0
+#endif
+#if !defined(UART3_BUFSIZE)
+#define UART3_BUFSIZE	UART_BUFSIZE
+#endif
+
+/* Characters in the receive FIFO that raise the receive interrupt: 1, 4, 8
+ * or 14. Fewer are picked up by the character timeout, 4 characters later. */
+#if !defined(UART_RX_TRIGGER)
+#define UART_RX_TRIGGER	8
+#endif
+
+/* Transmit buffer of a port, drained by the THRE interrupt; a power of two.
+ * UARTn_TX_BUFSIZE sizes the buffer of UARTn, UART_TX_BUFSIZE is the default. */
+#if !defined(UART_TX_BUFSIZE)
+#define UART_TX_BUFSIZE	0x20
+#endif
+
+#if !defined(UART0_TX_BUFSIZE)
+#define UART0_TX_BUFSIZE	UART_TX_BUFSIZE
+#endif
+#if !defined(UART1_TX_BUFSIZE)
+#define UART1_TX_BUFSIZE	UART_TX_BUFSIZE
+#endif
+#if !defined(UART2_TX_BUFSIZE)
+#define UART2_TX_BUFSIZE	UART_TX_BUFSIZE
+#endif
+#if !defined(UART3_TX_BUFSIZE)
+#define UART3_TX_BUFSIZE	UART_TX_BUFSIZE
+#endif
+
+/* A port is left out, or has two buffers whose sizes are powers of two */
+#define UART_BUFSIZES_VALID(rx, tx)	(((rx) == 0) || (!((rx) & ((rx) - 1)) && ((tx) != 0) && !((tx) & ((tx) - 1))))
 
+#if !UART_BUFSIZES_VALID(UART0_BUFSIZE, UART0_TX_BUFSIZE) || !UART_BUFSIZES_VALID(UART1_BUFSIZE, UART1_TX_BUFSIZE) || \
+	!UART_BUFSIZES_VALID(UART2_BUFSIZE, UART2_TX_BUFSIZE) || !UART_BUFSIZES_VALID(UART3_BUFSIZE, UART3_TX_BUFSIZE)
+#error The UART buffer sizes must be powers of two
+#endif
+
+/* Bytes the THRE interrupt moves at a time, the depth of the transmit FIFO */
+#define UART_TX_BURST	16
+
+/* Longest block UARTSendDMA() takes, the transfer size of a GPDMA channel */
+#define UART_DMA_MAX_LENGTH	0xFFF
+
+/* Gets a stretch of the receive buffer of UARTReceiveDMA() */
+typedef void (*UARTRxCallback_t)(uint32_t portNum, uint8_t *data, uint32_t length);
+
+/* Receive errors of a port since UARTInit() */
+typedef struct UARTErrors {
+	uint32_t overrun;		/* times the receive FIFO lost characters */
+	uint32_t framing;		/* characters with a bad stop bit, kept */
+	uint32_t parity;		/* characters with a bad parity bit, kept */
+	uint32_t breaks;		/* break conditions, not stored */
+	uint32_t dropped;		/* characters lost on a full receive buffer */
+} UARTErrors_t;
+
+/* The indexes run freely and are masked on use; head is only written by the
+ * interrupt handler, tail by the readers */
 typedef struct UARTFifo {
-	uint8_t buffer[UART_BUFSIZE];
-	uint8_t head;
-	uint8_t tail;
+	uint8_t *buffer;
+	uint32_t mask;				/* size of the buffer - 1 */
+	volatile uint32_t head;
+	volatile uint32_t tail;
+	UARTErrors_t errors;
 } UARTFifo_t;
 
+/* The indexes run freely and are masked on use; head is only written by the
+ * senders, tail by the interrupt handler */
+typedef struct UARTTxFifo {
+	uint8_t *buffer;
+	uint32_t mask;				/* size of the buffer - 1 */
+	volatile uint32_t head;
+	volatile uint32_t tail;
+} UARTTxFifo_t;
+
 uint32_t UARTInit( uint32_t portNum, uint32_t Baudrate );
+void UARTBaudrate( uint32_t portNum, uint32_t baudrate );
+void UARTLineControl( uint32_t portNum, uint8_t lcr );
+void UARTSetRxTrigger( uint32_t portNum, uint32_t level );
+void UARTGetErrors( uint32_t portNum, UARTErrors_t *errors );
 void UART0_IRQHandler( void );
 void UART1_IRQHandler( void );
+void UART2_IRQHandler( void );
 void UART3_IRQHandler( void );
 void UARTSend( uint32_t portNum, uint8_t *BufferPtr, uint32_t Length );
 void UARTSendStr( uint32_t portNum, char *BufferPtr );
 void UARTPutChar(uint32_t portNum, char c);
+uint32_t UARTTransmit( uint32_t portNum, const uint8_t *BufferPtr, uint32_t Length );
+void UARTFlush( uint32_t portNum );
 char UARTGetChar( uint32_t portNum);
+uint32_t UARTReceive( uint32_t portNum, uint8_t *BufferPtr, uint32_t Length );
+uint32_t UARTSendDMA( uint32_t portNum, uint8_t *BufferPtr, uint32_t Length );
+uint32_t UARTSendDMABusy( uint32_t portNum );
+void DMA_IRQHandler( void );
+void UARTTransmitDMA( uint32_t portNum, uint32_t enable );
+uint32_t UARTReceiveDMA( uint32_t portNum, uint8_t *BufferPtr, uint32_t Length, UARTRxCallback_t callback );
+uint32_t UARTReceiveDMAIdle( uint32_t portNum );
 
 #endif /* end __UART_H */
 /*****************************************************************************
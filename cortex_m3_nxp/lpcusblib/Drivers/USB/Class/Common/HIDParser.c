@@ -34,6 +34,23 @@
 #define  __INCLUDE_FROM_HID_DRIVER
 #include "HIDParser.h"
 
+/* Item data is not sign extended when read, test its sign bit at the size the item was encoded with */
+static inline bool HID_IsItemNegative(const uint8_t HIDReportItem,
+                                      const uint32_t ReportItemData)
+{
+	switch (HIDReportItem & HID_RI_DATA_SIZE_MASK)
+	{
+		case HID_RI_DATA_BITS_32:
+			return ((ReportItemData & 0x80000000UL) != 0);
+		case HID_RI_DATA_BITS_16:
+			return ((ReportItemData & 0x8000) != 0);
+		case HID_RI_DATA_BITS_8:
+			return ((ReportItemData & 0x80) != 0);
+		default:
+			return false;
+	}
+}
+
 uint8_t USB_ProcessHIDReport(const uint8_t* ReportData,
                              uint16_t ReportSize,
                              HID_ReportInfo_t* const ParserData)
@@ -106,6 +123,7 @@ uint8_t USB_ProcessHIDReport(const uint8_t* ReportData,
 				break;
 			case HID_RI_LOGICAL_MINIMUM(0):
 				CurrStateTable->Attributes.Logical.Minimum  = ReportItemData;
+				CurrStateTable->Attributes.LogicalSigned    = HID_IsItemNegative(HIDReportItem, ReportItemData);
 				break;
 			case HID_RI_LOGICAL_MAXIMUM(0):
 				CurrStateTable->Attributes.Logical.Maximum  = ReportItemData;
@@ -289,15 +307,33 @@ uint8_t USB_ProcessHIDReport(const uint8_t* ReportData,
 	return HID_PARSE_Successful;
 }
 
+/* Reads the bytes holding a field of up to 32 bits at bit Shift of Data, Bytes being at most 5 */
+static inline uint32_t HID_LoadField(const uint8_t* Data,
+                                     const uint8_t Shift,
+                                     const uint8_t Bytes)
+{
+	uint32_t Value = 0;
+	uint8_t  i;
+
+	for (i = 0; (i < Bytes) && (i < 4); i++)
+	  Value |= ((uint32_t)Data[i] << (i * 8));
+
+	Value >>= Shift;
+
+	if (Bytes > 4)
+	  Value |= ((uint32_t)Data[4] << (32 - Shift));
+
+	return Value;
+}
+
 bool USB_GetHIDReportItemInfo(const uint8_t* ReportData,
                               HID_ReportItem_t* const ReportItem)
 {
 	if (ReportItem == NULL)
 	  return false;
 
-	uint16_t DataBitsRem  = ReportItem->Attributes.BitSize;
-	uint16_t CurrentBit   = ReportItem->BitOffset;
-	uint32_t BitMask      = (1 << 0);
+	uint8_t  BitSize = MIN(ReportItem->Attributes.BitSize, 32);
+	uint8_t  Shift   = (ReportItem->BitOffset % 8);
 
 	if (ReportItem->ReportID)
 	{
@@ -308,16 +344,8 @@ bool USB_GetHIDReportItemInfo(const uint8_t* ReportData,
 	}
 
 	ReportItem->PreviousValue = ReportItem->Value;
-	ReportItem->Value = 0;
-
-	while (DataBitsRem--)
-	{
-		if (ReportData[CurrentBit / 8] & (1 << (CurrentBit % 8)))
-		  ReportItem->Value |= BitMask;
-
-		CurrentBit++;
-		BitMask <<= 1;
-	}
+	ReportItem->Value = HID_LoadField(&ReportData[ReportItem->BitOffset / 8], Shift, (Shift + BitSize + 7) / 8) &
+	                    HID_FIELD_MASK(BitSize);
 
 	return true;
 }
@@ -328,9 +356,9 @@ void USB_SetHIDReportItemInfo(uint8_t* ReportData,
 	if (ReportItem == NULL)
 	  return;
 
-	uint16_t DataBitsRem  = ReportItem->Attributes.BitSize;
-	uint16_t CurrentBit   = ReportItem->BitOffset;
-	uint32_t BitMask      = (1 << 0);
+	int16_t  BitsRem = MIN(ReportItem->Attributes.BitSize, 32);
+	uint8_t  Shift   = (ReportItem->BitOffset % 8);
+	uint32_t Value   = (ReportItem->Value & HID_FIELD_MASK(BitsRem));
 
 	if (ReportItem->ReportID)
 	{
@@ -340,14 +368,113 @@ void USB_SetHIDReportItemInfo(uint8_t* ReportData,
 
 	ReportItem->PreviousValue = ReportItem->Value;
 
-	while (DataBitsRem--)
+	if (!(BitsRem))
+	  return;
+
+	ReportData = &ReportData[ReportItem->BitOffset / 8];
+
+	*(ReportData++) |= (uint8_t)(Value << Shift);
+	Value   >>= (8 - Shift);
+	BitsRem  -= (8 - Shift);
+
+	while (BitsRem > 0)
+	{
+		*(ReportData++) |= (uint8_t)Value;
+		Value   >>= 8;
+		BitsRem  -= 8;
+	}
+}
+
+uint8_t USB_CompileHIDReportPlan(const HID_ReportInfo_t* const ParserData,
+                                 const uint8_t ItemType,
+                                 HID_ReportPlan_t* const Plan)
+{
+	uint8_t i;
+
+	memset(Plan, 0x00, sizeof(HID_ReportPlan_t));
+
+	Plan->UsingReportIDs = ParserData->UsingReportIDs;
+
+	for (i = 0; i < ParserData->TotalReportItems; i++)
 	{
-		if (ReportItem->Value & (1 << (CurrentBit % 8)))
-		  ReportData[CurrentBit / 8] |= BitMask;
+		const HID_ReportItem_t* ReportItem = &ParserData->ReportItems[i];
+		HID_ReportPlanField_t*  Field;
 
-		CurrentBit++;
-		BitMask <<= 1;
+		if ((ReportItem->ItemType != ItemType) || (ReportItem->ItemFlags & HID_IOF_CONSTANT) ||
+		    !(ReportItem->Attributes.BitSize) || (ReportItem->Attributes.BitSize > 32))
+		{
+			continue;
+		}
+
+		if (Plan->TotalFields == HID_MAX_PLAN_FIELDS)
+		  return HID_PARSE_InsufficientReportItems;
+
+		Field = &Plan->Fields[Plan->TotalFields++];
+
+		Field->ByteOffset = (ReportItem->BitOffset / 8) + (ReportItem->ReportID ? 1 : 0);
+		Field->Shift      = (ReportItem->BitOffset % 8);
+		Field->Bytes      = (Field->Shift + ReportItem->Attributes.BitSize + 7) / 8;
+		Field->ReportID   = ReportItem->ReportID;
+		Field->Mask       = HID_FIELD_MASK(ReportItem->Attributes.BitSize);
+		Field->Usage      = ReportItem->Attributes.Usage;
+
+		Field->Signed     = ReportItem->Attributes.LogicalSigned;
+	}
+
+	return HID_PARSE_Successful;
+}
+
+uint8_t USB_ExtractHIDReportFields(const HID_ReportPlan_t* const Plan,
+                                   const uint8_t* ReportData,
+                                   const uint16_t ReportSize,
+                                   int32_t* const Values)
+{
+	const HID_ReportPlanField_t* Field    = Plan->Fields;
+	uint8_t                      ReportID = 0;
+	uint8_t                      Extracted = 0;
+	uint8_t                      i;
+
+	if (Plan->UsingReportIDs)
+	{
+		if (!(ReportSize))
+		  return 0;
+
+		ReportID = ReportData[0];
 	}
+
+	for (i = 0; i < Plan->TotalFields; i++, Field++)
+	{
+		const uint8_t* Data = &ReportData[Field->ByteOffset];
+		uint32_t       Value;
+
+		if ((Field->ReportID != ReportID) || ((Field->ByteOffset + Field->Bytes) > ReportSize))
+		  continue;
+
+		/* One word load covers any field of up to 25 bits; the report buffer has no alignment, memcpy() lets the
+		 * compiler pick an access that is allowed (a single LDR on the Cortex-M3) */
+		if ((Field->ByteOffset + 4) <= ReportSize)
+		{
+			memcpy(&Value, Data, sizeof(Value));
+			Value = (le32_to_cpu(Value) >> Field->Shift);
+
+			if (Field->Bytes > 4)
+			  Value |= ((uint32_t)Data[4] << (32 - Field->Shift));
+		}
+		else
+		{
+			Value = HID_LoadField(Data, Field->Shift, Field->Bytes);
+		}
+
+		Value &= Field->Mask;
+
+		if (Field->Signed && (Value & ~(Field->Mask >> 1)))
+		  Value |= ~(Field->Mask);
+
+		Values[i] = (int32_t)Value;
+		Extracted++;
+	}
+
+	return Extracted;
 }
 
 uint16_t USB_GetHIDReportSize(HID_ReportInfo_t* const ParserData,
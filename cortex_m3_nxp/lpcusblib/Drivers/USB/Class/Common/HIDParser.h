@@ -133,6 +133,15 @@
 			#define HID_MAX_REPORT_IDS            10
 		#endif
 
+		#if !defined(HID_MAX_PLAN_FIELDS) || defined(__DOXYGEN__)
+			/** Constant indicating the maximum number of fields in a compiled \ref HID_ReportPlan_t extraction plan. A plan
+			 *  field takes 16 bytes against the 56 bytes of a full \ref HID_ReportItem_t. By default this is set to 20
+			 *  fields, but this can be overridden by defining \c HID_MAX_PLAN_FIELDS to another value in the user project
+			 *  makefile, and passing the define to the compiler using the -D compiler switch.
+			 */
+			#define HID_MAX_PLAN_FIELDS           20
+		#endif
+
 		/** Returns the value a given HID report item (once its value has been fetched via \ref USB_GetHIDReportItemInfo())
 		 *  left-aligned to the given data type. This allows for signed data to be interpreted correctly, by shifting the data
 		 *  leftwards until the data's sign bit is in the correct position.
@@ -214,6 +223,9 @@
 				HID_Usage_t  Usage;    /**< Usage of the report item. */
 				HID_Unit_t   Unit;     /**< Unit type and exponent of the report item. */
 				HID_MinMax_t Logical;  /**< Logical minimum and maximum of the report item. */
+				bool         LogicalSigned; /**< Indicates a negative logical minimum, taken from the sign bit of the
+				                             *   Logical Minimum item at its own size: the item's values are signed.
+				                             */
 				HID_MinMax_t Physical; /**< Physical minimum and maximum of the report item. */
 			} HID_ReportItem_Attributes_t;
 
@@ -270,6 +282,37 @@
 				                                      */
 			} HID_ReportInfo_t;
 
+			/** \brief HID Report Extraction Plan Field Structure.
+			 *
+			 *  Type define for one field of a compiled \ref HID_ReportPlan_t, holding the byte position, shift and mask
+			 *  precomputed from a parsed report item so that its value is fetched with a word load instead of bit by bit.
+			 */
+			typedef struct
+			{
+				uint16_t    ByteOffset; /**< Offset of the first byte holding the field, report ID byte included. */
+				HID_Usage_t Usage;      /**< Usage of the report item the field was compiled from. */
+				uint8_t     Shift;      /**< Bit position of the field's least significant bit within that byte. */
+				uint8_t     Bytes;      /**< Number of report bytes the field spans, at most 5. */
+				uint8_t     ReportID;   /**< Report ID the field belongs to, or 0x00 if device has only one report. */
+				bool        Signed;     /**< Indicates a field with a negative logical minimum (see \c LogicalSigned), sign
+				                         *   extended on extraction.
+				                         */
+				uint32_t    Mask;       /**< Mask of the field's bits once shifted down. */
+			} HID_ReportPlanField_t;
+
+			/** \brief HID Report Extraction Plan Structure.
+			 *
+			 *  Type define for a report extraction plan, compiled once from a parsed report with \ref USB_CompileHIDReportPlan()
+			 *  and then used by \ref USB_ExtractHIDReportFields() on every received report. The plan keeps no reference to the
+			 *  \ref HID_ReportInfo_t it was compiled from, which may therefore be reused once the plan is built.
+			 */
+			typedef struct
+			{
+				uint8_t               TotalFields; /**< Total number of fields stored in the \c Fields array. */
+				bool                  UsingReportIDs; /**< Indicates if reports start with a report ID byte. */
+				HID_ReportPlanField_t Fields[HID_MAX_PLAN_FIELDS]; /**< Fields in the order of the parsed report items. */
+			} HID_ReportPlan_t;
+
 		/* Function Prototypes: */
 			/** Function to process a given HID report returned from an attached device, and store it into a given
 			 *  \ref HID_ReportInfo_t structure.
@@ -329,6 +372,37 @@
 			                              const uint8_t ReportID,
 			                              const uint8_t ReportType) ATTR_CONST ATTR_NON_NULL_PTR_ARG(1);
 
+			/** Compiles the report items of the given type from a parsed HID report into an extraction plan. Constant
+			 *  (padding) items and items wider than 32 bits are left out, the remaining ones keep their order within the
+			 *  \ref HID_ReportInfo_t \c ReportItems array.
+			 *
+			 *  \param[in]  ParserData  Pointer to a \ref HID_ReportInfo_t instance containing the parser output.
+			 *  \param[in]  ItemType    Type of the report items to compile, a value from the \ref HID_ReportItemTypes_t enum.
+			 *  \param[out] Plan        Pointer to the \ref HID_ReportPlan_t to compile into.
+			 *
+			 *  \return \ref HID_PARSE_Successful, or \ref HID_PARSE_InsufficientReportItems if more than
+			 *          \ref HID_MAX_PLAN_FIELDS fields were found.
+			 */
+			uint8_t USB_CompileHIDReportPlan(const HID_ReportInfo_t* const ParserData,
+			                                 const uint8_t ItemType,
+			                                 HID_ReportPlan_t* const Plan) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(3);
+
+			/** Extracts the values of all the plan's fields present in the given report. Signed fields are sign extended.
+			 *
+			 *  \param[in]  Plan        Pointer to a compiled \ref HID_ReportPlan_t.
+			 *  \param[in]  ReportData  Buffer containing an IN or FEATURE report from an attached device.
+			 *  \param[in]  ReportSize  Size in bytes of the report, fields reaching past it are not extracted.
+			 *  \param[out] Values      Array of \c TotalFields values, the value of \c Fields[n] is stored in \c Values[n].
+			 *                          Entries of fields that belong to other reports are left untouched.
+			 *
+			 *  \return Number of fields extracted from the report.
+			 */
+			uint8_t USB_ExtractHIDReportFields(const HID_ReportPlan_t* const Plan,
+			                                   const uint8_t* ReportData,
+			                                   const uint16_t ReportSize,
+			                                   int32_t* const Values) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2)
+			                                   ATTR_NON_NULL_PTR_ARG(4);
+
 			/** Callback routine for the HID Report Parser. This callback <b>must</b> be implemented by the user code when
 			 *  the parser is used, to determine what report IN, OUT and FEATURE item's information is stored into the user
 			 *  \ref HID_ReportInfo_t structure. This can be used to filter only those items the application will be using, so that
@@ -347,6 +421,9 @@
 
 	/* Private Interface - For use in library only: */
 	#if !defined(__DOXYGEN__)
+		/* Macros: */
+			#define HID_FIELD_MASK(BitSize)  (((BitSize) >= 32) ? 0xFFFFFFFFUL : ((1UL << (BitSize)) - 1))
+
 		/* Type Defines: */
 			typedef struct
 			{
@@ -0,0 +1,159 @@
+/*
+* Copyright(C) NXP Semiconductors, 2011
+* All rights reserved.
+*
+* Copyright (C) Dean Camera, 2011.
+*
+* LUFA Library is licensed from Dean Camera by NXP for NXP customers 
+* for use with NXP's LPC microcontrollers.
+*
+* Software that is described herein is for illustrative purposes only
+* which provides customers with programming information regarding the
+* LPC products.  This software is supplied "AS IS" without any warranties of
+* any kind, and NXP Semiconductors and its licensor disclaim any and 
+* all warranties, express or implied, including all implied warranties of 
+* merchantability, fitness for a particular purpose and non-infringement of 
+* intellectual property rights.  NXP Semiconductors assumes no responsibility
+* or liability for the use of the software, conveys no license or rights under any
+* patent, copyright, mask work right, or any other intellectual property rights in 
+* or to any products. NXP Semiconductors reserves the right to make changes
+* in the software without notification. NXP Semiconductors also makes no 
+* representation or warranty that such application will be suitable for the
+* specified use without further testing or modification.
+* 
+* Permission to use, copy, modify, and distribute this software and its 
+* documentation is hereby granted, under NXP Semiconductors' and its 
+* licensor's relevant copyrights in the software, without fee, provided that it 
+* is used in conjunction with NXP Semiconductors microcontrollers.  This 
+* copyright, permission, and disclaimer notice must appear in all copies of 
+* this code.
+*/
+
+
+
+/** \file
+ *  \brief Common definitions and declarations for the library USB Hub Class driver.
+ *
+ *  Common definitions and declarations for the library USB Hub Class driver.
+ *
+ *  \note This file should not be included directly. It is automatically included as needed by the USB module driver
+ *        dispatch header located in LPCUSBlib/Drivers/USB.h.
+ */
+
+/** \ingroup Group_USBClassHub
+ *  \defgroup Group_USBClassHubCommon  Common Class Definitions
+ *
+ *  \section Sec_ModDescription Module Description
+ *  Constants, Types and Enum definitions for the USB Hub Class (chapter 11 of the USB 2.0 specification).
+ *
+ *  @{
+ */
+
+#ifndef _HUB_CLASS_COMMON_H_
+#define _HUB_CLASS_COMMON_H_
+
+	/* Includes: */
+		#include "../../Core/StdDescriptors.h"
+
+	/* Enable C linkage for C++ Compilers: */
+		#if defined(__cplusplus)
+			extern "C" {
+		#endif
+
+	/* Preprocessor Checks: */
+		#if !defined(__INCLUDE_FROM_HUB_DRIVER)
+			#error Do not include this file directly. Include LPCUSBlib/Drivers/USB.h instead.
+		#endif
+
+	/* Macros: */
+		/** Descriptor type value of the hub class descriptor, requested with \ref REQ_GetDescriptor on the hub's device. */
+		#define HUB_DTYPE_Hub                  0x29
+
+		/** \name Port Status Masks (wPortStatus of a GET_STATUS port request) */
+		//@{
+		#define HUB_PORT_STATUS_CONNECTION     (1 << 0)  /**< A device is present on the port. */
+		#define HUB_PORT_STATUS_ENABLE         (1 << 1)  /**< The port is enabled. */
+		#define HUB_PORT_STATUS_SUSPEND        (1 << 2)  /**< The port is suspended. */
+		#define HUB_PORT_STATUS_OVER_CURRENT   (1 << 3)  /**< The port is in an over-current condition. */
+		#define HUB_PORT_STATUS_RESET          (1 << 4)  /**< Reset signalling is being driven on the port. */
+		#define HUB_PORT_STATUS_POWER          (1 << 8)  /**< The port is powered. */
+		#define HUB_PORT_STATUS_LOW_SPEED      (1 << 9)  /**< The attached device is low speed. */
+		#define HUB_PORT_STATUS_HIGH_SPEED     (1 << 10) /**< The attached device is high speed. */
+		//@}
+
+		/** \name Port Change Masks (wPortChange of a GET_STATUS port request) */
+		//@{
+		#define HUB_PORT_CHANGE_CONNECTION     (1 << 0)  /**< The connection status has changed. */
+		#define HUB_PORT_CHANGE_ENABLE         (1 << 1)  /**< The port was disabled by an error. */
+		#define HUB_PORT_CHANGE_SUSPEND        (1 << 2)  /**< The resume sequence has completed. */
+		#define HUB_PORT_CHANGE_OVER_CURRENT   (1 << 3)  /**< The over-current indicator has changed. */
+		#define HUB_PORT_CHANGE_RESET          (1 << 4)  /**< Reset signalling on the port has completed. */
+		//@}
+
+	/* Enums: */
+		/** Enum for possible Class, Subclass and Protocol values of device and interface descriptors relating to the Hub
+		 *  device class.
+		 */
+		enum HUB_Descriptor_ClassSubclassProtocol_t
+		{
+			HUB_CSCP_HubClass               = 0x09, /**< Descriptor Class value indicating that the device or interface
+			                                         *   belongs to the Hub class.
+			                                         */
+			HUB_CSCP_HubSubclass            = 0x00, /**< Descriptor Subclass value indicating that the device or interface
+			                                         *   belongs to the Hub subclass.
+			                                         */
+		};
+
+		/** Enum for the Hub class feature selectors, used with \ref REQ_SetFeature and \ref REQ_ClearFeature. */
+		enum HUB_PortFeatures_t
+		{
+			HUB_FEATURE_CHubLocalPower      = 0,  /**< Hub feature selector to acknowledge a local power source change. */
+			HUB_FEATURE_CHubOverCurrent     = 1,  /**< Hub feature selector to acknowledge an over-current change. */
+			HUB_FEATURE_PortConnection      = 0,  /**< Port feature selector for the connection status. */
+			HUB_FEATURE_PortEnable          = 1,  /**< Port feature selector to disable a port (clear only). */
+			HUB_FEATURE_PortSuspend         = 2,  /**< Port feature selector to suspend or resume a port. */
+			HUB_FEATURE_PortOverCurrent     = 3,  /**< Port feature selector for the over-current status. */
+			HUB_FEATURE_PortReset           = 4,  /**< Port feature selector to start reset signalling on a port. */
+			HUB_FEATURE_PortPower           = 8,  /**< Port feature selector to switch port power. */
+			HUB_FEATURE_PortLowSpeed        = 9,  /**< Port feature selector for the low speed status. */
+			HUB_FEATURE_CPortConnection     = 16, /**< Port feature selector to acknowledge a connection change. */
+			HUB_FEATURE_CPortEnable         = 17, /**< Port feature selector to acknowledge an enable change. */
+			HUB_FEATURE_CPortSuspend        = 18, /**< Port feature selector to acknowledge a suspend change. */
+			HUB_FEATURE_CPortOverCurrent    = 19, /**< Port feature selector to acknowledge an over-current change. */
+			HUB_FEATURE_CPortReset          = 20, /**< Port feature selector to acknowledge a completed reset. */
+		};
+
+	/* Type Defines: */
+		/** \brief Hub class descriptor.
+		 *
+		 *  Type define for the hub class descriptor, up to the variable length DeviceRemovable bitmap.
+		 */
+		typedef struct
+		{
+			uint8_t  Length; /**< Size of the descriptor, in bytes. */
+			uint8_t  Type; /**< Descriptor type, must be \ref HUB_DTYPE_Hub. */
+			uint8_t  NumberOfPorts; /**< Number of downstream facing ports of the hub. */
+			uint16_t HubCharacteristics; /**< Power switching, compound device and over-current protection modes. */
+			uint8_t  PowerOnToPowerGood; /**< Time from switching a port's power on until it is good, in 2 ms units. */
+			uint8_t  HubControlCurrent; /**< Maximum current used by the hub controller, in mA. */
+		} ATTR_PACKED USB_HUB_Descriptor_Hub_t;
+
+		/** \brief Hub port status.
+		 *
+		 *  Type define for the data returned by a GET_STATUS request to a hub port.
+		 */
+		typedef struct
+		{
+			uint16_t PortStatus; /**< Current port state, a mask of \c HUB_PORT_STATUS_* values. */
+			uint16_t PortChange; /**< Changes since last acknowledged, a mask of \c HUB_PORT_CHANGE_* values. */
+		} ATTR_PACKED USB_HUB_PortStatus_t;
+
+	/* Disable C linkage for C++ Compilers: */
+		#if defined(__cplusplus)
+			}
+		#endif
+
+#endif
+
+/** @} */
+
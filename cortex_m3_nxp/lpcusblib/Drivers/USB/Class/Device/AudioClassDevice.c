@@ -39,6 +39,10 @@
 #define  __INCLUDE_FROM_AUDIO_DEVICE_C
 #include "AudioClassDevice.h"
 
+#if defined(ENDPOINT_ISO_STREAMS)
+static Audio_Device_Stream_t* Audio_Device_Streams[AUDIO_DEVICE_MAX_STREAMS];
+#endif
+
 void Audio_Device_ProcessControlRequest(USB_ClassInfo_Audio_Device_t* const AudioInterfaceInfo)
 {
 	if (!(Endpoint_IsSETUPReceived()))
@@ -174,9 +178,344 @@ bool Audio_Device_ConfigureEndpoints(USB_ClassInfo_Audio_Device_t* const AudioIn
 		}
 	}
 
+	/* The feedback endpoint may have the number of the data OUT endpoint, in the other direction */
+	if (AudioInterfaceInfo->Config.FeedbackEndpointNumber)
+	{
+		if (!(Endpoint_ConfigureEndpoint(AudioInterfaceInfo->Config.FeedbackEndpointNumber, EP_TYPE_ISOCHRONOUS,
+		                                 ENDPOINT_DIR_IN, AUDIO_DEVICE_FEEDBACK_SIZE, ENDPOINT_BANK_DOUBLE)))
+		{
+			return false;
+		}
+	}
+
+	#if defined(ENDPOINT_ISO_STREAMS)
+	/* Configuring the endpoints ended the streams running on them */
+	uint8_t Slot;
+	for (Slot = 0; Slot < AUDIO_DEVICE_MAX_STREAMS; Slot++)
+	{
+		if (Audio_Device_Streams[Slot] && (Audio_Device_Streams[Slot]->AudioInterfaceInfo == AudioInterfaceInfo))
+		  Audio_Device_StopStream(Audio_Device_Streams[Slot]);
+	}
+	#endif
+
+	return true;
+}
+
+#if defined(ENDPOINT_ISO_STREAMS)
+uint8_t Audio_Device_StartStream(USB_ClassInfo_Audio_Device_t* const AudioInterfaceInfo,
+                                 Audio_Device_Stream_t* const Stream,
+                                 uint8_t* const FIFO,
+                                 const uint16_t FIFOSize,
+                                 const uint32_t SampleRate,
+                                 const uint8_t SampleFrameSize)
+{
+	uint16_t FeedbackLength[AUDIO_DEVICE_STREAM_FRAMES];
+	uint8_t  PrevSelectedEndpoint = Endpoint_GetCurrentEndpoint();
+	uint8_t  Slot;
+
+	if ((USB_DeviceState != DEVICE_STATE_Configured) || !(AudioInterfaceInfo->State.InterfaceEnabled))
+	  return AUDIO_DEVICE_STREAM_NotEnabled;
+
+	if (!(AudioInterfaceInfo->Config.DataOUTEndpointNumber) || !(SampleFrameSize) || (SampleRate < 1000) ||
+	    (AudioInterfaceInfo->Config.DataOUTEndpointSize > AUDIO_DEVICE_STREAM_PACKET_SIZE) ||
+	    ((FIFOSize / SampleFrameSize) < (4 * AUDIO_DEVICE_STREAM_FRAMES * ((SampleRate / 1000) + 1))))
+	{
+		return AUDIO_DEVICE_STREAM_InvalidParameter;
+	}
+
+	Audio_Device_StopStream(Stream);
+
+	for (Slot = 0; (Slot < AUDIO_DEVICE_MAX_STREAMS) && Audio_Device_Streams[Slot]; Slot++);
+
+	if (Slot == AUDIO_DEVICE_MAX_STREAMS)
+	  return AUDIO_DEVICE_STREAM_NoStreams;
+
+	/* The reader may be taking silence from the stream meanwhile: it only looks at the FIFO once playing,
+	 * which cannot start before the stream is set up and marked as streaming */
+	Stream->IsStreaming            = false;
+	Stream->IsPlaying              = false;
+	Stream->HasPlayed              = false;
+	Stream->IsReceiving            = false;
+	Stream->AudioInterfaceInfo     = AudioInterfaceInfo;
+	Stream->FIFO                   = FIFO;
+	Stream->FIFOFrames             = FIFOSize / SampleFrameSize;
+	Stream->WriteIndex             = 0;
+	Stream->ReadIndex              = 0;
+	Stream->TargetLevel            = Stream->FIFOFrames / 2;
+	Stream->SampleFrameSize        = SampleFrameSize;
+	Stream->NominalSamplesPerFrame = Audio_Device_SamplesPerFrame(SampleRate);
+	Stream->SamplesPerFrame        = Stream->NominalSamplesPerFrame;
+	Stream->FilteredLevel          = (int32_t)Stream->TargetLevel << 8;
+	Stream->MinLevel               = 0;
+	Stream->MaxLevel               = 0;
+	Stream->DroppedSamples         = 0;
+	Stream->InsertedSamples        = 0;
+	Stream->LostPackets            = 0;
+	Stream->IsStreaming            = true;
+
+	Audio_Device_Streams[Slot] = Stream;
+
+	if (!(Audio_Device_SelectStreamEndpoint(AudioInterfaceInfo->Config.DataOUTEndpointNumber, ENDPOINT_DIR_OUT,
+	                                        AudioInterfaceInfo->Config.DataOUTEndpointSize)) ||
+	    !(Endpoint_StartISOStream(Audio_Device_DataOUTComplete, Stream->TransferBuffer[0], sizeof(Stream->TransferBuffer[0]),
+	                              NULL, AUDIO_DEVICE_STREAM_FRAMES, AUDIO_DEVICE_STREAM_TRANSFERS)))
+	{
+		Audio_Device_StopStream(Stream);
+		Endpoint_SelectEndpoint(PrevSelectedEndpoint);
+		return AUDIO_DEVICE_STREAM_EndpointError;
+	}
+
+	if (AudioInterfaceInfo->Config.FeedbackEndpointNumber)
+	{
+		Audio_Device_WriteFeedback(Stream, Stream->FeedbackBuffer[0], FeedbackLength, AUDIO_DEVICE_STREAM_FRAMES);
+		Audio_Device_WriteFeedback(Stream, Stream->FeedbackBuffer[1], FeedbackLength, AUDIO_DEVICE_STREAM_FRAMES);
+
+		if (!(Audio_Device_SelectStreamEndpoint(AudioInterfaceInfo->Config.FeedbackEndpointNumber, ENDPOINT_DIR_IN,
+		                                        AUDIO_DEVICE_FEEDBACK_SIZE)) ||
+		    !(Endpoint_StartISOStream(Audio_Device_FeedbackComplete, Stream->FeedbackBuffer[0], sizeof(Stream->FeedbackBuffer[0]),
+		                              FeedbackLength, AUDIO_DEVICE_STREAM_FRAMES, 2)))
+		{
+			Audio_Device_StopStream(Stream);
+			Endpoint_SelectEndpoint(PrevSelectedEndpoint);
+			return AUDIO_DEVICE_STREAM_EndpointError;
+		}
+	}
+
+	Endpoint_SelectEndpoint(PrevSelectedEndpoint);
+	return AUDIO_DEVICE_STREAM_NoError;
+}
+
+void Audio_Device_StopStream(Audio_Device_Stream_t* const Stream)
+{
+	USB_ClassInfo_Audio_Device_t* AudioInterfaceInfo = Stream->AudioInterfaceInfo;
+	uint8_t PrevSelectedEndpoint = Endpoint_GetCurrentEndpoint();
+	uint8_t Slot;
+
+	for (Slot = 0; (Slot < AUDIO_DEVICE_MAX_STREAMS) && (Audio_Device_Streams[Slot] != Stream); Slot++);
+
+	if (Slot == AUDIO_DEVICE_MAX_STREAMS)
+	  return;
+
+	Stream->IsStreaming = false;
+	Stream->IsPlaying   = false;
+
+	/* Configuring the endpoints again ends their streams and leaves them as the host set them up */
+	if (USB_DeviceState == DEVICE_STATE_Configured)
+	{
+		Audio_Device_SelectStreamEndpoint(AudioInterfaceInfo->Config.DataOUTEndpointNumber, ENDPOINT_DIR_OUT,
+		                                  AudioInterfaceInfo->Config.DataOUTEndpointSize);
+
+		if (AudioInterfaceInfo->Config.FeedbackEndpointNumber)
+		{
+			Audio_Device_SelectStreamEndpoint(AudioInterfaceInfo->Config.FeedbackEndpointNumber, ENDPOINT_DIR_IN,
+			                                  AUDIO_DEVICE_FEEDBACK_SIZE);
+		}
+	}
+
+	Audio_Device_Streams[Slot] = NULL;
+	Endpoint_SelectEndpoint(PrevSelectedEndpoint);
+}
+
+uint16_t Audio_Device_ReadStreamSamples(Audio_Device_Stream_t* const Stream,
+                                        void* const Buffer,
+                                        const uint16_t Count)
+{
+	uint8_t* Data   = Buffer;
+	uint16_t Frames = 0;
+	uint16_t Level  = Audio_Device_GetStreamLevel(Stream);
+
+	/* Playing starts, and starts again after running dry, once the FIFO is back at the target level */
+	if (!(Stream->IsPlaying) && Stream->IsStreaming && (Level >= Stream->TargetLevel))
+	{
+		Stream->MinLevel  = Level;
+		Stream->MaxLevel  = Level;
+		Stream->IsPlaying = true;
+		Stream->HasPlayed = true;
+	}
+
+	if (Stream->IsPlaying)
+	{
+		uint16_t Index     = Stream->ReadIndex;
+		uint16_t Remaining = Frames = MIN(Count, Level);
+
+		while (Remaining)
+		{
+			uint16_t Chunk = MIN(Remaining, Stream->FIFOFrames - Index);
+
+			memcpy(Data, &Stream->FIFO[Index * Stream->SampleFrameSize], Chunk * Stream->SampleFrameSize);
+			Data      += Chunk * Stream->SampleFrameSize;
+			Remaining -= Chunk;
+			Index      = (Index + Chunk) % Stream->FIFOFrames;
+		}
+
+		Stream->ReadIndex = Index;
+
+		if (Frames < Count)
+		  Stream->IsPlaying = false;
+	}
+
+	if (Frames < Count)
+	{
+		memset(Data, 0x00, (Count - Frames) * Stream->SampleFrameSize);
+
+		if (Stream->HasPlayed)
+		  Stream->InsertedSamples += (Count - Frames);
+	}
+
+	return Frames;
+}
+
+uint32_t Audio_Device_GetStreamSampleRate(const Audio_Device_Stream_t* const Stream)
+{
+	uint32_t SamplesPerFrame = Stream->SamplesPerFrame;
+
+	return ((SamplesPerFrame >> 16) * 1000) + ((((SamplesPerFrame & 0xFFFF) * 1000) + 0x8000) >> 16);
+}
+
+static bool Audio_Device_SelectStreamEndpoint(const uint8_t EndpointNumber, const uint8_t Direction, const uint16_t Size)
+{
+	/* Endpoints are selected by number only, and the data and feedback endpoints may share one: configuring
+	 * the endpoint again, as the host enabling the interface allows, makes the wanted direction the selected one */
+	if (!(Endpoint_ConfigureEndpoint(EndpointNumber, EP_TYPE_ISOCHRONOUS, Direction, Size, ENDPOINT_BANK_DOUBLE)))
+	  return false;
+
+	Endpoint_SelectEndpoint(EndpointNumber);
+	return true;
+}
+
+static uint32_t Audio_Device_SamplesPerFrame(const uint32_t SampleRate)
+{
+	return ((SampleRate / 1000) << 16) + (((SampleRate % 1000) << 16) / 1000);
+}
+
+static void Audio_Device_StreamToFIFO(Audio_Device_Stream_t* const Stream, const uint8_t* Data, uint16_t Length)
+{
+	uint16_t Frames = Length / Stream->SampleFrameSize;
+	uint16_t Free   = Stream->FIFOFrames - 1 - Audio_Device_GetStreamLevel(Stream);
+	uint16_t Index  = Stream->WriteIndex;
+
+	if (Frames > Free)
+	{
+		Stream->DroppedSamples += (Frames - Free);
+		Frames = Free;
+	}
+
+	while (Frames)
+	{
+		uint16_t Chunk = MIN(Frames, Stream->FIFOFrames - Index);
+
+		memcpy(&Stream->FIFO[Index * Stream->SampleFrameSize], Data, Chunk * Stream->SampleFrameSize);
+		Data   += Chunk * Stream->SampleFrameSize;
+		Frames -= Chunk;
+		Index   = (Index + Chunk) % Stream->FIFOFrames;
+	}
+
+	Stream->WriteIndex = Index;
+}
+
+static void Audio_Device_UpdateFeedback(Audio_Device_Stream_t* const Stream)
+{
+	uint16_t Level = Audio_Device_GetStreamLevel(Stream);
+	int32_t  Limit = Stream->NominalSamplesPerFrame >> AUDIO_DEVICE_FEEDBACK_RANGE_SHIFT;
+	int32_t  Adjust;
+
+	/* While the FIFO fills up to the target level the host sends at the rate it was set to */
+	if (!(Stream->IsPlaying))
+	{
+		Stream->FilteredLevel   = (int32_t)Stream->TargetLevel << 8;
+		Stream->SamplesPerFrame = Stream->NominalSamplesPerFrame;
+		return;
+	}
+
+	Stream->MinLevel = MIN(Stream->MinLevel, Level);
+	Stream->MaxLevel = MAX(Stream->MaxLevel, Level);
+
+	/* The rate asked for is the nominal one, corrected in proportion to how far the averaged level is from the
+	 * target. The host only follows after a few frames, so the gain is kept low for the level not to oscillate. */
+	Stream->FilteredLevel += (((int32_t)Level << 8) - Stream->FilteredLevel) >> AUDIO_DEVICE_LEVEL_FILTER_SHIFT;
+	Adjust = ((((int32_t)Stream->TargetLevel << 8) - Stream->FilteredLevel) * 256) >> AUDIO_DEVICE_FEEDBACK_GAIN_SHIFT;
+	Adjust = MIN(MAX(Adjust, -Limit), Limit);
+
+	Stream->SamplesPerFrame = Stream->NominalSamplesPerFrame + Adjust;
+}
+
+static bool Audio_Device_DataOUTComplete(const uint8_t EndpointNumber, uint8_t* Buffer,
+                                         uint16_t* PacketLength, const uint8_t PacketCount)
+{
+	Audio_Device_Stream_t* Stream = NULL;
+	uint8_t Slot;
+	uint8_t i;
+
+	for (Slot = 0; (Slot < AUDIO_DEVICE_MAX_STREAMS) && !(Stream); Slot++)
+	{
+		if (Audio_Device_Streams[Slot] && Audio_Device_Streams[Slot]->IsStreaming &&
+		    (Audio_Device_Streams[Slot]->AudioInterfaceInfo->Config.DataOUTEndpointNumber == EndpointNumber))
+		{
+			Stream = Audio_Device_Streams[Slot];
+		}
+	}
+
+	if (!(Stream))
+	  return false;
+
+	for (i = 0; i < PacketCount; i++)
+	{
+		if (PacketLength[i])
+		{
+			Audio_Device_StreamToFIFO(Stream, Buffer, PacketLength[i]);
+			Stream->IsReceiving = true;
+		}
+		else if (Stream->IsReceiving)
+		{
+			Stream->LostPackets++;
+		}
+
+		Buffer += PacketLength[i];
+	}
+
+	Audio_Device_UpdateFeedback(Stream);
 	return true;
 }
 
+static void Audio_Device_WriteFeedback(const Audio_Device_Stream_t* const Stream, uint8_t* Buffer,
+                                       uint16_t* PacketLength, const uint8_t PacketCount)
+{
+	/* Full speed feedback is the samples per frame in 10.14 fixed point, least significant byte first */
+	uint32_t Feedback = Stream->SamplesPerFrame >> 2;
+	uint8_t  i;
+
+	for (i = 0; i < PacketCount; i++)
+	{
+		Buffer[0] = (uint8_t)Feedback;
+		Buffer[1] = (uint8_t)(Feedback >> 8);
+		Buffer[2] = (uint8_t)(Feedback >> 16);
+		Buffer += AUDIO_DEVICE_FEEDBACK_SIZE;
+
+		PacketLength[i] = AUDIO_DEVICE_FEEDBACK_SIZE;
+	}
+}
+
+static bool Audio_Device_FeedbackComplete(const uint8_t EndpointNumber, uint8_t* Buffer,
+                                          uint16_t* PacketLength, const uint8_t PacketCount)
+{
+	uint8_t Slot;
+
+	for (Slot = 0; Slot < AUDIO_DEVICE_MAX_STREAMS; Slot++)
+	{
+		Audio_Device_Stream_t* Stream = Audio_Device_Streams[Slot];
+
+		if (Stream && Stream->IsStreaming &&
+		    (Stream->AudioInterfaceInfo->Config.FeedbackEndpointNumber == EndpointNumber))
+		{
+			Audio_Device_WriteFeedback(Stream, Buffer, PacketLength, PacketCount);
+			return true;
+		}
+	}
+
+	return false;
+}
+#endif
+
 void Audio_Device_Event_Stub(USB_ClassInfo_Audio_Device_t* const AudioInterfaceInfo)
 {
 
@@ -71,6 +71,35 @@
 		#endif
 
 	/* Public Interface - May be used in end-application: */
+		/* Macros: */
+			/** Size of a full speed feedback endpoint, whose packets give the samples per frame in 10.14 fixed point. */
+			#define AUDIO_DEVICE_FEEDBACK_SIZE               3
+
+			#if defined(ENDPOINT_ISO_STREAMS) || defined(__DOXYGEN__)
+				#if !defined(AUDIO_DEVICE_STREAM_TRANSFERS) || defined(__DOXYGEN__)
+					/** Number of isochronous transfers a playback stream keeps queued on its endpoint. Together with
+					 *  \ref AUDIO_DEVICE_STREAM_FRAMES this sets how late the USB interrupt may take a transfer
+					 *  before a packet is lost, (AUDIO_DEVICE_STREAM_TRANSFERS - 1) * AUDIO_DEVICE_STREAM_FRAMES ms.
+					 */
+					#define AUDIO_DEVICE_STREAM_TRANSFERS    4
+				#endif
+
+				#if !defined(AUDIO_DEVICE_STREAM_FRAMES) || defined(__DOXYGEN__)
+					/** Number of frames (one packet each) carried by every isochronous transfer of a playback stream. */
+					#define AUDIO_DEVICE_STREAM_FRAMES       2
+				#endif
+
+				#if !defined(AUDIO_DEVICE_STREAM_PACKET_SIZE) || defined(__DOXYGEN__)
+					/** Largest data packet of a playback stream, which the buffers of its transfers are sized for. The
+					 *  default holds a 48 kHz 16-bit stereo frame with the extra sample a faster host clock sends now and then.
+					 */
+					#define AUDIO_DEVICE_STREAM_PACKET_SIZE  196
+				#endif
+
+				/** Maximum number of playback streams running at the same time, over all interfaces. */
+				#define AUDIO_DEVICE_MAX_STREAMS             1
+			#endif
+
 		/* Type Defines: */
 			/** \brief Audio Class Device Mode Configuration and State Structure.
 			 *
@@ -99,6 +128,12 @@
 					uint16_t DataOUTEndpointSize; /**< Size in bytes of the outgoing Audio Streaming data endpoint, if available
 												   *   (zero if unused).
 												   */
+
+					uint8_t  FeedbackEndpointNumber; /**< Endpoint number of the isochronous IN endpoint telling the host the
+													  *   rate the outgoing stream is played at, if available (zero if unused).
+													  *   It is \ref AUDIO_DEVICE_FEEDBACK_SIZE bytes and may share its number
+													  *   with the outgoing data endpoint.
+													  */
 				} Config; /**< Config data for the USB class interface within the device. All elements in this section
 				           *   <b>must</b> be set or the interface will fail to enumerate and operate correctly.
 				           */
@@ -112,6 +147,59 @@
 				          */
 			} USB_ClassInfo_Audio_Device_t;
 
+			#if defined(ENDPOINT_ISO_STREAMS) || defined(__DOXYGEN__)
+			/** \brief Audio Class Device Mode Stream Structure.
+			 *
+			 *  State of a playback stream started with \ref Audio_Device_StartStream(). The USB interrupt writes each
+			 *  received packet into a sample FIFO supplied by the application, which takes the samples out at its own
+			 *  (DAC) rate with \ref Audio_Device_ReadStreamSamples(). The feedback endpoint steers the host towards the
+			 *  rate that keeps the FIFO half full, so the two clocks may drift apart without samples being dropped or
+			 *  inserted. The structure holds the transfer buffers of the endpoints, so it must be placed in the USB RAM.
+			 *  The statistics are written by the USB interrupt and the reading side, and may be read at any time.
+			 */
+			typedef struct
+			{
+				uint8_t  TransferBuffer[AUDIO_DEVICE_STREAM_TRANSFERS][AUDIO_DEVICE_STREAM_FRAMES * AUDIO_DEVICE_STREAM_PACKET_SIZE]
+				         ATTR_ALIGNED(4); /**< Queued data transfers. */
+				uint8_t  FeedbackBuffer[2][(AUDIO_DEVICE_STREAM_FRAMES * AUDIO_DEVICE_FEEDBACK_SIZE + 3) & ~3]
+				         ATTR_ALIGNED(4); /**< Queued feedback transfers. */
+
+				USB_ClassInfo_Audio_Device_t* AudioInterfaceInfo; /**< Interface the stream plays on. */
+				uint8_t* FIFO; /**< Sample FIFO, one sample frame of it is always left free. */
+				uint16_t FIFOFrames; /**< Size of the FIFO in sample frames. */
+				volatile uint16_t WriteIndex; /**< Next sample frame the USB interrupt writes. */
+				volatile uint16_t ReadIndex; /**< Next sample frame the application reads. */
+				uint16_t TargetLevel; /**< Fill level in sample frames the feedback keeps the FIFO at, half of it. */
+				uint8_t  SampleFrameSize; /**< Bytes in one sample of every channel. */
+
+				volatile bool IsStreaming; /**< Stream is started, cleared to let the USB interrupt drop its transfers. */
+				volatile bool IsPlaying; /**< The FIFO filled up to the target level and the application takes samples from it. */
+				bool     HasPlayed; /**< Stream played before, so silence the application is given counts as inserted samples. */
+				bool     IsReceiving; /**< A packet arrived, so frames without one count as lost packets. */
+
+				uint32_t NominalSamplesPerFrame; /**< Sample rate set by the host, in samples per 1 ms frame as 16.16 fixed point. */
+				volatile uint32_t SamplesPerFrame; /**< Rate asked from the host through the feedback endpoint, 16.16 fixed point. */
+				int32_t  FilteredLevel; /**< FIFO level the feedback is computed from, averaged over a few transfers, 24.8 fixed point. */
+				volatile uint16_t MinLevel; /**< Lowest FIFO level seen by the USB interrupt since playing started, in sample frames. */
+				volatile uint16_t MaxLevel; /**< Highest FIFO level seen by the USB interrupt since playing started, in sample frames. */
+
+				volatile uint32_t DroppedSamples; /**< Sample frames received while the FIFO was full, thrown away. */
+				volatile uint32_t InsertedSamples; /**< Sample frames of silence handed to the application because the FIFO ran dry. */
+				volatile uint32_t LostPackets; /**< Frames in which no data packet arrived while the host was streaming. */
+			} Audio_Device_Stream_t;
+
+		/* Enums: */
+			/** Enum for the possible error codes returned by the \ref Audio_Device_StartStream() function. */
+			enum AUDIO_Device_StreamErrorCodes_t
+			{
+				AUDIO_DEVICE_STREAM_NoError                = 0, /**< Stream is running. */
+				AUDIO_DEVICE_STREAM_NotEnabled             = 1, /**< The device is not configured or the host has not enabled the interface. */
+				AUDIO_DEVICE_STREAM_InvalidParameter       = 2, /**< The interface has no data OUT endpoint, its packets do not fit the transfer buffers, or the FIFO is too small. */
+				AUDIO_DEVICE_STREAM_NoStreams              = 3, /**< All streams are in use. */
+				AUDIO_DEVICE_STREAM_EndpointError          = 4, /**< The device controller driver refused the isochronous transfers. */
+			};
+			#endif
+
 		/* Function Prototypes: */
 			/** Configures the endpoints of a given Audio interface, ready for use. This should be linked to the library
 			 *  \ref EVENT_USB_Device_ConfigurationChanged() event so that the endpoints are configured when the configuration containing the
@@ -150,6 +238,9 @@
 			 *  \param[in,out] Data                Pointer to a location where the parameter data is stored for SET operations, or where
 			 *                                     the retrieved data is to be stored for GET operations.
 			 *
+			 *  \note With \c INTERRUPT_CONTROL_ENDPOINT defined this callback runs in interrupt context, see
+			 *        \ref EVENT_USB_Device_ControlRequest().
+			 *
 			 *  \return Boolean true if the property get/set was successful, false otherwise
 			 */
 			bool CALLBACK_Audio_Device_GetSetEndpointProperty(USB_ClassInfo_Audio_Device_t* const AudioInterfaceInfo,
@@ -163,11 +254,89 @@
 			 *  disable control request from the host, to start and stop the audio stream. The current state of the stream can be determined by the
 			 *  State.InterfaceEnabled value inside the Audio interface structure passed as a parameter.
 			 *
+			 *  \note With \c INTERRUPT_CONTROL_ENDPOINT defined this event fires in interrupt context, see
+			 *        \ref EVENT_USB_Device_ControlRequest().
+			 *
 			 *  \param[in,out] AudioInterfaceInfo  Pointer to a structure containing an Audio Class configuration and state.
 			 */
 			void EVENT_Audio_Device_StreamStartStop(USB_ClassInfo_Audio_Device_t* const AudioInterfaceInfo);
 
+			#if defined(ENDPOINT_ISO_STREAMS) || defined(__DOXYGEN__)
+			/** Starts a playback stream on the data OUT endpoint of the given Audio interface, and the rate feedback on its
+			 *  feedback endpoint if it has one. The USB interrupt then keeps \ref AUDIO_DEVICE_STREAM_TRANSFERS transfers queued
+			 *  and writes every received packet into the FIFO, a few frames at a time, so the application only reads samples.
+			 *  This is typically called from \ref EVENT_Audio_Device_StreamStartStop() when the host enables the interface.
+			 *
+			 *  \note The FIFO should hold several transfers of samples: the deeper it is, the longer a late reader or a host
+			 *        clock far from the device one is absorbed before the feedback has caught up.
+			 *
+			 *  \param[in,out] AudioInterfaceInfo  Pointer to a structure containing an Audio Class configuration and state.
+			 *  \param[out]    Stream              Stream state in the USB RAM, kept by the application until \ref Audio_Device_StopStream().
+			 *                                     Before it is first started it should be zeroed, with only \c SampleFrameSize set
+			 *                                     for \ref Audio_Device_ReadStreamSamples() to return silence.
+			 *  \param[in]     FIFO                Sample FIFO.
+			 *  \param[in]     FIFOSize            Size in bytes of the FIFO, at least four transfers of samples.
+			 *  \param[in]     SampleRate          Sample rate in Hz set by the host.
+			 *  \param[in]     SampleFrameSize     Bytes in one sample of every channel, e.g. 4 for 16-bit stereo.
+			 *
+			 *  \return A value from the \ref AUDIO_Device_StreamErrorCodes_t enum.
+			 */
+			uint8_t Audio_Device_StartStream(USB_ClassInfo_Audio_Device_t* const AudioInterfaceInfo,
+			                                 Audio_Device_Stream_t* const Stream,
+			                                 uint8_t* const FIFO,
+			                                 const uint16_t FIFOSize,
+			                                 const uint32_t SampleRate,
+			                                 const uint8_t SampleFrameSize) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2)
+			                                                                ATTR_NON_NULL_PTR_ARG(3);
+
+			/** Stops a stream started with \ref Audio_Device_StartStream(). The samples left in the FIFO are dropped.
+			 *
+			 *  \param[in,out] Stream  Stream state.
+			 */
+			void Audio_Device_StopStream(Audio_Device_Stream_t* const Stream) ATTR_NON_NULL_PTR_ARG(1);
+
+			/** Takes the next samples of a stream from its FIFO, typically from the interrupt feeding the DAC. The buffer is
+			 *  always filled: with silence while the FIFO fills up to the target level after the stream started or ran dry.
+			 *
+			 *  \param[in,out] Stream  Stream state.
+			 *  \param[out]    Buffer  Buffer for the samples.
+			 *  \param[in]     Count   Number of sample frames to take.
+			 *
+			 *  \return Number of sample frames taken from the FIFO, the rest of the buffer is silence.
+			 */
+			uint16_t Audio_Device_ReadStreamSamples(Audio_Device_Stream_t* const Stream,
+			                                        void* const Buffer,
+			                                        const uint16_t Count) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2);
+
+			/** Returns the sample rate a stream asks the host for through its feedback endpoint.
+			 *
+			 *  \param[in] Stream  Stream state.
+			 *
+			 *  \return Sample rate in Hz.
+			 */
+			uint32_t Audio_Device_GetStreamSampleRate(const Audio_Device_Stream_t* const Stream) ATTR_NON_NULL_PTR_ARG(1);
+			#endif
+
 		/* Inline Functions: */
+			#if defined(ENDPOINT_ISO_STREAMS) || defined(__DOXYGEN__)
+			/** Returns the number of sample frames waiting in the FIFO of a stream.
+			 *
+			 *  \param[in] Stream  Stream state.
+			 *
+			 *  \return Fill level of the FIFO in sample frames.
+			 */
+PRAGMA_ALWAYS_INLINE
+			static inline uint16_t Audio_Device_GetStreamLevel(const Audio_Device_Stream_t* const Stream)
+			                                                   ATTR_NON_NULL_PTR_ARG(1) ATTR_ALWAYS_INLINE;
+			static inline uint16_t Audio_Device_GetStreamLevel(const Audio_Device_Stream_t* const Stream)
+			{
+				uint16_t WriteIndex = Stream->WriteIndex;
+				uint16_t ReadIndex  = Stream->ReadIndex;
+
+				return (WriteIndex >= ReadIndex) ? (WriteIndex - ReadIndex) : (Stream->FIFOFrames - ReadIndex + WriteIndex);
+			}
+			#endif
+
 			/** General management task for a given Audio class interface, required for the correct operation of the interface. This should
 			 *  be called frequently in the main program loop, before the master USB management task \ref USB_USBTask().
 			 *
@@ -366,12 +535,30 @@ PRAGMA_ALWAYS_INLINE
 
 	/* Private Interface - For use in library only: */
 	#if !defined(__DOXYGEN__)
+		/* Macros: */
+			#define AUDIO_DEVICE_LEVEL_FILTER_SHIFT     3 /* FIFO level averaged over about 8 transfers */
+			#define AUDIO_DEVICE_FEEDBACK_GAIN_SHIFT    7 /* 1/128 sample per frame faster for each sample under the target level */
+			#define AUDIO_DEVICE_FEEDBACK_RANGE_SHIFT   7 /* feedback kept within 1/128 of the nominal rate */
+
 		/* Function Prototypes: */
 			#if defined(__INCLUDE_FROM_AUDIO_DEVICE_C)
 				void Audio_Device_Event_Stub(USB_ClassInfo_Audio_Device_t* const AudioInterfaceInfo) ATTR_CONST;
 PRAGMA_WEAK(EVENT_Audio_Device_StreamStartStop,Audio_Device_Event_Stub)				
 				void EVENT_Audio_Device_StreamStartStop(USB_ClassInfo_Audio_Device_t* const AudioInterfaceInfo)
 				                                        ATTR_WEAK ATTR_NON_NULL_PTR_ARG(1) ATTR_ALIAS(Audio_Device_Event_Stub);
+
+				#if defined(ENDPOINT_ISO_STREAMS)
+				static bool Audio_Device_SelectStreamEndpoint(const uint8_t EndpointNumber, const uint8_t Direction, const uint16_t Size);
+				static uint32_t Audio_Device_SamplesPerFrame(const uint32_t SampleRate) ATTR_CONST;
+				static void Audio_Device_StreamToFIFO(Audio_Device_Stream_t* const Stream, const uint8_t* Data, uint16_t Length);
+				static void Audio_Device_UpdateFeedback(Audio_Device_Stream_t* const Stream);
+				static void Audio_Device_WriteFeedback(const Audio_Device_Stream_t* const Stream, uint8_t* Buffer,
+				                                       uint16_t* PacketLength, const uint8_t PacketCount);
+				static bool Audio_Device_DataOUTComplete(const uint8_t EndpointNumber, uint8_t* Buffer,
+				                                         uint16_t* PacketLength, const uint8_t PacketCount);
+				static bool Audio_Device_FeedbackComplete(const uint8_t EndpointNumber, uint8_t* Buffer,
+				                                          uint16_t* PacketLength, const uint8_t PacketCount);
+				#endif
 			#endif
 
 	#endif	
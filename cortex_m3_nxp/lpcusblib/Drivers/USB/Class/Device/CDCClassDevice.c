@@ -163,9 +163,35 @@ void CDC_Device_USBTask(USB_ClassInfo_CDC_Device_t* const CDCInterfaceInfo)
 	if ((USB_DeviceState != DEVICE_STATE_Configured) || !(CDCInterfaceInfo->State.LineEncoding.BaudRateBPS))
 	  return;
 
+	#if defined(ENDPOINT_DMA_BUFFERS)
+	CDC_Device_BytesReceived(CDCInterfaceInfo);
+
+	Endpoint_SelectEndpoint(CDCInterfaceInfo->Config.DataINEndpointNumber);
+
+	while (CDCInterfaceInfo->State.Transmit.Queued && Endpoint_IsDMAComplete())
+	{
+		Endpoint_ReleaseDMA();
+		CDCInterfaceInfo->State.Transmit.Queued--;
+	}
+
+	/* Bytes written meanwhile go out once the endpoint is idle, so the task never waits on the host */
+	if (CDCInterfaceInfo->State.Transmit.Queued)
+	  return;
+	#endif
+
 	#if !defined(NO_CLASS_DRIVER_AUTOFLUSH)
+	#if defined(ENDPOINT_DMA_BUFFERS)
+	/* A full buffer goes at once and leaves the host's read open; a partial one waits for more bytes to join it */
+	if (CDCInterfaceInfo->State.Transmit.Length == CDC_DEVICE_BUFFER_SIZE)
+	  CDC_Device_Transmit(CDCInterfaceInfo);
+	else if ((CDCInterfaceInfo->State.Transmit.Length || CDCInterfaceInfo->State.Transmit.Unterminated) &&
+	         (((USB_Device_GetFrameNumber() - CDCInterfaceInfo->State.Transmit.Frame) & 0x7FF) >=
+	          CDCInterfaceInfo->Config.DataINFlushLatency))
+	  CDC_Device_Flush(CDCInterfaceInfo);
+	#else
 	CDC_Device_Flush(CDCInterfaceInfo);
 	#endif
+	#endif
 }
 
 uint8_t CDC_Device_SendString(USB_ClassInfo_CDC_Device_t* const CDCInterfaceInfo,
@@ -174,10 +200,14 @@ uint8_t CDC_Device_SendString(USB_ClassInfo_CDC_Device_t* const CDCInterfaceInfo
 	if ((USB_DeviceState != DEVICE_STATE_Configured) || !(CDCInterfaceInfo->State.LineEncoding.BaudRateBPS))
 	  return ENDPOINT_RWSTREAM_DeviceDisconnected;
 
+	#if defined(ENDPOINT_DMA_BUFFERS)
+	return CDC_Device_SendData(CDCInterfaceInfo, String, strlen(String));
+	#else
 	Endpoint_SelectEndpoint(CDCInterfaceInfo->Config.DataINEndpointNumber);
 	Endpoint_Write_Stream_LE(String, strlen(String), NULL);
 	Endpoint_ClearIN();
 	return ENDPOINT_RWSTREAM_NoError;
+	#endif
 }
 
 uint8_t CDC_Device_SendData(USB_ClassInfo_CDC_Device_t* const CDCInterfaceInfo,
@@ -187,10 +217,36 @@ uint8_t CDC_Device_SendData(USB_ClassInfo_CDC_Device_t* const CDCInterfaceInfo,
 	if ((USB_DeviceState != DEVICE_STATE_Configured) || !(CDCInterfaceInfo->State.LineEncoding.BaudRateBPS))
 	  return ENDPOINT_RWSTREAM_DeviceDisconnected;
 
+	#if defined(ENDPOINT_DMA_BUFFERS)
+	uint16_t Sent = 0;
+	uint16_t Chunk;
+	uint8_t  ErrorCode;
+
+	while (Sent < Length)
+	{
+		if (CDCInterfaceInfo->State.Transmit.Length == CDC_DEVICE_BUFFER_SIZE)
+		{
+			if ((ErrorCode = CDC_Device_Transmit(CDCInterfaceInfo)) != ENDPOINT_RWSTREAM_NoError)
+			  return ErrorCode;
+		}
+
+		if (!(CDCInterfaceInfo->State.Transmit.Length))
+		  CDCInterfaceInfo->State.Transmit.Frame = USB_Device_GetFrameNumber();
+
+		Chunk = MIN(Length - Sent, CDC_DEVICE_BUFFER_SIZE - CDCInterfaceInfo->State.Transmit.Length);
+		memcpy(&CDCInterfaceInfo->State.Transmit.Buffer[CDCInterfaceInfo->State.Transmit.Filling][CDCInterfaceInfo->State.Transmit.Length],
+		       &Buffer[Sent], Chunk);
+		CDCInterfaceInfo->State.Transmit.Length += Chunk;
+		Sent += Chunk;
+	}
+
+	return ENDPOINT_RWSTREAM_NoError;
+	#else
 	Endpoint_SelectEndpoint(CDCInterfaceInfo->Config.DataINEndpointNumber);
 	Endpoint_Write_Stream_LE(Buffer, Length, NULL);
 	Endpoint_ClearIN();
 	return ENDPOINT_RWSTREAM_NoError;
+	#endif
 }
 
 uint8_t CDC_Device_SendByte(USB_ClassInfo_CDC_Device_t* const CDCInterfaceInfo,
@@ -199,6 +255,20 @@ uint8_t CDC_Device_SendByte(USB_ClassInfo_CDC_Device_t* const CDCInterfaceInfo,
 	if ((USB_DeviceState != DEVICE_STATE_Configured) || !(CDCInterfaceInfo->State.LineEncoding.BaudRateBPS))
 	  return ENDPOINT_RWSTREAM_DeviceDisconnected;
 
+	#if defined(ENDPOINT_DMA_BUFFERS)
+	if (CDCInterfaceInfo->State.Transmit.Length == CDC_DEVICE_BUFFER_SIZE)
+	{
+		uint8_t ErrorCode;
+
+		if ((ErrorCode = CDC_Device_Transmit(CDCInterfaceInfo)) != ENDPOINT_READYWAIT_NoError)
+		  return ErrorCode;
+	}
+
+	if (!(CDCInterfaceInfo->State.Transmit.Length))
+	  CDCInterfaceInfo->State.Transmit.Frame = USB_Device_GetFrameNumber();
+
+	CDCInterfaceInfo->State.Transmit.Buffer[CDCInterfaceInfo->State.Transmit.Filling][CDCInterfaceInfo->State.Transmit.Length++] = Data;
+	#else
 	Endpoint_SelectEndpoint(CDCInterfaceInfo->Config.DataINEndpointNumber);
 
 	if (!(Endpoint_IsReadWriteAllowed()))
@@ -212,6 +282,7 @@ uint8_t CDC_Device_SendByte(USB_ClassInfo_CDC_Device_t* const CDCInterfaceInfo,
 	}
 
 	Endpoint_Write_8(Data);
+	#endif
 	return ENDPOINT_READYWAIT_NoError;
 }
 
@@ -222,6 +293,24 @@ uint8_t CDC_Device_Flush(USB_ClassInfo_CDC_Device_t* const CDCInterfaceInfo)
 
 	uint8_t ErrorCode;
 
+	#if defined(ENDPOINT_DMA_BUFFERS)
+	if (CDCInterfaceInfo->State.Transmit.Length)
+	{
+		if ((ErrorCode = CDC_Device_Transmit(CDCInterfaceInfo)) != ENDPOINT_READYWAIT_NoError)
+		  return ErrorCode;
+	}
+
+	/* A transfer of whole packets only ends the host's read with a zero length packet */
+	if (CDCInterfaceInfo->State.Transmit.Unterminated)
+	{
+		Endpoint_SelectEndpoint(CDCInterfaceInfo->Config.DataINEndpointNumber);
+		Endpoint_StartDMA(CDCInterfaceInfo->State.Transmit.Buffer[CDCInterfaceInfo->State.Transmit.Filling], 0);
+		CDCInterfaceInfo->State.Transmit.Queued++;
+		CDCInterfaceInfo->State.Transmit.Unterminated = false;
+	}
+
+	return ENDPOINT_READYWAIT_NoError;
+	#else
 	Endpoint_SelectEndpoint(CDCInterfaceInfo->Config.DataINEndpointNumber);
 
 	if (!(Endpoint_BytesInEndpoint()))
@@ -240,6 +329,7 @@ uint8_t CDC_Device_Flush(USB_ClassInfo_CDC_Device_t* const CDCInterfaceInfo)
 	}
 
 	return ENDPOINT_READYWAIT_NoError;
+	#endif
 }
 
 uint16_t CDC_Device_BytesReceived(USB_ClassInfo_CDC_Device_t* const CDCInterfaceInfo)
@@ -249,6 +339,9 @@ uint16_t CDC_Device_BytesReceived(USB_ClassInfo_CDC_Device_t* const CDCInterface
 
 	Endpoint_SelectEndpoint(CDCInterfaceInfo->Config.DataOUTEndpointNumber);
 
+	#if defined(ENDPOINT_DMA_BUFFERS)
+	return CDC_Device_FetchReceived(CDCInterfaceInfo);
+	#else
 	if (Endpoint_IsOUTReceived())
 	{
 		if (!(Endpoint_BytesInEndpoint()))
@@ -265,6 +358,47 @@ uint16_t CDC_Device_BytesReceived(USB_ClassInfo_CDC_Device_t* const CDCInterface
 	{
 		return 0;
 	}
+	#endif
+}
+
+uint16_t CDC_Device_ReceiveData(USB_ClassInfo_CDC_Device_t* const CDCInterfaceInfo,
+                                void* const Buffer,
+                                const uint16_t Length)
+{
+	if ((USB_DeviceState != DEVICE_STATE_Configured) || !(CDCInterfaceInfo->State.LineEncoding.BaudRateBPS))
+	  return 0;
+
+	uint16_t Received = 0;
+
+	Endpoint_SelectEndpoint(CDCInterfaceInfo->Config.DataOUTEndpointNumber);
+
+	#if defined(ENDPOINT_DMA_BUFFERS)
+	uint16_t Chunk;
+
+	while ((Received < Length) && (Chunk = CDC_Device_FetchReceived(CDCInterfaceInfo)))
+	{
+		Chunk = MIN(Chunk, Length - Received);
+		memcpy(&((uint8_t*)Buffer)[Received],
+		       &CDCInterfaceInfo->State.Receive.Buffer[CDCInterfaceInfo->State.Receive.Next ^ 1][CDCInterfaceInfo->State.Receive.Offset],
+		       Chunk);
+		CDCInterfaceInfo->State.Receive.Offset += Chunk;
+		Received += Chunk;
+	}
+
+	/* An emptied buffer goes back to the endpoint at once */
+	CDC_Device_FetchReceived(CDCInterfaceInfo);
+	#else
+	while ((Received < Length) && Endpoint_IsOUTReceived())
+	{
+		while ((Received < Length) && Endpoint_BytesInEndpoint())
+		  ((uint8_t*)Buffer)[Received++] = Endpoint_Read_8();
+
+		if (!(Endpoint_BytesInEndpoint()))
+		  Endpoint_ClearOUT();
+	}
+	#endif
+
+	return Received;
 }
 
 int16_t CDC_Device_ReceiveByte(USB_ClassInfo_CDC_Device_t* const CDCInterfaceInfo)
@@ -276,6 +410,15 @@ int16_t CDC_Device_ReceiveByte(USB_ClassInfo_CDC_Device_t* const CDCInterfaceInf
 
 	Endpoint_SelectEndpoint(CDCInterfaceInfo->Config.DataOUTEndpointNumber);
 
+	#if defined(ENDPOINT_DMA_BUFFERS)
+	if (CDC_Device_FetchReceived(CDCInterfaceInfo))
+	{
+		ReceivedByte = CDCInterfaceInfo->State.Receive.Buffer[CDCInterfaceInfo->State.Receive.Next ^ 1][CDCInterfaceInfo->State.Receive.Offset++];
+
+		/* An emptied buffer goes back to the endpoint at once */
+		CDC_Device_FetchReceived(CDCInterfaceInfo);
+	}
+	#else
 	if (Endpoint_IsOUTReceived())
 	{
 		if (Endpoint_BytesInEndpoint()){
@@ -286,6 +429,7 @@ int16_t CDC_Device_ReceiveByte(USB_ClassInfo_CDC_Device_t* const CDCInterfaceInf
 		if (!(Endpoint_BytesInEndpoint()))
 		  Endpoint_ClearOUT();
 	}
+	#endif
 
 	return ReceivedByte;
 }
@@ -361,6 +505,67 @@ static int CDC_Device_getchar_Blocking(FILE* Stream)
 }
 #endif
 
+#if defined(ENDPOINT_DMA_BUFFERS)
+/* Queues the buffer being filled on the data IN endpoint, behind the transfer in flight, and
+ * waits for that one to end so that its buffer can be filled next */
+static uint8_t CDC_Device_Transmit(USB_ClassInfo_CDC_Device_t* const CDCInterfaceInfo)
+{
+	uint8_t ErrorCode;
+
+	Endpoint_SelectEndpoint(CDCInterfaceInfo->Config.DataINEndpointNumber);
+
+	Endpoint_StartDMA(CDCInterfaceInfo->State.Transmit.Buffer[CDCInterfaceInfo->State.Transmit.Filling],
+	                  CDCInterfaceInfo->State.Transmit.Length);
+	CDCInterfaceInfo->State.Transmit.Queued++;
+	CDCInterfaceInfo->State.Transmit.Unterminated = !(CDCInterfaceInfo->State.Transmit.Length %
+	                                                  CDCInterfaceInfo->Config.DataINEndpointSize);
+	CDCInterfaceInfo->State.Transmit.Filling ^= 1;
+	CDCInterfaceInfo->State.Transmit.Length   = 0;
+	CDCInterfaceInfo->State.Transmit.Frame    = USB_Device_GetFrameNumber();
+
+	while (CDCInterfaceInfo->State.Transmit.Queued > 1)
+	{
+		if ((ErrorCode = Endpoint_WaitDMA(NULL)) != ENDPOINT_RWSTREAM_NoError)
+		{
+			CDCInterfaceInfo->State.Transmit.Queued = 0;
+			return ErrorCode;
+		}
+
+		CDCInterfaceInfo->State.Transmit.Queued--;
+	}
+
+	return ENDPOINT_RWSTREAM_NoError;
+}
+
+/* Returns the number of unread bytes in the receive buffer being read. Once it is empty, it is
+ * lent to the data OUT endpoint again and the oldest queued transfer, if ended, takes its place. */
+static uint16_t CDC_Device_FetchReceived(USB_ClassInfo_CDC_Device_t* const CDCInterfaceInfo)
+{
+	if (CDCInterfaceInfo->State.Receive.Offset == CDCInterfaceInfo->State.Receive.Length)
+	{
+		Endpoint_SelectEndpoint(CDCInterfaceInfo->Config.DataOUTEndpointNumber);
+
+		while (CDCInterfaceInfo->State.Receive.Queued < 2)
+		{
+			Endpoint_StartDMA(CDCInterfaceInfo->State.Receive.Buffer[(CDCInterfaceInfo->State.Receive.Next +
+			                                                          CDCInterfaceInfo->State.Receive.Queued) & 1],
+			                  CDC_DEVICE_BUFFER_SIZE);
+			CDCInterfaceInfo->State.Receive.Queued++;
+		}
+
+		if (Endpoint_IsDMAComplete())
+		{
+			CDCInterfaceInfo->State.Receive.Length = Endpoint_ReleaseDMA();
+			CDCInterfaceInfo->State.Receive.Offset = 0;
+			CDCInterfaceInfo->State.Receive.Next  ^= 1;
+			CDCInterfaceInfo->State.Receive.Queued--;
+		}
+	}
+
+	return (CDCInterfaceInfo->State.Receive.Length - CDCInterfaceInfo->State.Receive.Offset);
+}
+#endif
+
 void CDC_Device_Event_Stub(USB_ClassInfo_CDC_Device_t* const CDCInterfaceInfo)
 {
 
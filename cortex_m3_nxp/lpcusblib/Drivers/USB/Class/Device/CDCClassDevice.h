@@ -90,12 +90,25 @@
 		#endif
 
 	/* Public Interface - May be used in end-application: */
+		/* Macros: */
+			#if !defined(CDC_DEVICE_BUFFER_SIZE) || defined(__DOXYGEN__)
+				/** Size in bytes of each of the two transmit and two receive buffers of a CDC interface, where the endpoints
+				 *  can be lent buffers (\c ENDPOINT_DMA_BUFFERS). Must be a multiple of the data endpoint sizes; larger buffers
+				 *  move bursts of data in fewer DMA transfers.
+				 */
+				#define CDC_DEVICE_BUFFER_SIZE           64
+			#endif
+
 		/* Type Defines: */
 			/** \brief CDC Class Device Mode Configuration and State Structure.
 			 *
 			 *  Class state structure. An instance of this structure should be made for each CDC interface
 			 *  within the user application, and passed to each of the CDC class driver functions as the
 			 *  CDCInterfaceInfo parameter. This stores each CDC interface's configuration and state information.
+			 *
+			 *  \note Where the endpoints can be lent buffers (\c ENDPOINT_DMA_BUFFERS), the data is moved straight between the
+			 *        host and buffers in this structure, which must then be placed in memory the USB DMA can reach
+			 *        (\c __DATA(USBRAM_SECTION) on the LPC17xx).
 			 */
 			typedef struct
 			{
@@ -114,6 +127,12 @@
 					uint8_t  NotificationEndpointNumber; /**< Endpoint number of the CDC interface's IN notification endpoint, if used. */
 					uint16_t NotificationEndpointSize;  /**< Size in bytes of the CDC interface's IN notification endpoint, if used. */
 					bool     NotificationEndpointDoubleBank; /**< Indicates if the CDC interface's notification endpoint should use double banking. */
+
+					uint16_t DataINFlushLatency; /**< Frames a partly filled transmit buffer may wait for more bytes before
+					                              *   \ref CDC_Device_USBTask() sends it, where the endpoints can be lent buffers
+					                              *   (\c ENDPOINT_DMA_BUFFERS). Fewer, fuller packets for a byte stream; 0 sends
+					                              *   at the next call.
+					                              */
 				} Config; /**< Config data for the USB class interface within the device. All elements in this section
 				           *   <b>must</b> be set or the interface will fail to enumerate and operate correctly.
 				           */
@@ -134,6 +153,29 @@
 					                                  *  This is generally only used if the virtual serial port data is to be
 					                                  *  reconstructed on a physical UART.
 					                                  */
+
+					#if defined(ENDPOINT_DMA_BUFFERS)
+					struct
+					{
+						uint8_t  Buffer[2][CDC_DEVICE_BUFFER_SIZE] ATTR_ALIGNED(4); /**< Buffers lent in turn to the data IN endpoint. */
+						uint16_t Length; /**< Number of bytes written to the buffer being filled. */
+						uint8_t  Filling; /**< Index of the buffer being filled. */
+						uint8_t  Queued; /**< Number of transfers queued on the data IN endpoint. */
+						uint16_t Frame; /**< Frame number when the buffer being filled got its first byte. */
+						bool     Unterminated; /**< Indicates the last transfer queued ended on a whole packet, so the host's
+						                        *   read only ends with more data or a zero length packet.
+						                        */
+					} Transmit; /**< Transmit buffers, managed by the class driver. */
+
+					struct
+					{
+						uint8_t  Buffer[2][CDC_DEVICE_BUFFER_SIZE] ATTR_ALIGNED(4); /**< Buffers lent in turn to the data OUT endpoint. */
+						uint16_t Length; /**< Number of bytes received in the buffer being read. */
+						uint16_t Offset; /**< Number of bytes read from the buffer being read. */
+						uint8_t  Next; /**< Index of the buffer of the oldest transfer queued. */
+						uint8_t  Queued; /**< Number of transfers queued on the data OUT endpoint. */
+					} Receive; /**< Receive buffers, managed by the class driver. */
+					#endif
 				} State; /**< State data for the USB class interface within the device. All elements in this section
 				          *   are reset to their defaults when the interface is enumerated.
 				          */
@@ -169,6 +211,9 @@
 			 *  user program by declaring a handler function with the same name and parameters listed here. The new line encoding
 			 *  settings are available in the LineEncoding structure inside the CDC interface structure passed as a parameter.
 			 *
+			 *  \note With \c INTERRUPT_CONTROL_ENDPOINT defined this event fires in interrupt context, see
+			 *        \ref EVENT_USB_Device_ControlRequest(); reprogramming a UART here must not wait for it to drain.
+			 *
 			 *  \param[in,out] CDCInterfaceInfo  Pointer to a structure containing a CDC Class configuration and state.
 			 */
 			void EVENT_CDC_Device_LineEncodingChanged(USB_ClassInfo_CDC_Device_t* const CDCInterfaceInfo) ATTR_NON_NULL_PTR_ARG(1);
@@ -179,6 +224,9 @@
 			 *  are available in the \c ControlLineStates.HostToDevice value inside the CDC interface structure passed as a parameter, set as
 			 *  a mask of \c CDC_CONTROL_LINE_OUT_* masks.
 			 *
+			 *  \note With \c INTERRUPT_CONTROL_ENDPOINT defined this event fires in interrupt context, see
+			 *        \ref EVENT_USB_Device_ControlRequest().
+			 *
 			 *  \param[in,out] CDCInterfaceInfo  Pointer to a structure containing a CDC Class configuration and state.
 			 */
 			void EVENT_CDC_Device_ControLineStateChanged(USB_ClassInfo_CDC_Device_t* const CDCInterfaceInfo) ATTR_NON_NULL_PTR_ARG(1);
@@ -186,6 +234,10 @@
 			/** CDC class driver event for a send break request sent to the device from the host. This is generally used to separate
 			 *  data or to indicate a special condition to the receiving device.
 			 *
+			 *  \note With \c INTERRUPT_CONTROL_ENDPOINT defined this event fires in interrupt context, so the break
+			 *        should be started here and timed out elsewhere rather than waited for; see
+			 *        \ref EVENT_USB_Device_ControlRequest().
+			 *
 			 *  \param[in,out] CDCInterfaceInfo  Pointer to a structure containing a CDC Class configuration and state.
 			 *  \param[in]     Duration          Duration of the break that has been sent by the host, in milliseconds.
 			 */
@@ -247,6 +299,9 @@
 			 *  succeed immediately. If multiple bytes are to be received, they should be buffered by the user application, as the endpoint
 			 *  bank will not be released back to the USB controller until all bytes are read.
 			 *
+			 *  \note Where the endpoints can be lent buffers (\c ENDPOINT_DMA_BUFFERS), the count is that of the receive buffer being read;
+			 *        the other one stays lent to the endpoint meanwhile, so the host can send on.
+			 *
 			 *  \pre This function must only be called when the Device state machine is in the \ref DEVICE_STATE_Configured state or
 			 *       the call will fail.
 			 *
@@ -270,6 +325,22 @@
 			 */
 			int16_t CDC_Device_ReceiveByte(USB_ClassInfo_CDC_Device_t* const CDCInterfaceInfo) ATTR_NON_NULL_PTR_ARG(1);
 
+			/** Reads up to \c Length bytes of data received from the host, without waiting for more. Where the endpoints can be
+			 *  lent buffers (\c ENDPOINT_DMA_BUFFERS), emptied receive buffers go back to the endpoint as they are read.
+			 *
+			 *  \pre This function must only be called when the Device state machine is in the \ref DEVICE_STATE_Configured state or
+			 *       the call will fail.
+			 *
+			 *  \param[in,out] CDCInterfaceInfo  Pointer to a structure containing a CDC Class configuration and state.
+			 *  \param[out]    Buffer            Buffer to place the received bytes into.
+			 *  \param[in]     Length            Size in bytes of the buffer.
+			 *
+			 *  \return Number of bytes placed into the buffer.
+			 */
+			uint16_t CDC_Device_ReceiveData(USB_ClassInfo_CDC_Device_t* const CDCInterfaceInfo,
+			                                void* const Buffer,
+			                                const uint16_t Length) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2);
+
 			/** Flushes any data waiting to be sent, ensuring that the send buffer is cleared.
 			 *
 			 *  \pre This function must only be called when the Device state machine is in the \ref DEVICE_STATE_Configured state or
@@ -336,6 +407,11 @@
 				static int CDC_Device_getchar_Blocking(FILE* Stream) ATTR_NON_NULL_PTR_ARG(1);
 				#endif
 
+				#if defined(ENDPOINT_DMA_BUFFERS)
+				static uint8_t CDC_Device_Transmit(USB_ClassInfo_CDC_Device_t* const CDCInterfaceInfo) ATTR_NON_NULL_PTR_ARG(1);
+				static uint16_t CDC_Device_FetchReceived(USB_ClassInfo_CDC_Device_t* const CDCInterfaceInfo) ATTR_NON_NULL_PTR_ARG(1);
+				#endif
+
 				void CDC_Device_Event_Stub(USB_ClassInfo_CDC_Device_t* const CDCInterfaceInfo) ATTR_CONST;
 				void CDC_Device_Event_Stub2(USB_ClassInfo_CDC_Device_t* const CDCInterfaceInfo, const uint8_t Duration) ATTR_CONST;
 
@@ -153,6 +153,10 @@
 			 *  HID class control requests from the host, or by the normal HID endpoint polling procedure. Inside this callback the
 			 *  user is responsible for the creation of the next HID input report to be sent to the host.
 			 *
+			 *  \note With \c INTERRUPT_CONTROL_ENDPOINT defined, the GET REPORT requests call this from interrupt context
+			 *        (see \ref EVENT_USB_Device_ControlRequest()) while the endpoint polling calls it from the task, so it
+			 *        must not block and must be safe against being interrupted by itself.
+			 *
 			 *  \param[in,out] HIDInterfaceInfo  Pointer to a structure containing a HID Class configuration and state.
 			 *  \param[in,out] ReportID          If preset to a non-zero value, this is the report ID being requested by the host. If zero,
 			 *                                   this should be set to the report ID of the generated HID input report (if any). If multiple
@@ -175,6 +179,9 @@
 			 *  either HID class control requests from the host, or by the normal HID endpoint polling procedure. Inside this callback
 			 *  the user is responsible for the processing of the received HID output report from the host.
 			 *
+			 *  \note As for \ref CALLBACK_HID_Device_CreateHIDReport(), SET REPORT requests call this from interrupt
+			 *        context when \c INTERRUPT_CONTROL_ENDPOINT is defined.
+			 *
 			 *  \param[in,out] HIDInterfaceInfo  Pointer to a structure containing a HID Class configuration and state.
 			 *  \param[in]     ReportID          Report ID of the received output report. If multiple reports are not received via the given HID
 			 *                                   interface, this parameter should be ignored.
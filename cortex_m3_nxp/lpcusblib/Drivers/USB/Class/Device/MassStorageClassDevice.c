@@ -118,32 +118,27 @@ void MS_Device_USBTask(USB_ClassInfo_MS_Device_t* const MSInterfaceInfo)
 	if (USB_DeviceState != DEVICE_STATE_Configured)
 	  return;
 
-	Endpoint_SelectEndpoint(MSInterfaceInfo->Config.DataOUTEndpointNumber);
-
-	if (Endpoint_IsReadWriteAllowed())
+	if (MS_Device_ReadInCommandBlock(MSInterfaceInfo))
 	{
-		if (MS_Device_ReadInCommandBlock(MSInterfaceInfo))
-		{
-			if (MSInterfaceInfo->State.CommandBlock.Flags & MS_COMMAND_DIR_DATA_IN)
-				Endpoint_SelectEndpoint(MSInterfaceInfo->Config.DataINEndpointNumber);
+		if (MSInterfaceInfo->State.CommandBlock.Flags & MS_COMMAND_DIR_DATA_IN)
+			Endpoint_SelectEndpoint(MSInterfaceInfo->Config.DataINEndpointNumber);
 
-			bool SCSICommandResult = CALLBACK_MS_Device_SCSICommandReceived(MSInterfaceInfo);
+		bool SCSICommandResult = CALLBACK_MS_Device_SCSICommandReceived(MSInterfaceInfo);
 
-			Endpoint_SelectEndpoint(MSInterfaceInfo->Config.DataOUTEndpointNumber);// for streaming
-			Endpoint_ClearOUT();
-			if (MSInterfaceInfo->State.CommandBlock.Flags & MS_COMMAND_DIR_DATA_IN)
-				Endpoint_SelectEndpoint(MSInterfaceInfo->Config.DataINEndpointNumber);
+		Endpoint_SelectEndpoint(MSInterfaceInfo->Config.DataOUTEndpointNumber);// for streaming
+		Endpoint_ClearOUT();
+		if (MSInterfaceInfo->State.CommandBlock.Flags & MS_COMMAND_DIR_DATA_IN)
+			Endpoint_SelectEndpoint(MSInterfaceInfo->Config.DataINEndpointNumber);
 
-			MSInterfaceInfo->State.CommandStatus.Status              = (SCSICommandResult) ? MS_SCSI_COMMAND_Pass : MS_SCSI_COMMAND_Fail;
-			MSInterfaceInfo->State.CommandStatus.Signature           = CPU_TO_LE32(MS_CSW_SIGNATURE);
-			MSInterfaceInfo->State.CommandStatus.Tag                 = MSInterfaceInfo->State.CommandBlock.Tag;
-			MSInterfaceInfo->State.CommandStatus.DataTransferResidue = MSInterfaceInfo->State.CommandBlock.DataTransferLength;
+		MSInterfaceInfo->State.CommandStatus.Status              = (SCSICommandResult) ? MS_SCSI_COMMAND_Pass : MS_SCSI_COMMAND_Fail;
+		MSInterfaceInfo->State.CommandStatus.Signature           = CPU_TO_LE32(MS_CSW_SIGNATURE);
+		MSInterfaceInfo->State.CommandStatus.Tag                 = MSInterfaceInfo->State.CommandBlock.Tag;
+		MSInterfaceInfo->State.CommandStatus.DataTransferResidue = MSInterfaceInfo->State.CommandBlock.DataTransferLength;
 
-			if (!(SCSICommandResult) && (le32_to_cpu(MSInterfaceInfo->State.CommandStatus.DataTransferResidue)))
-			  Endpoint_StallTransaction();
+		if (!(SCSICommandResult) && (le32_to_cpu(MSInterfaceInfo->State.CommandStatus.DataTransferResidue)))
+		  Endpoint_StallTransaction();
 
-			MS_Device_ReturnCommandStatus(MSInterfaceInfo);
-		}
+		MS_Device_ReturnCommandStatus(MSInterfaceInfo);
 	}
 
 	if (MSInterfaceInfo->State.IsMassStoreReset)
@@ -152,9 +147,16 @@ void MS_Device_USBTask(USB_ClassInfo_MS_Device_t* const MSInterfaceInfo)
 		Endpoint_ResetEndpoint(MSInterfaceInfo->Config.DataINEndpointNumber);
 
 		Endpoint_SelectEndpoint(MSInterfaceInfo->Config.DataOUTEndpointNumber);
+		#if defined(ENDPOINT_DMA_BUFFERS)
+		Endpoint_AbortDMA();
+		MSInterfaceInfo->State.IsCommandBlockQueued = false;
+		#endif
 		Endpoint_ClearStall();
 		Endpoint_ResetDataToggle();
 		Endpoint_SelectEndpoint(MSInterfaceInfo->Config.DataINEndpointNumber);
+		#if defined(ENDPOINT_DMA_BUFFERS)
+		Endpoint_AbortDMA();
+		#endif
 		Endpoint_ClearStall();
 		Endpoint_ResetDataToggle();
 
@@ -164,10 +166,30 @@ void MS_Device_USBTask(USB_ClassInfo_MS_Device_t* const MSInterfaceInfo)
 
 static bool MS_Device_ReadInCommandBlock(USB_ClassInfo_MS_Device_t* const MSInterfaceInfo)
 {
-	uint16_t BytesProcessed;
+	bool IsComplete;
 
 	Endpoint_SelectEndpoint(MSInterfaceInfo->Config.DataOUTEndpointNumber);
-	
+
+	#if defined(ENDPOINT_DMA_BUFFERS)
+	/* The command block is lent to the endpoint while the interface waits for the next command,
+	 * so that the host's packet goes straight into it */
+	if (!(MSInterfaceInfo->State.IsCommandBlockQueued))
+	{
+		Endpoint_StartDMA(&MSInterfaceInfo->State.CommandBlock, sizeof(MS_CommandBlockWrapper_t));
+		MSInterfaceInfo->State.IsCommandBlockQueued = true;
+	}
+
+	if (!(Endpoint_IsDMAComplete()))
+	  return false;
+
+	MSInterfaceInfo->State.IsCommandBlockQueued = false;
+	IsComplete = (Endpoint_ReleaseDMA() == sizeof(MS_CommandBlockWrapper_t));
+	#else
+	uint16_t BytesProcessed;
+
+	if (!(Endpoint_IsReadWriteAllowed()))
+	  return false;
+
 	BytesProcessed = 0;
 	while (Endpoint_Read_Stream_LE(&MSInterfaceInfo->State.CommandBlock,
 	                               (sizeof(MS_CommandBlockWrapper_t) - 16), &BytesProcessed) ==
@@ -177,7 +199,11 @@ static bool MS_Device_ReadInCommandBlock(USB_ClassInfo_MS_Device_t* const MSInte
 		  return false;
 	}
 
-	if ((MSInterfaceInfo->State.CommandBlock.Signature         != CPU_TO_LE32(MS_CBW_SIGNATURE))     ||
+	IsComplete = true;
+	#endif
+
+	if (!(IsComplete)                                                                                ||
+	    (MSInterfaceInfo->State.CommandBlock.Signature         != CPU_TO_LE32(MS_CBW_SIGNATURE))     ||
 	    (MSInterfaceInfo->State.CommandBlock.LUN               >= MSInterfaceInfo->Config.TotalLUNs) ||
 		(MSInterfaceInfo->State.CommandBlock.Flags              & 0x1F)                              ||
 		(MSInterfaceInfo->State.CommandBlock.SCSICommandLength == 0)                                 ||
@@ -190,6 +216,7 @@ static bool MS_Device_ReadInCommandBlock(USB_ClassInfo_MS_Device_t* const MSInte
 		return false;
 	}
 
+	#if !defined(ENDPOINT_DMA_BUFFERS)
 	BytesProcessed = 0;
 	while (Endpoint_Read_Stream_LE(&MSInterfaceInfo->State.CommandBlock.SCSICommandData,
 	                                MSInterfaceInfo->State.CommandBlock.SCSICommandLength, &BytesProcessed) ==
@@ -198,6 +225,12 @@ static bool MS_Device_ReadInCommandBlock(USB_ClassInfo_MS_Device_t* const MSInte
 		if (MSInterfaceInfo->State.IsMassStoreReset)
 		  return false;
 	}
+
+	/* Drop the unused part of the command field, so that a data stage the host sent right
+	 * behind the command block is at the head of the endpoint's buffer */
+	Endpoint_Discard_Stream((16 - MSInterfaceInfo->State.CommandBlock.SCSICommandLength), NULL);
+	#endif
+
 	// for streaming, clear out later
 //	Endpoint_ClearOUT();
 
@@ -218,6 +251,12 @@ static void MS_Device_ReturnCommandStatus(USB_ClassInfo_MS_Device_t* const MSInt
 		  return;
 	}
 
+	#if defined(ENDPOINT_DMA_BUFFERS)
+	/* The next command block is lent before the status goes out, so it can never be staged */
+	Endpoint_StartDMA(&MSInterfaceInfo->State.CommandBlock, sizeof(MS_CommandBlockWrapper_t));
+	MSInterfaceInfo->State.IsCommandBlockQueued = true;
+	#endif
+
 	Endpoint_SelectEndpoint(MSInterfaceInfo->Config.DataINEndpointNumber);
 
 	while (Endpoint_IsStalled())
@@ -230,6 +269,9 @@ static void MS_Device_ReturnCommandStatus(USB_ClassInfo_MS_Device_t* const MSInt
 		  return;
 	}
 
+	#if defined(ENDPOINT_DMA_BUFFERS)
+	Endpoint_Write_DMA_Stream(&MSInterfaceInfo->State.CommandStatus, sizeof(MS_CommandStatusWrapper_t));
+	#else
 	uint16_t BytesProcessed = 0;
 	while (Endpoint_Write_Stream_LE(&MSInterfaceInfo->State.CommandStatus,
 	                                sizeof(MS_CommandStatusWrapper_t), &BytesProcessed) ==
@@ -240,6 +282,7 @@ static void MS_Device_ReturnCommandStatus(USB_ClassInfo_MS_Device_t* const MSInt
 	}
 	
 	Endpoint_ClearIN();
+	#endif
 }
 
 #endif
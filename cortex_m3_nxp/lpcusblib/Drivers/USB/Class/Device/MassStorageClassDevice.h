@@ -77,6 +77,10 @@
 			 *  Class state structure. An instance of this structure should be made for each Mass Storage interface
 			 *  within the user application, and passed to each of the Mass Storage class driver functions as the
 			 *  \c MSInterfaceInfo parameter. This stores each Mass Storage interface's configuration and state information.
+			 *
+			 *  \note Where the endpoints can be lent buffers (\c ENDPOINT_DMA_BUFFERS), the command blocks and statuses are moved
+			 *        straight between the host and this structure, which must then be placed in memory the USB DMA can reach
+			 *        (\c __DATA(USBRAM_SECTION) on the LPC17xx).
 			 */
 			typedef struct
 			{
@@ -98,15 +102,20 @@
 				           */
 				struct
 				{
-					MS_CommandBlockWrapper_t  CommandBlock; /**< Mass Storage class command block structure, stores the received SCSI
+					MS_CommandBlockWrapper_t  CommandBlock ATTR_ALIGNED(4); /**< Mass Storage class command block structure, stores the received SCSI
 															 *   command from the host which is to be processed.
 															 */
-					MS_CommandStatusWrapper_t CommandStatus; /**< Mass Storage class command status structure, set elements to indicate
+					MS_CommandStatusWrapper_t CommandStatus ATTR_ALIGNED(4); /**< Mass Storage class command status structure, set elements to indicate
 															  *   the issued command's success or failure to the host.
 															  */
 					volatile bool IsMassStoreReset; /**< Flag indicating that the host has requested that the Mass Storage interface be reset
 											         *   and that all current Mass Storage operations should immediately abort.
 											         */
+					#if defined(ENDPOINT_DMA_BUFFERS)
+					bool IsCommandBlockQueued; /**< Internal flag indicating that \c CommandBlock is lent to the data OUT endpoint for the
+					                            *   next command block.
+					                            */
+					#endif
 				} State; /**< State data for the USB class interface within the device. All elements in this section
 				          *   are reset to their defaults when the interface is enumerated.
 				          */
@@ -117,6 +117,14 @@ bool RNDIS_Device_ConfigureEndpoints(USB_ClassInfo_RNDIS_Device_t* const RNDISIn
 {
 	memset(&RNDISInterfaceInfo->State, 0x00, sizeof(RNDISInterfaceInfo->State));
 
+	RNDISInterfaceInfo->State.HostMaxTransferSize = sizeof(RNDIS_Packet_Message_t) + ETHERNET_FRAME_SIZE_MAX;
+
+	#if defined(ENDPOINT_DMA_BUFFERS)
+	uint8_t BufferIndex;
+	for (BufferIndex = 0; BufferIndex < RNDIS_DEVICE_FRAME_BUFFERS; BufferIndex++)
+	  RNDIS_Device_FreeBuffer(RNDISInterfaceInfo, BufferIndex);
+	#endif
+
 	uint8_t EndpointNum;
 	for (EndpointNum = 1; EndpointNum < ENDPOINT_TOTAL_ENDPOINTS; EndpointNum++)
 	{
@@ -185,6 +193,14 @@ void RNDIS_Device_USBTask(USB_ClassInfo_RNDIS_Device_t* const RNDISInterfaceInfo
 
 		RNDISInterfaceInfo->State.ResponseReady = false;
 	}
+
+	#if defined(ENDPOINT_DMA_BUFFERS)
+	if (RNDISInterfaceInfo->State.CurrRNDISState == RNDIS_Data_Initialized)
+	{
+		RNDIS_Device_ServiceTransmit(RNDISInterfaceInfo);
+		RNDIS_Device_LendReceiveBuffers(RNDISInterfaceInfo);
+	}
+	#endif
 }
 
 void RNDIS_Device_ProcessRNDISControlMessage(USB_ClassInfo_RNDIS_Device_t* const RNDISInterfaceInfo)
@@ -204,6 +220,9 @@ void RNDIS_Device_ProcessRNDISControlMessage(USB_ClassInfo_RNDIS_Device_t* const
 			RNDIS_Initialize_Complete_t* INITIALIZE_Response =
 			               (RNDIS_Initialize_Complete_t*)&RNDISInterfaceInfo->State.RNDISMessageBuffer;
 
+			/* Read before the response overwrites it: bounds the frames batched in one transfer to the host */
+			RNDISInterfaceInfo->State.HostMaxTransferSize = le32_to_cpu(INITIALIZE_Message->MaxTransferSize);
+
 			INITIALIZE_Response->MessageType            = CPU_TO_LE32(REMOTE_NDIS_INITIALIZE_CMPLT);
 			INITIALIZE_Response->MessageLength          = CPU_TO_LE32(sizeof(RNDIS_Initialize_Complete_t));
 			INITIALIZE_Response->RequestId              = INITIALIZE_Message->RequestId;
@@ -400,9 +419,24 @@ static bool RNDIS_Device_ProcessNDISQuery(USB_ClassInfo_RNDIS_Device_t* const RN
 
 			return true;
 		case OID_GEN_XMIT_OK:
+			*ResponseSize = sizeof(uint32_t);
+
+			*((uint32_t*)ResponseData) = cpu_to_le32(RNDISInterfaceInfo->State.FramesSent);
+
+			return true;
 		case OID_GEN_RCV_OK:
-		case OID_GEN_XMIT_ERROR:
+			*ResponseSize = sizeof(uint32_t);
+
+			*((uint32_t*)ResponseData) = cpu_to_le32(RNDISInterfaceInfo->State.FramesReceived);
+
+			return true;
 		case OID_GEN_RCV_ERROR:
+			*ResponseSize = sizeof(uint32_t);
+
+			*((uint32_t*)ResponseData) = cpu_to_le32(RNDISInterfaceInfo->State.ReceiveErrors);
+
+			return true;
+		case OID_GEN_XMIT_ERROR:
 		case OID_GEN_RCV_NO_BUFFER:
 		case OID_802_3_RCV_ERROR_ALIGNMENT:
 		case OID_802_3_XMIT_ONE_COLLISION:
@@ -458,7 +492,14 @@ bool RNDIS_Device_IsPacketReceived(USB_ClassInfo_RNDIS_Device_t* const RNDISInte
 	}
 	
 	Endpoint_SelectEndpoint(RNDISInterfaceInfo->Config.DataOUTEndpointNumber);
+
+	#if defined(ENDPOINT_DMA_BUFFERS)
+	RNDIS_Device_LendReceiveBuffers(RNDISInterfaceInfo);
+
+	return ((RNDISInterfaceInfo->State.Receive.Count > 1) && Endpoint_IsDMAComplete());
+	#else
 	return Endpoint_IsOUTReceived();
+	#endif
 }
 
 uint8_t RNDIS_Device_ReadPacket(USB_ClassInfo_RNDIS_Device_t* const RNDISInterfaceInfo,
@@ -475,6 +516,19 @@ uint8_t RNDIS_Device_ReadPacket(USB_ClassInfo_RNDIS_Device_t* const RNDISInterfa
 	
 	*PacketLength = 0;
 
+	#if defined(ENDPOINT_DMA_BUFFERS)
+	RNDIS_Device_Packet_t Packet;
+
+	if (!(RNDIS_Device_GetPacket(RNDISInterfaceInfo, &Packet)))
+		return ENDPOINT_RWSTREAM_NoError;
+
+	*PacketLength = Packet.Length;
+	memcpy(Buffer, Packet.Data, Packet.Length);
+
+	RNDIS_Device_ReleasePacket(RNDISInterfaceInfo, &Packet);
+
+	return ENDPOINT_RWSTREAM_NoError;
+	#else
 	if (!(Endpoint_IsOUTReceived()))
 		return ENDPOINT_RWSTREAM_NoError;
 
@@ -485,6 +539,7 @@ uint8_t RNDIS_Device_ReadPacket(USB_ClassInfo_RNDIS_Device_t* const RNDISInterfa
 	{
 		Endpoint_StallTransaction();
 
+		RNDISInterfaceInfo->State.ReceiveErrors++;
 		return RNDIS_ERROR_LOGICAL_CMD_FAILED;
 	}
 	
@@ -493,7 +548,9 @@ uint8_t RNDIS_Device_ReadPacket(USB_ClassInfo_RNDIS_Device_t* const RNDISInterfa
 	Endpoint_Read_Stream_LE(Buffer, *PacketLength, NULL);
 	Endpoint_ClearOUT();
 	
+	RNDISInterfaceInfo->State.FramesReceived++;
 	return ENDPOINT_RWSTREAM_NoError;
+	#endif
 }
 
 uint8_t RNDIS_Device_SendPacket(USB_ClassInfo_RNDIS_Device_t* const RNDISInterfaceInfo,
@@ -510,6 +567,41 @@ uint8_t RNDIS_Device_SendPacket(USB_ClassInfo_RNDIS_Device_t* const RNDISInterfa
 	
 	Endpoint_SelectEndpoint(RNDISInterfaceInfo->Config.DataINEndpointNumber);
 
+	#if defined(ENDPOINT_DMA_BUFFERS)
+	RNDIS_Device_Packet_t Packet;
+
+	if (PacketLength > ETHERNET_FRAME_SIZE_MAX)
+	  return RNDIS_ERROR_LOGICAL_CMD_FAILED;
+
+	/* With the pool in use, wait for the oldest frame lent to the data IN endpoint to be sent */
+	while (!(RNDIS_Device_AllocPacket(RNDISInterfaceInfo, &Packet)))
+	{
+		RNDIS_Device_ServiceTransmit(RNDISInterfaceInfo);
+
+		if (!(RNDISInterfaceInfo->State.Transmit.LentCount))
+		  return ENDPOINT_RWSTREAM_IncompleteTransfer;
+
+		Endpoint_SelectEndpoint(RNDISInterfaceInfo->Config.DataINEndpointNumber);
+
+		if ((ErrorCode = Endpoint_WaitDMA(NULL)) != ENDPOINT_RWSTREAM_NoError)
+		{
+			/* Every transfer queued on the endpoint has been dropped */
+			while (RNDISInterfaceInfo->State.Transmit.LentCount)
+			  RNDIS_Device_FreeBuffer(RNDISInterfaceInfo, RNDIS_Device_PopTransmitLent(RNDISInterfaceInfo));
+
+			RNDISInterfaceInfo->State.Transmit.BatchLength = 0;
+			return ErrorCode;
+		}
+
+		RNDIS_Device_FreeBuffer(RNDISInterfaceInfo, RNDIS_Device_PopTransmitLent(RNDISInterfaceInfo));
+		RNDISInterfaceInfo->State.FramesSent++;
+	}
+
+	memcpy(Packet.Data, Buffer, PacketLength);
+	Packet.Length = PacketLength;
+
+	return RNDIS_Device_QueuePacket(RNDISInterfaceInfo, &Packet);
+	#else
 	if ((ErrorCode = Endpoint_WaitUntilReady()) != ENDPOINT_READYWAIT_NoError)
 	  return ErrorCode;
 
@@ -526,8 +618,225 @@ uint8_t RNDIS_Device_SendPacket(USB_ClassInfo_RNDIS_Device_t* const RNDISInterfa
 	Endpoint_Write_Stream_LE(Buffer, PacketLength, NULL);
 	Endpoint_ClearIN();
 
+	RNDISInterfaceInfo->State.FramesSent++;
+	return ENDPOINT_RWSTREAM_NoError;
+	#endif
+}
+
+#if defined(ENDPOINT_DMA_BUFFERS)
+bool RNDIS_Device_GetPacket(USB_ClassInfo_RNDIS_Device_t* const RNDISInterfaceInfo,
+                            RNDIS_Device_Packet_t* const Packet)
+{
+	if ((USB_DeviceState != DEVICE_STATE_Configured) ||
+	    (RNDISInterfaceInfo->State.CurrRNDISState != RNDIS_Data_Initialized))
+	{
+		return false;
+	}
+
+	for (;;)
+	{
+		/* The last buffer lent is only taken back once another is lent behind it: with no transfer queued the
+		 * controller driver would stage the next packets itself, regardless of where the messages end */
+		RNDIS_Device_LendReceiveBuffers(RNDISInterfaceInfo);
+
+		if ((RNDISInterfaceInfo->State.Receive.Count < 2) || !(Endpoint_IsDMAComplete()))
+		  return false;
+
+		uint8_t  BufferIndex   = RNDISInterfaceInfo->State.Receive.Lent[RNDISInterfaceInfo->State.Receive.Head];
+		uint16_t MessageLength = Endpoint_ReleaseDMA();
+
+		RNDISInterfaceInfo->State.Receive.Head = (RNDISInterfaceInfo->State.Receive.Head + 1) % RNDIS_DEVICE_FRAME_BUFFERS;
+		RNDISInterfaceInfo->State.Receive.Count--;
+
+		/* A zero length packet ending a transfer on its own is no message */
+		if (!(MessageLength))
+		{
+			RNDIS_Device_FreeBuffer(RNDISInterfaceInfo, BufferIndex);
+			continue;
+		}
+
+		RNDIS_Packet_Message_t* RNDISPacketMessage = (RNDIS_Packet_Message_t*)RNDISInterfaceInfo->State.FrameBuffer[BufferIndex];
+		uint32_t DataOffset = le32_to_cpu(RNDISPacketMessage->DataOffset) + sizeof(RNDIS_Message_Header_t);
+		uint32_t DataLength = le32_to_cpu(RNDISPacketMessage->DataLength);
+
+		/* A malformed message, or the tail of one too long for its buffer, is dropped and the next buffer taken */
+		if ((MessageLength < sizeof(RNDIS_Packet_Message_t)) ||
+		    (le32_to_cpu(RNDISPacketMessage->MessageType) != REMOTE_NDIS_PACKET_MSG) ||
+		    (DataLength > ETHERNET_FRAME_SIZE_MAX) || (DataOffset > MessageLength) ||
+		    (DataLength > (MessageLength - DataOffset)))
+		{
+			RNDISInterfaceInfo->State.ReceiveErrors++;
+			RNDIS_Device_FreeBuffer(RNDISInterfaceInfo, BufferIndex);
+			continue;
+		}
+
+		Packet->Data        = &RNDISInterfaceInfo->State.FrameBuffer[BufferIndex][DataOffset];
+		Packet->Length      = (uint16_t)DataLength;
+		Packet->BufferIndex = BufferIndex;
+
+		RNDISInterfaceInfo->State.FramesReceived++;
+		return true;
+	}
+}
+
+bool RNDIS_Device_AllocPacket(USB_ClassInfo_RNDIS_Device_t* const RNDISInterfaceInfo,
+                              RNDIS_Device_Packet_t* const Packet)
+{
+	if (!(RNDISInterfaceInfo->State.FreeCount))
+	  return false;
+
+	Packet->BufferIndex = RNDISInterfaceInfo->State.Free[--RNDISInterfaceInfo->State.FreeCount];
+	Packet->Data        = &RNDISInterfaceInfo->State.FrameBuffer[Packet->BufferIndex][sizeof(RNDIS_Packet_Message_t)];
+	Packet->Length      = 0;
+
+	return true;
+}
+
+uint8_t RNDIS_Device_QueuePacket(USB_ClassInfo_RNDIS_Device_t* const RNDISInterfaceInfo,
+                                 const RNDIS_Device_Packet_t* const Packet)
+{
+	uint8_t* FrameBuffer = RNDISInterfaceInfo->State.FrameBuffer[Packet->BufferIndex];
+	uint32_t DataOffset  = (uint32_t)(Packet->Data - FrameBuffer);
+
+	if ((USB_DeviceState != DEVICE_STATE_Configured) ||
+	    (RNDISInterfaceInfo->State.CurrRNDISState != RNDIS_Data_Initialized))
+	{
+		RNDIS_Device_ReleasePacket(RNDISInterfaceInfo, Packet);
+		return ENDPOINT_RWSTREAM_DeviceDisconnected;
+	}
+
+	/* The header goes in front of the frame, and a byte of padding may follow it (see RNDIS_Device_ServiceTransmit()) */
+	if ((Packet->Length > ETHERNET_FRAME_SIZE_MAX) || (DataOffset < sizeof(RNDIS_Packet_Message_t)) ||
+	    ((DataOffset + Packet->Length) >= RNDIS_DEVICE_FRAME_BUFFER_SIZE))
+	{
+		RNDIS_Device_ReleasePacket(RNDISInterfaceInfo, Packet);
+		return RNDIS_ERROR_LOGICAL_CMD_FAILED;
+	}
+
+	RNDIS_Packet_Message_t* RNDISPacketMessage = (RNDIS_Packet_Message_t*)FrameBuffer;
+
+	memset(RNDISPacketMessage, 0, sizeof(RNDIS_Packet_Message_t));
+
+	RNDISPacketMessage->MessageType   = CPU_TO_LE32(REMOTE_NDIS_PACKET_MSG);
+	RNDISPacketMessage->MessageLength = cpu_to_le32(DataOffset + Packet->Length);
+	RNDISPacketMessage->DataOffset    = cpu_to_le32(DataOffset - sizeof(RNDIS_Message_Header_t));
+	RNDISPacketMessage->DataLength    = cpu_to_le32(Packet->Length);
+
+	RNDISInterfaceInfo->State.Transmit.Pending[(RNDISInterfaceInfo->State.Transmit.PendingHead +
+	                                            RNDISInterfaceInfo->State.Transmit.PendingCount) % RNDIS_DEVICE_FRAME_BUFFERS] = Packet->BufferIndex;
+	RNDISInterfaceInfo->State.Transmit.PendingCount++;
+
 	return ENDPOINT_RWSTREAM_NoError;
 }
 
+void RNDIS_Device_ReleasePacket(USB_ClassInfo_RNDIS_Device_t* const RNDISInterfaceInfo,
+                                const RNDIS_Device_Packet_t* const Packet)
+{
+	RNDIS_Device_FreeBuffer(RNDISInterfaceInfo, Packet->BufferIndex);
+}
+
+static void RNDIS_Device_FreeBuffer(USB_ClassInfo_RNDIS_Device_t* const RNDISInterfaceInfo,
+                                    const uint8_t BufferIndex)
+{
+	RNDISInterfaceInfo->State.Free[RNDISInterfaceInfo->State.FreeCount++] = BufferIndex;
+}
+
+static uint8_t RNDIS_Device_PopTransmitLent(USB_ClassInfo_RNDIS_Device_t* const RNDISInterfaceInfo)
+{
+	uint8_t BufferIndex = RNDISInterfaceInfo->State.Transmit.Lent[RNDISInterfaceInfo->State.Transmit.LentHead];
+
+	RNDISInterfaceInfo->State.Transmit.LentHead = (RNDISInterfaceInfo->State.Transmit.LentHead + 1) % RNDIS_DEVICE_FRAME_BUFFERS;
+	RNDISInterfaceInfo->State.Transmit.LentCount--;
+
+	return BufferIndex;
+}
+
+/* Length of the packet message in a frame buffer, from the header RNDIS_Device_QueuePacket() wrote */
+static uint32_t RNDIS_Device_MessageLength(USB_ClassInfo_RNDIS_Device_t* const RNDISInterfaceInfo,
+                                           const uint8_t BufferIndex)
+{
+	RNDIS_Packet_Message_t* RNDISPacketMessage = (RNDIS_Packet_Message_t*)RNDISInterfaceInfo->State.FrameBuffer[BufferIndex];
+
+	return sizeof(RNDIS_Message_Header_t) + le32_to_cpu(RNDISPacketMessage->DataOffset) +
+	       le32_to_cpu(RNDISPacketMessage->DataLength);
+}
+
+static void RNDIS_Device_ServiceTransmit(USB_ClassInfo_RNDIS_Device_t* const RNDISInterfaceInfo)
+{
+	uint16_t EndpointSize = RNDISInterfaceInfo->Config.DataINEndpointSize;
+
+	Endpoint_SelectEndpoint(RNDISInterfaceInfo->Config.DataINEndpointNumber);
+
+	while (RNDISInterfaceInfo->State.Transmit.LentCount && Endpoint_IsDMAComplete())
+	{
+		Endpoint_ReleaseDMA();
+
+		RNDIS_Device_FreeBuffer(RNDISInterfaceInfo, RNDIS_Device_PopTransmitLent(RNDISInterfaceInfo));
+		RNDISInterfaceInfo->State.FramesSent++;
+	}
+
+	/* A bulk IN transfer only ends on a short packet, so the frames queued together are batched into one by padding
+	 * every message but the last to whole packets; the chained DMA descriptors carry the transfer from one frame buffer
+	 * to the next. The last message gets a byte of padding instead if it would end on a whole packet, which spares the
+	 * zero length packet. */
+	while (RNDISInterfaceInfo->State.Transmit.PendingCount)
+	{
+		uint8_t  BufferIndex   = RNDISInterfaceInfo->State.Transmit.Pending[RNDISInterfaceInfo->State.Transmit.PendingHead];
+		uint32_t MessageLength = RNDIS_Device_MessageLength(RNDISInterfaceInfo, BufferIndex);
+		uint32_t PaddedLength  = ((MessageLength + EndpointSize - 1) / EndpointSize) * EndpointSize;
+		uint32_t BatchLength   = RNDISInterfaceInfo->State.Transmit.BatchLength;
+
+		if ((RNDISInterfaceInfo->State.Transmit.PendingCount > 1) && (PaddedLength <= RNDIS_DEVICE_FRAME_BUFFER_SIZE) &&
+		    ((BatchLength + PaddedLength + RNDIS_Device_MessageLength(RNDISInterfaceInfo,
+		          RNDISInterfaceInfo->State.Transmit.Pending[(RNDISInterfaceInfo->State.Transmit.PendingHead + 1) %
+		                                                     RNDIS_DEVICE_FRAME_BUFFERS])) < RNDISInterfaceInfo->State.HostMaxTransferSize))
+		{
+			MessageLength = PaddedLength;
+			BatchLength  += PaddedLength;
+		}
+		else
+		{
+			if (!(MessageLength % EndpointSize))
+			  MessageLength++;
+
+			BatchLength = 0;
+		}
+
+		((RNDIS_Packet_Message_t*)RNDISInterfaceInfo->State.FrameBuffer[BufferIndex])->MessageLength = cpu_to_le32(MessageLength);
+
+		if (!(Endpoint_StartDMA(RNDISInterfaceInfo->State.FrameBuffer[BufferIndex], MessageLength)))
+		  break;
+
+		RNDISInterfaceInfo->State.Transmit.BatchLength = BatchLength;
+		RNDISInterfaceInfo->State.Transmit.PendingHead = (RNDISInterfaceInfo->State.Transmit.PendingHead + 1) % RNDIS_DEVICE_FRAME_BUFFERS;
+		RNDISInterfaceInfo->State.Transmit.PendingCount--;
+
+		RNDISInterfaceInfo->State.Transmit.Lent[(RNDISInterfaceInfo->State.Transmit.LentHead +
+		                                         RNDISInterfaceInfo->State.Transmit.LentCount) % RNDIS_DEVICE_FRAME_BUFFERS] = BufferIndex;
+		RNDISInterfaceInfo->State.Transmit.LentCount++;
+	}
+}
+
+static void RNDIS_Device_LendReceiveBuffers(USB_ClassInfo_RNDIS_Device_t* const RNDISInterfaceInfo)
+{
+	Endpoint_SelectEndpoint(RNDISInterfaceInfo->Config.DataOUTEndpointNumber);
+
+	/* The other half of the pool stays for the frames being processed and sent */
+	while (RNDISInterfaceInfo->State.FreeCount &&
+	       (RNDISInterfaceInfo->State.Receive.Count < (RNDIS_DEVICE_FRAME_BUFFERS / 2)))
+	{
+		uint8_t BufferIndex = RNDISInterfaceInfo->State.Free[RNDISInterfaceInfo->State.FreeCount - 1];
+
+		if (!(Endpoint_StartDMA(RNDISInterfaceInfo->State.FrameBuffer[BufferIndex], RNDIS_DEVICE_FRAME_BUFFER_SIZE)))
+		  break;
+
+		RNDISInterfaceInfo->State.FreeCount--;
+		RNDISInterfaceInfo->State.Receive.Lent[(RNDISInterfaceInfo->State.Receive.Head +
+		                                        RNDISInterfaceInfo->State.Receive.Count) % RNDIS_DEVICE_FRAME_BUFFERS] = BufferIndex;
+		RNDISInterfaceInfo->State.Receive.Count++;
+	}
+}
+#endif
+
 #endif
 
@@ -71,12 +71,43 @@
 		#endif
 
 	/* Public Interface - May be used in end-application: */
+		/* Macros: */
+			#if !defined(RNDIS_DEVICE_FRAME_BUFFERS) || defined(__DOXYGEN__)
+				/** Number of frame buffers in the pool of an RNDIS interface, where the endpoints can be lent buffers
+				 *  (\c ENDPOINT_DMA_BUFFERS). The pool is shared by the frames being received, those handed to the
+				 *  application and those queued for sending; the receive side takes at most half of it. From 4 to 32.
+				 */
+				#define RNDIS_DEVICE_FRAME_BUFFERS       8
+			#endif
+
+			/** Size in bytes of each frame buffer of the pool: a packet message with an Ethernet frame of up to
+			 *  \ref ETHERNET_FRAME_SIZE_MAX bytes, rounded up to whole packets of a full speed bulk endpoint.
+			 */
+			#define RNDIS_DEVICE_FRAME_BUFFER_SIZE       (((sizeof(RNDIS_Packet_Message_t) + ETHERNET_FRAME_SIZE_MAX) + 63) & ~63)
+
 		/* Type Defines: */
+			/** \brief RNDIS Class Device Mode Packet.
+			 *
+			 *  Ethernet frame in a buffer of the frame pool of an RNDIS interface. Frames are handed out by
+			 *  \ref RNDIS_Device_GetPacket() or \ref RNDIS_Device_AllocPacket() and stay in their buffer until given to
+			 *  \ref RNDIS_Device_QueuePacket() or back with \ref RNDIS_Device_ReleasePacket().
+			 */
+			typedef struct
+			{
+				uint8_t* Data; /**< First byte of the Ethernet frame, within its frame buffer. */
+				uint16_t Length; /**< Length in bytes of the Ethernet frame. */
+				uint8_t  BufferIndex; /**< Frame buffer holding the frame. */
+			} RNDIS_Device_Packet_t;
+
 			/** \brief RNDIS Class Device Mode Configuration and State Structure.
 			 *
 			 *  Class state structure. An instance of this structure should be made for each RNDIS interface
 			 *  within the user application, and passed to each of the RNDIS class driver functions as the
 			 *  \c RNDISInterfaceInfo parameter. This stores each RNDIS interface's configuration and state information.
+			 *
+			 *  \note Where the endpoints can be lent buffers (\c ENDPOINT_DMA_BUFFERS), whole packet messages are moved
+			 *        between the host and the frame pool in this structure, which must then be placed in memory the USB DMA
+			 *        can reach (\c __DATA(USBRAM_SECTION) on the LPC17xx).
 			 */
 			typedef struct
 			{
@@ -109,6 +140,37 @@
 					bool     ResponseReady; /**< Internal flag indicating if a RNDIS message is waiting to be returned to the host. */
 					uint8_t  CurrRNDISState; /**< Current RNDIS state of the adapter, a value from the \ref RNDIS_States_t enum. */
 					uint32_t CurrPacketFilter; /**< Current packet filter mode, used internally by the class driver. */
+					uint32_t HostMaxTransferSize; /**< Maximum length in bytes of a transfer to the host, from its initialize message. */
+					uint32_t FramesReceived; /**< Frames received from the host, reported as \c OID_GEN_RCV_OK. */
+					uint32_t FramesSent; /**< Frames sent to the host, reported as \c OID_GEN_XMIT_OK. */
+					uint32_t ReceiveErrors; /**< Malformed packet messages dropped, reported as \c OID_GEN_RCV_ERROR. */
+					#if defined(ENDPOINT_DMA_BUFFERS)
+					uint8_t  FrameBuffer[RNDIS_DEVICE_FRAME_BUFFERS][RNDIS_DEVICE_FRAME_BUFFER_SIZE] ATTR_ALIGNED(4); /**< Frame pool,
+					                                                                   *   each buffer holding one packet message.
+					                                                                   */
+					uint8_t  Free[RNDIS_DEVICE_FRAME_BUFFERS]; /**< Stack of the frame buffers not in use. */
+					uint8_t  FreeCount; /**< Number of frame buffers in \c Free. */
+
+					struct
+					{
+						uint8_t Lent[RNDIS_DEVICE_FRAME_BUFFERS]; /**< Frame buffers lent to the data OUT endpoint, oldest first. */
+						uint8_t Head; /**< Index in \c Lent of the oldest buffer. */
+						uint8_t Count; /**< Number of buffers in \c Lent. */
+					} Receive; /**< Receive side of the frame pool, managed by the class driver. */
+
+					struct
+					{
+						uint8_t  Pending[RNDIS_DEVICE_FRAME_BUFFERS]; /**< Frame buffers queued by \ref RNDIS_Device_QueuePacket(),
+						                                               *   oldest first.
+						                                               */
+						uint8_t  PendingHead; /**< Index in \c Pending of the oldest buffer. */
+						uint8_t  PendingCount; /**< Number of buffers in \c Pending. */
+						uint8_t  Lent[RNDIS_DEVICE_FRAME_BUFFERS]; /**< Frame buffers lent to the data IN endpoint, oldest first. */
+						uint8_t  LentHead; /**< Index in \c Lent of the oldest buffer. */
+						uint8_t  LentCount; /**< Number of buffers in \c Lent. */
+						uint32_t BatchLength; /**< Bytes of the bulk IN transfer in progress, 0 once its last message is lent. */
+					} Transmit; /**< Transmit side of the frame pool, managed by the class driver. */
+					#endif
 				} State; /**< State data for the USB class interface within the device. All elements in this section
 				          *   are reset to their defaults when the interface is enumerated.
 				          */
@@ -135,6 +197,11 @@
 			/** General management task for a given RNDIS class interface, required for the correct operation of the interface. This should
 			 *  be called frequently in the main program loop, before the master USB management task \ref USB_USBTask().
 			 *
+			 *  Where the endpoints can be lent buffers (\c ENDPOINT_DMA_BUFFERS), this is where the frame pool moves: buffers sent
+			 *  to the host go back to the pool, free buffers are lent to the data OUT endpoint, and the frames queued with
+			 *  \ref RNDIS_Device_QueuePacket() are lent to the data IN endpoint. Frames queued together go out as one bulk transfer,
+			 *  every message but the last padded to whole packets, up to the maximum transfer size of the host.
+			 *
 			 *  \param[in,out] RNDISInterfaceInfo  Pointer to a structure containing a RNDIS Class configuration and state.
 			 */
 			void RNDIS_Device_USBTask(USB_ClassInfo_RNDIS_Device_t* const RNDISInterfaceInfo) ATTR_NON_NULL_PTR_ARG(1);
@@ -167,6 +234,10 @@
 											uint16_t* const PacketLength);
 
 			/** Sends the given packet to the attached RNDIS device, after adding a RNDIS packet message header.
+			 *
+			 *  \note With \c ENDPOINT_DMA_BUFFERS defined, the packet is copied into a frame buffer of the pool and queued
+			 *        as by \ref RNDIS_Device_QueuePacket(), so that \ref RNDIS_Device_USBTask() sends it; this only waits
+			 *        when every buffer of the pool is in use.
 			 *
 			 *  \pre This function must only be called when the Device state machine is in the \ref DEVICE_STATE_Configured state or the
 			 *       call will fail.
@@ -181,6 +252,59 @@
 											void* Buffer,
 											const uint16_t PacketLength);
 
+			#if defined(ENDPOINT_DMA_BUFFERS) || defined(__DOXYGEN__)
+			/** Hands out the next Ethernet frame received from the host, in place in the frame buffer the DMA received it into.
+			 *  Several frames may be held at the same time; each must be given to \ref RNDIS_Device_QueuePacket() (to send it back
+			 *  changed, as a reply) or back with \ref RNDIS_Device_ReleasePacket() once processed. Does not block.
+			 *
+			 *  \pre This function must only be called when the Device state machine is in the \ref DEVICE_STATE_Configured state or the
+			 *       call will fail.
+			 *
+			 *  \param[in,out] RNDISInterfaceInfo  Pointer to a structure containing an RNDIS Class configuration and state.
+			 *  \param[out]    Packet              Pointer to where the received frame is described.
+			 *
+			 *  \return Boolean \c true if a frame was handed out, \c false if none is waiting.
+			 */
+			bool RNDIS_Device_GetPacket(USB_ClassInfo_RNDIS_Device_t* const RNDISInterfaceInfo,
+			                            RNDIS_Device_Packet_t* const Packet) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2);
+
+			/** Takes a free frame buffer from the pool, for a frame to be built in place and queued with
+			 *  \ref RNDIS_Device_QueuePacket(). There is room for \ref ETHERNET_FRAME_SIZE_MAX bytes at \c Packet->Data.
+			 *
+			 *  \param[in,out] RNDISInterfaceInfo  Pointer to a structure containing an RNDIS Class configuration and state.
+			 *  \param[out]    Packet              Pointer to where the frame buffer is described, with a \c Length of 0.
+			 *
+			 *  \return Boolean \c true if a buffer was taken, \c false if the pool is empty.
+			 */
+			bool RNDIS_Device_AllocPacket(USB_ClassInfo_RNDIS_Device_t* const RNDISInterfaceInfo,
+			                              RNDIS_Device_Packet_t* const Packet) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2);
+
+			/** Queues a frame for sending to the host by reference: the RNDIS packet header is written in front of it in its
+			 *  frame buffer, and \ref RNDIS_Device_USBTask() lends the buffer to the data IN endpoint, which returns it to the pool
+			 *  once sent. The frame must not be touched afterwards. Does not block.
+			 *
+			 *  \pre This function must only be called when the Device state machine is in the \ref DEVICE_STATE_Configured state or the
+			 *       call will fail.
+			 *
+			 *  \param[in,out] RNDISInterfaceInfo  Pointer to a structure containing an RNDIS Class configuration and state.
+			 *  \param[in]     Packet              Frame to send, handed out by \ref RNDIS_Device_GetPacket() or
+			 *                                     \ref RNDIS_Device_AllocPacket(), with \c Data and \c Length describing the frame.
+			 *
+			 *  \return A value from the \ref Endpoint_Stream_RW_ErrorCodes_t enum; the buffer goes back to the pool on error.
+			 */
+			uint8_t RNDIS_Device_QueuePacket(USB_ClassInfo_RNDIS_Device_t* const RNDISInterfaceInfo,
+			                                 const RNDIS_Device_Packet_t* const Packet) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2);
+
+			/** Gives back a frame handed out by \ref RNDIS_Device_GetPacket() or \ref RNDIS_Device_AllocPacket() without sending
+			 *  it, returning its buffer to the pool.
+			 *
+			 *  \param[in,out] RNDISInterfaceInfo  Pointer to a structure containing an RNDIS Class configuration and state.
+			 *  \param[in]     Packet              Frame to release.
+			 */
+			void RNDIS_Device_ReleasePacket(USB_ClassInfo_RNDIS_Device_t* const RNDISInterfaceInfo,
+			                                const RNDIS_Device_Packet_t* const Packet) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2);
+			#endif
+
 	/* Private Interface - For use in library only: */
 	#if !defined(__DOXYGEN__)
 		/* Function Prototypes: */
@@ -199,6 +323,19 @@
 			                                        const void* SetData,
                                                     const uint16_t SetSize) ATTR_NON_NULL_PTR_ARG(1)
 			                                        ATTR_NON_NULL_PTR_ARG(3);
+
+			#if defined(ENDPOINT_DMA_BUFFERS)
+			static void RNDIS_Device_FreeBuffer(USB_ClassInfo_RNDIS_Device_t* const RNDISInterfaceInfo,
+			                                    const uint8_t BufferIndex) ATTR_NON_NULL_PTR_ARG(1);
+			static uint8_t RNDIS_Device_PopTransmitLent(USB_ClassInfo_RNDIS_Device_t* const RNDISInterfaceInfo)
+			                                            ATTR_NON_NULL_PTR_ARG(1);
+			static uint32_t RNDIS_Device_MessageLength(USB_ClassInfo_RNDIS_Device_t* const RNDISInterfaceInfo,
+			                                           const uint8_t BufferIndex) ATTR_NON_NULL_PTR_ARG(1);
+			static void RNDIS_Device_ServiceTransmit(USB_ClassInfo_RNDIS_Device_t* const RNDISInterfaceInfo)
+			                                         ATTR_NON_NULL_PTR_ARG(1);
+			static void RNDIS_Device_LendReceiveBuffers(USB_ClassInfo_RNDIS_Device_t* const RNDISInterfaceInfo)
+			                                            ATTR_NON_NULL_PTR_ARG(1);
+			#endif
 		#endif
 
 	#endif
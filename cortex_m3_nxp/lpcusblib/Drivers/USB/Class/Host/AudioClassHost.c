@@ -45,6 +45,8 @@ uint8_t Audio_Host_ConfigurePipes(USB_ClassInfo_Audio_Host_t* const AudioInterfa
 {
 	USB_Descriptor_Endpoint_t*  DataINEndpoint          = NULL;
 	USB_Descriptor_Endpoint_t*  DataOUTEndpoint         = NULL;
+	USB_Descriptor_Endpoint_t*  FeedbackEndpoint        = NULL;
+	uint8_t                     SyncEndpointAddress     = 0;
 	USB_Descriptor_Interface_t* AudioControlInterface   = NULL;
 	USB_Descriptor_Interface_t* AudioStreamingInterface = NULL;
 	uint8_t portnum = AudioInterfaceInfo->Config.PortNumber;
@@ -55,7 +57,8 @@ uint8_t Audio_Host_ConfigurePipes(USB_ClassInfo_Audio_Host_t* const AudioInterfa
 	  return AUDIO_ENUMERROR_InvalidConfigDescriptor;
 
 	while ((AudioInterfaceInfo->Config.DataINPipeNumber  && !(DataINEndpoint)) ||
-	       (AudioInterfaceInfo->Config.DataOUTPipeNumber && !(DataOUTEndpoint)))
+	       (AudioInterfaceInfo->Config.DataOUTPipeNumber && !(DataOUTEndpoint)) ||
+	       (SyncEndpointAddress && !(FeedbackEndpoint)))
 	{
 		if (!(AudioControlInterface) ||
 		    USB_GetNextDescriptorComp(&ConfigDescriptorSize, &ConfigDescriptorData,
@@ -82,18 +85,37 @@ uint8_t Audio_Host_ConfigurePipes(USB_ClassInfo_Audio_Host_t* const AudioInterfa
 
 			AudioStreamingInterface = DESCRIPTOR_PCAST(ConfigDescriptorData, USB_Descriptor_Interface_t);
 			
-			DataINEndpoint  = NULL;
-			DataOUTEndpoint = NULL;
+			DataINEndpoint      = NULL;
+			DataOUTEndpoint     = NULL;
+			FeedbackEndpoint    = NULL;
+			SyncEndpointAddress = 0;
 
 			continue;
 		}
 
 		USB_Descriptor_Endpoint_t* EndpointData = DESCRIPTOR_PCAST(ConfigDescriptorData, USB_Descriptor_Endpoint_t);
 
-		if ((EndpointData->EndpointAddress & ENDPOINT_DIR_MASK) == ENDPOINT_DIR_IN)
-		  DataINEndpoint  = EndpointData;
+		/* Feedback endpoints are tagged as such (USB 2.0) or named by the bSynchAddress of their asynchronous OUT data endpoint (Audio 1.0) */
+		if (((EndpointData->Attributes & (ENDPOINT_USAGE_FEEDBACK | ENDPOINT_USAGE_IMPLICIT_FEEDBACK)) == ENDPOINT_USAGE_FEEDBACK) ||
+		    (SyncEndpointAddress && (EndpointData->EndpointAddress == SyncEndpointAddress)))
+		{
+			FeedbackEndpoint = EndpointData;
+		}
+		else if ((EndpointData->EndpointAddress & ENDPOINT_DIR_MASK) == ENDPOINT_DIR_IN)
+		{
+			DataINEndpoint  = EndpointData;
+		}
 		else
-		  DataOUTEndpoint = EndpointData;
+		{
+			DataOUTEndpoint = EndpointData;
+
+			if (AudioInterfaceInfo->Config.FeedbackPipeNumber &&
+			    ((EndpointData->Attributes & ENDPOINT_ATTR_SYNC) == ENDPOINT_ATTR_ASYNC) &&
+			    (EndpointData->Header.Size >= sizeof(USB_Audio_Descriptor_StreamEndpoint_Std_t)))
+			{
+				SyncEndpointAddress = DESCRIPTOR_PCAST(EndpointData, USB_Audio_Descriptor_StreamEndpoint_Std_t)->SyncEndpointNumber;
+			}
+		}
 	}
 
 	uint8_t PipeNum;
@@ -125,6 +147,26 @@ uint8_t Audio_Host_ConfigurePipes(USB_ClassInfo_Audio_Host_t* const AudioInterfa
 
 			AudioInterfaceInfo->State.DataOUTPipeSize = DataOUTEndpoint->EndpointSize;
 		}
+		else if ((PipeNum == AudioInterfaceInfo->Config.FeedbackPipeNumber) && FeedbackEndpoint)
+		{
+			Size            = le16_to_cpu(FeedbackEndpoint->EndpointSize);
+			EndpointAddress = FeedbackEndpoint->EndpointAddress;
+			Token           = PIPE_TOKEN_IN;
+			Type            = EP_TYPE_ISOCHRONOUS;
+			DoubleBanked    = false;
+
+			if (FeedbackEndpoint->Header.Size >= sizeof(USB_Audio_Descriptor_StreamEndpoint_Std_t) &&
+			    DESCRIPTOR_PCAST(FeedbackEndpoint, USB_Audio_Descriptor_StreamEndpoint_Std_t)->Refresh)
+			{
+				AudioInterfaceInfo->State.FeedbackRefresh = DESCRIPTOR_PCAST(FeedbackEndpoint, USB_Audio_Descriptor_StreamEndpoint_Std_t)->Refresh;
+			}
+			else if (FeedbackEndpoint->PollingIntervalMS)
+			{
+				AudioInterfaceInfo->State.FeedbackRefresh = FeedbackEndpoint->PollingIntervalMS - 1;
+			}
+			AudioInterfaceInfo->State.FeedbackRefresh = MIN(AudioInterfaceInfo->State.FeedbackRefresh, 9);
+			AudioInterfaceInfo->State.FeedbackPipeSize = Size;
+		}
 		else
 		{
 			continue;
@@ -135,6 +177,12 @@ uint8_t Audio_Host_ConfigurePipes(USB_ClassInfo_Audio_Host_t* const AudioInterfa
 		{
 			return AUDIO_ENUMERROR_PipeConfigurationFailed;
 		}
+
+		if ((PipeNum == AudioInterfaceInfo->Config.FeedbackPipeNumber) &&
+		    !(Pipe_SetIsochronousInterval(portnum, AudioInterfaceInfo->State.FeedbackRefresh + 1)))
+		{
+			return AUDIO_ENUMERROR_PipeConfigurationFailed;
+		}
 	}
 
 	AudioInterfaceInfo->State.ControlInterfaceNumber    = AudioControlInterface->InterfaceNumber;
@@ -249,5 +297,357 @@ uint8_t Audio_Host_GetSetEndpointProperty(USB_ClassInfo_Audio_Host_t* const Audi
 	return USB_Host_SendControlRequest(portnum,Data);
 }
 
+static Audio_Host_Stream_t* Audio_Host_Streams[AUDIO_HOST_MAX_STREAMS];
+
+uint8_t Audio_Host_StartStream(USB_ClassInfo_Audio_Host_t* const AudioInterfaceInfo,
+                               const uint8_t DataPipeIndex,
+                               Audio_Host_Stream_t* const Stream,
+                               uint8_t* const FIFO,
+                               const uint16_t FIFOSize,
+                               const uint32_t SampleRate,
+                               const uint8_t SampleFrameSize)
+{
+	uint8_t  portnum = AudioInterfaceInfo->Config.PortNumber;
+	uint16_t PacketLength[AUDIO_HOST_STREAM_FRAMES];
+	uint8_t  Slot;
+	uint8_t  i;
+
+	if ((USB_HostState[portnum] != HOST_STATE_Configured) || !(AudioInterfaceInfo->State.IsActive))
+	  return AUDIO_STREAM_DeviceDisconnected;
+
+	memset(Stream, 0x00, sizeof(Audio_Host_Stream_t));
+
+	if (DataPipeIndex && (DataPipeIndex == AudioInterfaceInfo->Config.DataINPipeNumber))
+	{
+		Stream->PacketSize = AudioInterfaceInfo->State.DataINPipeSize;
+	}
+	else if (DataPipeIndex && (DataPipeIndex == AudioInterfaceInfo->Config.DataOUTPipeNumber))
+	{
+		Stream->IsOutput   = true;
+		Stream->PacketSize = AudioInterfaceInfo->State.DataOUTPipeSize;
+
+		if (AudioInterfaceInfo->State.FeedbackPipeSize)
+		{
+			Stream->FeedbackPipeNumber = AudioInterfaceInfo->Config.FeedbackPipeNumber;
+			Stream->FeedbackPacketSize = MIN(AudioInterfaceInfo->State.FeedbackPipeSize, 4);
+		}
+	}
+	else
+	{
+		return AUDIO_STREAM_InvalidParameter;
+	}
+
+	Stream->BlockSize    = FIFOSize / 2;
+	Stream->TransferSize = AUDIO_HOST_STREAM_FRAMES * Stream->PacketSize;
+
+	if (!(SampleFrameSize) || !(Stream->BlockSize) || (Stream->BlockSize % SampleFrameSize) ||
+	    (Stream->PacketSize < SampleFrameSize) || (Stream->TransferSize > 4096) || (SampleRate < 1000))
+	{
+		return AUDIO_STREAM_InvalidParameter;
+	}
+
+	for (Slot = 0; (Slot < AUDIO_HOST_MAX_STREAMS) && Audio_Host_Streams[Slot]; Slot++);
+
+	Stream->TransferBuffer = (Slot < AUDIO_HOST_MAX_STREAMS) ?
+	                         USB_Memory_Alloc(AUDIO_HOST_STREAM_TRANSFERS * Stream->TransferSize + 2 * Stream->FeedbackPacketSize) : NULL;
+
+	if (Stream->TransferBuffer == NULL)
+	  return AUDIO_STREAM_NoMemory;
+
+	Stream->Block[0]               = FIFO;
+	Stream->Block[1]               = FIFO + Stream->BlockSize;
+	Stream->BlockFull[0]           = Stream->IsOutput; /* the application fills the first playback block before starting */
+	Stream->AppBlock               = Stream->IsOutput ? 1 : 0;
+	Stream->SampleFrameSize        = SampleFrameSize;
+	Stream->PortNumber             = portnum;
+	Stream->DataPipeNumber         = DataPipeIndex;
+	Stream->DataPipeHandle         = PipeInfo[portnum][DataPipeIndex].PipeHandle;
+	Stream->FeedbackPipeHandle     = PipeInfo[portnum][Stream->FeedbackPipeNumber].PipeHandle;
+	Stream->NominalSamplesPerFrame = Audio_Host_SamplesPerFrame(SampleRate);
+	Stream->SamplesPerFrame        = Stream->NominalSamplesPerFrame;
+	Stream->IsStreaming            = true;
+
+	/* First transfers: empty slots of a full packet to receive into, or packets of the whole samples in a frame at the nominal rate */
+	for (i = 0; i < AUDIO_HOST_STREAM_FRAMES; i++)
+	{
+		PacketLength[i] = Stream->IsOutput ?
+		                  MIN(MAX(Stream->NominalSamplesPerFrame >> 16, 1) * SampleFrameSize, Stream->PacketSize) : Stream->PacketSize;
+	}
+
+	if (Stream->IsOutput)
+	{
+		uint8_t Transfer;
+
+		for (Transfer = 0; Transfer < AUDIO_HOST_STREAM_TRANSFERS; Transfer++)
+		{
+			uint8_t* Data = &Stream->TransferBuffer[Transfer * Stream->TransferSize];
+
+			for (i = 0; i < AUDIO_HOST_STREAM_FRAMES; i++)
+			{
+				Audio_Host_StreamFromFIFO(Stream, Data, PacketLength[i]);
+				Data += PacketLength[i];
+			}
+		}
+	}
+
+	Audio_Host_Streams[Slot] = Stream;
+
+	Pipe_SelectPipe(portnum, DataPipeIndex);
+	if (!(Pipe_StartISOStream(portnum, Stream->IsOutput ? Audio_Host_DataOUTComplete : Audio_Host_DataINComplete,
+	                          Stream->TransferBuffer, Stream->TransferSize, PacketLength, AUDIO_HOST_STREAM_FRAMES,
+	                          AUDIO_HOST_STREAM_TRANSFERS)))
+	{
+		Stream->FeedbackPipeNumber = 0;
+		Audio_Host_StopStream(Stream);
+		return AUDIO_STREAM_PipeError;
+	}
+
+	if (Stream->FeedbackPipeNumber)
+	{
+		Pipe_SelectPipe(portnum, Stream->FeedbackPipeNumber);
+		if (!(Pipe_StartISOStream(portnum, Audio_Host_FeedbackComplete,
+		                          &Stream->TransferBuffer[AUDIO_HOST_STREAM_TRANSFERS * Stream->TransferSize],
+		                          Stream->FeedbackPacketSize, &Stream->FeedbackPacketSize, 1, 2)))
+		{
+			Stream->FeedbackPipeNumber = 0;
+			Audio_Host_StopStream(Stream);
+			return AUDIO_STREAM_PipeError;
+		}
+	}
+
+	return AUDIO_STREAM_NoError;
+}
+
+void Audio_Host_StopStream(Audio_Host_Stream_t* const Stream)
+{
+	uint8_t Slot;
+
+	if (Stream->TransferBuffer == NULL)
+	  return;
+
+	Stream->IsStreaming = false;
+
+	Pipe_SelectPipe(Stream->PortNumber, Stream->DataPipeNumber);
+	Pipe_StopISOStream(Stream->PortNumber);
+
+	if (Stream->FeedbackPipeNumber)
+	{
+		Pipe_SelectPipe(Stream->PortNumber, Stream->FeedbackPipeNumber);
+		Pipe_StopISOStream(Stream->PortNumber);
+	}
+
+	for (Slot = 0; Slot < AUDIO_HOST_MAX_STREAMS; Slot++)
+	{
+		if (Audio_Host_Streams[Slot] == Stream)
+		  Audio_Host_Streams[Slot] = NULL;
+	}
+
+	USB_Memory_Free(Stream->TransferBuffer);
+	Stream->TransferBuffer = NULL;
+}
+
+uint8_t* Audio_Host_GetStreamBlock(Audio_Host_Stream_t* const Stream)
+{
+	/* Capture blocks belong to the application once full, playback blocks once sent */
+	if (Stream->BlockFull[Stream->AppBlock] != Stream->IsOutput)
+	  return Stream->Block[Stream->AppBlock];
+
+	return NULL;
+}
+
+void Audio_Host_ReleaseStreamBlock(Audio_Host_Stream_t* const Stream)
+{
+	Stream->BlockFull[Stream->AppBlock] = Stream->IsOutput;
+	Stream->AppBlock ^= 1;
+}
+
+uint32_t Audio_Host_GetStreamSampleRate(const Audio_Host_Stream_t* const Stream)
+{
+	uint32_t SamplesPerFrame = Stream->SamplesPerFrame;
+
+	return ((SamplesPerFrame >> 16) * 1000) + ((((SamplesPerFrame & 0xFFFF) * 1000) + 0x8000) >> 16);
+}
+
+static Audio_Host_Stream_t* Audio_Host_FindStream(const uint32_t PipeHandle, const bool Feedback)
+{
+	uint8_t Slot;
+
+	for (Slot = 0; Slot < AUDIO_HOST_MAX_STREAMS; Slot++)
+	{
+		Audio_Host_Stream_t* Stream = Audio_Host_Streams[Slot];
+
+		if (!(Stream) || !(Stream->IsStreaming))
+		  continue;
+
+		if (Feedback ? (Stream->FeedbackPipeNumber && (Stream->FeedbackPipeHandle == PipeHandle)) :
+		               (Stream->DataPipeHandle == PipeHandle))
+		{
+			return Stream;
+		}
+	}
+
+	return NULL;
+}
+
+static uint32_t Audio_Host_SamplesPerFrame(const uint32_t SampleRate)
+{
+	return ((SampleRate / 1000) << 16) + (((SampleRate % 1000) << 16) / 1000);
+}
+
+static uint16_t Audio_Host_NextPacketLength(Audio_Host_Stream_t* const Stream)
+{
+	uint32_t Samples;
+
+	Stream->SampleRemainder += Stream->SamplesPerFrame;
+	Samples = Stream->SampleRemainder >> 16;
+	Stream->SampleRemainder &= 0xFFFF;
+
+	Samples = MIN(MAX(Samples, 1), Stream->PacketSize / Stream->SampleFrameSize);
+
+	return Samples * Stream->SampleFrameSize;
+}
+
+static void Audio_Host_StreamToFIFO(Audio_Host_Stream_t* const Stream, const uint8_t* Data, uint16_t Length)
+{
+	while (Length)
+	{
+		uint16_t Count;
+
+		if (Stream->BlockFull[Stream->USBBlock])
+		{
+			Stream->Overruns++;
+			return;
+		}
+
+		Count = MIN(Length, Stream->BlockSize - Stream->BlockOffset);
+		memcpy(&Stream->Block[Stream->USBBlock][Stream->BlockOffset], Data, Count);
+		Stream->BlockOffset += Count;
+		Data   += Count;
+		Length -= Count;
+
+		if (Stream->BlockOffset == Stream->BlockSize)
+		{
+			Stream->BlockFull[Stream->USBBlock] = true;
+			Stream->USBBlock   ^= 1;
+			Stream->BlockOffset = 0;
+		}
+	}
+}
+
+static void Audio_Host_StreamFromFIFO(Audio_Host_Stream_t* const Stream, uint8_t* Data, uint16_t Length)
+{
+	while (Length)
+	{
+		uint16_t Count;
+
+		if (!(Stream->BlockFull[Stream->USBBlock]))
+		{
+			memset(Data, 0x00, Length);
+			Stream->Underruns++;
+			return;
+		}
+
+		Count = MIN(Length, Stream->BlockSize - Stream->BlockOffset);
+		memcpy(Data, &Stream->Block[Stream->USBBlock][Stream->BlockOffset], Count);
+		Stream->BlockOffset += Count;
+		Data   += Count;
+		Length -= Count;
+
+		if (Stream->BlockOffset == Stream->BlockSize)
+		{
+			Stream->BlockFull[Stream->USBBlock] = false;
+			Stream->USBBlock   ^= 1;
+			Stream->BlockOffset = 0;
+		}
+	}
+}
+
+static bool Audio_Host_DataINComplete(uint32_t PipeHandle, HCD_STATUS Status, uint8_t* Buffer,
+                                      uint16_t* PacketLength, uint8_t PacketCount)
+{
+	Audio_Host_Stream_t* Stream = Audio_Host_FindStream(PipeHandle, false);
+	uint8_t i;
+
+	if (!(Stream))
+	  return false;
+
+	for (i = 0; i < PacketCount; i++)
+	{
+		if (PacketLength[i])
+		{
+			uint32_t Samples = PacketLength[i] / Stream->SampleFrameSize;
+
+			Audio_Host_StreamToFIFO(Stream, &Buffer[i * Stream->PacketSize], PacketLength[i]);
+			Stream->SamplesPerFrame += ((int32_t) ((Samples << 16) - Stream->SamplesPerFrame) + (1 << (AUDIO_HOST_RATE_FILTER_SHIFT - 1))) >> AUDIO_HOST_RATE_FILTER_SHIFT;
+		}
+		else if (Status != HCD_STATUS_OK)
+		{
+			Stream->LostPackets++;
+		}
+
+		PacketLength[i] = Stream->PacketSize;
+	}
+
+	return true;
+}
+
+static bool Audio_Host_DataOUTComplete(uint32_t PipeHandle, HCD_STATUS Status, uint8_t* Buffer,
+                                       uint16_t* PacketLength, uint8_t PacketCount)
+{
+	Audio_Host_Stream_t* Stream = Audio_Host_FindStream(PipeHandle, false);
+	uint8_t i;
+
+	(void)Status;
+
+	if (!(Stream))
+	  return false;
+
+	for (i = 0; i < PacketCount; i++)
+	{
+		if (!(PacketLength[i]))
+		  Stream->LostPackets++;
+
+		PacketLength[i] = Audio_Host_NextPacketLength(Stream);
+		Audio_Host_StreamFromFIFO(Stream, Buffer, PacketLength[i]);
+		Buffer += PacketLength[i];
+	}
+
+	return true;
+}
+
+static bool Audio_Host_FeedbackComplete(uint32_t PipeHandle, HCD_STATUS Status, uint8_t* Buffer,
+                                        uint16_t* PacketLength, uint8_t PacketCount)
+{
+	Audio_Host_Stream_t* Stream = Audio_Host_FindStream(PipeHandle, true);
+
+	(void)Status;
+	(void)PacketCount;
+
+	if (!(Stream))
+	  return false;
+
+	if (PacketLength[0] >= 3)
+	{
+		uint32_t Feedback = Buffer[0] | ((uint32_t)Buffer[1] << 8) | ((uint32_t)Buffer[2] << 16);
+		uint32_t Nominal  = Stream->NominalSamplesPerFrame;
+
+		if (PacketLength[0] >= 4)
+		  Feedback |= ((uint32_t)Buffer[3] << 24); /* 16.16, sent by many full speed devices */
+		else
+		  Feedback <<= 2;                          /* 10.14 */
+
+		/* A value more than 1/8 off the nominal rate is garbage or in the other format */
+		if ((Feedback > (Nominal - (Nominal >> 3))) && (Feedback < (Nominal + (Nominal >> 3))))
+		{
+			Stream->SamplesPerFrame = Feedback;
+			Stream->FeedbackUpdates++;
+		}
+	}
+
+	PacketLength[0] = Stream->FeedbackPacketSize;
+
+	return true;
+}
+
 #endif
 
@@ -71,6 +71,23 @@
 		#endif
 
 	/* Public Interface - May be used in end-application: */
+		/* Macros: */
+			#if !defined(AUDIO_HOST_STREAM_TRANSFERS) || defined(__DOXYGEN__)
+				/** Number of isochronous transfers an audio stream keeps queued on its pipe. Together with
+				 *  \ref AUDIO_HOST_STREAM_FRAMES this sets how late the USB interrupt may refill a transfer
+				 *  before a frame goes out empty, (AUDIO_HOST_STREAM_TRANSFERS - 1) * AUDIO_HOST_STREAM_FRAMES ms.
+				 */
+				#define AUDIO_HOST_STREAM_TRANSFERS      3
+			#endif
+
+			#if !defined(AUDIO_HOST_STREAM_FRAMES) || defined(__DOXYGEN__)
+				/** Number of frames (one packet each) carried by every isochronous transfer of an audio stream, up to 8. */
+				#define AUDIO_HOST_STREAM_FRAMES         2
+			#endif
+
+			/** Maximum number of audio streams running at the same time, over all interfaces. */
+			#define AUDIO_HOST_MAX_STREAMS               2
+
 		/* Type Defines: */
 			/** \brief Audio Class Host Mode Configuration and State Structure.
 			 *
@@ -90,6 +107,10 @@
 					                            *   bind to an OUT endpoint, this may be set to 0 to disable audio output streaming for
 					                            *   this driver instance.
 					                            */
+					uint8_t  FeedbackPipeNumber; /**< Pipe number of the explicit feedback endpoint of an asynchronous OUT data endpoint,
+					                              *   used to match the playback rate to the device clock. This may be set to 0 to
+					                              *   play at the nominal rate.
+					                              */
 					uint8_t  PortNumber;		/**< Port number that this interface is running.			*/				
 				} Config; /**< Config data for the USB class interface within the device. All elements in this section
 				           *   <b>must</b> be set or the interface will fail to enumerate and operate correctly.
@@ -107,12 +128,56 @@
 
 					uint16_t DataINPipeSize; /**< Size in bytes of the Audio interface's IN data pipe. */
 					uint16_t DataOUTPipeSize;  /**< Size in bytes of the Audio interface's OUT data pipe. */
+					uint16_t FeedbackPipeSize; /**< Size in bytes of the Audio interface's feedback pipe, 0 if the device has none. */
+					uint8_t  FeedbackRefresh;  /**< Feedback period exponent, the device updates its feedback every 2^FeedbackRefresh ms. */
 				} State; /**< State data for the USB class interface within the device. All elements in this section
 						  *   <b>may</b> be set to initial values, but may also be ignored to default to sane values when
 						  *   the interface is enumerated.
 						  */
 			} USB_ClassInfo_Audio_Host_t;
 
+			/** \brief Audio Class Host Mode Stream Structure.
+			 *
+			 *  State of an isochronous audio stream started with \ref Audio_Host_StartStream(). Samples go through a
+			 *  double buffered FIFO supplied by the application: while the USB interrupt fills (capture) or drains
+			 *  (playback) one block, the application owns the other one, taking it with \ref Audio_Host_GetStreamBlock()
+			 *  and handing it back with \ref Audio_Host_ReleaseStreamBlock(). The statistics are only written by the
+			 *  USB interrupt and may be read at any time.
+			 */
+			typedef struct
+			{
+				uint8_t* Block[2]; /**< The two halves of the sample FIFO. */
+				uint16_t BlockSize; /**< Size in bytes of each half. */
+				uint16_t BlockOffset; /**< Position of the USB interrupt in the block it is filling or draining. */
+				volatile bool BlockFull[2]; /**< Block holds samples to be read (capture) or sent (playback). */
+				uint8_t  USBBlock; /**< Block the USB interrupt is working on. */
+				uint8_t  AppBlock; /**< Block the application works on next. */
+
+				bool     IsOutput; /**< Stream plays samples to the device. */
+				volatile bool IsStreaming; /**< Stream is started, cleared to let the queued transfers retire. */
+				uint8_t  SampleFrameSize; /**< Bytes in one sample of every channel. */
+				uint8_t  PortNumber; /**< Port number of the stream's interface. */
+				uint8_t  DataPipeNumber; /**< Pipe carrying the samples. */
+				uint8_t  FeedbackPipeNumber; /**< Feedback pipe bound to a playback stream, 0 for none. */
+				uint16_t PacketSize; /**< Maximum packet size of the data pipe. */
+				uint16_t TransferSize; /**< Bytes reserved for each queued transfer. */
+				uint16_t FeedbackPacketSize; /**< Size of a feedback packet, 3 (10.14 format) or 4 (16.16 format) bytes. */
+				uint8_t* TransferBuffer; /**< Queued transfers, in USB RAM. */
+				uint32_t DataPipeHandle; /**< HCD handle of the data pipe, identifies the stream in the interrupt. */
+				uint32_t FeedbackPipeHandle; /**< HCD handle of the feedback pipe. */
+
+				uint32_t NominalSamplesPerFrame; /**< Sample rate asked for, in samples per 1 ms frame as 16.16 fixed point. */
+				volatile uint32_t SamplesPerFrame; /**< Playback: rate the packets are sized with, the device feedback if there
+				                                    *   is one. Capture: rate measured on the received packets. 16.16 fixed point.
+				                                    */
+				uint32_t SampleRemainder; /**< Playback: fraction of a sample carried over to the next packet, 16.16 fixed point. */
+
+				volatile uint32_t Underruns; /**< Playback packets padded with silence because no block was ready. */
+				volatile uint32_t Overruns; /**< Capture packets dropped (in part) because the application still held both blocks. */
+				volatile uint32_t LostPackets; /**< Packets lost on the bus or skipped because a transfer was queued too late. */
+				volatile uint32_t FeedbackUpdates; /**< Feedback values received from the device. */
+			} Audio_Host_Stream_t;
+
 		/* Enums: */
 			/** Enum for the possible error codes returned by the \ref Audio_Host_ConfigurePipes() function. */
 			enum AUDIO_Host_EnumerationFailure_ErrorCodes_t
@@ -123,6 +188,16 @@
 				AUDIO_ENUMERROR_PipeConfigurationFailed    = 3, /**< One or more pipes for the specified interface could not be configured correctly. */
 			};
 
+			/** Enum for the possible error codes returned by the \ref Audio_Host_StartStream() function. */
+			enum AUDIO_Host_StreamErrorCodes_t
+			{
+				AUDIO_STREAM_NoError                       = 0, /**< Stream is running. */
+				AUDIO_STREAM_DeviceDisconnected            = 1, /**< The interface is not bound to a configured device. */
+				AUDIO_STREAM_InvalidParameter              = 2, /**< The pipe is not a data pipe of the interface or the FIFO cannot be split in two blocks of whole samples. */
+				AUDIO_STREAM_NoMemory                      = 3, /**< The transfer buffers do not fit in the USB RAM, or all streams are in use. */
+				AUDIO_STREAM_PipeError                     = 4, /**< The host controller driver refused the isochronous transfers. */
+			};
+
 		/* Function Prototypes: */
 			/** Host interface configuration routine, to configure a given Audio host interface instance using the Configuration
 			 *  Descriptor read from an attached USB device. This function automatically updates the given Audio Host instance's
@@ -172,6 +247,66 @@
 			                                          const uint16_t DataLength,
 			                                          void* const Data) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(6);
 
+			/** Starts an isochronous stream of samples on one of the data pipes of the given configured Audio Host interface.
+			 *  The USB interrupt then keeps \ref AUDIO_HOST_STREAM_TRANSFERS transfers queued and moves every packet between
+			 *  them and the FIFO, so the application only deals with blocks of half the FIFO. Playback packets are sized
+			 *  from the sample rate, or from the device feedback when the interface has a feedback pipe; the rate of
+			 *  captured packets is measured. Streaming should first be enabled on the device with
+			 *  \ref Audio_Host_StartStopStreaming() and its sample rate set with \ref Audio_Host_GetSetEndpointProperty().
+			 *
+			 *  \note A playback stream starts with the first block of the FIFO full: it should be filled before the call.
+			 *
+			 *  \param[in,out] AudioInterfaceInfo  Pointer to a structure containing an Audio Class host configuration and state.
+			 *  \param[in]     DataPipeIndex       Index of the data pipe to stream on, the interface's IN or OUT data pipe.
+			 *  \param[out]    Stream              Stream state, kept by the application until \ref Audio_Host_StopStream().
+			 *  \param[in]     FIFO                Sample FIFO, split in two blocks.
+			 *  \param[in]     FIFOSize            Size in bytes of the FIFO, each half a whole number of samples.
+			 *  \param[in]     SampleRate          Sample rate in Hz.
+			 *  \param[in]     SampleFrameSize     Bytes in one sample of every channel, e.g. 4 for 16-bit stereo.
+			 *
+			 *  \return A value from the \ref AUDIO_Host_StreamErrorCodes_t enum.
+			 */
+			uint8_t Audio_Host_StartStream(USB_ClassInfo_Audio_Host_t* const AudioInterfaceInfo,
+			                               const uint8_t DataPipeIndex,
+			                               Audio_Host_Stream_t* const Stream,
+			                               uint8_t* const FIFO,
+			                               const uint16_t FIFOSize,
+			                               const uint32_t SampleRate,
+			                               const uint8_t SampleFrameSize) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(3)
+			                                                              ATTR_NON_NULL_PTR_ARG(4);
+
+			/** Stops a stream started with \ref Audio_Host_StartStream(), cancelling its queued transfers. A capture block
+			 *  the interrupt had not finished is dropped.
+			 *
+			 *  \param[in,out] Stream  Stream state.
+			 */
+			void Audio_Host_StopStream(Audio_Host_Stream_t* const Stream) ATTR_NON_NULL_PTR_ARG(1);
+
+			/** Returns the next block of the stream's FIFO owned by the application: a block of captured samples to
+			 *  read, or a free block to fill with samples to play.
+			 *
+			 *  \param[in,out] Stream  Stream state.
+			 *
+			 *  \return Pointer to a block of \c Stream->BlockSize bytes, or \c NULL if the USB interrupt still has it.
+			 */
+			uint8_t* Audio_Host_GetStreamBlock(Audio_Host_Stream_t* const Stream) ATTR_NON_NULL_PTR_ARG(1);
+
+			/** Hands the block returned by \ref Audio_Host_GetStreamBlock() back to the USB interrupt, as read (capture)
+			 *  or as filled (playback).
+			 *
+			 *  \param[in,out] Stream  Stream state.
+			 */
+			void Audio_Host_ReleaseStreamBlock(Audio_Host_Stream_t* const Stream) ATTR_NON_NULL_PTR_ARG(1);
+
+			/** Returns the sample rate a stream actually runs at: the rate playback packets are sized with (following
+			 *  the device feedback) or the rate measured on captured packets.
+			 *
+			 *  \param[in] Stream  Stream state.
+			 *
+			 *  \return Sample rate in Hz.
+			 */
+			uint32_t Audio_Host_GetStreamSampleRate(const Audio_Host_Stream_t* const Stream) ATTR_NON_NULL_PTR_ARG(1);
+
 		/* Inline Functions: */
 			/** General management task for a given Audio host class interface, required for the correct operation of
 			 *  the interface. This should be called frequently in the main program loop, before the master USB management task
@@ -413,8 +548,22 @@
 			
 	/* Private Interface - For use in library only: */
 	#if !defined(__DOXYGEN__)
+		/* Macros: */
+			#define AUDIO_HOST_RATE_FILTER_SHIFT         7 /* measured capture rate averages over about 2^7 frames */
+
 		/* Function Prototypes: */
 			#if defined(__INCLUDE_FROM_AUDIO_HOST_C)
+				static Audio_Host_Stream_t* Audio_Host_FindStream(const uint32_t PipeHandle, const bool Feedback);
+				static uint32_t Audio_Host_SamplesPerFrame(const uint32_t SampleRate) ATTR_CONST;
+				static uint16_t Audio_Host_NextPacketLength(Audio_Host_Stream_t* const Stream);
+				static void Audio_Host_StreamToFIFO(Audio_Host_Stream_t* const Stream, const uint8_t* Data, uint16_t Length);
+				static void Audio_Host_StreamFromFIFO(Audio_Host_Stream_t* const Stream, uint8_t* Data, uint16_t Length);
+				static bool Audio_Host_DataINComplete(uint32_t PipeHandle, HCD_STATUS Status, uint8_t* Buffer,
+				                                      uint16_t* PacketLength, uint8_t PacketCount);
+				static bool Audio_Host_DataOUTComplete(uint32_t PipeHandle, HCD_STATUS Status, uint8_t* Buffer,
+				                                       uint16_t* PacketLength, uint8_t PacketCount);
+				static bool Audio_Host_FeedbackComplete(uint32_t PipeHandle, HCD_STATUS Status, uint8_t* Buffer,
+				                                        uint16_t* PacketLength, uint8_t PacketCount);
 				static uint8_t DCOMP_Audio_Host_NextAudioControlInterface(void* CurrentDescriptor)
 				                                                          ATTR_WARN_UNUSED_RESULT ATTR_NON_NULL_PTR_ARG(1);
 				static uint8_t DCOMP_Audio_Host_NextAudioStreamInterface(void* CurrentDescriptor)
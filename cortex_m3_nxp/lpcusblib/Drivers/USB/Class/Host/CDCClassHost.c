@@ -47,7 +47,6 @@ uint8_t CDC_Host_ConfigurePipes(USB_ClassInfo_CDC_Host_t* const CDCInterfaceInfo
 	USB_Descriptor_Endpoint_t*  DataOUTEndpoint      = NULL;
 	USB_Descriptor_Endpoint_t*  NotificationEndpoint = NULL;
 	USB_Descriptor_Interface_t* CDCControlInterface  = NULL;
-	uint8_t portnum = CDCInterfaceInfo->Config.PortNumber;
 
 	memset(&CDCInterfaceInfo->State, 0x00, sizeof(CDCInterfaceInfo->State));
 
@@ -102,6 +101,74 @@ uint8_t CDC_Host_ConfigurePipes(USB_ClassInfo_CDC_Host_t* const CDCInterfaceInfo
 		}
 	}
 
+	return CDC_Host_OpenPipes(CDCInterfaceInfo, CDCControlInterface, DataINEndpoint, DataOUTEndpoint, NotificationEndpoint);
+}
+
+uint8_t CDC_Host_ConfigurePipesIndexed(USB_ClassInfo_CDC_Host_t* const CDCInterfaceInfo,
+                                       const USB_Host_IndexedConfig_t* const Config)
+{
+	USB_Descriptor_Endpoint_t*  DataINEndpoint       = NULL;
+	USB_Descriptor_Endpoint_t*  DataOUTEndpoint      = NULL;
+	USB_Descriptor_Endpoint_t*  NotificationEndpoint = NULL;
+	USB_Descriptor_Interface_t* CDCControlInterface  = NULL;
+	uint8_t InterfaceIndex;
+
+	memset(&CDCInterfaceInfo->State, 0x00, sizeof(CDCInterfaceInfo->State));
+
+	/* The control interface with its notification endpoint first, then the data interface following it */
+	for (InterfaceIndex = 0; !(DataINEndpoint) || !(DataOUTEndpoint) || !(NotificationEndpoint); InterfaceIndex++)
+	{
+		uint8_t EndpointIndex;
+
+		if (USB_GetNextIndexedInterfaceComp(Config, &InterfaceIndex,
+		                                    NotificationEndpoint ? DCOMP_CDC_Host_NextCDCDataInterface
+		                                                         : DCOMP_CDC_Host_NextCDCControlInterface) != DESCRIPTOR_SEARCH_COMP_Found)
+		{
+			return CDC_ENUMERROR_NoCompatibleInterfaceFound;
+		}
+
+		if (NotificationEndpoint)
+		{
+			DataINEndpoint  = NULL;
+			DataOUTEndpoint = NULL;
+		}
+		else
+		{
+			CDCControlInterface = USB_GetIndexedInterface(Config, InterfaceIndex);
+		}
+
+		for (EndpointIndex = 0; EndpointIndex < Config->Index.Interfaces[InterfaceIndex].TotalEndpoints; EndpointIndex++)
+		{
+			USB_Descriptor_Endpoint_t* EndpointData = USB_GetIndexedEndpoint(Config, InterfaceIndex, EndpointIndex);
+
+			if (DCOMP_CDC_Host_NextCDCInterfaceEndpoint(EndpointData) != DESCRIPTOR_SEARCH_Found)
+			  continue;
+
+			if ((EndpointData->EndpointAddress & ENDPOINT_DIR_MASK) == ENDPOINT_DIR_IN)
+			{
+				if ((EndpointData->Attributes & EP_TYPE_MASK) == EP_TYPE_INTERRUPT)
+				  NotificationEndpoint = EndpointData;
+				else
+				  DataINEndpoint = EndpointData;
+			}
+			else
+			{
+				DataOUTEndpoint = EndpointData;
+			}
+		}
+	}
+
+	return CDC_Host_OpenPipes(CDCInterfaceInfo, CDCControlInterface, DataINEndpoint, DataOUTEndpoint, NotificationEndpoint);
+}
+
+static uint8_t CDC_Host_OpenPipes(USB_ClassInfo_CDC_Host_t* const CDCInterfaceInfo,
+                                  USB_Descriptor_Interface_t* const CDCControlInterface,
+                                  USB_Descriptor_Endpoint_t* const DataINEndpoint,
+                                  USB_Descriptor_Endpoint_t* const DataOUTEndpoint,
+                                  USB_Descriptor_Endpoint_t* const NotificationEndpoint)
+{
+	uint8_t portnum = CDCInterfaceInfo->Config.PortNumber;
+
 	uint8_t PipeNum;
 	for (PipeNum = 1; PipeNum < PIPE_TOTAL_PIPES; PipeNum++)
 	{
@@ -156,8 +223,8 @@ uint8_t CDC_Host_ConfigurePipes(USB_ClassInfo_CDC_Host_t* const CDCInterfaceInfo
 			return CDC_ENUMERROR_PipeConfigurationFailed;
 		}
 		
-		if (InterruptPeriod)
-		  Pipe_SetInterruptPeriod(InterruptPeriod);
+		if (InterruptPeriod && !(Pipe_SetInterruptPeriod(portnum, InterruptPeriod)))
+		  return CDC_ENUMERROR_PipeConfigurationFailed;
 	}
 
 	CDCInterfaceInfo->State.ControlInterfaceNumber = CDCControlInterface->InterfaceNumber;
@@ -265,6 +332,8 @@ void CDC_Host_USBTask(USB_ClassInfo_CDC_Host_t* const CDCInterfaceInfo)
 
 	Pipe_Freeze();
 
+	CDC_Host_RearmReceive(CDCInterfaceInfo);
+
 	#if !defined(NO_CLASS_DRIVER_AUTOFLUSH)
 	CDC_Host_Flush(CDCInterfaceInfo);
 	#endif
@@ -392,6 +461,9 @@ uint16_t CDC_Host_BytesReceived(USB_ClassInfo_CDC_Host_t* const CDCInterfaceInfo
 	if ((USB_HostState[portnum] != HOST_STATE_Configured) || !(CDCInterfaceInfo->State.IsActive))
 	  return 0;
 
+	if (CDCInterfaceInfo->State.Receive.Buffer)
+	  return CDC_Host_RingCount(CDCInterfaceInfo);
+
 	Pipe_SelectPipe(portnum,CDCInterfaceInfo->Config.DataINPipeNumber);
 	Pipe_Unfreeze();
 
@@ -425,6 +497,13 @@ int16_t CDC_Host_ReceiveByte(USB_ClassInfo_CDC_Host_t* const CDCInterfaceInfo)
 	if ((USB_HostState[portnum] != HOST_STATE_Configured) || !(CDCInterfaceInfo->State.IsActive))
 	  return -1;
 
+	if (CDCInterfaceInfo->State.Receive.Buffer)
+	{
+		uint8_t Data;
+
+		return CDC_Host_Read(CDCInterfaceInfo, &Data, 1) ? Data : -1;
+	}
+
 	Pipe_SelectPipe(portnum,CDCInterfaceInfo->Config.DataINPipeNumber);
 	Pipe_Unfreeze();
 
@@ -473,6 +552,242 @@ uint8_t CDC_Host_Flush(USB_ClassInfo_CDC_Host_t* const CDCInterfaceInfo)
 	return PIPE_READYWAIT_NoError;
 }
 
+static USB_ClassInfo_CDC_Host_t* CDC_Host_RxStreams[CDC_HOST_MAX_RX_STREAMS];
+
+uint8_t CDC_Host_StartReceiving(USB_ClassInfo_CDC_Host_t* const CDCInterfaceInfo,
+                                uint8_t* const Buffer,
+                                const uint16_t Size)
+{
+	uint8_t  portnum = CDCInterfaceInfo->Config.PortNumber;
+	uint16_t TransferSize;
+	uint8_t  Slot;
+
+	if ((USB_HostState[portnum] != HOST_STATE_Configured) || !(CDCInterfaceInfo->State.IsActive))
+	  return CDC_RECEIVE_DeviceDisconnected;
+
+	if (CDCInterfaceInfo->State.Receive.Buffer)
+	  CDC_Host_StopReceiving(CDCInterfaceInfo);
+
+	/* Transfers end on a packet boundary so that only a short packet ends one early */
+	TransferSize = CDC_HOST_RX_TRANSFER_SIZE - (CDC_HOST_RX_TRANSFER_SIZE % CDCInterfaceInfo->State.DataINPipeSize);
+
+	if (!(TransferSize) || (Size <= (uint32_t) CDC_HOST_RX_TRANSFERS * TransferSize))
+	  return CDC_RECEIVE_NoMemory;
+
+	for (Slot = 0; (Slot < CDC_HOST_MAX_RX_STREAMS) && CDC_Host_RxStreams[Slot]; Slot++);
+
+	CDCInterfaceInfo->State.Receive.TransferBuffer = (Slot < CDC_HOST_MAX_RX_STREAMS) ?
+	                                                 USB_Memory_Alloc(CDC_HOST_RX_TRANSFERS * TransferSize) : NULL;
+
+	if (CDCInterfaceInfo->State.Receive.TransferBuffer == NULL)
+	  return CDC_RECEIVE_NoMemory;
+
+	CDCInterfaceInfo->State.Receive.Size         = Size;
+	CDCInterfaceInfo->State.Receive.In           = 0;
+	CDCInterfaceInfo->State.Receive.Out          = 0;
+	CDCInterfaceInfo->State.Receive.Error        = HCD_STATUS_OK;
+	CDCInterfaceInfo->State.Receive.TransferSize = TransferSize;
+	CDCInterfaceInfo->State.Receive.Queued       = CDC_HOST_RX_TRANSFERS;
+	CDCInterfaceInfo->State.Receive.PipeHandle   = PipeInfo[portnum][CDCInterfaceInfo->Config.DataINPipeNumber].PipeHandle;
+	CDCInterfaceInfo->State.Receive.Buffer       = Buffer;
+
+	CDC_Host_RxStreams[Slot] = CDCInterfaceInfo;
+
+	Pipe_SelectPipe(portnum,CDCInterfaceInfo->Config.DataINPipeNumber);
+	if (!(Pipe_StartBulkINStream(portnum, CDC_Host_DataINComplete, CDCInterfaceInfo->State.Receive.TransferBuffer,
+	                             TransferSize, CDC_HOST_RX_TRANSFERS)))
+	{
+		CDC_Host_StopReceiving(CDCInterfaceInfo);
+		return CDC_RECEIVE_PipeError;
+	}
+
+	return CDC_RECEIVE_NoError;
+}
+
+void CDC_Host_StopReceiving(USB_ClassInfo_CDC_Host_t* const CDCInterfaceInfo)
+{
+	uint8_t portnum = CDCInterfaceInfo->Config.PortNumber;
+	uint8_t Slot;
+
+	if (!(CDCInterfaceInfo->State.Receive.Buffer))
+	  return;
+
+	/* The pipe is gone once the device has been detached */
+	if (USB_HostState[portnum] == HOST_STATE_Configured)
+	{
+		Pipe_SelectPipe(portnum,CDCInterfaceInfo->Config.DataINPipeNumber);
+		Pipe_StopINStream(portnum);
+	}
+
+	for (Slot = 0; Slot < CDC_HOST_MAX_RX_STREAMS; Slot++)
+	{
+		if (CDC_Host_RxStreams[Slot] == CDCInterfaceInfo)
+		  CDC_Host_RxStreams[Slot] = NULL;
+	}
+
+	USB_Memory_Free(CDCInterfaceInfo->State.Receive.TransferBuffer);
+	CDCInterfaceInfo->State.Receive.TransferBuffer = NULL;
+	CDCInterfaceInfo->State.Receive.Buffer         = NULL;
+	CDCInterfaceInfo->State.Receive.Queued         = 0;
+}
+
+uint16_t CDC_Host_Read(USB_ClassInfo_CDC_Host_t* const CDCInterfaceInfo,
+                       uint8_t* const Buffer,
+                       const uint16_t Length)
+{
+	uint8_t  portnum = CDCInterfaceInfo->Config.PortNumber;
+	uint16_t Count;
+	uint16_t Out;
+	uint16_t Chunk;
+
+	if ((USB_HostState[portnum] != HOST_STATE_Configured) || !(CDCInterfaceInfo->State.IsActive))
+	  return 0;
+
+	if (!(CDCInterfaceInfo->State.Receive.Buffer))
+	{
+		Pipe_SelectPipe(portnum,CDCInterfaceInfo->Config.DataINPipeNumber);
+		Pipe_Unfreeze();
+
+		Count = 0;
+		if (Pipe_IsINReceived(portnum))
+		{
+			Count = MIN(Length, Pipe_BytesInPipe(portnum));
+			Pipe_Read_Stream_LE(portnum, Buffer, Count, NULL);
+
+			if (!(Pipe_BytesInPipe(portnum)))
+			  Pipe_ClearIN(portnum);
+		}
+
+		Pipe_Freeze();
+
+		return Count;
+	}
+
+	Count = MIN(Length, CDC_Host_RingCount(CDCInterfaceInfo));
+	Out   = CDCInterfaceInfo->State.Receive.Out;
+	Chunk = MIN(Count, CDCInterfaceInfo->State.Receive.Size - Out);
+
+	memcpy(Buffer, &CDCInterfaceInfo->State.Receive.Buffer[Out], Chunk);
+	memcpy(&Buffer[Chunk], CDCInterfaceInfo->State.Receive.Buffer, Count - Chunk);
+
+	Out += Count;
+	if (Out >= CDCInterfaceInfo->State.Receive.Size)
+	  Out -= CDCInterfaceInfo->State.Receive.Size;
+
+	CDCInterfaceInfo->State.Receive.Out = Out;
+
+	CDC_Host_RearmReceive(CDCInterfaceInfo);
+
+	return Count;
+}
+
+uint8_t CDC_Host_Write(USB_ClassInfo_CDC_Host_t* const CDCInterfaceInfo,
+                       const uint8_t* const Buffer,
+                       const uint16_t Length)
+{
+	uint8_t ErrorCode;
+
+	if ((ErrorCode = CDC_Host_SendData(CDCInterfaceInfo, Buffer, Length)) != PIPE_RWSTREAM_NoError)
+	  return ErrorCode;
+
+	return CDC_Host_Flush(CDCInterfaceInfo);
+}
+
+static uint16_t CDC_Host_RingCount(USB_ClassInfo_CDC_Host_t* const CDCInterfaceInfo)
+{
+	uint16_t In  = CDCInterfaceInfo->State.Receive.In;
+	uint16_t Out = CDCInterfaceInfo->State.Receive.Out;
+
+	return (In >= Out) ? (In - Out) : (CDCInterfaceInfo->State.Receive.Size - Out + In);
+}
+
+/* Queues the receive transfers again once the interrupt has left them all idle for lack of space. While any is
+ * queued only the interrupt queues them, so the two never take the same ring buffer space. */
+static void CDC_Host_RearmReceive(USB_ClassInfo_CDC_Host_t* const CDCInterfaceInfo)
+{
+	uint8_t  portnum = CDCInterfaceInfo->Config.PortNumber;
+	uint16_t Free;
+	uint8_t  Transfers;
+	uint8_t  i;
+
+	if (!(CDCInterfaceInfo->State.Receive.Buffer) || CDCInterfaceInfo->State.Receive.Queued ||
+	    CDCInterfaceInfo->State.Receive.Error)
+	{
+		return;
+	}
+
+	Free      = CDCInterfaceInfo->State.Receive.Size - 1 - CDC_Host_RingCount(CDCInterfaceInfo);
+	Transfers = MIN(CDC_HOST_RX_TRANSFERS, Free / CDCInterfaceInfo->State.Receive.TransferSize);
+
+	if (!(Transfers))
+	  return;
+
+	CDCInterfaceInfo->State.Receive.Queued = Transfers;
+
+	Pipe_SelectPipe(portnum,CDCInterfaceInfo->Config.DataINPipeNumber);
+	for (i = 0; i < Transfers; i++)
+	{
+		if (!(Pipe_QueueINStreamTransfer(portnum,
+		                                 &CDCInterfaceInfo->State.Receive.TransferBuffer[i * CDCInterfaceInfo->State.Receive.TransferSize],
+		                                 CDCInterfaceInfo->State.Receive.TransferSize)))
+		{
+			CDCInterfaceInfo->State.Receive.Error = HCD_STATUS_TRANSFER_ERROR;
+			break;
+		}
+	}
+}
+
+static bool CDC_Host_DataINComplete(uint32_t PipeHandle, HCD_STATUS Status, uint8_t* Buffer, uint16_t Length)
+{
+	USB_ClassInfo_CDC_Host_t* CDCInterfaceInfo = NULL;
+	uint16_t In;
+	uint16_t Chunk;
+	uint16_t Free;
+	uint8_t  Slot;
+
+	for (Slot = 0; Slot < CDC_HOST_MAX_RX_STREAMS; Slot++)
+	{
+		if (CDC_Host_RxStreams[Slot] && (CDC_Host_RxStreams[Slot]->State.Receive.PipeHandle == PipeHandle))
+		  CDCInterfaceInfo = CDC_Host_RxStreams[Slot];
+	}
+
+	if (!(CDCInterfaceInfo) || !(CDCInterfaceInfo->State.Receive.Buffer))
+	  return false;
+
+	CDCInterfaceInfo->State.Receive.Queued--;
+
+	/* A failed transfer leaves a gap in the data, the stream ends there */
+	if ((Status != HCD_STATUS_OK) || CDCInterfaceInfo->State.Receive.Error)
+	{
+		if (!(CDCInterfaceInfo->State.Receive.Error))
+		  CDCInterfaceInfo->State.Receive.Error = Status;
+
+		return false;
+	}
+
+	/* Space for the whole transfer was set aside when it was queued */
+	In    = CDCInterfaceInfo->State.Receive.In;
+	Chunk = MIN(Length, CDCInterfaceInfo->State.Receive.Size - In);
+
+	memcpy(&CDCInterfaceInfo->State.Receive.Buffer[In], Buffer, Chunk);
+	memcpy(CDCInterfaceInfo->State.Receive.Buffer, &Buffer[Chunk], Length - Chunk);
+
+	In += Length;
+	if (In >= CDCInterfaceInfo->State.Receive.Size)
+	  In -= CDCInterfaceInfo->State.Receive.Size;
+
+	CDCInterfaceInfo->State.Receive.In = In;
+
+	/* Queue the transfer again only if the ring buffer still has room for it next to the ones in flight */
+	Free = CDCInterfaceInfo->State.Receive.Size - 1 - CDC_Host_RingCount(CDCInterfaceInfo);
+
+	if (Free < (uint32_t) (CDCInterfaceInfo->State.Receive.Queued + 1) * CDCInterfaceInfo->State.Receive.TransferSize)
+	  return false;
+
+	CDCInterfaceInfo->State.Receive.Queued++;
+	return true;
+}
+
 #if defined(FDEV_SETUP_STREAM)
 void CDC_Host_CreateStream(USB_ClassInfo_CDC_Host_t* const CDCInterfaceInfo,
                            FILE* const Stream)
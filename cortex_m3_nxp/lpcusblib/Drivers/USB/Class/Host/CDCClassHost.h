@@ -73,6 +73,24 @@
 		#endif
 
 	/* Public Interface - May be used in end-application: */
+		/* Macros: */
+			#if !defined(CDC_HOST_RX_TRANSFERS) || defined(__DOXYGEN__)
+				/** Number of bulk IN transfers a CDC receive stream keeps queued, so the device is not NAKed while the
+				 *  USB interrupt copies a finished one into the receive buffer.
+				 */
+				#define CDC_HOST_RX_TRANSFERS            2
+			#endif
+
+			#if !defined(CDC_HOST_RX_TRANSFER_SIZE) || defined(__DOXYGEN__)
+				/** Length in bytes of each bulk IN transfer of a CDC receive stream, rounded down to a whole number of
+				 *  packets of the data IN pipe. The stream takes \ref CDC_HOST_RX_TRANSFERS times this from the USB RAM.
+				 */
+				#define CDC_HOST_RX_TRANSFER_SIZE        512
+			#endif
+
+			/** Maximum number of CDC receive streams running at the same time, over all interfaces. */
+			#define CDC_HOST_MAX_RX_STREAMS              2
+
 		/* Type Defines: */
 			/** \brief CDC Class Host Mode Configuration and State Structure.
 			 *
@@ -127,6 +145,21 @@
 					                                  *   \ref CDC_Host_SetLineEncoding() function must be called to push the changes
 					                                  *   to the device.
 					                                  */
+
+					struct
+					{
+						uint8_t* Buffer; /**< Receive ring buffer given to \ref CDC_Host_StartReceiving(), \c NULL when the interface
+						                  *   is not streaming.
+						                  */
+						uint16_t Size; /**< Size in bytes of the receive ring buffer. */
+						volatile uint16_t In; /**< Ring buffer write index, advanced by the USB interrupt. */
+						volatile uint16_t Out; /**< Ring buffer read index, advanced as the application reads. */
+						volatile uint8_t Queued; /**< Number of bulk IN transfers currently queued on the data IN pipe. */
+						volatile uint8_t Error; /**< Host controller status of the transfer that stopped the stream, 0 while it runs. */
+						uint16_t TransferSize; /**< Length in bytes of each queued transfer. */
+						uint8_t* TransferBuffer; /**< Buffers of the queued transfers, in the USB RAM. */
+						uint32_t PipeHandle; /**< Handle of the data IN pipe, identifying the stream to the USB interrupt. */
+					} Receive; /**< Receive stream of the data IN pipe, see \ref CDC_Host_StartReceiving(). */
 				} State; /**< State data for the USB class interface within the device. All elements in this section
 						  *   <b>may</b> be set to initial values, but may also be ignored to default to sane values when
 						  *   the interface is enumerated.
@@ -143,6 +176,15 @@
 				CDC_ENUMERROR_PipeConfigurationFailed    = 3, /**< One or more pipes for the specified interface could not be configured correctly. */
 			};
 
+			/** Enum for the possible error codes returned by the \ref CDC_Host_StartReceiving() function. */
+			enum CDC_Host_ReceiveErrorCodes_t
+			{
+				CDC_RECEIVE_NoError                      = 0, /**< The receive stream was started. */
+				CDC_RECEIVE_DeviceDisconnected           = 1, /**< The interface is not bound to a configured device. */
+				CDC_RECEIVE_NoMemory                     = 2, /**< No stream slot or not enough USB RAM for the transfers. */
+				CDC_RECEIVE_PipeError                    = 3, /**< The host controller driver refused the transfers. */
+			};
+
 		/* Function Prototypes: */
 			/** General management task for a given CDC host class interface, required for the correct operation of the interface. This should
 			 *  be called frequently in the main program loop, before the master USB management task \ref USB_USBTask().
@@ -167,6 +209,18 @@
 			                                uint16_t ConfigDescriptorSize,
 			                                void* DeviceConfigDescriptor) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(3);
 
+			/** Host interface configuration routine like \ref CDC_Host_ConfigurePipes(), taking the Configuration Descriptor
+			 *  indexed by \ref USB_Host_GetIndexedConfigDescriptor(): only the interface and endpoint descriptors are looked
+			 *  at, found through the index.
+			 *
+			 *  \param[in,out] CDCInterfaceInfo  Pointer to a structure containing an CDC Class host configuration and state.
+			 *  \param[in]     Config            Pointer to the attached device's indexed Configuration Descriptor.
+			 *
+			 *  \return A value from the \ref CDC_Host_EnumerationFailure_ErrorCodes_t enum.
+			 */
+			uint8_t CDC_Host_ConfigurePipesIndexed(USB_ClassInfo_CDC_Host_t* const CDCInterfaceInfo,
+			                                       const USB_Host_IndexedConfig_t* const Config) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2);
+
 			/** Sets the line encoding for the attached device's virtual serial port. This should be called when the \c LineEncoding
 			 *  values of the interface have been changed to push the new settings to the USB device.
 			 *
@@ -286,6 +340,66 @@
 			 */
 			uint8_t CDC_Host_Flush(USB_ClassInfo_CDC_Host_t* const CDCInterfaceInfo) ATTR_NON_NULL_PTR_ARG(1);
 
+			/** Starts receiving the data IN pipe of the given configured CDC Host interface into a ring buffer. The USB interrupt
+			 *  keeps \ref CDC_HOST_RX_TRANSFERS bulk IN transfers of \ref CDC_HOST_RX_TRANSFER_SIZE bytes queued and copies each
+			 *  finished one into the ring buffer, so the device is read at the full bus rate without the application polling the
+			 *  pipe. A transfer is only queued while the ring buffer has room for it: when the application falls behind the
+			 *  device is NAKed until \ref CDC_Host_Read() frees space, and no data is lost.
+			 *
+			 *  While receiving, \ref CDC_Host_BytesReceived() and \ref CDC_Host_ReceiveByte() work on the ring buffer.
+			 *
+			 *  \note \ref CDC_Host_StopReceiving() must be called before the device is reconfigured or when it is detached.
+			 *
+			 *  \param[in,out] CDCInterfaceInfo  Pointer to a structure containing a CDC Class host configuration and state.
+			 *  \param[in]     Buffer            Ring buffer, kept by the application until \ref CDC_Host_StopReceiving().
+			 *  \param[in]     Size              Size in bytes of the ring buffer, holding up to \c Size - 1 bytes. At least
+			 *                                   \ref CDC_HOST_RX_TRANSFERS transfers plus one byte, more absorbs longer stalls.
+			 *
+			 *  \return A value from the \ref CDC_Host_ReceiveErrorCodes_t enum.
+			 */
+			uint8_t CDC_Host_StartReceiving(USB_ClassInfo_CDC_Host_t* const CDCInterfaceInfo,
+			                                uint8_t* const Buffer,
+			                                const uint16_t Size) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2);
+
+			/** Stops the receive stream started with \ref CDC_Host_StartReceiving(), cancelling its queued transfers. Data still in
+			 *  the ring buffer is dropped.
+			 *
+			 *  \param[in,out] CDCInterfaceInfo  Pointer to a structure containing a CDC Class host configuration and state.
+			 */
+			void CDC_Host_StopReceiving(USB_ClassInfo_CDC_Host_t* const CDCInterfaceInfo) ATTR_NON_NULL_PTR_ARG(1);
+
+			/** Reads up to \c Length bytes received from the device into the given buffer. The data comes from the ring buffer of
+			 *  \ref CDC_Host_StartReceiving() if the interface is receiving, or from the IN pipe otherwise. Does not block.
+			 *
+			 *  \pre This function must only be called when the Host state machine is in the \ref HOST_STATE_Configured state or the
+			 *       call will fail.
+			 *
+			 *  \param[in,out] CDCInterfaceInfo  Pointer to a structure containing a CDC Class host configuration and state.
+			 *  \param[out]    Buffer            Pointer to a buffer where the received data is stored.
+			 *  \param[in]     Length            Size in bytes of the buffer.
+			 *
+			 *  \return Number of bytes read.
+			 */
+			uint16_t CDC_Host_Read(USB_ClassInfo_CDC_Host_t* const CDCInterfaceInfo,
+			                       uint8_t* const Buffer,
+			                       const uint16_t Length) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2);
+
+			/** Sends a given data buffer to the attached USB device and flushes it, so that the whole buffer is on its way to the
+			 *  device once this returns, in transfers of up to \ref PIPE_MAX_SIZE bytes.
+			 *
+			 *  \pre This function must only be called when the Host state machine is in the \ref HOST_STATE_Configured state or the
+			 *       call will fail.
+			 *
+			 *  \param[in,out] CDCInterfaceInfo  Pointer to a structure containing a CDC Class host configuration and state.
+			 *  \param[in]     Buffer            Pointer to a buffer containing the data to send to the device.
+			 *  \param[in]     Length            Length of the data to send to the device.
+			 *
+			 *  \return A value from the \ref Pipe_Stream_RW_ErrorCodes_t enum.
+			 */
+			uint8_t CDC_Host_Write(USB_ClassInfo_CDC_Host_t* const CDCInterfaceInfo,
+			                       const uint8_t* const Buffer,
+			                       const uint16_t Length) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2);
+
 			/** Creates a standard character stream for the given CDC Device instance so that it can be used with all the regular
 			 *  functions in the standard \c <stdio.h> library that accept a \c FILE stream as a destination (e.g. \c fprintf). The created
 			 *  stream is bidirectional and can be used for both input and output functions.
@@ -332,6 +446,12 @@
 	#if !defined(__DOXYGEN__)
 		/* Function Prototypes: */
 			#if defined(__INCLUDE_FROM_CDC_HOST_C)
+				static uint8_t CDC_Host_OpenPipes(USB_ClassInfo_CDC_Host_t* const CDCInterfaceInfo,
+				                                  USB_Descriptor_Interface_t* const CDCControlInterface,
+				                                  USB_Descriptor_Endpoint_t* const DataINEndpoint,
+				                                  USB_Descriptor_Endpoint_t* const DataOUTEndpoint,
+				                                  USB_Descriptor_Endpoint_t* const NotificationEndpoint) ATTR_NON_NULL_PTR_ARG(1);
+
 				#if defined(FDEV_SETUP_STREAM)
 				static int CDC_Host_putchar(char c,
 				                            FILE* Stream) ATTR_NON_NULL_PTR_ARG(2);
@@ -350,6 +470,10 @@
 				                                                   ATTR_WARN_UNUSED_RESULT ATTR_NON_NULL_PTR_ARG(1);
 				static uint8_t DCOMP_CDC_Host_NextCDCInterfaceEndpoint(void* const CurrentDescriptor)
 				                                                       ATTR_WARN_UNUSED_RESULT ATTR_NON_NULL_PTR_ARG(1);
+
+				static uint16_t CDC_Host_RingCount(USB_ClassInfo_CDC_Host_t* const CDCInterfaceInfo) ATTR_NON_NULL_PTR_ARG(1);
+				static void CDC_Host_RearmReceive(USB_ClassInfo_CDC_Host_t* const CDCInterfaceInfo) ATTR_NON_NULL_PTR_ARG(1);
+				static bool CDC_Host_DataINComplete(uint32_t PipeHandle, HCD_STATUS Status, uint8_t* Buffer, uint16_t Length);
 			#endif
 	#endif
 
@@ -47,7 +47,6 @@ uint8_t HID_Host_ConfigurePipes(USB_ClassInfo_HID_Host_t* const HIDInterfaceInfo
 	USB_Descriptor_Endpoint_t*  DataOUTEndpoint = NULL;
 	USB_Descriptor_Interface_t* HIDInterface    = NULL;
 	USB_HID_Descriptor_HID_t*   HIDDescriptor   = NULL;
-	uint8_t portnum = HIDInterfaceInfo->Config.PortNumber;
 
 	memset(&HIDInterfaceInfo->State, 0x00, sizeof(HIDInterfaceInfo->State));
 
@@ -97,6 +96,79 @@ uint8_t HID_Host_ConfigurePipes(USB_ClassInfo_HID_Host_t* const HIDInterfaceInfo
 		  DataOUTEndpoint = EndpointData;
 	}
 
+	return HID_Host_OpenPipes(HIDInterfaceInfo, HIDInterface, HIDDescriptor, DataINEndpoint, DataOUTEndpoint);
+}
+
+uint8_t HID_Host_ConfigurePipesIndexed(USB_ClassInfo_HID_Host_t* const HIDInterfaceInfo,
+                                       const USB_Host_IndexedConfig_t* const Config)
+{
+	USB_Descriptor_Endpoint_t*  DataINEndpoint  = NULL;
+	USB_Descriptor_Endpoint_t*  DataOUTEndpoint = NULL;
+	USB_Descriptor_Interface_t* HIDInterface    = NULL;
+	USB_HID_Descriptor_HID_t*   HIDDescriptor   = NULL;
+	uint8_t InterfaceIndex;
+
+	memset(&HIDInterfaceInfo->State, 0x00, sizeof(HIDInterfaceInfo->State));
+
+	for (InterfaceIndex = 0; ; InterfaceIndex++)
+	{
+		uint8_t EndpointIndex;
+
+		if (USB_GetNextIndexedInterfaceComp(Config, &InterfaceIndex, DCOMP_HID_Host_NextHIDInterface) != DESCRIPTOR_SEARCH_COMP_Found)
+		  return HID_ENUMERROR_NoCompatibleInterfaceFound;
+
+		HIDInterface = USB_GetIndexedInterface(Config, InterfaceIndex);
+
+		if (HIDInterfaceInfo->Config.HIDInterfaceProtocol &&
+		    (HIDInterface->Protocol != HIDInterfaceInfo->Config.HIDInterfaceProtocol))
+		{
+			continue;
+		}
+
+		/* The HID descriptor sits between the interface and its endpoints, search the interface's descriptors only */
+		uint16_t InterfaceSize = Config->Index.Interfaces[InterfaceIndex].Length;
+		void*    InterfaceData = HIDInterface;
+
+		if (USB_GetNextDescriptorComp(&InterfaceSize, &InterfaceData,
+		                              DCOMP_HID_Host_NextHIDDescriptor) != DESCRIPTOR_SEARCH_COMP_Found)
+		{
+			return HID_ENUMERROR_NoCompatibleInterfaceFound;
+		}
+
+		HIDDescriptor = DESCRIPTOR_PCAST(InterfaceData, USB_HID_Descriptor_HID_t);
+
+		for (EndpointIndex = 0; (EndpointIndex < Config->Index.Interfaces[InterfaceIndex].TotalEndpoints) &&
+		                        (!(DataINEndpoint) || !(DataOUTEndpoint)); EndpointIndex++)
+		{
+			USB_Descriptor_Endpoint_t* EndpointData = USB_GetIndexedEndpoint(Config, InterfaceIndex, EndpointIndex);
+
+			if (DCOMP_HID_Host_NextHIDInterfaceEndpoint(EndpointData) != DESCRIPTOR_SEARCH_Found)
+			  continue;
+
+			if ((EndpointData->EndpointAddress & ENDPOINT_DIR_MASK) == ENDPOINT_DIR_IN)
+			  DataINEndpoint  = EndpointData;
+			else
+			  DataOUTEndpoint = EndpointData;
+		}
+
+		/* The OUT endpoint is optional */
+		if (DataINEndpoint)
+		  break;
+
+		DataOUTEndpoint = NULL;
+	}
+
+	return HID_Host_OpenPipes(HIDInterfaceInfo, HIDInterface, HIDDescriptor, DataINEndpoint, DataOUTEndpoint);
+}
+
+static uint8_t HID_Host_OpenPipes(USB_ClassInfo_HID_Host_t* const HIDInterfaceInfo,
+                                  USB_Descriptor_Interface_t* const HIDInterface,
+                                  USB_HID_Descriptor_HID_t* const HIDDescriptor,
+                                  USB_Descriptor_Endpoint_t* const DataINEndpoint,
+                                  USB_Descriptor_Endpoint_t* const DataOUTEndpoint)
+{
+	uint8_t portnum = HIDInterfaceInfo->Config.PortNumber;
+
 	uint8_t PipeNum;
 	for (PipeNum = 1; PipeNum < PIPE_TOTAL_PIPES; PipeNum++)
 	{
@@ -144,8 +216,8 @@ uint8_t HID_Host_ConfigurePipes(USB_ClassInfo_HID_Host_t* const HIDInterfaceInfo
 			return HID_ENUMERROR_PipeConfigurationFailed;
 		}
 		
-		if (InterruptPeriod)
-		  Pipe_SetInterruptPeriod(InterruptPeriod);
+		if (InterruptPeriod && !(Pipe_SetInterruptPeriod(portnum, InterruptPeriod)))
+		  return HID_ENUMERROR_PipeConfigurationFailed;
 	}
 
 	HIDInterfaceInfo->State.InterfaceNumber      = HIDInterface->InterfaceNumber;
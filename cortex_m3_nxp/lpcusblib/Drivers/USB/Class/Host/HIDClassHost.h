@@ -167,6 +167,18 @@
 			                                uint16_t ConfigDescriptorSize,
 			                                void* DeviceConfigDescriptor) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(3);
 
+			/** Host interface configuration routine like \ref HID_Host_ConfigurePipes(), taking the Configuration Descriptor
+			 *  indexed by \ref USB_Host_GetIndexedConfigDescriptor(): only the descriptors of the HID interfaces are looked
+			 *  at, found through the index.
+			 *
+			 *  \param[in,out] HIDInterfaceInfo  Pointer to a structure containing a HID Class host configuration and state.
+			 *  \param[in]     Config            Pointer to the attached device's indexed Configuration Descriptor.
+			 *
+			 *  \return A value from the \ref HID_Host_EnumerationFailure_ErrorCodes_t enum.
+			 */
+			uint8_t HID_Host_ConfigurePipesIndexed(USB_ClassInfo_HID_Host_t* const HIDInterfaceInfo,
+			                                       const USB_Host_IndexedConfig_t* const Config) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2);
+
 
 			/** Receives a HID IN report from the attached HID device, when a report has been received on the HID IN Data pipe.
 			 *
@@ -306,6 +318,11 @@
 	#if !defined(__DOXYGEN__)
 		/* Function Prototypes: */
 			#if defined(__INCLUDE_FROM_HID_HOST_C)
+				static uint8_t HID_Host_OpenPipes(USB_ClassInfo_HID_Host_t* const HIDInterfaceInfo,
+				                                  USB_Descriptor_Interface_t* const HIDInterface,
+				                                  USB_HID_Descriptor_HID_t* const HIDDescriptor,
+				                                  USB_Descriptor_Endpoint_t* const DataINEndpoint,
+				                                  USB_Descriptor_Endpoint_t* const DataOUTEndpoint) ATTR_NON_NULL_PTR_ARG(1);
 				static uint8_t DCOMP_HID_Host_NextHIDInterface(void* const CurrentDescriptor)
 				                                               ATTR_WARN_UNUSED_RESULT ATTR_NON_NULL_PTR_ARG(1);
 				static uint8_t DCOMP_HID_Host_NextHIDDescriptor(void* const CurrentDescriptor)
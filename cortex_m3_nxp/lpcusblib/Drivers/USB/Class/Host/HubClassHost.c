@@ -0,0 +1,512 @@
+/*
+* Copyright(C) NXP Semiconductors, 2011
+* All rights reserved.
+*
+* Copyright (C) Dean Camera, 2011.
+*
+* LUFA Library is licensed from Dean Camera by NXP for NXP customers 
+* for use with NXP's LPC microcontrollers.
+*
+* Software that is described herein is for illustrative purposes only
+* which provides customers with programming information regarding the
+* LPC products.  This software is supplied "AS IS" without any warranties of
+* any kind, and NXP Semiconductors and its licensor disclaim any and 
+* all warranties, express or implied, including all implied warranties of 
+* merchantability, fitness for a particular purpose and non-infringement of 
+* intellectual property rights.  NXP Semiconductors assumes no responsibility
+* or liability for the use of the software, conveys no license or rights under any
+* patent, copyright, mask work right, or any other intellectual property rights in 
+* or to any products. NXP Semiconductors reserves the right to make changes
+* in the software without notification. NXP Semiconductors also makes no 
+* representation or warranty that such application will be suitable for the
+* specified use without further testing or modification.
+* 
+* Permission to use, copy, modify, and distribute this software and its 
+* documentation is hereby granted, under NXP Semiconductors' and its 
+* licensor's relevant copyrights in the software, without fee, provided that it 
+* is used in conjunction with NXP Semiconductors microcontrollers.  This 
+* copyright, permission, and disclaimer notice must appear in all copies of 
+* this code.
+*/
+
+
+#define  __INCLUDE_FROM_USB_DRIVER
+#include "../../Core/USBMode.h"
+
+#if defined(USB_CAN_BE_HOST)
+
+#define  __INCLUDE_FROM_HUB_DRIVER
+#define  __INCLUDE_FROM_HUB_HOST_C
+#include "HubClassHost.h"
+
+static void HUB_Host_ReleasePipe(USB_Pipe_Data_t* const Pipe)
+{
+	if (Pipe->Buffer != NULL)
+	{
+		HcdClosePipe(Pipe->PipeHandle);
+		USB_Memory_Free(Pipe->Buffer);
+	}
+
+	memset(Pipe, 0x00, sizeof(USB_Pipe_Data_t));
+}
+
+/* Releases the control pipes parked in the instance, the pipe in PIPE_CONTROLPIPE is left to the caller */
+static void HUB_Host_ReleasePorts(USB_ClassInfo_HUB_Host_t* const HUBInterfaceInfo)
+{
+	uint8_t Port;
+
+	for (Port = 1; Port <= HUBInterfaceInfo->State.NumberOfPorts; Port++)
+	{
+		if (Port != HUBInterfaceInfo->State.SelectedPort)
+		  HUB_Host_ReleasePipe(&HUBInterfaceInfo->State.Ports[Port - 1].ControlPipe);
+	}
+
+	if (HUBInterfaceInfo->State.SelectedPort)
+	  HUB_Host_ReleasePipe(&HUBInterfaceInfo->State.HubControlPipe);
+}
+
+uint8_t HUB_Host_ConfigurePipes(USB_ClassInfo_HUB_Host_t* const HUBInterfaceInfo,
+                                uint16_t ConfigDescriptorSize,
+                                void* ConfigDescriptorData)
+{
+	USB_Descriptor_Endpoint_t*  StatusEndpoint = NULL;
+	USB_Descriptor_Interface_t* HUBInterface   = NULL;
+	uint8_t portnum = HUBInterfaceInfo->Config.PortNumber;
+
+	if (HUBInterfaceInfo->State.IsActive)
+	  HUB_Host_ReleasePorts(HUBInterfaceInfo);
+
+	memset(&HUBInterfaceInfo->State, 0x00, sizeof(HUBInterfaceInfo->State));
+
+	if (DESCRIPTOR_TYPE(ConfigDescriptorData) != DTYPE_Configuration)
+	  return HUB_ENUMERROR_InvalidConfigDescriptor;
+
+	if (USB_GetNextDescriptorComp(&ConfigDescriptorSize, &ConfigDescriptorData,
+	                              DCOMP_HUB_Host_NextHUBInterface) != DESCRIPTOR_SEARCH_COMP_Found)
+	{
+		return HUB_ENUMERROR_NoCompatibleInterfaceFound;
+	}
+
+	HUBInterface = DESCRIPTOR_PCAST(ConfigDescriptorData, USB_Descriptor_Interface_t);
+
+	if (USB_GetNextDescriptorComp(&ConfigDescriptorSize, &ConfigDescriptorData,
+	                              DCOMP_HUB_Host_NextHUBInterfaceEndpoint) != DESCRIPTOR_SEARCH_COMP_Found)
+	{
+		return HUB_ENUMERROR_NoCompatibleInterfaceFound;
+	}
+
+	StatusEndpoint = DESCRIPTOR_PCAST(ConfigDescriptorData, USB_Descriptor_Endpoint_t);
+
+	Pipe_SetTargetDevice(portnum, 0, FULL_SPEED);
+
+	if (!(Pipe_ConfigurePipe(portnum, HUBInterfaceInfo->Config.StatusPipeNumber, EP_TYPE_INTERRUPT, PIPE_TOKEN_IN,
+	                         StatusEndpoint->EndpointAddress, le16_to_cpu(StatusEndpoint->EndpointSize),
+	                         PIPE_BANK_SINGLE)))
+	{
+		return HUB_ENUMERROR_PipeConfigurationFailed;
+	}
+
+	if (StatusEndpoint->PollingIntervalMS &&
+	    !(Pipe_SetInterruptPeriod(portnum, StatusEndpoint->PollingIntervalMS)))
+	{
+		return HUB_ENUMERROR_PipeConfigurationFailed;
+	}
+
+	HUBInterfaceInfo->State.InterfaceNumber = HUBInterface->InterfaceNumber;
+	HUBInterfaceInfo->State.StatusPipeSize  = le16_to_cpu(StatusEndpoint->EndpointSize);
+	HUBInterfaceInfo->State.IsActive        = true;
+
+	return HUB_ENUMERROR_NoError;
+}
+
+static uint8_t DCOMP_HUB_Host_NextHUBInterface(void* const CurrentDescriptor)
+{
+	USB_Descriptor_Header_t* Header = DESCRIPTOR_PCAST(CurrentDescriptor, USB_Descriptor_Header_t);
+
+	if (Header->Type == DTYPE_Interface)
+	{
+		USB_Descriptor_Interface_t* Interface = DESCRIPTOR_PCAST(CurrentDescriptor, USB_Descriptor_Interface_t);
+
+		if ((Interface->Class    == HUB_CSCP_HubClass) &&
+		    (Interface->SubClass == HUB_CSCP_HubSubclass))
+		{
+			return DESCRIPTOR_SEARCH_Found;
+		}
+	}
+
+	return DESCRIPTOR_SEARCH_NotFound;
+}
+
+static uint8_t DCOMP_HUB_Host_NextHUBInterfaceEndpoint(void* const CurrentDescriptor)
+{
+	USB_Descriptor_Header_t* Header = DESCRIPTOR_PCAST(CurrentDescriptor, USB_Descriptor_Header_t);
+
+	if (Header->Type == DTYPE_Endpoint)
+	{
+		USB_Descriptor_Endpoint_t* Endpoint = DESCRIPTOR_PCAST(CurrentDescriptor, USB_Descriptor_Endpoint_t);
+
+		if (((Endpoint->Attributes & EP_TYPE_MASK) == EP_TYPE_INTERRUPT) &&
+		    ((Endpoint->EndpointAddress & ENDPOINT_DIR_MASK) == ENDPOINT_DIR_IN))
+		{
+			return DESCRIPTOR_SEARCH_Found;
+		}
+	}
+	else if (Header->Type == DTYPE_Interface)
+	{
+		return DESCRIPTOR_SEARCH_Fail;
+	}
+
+	return DESCRIPTOR_SEARCH_NotFound;
+}
+
+static uint8_t HUB_Host_SetPortFeature(USB_ClassInfo_HUB_Host_t* const HUBInterfaceInfo,
+                                       const uint8_t Request,
+                                       const uint8_t Port,
+                                       const uint8_t Feature)
+{
+	USB_ControlRequest = (USB_Request_Header_t)
+		{
+			.bmRequestType = (REQDIR_HOSTTODEVICE | REQTYPE_CLASS | (Port ? REQREC_OTHER : REQREC_DEVICE)),
+			.bRequest      = Request,
+			.wValue        = Feature,
+			.wIndex        = Port,
+			.wLength       = 0,
+		};
+
+	Pipe_SelectPipe(HUBInterfaceInfo->Config.PortNumber, PIPE_CONTROLPIPE);
+
+	return USB_Host_SendControlRequest(HUBInterfaceInfo->Config.PortNumber, NULL);
+}
+
+static uint8_t HUB_Host_GetPortStatus(USB_ClassInfo_HUB_Host_t* const HUBInterfaceInfo,
+                                      const uint8_t Port,
+                                      USB_HUB_PortStatus_t* const Status)
+{
+	uint8_t ErrorCode;
+
+	USB_ControlRequest = (USB_Request_Header_t)
+		{
+			.bmRequestType = (REQDIR_DEVICETOHOST | REQTYPE_CLASS | (Port ? REQREC_OTHER : REQREC_DEVICE)),
+			.bRequest      = REQ_GetStatus,
+			.wValue        = 0,
+			.wIndex        = Port,
+			.wLength       = sizeof(USB_HUB_PortStatus_t),
+		};
+
+	Pipe_SelectPipe(HUBInterfaceInfo->Config.PortNumber, PIPE_CONTROLPIPE);
+
+	if ((ErrorCode = USB_Host_SendControlRequest(HUBInterfaceInfo->Config.PortNumber, Status)) != HOST_SENDCONTROL_Successful)
+	  return ErrorCode;
+
+	Status->PortStatus = le16_to_cpu(Status->PortStatus);
+	Status->PortChange = le16_to_cpu(Status->PortChange);
+
+	return HOST_SENDCONTROL_Successful;
+}
+
+static uint8_t HUB_Host_PowerPorts(USB_ClassInfo_HUB_Host_t* const HUBInterfaceInfo)
+{
+	USB_HUB_Descriptor_Hub_t HubDescriptor;
+	uint8_t ErrorCode;
+	uint8_t Port;
+
+	USB_ControlRequest = (USB_Request_Header_t)
+		{
+			.bmRequestType = (REQDIR_DEVICETOHOST | REQTYPE_CLASS | REQREC_DEVICE),
+			.bRequest      = REQ_GetDescriptor,
+			.wValue        = (HUB_DTYPE_Hub << 8),
+			.wIndex        = 0,
+			.wLength       = sizeof(USB_HUB_Descriptor_Hub_t),
+		};
+
+	Pipe_SelectPipe(HUBInterfaceInfo->Config.PortNumber, PIPE_CONTROLPIPE);
+
+	if ((ErrorCode = USB_Host_SendControlRequest(HUBInterfaceInfo->Config.PortNumber, &HubDescriptor)) != HOST_SENDCONTROL_Successful)
+	  return ErrorCode;
+
+	HUBInterfaceInfo->State.NumberOfPorts = MIN(HubDescriptor.NumberOfPorts, HUB_HOST_MAX_PORTS);
+
+	for (Port = 1; Port <= HUBInterfaceInfo->State.NumberOfPorts; Port++)
+	{
+		if ((ErrorCode = HUB_Host_SetPortFeature(HUBInterfaceInfo, REQ_SetFeature, Port,
+		                                         HUB_FEATURE_PortPower)) != HOST_SENDCONTROL_Successful)
+		{
+			return ErrorCode;
+		}
+	}
+
+	/* PowerOnToPowerGood counts 2ms units, wait twice to stay within the range of USB_Host_WaitMS() */
+	USB_Host_WaitMS(HubDescriptor.PowerOnToPowerGood);
+	USB_Host_WaitMS(HubDescriptor.PowerOnToPowerGood);
+
+	HUBInterfaceInfo->State.PortsPowered = true;
+
+	return HOST_SENDCONTROL_Successful;
+}
+
+static void HUB_Host_DetachPort(USB_ClassInfo_HUB_Host_t* const HUBInterfaceInfo,
+                                const uint8_t Port)
+{
+	USB_HUB_Host_Port_t* PortInfo = &HUBInterfaceInfo->State.Ports[Port - 1];
+	uint8_t portnum = HUBInterfaceInfo->Config.PortNumber;
+
+	if (!(PortInfo->Address))
+	  return;
+
+	HUB_Host_ReleasePipe(&PortInfo->ControlPipe);
+	Pipe_CloseDevicePipes(portnum, PortInfo->Address);
+	USB_Host_FreeDeviceAddress(portnum, PortInfo->Address);
+	PortInfo->Address = 0;
+
+	EVENT_HUB_Host_DeviceDetached(HUBInterfaceInfo, Port);
+}
+
+static uint8_t HUB_Host_EnumeratePort(USB_ClassInfo_HUB_Host_t* const HUBInterfaceInfo,
+                                      const uint8_t Port)
+{
+	USB_HUB_Host_Port_t*    PortInfo = &HUBInterfaceInfo->State.Ports[Port - 1];
+	USB_Descriptor_Device_t DevDescriptor;
+	USB_HUB_PortStatus_t    PortStatus;
+	HCD_USB_SPEED           Speed;
+	uint8_t  portnum   = HUBInterfaceInfo->Config.PortNumber;
+	uint8_t  ErrorCode = HUB_PORTERROR_PipeConfigError;
+	uint8_t  Address;
+	uint16_t ResetFrame;
+
+	/* Connect debounce, then reset the port and wait for the hub to enable it */
+	USB_Host_WaitMS(100);
+
+	if (HUB_Host_SetPortFeature(HUBInterfaceInfo, REQ_SetFeature, Port, HUB_FEATURE_PortReset) != HOST_SENDCONTROL_Successful)
+	  return HUB_PORTERROR_ResetFailed;
+
+	/* The timeout runs on the frame counter, the waits between polls take longer than they ask for */
+	ResetFrame = USB_Host_GetFrameNumber();
+	do
+	{
+		USB_Host_WaitMS(HUB_PORT_RESET_POLL_MS);
+
+		if (HUB_Host_GetPortStatus(HUBInterfaceInfo, Port, &PortStatus) != HOST_SENDCONTROL_Successful)
+		  return HUB_PORTERROR_ResetFailed;
+
+		if (PortStatus.PortChange & HUB_PORT_CHANGE_RESET)
+		  break;
+	}
+	while ((uint16_t) (USB_Host_GetFrameNumber() - ResetFrame) < HUB_PORT_RESET_TIMEOUT_MS);
+
+	HUB_Host_SetPortFeature(HUBInterfaceInfo, REQ_ClearFeature, Port, HUB_FEATURE_CPortReset);
+
+	if (!(PortStatus.PortChange & HUB_PORT_CHANGE_RESET) || !(PortStatus.PortStatus & HUB_PORT_STATUS_ENABLE))
+	  return HUB_PORTERROR_ResetFailed;
+
+	USB_Host_WaitMS(10);
+
+	Speed = (PortStatus.PortStatus & HUB_PORT_STATUS_LOW_SPEED) ? LOW_SPEED : FULL_SPEED;
+
+	if (!(Address = USB_Host_AllocateDeviceAddress(portnum)))
+	  return HUB_PORTERROR_NoAddressLeft;
+
+	/* Park the hub's control pipe, the new device answers on address 0 until SET_ADDRESS */
+	HUBInterfaceInfo->State.HubControlPipe = PipeInfo[portnum][PIPE_CONTROLPIPE];
+	memset(&PipeInfo[portnum][PIPE_CONTROLPIPE], 0x00, sizeof(USB_Pipe_Data_t));
+
+	if (Pipe_ConfigureDevicePipe(portnum, PIPE_CONTROLPIPE, 0, Speed, EP_TYPE_CONTROL, PIPE_TOKEN_SETUP,
+	                             ENDPOINT_CONTROLEP, PIPE_CONTROLPIPE_DEFAULT_SIZE, PIPE_BANK_SINGLE))
+	{
+		USB_ControlRequest = (USB_Request_Header_t)
+			{
+				.bmRequestType = (REQDIR_DEVICETOHOST | REQTYPE_STANDARD | REQREC_DEVICE),
+				.bRequest      = REQ_GetDescriptor,
+				.wValue        = (DTYPE_Device << 8),
+				.wIndex        = 0,
+				.wLength       = 8,
+			};
+
+		Pipe_SelectPipe(portnum, PIPE_CONTROLPIPE);
+		ErrorCode = HUB_PORTERROR_ControlError;
+
+		if (USB_Host_SendControlRequest(portnum, &DevDescriptor) == HOST_SENDCONTROL_Successful)
+		{
+			USB_ControlRequest = (USB_Request_Header_t)
+				{
+					.bmRequestType = (REQDIR_HOSTTODEVICE | REQTYPE_STANDARD | REQREC_DEVICE),
+					.bRequest      = REQ_SetAddress,
+					.wValue        = Address,
+					.wIndex        = 0,
+					.wLength       = 0,
+				};
+
+			if (USB_Host_SendControlRequest(portnum, NULL) == HOST_SENDCONTROL_Successful)
+			  ErrorCode = HUB_ENUMERROR_NoError;
+		}
+	}
+
+	HUB_Host_ReleasePipe(&PipeInfo[portnum][PIPE_CONTROLPIPE]);
+
+	if (ErrorCode == HUB_ENUMERROR_NoError)
+	{
+		/* SET_ADDRESS recovery time */
+		USB_Host_WaitMS(2);
+
+		if (Pipe_ConfigureDevicePipe(portnum, PIPE_CONTROLPIPE, Address, Speed, EP_TYPE_CONTROL, PIPE_TOKEN_SETUP,
+		                             ENDPOINT_CONTROLEP, DevDescriptor.Endpoint0Size, PIPE_BANK_SINGLE))
+		{
+			PortInfo->ControlPipe = PipeInfo[portnum][PIPE_CONTROLPIPE];
+			PortInfo->Address     = Address;
+			PortInfo->Speed       = Speed;
+		}
+		else
+		{
+			HUB_Host_ReleasePipe(&PipeInfo[portnum][PIPE_CONTROLPIPE]);
+			ErrorCode = HUB_PORTERROR_PipeConfigError;
+		}
+	}
+
+	PipeInfo[portnum][PIPE_CONTROLPIPE] = HUBInterfaceInfo->State.HubControlPipe;
+	memset(&HUBInterfaceInfo->State.HubControlPipe, 0x00, sizeof(USB_Pipe_Data_t));
+
+	if (ErrorCode != HUB_ENUMERROR_NoError)
+	  USB_Host_FreeDeviceAddress(portnum, Address);
+
+	return ErrorCode;
+}
+
+static void HUB_Host_ServicePort(USB_ClassInfo_HUB_Host_t* const HUBInterfaceInfo,
+                                 const uint8_t Port)
+{
+	USB_HUB_PortStatus_t PortStatus;
+	uint8_t Feature;
+	uint8_t ErrorCode;
+
+	if (HUB_Host_GetPortStatus(HUBInterfaceInfo, Port, &PortStatus) != HOST_SENDCONTROL_Successful)
+	  return;
+
+	for (Feature = HUB_FEATURE_CPortConnection; Feature <= HUB_FEATURE_CPortReset; Feature++)
+	{
+		if (PortStatus.PortChange & (1 << (Feature - HUB_FEATURE_CPortConnection)))
+		  HUB_Host_SetPortFeature(HUBInterfaceInfo, REQ_ClearFeature, Port, Feature);
+	}
+
+	if ((PortStatus.PortChange & HUB_PORT_CHANGE_CONNECTION) || !(PortStatus.PortStatus & HUB_PORT_STATUS_ENABLE))
+	  HUB_Host_DetachPort(HUBInterfaceInfo, Port);
+
+	if ((PortStatus.PortChange & HUB_PORT_CHANGE_CONNECTION) && (PortStatus.PortStatus & HUB_PORT_STATUS_CONNECTION))
+	{
+		if ((ErrorCode = HUB_Host_EnumeratePort(HUBInterfaceInfo, Port)) == HUB_ENUMERROR_NoError)
+		  EVENT_HUB_Host_DeviceAttached(HUBInterfaceInfo, Port);
+		else
+		  EVENT_HUB_Host_DeviceEnumerationFailed(HUBInterfaceInfo, Port, ErrorCode);
+	}
+
+	/* The event handlers may have selected a device, the next port's requests go to the hub */
+	HUB_Host_SelectDevice(HUBInterfaceInfo, 0);
+}
+
+void HUB_Host_USBTask(USB_ClassInfo_HUB_Host_t* const HUBInterfaceInfo)
+{
+	uint8_t portnum = HUBInterfaceInfo->Config.PortNumber;
+	uint8_t ChangeMap[(HUB_HOST_MAX_PORTS / 8) + 1];
+	uint8_t Port;
+
+	if ((USB_HostState[portnum] == HOST_STATE_Unattached) && HUBInterfaceInfo->State.IsActive)
+	{
+		/* The hub was unplugged, the pipes in PipeInfo are already closed */
+		HUB_Host_ReleasePorts(HUBInterfaceInfo);
+		HUBInterfaceInfo->State.IsActive = false;
+		return;
+	}
+
+	if ((USB_HostState[portnum] != HOST_STATE_Configured) || !(HUBInterfaceInfo->State.IsActive))
+	  return;
+
+	HUB_Host_SelectDevice(HUBInterfaceInfo, 0);
+
+	if (!(HUBInterfaceInfo->State.PortsPowered))
+	{
+		HUB_Host_PowerPorts(HUBInterfaceInfo);
+		return;
+	}
+
+	Pipe_SelectPipe(portnum, HUBInterfaceInfo->Config.StatusPipeNumber);
+	Pipe_Unfreeze();
+
+	if (!(Pipe_IsINReceived(portnum)))
+	{
+		Pipe_Freeze();
+		return;
+	}
+
+	memset(ChangeMap, 0x00, sizeof(ChangeMap));
+
+	for (Port = 0; (Port < sizeof(ChangeMap)) && Pipe_BytesInPipe(portnum); Port++)
+	  ChangeMap[Port] = Pipe_Read_8(portnum);
+
+	Pipe_ClearIN(portnum);
+	Pipe_Freeze();
+
+	if (ChangeMap[0] & 0x01)
+	{
+		USB_HUB_PortStatus_t HubStatus;
+
+		/* Local power or over-current change of the hub itself, acknowledge it */
+		if (HUB_Host_GetPortStatus(HUBInterfaceInfo, 0, &HubStatus) == HOST_SENDCONTROL_Successful)
+		{
+			if (HubStatus.PortChange & 0x01)
+			  HUB_Host_SetPortFeature(HUBInterfaceInfo, REQ_ClearFeature, 0, HUB_FEATURE_CHubLocalPower);
+			if (HubStatus.PortChange & 0x02)
+			  HUB_Host_SetPortFeature(HUBInterfaceInfo, REQ_ClearFeature, 0, HUB_FEATURE_CHubOverCurrent);
+		}
+	}
+
+	for (Port = 1; Port <= HUBInterfaceInfo->State.NumberOfPorts; Port++)
+	{
+		if (ChangeMap[Port >> 3] & (1 << (Port & 0x07)))
+		  HUB_Host_ServicePort(HUBInterfaceInfo, Port);
+	}
+}
+
+bool HUB_Host_SelectDevice(USB_ClassInfo_HUB_Host_t* const HUBInterfaceInfo,
+                           const uint8_t Port)
+{
+	uint8_t portnum = HUBInterfaceInfo->Config.PortNumber;
+
+	if ((Port > HUBInterfaceInfo->State.NumberOfPorts) || (Port && !(HUBInterfaceInfo->State.Ports[Port - 1].Address)))
+	  return false;
+
+	if (Port != HUBInterfaceInfo->State.SelectedPort)
+	{
+		if (HUBInterfaceInfo->State.SelectedPort)
+		  HUBInterfaceInfo->State.Ports[HUBInterfaceInfo->State.SelectedPort - 1].ControlPipe = PipeInfo[portnum][PIPE_CONTROLPIPE];
+		else
+		  HUBInterfaceInfo->State.HubControlPipe = PipeInfo[portnum][PIPE_CONTROLPIPE];
+
+		if (Port)
+		  PipeInfo[portnum][PIPE_CONTROLPIPE] = HUBInterfaceInfo->State.Ports[Port - 1].ControlPipe;
+		else
+		  PipeInfo[portnum][PIPE_CONTROLPIPE] = HUBInterfaceInfo->State.HubControlPipe;
+
+		HUBInterfaceInfo->State.SelectedPort = Port;
+	}
+
+	if (Port)
+	  Pipe_SetTargetDevice(portnum, HUBInterfaceInfo->State.Ports[Port - 1].Address, HUBInterfaceInfo->State.Ports[Port - 1].Speed);
+	else
+	  Pipe_SetTargetDevice(portnum, 0, FULL_SPEED);
+
+	Pipe_SelectPipe(portnum, PIPE_CONTROLPIPE);
+
+	return true;
+}
+
+void HUB_Host_Event_Stub(USB_ClassInfo_HUB_Host_t* const HUBInterfaceInfo, const uint8_t Port)
+{
+
+}
+
+void HUB_Host_Event_Stub2(USB_ClassInfo_HUB_Host_t* const HUBInterfaceInfo, const uint8_t Port,
+                          const uint8_t ErrorCode)
+{
+
+}
+
+#endif
+
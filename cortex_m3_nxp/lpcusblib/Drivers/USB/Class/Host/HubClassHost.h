@@ -0,0 +1,259 @@
+/*
+* Copyright(C) NXP Semiconductors, 2011
+* All rights reserved.
+*
+* Copyright (C) Dean Camera, 2011.
+*
+* LUFA Library is licensed from Dean Camera by NXP for NXP customers 
+* for use with NXP's LPC microcontrollers.
+*
+* Software that is described herein is for illustrative purposes only
+* which provides customers with programming information regarding the
+* LPC products.  This software is supplied "AS IS" without any warranties of
+* any kind, and NXP Semiconductors and its licensor disclaim any and 
+* all warranties, express or implied, including all implied warranties of 
+* merchantability, fitness for a particular purpose and non-infringement of 
+* intellectual property rights.  NXP Semiconductors assumes no responsibility
+* or liability for the use of the software, conveys no license or rights under any
+* patent, copyright, mask work right, or any other intellectual property rights in 
+* or to any products. NXP Semiconductors reserves the right to make changes
+* in the software without notification. NXP Semiconductors also makes no 
+* representation or warranty that such application will be suitable for the
+* specified use without further testing or modification.
+* 
+* Permission to use, copy, modify, and distribute this software and its 
+* documentation is hereby granted, under NXP Semiconductors' and its 
+* licensor's relevant copyrights in the software, without fee, provided that it 
+* is used in conjunction with NXP Semiconductors microcontrollers.  This 
+* copyright, permission, and disclaimer notice must appear in all copies of 
+* this code.
+*/
+
+
+
+/** \file
+ *  \brief Host mode driver for the library USB Hub Class driver.
+ *
+ *  Host mode driver for the library USB Hub Class driver.
+ *
+ *  \note This file should not be included directly. It is automatically included as needed by the USB module driver
+ *        dispatch header located in LPCUSBlib/Drivers/USB.h.
+ */
+
+/** \ingroup Group_USBClassHub
+ *  \defgroup Group_USBClassHubHost Hub Class Host Mode Driver
+ *
+ *  \section Sec_Dependencies Module Source Dependencies
+ *  The following files must be built with any user project that uses this module:
+ *    - LPCUSBlib/Drivers/USB/Class/Host/HubClassHost.c <i>(Makefile source module name: LPCUSBlib_SRC_USBCLASS)</i>
+ *
+ *  \section Sec_ModDescription Module Description
+ *  Host Mode USB Class driver framework interface, for a full speed Hub attached to the root port. Each device plugged
+ *  into the hub is reset, given its own address (see \ref USB_Host_AllocateDeviceAddress()) and its own control pipe,
+ *  after which \ref EVENT_HUB_Host_DeviceAttached() fires. Select the device with \ref HUB_Host_SelectDevice() and set it
+ *  up with the usual calls (\ref USB_Host_GetDeviceConfigDescriptor(), the class driver's \c *_Host_ConfigurePipes() and
+ *  \ref USB_Host_SetDeviceConfiguration()); every class driver instance needs its own pipe numbers. The data pipes stay
+ *  bound to their device, so bulk transfers of several devices may then be interleaved freely and share the bulk list;
+ *  only class requests over the control pipe need the device to be selected first.
+ *
+ *  Hubs plugged into the hub are reported as ordinary devices, nested hubs are not driven by this module.
+ *
+ *  @{
+ */
+
+#ifndef __HUB_CLASS_HOST_H__
+#define __HUB_CLASS_HOST_H__
+
+	/* Includes: */
+		#include "../../USB.h"
+		#include "../Common/HubClassCommon.h"
+
+	/* Enable C linkage for C++ Compilers: */
+		#if defined(__cplusplus)
+			extern "C" {
+		#endif
+
+	/* Preprocessor Checks: */
+		#if !defined(__INCLUDE_FROM_HUB_DRIVER)
+			#error Do not include this file directly. Include LPCUSBlib/Drivers/USB.h instead.
+		#endif
+
+	/* Public Interface - May be used in end-application: */
+		/* Macros: */
+			#if !defined(HUB_HOST_MAX_PORTS) || defined(__DOXYGEN__)
+				/** Number of downstream ports of a hub that are serviced, ports above it are left unpowered. May be
+				 *  overridden in the user project makefile with the -D switch.
+				 */
+				#define HUB_HOST_MAX_PORTS          4
+			#endif
+
+		/* Type Defines: */
+			/** \brief Device attached to a downstream port of a hub. */
+			typedef struct
+			{
+				uint8_t          Address; /**< USB address given to the device, 0 if the port is empty. */
+				HCD_USB_SPEED    Speed; /**< Speed of the device, \c FULL_SPEED or \c LOW_SPEED. */
+				USB_Pipe_Data_t  ControlPipe; /**< The device's control pipe while it is not the selected device. */
+			} USB_HUB_Host_Port_t;
+
+			/** \brief Hub Class Host Mode Configuration and State Structure.
+			 *
+			 *  Class state structure. An instance of this structure should be made within the user application,
+			 *  and passed to each of the Hub class driver functions as the \c HUBInterfaceInfo parameter. This
+			 *  stores each Hub interface's configuration and state information.
+			 */
+			typedef struct
+			{
+				const struct
+				{
+					uint8_t  StatusPipeNumber; /**< Pipe number of the Hub interface's status change IN pipe. */
+					uint8_t  PortNumber;		/**< Port number that this interface is running.
+												*/
+				} Config; /**< Config data for the USB class interface within the device. All elements in this section
+				           *   <b>must</b> be set or the interface will fail to enumerate and operate correctly.
+				           */
+				struct
+				{
+					bool IsActive; /**< Indicates if the current interface instance is connected to an attached device, valid
+					                *   after \ref HUB_Host_ConfigurePipes() is called and the Host state machine is in the
+					                *   Configured state.
+					                */
+					bool PortsPowered; /**< Indicates that the hub descriptor was read and the downstream ports powered. */
+					uint8_t InterfaceNumber; /**< Interface index of the Hub interface within the attached device. */
+					uint16_t StatusPipeSize; /**< Size in bytes of the Hub interface's status change IN pipe. */
+
+					uint8_t NumberOfPorts; /**< Number of downstream ports serviced, at most \ref HUB_HOST_MAX_PORTS. */
+					uint8_t SelectedPort; /**< Port whose device owns the control pipe, 0 for the hub itself. */
+					USB_Pipe_Data_t HubControlPipe; /**< The hub's control pipe while a downstream device is selected. */
+					USB_HUB_Host_Port_t Ports[HUB_HOST_MAX_PORTS]; /**< Devices on the downstream ports, index 0 is port 1. */
+				} State; /**< State data for the USB class interface within the device. All elements in this section
+						  *   <b>may</b> be set to initial values, but may also be ignored to default to sane values when
+						  *   the interface is enumerated.
+						  */
+			} USB_ClassInfo_HUB_Host_t;
+
+		/* Enums: */
+			/** Enum for the possible error codes returned by the \ref HUB_Host_ConfigurePipes() function. */
+			enum HUB_Host_EnumerationFailure_ErrorCodes_t
+			{
+				HUB_ENUMERROR_NoError                    = 0, /**< Configuration Descriptor was processed successfully. */
+				HUB_ENUMERROR_InvalidConfigDescriptor    = 1, /**< The device returned an invalid Configuration Descriptor. */
+				HUB_ENUMERROR_NoCompatibleInterfaceFound = 2, /**< A compatible Hub interface was not found in the device's Configuration Descriptor. */
+				HUB_ENUMERROR_PipeConfigurationFailed    = 3, /**< One or more pipes for the specified interface could not be configured correctly. */
+			};
+
+			/** Enum for the error codes passed to \ref EVENT_HUB_Host_DeviceEnumerationFailed(). */
+			enum HUB_Host_PortEnumeration_ErrorCodes_t
+			{
+				HUB_PORTERROR_ResetFailed                = 1, /**< The hub did not complete the port reset, or disabled the port. */
+				HUB_PORTERROR_NoAddressLeft              = 2, /**< All device addresses of the host are in use. */
+				HUB_PORTERROR_PipeConfigError            = 3, /**< The device's control pipe could not be opened (no free pipe or memory). */
+				HUB_PORTERROR_ControlError               = 4, /**< The device failed GET_DESCRIPTOR or SET_ADDRESS. */
+			};
+
+		/* Function Prototypes: */
+			/** Host interface configuration routine, to configure a given Hub host interface instance using the
+			 *  Configuration Descriptor read from an attached USB device. This function automatically updates the given Hub
+			 *  instance's state values and configures the status change pipe if a hub interface is found within the device.
+			 *  This should be called once after the stack has enumerated the attached device, while the host state machine
+			 *  is in the Addressed state. The downstream ports are powered by \ref HUB_Host_USBTask() once the device is
+			 *  configured.
+			 *
+			 *  \param[in,out] HUBInterfaceInfo        Pointer to a structure containing a Hub Class host configuration and state.
+			 *  \param[in]     ConfigDescriptorSize    Length of the attached device's Configuration Descriptor.
+			 *  \param[in]     DeviceConfigDescriptor  Pointer to a buffer containing the attached device's Configuration Descriptor.
+			 *
+			 *  \return A value from the \ref HUB_Host_EnumerationFailure_ErrorCodes_t enum.
+			 */
+			uint8_t HUB_Host_ConfigurePipes(USB_ClassInfo_HUB_Host_t* const HUBInterfaceInfo,
+			                                uint16_t ConfigDescriptorSize,
+			                                void* DeviceConfigDescriptor) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(3);
+
+			/** General management task for a given Hub host class interface, required for the correct operation of
+			 *  the interface. This should be called frequently in the main program loop, before the master USB management task
+			 *  \ref USB_USBTask(). It powers the ports, polls the status change pipe and enumerates or releases the devices
+			 *  on ports that changed; the hub itself is left selected on return.
+			 *
+			 *  \param[in,out] HUBInterfaceInfo  Pointer to a structure containing a Hub Class host configuration and state.
+			 */
+			void HUB_Host_USBTask(USB_ClassInfo_HUB_Host_t* const HUBInterfaceInfo) ATTR_NON_NULL_PTR_ARG(1);
+
+			/** Makes the device on the given downstream port the target of the control pipe (\c PIPE_CONTROLPIPE) and of
+			 *  pipes configured from now on, so that the standard requests and the class drivers talk to it. Port 0
+			 *  selects the hub itself again.
+			 *
+			 *  \param[in,out] HUBInterfaceInfo  Pointer to a structure containing a Hub Class host configuration and state.
+			 *  \param[in]     Port              Downstream port number (1 to \c NumberOfPorts), or 0 for the hub.
+			 *
+			 *  \return Boolean \c true if the device was selected, \c false if the port holds no enumerated device.
+			 */
+			bool HUB_Host_SelectDevice(USB_ClassInfo_HUB_Host_t* const HUBInterfaceInfo,
+			                           const uint8_t Port) ATTR_NON_NULL_PTR_ARG(1);
+
+			/** Hub class driver event for a device that was enumerated on a downstream port. The device has its address and
+			 *  control pipe and is ready to be selected with \ref HUB_Host_SelectDevice() and configured.
+			 *
+			 *  \param[in,out] HUBInterfaceInfo  Pointer to a structure containing a Hub Class host configuration and state.
+			 *  \param[in]     Port              Downstream port number the device is attached to.
+			 */
+			void EVENT_HUB_Host_DeviceAttached(USB_ClassInfo_HUB_Host_t* const HUBInterfaceInfo,
+			                                   const uint8_t Port) ATTR_NON_NULL_PTR_ARG(1);
+
+			/** Hub class driver event for a device removed from a downstream port (or from a port the hub disabled). All
+			 *  pipes bound to the device have been closed, class driver instances using them must be marked inactive.
+			 *
+			 *  \param[in,out] HUBInterfaceInfo  Pointer to a structure containing a Hub Class host configuration and state.
+			 *  \param[in]     Port              Downstream port number the device was attached to.
+			 */
+			void EVENT_HUB_Host_DeviceDetached(USB_ClassInfo_HUB_Host_t* const HUBInterfaceInfo,
+			                                   const uint8_t Port) ATTR_NON_NULL_PTR_ARG(1);
+
+			/** Hub class driver event for a device on a downstream port that could not be enumerated.
+			 *
+			 *  \param[in,out] HUBInterfaceInfo  Pointer to a structure containing a Hub Class host configuration and state.
+			 *  \param[in]     Port              Downstream port number the device is attached to.
+			 *  \param[in]     ErrorCode         A value from the \ref HUB_Host_PortEnumeration_ErrorCodes_t enum.
+			 */
+			void EVENT_HUB_Host_DeviceEnumerationFailed(USB_ClassInfo_HUB_Host_t* const HUBInterfaceInfo,
+			                                            const uint8_t Port,
+			                                            const uint8_t ErrorCode) ATTR_NON_NULL_PTR_ARG(1);
+
+	/* Private Interface - For use in library only: */
+	#if !defined(__DOXYGEN__)
+		/* Macros: */
+			#define HUB_PORT_RESET_POLL_MS          10
+			#define HUB_PORT_RESET_TIMEOUT_MS       500
+
+		/* Function Prototypes: */
+			#if defined(__INCLUDE_FROM_HUB_HOST_C)
+				static uint8_t DCOMP_HUB_Host_NextHUBInterface(void* const CurrentDescriptor)
+				                                               ATTR_WARN_UNUSED_RESULT ATTR_NON_NULL_PTR_ARG(1);
+				static uint8_t DCOMP_HUB_Host_NextHUBInterfaceEndpoint(void* const CurrentDescriptor)
+				                                                       ATTR_WARN_UNUSED_RESULT ATTR_NON_NULL_PTR_ARG(1);
+
+				void HUB_Host_Event_Stub(USB_ClassInfo_HUB_Host_t* const HUBInterfaceInfo, const uint8_t Port) ATTR_CONST;
+				void HUB_Host_Event_Stub2(USB_ClassInfo_HUB_Host_t* const HUBInterfaceInfo, const uint8_t Port,
+				                          const uint8_t ErrorCode) ATTR_CONST;
+
+PRAGMA_WEAK(EVENT_HUB_Host_DeviceAttached,HUB_Host_Event_Stub)
+				void EVENT_HUB_Host_DeviceAttached(USB_ClassInfo_HUB_Host_t* const HUBInterfaceInfo, const uint8_t Port)
+				                                   ATTR_WEAK ATTR_NON_NULL_PTR_ARG(1) ATTR_ALIAS(HUB_Host_Event_Stub);
+PRAGMA_WEAK(EVENT_HUB_Host_DeviceDetached,HUB_Host_Event_Stub)
+				void EVENT_HUB_Host_DeviceDetached(USB_ClassInfo_HUB_Host_t* const HUBInterfaceInfo, const uint8_t Port)
+				                                   ATTR_WEAK ATTR_NON_NULL_PTR_ARG(1) ATTR_ALIAS(HUB_Host_Event_Stub);
+PRAGMA_WEAK(EVENT_HUB_Host_DeviceEnumerationFailed,HUB_Host_Event_Stub2)
+				void EVENT_HUB_Host_DeviceEnumerationFailed(USB_ClassInfo_HUB_Host_t* const HUBInterfaceInfo, const uint8_t Port,
+				                                            const uint8_t ErrorCode)
+				                                            ATTR_WEAK ATTR_NON_NULL_PTR_ARG(1) ATTR_ALIAS(HUB_Host_Event_Stub2);
+			#endif
+	#endif
+
+	/* Disable C linkage for C++ Compilers: */
+		#if defined(__cplusplus)
+			}
+		#endif
+
+#endif
+
+/** @} */
+
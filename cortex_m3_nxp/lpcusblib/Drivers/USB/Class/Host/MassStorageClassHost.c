@@ -46,7 +46,6 @@ uint8_t MS_Host_ConfigurePipes(USB_ClassInfo_MS_Host_t* const MSInterfaceInfo,
 	USB_Descriptor_Endpoint_t*  DataINEndpoint       = NULL;
 	USB_Descriptor_Endpoint_t*  DataOUTEndpoint      = NULL;
 	USB_Descriptor_Interface_t* MassStorageInterface = NULL;
-	uint8_t portnum = MSInterfaceInfo->Config.PortNumber;
 
 	memset(&MSInterfaceInfo->State, 0x00, sizeof(MSInterfaceInfo->State));
 
@@ -81,6 +80,56 @@ uint8_t MS_Host_ConfigurePipes(USB_ClassInfo_MS_Host_t* const MSInterfaceInfo,
 		  DataOUTEndpoint = EndpointData;
 	}
 
+	return MS_Host_OpenPipes(MSInterfaceInfo, MassStorageInterface, DataINEndpoint, DataOUTEndpoint);
+}
+
+uint8_t MS_Host_ConfigurePipesIndexed(USB_ClassInfo_MS_Host_t* const MSInterfaceInfo,
+                                      const USB_Host_IndexedConfig_t* const Config)
+{
+	USB_Descriptor_Endpoint_t*  DataINEndpoint  = NULL;
+	USB_Descriptor_Endpoint_t*  DataOUTEndpoint = NULL;
+	uint8_t InterfaceIndex;
+
+	memset(&MSInterfaceInfo->State, 0x00, sizeof(MSInterfaceInfo->State));
+
+	for (InterfaceIndex = 0; ; InterfaceIndex++)
+	{
+		uint8_t EndpointIndex;
+
+		if (USB_GetNextIndexedInterfaceComp(Config, &InterfaceIndex, DCOMP_MS_Host_NextMSInterface) != DESCRIPTOR_SEARCH_COMP_Found)
+		  return MS_ENUMERROR_NoCompatibleInterfaceFound;
+
+		DataINEndpoint  = NULL;
+		DataOUTEndpoint = NULL;
+
+		for (EndpointIndex = 0; (EndpointIndex < Config->Index.Interfaces[InterfaceIndex].TotalEndpoints) &&
+		                        (!(DataINEndpoint) || !(DataOUTEndpoint)); EndpointIndex++)
+		{
+			USB_Descriptor_Endpoint_t* EndpointData = USB_GetIndexedEndpoint(Config, InterfaceIndex, EndpointIndex);
+
+			if (DCOMP_MS_Host_NextMSInterfaceEndpoint(EndpointData) != DESCRIPTOR_SEARCH_Found)
+			  continue;
+
+			if ((EndpointData->EndpointAddress & ENDPOINT_DIR_MASK) == ENDPOINT_DIR_IN)
+			  DataINEndpoint  = EndpointData;
+			else
+			  DataOUTEndpoint = EndpointData;
+		}
+
+		if (DataINEndpoint && DataOUTEndpoint)
+		  break;
+	}
+
+	return MS_Host_OpenPipes(MSInterfaceInfo, USB_GetIndexedInterface(Config, InterfaceIndex), DataINEndpoint, DataOUTEndpoint);
+}
+
+static uint8_t MS_Host_OpenPipes(USB_ClassInfo_MS_Host_t* const MSInterfaceInfo,
+                                 USB_Descriptor_Interface_t* const MassStorageInterface,
+                                 USB_Descriptor_Endpoint_t* const DataINEndpoint,
+                                 USB_Descriptor_Endpoint_t* const DataOUTEndpoint)
+{
+	uint8_t portnum = MSInterfaceInfo->Config.PortNumber;
+
 	uint8_t PipeNum;
 	for (PipeNum = 1; PipeNum < PIPE_TOTAL_PIPES; PipeNum++)
 	{
@@ -170,9 +219,8 @@ static uint8_t DCOMP_MS_Host_NextMSInterfaceEndpoint(void* const CurrentDescript
 	return DESCRIPTOR_SEARCH_NotFound;
 }
 
-static uint8_t MS_Host_SendCommand(USB_ClassInfo_MS_Host_t* const MSInterfaceInfo,
-                                   MS_CommandBlockWrapper_t* const SCSICommandBlock,
-                                   const void* const BufferPtr)
+static uint8_t MS_Host_SendCommandBlock(USB_ClassInfo_MS_Host_t* const MSInterfaceInfo,
+                                        MS_CommandBlockWrapper_t* const SCSICommandBlock)
 {
 	uint8_t ErrorCode = PIPE_RWSTREAM_NoError;
 	uint8_t portnum = MSInterfaceInfo->Config.PortNumber;
@@ -197,6 +245,18 @@ static uint8_t MS_Host_SendCommand(USB_ClassInfo_MS_Host_t* const MSInterfaceInf
 
 	Pipe_Freeze();
 
+	return PIPE_RWSTREAM_NoError;
+}
+
+static uint8_t MS_Host_SendCommand(USB_ClassInfo_MS_Host_t* const MSInterfaceInfo,
+                                   MS_CommandBlockWrapper_t* const SCSICommandBlock,
+                                   const void* const BufferPtr)
+{
+	uint8_t ErrorCode = PIPE_RWSTREAM_NoError;
+
+	if ((ErrorCode = MS_Host_SendCommandBlock(MSInterfaceInfo, SCSICommandBlock)) != PIPE_RWSTREAM_NoError)
+	  return ErrorCode;
+
 	if (BufferPtr != NULL)
 	{
 		ErrorCode = MS_Host_SendReceiveData(MSInterfaceInfo, SCSICommandBlock, (void*)BufferPtr);
@@ -602,6 +662,66 @@ uint8_t MS_Host_ReadDeviceBlocks(USB_ClassInfo_MS_Host_t* const MSInterfaceInfo,
 	return PIPE_RWSTREAM_NoError;
 }
 
+uint8_t MS_Host_ReadDeviceBlocksStream(USB_ClassInfo_MS_Host_t* const MSInterfaceInfo,
+                                       const uint8_t LUNIndex,
+                                       const uint32_t BlockAddress,
+                                       const uint16_t Blocks,
+                                       const uint16_t BlockSize,
+                                       Pipe_StreamChunkCallback_t Callback,
+                                       void* const Context)
+{
+	if ((USB_HostState[MSInterfaceInfo->Config.PortNumber] != HOST_STATE_Configured) || !(MSInterfaceInfo->State.IsActive))
+	  return HOST_SENDCONTROL_DeviceDisconnected;
+
+	uint8_t ErrorCode;
+	uint8_t portnum = MSInterfaceInfo->Config.PortNumber;
+
+	MS_CommandBlockWrapper_t SCSICommandBlock = (MS_CommandBlockWrapper_t)
+		{
+			.DataTransferLength = cpu_to_le32((uint32_t)Blocks * BlockSize),
+			.Flags              = MS_COMMAND_DIR_DATA_IN,
+			.LUN                = LUNIndex,
+			.SCSICommandLength  = 10,
+			.SCSICommandData    =
+				{
+					SCSI_CMD_READ_10,
+					0x00,                   // Unused (control bits, all off)
+					(BlockAddress >> 24),   // MSB of Block Address
+					(BlockAddress >> 16),
+					(BlockAddress >> 8),
+					(BlockAddress & 0xFF),  // LSB of Block Address
+					0x00,                   // Reserved
+					(Blocks >> 8),          // MSB of Total Blocks to Read
+					(Blocks & 0xFF),        // LSB of Total Blocks to Read
+					0x00                    // Unused (control)
+				}
+		};
+
+	if ((ErrorCode = MS_Host_SendCommandBlock(MSInterfaceInfo, &SCSICommandBlock)) != PIPE_RWSTREAM_NoError)
+	  return ErrorCode;
+
+	Pipe_SelectPipe(portnum,MSInterfaceInfo->Config.DataINPipeNumber);
+	Pipe_Unfreeze();
+
+	ErrorCode = Pipe_Read_Stream_Chunked(portnum, (uint32_t)Blocks * BlockSize, MS_HOST_STREAM_CHUNK_SIZE,
+	                                     Callback, Context, NULL);
+	Pipe_Freeze();
+
+	if (ErrorCode == PIPE_RWSTREAM_PipeStalled)
+	{
+		/* Device ended the data stage with a STALL, the status wrapper still follows */
+		Pipe_ClearStall(portnum);
+		USB_Host_ClearEndpointStall(portnum,Pipe_GetBoundEndpointAddress(portnum));
+	}
+	else if (ErrorCode != PIPE_RWSTREAM_NoError)
+	{
+		return ErrorCode;
+	}
+
+	MS_CommandStatusWrapper_t SCSIStatusBlock;
+	return MS_Host_GetReturnedStatus(MSInterfaceInfo, &SCSIStatusBlock);
+}
+
 uint8_t MS_Host_WriteDeviceBlocks(USB_ClassInfo_MS_Host_t* const MSInterfaceInfo,
                                   const uint8_t LUNIndex,
                                   const uint32_t BlockAddress,
@@ -75,6 +75,13 @@
 			/** Error code for some Mass Storage Host functions, indicating a logical (and not hardware) error. */
 			#define MS_ERROR_LOGICAL_CMD_FAILED              0x80
 
+			#if !defined(MS_HOST_STREAM_CHUNK_SIZE) || defined(__DOXYGEN__)
+				/** Size in bytes of each chunk delivered by \ref MS_Host_ReadDeviceBlocksStream(). Two buffers of this size
+				 *  are taken from the USB memory pool for the duration of the read.
+				 */
+				#define MS_HOST_STREAM_CHUNK_SIZE            1024
+			#endif
+
 		/* Type Defines: */
 			/** \brief Mass Storage Class Host Mode Configuration and State Structure.
 			 *
@@ -152,6 +159,18 @@
 			                               uint16_t ConfigDescriptorSize,
 			                               void* ConfigDescriptorData) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(3);
 
+			/** Host interface configuration routine like \ref MS_Host_ConfigurePipes(), taking the Configuration Descriptor
+			 *  indexed by \ref USB_Host_GetIndexedConfigDescriptor(): only the interface and endpoint descriptors are looked
+			 *  at, found through the index.
+			 *
+			 *  \param[in,out] MSInterfaceInfo  Pointer to a structure containing an MS Class host configuration and state.
+			 *  \param[in]     Config           Pointer to the attached device's indexed Configuration Descriptor.
+			 *
+			 *  \return A value from the \ref MS_Host_EnumerationFailure_ErrorCodes_t enum.
+			 */
+			uint8_t MS_Host_ConfigurePipesIndexed(USB_ClassInfo_MS_Host_t* const MSInterfaceInfo,
+			                                      const USB_Host_IndexedConfig_t* const Config) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2);
+
 			/** Sends a MASS STORAGE RESET control request to the attached device, resetting the Mass Storage Interface
 			 *  and readying it for the next Mass Storage command. This should be called after a failed SCSI request to 
 			 *  ensure the attached Mass Storage device is ready to receive the next command.
@@ -275,6 +294,33 @@
 			                                 const uint16_t BlockSize,
 			                                 void* BlockBuffer) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(6);
 
+			/** Reads blocks of data from the attached Mass Storage device's medium, handing the data to the given callback
+			 *  in chunks of \ref MS_HOST_STREAM_CHUNK_SIZE bytes as soon as each chunk arrives. The next chunk is already
+			 *  being received by the host controller while the callback processes the current one, so the application
+			 *  can work on the data (e.g. write it to another medium or hash it) while the bus keeps transferring. Unlike
+			 *  \ref MS_Host_ReadDeviceBlocks(), up to 65535 blocks can be read with a single command.
+			 *
+			 *  \pre This function must only be called when the Host state machine is in the \ref HOST_STATE_Configured state or the
+			 *       call will fail.
+			 *
+			 *  \param[in,out] MSInterfaceInfo  Pointer to a structure containing a MS Class host configuration and state.
+			 *  \param[in]     LUNIndex         LUN index within the device the command is being issued to.
+			 *  \param[in]     BlockAddress     Starting block address within the device to read from.
+			 *  \param[in]     Blocks           Total number of blocks to read.
+			 *  \param[in]     BlockSize        Size in bytes of each block within the device.
+			 *  \param[in]     Callback         Function called with each received chunk of data.
+			 *  \param[in]     Context          User context pointer passed to the callback.
+			 *
+			 *  \return A value from the \ref Pipe_Stream_RW_ErrorCodes_t enum or \ref MS_ERROR_LOGICAL_CMD_FAILED if not ready.
+			 */
+			uint8_t MS_Host_ReadDeviceBlocksStream(USB_ClassInfo_MS_Host_t* const MSInterfaceInfo,
+			                                       const uint8_t LUNIndex,
+			                                       const uint32_t BlockAddress,
+			                                       const uint16_t Blocks,
+			                                       const uint16_t BlockSize,
+			                                       Pipe_StreamChunkCallback_t Callback,
+			                                       void* const Context) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(6);
+
 			/** Writes blocks of data to the attached Mass Storage device's medium.
 			 *
 			 *  \pre This function must only be called when the Host state machine is in the \ref HOST_STATE_Configured state or the
@@ -316,6 +362,12 @@
 
 		/* Function Prototypes: */
 			#if defined(__INCLUDE_FROM_MASSSTORAGE_HOST_C)
+				static uint8_t MS_Host_OpenPipes(USB_ClassInfo_MS_Host_t* const MSInterfaceInfo,
+				                                 USB_Descriptor_Interface_t* const MassStorageInterface,
+				                                 USB_Descriptor_Endpoint_t* const DataINEndpoint,
+				                                 USB_Descriptor_Endpoint_t* const DataOUTEndpoint) ATTR_NON_NULL_PTR_ARG(1);
+				static uint8_t MS_Host_SendCommandBlock(USB_ClassInfo_MS_Host_t* const MSInterfaceInfo,
+				                                        MS_CommandBlockWrapper_t* const SCSICommandBlock) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2);
 				static uint8_t MS_Host_SendCommand(USB_ClassInfo_MS_Host_t* const MSInterfaceInfo,
 				                                   MS_CommandBlockWrapper_t* const SCSICommandBlock,
 				                                   const void* const BufferPtr) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2);
@@ -334,6 +334,141 @@ uint8_t PRNT_Host_SendData(USB_ClassInfo_PRNT_Host_t* const PRNTInterfaceInfo,
 	return ErrorCode;
 }
 
+/* Waits for the block on the bus to be taken. A busy printer NAKs it for as long as it needs to; once that has gone on
+ * for PRNT_HOST_SPOOL_BUSY_MS, sleep a millisecond at a time instead of spinning, and read the port status at
+ * intervals doubling from there so the application can tell why the job is held up. */
+static uint8_t PRNT_Host_WaitSpoolBlock(USB_ClassInfo_PRNT_Host_t* const PRNTInterfaceInfo)
+{
+	uint8_t  portnum   = PRNTInterfaceInfo->Config.PortNumber;
+	uint16_t BusyFrame = USB_Host_GetFrameNumber();
+	uint16_t PollFrame = 0;
+	uint16_t Delay     = 0;
+	uint16_t Now;
+	bool     Busy      = false;
+	uint8_t  PortStatus;
+	HCD_STATUS Status;
+
+	for (;;)
+	{
+		if (USB_HostState[portnum] != HOST_STATE_Configured)
+		  return PIPE_RWSTREAM_DeviceDisconnected;
+
+		Pipe_SelectPipe(portnum,PRNTInterfaceInfo->Config.DataOUTPipeNumber);
+		Status = HcdGetPipeStatus(PipeInfo[portnum][PRNTInterfaceInfo->Config.DataOUTPipeNumber].PipeHandle);
+
+		if (Status == HCD_STATUS_OK)
+		  return PIPE_RWSTREAM_NoError;
+		else if (Status == HCD_STATUS_TRANSFER_Stall)
+		  return PIPE_RWSTREAM_PipeStalled;
+		else if (Status != HCD_STATUS_TRANSFER_QUEUED)
+		  return PIPE_RWSTREAM_Timeout;
+
+		Now = USB_Host_GetFrameNumber();
+
+		if (!(Busy))
+		{
+			if ((uint16_t) (Now - BusyFrame) < PRNT_HOST_SPOOL_BUSY_MS)
+			  continue;
+
+			Busy      = true;
+			PollFrame = Now;
+		}
+
+		if ((uint16_t) (Now - PollFrame) >= Delay)
+		{
+			Delay     = Delay ? MIN(Delay * 2, PRNT_HOST_SPOOL_BACKOFF_MAX_MS) : PRNT_HOST_SPOOL_BUSY_MS;
+			PollFrame = Now;
+			PRNTInterfaceInfo->State.SpoolBackoffs++;
+
+			if (PRNT_Host_GetPortStatus(PRNTInterfaceInfo, &PortStatus) == HOST_SENDCONTROL_Successful)
+			  PRNTInterfaceInfo->State.PortStatus = PortStatus;
+		}
+
+		USB_Host_WaitMS(1);
+	}
+}
+
+uint8_t PRNT_Host_SpoolStream(USB_ClassInfo_PRNT_Host_t* const PRNTInterfaceInfo,
+                              PRNT_Host_SpoolReadCallback_t ReadCallback,
+                              void* const Context,
+                              uint32_t* const BytesSent)
+{
+	uint8_t  portnum   = PRNTInterfaceInfo->Config.PortNumber;
+	USB_Pipe_Data_t* Pipe = &PipeInfo[portnum][PRNTInterfaceInfo->Config.DataOUTPipeNumber];
+	uint16_t ChunkSize = MIN(PRNT_HOST_SPOOL_CHUNK_SIZE, PIPE_STREAM_MAX_CHUNK_SIZE);
+	uint8_t* SpoolBuffer[2];
+	uint16_t SpoolLength[2];
+	bool     OwnBuffers = true;
+	bool     DoubleBuffered;
+	uint8_t  Bank = 0;
+	uint8_t  Next;
+	uint8_t  ErrorCode = PIPE_RWSTREAM_NoError;
+
+	if (BytesSent != NULL)
+	  *BytesSent = 0;
+
+	if ((USB_HostState[portnum] != HOST_STATE_Configured) || !(PRNTInterfaceInfo->State.IsActive))
+	  return PIPE_RWSTREAM_DeviceDisconnected;
+
+	/* Anything left by PRNT_Host_SendByte() goes first */
+	if ((ErrorCode = PRNT_Host_Flush(PRNTInterfaceInfo)) != PIPE_READYWAIT_NoError)
+	  return ErrorCode;
+
+	SpoolBuffer[0] = USB_Memory_Alloc(ChunkSize);
+	SpoolBuffer[1] = (SpoolBuffer[0] != NULL) ? USB_Memory_Alloc(ChunkSize) : NULL;
+
+	if (SpoolBuffer[0] == NULL) /* Pool exhausted, use the pipe buffer without overlap */
+	{
+		SpoolBuffer[0] = Pipe->Buffer;
+		ChunkSize      = Pipe->BufferSize;
+		OwnBuffers     = false;
+	}
+
+	DoubleBuffered = (SpoolBuffer[1] != NULL);
+	if (!(DoubleBuffered))
+	  SpoolBuffer[1] = SpoolBuffer[0];
+
+	SpoolLength[0] = ReadCallback(SpoolBuffer[0], ChunkSize, Context);
+
+	while (SpoolLength[Bank])
+	{
+		Pipe_SelectPipe(portnum,PRNTInterfaceInfo->Config.DataOUTPipeNumber);
+
+		if (!(Pipe_StartOUTTransfer(portnum, SpoolBuffer[Bank], MIN(SpoolLength[Bank], ChunkSize))))
+		{
+			ErrorCode = PIPE_RWSTREAM_PipeStalled;
+			break;
+		}
+
+		Next = Bank ^ 1;
+
+		/* Keep the bus busy with this block while the next one is read */
+		SpoolLength[Next] = DoubleBuffered ? ReadCallback(SpoolBuffer[Next], ChunkSize, Context) : 0;
+
+		if ((ErrorCode = PRNT_Host_WaitSpoolBlock(PRNTInterfaceInfo)) != PIPE_RWSTREAM_NoError)
+		  break;
+
+		if (BytesSent != NULL)
+		  *BytesSent += MIN(SpoolLength[Bank], ChunkSize);
+
+		if (!(DoubleBuffered))
+		  SpoolLength[Next] = ReadCallback(SpoolBuffer[Next], ChunkSize, Context);
+
+		Bank = Next;
+	}
+
+	/* The pipes are gone if the printer was detached, and with them the transfer reading the buffers */
+	if (OwnBuffers)
+	{
+		if (DoubleBuffered)
+		  USB_Memory_Free(SpoolBuffer[1]);
+
+		USB_Memory_Free(SpoolBuffer[0]);
+	}
+
+	return ErrorCode;
+}
+
 uint16_t PRNT_Host_BytesReceived(USB_ClassInfo_PRNT_Host_t* const PRNTInterfaceInfo)
 {
 	uint8_t portnum = PRNTInterfaceInfo->Config.PortNumber;
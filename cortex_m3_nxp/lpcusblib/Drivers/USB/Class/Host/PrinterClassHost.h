@@ -71,6 +71,29 @@
 		#endif
 
 	/* Public Interface - May be used in end-application: */
+		/* Macros: */
+			#if !defined(PRNT_HOST_SPOOL_CHUNK_SIZE) || defined(__DOXYGEN__)
+				/** Size in bytes of each block read from the source by \ref PRNT_Host_SpoolStream(), at most
+				 *  \ref PIPE_STREAM_MAX_CHUNK_SIZE. Two buffers of this size are taken from the USB memory pool for the
+				 *  duration of the job; a multiple of 512 lets a file source read whole sectors straight into them.
+				 */
+				#define PRNT_HOST_SPOOL_CHUNK_SIZE          2048
+			#endif
+
+			#if !defined(PRNT_HOST_SPOOL_BUSY_MS) || defined(__DOXYGEN__)
+				/** Time in milliseconds a block may be held off by the printer before \ref PRNT_Host_SpoolStream() stops
+				 *  polling for it and starts backing off.
+				 */
+				#define PRNT_HOST_SPOOL_BUSY_MS             20
+			#endif
+
+			#if !defined(PRNT_HOST_SPOOL_BACKOFF_MAX_MS) || defined(__DOXYGEN__)
+				/** Longest interval in milliseconds between two port status reads of a busy printer in
+				 *  \ref PRNT_Host_SpoolStream().
+				 */
+				#define PRNT_HOST_SPOOL_BACKOFF_MAX_MS      128
+			#endif
+
 		/* Type Defines: */
 			/** \brief Printer Class Host Mode Configuration and State Structure.
 			 *
@@ -103,12 +126,30 @@
 
 					uint16_t DataINPipeSize; /**< Size in bytes of the Printer interface's IN data pipe. */
 					uint16_t DataOUTPipeSize;  /**< Size in bytes of the Printer interface's OUT data pipe. */
+
+					uint8_t  PortStatus; /**< Port status last read by \ref PRNT_Host_SpoolStream() while the printer was holding
+					                      *   a block off, a mask of \c PRNT_PORTSTATUS_* bits.
+					                      */
+					uint32_t SpoolBackoffs; /**< Number of port status reads done by \ref PRNT_Host_SpoolStream() while backing off. */
 				} State; /**< State data for the USB class interface within the device. All elements in this section
 						  *   <b>may</b> be set to initial values, but may also be ignored to default to sane values when
 						  *   the interface is enumerated.
 						  */
 			} USB_ClassInfo_PRNT_Host_t;
 
+			/** Type define for the source callback of \ref PRNT_Host_SpoolStream(), called for each block of the print job
+			 *  in turn while the previous block is on its way to the printer.
+			 *
+			 *  \param[out] Buffer   Pointer to where the next block of the job is to be placed.
+			 *  \param[in]  Size     Size in bytes of the buffer.
+			 *  \param[in]  Context  User context pointer given to \ref PRNT_Host_SpoolStream().
+			 *
+			 *  \return Number of bytes placed in the buffer, \c 0 to end the job.
+			 */
+			typedef uint16_t (*PRNT_Host_SpoolReadCallback_t)(uint8_t* const Buffer,
+			                                                  const uint16_t Size,
+			                                                  void* const Context);
+
 		/* Enums: */
 			enum PRNT_Host_EnumerationFailure_ErrorCodes_t
 			{
@@ -213,6 +254,34 @@
 			                           void* Buffer,
 			                           const uint16_t Length) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2);
 
+			/** Streams a print job of any length to the attached printer, block by block from the given source callback (for
+			 *  example reading a file). Two buffers of \ref PRNT_HOST_SPOOL_CHUNK_SIZE bytes are used alternately: the source
+			 *  fills one while the host controller sends the other, so the bus stays busy while the next block is read. If the
+			 *  pool cannot provide two buffers the function falls back to a single buffer, and if it cannot provide any, to the
+			 *  pipe's own buffer.
+			 *
+			 *  A printer that cannot take more data (busy printing, out of paper) holds the block off. After
+			 *  \ref PRNT_HOST_SPOOL_BUSY_MS of that, the function backs off: it sleeps a millisecond at a time instead of
+			 *  polling the pipe, and reads the port status into the \c PortStatus state element at once, then at intervals
+			 *  doubling up to \ref PRNT_HOST_SPOOL_BACKOFF_MAX_MS. It does not give up on a busy printer; the job only fails
+			 *  if the printer stalls the pipe or is detached.
+			 *
+			 *  \pre This function must only be called when the Host state machine is in the \ref HOST_STATE_Configured state or the
+			 *       call will fail.
+			 *
+			 *  \param[in,out] PRNTInterfaceInfo  Pointer to a structure containing a Printer Class host configuration and state.
+			 *  \param[in]     ReadCallback       Function called for each block of the job, returning \c 0 at its end.
+			 *  \param[in]     Context            User context pointer passed to the callback.
+			 *  \param[out]    BytesSent          Pointer to where the number of bytes taken by the printer is stored, or \c NULL
+			 *                                    if not required.
+			 *
+			 *  \return A value from the \ref Pipe_Stream_RW_ErrorCodes_t enum.
+			 */
+			uint8_t PRNT_Host_SpoolStream(USB_ClassInfo_PRNT_Host_t* const PRNTInterfaceInfo,
+			                              PRNT_Host_SpoolReadCallback_t ReadCallback,
+			                              void* const Context,
+			                              uint32_t* const BytesSent) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2);
+
 			/** Sends a given byte to the attached USB device, if connected. If a device is not connected when the function is called, the
 			 *  byte is discarded. Bytes will be queued for transmission to the device until either the pipe bank becomes full, or the
 			 *  \ref PRNT_Host_Flush() function is called to flush the pending data to the host. This allows for multiple bytes to be
@@ -281,6 +350,7 @@
 				                                                 ATTR_WARN_UNUSED_RESULT ATTR_NON_NULL_PTR_ARG(1);
 				static uint8_t DCOMP_PRNT_Host_NextPRNTInterfaceEndpoint(void* const CurrentDescriptor)
 				                                                         ATTR_WARN_UNUSED_RESULT ATTR_NON_NULL_PTR_ARG(1);
+				static uint8_t PRNT_Host_WaitSpoolBlock(USB_ClassInfo_PRNT_Host_t* const PRNTInterfaceInfo) ATTR_NON_NULL_PTR_ARG(1);
 			#endif
 	#endif
 
@@ -158,8 +158,8 @@ uint8_t RNDIS_Host_ConfigurePipes(USB_ClassInfo_RNDIS_Host_t* const RNDISInterfa
 			return CDC_ENUMERROR_PipeConfigurationFailed;
 		}
 		
-		if (InterruptPeriod)
-		  Pipe_SetInterruptPeriod(InterruptPeriod);
+		if (InterruptPeriod && !(Pipe_SetInterruptPeriod(portnum, InterruptPeriod)))
+		  return CDC_ENUMERROR_PipeConfigurationFailed;
 	}
 
 	RNDISInterfaceInfo->State.ControlInterfaceNumber = RNDISControlInterface->InterfaceNumber;
@@ -325,7 +325,11 @@ uint8_t RNDIS_Host_InitializeDevice(USB_ClassInfo_RNDIS_Host_t* const RNDISInter
 	if (InitMessageResponse.Status != CPU_TO_LE32(REMOTE_NDIS_STATUS_SUCCESS))
 	  return RNDIS_ERROR_LOGICAL_CMD_FAILED;
 
-	RNDISInterfaceInfo->State.DeviceMaxPacketSize = le32_to_cpu(InitMessageResponse.MaxTransferSize);
+	RNDISInterfaceInfo->State.DeviceMaxPacketSize         = le32_to_cpu(InitMessageResponse.MaxTransferSize);
+	RNDISInterfaceInfo->State.DeviceMaxPacketsPerTransfer = le32_to_cpu(InitMessageResponse.MaxPacketsPerTransfer);
+
+	/* Past 4 KB the alignment leaves room for a single packet per batch anyway */
+	RNDISInterfaceInfo->State.DevicePacketAlignmentFactor = MIN(le32_to_cpu(InitMessageResponse.PacketAlignmentFactor), 12);
 
 	return HOST_SENDCONTROL_Successful;
 }
@@ -439,6 +443,12 @@ bool RNDIS_Host_IsPacketReceived(USB_ClassInfo_RNDIS_Host_t* const RNDISInterfac
 	if ((USB_HostState[portnum] != HOST_STATE_Configured) || !(RNDISInterfaceInfo->State.IsActive))
 	  return false;
 
+	if (RNDISInterfaceInfo->State.Receive.Buffer)
+	{
+		return RNDISInterfaceInfo->State.Receive.OrderCount &&
+		       RNDISInterfaceInfo->State.Receive.Filled[RNDISInterfaceInfo->State.Receive.Order[RNDISInterfaceInfo->State.Receive.OrderHead]];
+	}
+
 	Pipe_SelectPipe(portnum,RNDISInterfaceInfo->Config.DataINPipeNumber);
 
 	Pipe_Unfreeze();
@@ -458,6 +468,23 @@ uint8_t RNDIS_Host_ReadPacket(USB_ClassInfo_RNDIS_Host_t* const RNDISInterfaceIn
 	if ((USB_HostState[portnum] != HOST_STATE_Configured) || !(RNDISInterfaceInfo->State.IsActive))
 	  return PIPE_READYWAIT_DeviceDisconnected;
 
+	if (RNDISInterfaceInfo->State.Receive.Buffer)
+	{
+		RNDIS_Host_Packet_t Packet;
+
+		*PacketLength = 0;
+
+		if (RNDIS_Host_GetPacket(RNDISInterfaceInfo, &Packet))
+		{
+			memcpy(Buffer, Packet.Data, Packet.Length);
+			*PacketLength = Packet.Length;
+
+			RNDIS_Host_ReleasePacket(RNDISInterfaceInfo, &Packet);
+		}
+
+		return PIPE_RWSTREAM_NoError;
+	}
+
 	Pipe_SelectPipe(portnum,RNDISInterfaceInfo->Config.DataINPipeNumber);
 	Pipe_Unfreeze();
 
@@ -505,6 +532,20 @@ uint8_t RNDIS_Host_SendPacket(USB_ClassInfo_RNDIS_Host_t* const RNDISInterfaceIn
 	if ((USB_HostState[portnum] != HOST_STATE_Configured) || !(RNDISInterfaceInfo->State.IsActive))
 	  return PIPE_READYWAIT_DeviceDisconnected;
 
+	if (RNDISInterfaceInfo->State.Transmit.Buffer)
+	{
+		uint8_t* Packet;
+
+		if ((ErrorCode = RNDIS_Host_ReservePacket(RNDISInterfaceInfo, PacketLength, &Packet)) != PIPE_RWSTREAM_NoError)
+		  return ErrorCode;
+
+		memcpy(Packet, Buffer, PacketLength);
+
+		RNDIS_Host_USBTask(RNDISInterfaceInfo);
+
+		return PIPE_RWSTREAM_NoError;
+	}
+
 	RNDIS_Packet_Message_t DeviceMessage;
 
 	memset(&DeviceMessage, 0, sizeof(RNDIS_Packet_Message_t));
@@ -530,5 +571,406 @@ uint8_t RNDIS_Host_SendPacket(USB_ClassInfo_RNDIS_Host_t* const RNDISInterfaceIn
 	return PIPE_RWSTREAM_NoError;
 }
 
+void RNDIS_Host_USBTask(USB_ClassInfo_RNDIS_Host_t* const RNDISInterfaceInfo)
+{
+	uint8_t portnum = RNDISInterfaceInfo->Config.PortNumber;
+
+	if ((USB_HostState[portnum] != HOST_STATE_Configured) || !(RNDISInterfaceInfo->State.IsActive))
+	  return;
+
+	if (!(RNDISInterfaceInfo->State.Transmit.Length))
+	  return;
+
+	/* Packets gather in the batch for as long as the previous one is on the bus */
+	Pipe_SelectPipe(portnum,RNDISInterfaceInfo->Config.DataOUTPipeNumber);
+	if (!(Pipe_IsOUTTransferPending(portnum)))
+	  RNDIS_Host_FlushPackets(RNDISInterfaceInfo);
+}
+
+static USB_ClassInfo_RNDIS_Host_t* RNDIS_Host_Streams[RNDIS_HOST_MAX_STREAMS];
+
+uint8_t RNDIS_Host_StartStreaming(USB_ClassInfo_RNDIS_Host_t* const RNDISInterfaceInfo)
+{
+	uint8_t  portnum  = RNDISInterfaceInfo->Config.PortNumber;
+	uint16_t PipeSize = RNDISInterfaceInfo->State.DataINPipeSize;
+	uint32_t BufferSize;
+	uint32_t BatchSize;
+	uint8_t* ReceiveBuffer;
+	uint8_t* TransmitBuffer;
+	uint8_t  Slot;
+	uint8_t  i;
+
+	if ((USB_HostState[portnum] != HOST_STATE_Configured) || !(RNDISInterfaceInfo->State.IsActive))
+	  return RNDIS_STREAM_DeviceDisconnected;
+
+	if (RNDISInterfaceInfo->State.Receive.Buffer)
+	  RNDIS_Host_StopStreaming(RNDISInterfaceInfo);
+
+	/* The device never sends more than HostMaxPacketSize in one transfer, which then ends on a short packet or
+	 * by filling the buffer, so that transfers and buffers stay matched one to one */
+	BufferSize = ((RNDISInterfaceInfo->Config.HostMaxPacketSize + PipeSize - 1) / PipeSize) * PipeSize;
+	BatchSize  = MIN(RNDISInterfaceInfo->State.DeviceMaxPacketSize, RNDIS_HOST_TX_BATCH_SIZE);
+
+	if ((RNDISInterfaceInfo->Config.HostMaxPacketSize < sizeof(RNDIS_Packet_Message_t) + ETHERNET_FRAME_SIZE_MAX) ||
+	    (BufferSize > 4096) ||
+	    (BatchSize <= sizeof(RNDIS_Packet_Message_t) + ETHERNET_FRAME_SIZE_MAX))
+	{
+		return RNDIS_STREAM_InvalidTransferSize;
+	}
+
+	for (Slot = 0; (Slot < RNDIS_HOST_MAX_STREAMS) && RNDIS_Host_Streams[Slot]; Slot++);
+
+	ReceiveBuffer  = (Slot < RNDIS_HOST_MAX_STREAMS) ? USB_Memory_Alloc(RNDIS_HOST_RX_BUFFERS * BufferSize) : NULL;
+	TransmitBuffer = (ReceiveBuffer != NULL) ? USB_Memory_Alloc(2 * BatchSize) : NULL;
+
+	if (TransmitBuffer == NULL)
+	{
+		if (ReceiveBuffer != NULL)
+		  USB_Memory_Free(ReceiveBuffer);
+
+		return RNDIS_STREAM_NoMemory;
+	}
+
+	memset(&RNDISInterfaceInfo->State.Receive, 0x00, sizeof(RNDISInterfaceInfo->State.Receive));
+	memset(&RNDISInterfaceInfo->State.Transmit, 0x00, sizeof(RNDISInterfaceInfo->State.Transmit));
+
+	for (i = 0; i < RNDIS_HOST_RX_BUFFERS; i++)
+	  RNDISInterfaceInfo->State.Receive.Order[i] = i;
+
+	RNDISInterfaceInfo->State.Receive.OrderCount  = RNDIS_HOST_RX_BUFFERS;
+	RNDISInterfaceInfo->State.Receive.Queued      = (uint8_t) ((1 << RNDIS_HOST_RX_BUFFERS) - 1);
+	RNDISInterfaceInfo->State.Receive.BufferSize  = BufferSize;
+	RNDISInterfaceInfo->State.Receive.PipeHandle  = PipeInfo[portnum][RNDISInterfaceInfo->Config.DataINPipeNumber].PipeHandle;
+	RNDISInterfaceInfo->State.Receive.Buffer      = ReceiveBuffer;
+
+	RNDISInterfaceInfo->State.Transmit.BufferSize = BatchSize;
+	RNDISInterfaceInfo->State.Transmit.Buffer     = TransmitBuffer;
+
+	RNDIS_Host_Streams[Slot] = RNDISInterfaceInfo;
+
+	Pipe_SelectPipe(portnum,RNDISInterfaceInfo->Config.DataINPipeNumber);
+	if (!(Pipe_StartBulkINStream(portnum, RNDIS_Host_DataINComplete, ReceiveBuffer, BufferSize, RNDIS_HOST_RX_BUFFERS)))
+	{
+		RNDIS_Host_StopStreaming(RNDISInterfaceInfo);
+		return RNDIS_STREAM_PipeError;
+	}
+
+	return RNDIS_STREAM_NoError;
+}
+
+void RNDIS_Host_StopStreaming(USB_ClassInfo_RNDIS_Host_t* const RNDISInterfaceInfo)
+{
+	uint8_t  portnum = RNDISInterfaceInfo->Config.PortNumber;
+	uint16_t StartFrame;
+	uint8_t  Slot;
+
+	if (!(RNDISInterfaceInfo->State.Receive.Buffer))
+	  return;
+
+	/* The pipes are gone once the device has been detached */
+	if (USB_HostState[portnum] == HOST_STATE_Configured)
+	{
+		Pipe_SelectPipe(portnum,RNDISInterfaceInfo->Config.DataINPipeNumber);
+		Pipe_StopINStream(portnum);
+
+		/* The host controller reads the batch in flight from the buffer about to be freed: give it the stream timeout
+		 * to finish, then take the transfer back from the controller */
+		Pipe_SelectPipe(portnum,RNDISInterfaceInfo->Config.DataOUTPipeNumber);
+		StartFrame = USB_Host_GetFrameNumber();
+
+		while (Pipe_IsOUTTransferPending(portnum) && (USB_HostState[portnum] == HOST_STATE_Configured))
+		{
+			if ((uint16_t) (USB_Host_GetFrameNumber() - StartFrame) >= USB_STREAM_TIMEOUT_MS)
+			{
+				HcdCancelTransfer(PipeInfo[portnum][RNDISInterfaceInfo->Config.DataOUTPipeNumber].PipeHandle);
+				break;
+			}
+		}
+	}
+
+	for (Slot = 0; Slot < RNDIS_HOST_MAX_STREAMS; Slot++)
+	{
+		if (RNDIS_Host_Streams[Slot] == RNDISInterfaceInfo)
+		  RNDIS_Host_Streams[Slot] = NULL;
+	}
+
+	USB_Memory_Free(RNDISInterfaceInfo->State.Receive.Buffer);
+	USB_Memory_Free(RNDISInterfaceInfo->State.Transmit.Buffer);
+	RNDISInterfaceInfo->State.Receive.Buffer  = NULL;
+	RNDISInterfaceInfo->State.Transmit.Buffer = NULL;
+	RNDISInterfaceInfo->State.Transmit.Length = 0;
+}
+
+bool RNDIS_Host_GetPacket(USB_ClassInfo_RNDIS_Host_t* const RNDISInterfaceInfo,
+                          RNDIS_Host_Packet_t* const Packet)
+{
+	RNDIS_Packet_Message_t Message;
+	uint8_t* Data;
+	uint8_t  Index;
+	uint16_t Length;
+	uint16_t Offset;
+	uint32_t MessageLength;
+	uint32_t DataOffset;
+	uint32_t DataLength;
+
+	while (RNDISInterfaceInfo->State.Receive.Buffer && RNDISInterfaceInfo->State.Receive.OrderCount)
+	{
+		Index = RNDISInterfaceInfo->State.Receive.Order[RNDISInterfaceInfo->State.Receive.OrderHead];
+
+		if (!(RNDISInterfaceInfo->State.Receive.Filled[Index]))
+		  return false;
+
+		Data   = &RNDISInterfaceInfo->State.Receive.Buffer[Index * RNDISInterfaceInfo->State.Receive.BufferSize];
+		Length = RNDISInterfaceInfo->State.Receive.Length[Index];
+		Offset = RNDISInterfaceInfo->State.Receive.Offset;
+
+		/* The device may batch several messages in one transfer, each starting where the previous one ends */
+		while ((uint32_t) Offset + sizeof(RNDIS_Message_Header_t) <= Length)
+		{
+			memcpy(&Message, &Data[Offset], MIN(sizeof(RNDIS_Packet_Message_t), (uint32_t) (Length - Offset)));
+			MessageLength = le32_to_cpu(Message.MessageLength);
+
+			/* Nothing past a message running off the end of the transfer can be trusted */
+			if ((MessageLength < sizeof(RNDIS_Message_Header_t)) || (MessageLength > (uint32_t) (Length - Offset)))
+			  break;
+
+			RNDISInterfaceInfo->State.Receive.Offset = Offset + MessageLength;
+
+			if ((Message.MessageType != CPU_TO_LE32(REMOTE_NDIS_PACKET_MSG)) || (MessageLength < sizeof(RNDIS_Packet_Message_t)))
+			{
+				Offset += MessageLength;
+				continue;
+			}
+
+			DataOffset = le32_to_cpu(Message.DataOffset) + sizeof(RNDIS_Message_Header_t);
+			DataLength = le32_to_cpu(Message.DataLength);
+
+			if (!(DataLength) || (DataOffset > MessageLength) || (DataLength > MessageLength - DataOffset))
+			{
+				Offset += MessageLength;
+				continue;
+			}
+
+			Packet->Data        = &Data[Offset + DataOffset];
+			Packet->Length      = DataLength;
+			Packet->BufferIndex = Index;
+
+			RNDISInterfaceInfo->State.Receive.References[Index]++;
+			return true;
+		}
+
+		/* Every packet of the buffer has been handed out, it is queued again once they are all released */
+		RNDISInterfaceInfo->State.Receive.Offset        = 0;
+		RNDISInterfaceInfo->State.Receive.Filled[Index] = false;
+		RNDISInterfaceInfo->State.Receive.OrderHead     = (RNDISInterfaceInfo->State.Receive.OrderHead + 1) % RNDIS_HOST_RX_BUFFERS;
+		RNDISInterfaceInfo->State.Receive.OrderCount--;
+		RNDISInterfaceInfo->State.Receive.Queued       &= ~(1 << Index);
+
+		if (!(RNDISInterfaceInfo->State.Receive.References[Index]))
+		  RNDIS_Host_QueueReceiveBuffer(RNDISInterfaceInfo, Index);
+	}
+
+	return false;
+}
+
+void RNDIS_Host_ReleasePacket(USB_ClassInfo_RNDIS_Host_t* const RNDISInterfaceInfo,
+                              const RNDIS_Host_Packet_t* const Packet)
+{
+	uint8_t Index = Packet->BufferIndex;
+
+	if (!(RNDISInterfaceInfo->State.Receive.Buffer) || (Index >= RNDIS_HOST_RX_BUFFERS) ||
+	    !(RNDISInterfaceInfo->State.Receive.References[Index]))
+	{
+		return;
+	}
+
+	if (!(--RNDISInterfaceInfo->State.Receive.References[Index]) &&
+	    !(RNDISInterfaceInfo->State.Receive.Queued & (1 << Index)))
+	{
+		RNDIS_Host_QueueReceiveBuffer(RNDISInterfaceInfo, Index);
+	}
+}
+
+uint8_t* RNDIS_Host_AllocPacket(USB_ClassInfo_RNDIS_Host_t* const RNDISInterfaceInfo,
+                                const uint16_t PacketLength)
+{
+	uint8_t* Packet;
+
+	if (RNDIS_Host_ReservePacket(RNDISInterfaceInfo, PacketLength, &Packet) != PIPE_RWSTREAM_NoError)
+	  return NULL;
+
+	return Packet;
+}
+
+/* RNDIS_Host_AllocPacket() telling why no packet could be had: the error of the flush that was needed for room, or
+ * PIPE_RWSTREAM_PipeStalled when streaming is off or the packet can never fit in a batch */
+static uint8_t RNDIS_Host_ReservePacket(USB_ClassInfo_RNDIS_Host_t* const RNDISInterfaceInfo,
+                                        const uint16_t PacketLength,
+                                        uint8_t** const Packet)
+{
+	RNDIS_Packet_Message_t Message;
+	uint8_t* Batch;
+	uint32_t Alignment     = 1UL << RNDISInterfaceInfo->State.DevicePacketAlignmentFactor;
+	uint32_t MessageLength = sizeof(RNDIS_Packet_Message_t) + PacketLength;
+	uint32_t Offset;
+	uint32_t PreviousLength;
+	uint8_t  ErrorCode;
+
+	*Packet = NULL;
+
+	/* One byte of each batch is kept back for the padding of RNDIS_Host_FlushPackets() */
+	if (!(RNDISInterfaceInfo->State.Transmit.Buffer) || !(PacketLength) ||
+	    (MessageLength >= RNDISInterfaceInfo->State.Transmit.BufferSize))
+	{
+		return PIPE_RWSTREAM_PipeStalled;
+	}
+
+	Offset = (RNDISInterfaceInfo->State.Transmit.Length + Alignment - 1) & ~(Alignment - 1);
+
+	if ((RNDISInterfaceInfo->State.Transmit.Length && (Offset + MessageLength >= RNDISInterfaceInfo->State.Transmit.BufferSize)) ||
+	    (RNDISInterfaceInfo->State.Transmit.Packets >= MAX(RNDISInterfaceInfo->State.DeviceMaxPacketsPerTransfer, 1)))
+	{
+		if ((ErrorCode = RNDIS_Host_FlushPackets(RNDISInterfaceInfo)) != PIPE_RWSTREAM_NoError)
+		  return ErrorCode;
+
+		Offset = 0;
+	}
+
+	Batch = &RNDISInterfaceInfo->State.Transmit.Buffer[RNDISInterfaceInfo->State.Transmit.Current *
+	                                                   RNDISInterfaceInfo->State.Transmit.BufferSize];
+
+	/* The previous message is stretched over the padding up to the aligned start of this one */
+	if (Offset != RNDISInterfaceInfo->State.Transmit.Length)
+	{
+		memset(&Batch[RNDISInterfaceInfo->State.Transmit.Length], 0x00, Offset - RNDISInterfaceInfo->State.Transmit.Length);
+
+		memcpy(&PreviousLength, &Batch[RNDISInterfaceInfo->State.Transmit.Message + 4], sizeof(uint32_t));
+		PreviousLength = cpu_to_le32(le32_to_cpu(PreviousLength) + Offset - RNDISInterfaceInfo->State.Transmit.Length);
+		memcpy(&Batch[RNDISInterfaceInfo->State.Transmit.Message + 4], &PreviousLength, sizeof(uint32_t));
+	}
+
+	memset(&Message, 0, sizeof(RNDIS_Packet_Message_t));
+	Message.MessageType   = CPU_TO_LE32(REMOTE_NDIS_PACKET_MSG);
+	Message.MessageLength = cpu_to_le32(MessageLength);
+	Message.DataOffset    = CPU_TO_LE32(sizeof(RNDIS_Packet_Message_t) - sizeof(RNDIS_Message_Header_t));
+	Message.DataLength    = cpu_to_le32(PacketLength);
+
+	memcpy(&Batch[Offset], &Message, sizeof(RNDIS_Packet_Message_t));
+
+	RNDISInterfaceInfo->State.Transmit.Message = Offset;
+	RNDISInterfaceInfo->State.Transmit.Length  = Offset + MessageLength;
+	RNDISInterfaceInfo->State.Transmit.Packets++;
+
+	*Packet = &Batch[Offset + sizeof(RNDIS_Packet_Message_t)];
+	return PIPE_RWSTREAM_NoError;
+}
+
+uint8_t RNDIS_Host_FlushPackets(USB_ClassInfo_RNDIS_Host_t* const RNDISInterfaceInfo)
+{
+	uint8_t  portnum = RNDISInterfaceInfo->Config.PortNumber;
+	uint8_t* Batch;
+	uint16_t Length  = RNDISInterfaceInfo->State.Transmit.Length;
+
+	if ((USB_HostState[portnum] != HOST_STATE_Configured) || !(RNDISInterfaceInfo->State.IsActive))
+	  return PIPE_RWSTREAM_DeviceDisconnected;
+
+	if (!(RNDISInterfaceInfo->State.Transmit.Buffer) || !(Length))
+	  return PIPE_RWSTREAM_NoError;
+
+	Pipe_SelectPipe(portnum,RNDISInterfaceInfo->Config.DataOUTPipeNumber);
+
+	while (Pipe_IsOUTTransferPending(portnum))
+	{
+		if (USB_HostState[portnum] != HOST_STATE_Configured)
+		  return PIPE_RWSTREAM_DeviceDisconnected;
+	}
+
+	/* The outcome of the previous batch is only known now, it is reported against this one */
+	if (RNDISInterfaceInfo->State.Transmit.InFlight)
+	{
+		RNDISInterfaceInfo->State.Transmit.InFlight = false;
+
+		if (!(Pipe_IsOUTReady(portnum)))
+		  return PIPE_RWSTREAM_PipeStalled;
+	}
+
+	Batch = &RNDISInterfaceInfo->State.Transmit.Buffer[RNDISInterfaceInfo->State.Transmit.Current *
+	                                                   RNDISInterfaceInfo->State.Transmit.BufferSize];
+
+	/* A batch filling its last packet would need a zero length packet to end the transfer, a byte past the last
+	 * message ends it as well and is ignored by the device */
+	if (!(Length % RNDISInterfaceInfo->State.DataOUTPipeSize))
+	  Batch[Length++] = 0x00;
+
+	if (!(Pipe_StartOUTTransfer(portnum, Batch, Length)))
+	  return PIPE_RWSTREAM_PipeStalled;
+
+	RNDISInterfaceInfo->State.Transmit.InFlight = true;
+	RNDISInterfaceInfo->State.Transmit.Current ^= 1;
+	RNDISInterfaceInfo->State.Transmit.Length   = 0;
+	RNDISInterfaceInfo->State.Transmit.Packets  = 0;
+
+	return PIPE_RWSTREAM_NoError;
+}
+
+/* Queues a receive buffer again once all of its packets have been handed out and released. Only this side queues
+ * receive buffers, so Order follows the order the device fills them in. */
+static void RNDIS_Host_QueueReceiveBuffer(USB_ClassInfo_RNDIS_Host_t* const RNDISInterfaceInfo,
+                                          const uint8_t Index)
+{
+	uint8_t portnum = RNDISInterfaceInfo->Config.PortNumber;
+	uint8_t Tail;
+
+	if (!(RNDISInterfaceInfo->State.Receive.Buffer) || RNDISInterfaceInfo->State.Receive.Error)
+	  return;
+
+	Tail = (RNDISInterfaceInfo->State.Receive.OrderHead + RNDISInterfaceInfo->State.Receive.OrderCount) % RNDIS_HOST_RX_BUFFERS;
+
+	RNDISInterfaceInfo->State.Receive.Order[Tail] = Index;
+	RNDISInterfaceInfo->State.Receive.OrderCount++;
+	RNDISInterfaceInfo->State.Receive.Queued |= (1 << Index);
+
+	Pipe_SelectPipe(portnum,RNDISInterfaceInfo->Config.DataINPipeNumber);
+	if (!(Pipe_QueueINStreamTransfer(portnum,
+	                                 &RNDISInterfaceInfo->State.Receive.Buffer[Index * RNDISInterfaceInfo->State.Receive.BufferSize],
+	                                 RNDISInterfaceInfo->State.Receive.BufferSize)))
+	{
+		RNDISInterfaceInfo->State.Receive.Error = HCD_STATUS_TRANSFER_ERROR;
+	}
+}
+
+static bool RNDIS_Host_DataINComplete(uint32_t PipeHandle, HCD_STATUS Status, uint8_t* Buffer, uint16_t Length)
+{
+	USB_ClassInfo_RNDIS_Host_t* RNDISInterfaceInfo = NULL;
+	uint8_t Index;
+	uint8_t Slot;
+
+	for (Slot = 0; Slot < RNDIS_HOST_MAX_STREAMS; Slot++)
+	{
+		if (RNDIS_Host_Streams[Slot] && (RNDIS_Host_Streams[Slot]->State.Receive.PipeHandle == PipeHandle))
+		  RNDISInterfaceInfo = RNDIS_Host_Streams[Slot];
+	}
+
+	if (!(RNDISInterfaceInfo) || !(RNDISInterfaceInfo->State.Receive.Buffer))
+	  return false;
+
+	/* Packets are lost with a failed transfer, the stream ends there */
+	if ((Status != HCD_STATUS_OK) || RNDISInterfaceInfo->State.Receive.Error)
+	{
+		if (!(RNDISInterfaceInfo->State.Receive.Error))
+		  RNDISInterfaceInfo->State.Receive.Error = Status;
+
+		return false;
+	}
+
+	/* The packets are handed out in place, the buffer stays idle until they have all been released */
+	Index = (Buffer - RNDISInterfaceInfo->State.Receive.Buffer) / RNDISInterfaceInfo->State.Receive.BufferSize;
+
+	RNDISInterfaceInfo->State.Receive.Length[Index] = Length;
+	RNDISInterfaceInfo->State.Receive.Filled[Index] = true;
+
+	return false;
+}
+
 #endif
 
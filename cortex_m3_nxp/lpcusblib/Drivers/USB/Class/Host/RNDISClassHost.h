@@ -72,7 +72,39 @@
 		#endif
 
 	/* Public Interface - May be used in end-application: */
+		/* Macros: */
+			#if !defined(RNDIS_HOST_RX_BUFFERS) || defined(__DOXYGEN__)
+				/** Number of receive buffers of an RNDIS stream, each holding one bulk IN transfer of up to
+				 *  \c HostMaxPacketSize bytes. Buffers are queued on the data IN pipe while free, so the device is not NAKed
+				 *  while the application works through the packets of a finished one. At most 8.
+				 */
+				#define RNDIS_HOST_RX_BUFFERS            2
+			#endif
+
+			#if !defined(RNDIS_HOST_TX_BATCH_SIZE) || defined(__DOXYGEN__)
+				/** Maximum length in bytes of a batch of packets sent to the device in one bulk OUT transfer, further limited to
+				 *  the device's maximum transfer size. An RNDIS stream takes two of them from the USB RAM, one being filled while
+				 *  the other is sent. At most 4 KB, and at least one full Ethernet frame with its RNDIS header.
+				 */
+				#define RNDIS_HOST_TX_BATCH_SIZE         1600
+			#endif
+
+			/** Maximum number of RNDIS streams running at the same time, over all interfaces. */
+			#define RNDIS_HOST_MAX_STREAMS               2
+
 		/* Type Defines: */
+			/** \brief RNDIS Class Host Mode Received Packet.
+			 *
+			 *  Ethernet frame received on an RNDIS stream, handed out by \ref RNDIS_Host_GetPacket(). The frame stays in the
+			 *  receive buffer it arrived in until it is given back with \ref RNDIS_Host_ReleasePacket().
+			 */
+			typedef struct
+			{
+				uint8_t* Data; /**< First byte of the Ethernet frame, within a receive buffer of the stream. */
+				uint16_t Length; /**< Length in bytes of the Ethernet frame. */
+				uint8_t  BufferIndex; /**< Receive buffer holding the frame. */
+			} RNDIS_Host_Packet_t;
+
 			/** \brief RNDIS Class Host Mode Configuration and State Structure.
 			 *
 			 *  Class state structure. An instance of this structure should be made within the user application,
@@ -111,8 +143,41 @@
 					uint16_t NotificationPipeSize;  /**< Size in bytes of the RNDIS interface's IN notification pipe, if used. */
 
 					uint32_t DeviceMaxPacketSize; /**< Maximum size of a packet which can be buffered by the attached RNDIS device. */
+					uint32_t DeviceMaxPacketsPerTransfer; /**< Maximum number of packets the attached RNDIS device accepts in one transfer. */
+					uint8_t  DevicePacketAlignmentFactor; /**< Packets batched in one transfer to the device start on multiples of
+					                                       *   2^DevicePacketAlignmentFactor bytes.
+					                                       */
 
 					uint32_t RequestID; /**< Request ID counter to give a unique ID for each command/response pair. */
+
+					struct
+					{
+						uint8_t* Buffer; /**< The \ref RNDIS_HOST_RX_BUFFERS receive buffers in the USB RAM, \c NULL when the
+						                  *   interface is not streaming.
+						                  */
+						uint16_t BufferSize; /**< Size in bytes of each receive buffer, the length of each queued transfer. */
+						volatile uint16_t Length[RNDIS_HOST_RX_BUFFERS]; /**< Bytes received into each buffer. */
+						volatile bool Filled[RNDIS_HOST_RX_BUFFERS]; /**< Set by the USB interrupt when the transfer of a buffer has completed. */
+						volatile uint8_t Error; /**< Host controller status of the transfer that stopped the stream, 0 while it runs. */
+						uint8_t  References[RNDIS_HOST_RX_BUFFERS]; /**< Packets of each buffer handed out and not released yet. */
+						uint8_t  Order[RNDIS_HOST_RX_BUFFERS]; /**< Queued buffers, in the order the device fills them. */
+						uint8_t  OrderHead; /**< Index in \c Order of the buffer filled next. */
+						uint8_t  OrderCount; /**< Number of buffers in \c Order. */
+						uint8_t  Queued; /**< Bit mask of the buffers in \c Order. */
+						uint16_t Offset; /**< Offset of the next message in the buffer at the head of \c Order. */
+						uint32_t PipeHandle; /**< Handle of the data IN pipe, identifying the stream to the USB interrupt. */
+					} Receive; /**< Receive side of the stream, see \ref RNDIS_Host_StartStreaming(). */
+
+					struct
+					{
+						uint8_t* Buffer; /**< The two batch buffers in the USB RAM, \c NULL when the interface is not streaming. */
+						uint16_t BufferSize; /**< Size in bytes of each batch buffer. */
+						uint16_t Length; /**< Bytes of the batch being filled. */
+						uint16_t Message; /**< Offset of the last message of the batch being filled. */
+						uint8_t  Packets; /**< Packets in the batch being filled. */
+						uint8_t  Current; /**< Batch buffer being filled, the other one may be in flight. */
+						bool     InFlight; /**< A batch has been queued on the data OUT pipe and its outcome not checked yet. */
+					} Transmit; /**< Transmit side of the stream, see \ref RNDIS_Host_StartStreaming(). */
 				} State; /**< State data for the USB class interface within the device. All elements in this section
 						  *   <b>may</b> be set to initial values, but may also be ignored to default to sane values when
 						  *   the interface is enumerated.
@@ -129,7 +194,27 @@
 				RNDIS_ENUMERROR_PipeConfigurationFailed    = 3, /**< One or more pipes for the specified interface could not be configured correctly. */
 			};
 
+			/** Enum for the possible error codes returned by the \ref RNDIS_Host_StartStreaming() function. */
+			enum RNDIS_Host_StreamErrorCodes_t
+			{
+				RNDIS_STREAM_NoError                       = 0, /**< The stream was started. */
+				RNDIS_STREAM_DeviceDisconnected            = 1, /**< The interface is not bound to a configured device. */
+				RNDIS_STREAM_InvalidTransferSize           = 2, /**< \c HostMaxPacketSize exceeds 4 KB, or it or the device's maximum
+				                                                 *   transfer size cannot hold an Ethernet frame.
+				                                                 */
+				RNDIS_STREAM_NoMemory                      = 3, /**< No stream slot or not enough USB RAM for the buffers. */
+				RNDIS_STREAM_PipeError                     = 4, /**< The host controller driver refused the receive transfers. */
+			};
+
 		/* Function Prototypes: */
+			/** General management task for a given RNDIS host class interface, required for the correct operation of the interface. This should
+			 *  be called frequently in the main program loop, before the master USB management task \ref USB_USBTask(). While the
+			 *  interface is streaming it sends the batch of packets being filled as soon as the previous one has gone out.
+			 *
+			 *  \param[in,out] RNDISInterfaceInfo  Pointer to a structure containing an RNDIS Class host configuration and state.
+			 */
+			void RNDIS_Host_USBTask(USB_ClassInfo_RNDIS_Host_t* const RNDISInterfaceInfo) ATTR_NON_NULL_PTR_ARG(1);
+
 			/** Host interface configuration routine, to configure a given RNDIS host interface instance using the Configuration
 			 *  Descriptor read from an attached USB device. This function automatically updates the given RNDIS Host instance's
 			 *  state values and configures the pipes required to communicate with the interface if it is found within the device.
@@ -196,6 +281,81 @@
 			                                      void* Buffer,
 			                                      const uint16_t MaxLength) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(3);
 
+			/** Starts streaming packets on the given RNDIS interface, initialized with \ref RNDIS_Host_InitializeDevice().
+			 *
+			 *  On the receive side \ref RNDIS_HOST_RX_BUFFERS buffers of \c HostMaxPacketSize bytes, rounded up to whole packets
+			 *  of the data IN pipe, are kept queued as bulk IN transfers, so the device can batch several packets in each transfer
+			 *  up to the maximum transfer size given to it at initialization. \ref RNDIS_Host_GetPacket() hands out the Ethernet
+			 *  frames of finished transfers in place, and a buffer is queued again once all its frames have been released.
+			 *
+			 *  On the send side \ref RNDIS_Host_AllocPacket() reserves room for each frame in a batch buffer, and the batch goes out
+			 *  as a single bulk OUT transfer from \ref RNDIS_Host_USBTask() once the previous one is done, when it is full, or on
+			 *  \ref RNDIS_Host_FlushPackets(). Batches respect the device's maximum transfer size, packets per transfer and alignment.
+			 *
+			 *  While streaming, \ref RNDIS_Host_IsPacketReceived(), \ref RNDIS_Host_ReadPacket() and \ref RNDIS_Host_SendPacket()
+			 *  work on the stream buffers.
+			 *
+			 *  \note \ref RNDIS_Host_StopStreaming() must be called before the device is reconfigured or when it is detached.
+			 *
+			 *  \param[in,out] RNDISInterfaceInfo  Pointer to a structure containing an RNDIS Class host configuration and state.
+			 *
+			 *  \return A value from the \ref RNDIS_Host_StreamErrorCodes_t enum.
+			 */
+			uint8_t RNDIS_Host_StartStreaming(USB_ClassInfo_RNDIS_Host_t* const RNDISInterfaceInfo) ATTR_NON_NULL_PTR_ARG(1);
+
+			/** Stops the stream started with \ref RNDIS_Host_StartStreaming(), waiting for the batch in flight and cancelling the
+			 *  queued receive transfers. Packets not sent yet are dropped, and packets handed out by \ref RNDIS_Host_GetPacket()
+			 *  must not be used anymore.
+			 *
+			 *  \param[in,out] RNDISInterfaceInfo  Pointer to a structure containing an RNDIS Class host configuration and state.
+			 */
+			void RNDIS_Host_StopStreaming(USB_ClassInfo_RNDIS_Host_t* const RNDISInterfaceInfo) ATTR_NON_NULL_PTR_ARG(1);
+
+			/** Hands out the next Ethernet frame received on a streaming RNDIS interface, in place in its receive buffer. Several
+			 *  frames may be held at the same time; each must be given back with \ref RNDIS_Host_ReleasePacket() once processed, as
+			 *  its buffer is only queued again when all of its frames have been released. Does not block.
+			 *
+			 *  Once the stream has failed, indicated by a non zero \c State.Receive.Error, the frames already received are still
+			 *  handed out and no new ones arrive.
+			 *
+			 *  \param[in,out] RNDISInterfaceInfo  Pointer to a structure containing an RNDIS Class host configuration and state.
+			 *  \param[out]    Packet              Pointer to where the received frame is described.
+			 *
+			 *  \return Boolean \c true if a frame was handed out, \c false if none is waiting.
+			 */
+			bool RNDIS_Host_GetPacket(USB_ClassInfo_RNDIS_Host_t* const RNDISInterfaceInfo,
+			                          RNDIS_Host_Packet_t* const Packet) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2);
+
+			/** Gives back a frame handed out by \ref RNDIS_Host_GetPacket(), so that its receive buffer can be reused.
+			 *
+			 *  \param[in,out] RNDISInterfaceInfo  Pointer to a structure containing an RNDIS Class host configuration and state.
+			 *  \param[in]     Packet              Frame to release.
+			 */
+			void RNDIS_Host_ReleasePacket(USB_ClassInfo_RNDIS_Host_t* const RNDISInterfaceInfo,
+			                              const RNDIS_Host_Packet_t* const Packet) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2);
+
+			/** Reserves room for an Ethernet frame in the batch being filled on a streaming RNDIS interface and writes its RNDIS
+			 *  packet header. The frame is to be written to the returned location before any other call to the driver for this
+			 *  interface; it is sent with the rest of the batch. If the batch is full it is sent first, waiting for the one in flight.
+			 *
+			 *  \param[in,out] RNDISInterfaceInfo  Pointer to a structure containing an RNDIS Class host configuration and state.
+			 *  \param[in]     PacketLength        Length in bytes of the frame.
+			 *
+			 *  \return Location of the frame in the batch, or \c NULL if the interface is not streaming, the frame is too large for
+			 *          a batch or the batch could not be sent.
+			 */
+			uint8_t* RNDIS_Host_AllocPacket(USB_ClassInfo_RNDIS_Host_t* const RNDISInterfaceInfo,
+			                                const uint16_t PacketLength) ATTR_NON_NULL_PTR_ARG(1);
+
+			/** Sends the batch being filled on a streaming RNDIS interface, after waiting for the one in flight. Once this returns
+			 *  every packet reserved with \ref RNDIS_Host_AllocPacket() is on its way to the device.
+			 *
+			 *  \param[in,out] RNDISInterfaceInfo  Pointer to a structure containing an RNDIS Class host configuration and state.
+			 *
+			 *  \return A value from the \ref Pipe_Stream_RW_ErrorCodes_t enum.
+			 */
+			uint8_t RNDIS_Host_FlushPackets(USB_ClassInfo_RNDIS_Host_t* const RNDISInterfaceInfo) ATTR_NON_NULL_PTR_ARG(1);
+
 			/** Determines if a packet is currently waiting for the host to read in and process.
 			 *
 			 *  \pre This function must only be called when the Host state machine is in the \ref HOST_STATE_Configured state or the
@@ -208,7 +368,8 @@
 			bool RNDIS_Host_IsPacketReceived(USB_ClassInfo_RNDIS_Host_t* const RNDISInterfaceInfo) ATTR_NON_NULL_PTR_ARG(1);
 
 			/** Retrieves the next pending packet from the device, discarding the remainder of the RNDIS packet header to leave
-			 *  only the packet contents for processing by the host in the nominated buffer.
+			 *  only the packet contents for processing by the host in the nominated buffer. On a streaming interface the packet is
+			 *  copied out of its receive buffer, \c PacketLength being 0 if none is waiting.
 			 *
 			 *  \pre This function must only be called when the Host state machine is in the \ref HOST_STATE_Configured state or the
 			 *       call will fail.
@@ -224,7 +385,8 @@
 			                              uint16_t* const PacketLength) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2)
 			                              ATTR_NON_NULL_PTR_ARG(3);
 
-			/** Sends the given packet to the attached RNDIS device, after adding a RNDIS packet message header.
+			/** Sends the given packet to the attached RNDIS device, after adding a RNDIS packet message header. On a streaming
+			 *  interface the packet is copied into the batch being filled, which is sent right away if no batch is in flight.
 			 *
 			 *  \pre This function must only be called when the Host state machine is in the \ref HOST_STATE_Configured state or the
 			 *       call will fail.
@@ -239,18 +401,6 @@
 			                              void* Buffer,
 			                              const uint16_t PacketLength) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2);
 
-		/* Inline Functions: */
-			/** General management task for a given RNDIS host class interface, required for the correct operation of the interface. This should
-			 *  be called frequently in the main program loop, before the master USB management task \ref USB_USBTask().
-			 *
-			 *  \param[in,out] RNDISInterfaceInfo  Pointer to a structure containing an RNDIS Class host configuration and state.
-			 */
-			static inline void RNDIS_Host_USBTask(USB_ClassInfo_RNDIS_Host_t* const RNDISInterfaceInfo) ATTR_NON_NULL_PTR_ARG(1) ATTR_ALWAYS_INLINE;
-			static inline void RNDIS_Host_USBTask(USB_ClassInfo_RNDIS_Host_t* const RNDISInterfaceInfo)
-			{
-				(void)RNDISInterfaceInfo;
-			}
-
 	/* Private Interface - For use in library only: */
 	#if !defined(__DOXYGEN__)
 		/* Function Prototypes: */
@@ -264,6 +414,13 @@
 				                                             const uint16_t Length) ATTR_NON_NULL_PTR_ARG(1)
 				                                             ATTR_NON_NULL_PTR_ARG(2);
 
+				static uint8_t RNDIS_Host_ReservePacket(USB_ClassInfo_RNDIS_Host_t* const RNDISInterfaceInfo,
+				                                        const uint16_t PacketLength,
+				                                        uint8_t** const Packet) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(3);
+				static void RNDIS_Host_QueueReceiveBuffer(USB_ClassInfo_RNDIS_Host_t* const RNDISInterfaceInfo,
+				                                          const uint8_t Index) ATTR_NON_NULL_PTR_ARG(1);
+				static bool RNDIS_Host_DataINComplete(uint32_t PipeHandle, HCD_STATUS Status, uint8_t* Buffer, uint16_t Length);
+
 				static uint8_t DCOMP_RNDIS_Host_NextRNDISControlInterface(void* const CurrentDescriptor)
 				                                                          ATTR_WARN_UNUSED_RESULT ATTR_NON_NULL_PTR_ARG(1);
 				static uint8_t DCOMP_RNDIS_Host_NextRNDISDataInterface(void* const CurrentDescriptor)
@@ -144,8 +144,8 @@ uint8_t SI_Host_ConfigurePipes(USB_ClassInfo_SI_Host_t* const SIInterfaceInfo,
 			return SI_ENUMERROR_PipeConfigurationFailed;
 		}
 		
-		if (InterruptPeriod)
-		  Pipe_SetInterruptPeriod(InterruptPeriod);
+		if (InterruptPeriod && !(Pipe_SetInterruptPeriod(portnum, InterruptPeriod)))
+		  return SI_ENUMERROR_PipeConfigurationFailed;
 	}
 
 	SIInterfaceInfo->State.InterfaceNumber = StillImageInterface->InterfaceNumber;
@@ -336,6 +336,75 @@ uint8_t SI_Host_ReadData(USB_ClassInfo_SI_Host_t* const SIInterfaceInfo,
 	return ErrorCode;
 }
 
+uint8_t SI_Host_ReadDataStream(USB_ClassInfo_SI_Host_t* const SIInterfaceInfo,
+                               Pipe_StreamChunkCallback_t Callback,
+                               void* const Context,
+                               uint32_t* const DataLength)
+{
+	uint8_t  ErrorCode;
+	uint8_t  Residue[64];
+	uint16_t ResidueLength;
+	uint32_t Remaining;
+	uint32_t Delivered = 0;
+	uint32_t Received  = 0;
+	bool     ShortPacket;
+	PIMA_Container_t PIMABlock;
+	uint8_t portnum = SIInterfaceInfo->Config.PortNumber;
+
+	if ((USB_HostState[portnum] != HOST_STATE_Configured) || !(SIInterfaceInfo->State.IsActive))
+	  return PIPE_RWSTREAM_DeviceDisconnected;
+
+	if ((ErrorCode = SI_Host_ReceiveBlockHeader(SIInterfaceInfo, &PIMABlock)) != PIPE_RWSTREAM_NoError)
+	  return ErrorCode;
+
+	if (PIMABlock.Type != CPU_TO_LE16(PIMA_CONTAINER_DataBlock))
+	  return SI_ERROR_LOGICAL_CMD_FAILED;
+
+	Remaining = le32_to_cpu(PIMABlock.DataLength);
+
+	if (Remaining != 0xFFFFFFFF)
+	  Remaining = (Remaining > PIMA_DATA_SIZE(0)) ? (Remaining - PIMA_DATA_SIZE(0)) : 0;
+
+	if (DataLength != NULL)
+	  *DataLength = Remaining;
+
+	Pipe_SelectPipe(portnum,SIInterfaceInfo->Config.DataINPipeNumber);
+	Pipe_Unfreeze();
+
+	/* The header came in a packet of its own, which also holds the start of the payload */
+	ShortPacket = ((PIMA_DATA_SIZE(0) + Pipe_BytesInPipe(portnum)) < SIInterfaceInfo->State.DataINPipeSize);
+
+	while (Remaining && Pipe_BytesInPipe(portnum))
+	{
+		ResidueLength = MIN(MIN(Pipe_BytesInPipe(portnum), sizeof(Residue)), Remaining);
+
+		Pipe_Read_Stream_LE(portnum, Residue, ResidueLength, NULL);
+		Callback(Residue, ResidueLength, Context);
+
+		Remaining -= ResidueLength;
+		Delivered += ResidueLength;
+	}
+
+	if (Remaining && !(ShortPacket))
+	{
+		ErrorCode  = Pipe_Read_Stream_Chunked(portnum, Remaining, SI_HOST_STREAM_CHUNK_SIZE, Callback, Context, &Received);
+		Remaining -= Received;
+		Delivered += Received;
+	}
+
+	Pipe_ClearIN(portnum);
+	Pipe_Freeze();
+
+	/* A device ending the data short of the length it declared has not sent the whole payload */
+	if (DataLength != NULL)
+	  *DataLength = Delivered;
+
+	if ((ErrorCode == PIPE_RWSTREAM_NoError) && Remaining && (le32_to_cpu(PIMABlock.DataLength) != 0xFFFFFFFF))
+	  ErrorCode = PIPE_RWSTREAM_IncompleteTransfer;
+
+	return ErrorCode;
+}
+
 bool SI_Host_IsEventReceived(USB_ClassInfo_SI_Host_t* const SIInterfaceInfo)
 {
 	bool IsEventReceived = false;
@@ -467,6 +536,31 @@ uint8_t SI_Host_SendCommand(USB_ClassInfo_SI_Host_t* const SIInterfaceInfo,
 	return PIPE_RWSTREAM_NoError;
 }
 
+uint8_t SI_Host_GetObject(USB_ClassInfo_SI_Host_t* const SIInterfaceInfo,
+                          const uint32_t ObjectHandle,
+                          Pipe_StreamChunkCallback_t Callback,
+                          void* const Context,
+                          uint32_t* const ObjectSize)
+{
+	uint8_t  ErrorCode;
+	uint8_t  DataError;
+	uint32_t Params[1] = {cpu_to_le32(ObjectHandle)};
+
+	if ((ErrorCode = SI_Host_SendCommand(SIInterfaceInfo, 0x1009, 1, Params)) != PIPE_RWSTREAM_NoError)
+	  return ErrorCode;
+
+	DataError = SI_Host_ReadDataStream(SIInterfaceInfo, Callback, Context, ObjectSize);
+
+	/* A data phase the device ended short is still followed by its response */
+	if ((DataError != PIPE_RWSTREAM_NoError) && (DataError != PIPE_RWSTREAM_IncompleteTransfer))
+	  return DataError;
+
+	if ((ErrorCode = SI_Host_ReceiveResponse(SIInterfaceInfo)) != PIPE_RWSTREAM_NoError)
+	  return ErrorCode;
+
+	return DataError;
+}
+
 uint8_t SI_Host_ReceiveResponse(USB_ClassInfo_SI_Host_t* const SIInterfaceInfo)
 {
 	uint8_t ErrorCode;
@@ -75,6 +75,13 @@
 			/** Error code for some Still Image Host functions, indicating a logical (and not hardware) error. */
 			#define SI_ERROR_LOGICAL_CMD_FAILED              0x80
 
+			#if !defined(SI_HOST_STREAM_CHUNK_SIZE) || defined(__DOXYGEN__)
+				/** Size in bytes of each chunk delivered by \ref SI_Host_ReadDataStream(). Two buffers of this size
+				 *  are taken from the USB memory pool for the duration of the data phase.
+				 */
+				#define SI_HOST_STREAM_CHUNK_SIZE            2048
+			#endif
+
 		/* Type Defines: */
 			/** \brief Still Image Class Host Mode Configuration and State Structure.
 			 *
@@ -293,6 +300,59 @@
 			                         void* Buffer,
 			                         const uint16_t Bytes) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2);
 
+			/** Receives the data phase of a PIMA command, once the command has been issued, handing the payload of the data
+			 *  container to the given callback in chunks of up to \ref SI_HOST_STREAM_CHUNK_SIZE bytes as soon as each chunk
+			 *  arrives. The next chunk is already being received by the host controller while the callback processes the
+			 *  current one, so objects of any size can be moved (e.g. to a file) with a fixed amount of memory. The first call
+			 *  of the callback only carries what followed the container header in the first packet.
+			 *
+			 *  If the device answers with a response block instead of a data container, no data is delivered and
+			 *  \ref SI_ERROR_LOGICAL_CMD_FAILED is returned without a further \ref SI_Host_ReceiveResponse(); otherwise the
+			 *  response is to be received with \ref SI_Host_ReceiveResponse() once this returns.
+			 *
+			 *  \pre This function must only be called when the Host state machine is in the \ref HOST_STATE_Configured state or the
+			 *       call will fail.
+			 *
+			 *  \param[in,out] SIInterfaceInfo  Pointer to a structure containing a Still Image Class host configuration and state.
+			 *  \param[in]     Callback         Function called with each received chunk of the payload.
+			 *  \param[in]     Context          User context pointer passed to the callback.
+			 *  \param[out]    DataLength       Pointer to where the length in bytes of the payload, from the container header, is
+			 *                                  stored before the first call of the callback, or \c NULL if not required. The
+			 *                                  length is \c 0xFFFFFFFF for payloads of 4 GB or more, read until the device ends them.
+			 *                                  On return it holds the number of bytes actually handed to the callback.
+			 *
+			 *  \return A value from the \ref Pipe_Stream_RW_ErrorCodes_t enum, \ref PIPE_RWSTREAM_IncompleteTransfer if the
+			 *          device ended the data before the length its header declared, or \ref SI_ERROR_LOGICAL_CMD_FAILED if the
+			 *          device returned a response block instead of data.
+			 */
+			uint8_t SI_Host_ReadDataStream(USB_ClassInfo_SI_Host_t* const SIInterfaceInfo,
+			                               Pipe_StreamChunkCallback_t Callback,
+			                               void* const Context,
+			                               uint32_t* const DataLength) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2);
+
+			/** Retrieves an object from the attached device with the PIMA GetObject operation, handing it to the given callback
+			 *  through \ref SI_Host_ReadDataStream() and then checking the device's response. A session must be open.
+			 *
+			 *  \pre This function must only be called when the Host state machine is in the \ref HOST_STATE_Configured state or the
+			 *       call will fail.
+			 *
+			 *  \param[in,out] SIInterfaceInfo  Pointer to a structure containing a Still Image Class host configuration and state.
+			 *  \param[in]     ObjectHandle     Device handle of the object to retrieve.
+			 *  \param[in]     Callback         Function called with each received chunk of the object.
+			 *  \param[in]     Context          User context pointer passed to the callback.
+			 *  \param[out]    ObjectSize       Pointer to where the size in bytes of the object is stored before the first call of
+			 *                                  the callback, and the number of bytes received on return, or \c NULL if not required.
+			 *
+			 *  \return A value from the \ref Pipe_Stream_RW_ErrorCodes_t enum, \ref PIPE_RWSTREAM_IncompleteTransfer if the
+			 *          device sent less of the object than it declared (its response has then still been received), or
+			 *          \ref SI_ERROR_LOGICAL_CMD_FAILED if the device returned a logical command failure.
+			 */
+			uint8_t SI_Host_GetObject(USB_ClassInfo_SI_Host_t* const SIInterfaceInfo,
+			                          const uint32_t ObjectHandle,
+			                          Pipe_StreamChunkCallback_t Callback,
+			                          void* const Context,
+			                          uint32_t* const ObjectSize) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(3);
+
 		/* Inline Functions: */
 			/** General management task for a given Still Image host class interface, required for the correct operation of the
 			 *  interface. This should be called frequently in the main program loop, before the master USB management task
@@ -72,8 +72,165 @@ uint8_t USB_Host_GetDeviceConfigDescriptor(const uint8_t corenum,
 
 	return HOST_GETCONFIG_Successful;
 }
+
+static USB_Host_IndexedConfig_t USB_Host_ConfigCache[USB_HOST_CONFIG_CACHE_ENTRIES];
+static USB_Host_IndexedConfig_t* USB_Host_CurrentConfig[MAX_USB_CORE];
+static uint32_t USB_Host_ConfigCacheAge;
+
+/* Least recently used cache entry which no USB core is using, free entries first */
+static USB_Host_IndexedConfig_t* USB_Host_GetFreeConfigCacheEntry(void)
+{
+	USB_Host_IndexedConfig_t* Oldest = NULL;
+	uint8_t i, corenum;
+
+	for (i = 0; i < USB_HOST_CONFIG_CACHE_ENTRIES; i++)
+	{
+		USB_Host_IndexedConfig_t* Entry = &USB_Host_ConfigCache[i];
+
+		for (corenum = 0; corenum < MAX_USB_CORE; corenum++)
+		{
+			if (USB_Host_CurrentConfig[corenum] == Entry)
+			  break;
+		}
+
+		if (corenum != MAX_USB_CORE)
+		  continue;
+
+		if (Entry->ConfigNumber == 0)
+		  return Entry;
+
+		if ((Oldest == NULL) || ((int32_t)(Entry->LastUsed - Oldest->LastUsed) < 0))
+		  Oldest = Entry;
+	}
+
+	return Oldest;
+}
+
+uint8_t USB_Host_GetIndexedConfigDescriptor(const uint8_t corenum,
+                                            const uint8_t ConfigNumber,
+                                            USB_Host_IndexedConfig_t** const ConfigPtr)
+{
+	USB_Descriptor_Device_t DeviceDescriptor;
+	USB_Host_IndexedConfig_t* Config;
+	uint8_t ErrorCode;
+	uint8_t i;
+
+	/* The core's previous device is gone, its entry stays in the cache but may now be replaced */
+	USB_Host_CurrentConfig[corenum] = NULL;
+
+	if ((ErrorCode = USB_Host_GetDeviceDescriptor(corenum, &DeviceDescriptor)) != HOST_SENDCONTROL_Successful)
+	  return ErrorCode;
+
+	for (i = 0; i < USB_HOST_CONFIG_CACHE_ENTRIES; i++)
+	{
+		Config = &USB_Host_ConfigCache[i];
+
+		if ((Config->ConfigNumber  == ConfigNumber) &&
+		    (Config->VendorID      == le16_to_cpu(DeviceDescriptor.VendorID)) &&
+		    (Config->ProductID     == le16_to_cpu(DeviceDescriptor.ProductID)) &&
+		    (Config->ReleaseNumber == le16_to_cpu(DeviceDescriptor.ReleaseNumber)))
+		{
+			break;
+		}
+	}
+
+	if (i == USB_HOST_CONFIG_CACHE_ENTRIES)
+	{
+		if ((Config = USB_Host_GetFreeConfigCacheEntry()) == NULL)
+		  return HOST_GETCONFIG_BuffOverflow;
+
+		Config->ConfigNumber = 0;
+
+		if ((ErrorCode = USB_Host_GetDeviceConfigDescriptor(corenum, ConfigNumber, &Config->ConfigSize,
+		                                                    Config->ConfigData, sizeof(Config->ConfigData))) != HOST_GETCONFIG_Successful)
+		{
+			return ErrorCode;
+		}
+
+		if ((ErrorCode = USB_IndexConfigDescriptor(&Config->Index, Config->ConfigSize, Config->ConfigData)) != HOST_GETCONFIG_Successful)
+		  return ErrorCode;
+
+		Config->VendorID      = le16_to_cpu(DeviceDescriptor.VendorID);
+		Config->ProductID     = le16_to_cpu(DeviceDescriptor.ProductID);
+		Config->ReleaseNumber = le16_to_cpu(DeviceDescriptor.ReleaseNumber);
+		Config->ConfigNumber  = ConfigNumber;
+	}
+
+	Config->LastUsed = ++USB_Host_ConfigCacheAge;
+	USB_Host_CurrentConfig[corenum] = Config;
+	*ConfigPtr = Config;
+
+	return HOST_GETCONFIG_Successful;
+}
 #endif
 
+uint8_t USB_IndexConfigDescriptor(USB_Descriptor_Index_t* const Index,
+                                  const uint16_t ConfigSize,
+                                  const void* const ConfigData)
+{
+	USB_Descriptor_IndexedInterface_t* Interface = NULL;
+	uint16_t Offset = 0;
+
+	Index->TotalInterfaces = 0;
+	Index->TotalEndpoints  = 0;
+
+	if ((ConfigSize < sizeof(USB_Descriptor_Configuration_Header_t)) || (DESCRIPTOR_TYPE(ConfigData) != DTYPE_Configuration))
+	  return HOST_GETCONFIG_InvalidData;
+
+	while (Offset < ConfigSize)
+	{
+		const void* Descriptor = (const uint8_t*)ConfigData + Offset;
+		uint8_t     Size       = DESCRIPTOR_SIZE(Descriptor);
+
+		if ((Size < sizeof(USB_Descriptor_Header_t)) || (Size > (ConfigSize - Offset)))
+		  return HOST_GETCONFIG_InvalidData;
+
+		if (DESCRIPTOR_TYPE(Descriptor) == DTYPE_Interface)
+		{
+			if (Index->TotalInterfaces == USB_DESCRIPTOR_INDEX_MAX_INTERFACES)
+			  return HOST_GETCONFIG_BuffOverflow;
+
+			if (Interface != NULL)
+			  Interface->Length = Offset - Interface->Offset;
+
+			Interface = &Index->Interfaces[Index->TotalInterfaces++];
+			Interface->Offset         = Offset;
+			Interface->FirstEndpoint  = Index->TotalEndpoints;
+			Interface->TotalEndpoints = 0;
+		}
+		else if ((DESCRIPTOR_TYPE(Descriptor) == DTYPE_Endpoint) && (Interface != NULL))
+		{
+			if (Index->TotalEndpoints == USB_DESCRIPTOR_INDEX_MAX_ENDPOINTS)
+			  return HOST_GETCONFIG_BuffOverflow;
+
+			Index->EndpointOffset[Index->TotalEndpoints++] = Offset;
+			Interface->TotalEndpoints++;
+		}
+
+		Offset += Size;
+	}
+
+	if (Interface != NULL)
+	  Interface->Length = ConfigSize - Interface->Offset;
+
+	return HOST_GETCONFIG_Successful;
+}
+
+uint8_t USB_GetNextIndexedInterfaceComp(const USB_Host_IndexedConfig_t* const Config,
+                                        uint8_t* const InterfaceIndex,
+                                        ConfigComparatorPtr_t const ComparatorRoutine)
+{
+	uint8_t ErrorCode;
+
+	for (; *InterfaceIndex < Config->Index.TotalInterfaces; (*InterfaceIndex)++)
+	{
+		if ((ErrorCode = ComparatorRoutine(USB_GetIndexedInterface(Config, *InterfaceIndex))) != DESCRIPTOR_SEARCH_NotFound)
+		  return (ErrorCode == DESCRIPTOR_SEARCH_Found) ? DESCRIPTOR_SEARCH_COMP_Found : DESCRIPTOR_SEARCH_COMP_Fail;
+	}
+
+	return DESCRIPTOR_SEARCH_COMP_EndOfDescriptor;
+}
+
 void USB_GetNextDescriptorOfType(uint16_t* const BytesRem,
                                  void** const CurrConfigLoc,
                                  const uint8_t Type)
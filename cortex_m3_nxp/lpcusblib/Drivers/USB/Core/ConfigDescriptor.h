@@ -108,6 +108,29 @@
 			/** Returns the descriptor's size, expressed as the 8-bit value indicating the number of bytes. */
 			#define DESCRIPTOR_SIZE(DescriptorPtr)    DESCRIPTOR_PCAST(DescriptorPtr, USB_Descriptor_Header_t)->Size
 
+			#if !defined(USB_HOST_CONFIG_DESCRIPTOR_SIZE) || defined(__DOXYGEN__)
+				/** Largest configuration descriptor in bytes that \ref USB_Host_GetIndexedConfigDescriptor() can hold. */
+				#define USB_HOST_CONFIG_DESCRIPTOR_SIZE         512
+			#endif
+
+			#if !defined(USB_HOST_CONFIG_CACHE_ENTRIES) || defined(__DOXYGEN__)
+				/** Number of indexed configuration descriptors kept by \ref USB_Host_GetIndexedConfigDescriptor(), each taking
+				 *  about \ref USB_HOST_CONFIG_DESCRIPTOR_SIZE bytes of RAM. Every USB core needs one for its attached device,
+				 *  the others remember devices which were detached so that they enumerate again without the descriptor.
+				 */
+				#define USB_HOST_CONFIG_CACHE_ENTRIES           (MAX_USB_CORE + 1)
+			#endif
+
+			#if !defined(USB_DESCRIPTOR_INDEX_MAX_INTERFACES) || defined(__DOXYGEN__)
+				/** Number of interface descriptors, alternate settings included, a \ref USB_Descriptor_Index_t can record. */
+				#define USB_DESCRIPTOR_INDEX_MAX_INTERFACES     8
+			#endif
+
+			#if !defined(USB_DESCRIPTOR_INDEX_MAX_ENDPOINTS) || defined(__DOXYGEN__)
+				/** Number of endpoint descriptors, over all interfaces, a \ref USB_Descriptor_Index_t can record. */
+				#define USB_DESCRIPTOR_INDEX_MAX_ENDPOINTS      16
+			#endif
+
 		/* Type Defines: */
 			/** Type define for a Configuration Descriptor comparator function (function taking a pointer to an array
 			 *  of type void, returning a uint8_t value).
@@ -116,6 +139,47 @@
 			 */
 			typedef uint8_t (* ConfigComparatorPtr_t)(void*);
 
+			/** Location of one interface descriptor inside an indexed configuration descriptor.
+			 *
+			 *  \see \ref USB_Descriptor_Index_t.
+			 */
+			typedef struct
+			{
+				uint16_t Offset; /**< Offset of the interface descriptor from the start of the configuration descriptor. */
+				uint16_t Length; /**< Bytes from the interface descriptor up to the next one, its class specific and
+				                  *   endpoint descriptors included.
+				                  */
+				uint8_t  FirstEndpoint; /**< Index of its first endpoint in \ref USB_Descriptor_Index_t::EndpointOffset. */
+				uint8_t  TotalEndpoints; /**< Number of endpoint descriptors following the interface descriptor. */
+			} USB_Descriptor_IndexedInterface_t;
+
+			/** Index of a configuration descriptor, built in a single pass by \ref USB_IndexConfigDescriptor() so that class
+			 *  drivers can go straight to the interfaces and endpoints they need instead of walking every descriptor.
+			 */
+			typedef struct
+			{
+				uint8_t  TotalInterfaces; /**< Number of interface descriptors, alternate settings included. */
+				uint8_t  TotalEndpoints; /**< Number of endpoint descriptors of all interfaces. */
+				USB_Descriptor_IndexedInterface_t Interfaces[USB_DESCRIPTOR_INDEX_MAX_INTERFACES]; /**< Interfaces in descriptor order. */
+				uint16_t EndpointOffset[USB_DESCRIPTOR_INDEX_MAX_ENDPOINTS]; /**< Offsets of the endpoint descriptors, in descriptor order. */
+			} USB_Descriptor_Index_t;
+
+			/** Configuration descriptor of an attached device together with its index, as returned by
+			 *  \ref USB_Host_GetIndexedConfigDescriptor(). Instances live in a cache keyed by the vendor ID, product ID and
+			 *  release number of the device and must not be changed by the application.
+			 */
+			typedef struct
+			{
+				uint16_t VendorID; /**< Vendor ID of the device the descriptor belongs to. */
+				uint16_t ProductID; /**< Product ID of the device the descriptor belongs to. */
+				uint16_t ReleaseNumber; /**< Release number (bcdDevice) of the device the descriptor belongs to. */
+				uint8_t  ConfigNumber; /**< Configuration number of the descriptor, 0 if the cache entry is free. */
+				uint32_t LastUsed; /**< Age stamp for replacing the least recently used cache entry. */
+				uint16_t ConfigSize; /**< Size of the configuration descriptor in bytes. */
+				USB_Descriptor_Index_t Index; /**< Index of \ref ConfigData. */
+				uint32_t ConfigData[(USB_HOST_CONFIG_DESCRIPTOR_SIZE + 3) / 4]; /**< Configuration descriptor, word aligned. */
+			} USB_Host_IndexedConfig_t;
+
 		/* Enums: */
 			/** Enum for the possible return codes of the \ref USB_Host_GetDeviceConfigDescriptor() function. */
 			enum USB_Host_GetConfigDescriptor_ErrorCodes_t
@@ -170,6 +234,58 @@
 			                                           void* const BufferPtr,
 			                                           const uint16_t BufferSize) ATTR_NON_NULL_PTR_ARG(3) ATTR_NON_NULL_PTR_ARG(4);
 
+			/** Records the offsets of every interface and endpoint descriptor of a configuration descriptor in a single
+			 *  pass, so that \ref USB_GetNextIndexedInterfaceComp(), \ref USB_GetIndexedInterface() and
+			 *  \ref USB_GetIndexedEndpoint() can then find them without walking the descriptor again.
+			 *
+			 *  \param[out] Index       Pointer to the index to fill.
+			 *  \param[in]  ConfigSize  Size of the configuration descriptor in bytes.
+			 *  \param[in]  ConfigData  Pointer to the configuration descriptor.
+			 *
+			 *  \return \ref HOST_GETCONFIG_Successful, \ref HOST_GETCONFIG_InvalidData if the data is not a well formed
+			 *          configuration descriptor or \ref HOST_GETCONFIG_BuffOverflow if it has more interfaces or endpoints
+			 *          than the index can record.
+			 */
+			uint8_t USB_IndexConfigDescriptor(USB_Descriptor_Index_t* const Index,
+			                                  const uint16_t ConfigSize,
+			                                  const void* const ConfigData) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(3);
+
+			#if defined(USB_CAN_BE_HOST) || defined(__DOXYGEN__)
+			/** Gives the indexed configuration descriptor of the attached device, fetching and indexing it only if the
+			 *  device is not in the cache yet: a device which enumerates again, or another one of the same model, costs a
+			 *  GET_DESCRIPTOR of its device descriptor only. The descriptor stays valid until the next call for the same
+			 *  USB core, and keeps the event handlers from holding a copy of it on their stack.
+			 *
+			 *  \note The cache assumes that devices with the same vendor ID, product ID and release number have the same
+			 *        configuration descriptor.
+			 *
+			 *  \param[in]  corenum       ID Number of USB Core to be processed.
+			 *  \param[in]  ConfigNumber  Device configuration descriptor number to fetch from the device (usually set to 1
+			 *                            for single configuration devices).
+			 *  \param[out] ConfigPtr     Pointer to a location for storing the address of the indexed descriptor.
+			 *
+			 *  \return A value from the \ref USB_Host_GetConfigDescriptor_ErrorCodes_t enum.
+			 */
+			uint8_t USB_Host_GetIndexedConfigDescriptor(const uint8_t corenum,
+			                                            const uint8_t ConfigNumber,
+			                                            USB_Host_IndexedConfig_t** const ConfigPtr) ATTR_NON_NULL_PTR_ARG(3);
+			#endif
+
+			/** Searches the interfaces of an indexed configuration descriptor, from the given one on, for one which the
+			 *  comparator routine accepts. The routine is the same as for \ref USB_GetNextDescriptorComp(), but it is only
+			 *  called with interface descriptors.
+			 *
+			 *  \param[in]     Config             Pointer to the indexed configuration descriptor.
+			 *  \param[in,out] InterfaceIndex     Pointer to the index in \ref USB_Descriptor_Index_t::Interfaces to start
+			 *                                    from, set to the index of the interface found.
+			 *  \param[in]     ComparatorRoutine  Name of the comparator search function to use on the interfaces.
+			 *
+			 *  \return Value of one of the members of the \ref DSearch_Comp_Return_ErrorCodes_t enum.
+			 */
+			uint8_t USB_GetNextIndexedInterfaceComp(const USB_Host_IndexedConfig_t* const Config,
+			                                        uint8_t* const InterfaceIndex,
+			                                        ConfigComparatorPtr_t const ComparatorRoutine) ATTR_NON_NULL_PTR_ARG(1) ATTR_NON_NULL_PTR_ARG(2);
+
 			/** Skips to the next sub-descriptor inside the configuration descriptor of the specified type value.
 			 *  The bytes remaining value is automatically decremented.
 			 *
@@ -278,6 +394,42 @@
 				*BytesRem      -= CurrDescriptorSize;
 			}
 
+			/** Returns an interface descriptor of an indexed configuration descriptor.
+			 *
+			 *  \param[in] Config          Pointer to the indexed configuration descriptor.
+			 *  \param[in] InterfaceIndex  Index of the interface in \ref USB_Descriptor_Index_t::Interfaces.
+			 *
+			 *  \return Pointer to the interface descriptor.
+			 */
+			static inline USB_Descriptor_Interface_t* USB_GetIndexedInterface(const USB_Host_IndexedConfig_t* const Config,
+			                                                                 const uint8_t InterfaceIndex) ATTR_NON_NULL_PTR_ARG(1);
+			static inline USB_Descriptor_Interface_t* USB_GetIndexedInterface(const USB_Host_IndexedConfig_t* const Config,
+			                                                                 const uint8_t InterfaceIndex)
+			{
+				return (USB_Descriptor_Interface_t*)((uintptr_t)Config->ConfigData + Config->Index.Interfaces[InterfaceIndex].Offset);
+			}
+
+			/** Returns an endpoint descriptor of an interface of an indexed configuration descriptor.
+			 *
+			 *  \param[in] Config          Pointer to the indexed configuration descriptor.
+			 *  \param[in] InterfaceIndex  Index of the interface in \ref USB_Descriptor_Index_t::Interfaces.
+			 *  \param[in] EndpointIndex   Index of the endpoint among the interface's endpoints, less than
+			 *                             \ref USB_Descriptor_IndexedInterface_t::TotalEndpoints.
+			 *
+			 *  \return Pointer to the endpoint descriptor.
+			 */
+			static inline USB_Descriptor_Endpoint_t* USB_GetIndexedEndpoint(const USB_Host_IndexedConfig_t* const Config,
+			                                                               const uint8_t InterfaceIndex,
+			                                                               const uint8_t EndpointIndex) ATTR_NON_NULL_PTR_ARG(1);
+			static inline USB_Descriptor_Endpoint_t* USB_GetIndexedEndpoint(const USB_Host_IndexedConfig_t* const Config,
+			                                                               const uint8_t InterfaceIndex,
+			                                                               const uint8_t EndpointIndex)
+			{
+				uint8_t Endpoint = Config->Index.Interfaces[InterfaceIndex].FirstEndpoint + EndpointIndex;
+
+				return (USB_Descriptor_Endpoint_t*)((uintptr_t)Config->ConfigData + Config->Index.EndpointOffset[Endpoint]);
+			}
+
 	/* Disable C linkage for C++ Compilers: */
 		#if defined(__cplusplus)
 			}
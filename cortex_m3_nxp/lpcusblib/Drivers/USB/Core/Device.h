@@ -131,6 +131,9 @@
 			 *        \c USE_EEPROM_DESCRIPTORS tokens may be defined in the project makefile and passed to the compiler by the -D
 			 *        switch.
 			 *
+			 *  \note With \c INTERRUPT_CONTROL_ENDPOINT defined this callback is called from the control request interrupt,
+			 *        see \ref EVENT_USB_Device_ControlRequest(); it should only look the descriptor up.
+			 *
 			 *  \return Size in bytes of the descriptor if it exists, zero or \ref NO_DESCRIPTOR otherwise.
 			 */
 			uint16_t CALLBACK_USB_GetDescriptor(const uint16_t wValue,
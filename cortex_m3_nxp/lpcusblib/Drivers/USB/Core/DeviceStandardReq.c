@@ -48,8 +48,12 @@ bool    USB_Device_CurrentlySelfPowered;
 bool    USB_Device_RemoteWakeupEnabled;
 #endif
 
+volatile uint8_t USB_Device_SETUPCount;
+
 void USB_Device_ProcessControlRequest(void)
 {
+	uint8_t SETUPCount = USB_Device_SETUPCount;
+
 	Endpoint_GetSetupPackage( (uint8_t*) &USB_ControlRequest);
 
 	EVENT_USB_Device_ControlRequest();
@@ -103,7 +107,9 @@ void USB_Device_ProcessControlRequest(void)
 		}
 	}
 
-	if (Endpoint_IsSETUPReceived())
+	/* A request nobody handled is stalled. Once the status stage of a handled one is through,
+	 * the host may send the next SETUP while its handler is still busy: that one is left alone. */
+	if (Endpoint_IsSETUPReceived() && (USB_Device_SETUPCount == SETUPCount))
 	{
 		Endpoint_ClearSETUP();
 		Endpoint_StallTransaction();
@@ -136,6 +136,12 @@
 			#error Only one of the USE_*_DESCRIPTORS modes should be selected.
 		#endif
 
+		/* Global Variables: */
+			/* Count of the SETUP packets a device controller driver latches in its interrupt handler
+			 * (rather than in a hardware status bit), so that a request which arrives while the one
+			 * before it is still being processed is not taken for that one. */
+			extern volatile uint8_t USB_Device_SETUPCount;
+
 		/* Function Prototypes: */
 			void USB_Device_ProcessControlRequest(void);
 
@@ -243,6 +243,13 @@
 			 *        or appropriate class specification. In all instances, the library has already read the
 			 *        request SETUP parameters into the \ref USB_ControlRequest structure which should then be used
 			 *        by the application to determine how to handle the issued request.
+			 *        \n\n
+			 *
+			 *  \note When the \c INTERRUPT_CONTROL_ENDPOINT token is supplied to the compiler, this event and every class
+			 *        driver event or callback fired while processing the request run in the interrupt the control requests
+			 *        are processed in (\c USB_CONTROL_IRQn, see HAL_LPC17xx.h) instead of from \ref USB_USBTask(). Handlers
+			 *        must then not block or wait on the application's tasks, and may only use the \c FromISR variants of
+			 *        the FreeRTOS calls; longer work should be handed to a task, for example with \c xSemaphoreGiveFromISR().
 			 */
 			void EVENT_USB_Device_ControlRequest(void);
 
@@ -257,6 +264,10 @@
 			 *
 			 *  \note This event does not exist if the \c USB_HOST_ONLY token is supplied to the compiler (see
 			 *        \ref Group_USBManagement documentation).
+			 *        \n\n
+			 *
+			 *  \note This event comes from the SET CONFIGURATION request, so with \c INTERRUPT_CONTROL_ENDPOINT defined it
+			 *        runs in interrupt context, under the same rules as \ref EVENT_USB_Device_ControlRequest().
 			 */
 			void EVENT_USB_Device_ConfigurationChanged(void);
 
@@ -44,14 +44,51 @@ DMADescriptor dmaDescriptor[USED_PHYSICAL_ENDPOINTS] __DATA(USBRAM_SECTION);
 static uint8_t SetupPackage[8] __DATA(USBRAM_SECTION);
 uint32_t DataInRemainCount,DataInRemainOffset;
 bool IsConfigured,shortpacket;
-uint8_t* ISO_Address;
 PRAGMA_ALIGN_4
 uint8_t iso_buffer[512] ATTR_ALIGNED(4) __DATA(USBRAM_SECTION);
+uint8_t* ISO_Address = iso_buffer;
 PRAGMA_WEAK(CALLBACK_HAL_GetISOBufferAddress,Dummy_EPGetISOAddress)
 uint32_t CALLBACK_HAL_GetISOBufferAddress(const uint32_t EPNum,uint32_t* last_packet_size) ATTR_WEAK ATTR_ALIAS(Dummy_EPGetISOAddress);
 uint32_t BufferAddressIso[32] __DATA(USBRAM_SECTION);
 uint32_t SizeAudioTransfer;
 
+/* Transfers queued by Endpoint_StartDMA(). Each endpoint has a ring of DDs which are chained
+ * through NextDD as transfers are queued, so the engine goes on to the next transfer by itself;
+ * DMAChainStaged holds the bytes an OUT transfer took from usb_data_buffer_OUT. DMAUserBuffer
+ * marks the endpoints whose DMA belongs to the chain rather than to the staging buffers, and
+ * DMANewDDPending the ones with a new DD request set aside while the chain had no DD armed. */
+static DMADescriptor DMAChain[USED_PHYSICAL_ENDPOINTS][ENDPOINT_DMA_CHAIN_LENGTH] __DATA(USBRAM_SECTION);
+static uint16_t DMAChainStaged[USED_PHYSICAL_ENDPOINTS][ENDPOINT_DMA_CHAIN_LENGTH];
+static uint8_t  DMAChainHead[USED_PHYSICAL_ENDPOINTS];
+static uint8_t  DMAChainCount[USED_PHYSICAL_ENDPOINTS];
+static volatile uint32_t DMAUserBuffer;
+static volatile uint32_t DMANewDDPending;
+
+#define ISO_PACKET_LENGTH_MASK		0x0000FFFF
+#define ISO_PACKET_VALID			0x00010000
+
+/* Isochronous streams started by Endpoint_StartISOStream(). A stream's DDs retire in ring order,
+ * one packet per frame; PacketWord holds the length word of each packet of a DD (IsoBufferAddr).
+ * A finished DD is handed to the callback and chained again behind the last one queued, so the
+ * engine runs from DD to DD without waiting for the CPU. DMAISOStream marks the streaming endpoints. */
+typedef struct
+{
+	DMADescriptor         Dd[ENDPOINT_ISO_MAX_TRANSFERS];
+	uint32_t              PacketWord[ENDPOINT_ISO_MAX_TRANSFERS][ENDPOINT_ISO_MAX_PACKETS];
+	ENDPOINT_ISO_CALLBACK Callback;
+	uint8_t*              Buffer;
+	uint16_t              TransferSize;
+	uint8_t               PhyEP;
+	uint8_t               PacketCount;
+	uint8_t               Transfers;
+	uint8_t               Head;
+	uint8_t               Count;
+	bool                  Ending;
+} ISOStream_t;
+
+static ISOStream_t ISOStream[ENDPOINT_ISO_MAX_STREAMS] __DATA(USBRAM_SECTION) ATTR_ALIGNED(4);
+static volatile uint32_t DMAISOStream;
+
 /*
  *  Write Command
  *    Parameters:      cmd:   Command
@@ -91,6 +128,39 @@ uint32_t SIE_ReadCommandData (uint32_t cmd) {
 	while ((LPC_USB->USBDevIntSt & CDFULL_INT) == 0);
   	return (LPC_USB->USBCmdData);
 }
+/* Stream of an endpoint, NULL if it is not streaming */
+static ISOStream_t* ISOStreamFind(uint8_t PhyEP)
+{
+	uint8_t n;
+
+	if (!(DMAISOStream & (1 << PhyEP)))
+		return NULL;
+
+	for (n = 0; n < ENDPOINT_ISO_MAX_STREAMS; n++)
+	{
+		if (ISOStream[n].Callback && (ISOStream[n].PhyEP == PhyEP))
+			return &ISOStream[n];
+	}
+	return NULL;
+}
+
+/* The endpoint leaves its stream, its DMA goes back to the buffer of the isochronous hook */
+static void ISOStreamRelease(uint8_t PhyEP)
+{
+	ISOStream_t* Stream = ISOStreamFind(PhyEP);
+
+	if (Stream == NULL)
+		return;
+
+	LPC_USB->USBEpDMADis   = (1 << PhyEP);
+	LPC_USB->USBEoTIntClr  = (1 << PhyEP);
+	LPC_USB->USBNDDRIntClr = (1 << PhyEP);
+	UDCA[PhyEP] = 0;
+
+	DMAISOStream &= ~(1 << PhyEP);
+	Stream->Callback = NULL;
+}
+
 /********************************************************************//**
  * @brief
  * @param
@@ -129,6 +199,13 @@ void HAL_Reset (void)
 	IsConfigured = false;
 	isOutReceived = false;
 	isInReady = true;
+	DMAUserBuffer = 0;
+	DMANewDDPending = 0;
+	memset(DMAChainCount, 0, sizeof(DMAChainCount));
+	DMAISOStream = 0;
+	for (n = 0; n < ENDPOINT_ISO_MAX_STREAMS; n++) {
+		ISOStream[n].Callback = NULL;
+	}
 	usb_data_buffer_size = 0;
  	usb_data_buffer_index = 0;
 
@@ -145,10 +222,12 @@ void HAL_Reset (void)
  */
 void Endpoint_StallTransaction(void)
 {
+	HAL_DisableUSBInterrupt(USBPortNum);
 	if(endpointselected==ENDPOINT_CONTROLEP)
 		SIE_WriteCommandData( CMD_SET_EP_STAT(endpointhandle[endpointselected]), DAT_WR_BYTE(EP_STAT_CND_ST) );
 	else
 		SIE_WriteCommandData( CMD_SET_EP_STAT(endpointhandle[endpointselected]), DAT_WR_BYTE(EP_STAT_ST) );
+	HAL_EnableUSBInterrupt(USBPortNum);
 }
 
 /********************************************************************//**
@@ -161,6 +240,10 @@ bool Endpoint_ConfigureEndpoint(const uint8_t Number, const uint8_t Type,
 {
 	uint32_t PhyEP = 2*Number + (Direction == ENDPOINT_DIR_OUT ? 0 : 1);
 
+	/* Class drivers configure their endpoints from the control request handler, which the
+	 * device interrupt may preempt with SIE commands of its own */
+	HAL_DisableUSBInterrupt(USBPortNum);
+
 	if((!IsConfigured)&&(PhyEP>1))
 	{
 		IsConfigured = true;
@@ -182,10 +265,16 @@ bool Endpoint_ConfigureEndpoint(const uint8_t Number, const uint8_t Type,
 		DataInRemainOffset = 0;
 	}else /* all other endpoints use DMA mode */
 	{
+		ISOStreamRelease(PhyEP);
+		LPC_USB->USBEpDMADis = (1 << PhyEP);	/* the DD is rewritten below, the engine must not hold it */
+		UDCA[PhyEP] = 0;
 		memset(&dmaDescriptor[PhyEP], 0, sizeof(DMADescriptor));
 		dmaDescriptor[PhyEP].Isochronous = (Type == EP_TYPE_ISOCHRONOUS ? 1 : 0 );
 		dmaDescriptor[PhyEP].MaxPacketSize = Size;
 		dmaDescriptor[PhyEP].Retired = 1; /* inactive DD */
+		DMAChainCount[PhyEP] = 0;
+		DMAUserBuffer &= ~(1 << PhyEP);
+		DMANewDDPending &= ~(1 << PhyEP);
 		
 		LPC_USB->USBEpDMAEn = (1 << PhyEP);
 	}
@@ -194,6 +283,8 @@ bool Endpoint_ConfigureEndpoint(const uint8_t Number, const uint8_t Type,
 	SIE_WriteCommandData(CMD_SET_EP_STAT(PhyEP), DAT_WR_BYTE(0)); /* Reset Endpoint */
 
 	endpointhandle[Number] = (Number==ENDPOINT_CONTROLEP) ? ENDPOINT_CONTROLEP : PhyEP;
+
+	HAL_EnableUSBInterrupt(USBPortNum);
 	return true;
 }
 /********************************************************************//**
@@ -239,6 +330,8 @@ void WriteControlEndpoint( uint8_t *pData, uint32_t cnt )
 	uint32_t n;
 	uint32_t count;
 
+	HAL_DisableUSBInterrupt(USBPortNum);
+
 	isInReady = false;
 	if(cnt >= USB_Device_ControlEndpointSize)
 	{
@@ -269,6 +362,8 @@ void WriteControlEndpoint( uint8_t *pData, uint32_t cnt )
 
 	SIE_WriteCommamd(CMD_SEL_EP(ENDPOINT_CONTROLEP+1));
 	SIE_WriteCommamd(CMD_VALID_BUF);
+
+	HAL_EnableUSBInterrupt(USBPortNum);
 }
 
 /********************************************************************//**
@@ -278,8 +373,10 @@ void WriteControlEndpoint( uint8_t *pData, uint32_t cnt )
  *********************************************************************/
 void HAL17XX_SetDeviceAddress (uint8_t Address)
 {
+	HAL_DisableUSBInterrupt(USBPortNum);
 	SIE_WriteCommandData(CMD_SET_ADDR, DAT_WR_BYTE(DEV_EN | Address)); /* Don't wait for next */
 	SIE_WriteCommandData(CMD_SET_ADDR, DAT_WR_BYTE(DEV_EN | Address)); /*  Setup Status Phase */
+	HAL_EnableUSBInterrupt(USBPortNum);
 }
 /********************************************************************//**
  * @brief
@@ -309,6 +406,8 @@ void SlaveEndpointISR()
 			{
 				uint32_t SIEEndpointStatus;
 				
+				/* Clearing the interrupt has the SIE select the endpoint; its status is there
+				 * within a few SIE clocks */
 				while ((LPC_USB->USBDevIntSt & CDFULL_INT) == 0);
 				SIEEndpointStatus = LPC_USB->USBCmdData;
 				
@@ -316,7 +415,11 @@ void SlaveEndpointISR()
 				{
 					SETUPReceived = true;
 					ReadControlEndpoint(SetupPackage);
-				}else
+					USB_Device_SETUPCount++;
+					#if defined(INTERRUPT_CONTROL_ENDPOINT)
+					HAL_PendControlRequest(USBPortNum);
+					#endif
+				}else if (SIEEndpointStatus & EP_SEL_F) /* Data, unless the status stage cleared it already */
 				{
 					ReadControlEndpoint(usb_data_buffer);
 				}
@@ -345,26 +448,52 @@ void SlaveEndpointISR()
 void Endpoint_Streaming(uint8_t * buffer,uint16_t packetsize,
 						uint16_t totalpackets,uint16_t dummypackets)
 {
-	uint8_t PhyEP = endpointhandle[endpointselected];
-	uint16_t i;
+	uint32_t Remaining;
+	uint16_t Length, Segment;
+	uint16_t PreviousFrameNumber;
+	uint16_t TimeoutMSRem;
+	uint8_t  Queued = 0;
 
 	dummypackets = dummypackets;
-	if(PhyEP&1)
+	if (packetsize == 0)
+		return;
+
+	/* The buffer is moved as a chain of DDs of up to 64KB each, so the CPU only steps in
+	 * once per DD rather than once per packet */
+	Remaining = (uint32_t) packetsize * totalpackets;
+	Segment   = (0xFFFF / packetsize) * packetsize;
+	while (Remaining || Queued)
 	{
-		for(i=0;i<totalpackets;i++){
-			while(!Endpoint_IsReadWriteAllowed());
-			Endpoint_Write_Stream_LE((void*)(buffer + i*packetsize), packetsize,NULL);
-			Endpoint_ClearIN();
+		Length = MIN(Remaining, Segment);
+		while (Remaining && Endpoint_StartDMA(buffer, Length))
+		{
+			buffer    += Length;
+			Remaining -= Length;
+			Length     = MIN(Remaining, Segment);
+			Queued++;
 		}
-	}
-	else
-	{
-		for(i=0;i<totalpackets;i++){
-			DcdDataTransfer(PhyEP, usb_data_buffer_OUT, packetsize);
-			Endpoint_ClearOUT();
-			while(!Endpoint_IsReadWriteAllowed());
-			Endpoint_Read_Stream_LE((void*)(buffer + i*packetsize),packetsize,NULL);
+
+		/* As Endpoint_WaitDMA(), but a bus reset also ends the stream: whatever is still queued is dropped if
+		 * the device leaves the configured state, the endpoint is stalled or the oldest DD has not retired
+		 * after USB_STREAM_TIMEOUT_MS */
+		PreviousFrameNumber = USB_Device_GetFrameNumber();
+		TimeoutMSRem        = USB_STREAM_TIMEOUT_MS;
+		while (!Endpoint_IsDMAComplete())
+		{
+			if (USB_Device_GetFrameNumber() != PreviousFrameNumber)
+			{
+				PreviousFrameNumber = USB_Device_GetFrameNumber();
+				TimeoutMSRem--;
+			}
+
+			if ((USB_DeviceState != DEVICE_STATE_Configured) || Endpoint_IsStalled() || !TimeoutMSRem)
+			{
+				Endpoint_AbortDMA();
+				return;
+			}
 		}
+		Endpoint_ReleaseDMA();
+		Queued--;
 	}
 }
 
@@ -411,7 +540,315 @@ void DcdDataTransfer(uint8_t PhyEP, uint8_t *pData, uint32_t cnt)
 	UDCA[PhyEP] = (uint32_t) &dmaDescriptor[PhyEP];
 	LPC_USB->USBEpDMAEn = (1 << PhyEP);
 }
-void DMAEndTransferISR() 
+
+/* Points the engine at a DD of the chain while the endpoint's DMA is idle. The DD takes
+ * the packet a pending new DD request was about. The request is cleared once the DD is
+ * armed: a packet arriving just before could raise a new one, which the DD answers too. */
+static void DMAChainArm(uint8_t PhyEP, PDMADescriptor Dd)
+{
+	UDCA[PhyEP] = (uint32_t) Dd;
+	LPC_USB->USBEpDMAEn = (1 << PhyEP);
+
+	LPC_USB->USBNDDRIntClr = (1 << PhyEP);
+	DMANewDDPending &= ~(1 << PhyEP);
+
+	if (!IsOutEndpoint(PhyEP))
+		LPC_USB->USBDMARSet = (1 << PhyEP);
+}
+
+/* The chain has drained, the endpoint goes back to the staging buffers. A new DD request
+ * set aside meanwhile is raised again so that the waiting packet gets staged. */
+static void DMAChainHandOver(uint8_t PhyEP)
+{
+	DMAUserBuffer &= ~(1 << PhyEP);
+	if (DMANewDDPending & (1 << PhyEP))
+	{
+		DMANewDDPending &= ~(1 << PhyEP);
+		LPC_USB->USBNDDRIntSet = (1 << PhyEP);
+	}
+}
+
+bool Endpoint_StartDMA(void* Buffer, uint16_t Length)
+{
+	uint8_t  PhyEP = endpointhandle[endpointselected];
+	uint8_t  Count, Slot;
+	uint16_t Staged = 0;
+	PDMADescriptor Dd, Tail;
+
+	HAL_DisableUSBInterrupt(USBPortNum);
+
+	Count = DMAChainCount[PhyEP];
+	if (Count == ENDPOINT_DMA_CHAIN_LENGTH)
+	{
+		HAL_EnableUSBInterrupt(USBPortNum);
+		return false;
+	}
+
+	if (IsOutEndpoint(PhyEP))
+	{
+		/* A DD the NDD interrupt armed into usb_data_buffer_OUT is for a packet which is already
+		 * in the endpoint buffer, wait for it to retire. If the ISR has not seen its EOT yet the
+		 * bytes are accounted for here. */
+		if (!(DMAUserBuffer & (1 << PhyEP)))
+		{
+			while (!dmaDescriptor[PhyEP].Retired)
+			{
+				HAL_EnableUSBInterrupt(USBPortNum);
+				HAL_DisableUSBInterrupt(USBPortNum);
+			}
+
+			if (LPC_USB->USBEoTIntSt & (1 << PhyEP))
+			{
+				LPC_USB->USBEoTIntClr = (1 << PhyEP);
+				usb_data_buffer_OUT_size += dmaDescriptor[PhyEP].PresentCount;
+			}
+		}
+
+		/* Data staged before the transfer was queued belongs at its head. Nothing is staged while
+		 * a DD of the chain is armed, so this never reorders the stream. */
+		Staged = MIN(usb_data_buffer_OUT_size, Length);
+		memcpy(Buffer, &usb_data_buffer_OUT[usb_data_buffer_OUT_index], Staged);
+		usb_data_buffer_OUT_index += Staged;
+		usb_data_buffer_OUT_size  -= Staged;
+		if (usb_data_buffer_OUT_size == 0)
+			usb_data_buffer_OUT_index = 0;
+
+		/* Staging may have switched the NDD interrupt off when usb_data_buffer_OUT filled up */
+		LPC_USB->USBDMAIntEn |= NDD_REQ_INT;
+	}
+
+	Slot = (DMAChainHead[PhyEP] + Count) % ENDPOINT_DMA_CHAIN_LENGTH;
+	Dd   = &DMAChain[PhyEP][Slot];
+	memset(Dd, 0, sizeof(DMADescriptor));
+	Dd->MaxPacketSize   = dmaDescriptor[PhyEP].MaxPacketSize;
+	Dd->BufferLength    = Length - Staged;
+	Dd->BufferStartAddr = (uint8_t*) Buffer + Staged;
+	DMAChainStaged[PhyEP][Slot] = Staged;
+
+	DMAChainCount[PhyEP] = Count + 1;
+	DMAUserBuffer |= (1 << PhyEP);
+
+	if (IsOutEndpoint(PhyEP) && (Staged == Length))
+	{
+		/* Taken from the staging buffer as a whole, the DD is never handed to the engine */
+		Dd->Retired = 1;
+	}
+	else if (Count == 0)
+	{
+		DMAChainArm(PhyEP, Dd);
+	}
+	else
+	{
+		/* The engine fetches the new DD when the previous one retires, unless it has already
+		 * retired without a successor; the engine writes the DD it moves on to into the UDCA.
+		 * A previous DD which was served from the staging buffer never reached the engine. */
+		Tail = &DMAChain[PhyEP][(Slot + ENDPOINT_DMA_CHAIN_LENGTH - 1) % ENDPOINT_DMA_CHAIN_LENGTH];
+		Tail->NextDD      = (uint32_t) Dd;
+		Tail->NextDDValid = 1;
+
+		if (Tail->Retired &&
+			((IsOutEndpoint(PhyEP) && (Tail->BufferLength == 0)) || (UDCA[PhyEP] != (uint32_t) Dd)))
+		{
+			DMAChainArm(PhyEP, Dd);
+		}
+	}
+
+	HAL_EnableUSBInterrupt(USBPortNum);
+	return true;
+}
+
+bool Endpoint_IsDMAComplete(void)
+{
+	uint8_t PhyEP = endpointhandle[endpointselected];
+
+	if (DMAChainCount[PhyEP] == 0)
+		return true;
+
+	return DMAChain[PhyEP][DMAChainHead[PhyEP]].Retired ? true : false;
+}
+
+uint16_t Endpoint_ReleaseDMA(void)
+{
+	uint8_t  PhyEP = endpointhandle[endpointselected];
+	uint8_t  Head  = DMAChainHead[PhyEP];
+	uint16_t Transferred;
+
+	if (DMAChainCount[PhyEP] == 0)
+		return 0;
+
+	Transferred = DMAChainStaged[PhyEP][Head] + DMAChain[PhyEP][Head].PresentCount;
+
+	HAL_DisableUSBInterrupt(USBPortNum);
+
+	DMAChainHead[PhyEP] = (Head + 1) % ENDPOINT_DMA_CHAIN_LENGTH;
+	DMAChainCount[PhyEP]--;
+
+	/* With the chain empty the endpoint goes back to the staging buffers, once the ISR is past
+	 * the EOT of the last DD so that it does not take it for one of the staging DD */
+	if ((DMAChainCount[PhyEP] == 0) && !(LPC_USB->USBEoTIntSt & (1 << PhyEP)))
+		DMAChainHandOver(PhyEP);
+
+	HAL_EnableUSBInterrupt(USBPortNum);
+
+	return Transferred;
+}
+
+void Endpoint_AbortDMA(void)
+{
+	uint8_t PhyEP = endpointhandle[endpointselected];
+
+	HAL_DisableUSBInterrupt(USBPortNum);
+
+	LPC_USB->USBEpDMADis  = (1 << PhyEP);
+	LPC_USB->USBEoTIntClr = (1 << PhyEP);
+	UDCA[PhyEP] = 0;
+
+	DMAChainCount[PhyEP] = 0;
+	DMAChainHandOver(PhyEP);
+
+	LPC_USB->USBEpDMAEn = (1 << PhyEP);
+
+	HAL_EnableUSBInterrupt(USBPortNum);
+}
+
+/* Queues the DD in Slot of the stream with the given IN packet lengths, behind the last one queued.
+ * If that one retired before it could be chained, the engine is idle and is given the DD at once;
+ * the packets of the frames in between are lost. */
+static void ISOStreamQueue(ISOStream_t* Stream, uint8_t Slot, const uint16_t* PacketLength)
+{
+	uint8_t  PhyEP = Stream->PhyEP;
+	uint32_t* Word = Stream->PacketWord[Slot];
+	PDMADescriptor Dd = &Stream->Dd[Slot], Tail;
+	uint8_t  i;
+
+	memset(Dd, 0, sizeof(DMADescriptor));
+	Dd->Isochronous     = 1;
+	Dd->MaxPacketSize   = dmaDescriptor[PhyEP].MaxPacketSize;
+	Dd->BufferLength    = Stream->PacketCount;
+	Dd->BufferStartAddr = Stream->Buffer + (uint32_t) Slot * Stream->TransferSize;
+	Dd->IsoBufferAddr   = (uint32_t) Word;
+
+	for (i = 0; i < Stream->PacketCount; i++)
+		Word[i] = IsOutEndpoint(PhyEP) ? 0 : PacketLength[i];
+
+	if (Stream->Count == 0)
+	{
+		DMAChainArm(PhyEP, Dd);
+	}
+	else
+	{
+		Tail = &Stream->Dd[(Slot + Stream->Transfers - 1) % Stream->Transfers];
+		Tail->NextDD      = (uint32_t) Dd;
+		Tail->NextDDValid = 1;
+
+		if (Tail->Retired && (UDCA[PhyEP] != (uint32_t) Dd))
+			DMAChainArm(PhyEP, Dd);
+	}
+
+	Stream->Count++;
+}
+
+/* Hands the DDs of the stream that have retired to the callback, in order, and queues them again */
+static void ISOStreamEndTransfer(ISOStream_t* Stream)
+{
+	uint16_t PacketLength[ENDPOINT_ISO_MAX_PACKETS];
+	uint8_t  Slot, i;
+	uint32_t Word;
+
+	while (Stream->Count && Stream->Dd[Stream->Head].Retired)
+	{
+		Slot = Stream->Head;
+		for (i = 0; i < Stream->PacketCount; i++)
+		{
+			Word = Stream->PacketWord[Slot][i];
+			if (IsOutEndpoint(Stream->PhyEP) && !(Word & ISO_PACKET_VALID))
+				PacketLength[i] = 0;
+			else
+				PacketLength[i] = Word & ISO_PACKET_LENGTH_MASK;
+		}
+
+		Stream->Head = (Slot + 1) % Stream->Transfers;
+		Stream->Count--;
+
+		if (!Stream->Callback(Stream->PhyEP / 2, Stream->Buffer + (uint32_t) Slot * Stream->TransferSize,
+							  PacketLength, Stream->PacketCount))
+			Stream->Ending = true;
+
+		if (!Stream->Ending)
+			ISOStreamQueue(Stream, Slot, PacketLength);
+	}
+}
+
+bool Endpoint_StartISOStream(ENDPOINT_ISO_CALLBACK Callback,
+							 uint8_t* const Buffer,
+							 const uint16_t TransferSize,
+							 const uint16_t* const PacketLength,
+							 const uint8_t PacketCount,
+							 const uint8_t Transfers)
+{
+	uint8_t PhyEP = endpointhandle[endpointselected];
+	ISOStream_t* Stream = NULL;
+	uint8_t n;
+
+	if ((PhyEP < 2) || !dmaDescriptor[PhyEP].Isochronous || (Callback == NULL) ||
+		(PacketCount == 0) || (PacketCount > ENDPOINT_ISO_MAX_PACKETS) ||
+		(Transfers == 0) || (Transfers > ENDPOINT_ISO_MAX_TRANSFERS))
+	{
+		return false;
+	}
+
+	HAL_DisableUSBInterrupt(USBPortNum);
+
+	for (n = 0; (n < ENDPOINT_ISO_MAX_STREAMS) && (Stream == NULL); n++)
+	{
+		if (ISOStream[n].Callback == NULL)
+			Stream = &ISOStream[n];
+	}
+
+	if ((Stream == NULL) || (DMAISOStream & (1 << PhyEP)))
+	{
+		HAL_EnableUSBInterrupt(USBPortNum);
+		return false;
+	}
+
+	Stream->Callback     = Callback;
+	Stream->Buffer       = Buffer;
+	Stream->TransferSize = TransferSize;
+	Stream->PhyEP        = PhyEP;
+	Stream->PacketCount  = PacketCount;
+	Stream->Transfers    = Transfers;
+	Stream->Head         = 0;
+	Stream->Count        = 0;
+	Stream->Ending       = false;
+
+	/* The single buffer DD of the isochronous hook may be armed, the ring takes its place */
+	LPC_USB->USBEpDMADis  = (1 << PhyEP);
+	LPC_USB->USBEoTIntClr = (1 << PhyEP);
+	DMAISOStream |= (1 << PhyEP);
+
+	for (n = 0; n < Transfers; n++)
+		ISOStreamQueue(Stream, n, PacketLength);
+
+	HAL_EnableUSBInterrupt(USBPortNum);
+	return true;
+}
+
+void Endpoint_StopISOStream(void)
+{
+	uint8_t PhyEP = endpointhandle[endpointselected];
+
+	HAL_DisableUSBInterrupt(USBPortNum);
+
+	if (DMAISOStream & (1 << PhyEP))
+	{
+		ISOStreamRelease(PhyEP);
+		LPC_USB->USBEpDMAEn = (1 << PhyEP);
+	}
+
+	HAL_EnableUSBInterrupt(USBPortNum);
+}
+
+void DMAEndTransferISR()
 {
 	uint32_t PhyEP;
 	uint32_t EoTIntSt = LPC_USB->USBEoTIntSt;
@@ -420,18 +857,30 @@ void DMAEndTransferISR()
 	{
 		if ( EoTIntSt & (1 << PhyEP))
 		{
-			if ( IsOutEndpoint(PhyEP) )                 /* OUT Endpoint */
+			if (DMAISOStream & (1 << PhyEP))		/* DD of an isochronous stream */
 			{
-				if(dmaDescriptor[PhyEP].Isochronous == 1) // iso endpoint
+				ISOStreamEndTransfer(ISOStreamFind(PhyEP));
+			}
+			else if (DMAUserBuffer & (1 << PhyEP))		/* DD of a chain, its Retired bit tells the application */
+			{
+				if (DMAChainCount[PhyEP] == 0)
+					DMAChainHandOver(PhyEP);
+			}
+			else if ( IsOutEndpoint(PhyEP) )                 /* OUT Endpoint */
+			{
+				if(dmaDescriptor[PhyEP].Isochronous == 1) // iso endpoint, never staged
 				{
 					SizeAudioTransfer = (BufferAddressIso[0])& 0xFFFF;
 					ISO_Address = (uint8_t*)CALLBACK_HAL_GetISOBufferAddress(PhyEP/2,&SizeAudioTransfer);
 					DcdDataTransfer(PhyEP, ISO_Address,512);
 				}
-				usb_data_buffer_OUT_size += dmaDescriptor[PhyEP].PresentCount;
-				if((usb_data_buffer_OUT_size + usb_data_buffer_OUT_index +
-								dmaDescriptor[PhyEP].MaxPacketSize) > 512)
-							LPC_USB->USBDMAIntEn &= ~(1<<1);
+				else
+				{
+					usb_data_buffer_OUT_size += dmaDescriptor[PhyEP].PresentCount;
+					if((usb_data_buffer_OUT_size + usb_data_buffer_OUT_index +
+									dmaDescriptor[PhyEP].MaxPacketSize) > 512)
+								LPC_USB->USBDMAIntEn &= ~(1<<1);
+				}
 			}
 			else			                    /* IN Endpoint */
 			{
@@ -451,12 +900,22 @@ void DMANewTransferRequestISR()
 	{
 		if ( NDDRIntSt & (1 << PhyEP))
 		{
-			if ( IsOutEndpoint(PhyEP) )                     /* OUT Endpoint */
+			if (DMAISOStream & (1 << PhyEP))
+			{
+				/* The stream has no DD queued: it is ending, or its callback is late and the DD it
+				 * queues next is armed straight away. The packet of this frame is lost. */
+			}
+			else if ( IsOutEndpoint(PhyEP) )                     /* OUT Endpoint */
 			{
 				if(dmaDescriptor[PhyEP].Isochronous == 1) // iso endpoint
 				{
 					DcdDataTransfer(PhyEP, ISO_Address,512);
 				}
+				else if (DMAUserBuffer & (1 << PhyEP))
+				{
+					/* The chain owns the endpoint, the packet waits for the next DD queued on it */
+					DMANewDDPending |= (1 << PhyEP);
+				}
 				else
 				{
 					uint16_t MaxPS = dmaDescriptor[PhyEP].MaxPacketSize;
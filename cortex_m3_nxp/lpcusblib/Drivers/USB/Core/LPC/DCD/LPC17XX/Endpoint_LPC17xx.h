@@ -88,6 +88,12 @@
 			#define ENDPOINT_DETAILS_MAXEP		6							/* Maximum of supported endpoint */
 			#define USED_PHYSICAL_ENDPOINTS		(ENDPOINT_DETAILS_MAXEP*2) 	/* This macro effect memory size of the DCD */
 
+			#if !defined(ENDPOINT_DMA_CHAIN_LENGTH)
+				#define ENDPOINT_DMA_CHAIN_LENGTH	4							/* DDs per endpoint for Endpoint_StartDMA() */
+			#endif
+
+			#define ENDPOINT_ISO_MAX_STREAMS	2							/* isochronous endpoints streaming at the same time */
+
 			extern volatile bool SETUPReceived;
 			extern DMADescriptor dmaDescriptor[USED_PHYSICAL_ENDPOINTS];
 			
@@ -112,6 +118,37 @@
 
 	#endif
 
+	/* Public Interface - May be used in end-application: */
+		/* Macros: */
+			/** Defined as the endpoints' DMA engine can be lent buffers of the application or class driver, see
+			 *  \ref Endpoint_StartDMA(). Class drivers then move their data without copying it through the staging buffers.
+			 */
+			#define ENDPOINT_DMA_BUFFERS
+
+			/** Defined as isochronous endpoints can stream through a ring of DMA descriptors, see
+			 *  \ref Endpoint_StartISOStream(). Class drivers then handle a few frames of packets per interrupt.
+			 */
+			#define ENDPOINT_ISO_STREAMS
+
+			#if !defined(ENDPOINT_ISO_MAX_TRANSFERS) || defined(__DOXYGEN__)
+				/** Largest number of transfers an isochronous stream keeps queued, see \ref Endpoint_StartISOStream(). */
+				#define ENDPOINT_ISO_MAX_TRANSFERS	4
+			#endif
+
+			#if !defined(ENDPOINT_ISO_MAX_PACKETS) || defined(__DOXYGEN__)
+				/** Largest number of packets (one per frame) in each transfer of an isochronous stream. */
+				#define ENDPOINT_ISO_MAX_PACKETS	8
+			#endif
+
+		/* Type Defines: */
+			/** Callback of an isochronous stream, called from the USB interrupt for each finished transfer. On entry
+			 *  PacketLength holds the bytes each packet carried (0 for a frame in which no OUT packet arrived), on
+			 *  return the lengths of the IN packets the buffer is queued again with when the callback returns \c true.
+			 *  The packets lie back to back in the buffer.
+			 */
+			typedef bool (*ENDPOINT_ISO_CALLBACK)(const uint8_t EndpointNumber, uint8_t* Buffer,
+			                                      uint16_t* PacketLength, const uint8_t PacketCount);
+
 		/* Inline Functions: */
 			/** Configures the specified endpoint number with the given endpoint type, direction, bank size
 			 *  and banking mode. Once configured, the endpoint may be read from or written to, depending
@@ -301,8 +338,10 @@
 				{
 					uint8_t SelEP_Data;
 					if (dmaDescriptor[ endpointhandle[endpointselected] ].Retired == true){
+						HAL_DisableUSBInterrupt(USBPortNum);
 						SIE_WriteCommamd( CMD_SEL_EP(endpointhandle[endpointselected]) );
 						SelEP_Data = SIE_ReadCommandData( DAT_SEL_EP(endpointhandle[endpointselected]) ) ;
+						HAL_EnableUSBInterrupt(USBPortNum);
 						if((SelEP_Data & 1) == 0)
 							return true;
 					}
@@ -357,8 +396,10 @@
 				SETUPReceived = false;
 				usb_data_buffer_index = 0;
 				usb_data_buffer_size = 0;
+				HAL_DisableUSBInterrupt(USBPortNum);
 				SIE_WriteCommamd(CMD_SEL_EP(ENDPOINT_CONTROLEP));
 				SIE_WriteCommamd(CMD_CLR_BUF);
+				HAL_EnableUSBInterrupt(USBPortNum);
 			}
 
 			/** Sends an IN packet to the host on the currently selected endpoint, freeing up the endpoint for the
@@ -395,9 +436,11 @@
 				usb_data_buffer_index = 0;
 				if(endpointselected == ENDPOINT_CONTROLEP)	   /* Control only */
 				{
+					HAL_DisableUSBInterrupt(USBPortNum);
 					SIE_WriteCommamd(CMD_SEL_EP(ENDPOINT_CONTROLEP));
 					SIE_WriteCommamd(CMD_CLR_BUF);
 					isOutReceived = false;
+					HAL_EnableUSBInterrupt(USBPortNum);
 				}else
 				{
 					usb_data_buffer_OUT_index = 0;
@@ -500,6 +543,95 @@
 			 */
 			uint8_t Endpoint_WaitUntilReady(void);
 
+			/** Lends a buffer to the DMA engine of the currently selected non-control endpoint, which moves
+			 *  \c Length bytes between it and the host without going through the endpoint's staging buffer.
+			 *  An IN transfer sends the buffer as full packets followed by a short one, if any; an OUT transfer
+			 *  ends when the buffer is full or on a short packet, and begins with whatever was already staged
+			 *  for the endpoint (the bytes following a command block, for instance).
+			 *
+			 *  Up to \c ENDPOINT_DMA_CHAIN_LENGTH transfers can be queued on an endpoint. Each one gets its own
+			 *  DMA descriptor, chained to the previous one, so the engine goes on to the next transfer as soon as
+			 *  a transfer ends, without waiting for the CPU; a transfer raises a single end of transfer interrupt
+			 *  however many packets it takes. An OUT transfer which ends early on a short packet does not end the
+			 *  ones queued behind it.
+			 *
+			 *  The buffer belongs to the DMA engine until the transfer is handed back by \ref Endpoint_ReleaseDMA(),
+			 *  so the caller can prepare its next buffer meanwhile. The endpoint's stream and packet functions must
+			 *  not be used while transfers are queued on it.
+			 *
+			 *  \ingroup Group_EndpointRW_LPC17xx
+			 *
+			 *  \note This routine should only be called on bulk and interrupt type endpoints.
+			 *
+			 *  \param[in,out] Buffer  Data to send, or room for the data to receive, in memory the USB DMA can reach.
+			 *  \param[in]     Length  Number of bytes to transfer.
+			 *
+			 *  \return Boolean \c true if the transfer was queued, \c false if the endpoint's queue is full.
+			 */
+			bool Endpoint_StartDMA(void* Buffer, uint16_t Length);
+
+			/** Determines if the oldest transfer queued on the currently selected endpoint by \ref Endpoint_StartDMA()
+			 *  has ended.
+			 *
+			 *  \ingroup Group_EndpointRW_LPC17xx
+			 *
+			 *  \return Boolean \c true if the transfer has ended or none is queued, \c false while it is in progress.
+			 */
+			bool Endpoint_IsDMAComplete(void) ATTR_WARN_UNUSED_RESULT;
+
+			/** Takes the oldest transfer off the queue of the currently selected endpoint, handing its buffer back
+			 *  to the caller. Only to be called once \ref Endpoint_IsDMAComplete() has returned \c true.
+			 *
+			 *  \ingroup Group_EndpointRW_LPC17xx
+			 *
+			 *  \return Number of bytes transferred, less than the transfer's length if an OUT transfer ended on a
+			 *          short packet.
+			 */
+			uint16_t Endpoint_ReleaseDMA(void);
+
+			/** Drops all the transfers queued on the currently selected endpoint, for instance when the host has
+			 *  aborted the command they belong to. Their buffers are handed back at once; packets the host sends
+			 *  afterwards go to the endpoint's staging buffer again.
+			 *
+			 *  \ingroup Group_EndpointRW_LPC17xx
+			 */
+			void Endpoint_AbortDMA(void);
+
+			/** Starts streaming on the currently selected ISOCHRONOUS type endpoint. \c Transfers DMA descriptors of
+			 *  \c PacketCount packets each are chained, transfer \c n using the buffer at \c Buffer + \c n * \c TransferSize,
+			 *  and the engine moves one packet per frame. Each finished transfer is handed to the callback from the USB
+			 *  interrupt, which consumes (OUT) or refills (IN) the buffer and sets the packet lengths it is queued again
+			 *  with, so the stream keeps running without the application touching individual packets or frames. A
+			 *  callback late by less than (\c Transfers - 1) * \c PacketCount frames loses no packet.
+			 *
+			 *  \note The buffer must be in the USB RAM. An OUT transfer needs \c PacketCount times the endpoint size.
+			 *
+			 *  \ingroup Group_EndpointRW_LPC17xx
+			 *
+			 *  \param[in] Callback      Function called with each finished transfer, returning \c true to queue it again.
+			 *  \param[in] Buffer        Buffer of the queued transfers.
+			 *  \param[in] TransferSize  Distance in bytes between the buffers of two transfers.
+			 *  \param[in] PacketLength  Length of each IN packet of the first transfers, unused for an OUT endpoint.
+			 *  \param[in] PacketCount   Number of packets per transfer, up to \ref ENDPOINT_ISO_MAX_PACKETS.
+			 *  \param[in] Transfers     Number of transfers kept queued, up to \ref ENDPOINT_ISO_MAX_TRANSFERS.
+			 *
+			 *  \return Boolean \c true if the stream was started, \c false if the endpoint is not isochronous, the
+			 *          parameters are out of range or too many endpoints are streaming.
+			 */
+			bool Endpoint_StartISOStream(ENDPOINT_ISO_CALLBACK Callback,
+			                             uint8_t* const Buffer,
+			                             const uint16_t TransferSize,
+			                             const uint16_t* const PacketLength,
+			                             const uint8_t PacketCount,
+			                             const uint8_t Transfers);
+
+			/** Stops a stream started with \ref Endpoint_StartISOStream() on the currently selected endpoint. The
+			 *  callback is not called again and the stream buffer may be released once this returns.
+			 *
+			 *  \ingroup Group_EndpointRW_LPC17xx
+			 */
+			void Endpoint_StopISOStream(void);
+
 	/* Disable C linkage for C++ Compilers: */
 		#if defined(__cplusplus)
 			}
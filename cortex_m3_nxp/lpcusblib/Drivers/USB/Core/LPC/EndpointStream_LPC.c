@@ -117,6 +117,65 @@ uint8_t Endpoint_Read_Stream_BE(void* const Buffer,
 	return ENDPOINT_RWSTREAM_NoError;
 }
 
+#if defined(ENDPOINT_DMA_BUFFERS)
+uint8_t Endpoint_Write_DMA_Stream(const void* const Buffer,
+			                                  uint16_t Length)
+{
+	if (!(Endpoint_StartDMA((void*) Buffer, Length)))
+		return ENDPOINT_RWSTREAM_IncompleteTransfer;
+
+	return Endpoint_WaitDMA(NULL);
+}
+
+uint8_t Endpoint_Read_DMA_Stream(void* const Buffer,
+			                                 uint16_t Length,
+			                                 uint16_t* const BytesReceived)
+{
+	if (!(Endpoint_StartDMA(Buffer, Length)))
+		return ENDPOINT_RWSTREAM_IncompleteTransfer;
+
+	return Endpoint_WaitDMA(BytesReceived);
+}
+
+uint8_t Endpoint_WaitDMA(uint16_t* const BytesTransferred)
+{
+	uint16_t PreviousFrameNumber = USB_Device_GetFrameNumber();
+	uint16_t TimeoutMSRem        = USB_STREAM_TIMEOUT_MS;
+	uint8_t  ErrorCode           = ENDPOINT_RWSTREAM_NoError;
+	uint16_t Transferred;
+
+	while (!(Endpoint_IsDMAComplete()))
+	{
+		if (USB_DeviceState == DEVICE_STATE_Unattached)
+		  ErrorCode = ENDPOINT_RWSTREAM_DeviceDisconnected;
+		else if (USB_DeviceState == DEVICE_STATE_Suspended)
+		  ErrorCode = ENDPOINT_RWSTREAM_BusSuspended;
+		else if (Endpoint_IsStalled())
+		  ErrorCode = ENDPOINT_RWSTREAM_EndpointStalled;
+
+		if (USB_Device_GetFrameNumber() != PreviousFrameNumber)
+		{
+			PreviousFrameNumber = USB_Device_GetFrameNumber();
+
+			if (!(TimeoutMSRem--))
+			  ErrorCode = ENDPOINT_RWSTREAM_Timeout;
+		}
+
+		if (ErrorCode != ENDPOINT_RWSTREAM_NoError)
+		{
+			Endpoint_AbortDMA();
+			return ErrorCode;
+		}
+	}
+
+	Transferred = Endpoint_ReleaseDMA();
+	if (BytesTransferred != NULL)
+	  *BytesTransferred = Transferred;
+
+	return ENDPOINT_RWSTREAM_NoError;
+}
+#endif
+
 #endif
 
 
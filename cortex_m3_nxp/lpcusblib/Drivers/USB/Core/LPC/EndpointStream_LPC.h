@@ -331,6 +331,54 @@
 			                                uint16_t Length,
 			                                uint16_t* const BytesProcessed) ATTR_NON_NULL_PTR_ARG(1);
 
+			#if defined(ENDPOINT_DMA_BUFFERS) || defined(__DOXYGEN__)
+			/** Sends the given buffer to the host by lending it to the DMA engine of the currently selected endpoint
+			 *  (see \ref Endpoint_StartDMA()), and waits until it has gone out. The data does not pass through the
+			 *  endpoint's staging buffer and no \ref Endpoint_ClearIN() is needed; the transfer ends with a short
+			 *  packet unless \c Length is a multiple of the endpoint size, a \c Length of 0 sends a zero length packet.
+			 *
+			 *  \note No other transfer may be queued on the endpoint. This routine should not be used on CONTROL
+			 *        type endpoints.
+			 *
+			 *  \param[in] Buffer  Pointer to the data to send, in memory the USB DMA can reach.
+			 *  \param[in] Length  Number of bytes to send.
+			 *
+			 *  \return A value from the \ref Endpoint_Stream_RW_ErrorCodes_t enum.
+			 */
+			uint8_t Endpoint_Write_DMA_Stream(const void* const Buffer,
+			                                  uint16_t Length) ATTR_NON_NULL_PTR_ARG(1);
+
+			/** Receives data from the host straight into the given buffer by lending it to the DMA engine of the
+			 *  currently selected endpoint (see \ref Endpoint_StartDMA()), and waits until the transfer has ended,
+			 *  either with the buffer full or on a short packet. Data already staged for the endpoint comes first.
+			 *
+			 *  \note No other transfer may be queued on the endpoint. This routine should not be used on CONTROL
+			 *        type endpoints.
+			 *
+			 *  \param[out] Buffer         Pointer to the room for the data, in memory the USB DMA can reach.
+			 *  \param[in]  Length         Size in bytes of the buffer.
+			 *  \param[out] BytesReceived  Pointer to a location where the number of bytes received is stored, \c NULL
+			 *                             if not needed.
+			 *
+			 *  \return A value from the \ref Endpoint_Stream_RW_ErrorCodes_t enum.
+			 */
+			uint8_t Endpoint_Read_DMA_Stream(void* const Buffer,
+			                                 uint16_t Length,
+			                                 uint16_t* const BytesReceived) ATTR_NON_NULL_PTR_ARG(1);
+
+			/** Waits until the oldest transfer queued on the currently selected endpoint by \ref Endpoint_StartDMA() has
+			 *  ended and hands its buffer back, as \ref Endpoint_ReleaseDMA() does. If the device is detached or suspended,
+			 *  the endpoint is stalled or the transfer has not ended after \ref USB_STREAM_TIMEOUT_MS, all the transfers
+			 *  queued on the endpoint are dropped instead.
+			 *
+			 *  \param[out] BytesTransferred  Pointer to a location where the number of bytes transferred is stored, \c NULL
+			 *                                if not needed.
+			 *
+			 *  \return A value from the \ref Endpoint_Stream_RW_ErrorCodes_t enum.
+			 */
+			uint8_t Endpoint_WaitDMA(uint16_t* const BytesTransferred);
+			#endif
+
 			/** Writes the given number of bytes to the CONTROL type endpoint from the given buffer in little endian,
 			 *  sending full packets to the host as needed. The host OUT acknowledgement is not automatically cleared
 			 *  in both failure and success states; the user is responsible for manually clearing the setup OUT to
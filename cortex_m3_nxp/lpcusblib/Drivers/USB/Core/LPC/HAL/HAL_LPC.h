@@ -70,6 +70,11 @@ void HAL_DisableUSBInterrupt(uint8_t corenum);
  *  Normally, this function is called when every setup or initial are done.
  */
 void HAL_USBConnect (uint8_t corenum, uint32_t con);
+#if defined(INTERRUPT_CONTROL_ENDPOINT)
+/** This function is used in device mode by the interrupt handler of the controller driver to have the
+ *  SETUP packet it latched processed by USB_DeviceControlTask(), in a lower priority interrupt */
+void HAL_PendControlRequest(uint8_t corenum);
+#endif
 /* Selected USB Port Number */
 extern uint8_t USBPortNum;
 #endif /*__LPC_HAL_H__*/
@@ -91,6 +91,9 @@
 		LPC_USB->USBClkCtrl = 0x12;                 /* Dev, PortSel, AHB clock enable */
 		while ((LPC_USB->USBClkSt & 0x12) != 0x12);
 		HAL_Reset();
+	#if defined(INTERRUPT_CONTROL_ENDPOINT)
+		NVIC_SetPriority(USB_CONTROL_IRQn, USB_CONTROL_IRQ_PRIORITY);
+	#endif
 	}
 #endif
  }
@@ -102,6 +105,9 @@
  void HAL_USBDeInit(uint8_t corenum)
  {
  	NVIC_DisableIRQ(USB_IRQn);               	/* disable USB interrupt */
+#if defined(INTERRUPT_CONTROL_ENDPOINT)
+ 	NVIC_DisableIRQ(USB_CONTROL_IRQn);
+#endif
  	LPC_SC->PCONP &= (~(1UL<<31));              /* disable USB Per.      */
 #if defined(__LPC17XX__)
  	LPC_PINCON->PINSEL1 &= ~((3<<26)|(3<<28));  /* P0.29 D+, P0.30 D- reset to GPIO function */
@@ -118,6 +124,9 @@
 void HAL_EnableUSBInterrupt(uint8_t corenum)
 {
 	NVIC_EnableIRQ(USB_IRQn);               	/* enable USB interrupt */
+#if defined(INTERRUPT_CONTROL_ENDPOINT)
+	NVIC_EnableIRQ(USB_CONTROL_IRQn);			/* and the one control requests are processed in */
+#endif
 }
 /********************************************************************//**
  * @brief
@@ -127,6 +136,9 @@ void HAL_EnableUSBInterrupt(uint8_t corenum)
 void HAL_DisableUSBInterrupt(uint8_t corenum)
 {
 	NVIC_DisableIRQ(USB_IRQn);               	/* enable USB interrupt */
+#if defined(INTERRUPT_CONTROL_ENDPOINT)
+	NVIC_DisableIRQ(USB_CONTROL_IRQn);			/* the stack's critical sections keep requests out too */
+#endif
 }
 /********************************************************************//**
  * @brief
@@ -163,4 +175,27 @@ void USB_IRQHandler (void)
 	return;
 }
 
+#if defined(USB_CAN_BE_DEVICE) && defined(INTERRUPT_CONTROL_ENDPOINT)
+/* Fails to compile when USB_CONTROL_IRQn is not a peripheral interrupt other than USB_IRQn */
+typedef char USB_CONTROL_IRQn_must_be_a_spare_peripheral_interrupt
+	[(USB_CONTROL_IRQn >= 0 && USB_CONTROL_IRQn != USB_IRQn) ? 1 : -1];
+
+/********************************************************************//**
+ * @brief		Have the SETUP packet the device interrupt latched processed
+ * @param		corenum	USB port
+ * @return		None
+ *********************************************************************/
+void HAL_PendControlRequest(uint8_t corenum)
+{
+	NVIC_SetPendingIRQ(USB_CONTROL_IRQn);
+}
+
+/* Runs below the USB interrupt, which goes on moving the data and status stages of the
+ * request while the handler waits for them */
+void USB_CONTROL_IRQHandler(void)
+{
+	USB_DeviceControlTask();
+}
+#endif
+
 #endif /*__LPC17XX__*/
@@ -38,6 +38,29 @@
 
 #define USBRAM_SECTION	RAM2
 
+#if defined(INTERRUPT_CONTROL_ENDPOINT)
+/* Interrupt in which the control requests are processed when INTERRUPT_CONTROL_ENDPOINT is
+ * defined. The USB interrupt pends it for each SETUP packet; it must be a peripheral interrupt
+ * the application does not use, below the priority of USB_IRQn so that the data and status
+ * stages of the request go on underneath the handler. The USB events of those requests run
+ * in it, see EVENT_USB_Device_ControlRequest.
+ * USB_CONTROL_IRQHandler must be the startup code's name for the vector: the startup code
+ * only aliases those weakly, so an application that handles the same vector itself fails
+ * to link with a multiple definition instead of losing its interrupts. */
+#if !defined(USB_CONTROL_IRQn)
+	#if defined(USB_CONTROL_IRQHandler)
+		#error USB_CONTROL_IRQHandler is defined without USB_CONTROL_IRQn
+	#endif
+	#define USB_CONTROL_IRQn			QEI_IRQn
+	#define USB_CONTROL_IRQHandler		QEI_IRQHandler
+#elif !defined(USB_CONTROL_IRQHandler)
+	#error USB_CONTROL_IRQn is defined without USB_CONTROL_IRQHandler
+#endif
+#if !defined(USB_CONTROL_IRQ_PRIORITY)
+	#define USB_CONTROL_IRQ_PRIORITY	((1 << __NVIC_PRIO_BITS) - 1)
+#endif
+#endif
+
 #if defined(__LPC177X_8X__)
 /** This macro used in Keil only to declare a variable in a defined section. */
 #if defined(__CC_ARM)
@@ -90,9 +90,35 @@ HCD_STATUS HcdClearEndpointHalt(uint32_t PipeHandle) // FIXME not implemented
 {
 	return HCD_STATUS_OK;
 }
+
+HCD_STATUS HcdSetPipeInterval(uint32_t PipeHandle, uint8_t Interval)
+{
+	uint8_t HostID, HeadIdx;
+	HCD_TRANSFER_TYPE XferType;
+
+	ASSERT_STATUS_OK( PipehandleParse(PipeHandle, &HostID, &XferType, &HeadIdx) );
+
+	if (Interval == 0)
+	{
+		ASSERT_STATUS_OK_MESSAGE(HCD_STATUS_PARAMETER_INVALID, "Interval must not be 0");
+	}
+
+	/*-- Interrupt queue heads are still polled every (micro)frame, see AllocQhd --*/
+	HcdQHD(HostID,HeadIdx)->Interval = Interval;
+
+	return HCD_STATUS_OK;
+}
 uint32_t   HcdGetFrameNumber(uint8_t HostID)
 {
-	return USB_REG(HostID)->FRINDEX_H;
+	/* FRINDEX counts microframes and wraps after 2048 frames; extend it to the 16 bit
+	   millisecond frame number the callers time their waits with */
+	static uint16_t LastIndex[MAX_USB_CORE];
+	static uint16_t FrameNumber[MAX_USB_CORE];
+	uint16_t FrameIndex = (USB_REG(HostID)->FRINDEX_H >> 3) & 0x7FF;
+
+	FrameNumber[HostID] += (uint16_t) ((FrameIndex - LastIndex[HostID]) & 0x7FF);
+	LastIndex[HostID]    = FrameIndex;
+	return FrameNumber[HostID];
 }
 HCD_STATUS HcdGetDeviceSpeed( uint8_t HostID, uint8_t PortNumber, HCD_USB_SPEED* DeviceSpeed )
 {
@@ -345,12 +371,11 @@ HCD_STATUS HcdControlTransfer(uint32_t PipeHandle, const USB_Request_Header_t* c
 	HcdQTD(HostID,SetupTdIdx)->NextQtd = (uint32_t)HcdQTD(HostID,DataTdIdx);
 	HcdQTD(HostID,DataTdIdx)->NextQtd = (uint32_t)HcdQTD(HostID,StatusTdIdx);
 	
-	/* Hook TDs to QHD */
+	/* Hook TDs to QHD, the status first: the transfer may complete as soon as it is hooked */
+	HcdQHD(HostID,QhdIdx)->status = (uint32_t) HCD_STATUS_TRANSFER_QUEUED;
 	HcdQHD(HostID,QhdIdx)->Overlay.NextQtd = (uint32_t) HcdQTD(HostID,SetupTdIdx);
 	HcdQHD(HostID,QhdIdx)->FirstQtd = Align32( (uint32_t) HcdQTD(HostID,SetupTdIdx) );
 
-	HcdQHD(HostID,QhdIdx)->status = (uint32_t) HCD_STATUS_TRANSFER_QUEUED;
-
 	/* wait for semaphore compete TDs */
 	ASSERT_STATUS_OK ( WaitForTransferComplete(HostID,QhdIdx) );
 
@@ -382,7 +407,19 @@ HCD_STATUS HcdDataTransfer(uint32_t PipeHandle, uint8_t* const buffer, uint32_t
 	ASSERT_STATUS_OK ( PipehandleParse(PipeHandle, &HostID, &XferType, &HeadIdx) );
 
 	ExpectedLength = (length != HCD_ENDPOINT_MAXPACKET_XFER_LEN) ? length : HcdQHD(HostID,HeadIdx)->MaxPackageSize; /* LUFA adaption, receive only 1 data transaction */
-	
+
+	/* The actual count is 16 bit, a longer transfer could not report how much of it was done */
+	if (ExpectedLength > 0xFFFF)
+	{
+		ASSERT_STATUS_OK_MESSAGE(HCD_STATUS_PARAMETER_INVALID, "Transfer Length exceeds 64 KB");
+	}
+
+	/* Status and count first: the transfer may complete as soon as it is hooked */
+	HcdQHD(HostID,HeadIdx)->status = (uint32_t) HCD_STATUS_TRANSFER_QUEUED;
+	HcdQHD(HostID,HeadIdx)->pActualTransferCount = pActualTransferred;
+	if (HcdQHD(HostID,HeadIdx)->pActualTransferCount)
+		*(HcdQHD(HostID,HeadIdx)->pActualTransferCount) = ExpectedLength;
+
 	if (XferType == ISOCHRONOUS_TRANSFER)
 	{
 		if ( HcdQHD(HostID,HeadIdx)->EndpointSpeed == HIGH_SPEED ) /*-- Highspeed ISO --*/
@@ -394,20 +431,15 @@ HCD_STATUS HcdDataTransfer(uint32_t PipeHandle, uint8_t* const buffer, uint32_t
 		}
 	}else /*-- Control / Bulk / Interrupt --*/
 	{
-		/* ASSERT_STATUS_OK( QueueQTDs(&DataTdIdx, buffer, ExpectedLength, HcdQHD(HeadIdx)->Direction ? IN_TRANSFER : OUT_TRANSFER, 0, 1) ); */
-		/* For simplicity, this only queue one TD only */
-		ASSERT_STATUS_OK( AllocQTD(HostID, &DataTdIdx, buffer, ExpectedLength, HcdQHD(HostID,HeadIdx)->Direction ? IN_TRANSFER : OUT_TRANSFER, 0, 1) );
+		/*-- Long transfers are chained qTDs of up to 20 KB, only the last one interrupts --*/
+		ASSERT_STATUS_OK( QueueQTDs(HostID, HeadIdx, &DataTdIdx, buffer, ExpectedLength, HcdQHD(HostID,HeadIdx)->Direction ? IN_TRANSFER : OUT_TRANSFER) );
 
 		/*---------- Hook to Queue Head ----------*/
+		HcdQHD(HostID,HeadIdx)->Overlay.AlterNextQtd = LINK_TERMINATE;	/* a short packet of the previous transfer left the overlay on its alternate link */
 		HcdQHD(HostID,HeadIdx)->Overlay.NextQtd = (uint32_t) HcdQTD(HostID,DataTdIdx);
 		HcdQHD(HostID,HeadIdx)->FirstQtd = Align32( (uint32_t) HcdQTD(HostID,DataTdIdx) );	/* used as TD head to clean up TD chain when transfer done */
 	}
 
-	HcdQHD(HostID,HeadIdx)->status = (uint32_t) HCD_STATUS_TRANSFER_QUEUED;
-	HcdQHD(HostID,HeadIdx)->pActualTransferCount = pActualTransferred; /* TODO Actual Length get rid of this */
-	if (HcdQHD(HostID,HeadIdx)->pActualTransferCount)
-		*(HcdQHD(HostID,HeadIdx)->pActualTransferCount) = ExpectedLength;
-
 	return HCD_STATUS_OK;
 }
 
@@ -420,6 +452,40 @@ HCD_STATUS HcdGetPipeStatus(uint32_t PipeHandle) /* TODO can be implemented base
 
 	return HcdQHD(HostID,HeadIdx)->status;
 }
+
+/* Completion callbacks are not supported here, EHCI pipes are polled: streaming pipes need the OHCI driver */
+HCD_STATUS HcdSetTransferCallback(uint32_t PipeHandle, HCD_TRANSFER_CALLBACK Callback)
+{
+	if (Callback == NULL) /* stopping a stream that never started */
+	{
+		return HCD_STATUS_OK;
+	}
+
+	assert_status_ok_message(HCD_STATUS_TRANSFER_TYPE_NOT_SUPPORTED, "Pipe streaming is only supported by the OHCI driver",
+							 __func__, __FILE__, __LINE__);
+	return HCD_STATUS_TRANSFER_TYPE_NOT_SUPPORTED;
+}
+
+/* Per packet isochronous transfers are not supported here, queue isochronous data with HcdDataTransfer() */
+HCD_STATUS HcdIsoTransfer(uint32_t PipeHandle, uint8_t* const buffer, const uint16_t* const PacketLength, uint8_t const PacketCount)
+{
+	assert_status_ok_message(HCD_STATUS_TRANSFER_TYPE_NOT_SUPPORTED, "Per packet isochronous transfers are only supported by the OHCI driver",
+							 __func__, __FILE__, __LINE__);
+	return HCD_STATUS_TRANSFER_TYPE_NOT_SUPPORTED;
+}
+
+/* Not supported either, see HcdSetTransferCallback() */
+HCD_STATUS HcdSetIsoCallback(uint32_t PipeHandle, HCD_ISO_CALLBACK Callback)
+{
+	if (Callback == NULL) /* stopping a stream that never started */
+	{
+		return HCD_STATUS_OK;
+	}
+
+	assert_status_ok_message(HCD_STATUS_TRANSFER_TYPE_NOT_SUPPORTED, "Isochronous streaming is only supported by the OHCI driver",
+							 __func__, __FILE__, __LINE__);
+	return HCD_STATUS_TRANSFER_TYPE_NOT_SUPPORTED;
+}
 /*==========================================================================*/
 /* QUEUE HEAD & QUEUE TD                         											*/
 /*==========================================================================*/
@@ -433,9 +499,9 @@ static void FreeQhd(uint8_t HostID, uint8_t QhdIdx )
 static HCD_STATUS AllocQhd(uint8_t HostID, uint8_t DeviceAddr, HCD_USB_SPEED DeviceSpeed, uint8_t EndpointNumber, HCD_TRANSFER_TYPE TransferType, HCD_TRANSFER_DIR TransferDir, uint16_t MaxPacketSize, uint8_t Interval, uint8_t Mult, uint8_t HSHubDevAddr, uint8_t HSHubPortNum, uint32_t* pQhdIdx )
 {
 	/* Looking for a free QHD */
-	for ( (*pQhdIdx)=0; (*pQhdIdx) < HCD_MAX_QTD && HcdQHD(HostID,*pQhdIdx)->inUse; (*pQhdIdx)++) {}
+	for ( (*pQhdIdx)=0; (*pQhdIdx) < HCD_MAX_QHD && HcdQHD(HostID,*pQhdIdx)->inUse; (*pQhdIdx)++) {}
 
-	if ((*pQhdIdx) == HCD_MAX_QTD )
+	if ((*pQhdIdx) == HCD_MAX_QHD )
 		return HCD_STATUS_NOT_ENOUGH_ENDPOINT;
 
 	memset(HcdQHD(HostID,*pQhdIdx), 0, sizeof(HCD_QHD) );
@@ -550,40 +616,71 @@ static HCD_STATUS AllocQTD (uint8_t HostID, uint32_t* pTdIdx, uint8_t* const Buf
 	}
 }
 
-#if 0
-/* For simplicity, this only queue one TD only */
-static HCD_STATUS QueueQTDs (uint32_t* pTdIdx, uint8_t* dataBuff, uint32_t xferLen, HCD_TRANSFER_DIR PIDCode, uint8_t DataToggle)
+static void FreeQtdChain(uint32_t TdLink)
 {
+	while ( isValidLink(TdLink) )
+	{
+		PHCD_QTD pQtd = (PHCD_QTD) Align32(TdLink);
+		TdLink = pQtd->NextQtd;
+		FreeQtd(pQtd);
+	}
+}
+
+/** Queue a data transfer as a chain of qTDs, each covering up to 5 pages (QTD_MAX_XFER_LENGTH less the offset of
+ *  its buffer in the first page). Every qTD but the last ends on a packet boundary, and only the last one interrupts
+ *  on completion, so the whole chain costs one interrupt. Data toggles are kept by the queue head (DataToggleControl 0).
+ */
+static HCD_STATUS QueueQTDs (uint8_t HostID, uint8_t QhdIdx, uint32_t* pTdIdx, uint8_t* dataBuff, uint32_t xferLen, HCD_TRANSFER_DIR PIDCode)
+{
+	uint32_t MaxPacketSize = HcdQHD(HostID,QhdIdx)->MaxPackageSize;
 	uint32_t TailTdIdx=0xFFFFFFFF;
 
-	while (xferLen > 0)
+	do
 	{
+		HCD_STATUS status;
+		uint32_t NewTdIdx;
 		uint32_t TdLen;
 		uint32_t MaxTDLen = QTD_MAX_XFER_LENGTH - Offset4k((uint32_t)dataBuff);
 
+		if (xferLen > MaxTDLen && MaxPacketSize)
+		{
+			MaxTDLen -= MaxTDLen % MaxPacketSize;	/*-- a packet must not straddle two qTDs --*/
+		}
 		TdLen = MIN(xferLen, MaxTDLen);
 		xferLen -= TdLen;
 
+		status = AllocQTD(HostID, &NewTdIdx, dataBuff, TdLen, PIDCode, 0, (xferLen==0) ? 1 : 0);
+		if (status != HCD_STATUS_OK)
+		{
+			if (TailTdIdx != 0xFFFFFFFF)
+			{
+				FreeQtdChain( Align32((uint32_t) HcdQTD(HostID,*pTdIdx)) );
+			}
+			ASSERT_STATUS_OK(status);
+		}
+
+		if (PIDCode == IN_TRANSFER)
+		{
+			/*-- On a short packet the controller parks on the inactive qTD instead of running the rest of the chain --*/
+			HcdQTD(HostID,NewTdIdx)->AlterNextQtd = Align32( (uint32_t) &ehci_data[HostID].ShortPacketQtd );
+			HcdQTD(HostID,NewTdIdx)->inUse = 1;
+		}
+
 		if (TailTdIdx == 0xFFFFFFFF)
 		{
-			ASSERT_STATUS_OK ( AllocQTD(pTdIdx, dataBuff, TdLen, PIDCode, DataToggle, (xferLen==0) ? 1 : 0) );
-			TailTdIdx = *pTdIdx;
+			*pTdIdx = NewTdIdx;
 		}
 		else
 		{
-			uint32_t NewTdIDx;
-			ASSERT_STATUS_OK ( AllocQTD(&NewTdIDx, dataBuff, TdLen, PIDCode, DataToggle, (xferLen==0) ? 1 : 0) );
-			HcdQTD(TailTdIdx)->NextQtd = Align32((uint32_t) HcdQTD(NewTdIDx));
-			TailTdIdx = NewTdIDx;
+			HcdQTD(HostID,TailTdIdx)->NextQtd = Align32( (uint32_t) HcdQTD(HostID,NewTdIdx) );
 		}
-		DataToggle = 1 - DataToggle;
+		TailTdIdx = NewTdIdx;
 		dataBuff += TdLen;
-	}
+	} while (xferLen > 0);
+
 	return HCD_STATUS_OK;
 }
 
-#endif
-
 /*==========================================================================*/
 /* Highspeed & Split ISO TD                        											*/
 /*==========================================================================*/
@@ -810,7 +907,7 @@ static HCD_STATUS PipehandleParse(uint32_t Pipehandle, uint8_t* pHostID, HCD_TRA
 	Pipe_Handle_Type* pHandle = (Pipe_Handle_Type*) (&Pipehandle);
 
 	if	(	pHandle->HostId >= MAX_USB_CORE ||
-			pHandle->Idx >= HCD_MAX_QTD		||
+			pHandle->Idx >= HCD_MAX_QHD		||
 			HcdQHD(pHandle->HostId,pHandle->Idx)->inUse == 0	||
 			HcdQHD(pHandle->HostId,pHandle->Idx)->status == HCD_STATUS_TO_BE_REMOVED)
 	{
@@ -969,6 +1066,22 @@ static void RemoveCompletedQTD(PHCD_QHD pQhd)
 		{
 			pQhd->status = HCD_STATUS_TRANSFER_Stall;
 		}
+		else if (pQtd->TotalBytesToTransfer && pQtd->PIDCode == 1 && isValidLink(TdLink))
+		{
+			/*-- Short packet inside an IN chain: the controller took the alternate link, the rest never ran --*/
+			while ( isValidLink(TdLink) )
+			{
+				PHCD_QTD pRest = (PHCD_QTD) Align32(TdLink);
+				TdLink = pRest->NextQtd;
+
+				if(pQhd->pActualTransferCount)
+					*(pQhd->pActualTransferCount) -= pRest->TotalBytesToTransfer;
+
+				pRest->Active = 0;
+				FreeQtd(pRest);
+			}
+			pQhd->status = HCD_STATUS_OK;
+		}
 		FreeQtd(pQtd);
 	}
 	pQhd->FirstQtd = TdLink;
@@ -1185,6 +1298,11 @@ static __INLINE HCD_STATUS EHciHostInit(uint8_t HostID)
 
 	USB_REG(HostID)->ASYNCLISTADDR = (uint32_t) HcdAsyncHead(HostID);
 
+	/*-- Parking qTD for short packets, never active --*/
+	ehci_data[HostID].ShortPacketQtd.NextQtd = LINK_TERMINATE;
+	ehci_data[HostID].ShortPacketQtd.AlterNextQtd = LINK_TERMINATE;
+	ehci_data[HostID].ShortPacketQtd.Active = 0;
+
 	/*---------- Periodic List ----------*/
 	/*-- Static Interrupt Qhd (1 ms) --*/
 	HcdIntHead(HostID)->Horizontal.Link = LINK_TERMINATE;
@@ -41,7 +41,10 @@
 /*  EHCI C O N F I G U R A T I O N                        */
 /*=======================================================================*/
 #define HCD_MAX_QHD					HCD_MAX_ENDPOINT		/* USBD_USB_HC_EHCI */
-#define	HCD_MAX_QTD					(HCD_MAX_ENDPOINT+3)	/* USBD_USB_HC_EHCI */
+#if !defined(HCD_MAX_QTD_CHAIN)
+#define HCD_MAX_QTD_CHAIN			16			/* qTDs for chaining long transfers, set in LPCUSBlibConfig.h */
+#endif
+#define	HCD_MAX_QTD					(HCD_MAX_GTD + HCD_MAX_QTD_CHAIN)	/* USBD_USB_HC_EHCI */
 #define	HCD_MAX_HS_ITD				4						/* USBD_USB_HC_EHCI */
 #define HCD_MAX_SITD				16						/* USBD_USB_HC_EHCI */
 
@@ -190,10 +193,8 @@ typedef struct st_EHCD_QTD{
 		uint32_t AlterNextQtd;
 		struct  {
 			uint32_t Terminate : 1;
-			uint32_t : 4;
 
-			// === TODO: used reserved space, need to move to other place ===
-			/*-- HCD Area --*/
+			/*-- HCD Area, in the reserved bits [4:1]: the alternate link of an IN chain is a live pointer --*/
 			uint32_t inUse : 1;
 			uint32_t : 0;
 		};
@@ -360,6 +361,7 @@ typedef struct st_EHCI_HOST_DATA{
 	HCD_QHD				IntHeadQhd;							/* Serve as Static 1ms Interrupt Heads */
 	HCD_QHD				qHDs[HCD_MAX_QHD];				/* Queue Head */
 	HCD_QTD				qTDs[HCD_MAX_QTD];				/* Queue Transfer Descriptor (Queue Element) */
+	HCD_QTD				ShortPacketQtd;					/* Inactive qTD the alternate links of IN chains point to, ends a chain on a short packet */
 	HCD_SITD			siTDs[HCD_MAX_SITD];			/* Split Iso Transfer Descriptor */
 }EHCI_HOST_DATA_Type;
 
@@ -427,7 +429,8 @@ static HCD_STATUS InsertLinkPointer(NextLinkPointer *pList, NextLinkPointer *pNe
 static HCD_STATUS RemoveQueueHead(uint8_t HostID, uint8_t QhdIdx );
 static void FreeQtd( PHCD_QTD pQtd );
 static HCD_STATUS AllocQTD (uint8_t HostID, uint32_t* pTdIdx, uint8_t* const BufferPointer, uint32_t xferLen, HCD_TRANSFER_DIR PIDCode, uint8_t DataToggle, uint8_t IOC);
-/*static HCD_STATUS QueueQTDs (uint32_t* pTdIdx, uint8_t* dataBuff, uint32_t xferLen, HCD_TRANSFER_DIR PIDCode, uint8_t DataToggle);*/
+static HCD_STATUS QueueQTDs (uint8_t HostID, uint8_t QhdIdx, uint32_t* pTdIdx, uint8_t* dataBuff, uint32_t xferLen, HCD_TRANSFER_DIR PIDCode);
+static void FreeQtdChain(uint32_t TdLink);
 /********************************* ISO Head & ISO TD & Split ISO *********************************/
 static void FreeHsItd( PHCD_HS_ITD pItd );
 static HCD_STATUS AllocHsItd(uint8_t HostID, uint32_t* pTdIdx, uint8_t IhdIdx, uint8_t* dataBuff, uint32_t TDLen, uint8_t XactPerITD, uint8_t IntOnComplete);
@@ -35,6 +35,11 @@
 
 #include "../../USBTask.h"
 
+#if USE_FREERTOS_DELAY
+	#include "FreeRTOS.h"
+	#include "task.h"
+#endif
+
 /*==========================================================================*/
 /* Private Functions to OHCI EHCI                        											*/
 /*==========================================================================*/
@@ -54,6 +59,14 @@ void assert_status_ok_message(HCD_STATUS status, char const * mess, char const *
 }
 #endif
 
+#if USE_FREERTOS_DELAY
+/* vTaskDelay() may only be used from a task once the scheduler has been started */
+static __INLINE bool HcdCanSleep(void)
+{
+	return (__get_IPSR() == 0) && (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING);
+}
+#endif
+
 void  HcdDelayUS (uint32_t  delay)
 {
 	volatile  uint32_t  i;
@@ -66,11 +79,34 @@ void  HcdDelayMS (uint32_t  delay)
 {
 	volatile  uint32_t  i;
 
+#if USE_FREERTOS_DELAY
+	if (HcdCanSleep())
+	{
+		/* Reset and settle times are minimums: round up to whole ticks, plus one for the
+		 * part of the current tick that has already gone. A call thus sleeps a tick longer
+		 * than asked for, so waits made of many short calls check a deadline on the frame
+		 * counter rather than counting the calls. */
+		vTaskDelay(((delay + portTICK_RATE_MS - 1) / portTICK_RATE_MS) + 1);
+		return;
+	}
+#endif
+
 	for (i = 0; i < delay; i++) {
 		HcdDelayUS(1000);
 	}
 }
 
+/* Hand the CPU to other tasks for one tick while the host stack has nothing to do, no-op on bare metal */
+void  HcdYield (void)
+{
+#if USE_FREERTOS_DELAY
+	if (HcdCanSleep())
+	{
+		vTaskDelay(1);
+	}
+#endif
+}
+
 HCD_STATUS OpenPipe_VerifyParameters( uint8_t HostID, uint8_t DeviceAddr, HCD_USB_SPEED DeviceSpeed, uint8_t EndpointNumber, HCD_TRANSFER_TYPE TransferType, HCD_TRANSFER_DIR TransferDir, uint16_t MaxPacketSize, uint8_t Interval, uint8_t Mult )
 {
 	if	(HostID >= MAX_USB_CORE ||
@@ -42,7 +42,19 @@
 #define YES									1
 #define NO									0
 
-#define HCD_MAX_ENDPOINT					8	/* Maximum number of endpoints */
+#if !defined(HCD_MAX_ENDPOINT)
+#define HCD_MAX_ENDPOINT					8	/* Maximum number of endpoints, set in LPCUSBlibConfig.h */
+#endif
+
+#if !defined(HCD_MAX_GTD)
+#define HCD_MAX_GTD							(HCD_MAX_ENDPOINT + 3)	/* Maximum number of general transfer descriptors, set in LPCUSBlibConfig.h */
+#endif
+
+#if !defined(HCD_MAX_ITD)
+#define HCD_MAX_ITD							4	/* Maximum number of isochronous TDs, set in LPCUSBlibConfig.h */
+#endif
+
+#define HCD_ISO_MAX_PACKETS					8	/* Packets (one per frame) carried by one isochronous transfer */
 
 #define HC_RESET_TIMEOUT					10			/* in microseconds */
 #define TRANSFER_TIMEOUT_MS					1000
@@ -120,9 +132,19 @@ typedef enum {
 
 	/* 31-35 */
 	HCD_STATUS_PIPEHANDLE_INVALID,
-	HCD_STATUS_PARAMETER_INVALID
+	HCD_STATUS_PARAMETER_INVALID,
+	HCD_STATUS_NOT_ENOUGH_BANDWIDTH
 }HCD_STATUS;
 
+/* Completion callback of a pipe, called from the USB interrupt with the buffer and length of each finished
+ * transfer. Returning true queues the same buffer again straight from the interrupt (streaming pipes). */
+typedef bool (*HCD_TRANSFER_CALLBACK)(uint32_t PipeHandle, HCD_STATUS Status, uint8_t* Buffer, uint16_t Length);
+
+/* Completion callback of an isochronous pipe, called from the USB interrupt for each finished transfer. On entry
+ * PacketLength holds the bytes each packet carried (0 for a packet lost on the bus), on return the packet layout the
+ * buffer is queued again with for the following frames when the callback returns true. */
+typedef bool (*HCD_ISO_CALLBACK)(uint32_t PipeHandle, HCD_STATUS Status, uint8_t* Buffer, uint16_t* PacketLength, uint8_t PacketCount);
+
 //////////////////////////////////////////////////////////////////////////
 HCD_STATUS HcdInitDriver (uint8_t HostID);
 HCD_STATUS HcdDeInitDriver(uint8_t HostID);
@@ -156,6 +178,7 @@ HCD_STATUS HcdOpenPipe(uint8_t HostID,
 HCD_STATUS HcdClosePipe(uint32_t PipeHandle);
 HCD_STATUS HcdCancelTransfer(uint32_t PipeHandle);
 HCD_STATUS HcdClearEndpointHalt(uint32_t PipeHandle);
+HCD_STATUS HcdSetPipeInterval(uint32_t PipeHandle, uint8_t Interval);
 
 /************************************************************************/
 /* Transfer API                                                                     */
@@ -163,6 +186,20 @@ HCD_STATUS HcdClearEndpointHalt(uint32_t PipeHandle);
 HCD_STATUS HcdControlTransfer(uint32_t PipeHandle, const USB_Request_Header_t* const pDeviceRequest, uint8_t* const buffer);
 HCD_STATUS HcdDataTransfer(uint32_t PipeHandle, uint8_t* const buffer, uint32_t const length, uint16_t* const pActualTransferred);
 HCD_STATUS HcdGetPipeStatus(uint32_t PipeHandle);
+/* Completion callbacks, used by the pipe streams of Pipe_LPC.c, are only implemented by the OHCI driver:
+ * with EHCI, HcdSetTransferCallback() reports HCD_STATUS_TRANSFER_TYPE_NOT_SUPPORTED for any Callback but NULL */
+HCD_STATUS HcdSetTransferCallback(uint32_t PipeHandle, HCD_TRANSFER_CALLBACK Callback);
+/* Per packet isochronous transfers and their callbacks are OHCI only as well: with EHCI both report
+ * HCD_STATUS_TRANSFER_TYPE_NOT_SUPPORTED (but for a NULL Callback), isochronous pipes use HcdDataTransfer() there */
+HCD_STATUS HcdIsoTransfer(uint32_t PipeHandle, uint8_t* const buffer, const uint16_t* const PacketLength, uint8_t const PacketCount);
+HCD_STATUS HcdSetIsoCallback(uint32_t PipeHandle, HCD_ISO_CALLBACK Callback);
+
+/************************************************************************/
+/* Delay API                                                                     */
+/************************************************************************/
+void  HcdDelayUS (uint32_t  delay);
+void  HcdDelayMS (uint32_t  delay);
+void  HcdYield (void);
 
 #ifdef LPCUSBlib_DEBUG
 	#define hcd_printf			printf
@@ -186,8 +223,6 @@ HCD_STATUS HcdGetPipeStatus(uint32_t PipeHandle);
 
 #if defined(__LPC_OHCI_C__) || defined(__LPC_EHCI_C__)
 
-void  HcdDelayUS (uint32_t  delay); // TODO use unify delay
-void  HcdDelayMS (uint32_t  delay);
 HCD_STATUS OpenPipe_VerifyParameters( uint8_t HostID, uint8_t DeviceAddr, HCD_USB_SPEED DeviceSpeed, uint8_t EndpointNumber, HCD_TRANSFER_TYPE TransferType, HCD_TRANSFER_DIR TransferDir, uint16_t MaxPacketSize, uint8_t Interval, uint8_t Mult );
 
 static __INLINE uint32_t Align32 (uint32_t Value)
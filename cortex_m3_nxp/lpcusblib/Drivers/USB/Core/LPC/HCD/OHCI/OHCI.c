@@ -179,8 +179,7 @@ HCD_STATUS HcdOpenPipe(uint8_t HostID,
 		break;
 
 		case INTERRUPT_TRANSFER:
-			//ListIdx = FindInterruptTransferListIndex(Interval);
-			ListIdx = INTERRUPT_1ms_LIST_HEAD;
+			ListIdx = INTERRUPT_1ms_LIST_HEAD; /* real list is picked below, once the ED bandwidth is known */
 		break;
 
 		case ISOCHRONOUS_TRANSFER:
@@ -190,6 +189,16 @@ HCD_STATUS HcdOpenPipe(uint8_t HostID,
 
 	ASSERT_STATUS_OK ( AllocEd(DeviceAddr, DeviceSpeed, EndpointNumber, TransferType, TransferDir, MaxPacketSize, Interval, &EdIdx) ) ;
 
+	if (TransferType == INTERRUPT_TRANSFER)
+	{
+		ListIdx = FindInterruptTransferListIndex(HostID, Interval, InterruptEndpointBandwidth(EdIdx));
+		if (ListIdx == INTERRUPT_LIST_NONE)
+		{
+			FreeED(EdIdx);
+			ASSERT_STATUS_OK_MESSAGE(HCD_STATUS_NOT_ENOUGH_BANDWIDTH, "Periodic schedule is full");
+		}
+	}
+
 	/* Add new ED to the EDs List */
 	HcdED(EdIdx)->ListIndex  = ListIdx;
 	InsertEndpoint(HostID, EdIdx, ListIdx);
@@ -213,10 +222,7 @@ HCD_STATUS HcdCancelTransfer(uint32_t PipeHandle)
 	ASSERT_STATUS_OK ( PipehandleParse(PipeHandle, &HostID, &EdIdx) );
 
 	HcdED(EdIdx)->hcED.Skip = 1;
-
-	/* Clear SOF and wait for the next frame */
-	OHCI_REG(HostID)->HcInterruptStatus = HC_INTERRUPT_StartofFrame;
-	while( !(OHCI_REG(HostID)->HcInterruptStatus & HC_INTERRUPT_StartofFrame) ) /* TODO Should have timeout */
+	WaitForNextFrame(HostID);
 
 	/* ISO TD & General TD have the same offset for nextTD, we can use GTD as pointer to travel on TD list */
 	while ( Align16( HcdED(EdIdx)->hcED.HeadP.HeadTD ) != Align16( HcdED(EdIdx)->hcED.TailP ) )
@@ -256,8 +262,9 @@ HCD_STATUS HcdClosePipe(uint32_t PipeHandle)
 
 	ASSERT_STATUS_OK ( HcdCancelTransfer(PipeHandle) );
 
-	HcdED(EdIdx)->hcED.Skip = 1; /* no need for delay, it is already delayed in cancel transfer */
+	HcdED(EdIdx)->hcED.Skip = 1;
 	RemoveEndpoint(HostID, EdIdx);
+	WaitForNextFrame(HostID);	/* the HC may hold the ED until the frame ends, it must not be reused before */
 
 	FreeED(EdIdx);
 
@@ -276,6 +283,54 @@ HCD_STATUS HcdClearEndpointHalt(uint32_t PipeHandle)
 	return HCD_STATUS_OK;
 }
 
+/*********************************************************************//**
+ * @brief		Change the polling interval of an opened pipe
+ * @param[in]	PipeHandle	Handler of target pipe
+ * @param[in]	Interval	New polling interval in frames (1-255)
+ * @return 		HCD_STATUS
+ *				- HCD_STATUS_OK	: function performs successfully
+ *				- HCD_STATUS_NOT_ENOUGH_BANDWIDTH : no periodic list can take the endpoint, previous interval is kept
+ *				- Others		: Error occurs
+ * Note: Interrupt EDs are moved to the periodic tree list matching the new interval.
+ *		 Queued TDs stay attached to the ED while it is moved.
+ **********************************************************************/
+HCD_STATUS HcdSetPipeInterval(uint32_t PipeHandle, uint8_t Interval)
+{
+	uint8_t HostID, EdIdx;
+	uint8_t ListIdx;
+
+	ASSERT_STATUS_OK ( PipehandleParse(PipeHandle, &HostID, &EdIdx) );
+
+	if (Interval == 0)
+	{
+		ASSERT_STATUS_OK_MESSAGE(HCD_STATUS_PARAMETER_INVALID, "Interval must be in range 1-255");
+	}
+
+	if ( !IsInterruptEndpoint(EdIdx) ) /* ISO reads Interval when queuing, Control/Bulk are not periodic */
+	{
+		HcdED(EdIdx)->Interval = Interval;
+		return HCD_STATUS_OK;
+	}
+
+	/* The HC may still be on the ED for the rest of the frame: its NextED is only rewritten once the next SOF
+	 * shows the HC has let go of it (OHCI 5.2.7.1) */
+	HcdED(EdIdx)->hcED.Skip = 1;
+	RemoveEndpoint(HostID, EdIdx);
+	WaitForNextFrame(HostID);
+
+	ListIdx = FindInterruptTransferListIndex(HostID, Interval, InterruptEndpointBandwidth(EdIdx));
+	if (ListIdx != INTERRUPT_LIST_NONE)
+	{
+		HcdED(EdIdx)->Interval  = Interval;
+		HcdED(EdIdx)->ListIndex = ListIdx;
+	}
+	InsertEndpoint(HostID, EdIdx, HcdED(EdIdx)->ListIndex);
+
+	HcdED(EdIdx)->hcED.Skip = 0;
+
+	return (ListIdx != INTERRUPT_LIST_NONE) ? HCD_STATUS_OK : HCD_STATUS_NOT_ENOUGH_BANDWIDTH;
+}
+
 /*********************************************************************//**
  * @brief		Issue Transfer on the control pipe
  * @param[in]	PipeHandle		Handler of target pipe
@@ -299,6 +354,9 @@ HCD_STATUS HcdControlTransfer(uint32_t PipeHandle, const USB_Request_Header_t* c
 
 	ASSERT_STATUS_OK ( PipehandleParse(PipeHandle, &HostID, &EdIdx) );
 
+	/* Mark the transfer queued before the HC can see it, the ISR may complete it before CLF is even set */
+	HcdED(EdIdx)->status = HCD_STATUS_TRANSFER_QUEUED;
+
 	/************************************************************************/
 	/* Setup Stage                                                          */
 	/************************************************************************/
@@ -319,34 +377,44 @@ HCD_STATUS HcdControlTransfer(uint32_t PipeHandle, const USB_Request_Header_t* c
 	/* set control list filled */
 	OHCI_REG(HostID)->HcCommandStatus |= HC_COMMAND_STATUS_ControlListFilled;
 
-	HcdED(EdIdx)->status = HCD_STATUS_TRANSFER_QUEUED;
-
 	/* wait for semaphore compete TDs */
 	ASSERT_STATUS_OK ( WaitForTransferComplete(EdIdx) );
 
 	return HCD_STATUS_OK;
 }
 
-static HCD_STATUS QueueOneITD(uint32_t EdIdx, uint8_t* dataBuff, uint32_t TDLen, uint16_t StartingFrame)
+static void FillItd(PHCD_IsoTransferDescriptor pItd, uint8_t* dataBuff, const uint16_t* PacketLength, uint8_t PacketCount, uint16_t StartingFrame)
 {
 	uint32_t i;
-	PHCD_IsoTransferDescriptor pItd = (PHCD_IsoTransferDescriptor) Align16( HcdED(EdIdx)->hcED.TailP );
-	
+	uint32_t TDLen = 0;
+
+	for (i = 0; i < PacketCount; i++)
+	{
+		TDLen += PacketLength[i];
+	}
+
 	pItd->StartingFrame = StartingFrame;
-	pItd->FrameCount = (TDLen / HcdED(EdIdx)->hcED.MaxPackageSize) + (TDLen % HcdED(EdIdx)->hcED.MaxPackageSize ? 1 : 0) - 1;
+	pItd->FrameCount = PacketCount - 1;
 	pItd->BufferPage0 = Align4k( (uint32_t) dataBuff );
 	pItd->BufferEnd = (uint32_t) (dataBuff + TDLen - 1);
+	pItd->BufferStart = dataBuff;
 
-	for (i=0; TDLen>0 && i < 8; i++)
+	for (i = 0; i < PacketCount; i++)
 	{
-		uint32_t XactLen = MIN(TDLen, HcdED(EdIdx)->hcED.MaxPackageSize);
+		/*-- 15-12: ConditionCode (not accessed, bit 12 selects the page of BufferEnd), 11-0: offset --*/
+		pItd->OffsetPSW[i] = (HCD_STATUS_TRANSFER_NotAccessed << 12) | (Align4k((uint32_t)dataBuff) != pItd->BufferPage0 ? (1 <<12) : 0) |
+							Offset4k((uint32_t)dataBuff);
+		pItd->PacketLength[i] = PacketLength[i];
 
-		pItd->OffsetPSW[i] = (HCD_STATUS_TRANSFER_NotAccessed << 12) | (Align4k((uint32_t)dataBuff) != Align4k(pItd->BufferPage0) ? (1 <<12) : 0) |
-							Offset4k((uint32_t)dataBuff); /*-- FIXME take into cross page account later 15-12: ConditionCode, 11-0: offset --*/
-		
-		TDLen -= XactLen;
-		dataBuff += XactLen;
+		dataBuff += PacketLength[i];
 	}
+}
+
+static HCD_STATUS QueueOneITD(uint8_t HostID, uint32_t EdIdx, uint8_t* dataBuff, const uint16_t* PacketLength, uint8_t PacketCount)
+{
+	PHCD_IsoTransferDescriptor pItd = (PHCD_IsoTransferDescriptor) Align16( HcdED(EdIdx)->hcED.TailP );
+
+	FillItd(pItd, dataBuff, PacketLength, PacketCount, IsoReserveFrames(HostID, EdIdx, PacketCount));
 
 	/* Create a new place holder TD & link setup TD to the new place holder */
 	ASSERT_STATUS_OK ( AllocItdForEd(EdIdx) );
@@ -354,43 +422,27 @@ static HCD_STATUS QueueOneITD(uint32_t EdIdx, uint8_t* dataBuff, uint32_t TDLen,
 	return HCD_STATUS_OK;
 }
 
-static HCD_STATUS QueueITDs(uint32_t EdIdx, uint8_t* dataBuff, uint32_t xferLen)
+static HCD_STATUS QueueITDs(uint8_t HostID, uint32_t EdIdx, uint8_t* dataBuff, uint32_t xferLen)
 {
-	uint32_t FrameIdx;
-	uint32_t MaxDataSize;
-
-#if 0 /* Maximum bandwidth (Interval = 1) regardless of Interval value */
-	uint8_t MaxXactPerITD, FramePeriod;
-	if (HcdED(EdIdx)->Interval < 4) /*-- Period < 8 --*/
-	{
-		MaxXactPerITD = 1 << ( 4 - HcdED(EdIdx)->Interval ) ;	/*-- Interval 1 => 8, 2 => 4, 3 => 2 --*/
-		FramePeriod = 1;
-	}else
-	{
-		MaxXactPerITD = 1;
-		FramePeriod = 1 << ( HcdED(EdIdx)->Interval - 4 );	/*-- Frame step 4 => 1, 5 => 2, 6 => 3 --*/
-	}
-#else
-	#define MaxXactPerITD	8
-	#define FramePeriod		1
-#endif
-
-	MaxDataSize = MaxXactPerITD * HcdED(EdIdx)->hcED.MaxPackageSize;
-	FrameIdx = HcdGetFrameNumber(0)+1;	/* FIXME dual controller */
+	uint16_t PacketLength[HCD_ISO_MAX_PACKETS];
+	uint32_t MaxPackets = (HcdED(EdIdx)->Interval > 1) ? 1 : HCD_ISO_MAX_PACKETS;	/* packets of an ITD go to consecutive frames */
 
 	while (xferLen > 0)
 	{
-		uint16_t TdLen;
-		uint32_t MaxTDLen = TD_MAX_XFER_LENGTH - Offset4k((uint32_t)dataBuff);
-		MaxTDLen = MIN(MaxDataSize, MaxTDLen);
+		uint32_t TdLen = 0;
+		uint32_t MaxTDLen = TD_MAX_XFER_LENGTH - Offset4k((uint32_t)dataBuff);	/* an ITD spans at most two pages */
+		uint8_t PacketCount;
 
-		TdLen = MIN(xferLen, MaxTDLen);
-		xferLen -= TdLen;
+		for (PacketCount = 0; (PacketCount < MaxPackets) && (xferLen > 0) && (TdLen < MaxTDLen); PacketCount++)
+		{
+			PacketLength[PacketCount] = MIN( MIN(xferLen, HcdED(EdIdx)->hcED.MaxPackageSize), MaxTDLen - TdLen );
+			TdLen += PacketLength[PacketCount];
+			xferLen -= PacketLength[PacketCount];
+		}
 
 		/*---------- Fill data to Place hodler TD ----------*/
-		ASSERT_STATUS_OK ( QueueOneITD(EdIdx, dataBuff, TdLen, FrameIdx) );
-		
-		FrameIdx = (FrameIdx + FramePeriod) % (1<<16);
+		ASSERT_STATUS_OK ( QueueOneITD(HostID, EdIdx, dataBuff, PacketLength, PacketCount) );
+
 		dataBuff += TdLen;
 	}
 	return HCD_STATUS_OK;
@@ -411,9 +463,13 @@ HCD_STATUS HcdDataTransfer( uint32_t PipeHandle, uint8_t* const buffer, uint32_t
 
 	ExpectedLength = (length != HCD_ENDPOINT_MAXPACKET_XFER_LEN) ? length : HcdED(EdIdx)->hcED.MaxPackageSize; /* LUFA adaption, receive only 1 data transaction */
 
+	/* Set up completion state before queuing, the done queue may be processed before this function returns */
+	HcdED(EdIdx)->status = HCD_STATUS_TRANSFER_QUEUED;
+	HcdED(EdIdx)->pActualTransferCount = pActualTransferred ; /* TODO refractor Actual length transfer */
+
 	if ( IsIsoEndpoint(EdIdx) ) /* Iso Transfer */
 	{
-		ASSERT_STATUS_OK( QueueITDs(EdIdx, buffer, ExpectedLength) );
+		ASSERT_STATUS_OK( QueueITDs(HostID, EdIdx, buffer, ExpectedLength) );
 	}else
 	{
 		ASSERT_STATUS_OK( QueueGTDs(EdIdx, buffer, ExpectedLength, 0) );
@@ -423,9 +479,6 @@ HCD_STATUS HcdDataTransfer( uint32_t PipeHandle, uint8_t* const buffer, uint32_t
 		}
 	}
 
-	HcdED(EdIdx)->status = HCD_STATUS_TRANSFER_QUEUED;
-	HcdED(EdIdx)->pActualTransferCount = pActualTransferred ; /* TODO refractor Actual length transfer */
-
 	return HCD_STATUS_OK;
 }
 
@@ -437,6 +490,114 @@ HCD_STATUS HcdGetPipeStatus(uint32_t PipeHandle)
 
 	return HcdED(EdIdx)->status;
 }
+
+/*********************************************************************//**
+ * @brief		Set the function called from the USB interrupt when a transfer
+ *				on the pipe completes
+ * @param[in]	PipeHandle	Handler of target pipe, a bulk or interrupt pipe
+ * @param[in]	Callback	Completion callback, NULL to go back to polling
+ * @return 		HCD_STATUS
+ *				- HCD_STATUS_OK : function performs successfully
+ *				- Others		: Error occurs
+ * Note: a callback returning true re-queues the finished TD on the same
+ * buffer without allocating, so it must only be used with transfers that
+ * fit one TD (at most 4 KB, as any single packet HCD_ENDPOINT_MAXPACKET_XFER_LEN
+ * transfer does). The buffer is only valid until the callback returns.
+ **********************************************************************/
+HCD_STATUS HcdSetTransferCallback(uint32_t PipeHandle, HCD_TRANSFER_CALLBACK Callback)
+{
+	uint8_t HostID, EdIdx;
+
+	ASSERT_STATUS_OK ( PipehandleParse(PipeHandle, &HostID, &EdIdx) );
+
+	if ( IsIsoEndpoint(EdIdx) || (HcdED(EdIdx)->ListIndex == CONTROL_LIST_HEAD) )
+	{
+		ASSERT_STATUS_OK_MESSAGE(HCD_STATUS_TRANSFER_TYPE_NOT_SUPPORTED, "Transfer callbacks are for bulk and interrupt pipes");
+	}
+
+	HcdED(EdIdx)->Callback = Callback;
+
+	return HCD_STATUS_OK;
+}
+
+/*********************************************************************//**
+ * @brief		Queue one isochronous transfer with a given packet layout
+ * @param[in]	PipeHandle		Handler of target pipe, an isochronous pipe
+ * @param[in]	buffer			Data buffer, the packets follow each other in it
+ * @param[in]	PacketLength	Length of each packet, 1 up to the pipe max packet size
+ * @param[in]	PacketCount		Number of packets, 1-HCD_ISO_MAX_PACKETS (1 when the pipe period is above one frame)
+ * @return 		HCD_STATUS
+ *				- HCD_STATUS_OK : transfer is queued
+ *				- Others		: Error occurs
+ * Note: the transfer starts right after the ones already queued on the pipe, or
+ * in the next frame when the pipe is idle or its schedule has fallen behind.
+ **********************************************************************/
+HCD_STATUS HcdIsoTransfer(uint32_t PipeHandle, uint8_t* const buffer, const uint16_t* const PacketLength, uint8_t const PacketCount)
+{
+	uint8_t HostID, EdIdx;
+	uint32_t TDLen = 0;
+	uint32_t i;
+
+	ASSERT_STATUS_OK ( PipehandleParse(PipeHandle, &HostID, &EdIdx) );
+
+	if ( !IsIsoEndpoint(EdIdx) )
+	{
+		ASSERT_STATUS_OK_MESSAGE(HCD_STATUS_TRANSFER_TYPE_NOT_SUPPORTED, "Not an isochronous pipe");
+	}
+
+	if ( buffer == NULL || PacketCount == 0 || PacketCount > HCD_ISO_MAX_PACKETS ||
+		 (PacketCount > 1 && HcdED(EdIdx)->Interval > 1) )
+	{
+		ASSERT_STATUS_OK_MESSAGE(HCD_STATUS_PARAMETER_INVALID, "Invalid isochronous packet count");
+	}
+
+	for (i = 0; i < PacketCount; i++)
+	{
+		if ( PacketLength[i] == 0 || PacketLength[i] > HcdED(EdIdx)->hcED.MaxPackageSize )
+		{
+			ASSERT_STATUS_OK_MESSAGE(HCD_STATUS_PARAMETER_INVALID, "Invalid isochronous packet length");
+		}
+		TDLen += PacketLength[i];
+	}
+
+	if ( Align4k( (uint32_t) buffer + TDLen - 1 ) - Align4k( (uint32_t) buffer ) > 0x1000 )
+	{
+		ASSERT_STATUS_OK_MESSAGE(HCD_STATUS_PARAMETER_INVALID, "Isochronous buffer spans more than two pages");
+	}
+
+	HcdED(EdIdx)->status = HCD_STATUS_TRANSFER_QUEUED;
+
+	return QueueOneITD(HostID, EdIdx, buffer, PacketLength, PacketCount);
+}
+
+/*********************************************************************//**
+ * @brief		Set the function called from the USB interrupt when an
+ *				isochronous transfer on the pipe completes
+ * @param[in]	PipeHandle	Handler of target pipe, an isochronous pipe
+ * @param[in]	Callback	Completion callback, NULL to let transfers retire
+ * @return 		HCD_STATUS
+ *				- HCD_STATUS_OK : function performs successfully
+ *				- Others		: Error occurs
+ * Note: a callback returning true re-queues the finished ITD on the same
+ * buffer without allocating, with the packet lengths it left in PacketLength.
+ * Transfers are queued again whatever their status, a packet lost on the bus
+ * does not stop the stream.
+ **********************************************************************/
+HCD_STATUS HcdSetIsoCallback(uint32_t PipeHandle, HCD_ISO_CALLBACK Callback)
+{
+	uint8_t HostID, EdIdx;
+
+	ASSERT_STATUS_OK ( PipehandleParse(PipeHandle, &HostID, &EdIdx) );
+
+	if ( !IsIsoEndpoint(EdIdx) )
+	{
+		ASSERT_STATUS_OK_MESSAGE(HCD_STATUS_TRANSFER_TYPE_NOT_SUPPORTED, "Not an isochronous pipe");
+	}
+
+	HcdED(EdIdx)->IsoCallback = Callback;
+
+	return HCD_STATUS_OK;
+}
 /*=======================================================================*/
 /* OHCD INTERRUPT HANDLERS                     */
 /*=======================================================================*/
@@ -483,8 +644,8 @@ static void ProcessDoneQueue(uint8_t HostID, uint32_t donehead)
 	/* reverse done queue order */	
 	do 
 	{
-		uint32_t nextTD = pCurTD->NextTD;
-		pCurTD->NextTD = (uint32_t) pTDList;
+		uint32_t nextTD = *DoneQueueLink(pCurTD);
+		*DoneQueueLink(pCurTD) = (uint32_t) pTDList;
 		pTDList = pCurTD;
 		pCurTD = (PHC_GTD) nextTD;
 	} while (pCurTD);
@@ -494,10 +655,10 @@ static void ProcessDoneQueue(uint8_t HostID, uint32_t donehead)
 		uint32_t EdIdx;
 
 		pCurTD	= pTDList;
-		pTDList = (PHC_GTD) pTDList->NextTD;
+		pTDList = (PHC_GTD) *DoneQueueLink(pTDList);
 
 		/* TODO Cannot determine EdIdx because GTD and ITD have different offsets for EdIdx  */
-		if ( ((uint32_t) pCurTD) <=  ((uint32_t) HcdITD(MAX_ITD-1)) )	/* ISO TD address range */
+		if ( IsIsoTd(pCurTD) )
 		{
 			PHCD_IsoTransferDescriptor pItd = (PHCD_IsoTransferDescriptor) pCurTD;
 			EdIdx = pItd->EdIdx;
@@ -530,6 +691,37 @@ static void ProcessDoneQueue(uint8_t HostID, uint32_t donehead)
 					pCurTD->ConditionCode);
 		}
 
+		/* Hand the finished transfer to the pipe's callback, streaming pipes get the TD queued again */
+		if ( HcdED(EdIdx)->IsoCallback && IsIsoEndpoint(EdIdx) )
+		{
+			PHCD_IsoTransferDescriptor pItd = (PHCD_IsoTransferDescriptor) pCurTD;
+			uint16_t PacketLength[HCD_ISO_MAX_PACKETS];
+			uint8_t PacketCount = pItd->FrameCount + 1;
+			HCD_STATUS Status = IsoPacketLengths(EdIdx, pItd, PacketLength);
+			uint32_t PipeHandle;
+
+			PipehandleCreate(&PipeHandle, HostID, EdIdx);
+			if ( HcdED(EdIdx)->IsoCallback(PipeHandle, Status, pItd->BufferStart, PacketLength, PacketCount) )
+			{
+				RequeueItd(HostID, EdIdx, pItd, PacketLength, PacketCount);
+				continue;
+			}
+		}
+		else if ( HcdED(EdIdx)->Callback && !IsIsoEndpoint(EdIdx) &&
+			 ((pCurTD->DelayInterrupt != TD_NoInterruptOnComplete) || pCurTD->ConditionCode) )
+		{
+			PHCD_GeneralTransferDescriptor pGtd = (PHCD_GeneralTransferDescriptor) pCurTD;
+			uint32_t PipeHandle;
+
+			PipehandleCreate(&PipeHandle, HostID, EdIdx);
+			if ( HcdED(EdIdx)->Callback(PipeHandle, (HCD_STATUS) HcdED(EdIdx)->status, pGtd->BufferStart, pGtd->TransferCount) &&
+				 (HcdED(EdIdx)->status == HCD_STATUS_OK) )
+			{
+				RequeueGtd(HostID, EdIdx, pGtd);
+				continue;
+			}
+		}
+
 		/* remove completed TD from usb request list, if request list is now empty complete usb request */
 		if (IsIsoEndpoint(EdIdx))
 		{
@@ -699,7 +891,8 @@ static HCD_STATUS QueueOneGTD (uint32_t EdIdx, uint8_t* const CurrentBufferPoint
 	TailP->hcGTD.DataToggle = DataToggle;
 	TailP->hcGTD.CurrentBufferPointer = CurrentBufferPointer;
 	TailP->hcGTD.BufferEnd = (xferLen) ? (CurrentBufferPointer+xferLen-1) : NULL;
-	TailP->TransferCount = xferLen;
+	TailP->BufferStart = CurrentBufferPointer;
+	TailP->TransferCount = TailP->QueuedLength = xferLen;
 	if (!IOC)
 	{
 		TailP->hcGTD.DelayInterrupt = TD_NoInterruptOnComplete; /* Delay Interrupt with  */
@@ -738,6 +931,22 @@ static HCD_STATUS WaitForTransferComplete( uint8_t EdIdx )
 #endif
 }
 
+/* Waits for the next SOF, after which the HC holds no ED that was unlinked or skipped before it.
+ * An HC that is not operational runs no frames and holds no ED. */
+static void WaitForNextFrame( uint8_t HostID )
+{
+	if ( ((OHCI_REG(HostID)->HcControl & HC_CONTROL_HostControllerFunctionalState) >> 6) != HC_HOST_OPERATIONAL )
+	{
+		return;
+	}
+
+	/* Clear SOF and wait for the next frame */
+	OHCI_REG(HostID)->HcInterruptStatus = HC_INTERRUPT_StartofFrame;
+	while ( !(OHCI_REG(HostID)->HcInterruptStatus & HC_INTERRUPT_StartofFrame) )
+	{
+	}
+}
+
 static __INLINE HCD_STATUS InsertEndpoint( uint8_t HostID, uint32_t EdIdx, uint8_t ListIndex )
 {
 	PHC_ED list_head;
@@ -746,10 +955,10 @@ static __INLINE HCD_STATUS InsertEndpoint( uint8_t HostID, uint32_t EdIdx, uint8
 	HcdED(EdIdx)->hcED.NextED = list_head->NextED;	
 	list_head->NextED = (uint32_t) HcdED(EdIdx);
 
-// 	if ( IsInterruptEndpoint(EdIdx) )
-// 	{
-// 		OHCI_HOST_DATA->staticEDs[ListIndex].TailP += HcdED(EdIdx)->hcED.MaxPackageSize;	/* increase the bandwidth for the found list */
-// 	}
+	if ( IsInterruptEndpoint(EdIdx) )
+	{
+		list_head->TailP += InterruptEndpointBandwidth(EdIdx);	/* increase the bandwidth for the found list */
+	}
 
 	return HCD_STATUS_OK;
 }
@@ -765,18 +974,51 @@ static __INLINE HCD_STATUS RemoveEndpoint( uint8_t HostID, uint32_t EdIdx )
 		prevED = (PHCD_EndpointDescriptor) (prevED->hcED.NextED) ;
 	}
 
-// 	if ( IsInterruptEndpoint(EdIdx) )
-// 	{
-// 		OHCI_HOST_DATA->staticEDs[HcdED(EdIdx)->ListIndex].TailP -= HcdED(EdIdx)->hcED.MaxPackageSize;	/* decrease the bandwidth for the removed list */
-// 	}
+	if ( IsInterruptEndpoint(EdIdx) )
+	{
+		ohci_data[HostID].staticEDs[HcdED(EdIdx)->ListIndex].TailP -= InterruptEndpointBandwidth(EdIdx);	/* decrease the bandwidth for the removed list */
+	}
 	prevED->hcED.NextED = HcdED(EdIdx)->hcED.NextED;
 
 	return HCD_STATUS_OK;
 }
 
-#if 0	/* We dont need to manage bandwidth this hard */
+#if INTERRUPT_LIST_ENABLE
+
+/* 32ms lists are spread over the 16ms lists in bit-reversed order so that every level stays evenly balanced */
+static const uint8_t InterruptTreeBalance[16] = {0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF};
+
+/* List that a static interrupt ED is chained to, i.e. the one with half its period */
+static __INLINE uint8_t InterruptListParent( uint8_t ListIdx )
+{
+	if (ListIdx >= INTERRUPT_32ms_LIST_HEAD)
+	{
+		return InterruptTreeBalance[(ListIdx - INTERRUPT_32ms_LIST_HEAD) & 0xF] + INTERRUPT_16ms_LIST_HEAD;
+	}
+	return (ListIdx - 1) / 2;
+}
+
+/* Bus time taken by one transaction of an interrupt ED, in full speed byte times */
+static __INLINE uint32_t InterruptEndpointBandwidth( uint8_t EdIdx )
+{
+	uint32_t Bandwidth = HcdED(EdIdx)->hcED.MaxPackageSize + INTERRUPT_PROTOCOL_OVERHEAD;
+	return HcdED(EdIdx)->hcED.Speed ? (Bandwidth * LOW_SPEED_BANDWIDTH_FACTOR) : Bandwidth;
+}
 
-__INLINE uint8_t FindInterruptTransferListIndex( uint8_t HostID, uint8_t Interval )
+/* Worst frame load seen by a list: the list itself plus every list it is chained to down to the 1ms head */
+static __INLINE uint32_t InterruptListBandwidth( uint8_t HostID, uint8_t ListIdx )
+{
+	uint32_t Bandwidth = ohci_data[HostID].staticEDs[ListIdx].TailP;
+
+	while (ListIdx != INTERRUPT_1ms_LIST_HEAD)
+	{
+		ListIdx = InterruptListParent(ListIdx);
+		Bandwidth += ohci_data[HostID].staticEDs[ListIdx].TailP;
+	}
+	return Bandwidth;
+}
+
+static __INLINE uint8_t FindInterruptTransferListIndex( uint8_t HostID, uint8_t Interval, uint32_t Bandwidth )
 {
 	uint8_t ListLeastBandwidth;
 	uint8_t ListEnd;
@@ -790,56 +1032,73 @@ __INLINE uint8_t FindInterruptTransferListIndex( uint8_t HostID, uint8_t Interva
 	/* Note: For Interrupt Static ED (0 to 62), TailP is used to store the accumulated bandwidth of the list */
 	for (ListLeastBandwidth=ListIdx; ListIdx <= ListEnd; ListIdx++ )
 	{
-		if ( ohci_data[HostID].staticEDs[ListIdx].TailP < ohci_data[HostID].staticEDs[ListLeastBandwidth].TailP )
+		if ( InterruptListBandwidth(HostID, ListIdx) < InterruptListBandwidth(HostID, ListLeastBandwidth) )
 		{
 			ListLeastBandwidth = ListIdx;
 		}
 	}
+
+	/* The most loaded frame is behind the deepest list, check the new endpoint still fits in it */
+	for (ListIdx = INTERRUPT_32ms_LIST_HEAD; ListIdx < INTERRUPT_32ms_LIST_HEAD + 32; ListIdx++)
+	{
+		uint8_t Node = ListIdx;
+
+		while (Node > ListLeastBandwidth)
+		{
+			Node = InterruptListParent(Node);
+		}
+		if ( (Node == ListLeastBandwidth) &&
+			 (InterruptListBandwidth(HostID, ListIdx) + Bandwidth > PERIODIC_BANDWIDTH_MAX) )
+		{
+			return INTERRUPT_LIST_NONE;
+		}
+	}
+
 	return ListLeastBandwidth;
 }
 
 /* build static EDs tree for periodic transfer */
 static __INLINE void BuildPeriodicStaticEdTree( uint8_t HostID )
 {
-#if INTERRUPT_LIST_ENABLE
 	/* Build full binary tree for interrupt list */
-	uint32_t idx, count;
-	uint32_t Balance[16] = {0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF};
+	uint32_t idx;
 
 	/* build static tree for 1 -> 16 ms */
-	OHCI_HOST_DATA->staticEDs[0].NextED = 0;
 	for (idx=1; idx < INTERRUPT_32ms_LIST_HEAD; idx++)
 	{
-		OHCI_HOST_DATA->staticEDs[idx].NextED = (uint32_t) &(OHCI_HOST_DATA->staticEDs[(idx-1)/2]);
+		ohci_data[HostID].staticEDs[idx].NextED = (uint32_t) &(ohci_data[HostID].staticEDs[ InterruptListParent(idx) ]);
 	}
 	/* create 32ms EDs which will be assigned to HccaInterruptTable */
-	for (count=0, idx=INTERRUPT_32ms_LIST_HEAD; count < 32; count++, idx++)
+	for (idx=INTERRUPT_32ms_LIST_HEAD; idx < INTERRUPT_32ms_LIST_HEAD + 32; idx++)
 	{
-		OHCI_HOST_DATA->staticEDs[idx].NextED = (uint32_t) &(OHCI_HOST_DATA->staticEDs[ Balance[count & 0xF] + INTERRUPT_16ms_LIST_HEAD ]);
+		ohci_data[HostID].staticEDs[idx].NextED = (uint32_t) &(ohci_data[HostID].staticEDs[ InterruptListParent(idx) ]);
 	}
 	/* Hook to HCCA interrupt Table */
 	for (idx = 0; idx < 32; idx++)
 	{
-		OHCI_HOST_DATA->hcca.HccaIntTable[idx] = (uint32_t) &(OHCI_HOST_DATA->staticEDs[idx+INTERRUPT_32ms_LIST_HEAD]) ;
+		ohci_data[HostID].hcca.HccaIntTable[idx] = (uint32_t) &(ohci_data[HostID].staticEDs[idx+INTERRUPT_32ms_LIST_HEAD]) ;
 	}
-	OHCI_HOST_DATA->staticEDs[INTERRUPT_1ms_LIST_HEAD].NextED = (uint32_t) &(OHCI_HOST_DATA->staticEDs[ISO_LIST_HEAD]);
-#elif ISO_LIST_ENABLE
-	for (idx = 0; idx < 32; idx++)
-	{
-		OHCI_HOST_DATA->hcca.HccaIntTable[idx] = (uint32_t) &(OHCI_HOST_DATA->staticEDs[ISO_LIST_HEAD]) ;
-	}
-#endif
+	ohci_data[HostID].staticEDs[INTERRUPT_1ms_LIST_HEAD].NextED = (uint32_t) &(ohci_data[HostID].staticEDs[ISO_LIST_HEAD]);
 }
 
 #else
 
+static __INLINE uint32_t InterruptEndpointBandwidth( uint8_t EdIdx )
+{
+	return 0;
+}
+
+static __INLINE uint8_t FindInterruptTransferListIndex( uint8_t HostID, uint8_t Interval, uint32_t Bandwidth )
+{
+	return INTERRUPT_1ms_LIST_HEAD;
+}
+
 static __INLINE void BuildPeriodicStaticEdTree( uint8_t HostID )
 {
-	/* Treat all interrupt interval as 1ms (maximum rate) */
 	uint32_t idx;
 	for (idx = 0; idx < 32; idx++)
 	{
-		ohci_data[HostID].hcca.HccaIntTable[idx] = (uint32_t) &(ohci_data[HostID].staticEDs[INTERRUPT_1ms_LIST_HEAD]) ;
+		ohci_data[HostID].hcca.HccaIntTable[idx] = (uint32_t) &(ohci_data[HostID].staticEDs[ISO_LIST_HEAD]) ;
 	}
 	/* ISO_LIST_HEAD is an alias for INTERRUPT_1ms_LIST_HEAD */
 }
@@ -870,6 +1129,18 @@ static __INLINE PHCD_IsoTransferDescriptor HcdITD(uint8_t idx)
 #endif
 }
 
+/* ITDs sit below the GTDs in ohci_data */
+static __INLINE bool IsIsoTd(PHC_GTD pTd)
+{
+	return ((uint32_t) pTd) <= ((uint32_t) HcdITD(MAX_ITD-1));
+}
+
+/* Done queue link of a retired TD, read through the TD's own type: only the 32-bit layouts share its offset */
+static __INLINE __IO uint32_t* DoneQueueLink(PHC_GTD pTd)
+{
+	return IsIsoTd(pTd) ? &((PHCD_IsoTransferDescriptor) pTd)->NextTD : &pTd->NextTD;
+}
+
 static __INLINE bool IsIsoEndpoint( uint8_t EdIdx )
 {
 	return HcdED(EdIdx)->hcED.Format ;
@@ -938,31 +1209,7 @@ static HCD_STATUS AllocGtdForEd(uint8_t EdIdx)
 
 	if (GtdIdx < MAX_GTD)
 	{
-		/***************    Control (word 0) ****************/
-		/* Buffer rounding:    R = 1b (yes)                 */
-		/* Direction/PID:      DP = 00b (SETUP)             */
-		/* Delay Interrupt:    DI = 000b (interrupt)		*/
-		/* Data Toggle:        DT = 00b (from ED)		    */
-		/* Error Count:        EC = 00b                     */
-		/* Condition Code:     CC = 1110b (not accessed)    */
-		/****************************************************/
-		memset(HcdGTD(GtdIdx), 0, sizeof(HCD_GeneralTransferDescriptor));
-
-		HcdGTD(GtdIdx)->inUse = 1;
-		HcdGTD(GtdIdx)->EdIdx = EdIdx;
-
-		HcdGTD(GtdIdx)->hcGTD.BufferRounding = 1;
-		HcdGTD(GtdIdx)->hcGTD.ConditionCode = (uint32_t) HCD_STATUS_TRANSFER_NotAccessed;
-
-		/* link new GTD to the Endpoint */
-		if (HcdED(EdIdx)->hcED.TailP) /* already have place holder */
-		{
-			( (PHCD_GeneralTransferDescriptor) HcdED(EdIdx)->hcED.TailP )->hcGTD.NextTD = (uint32_t) HcdGTD(GtdIdx);
-		}else /* have no dummy TD attached to the ED */
-		{
-			HcdED(EdIdx)->hcED.HeadP.HeadTD = ((uint32_t) HcdGTD(GtdIdx)) ;
-		}
-		HcdED(EdIdx)->hcED.TailP = (uint32_t) HcdGTD(GtdIdx);
+		LinkPlaceHolderGtd(EdIdx, HcdGTD(GtdIdx));
 
 		return HCD_STATUS_OK;
 	}
@@ -972,6 +1219,56 @@ static HCD_STATUS AllocGtdForEd(uint8_t EdIdx)
 	}
 
 }
+
+static __INLINE void LinkPlaceHolderGtd(uint8_t EdIdx, PHCD_GeneralTransferDescriptor pGtd)
+{
+	/***************    Control (word 0) ****************/
+	/* Buffer rounding:    R = 1b (yes)                 */
+	/* Direction/PID:      DP = 00b (SETUP)             */
+	/* Delay Interrupt:    DI = 000b (interrupt)		*/
+	/* Data Toggle:        DT = 00b (from ED)		    */
+	/* Error Count:        EC = 00b                     */
+	/* Condition Code:     CC = 1110b (not accessed)    */
+	/****************************************************/
+	memset(pGtd, 0, sizeof(HCD_GeneralTransferDescriptor));
+
+	pGtd->inUse = 1;
+	pGtd->EdIdx = EdIdx;
+
+	pGtd->hcGTD.BufferRounding = 1;
+	pGtd->hcGTD.ConditionCode = (uint32_t) HCD_STATUS_TRANSFER_NotAccessed;
+
+	/* link new GTD to the Endpoint */
+	if (HcdED(EdIdx)->hcED.TailP) /* already have place holder */
+	{
+		( (PHCD_GeneralTransferDescriptor) HcdED(EdIdx)->hcED.TailP )->hcGTD.NextTD = (uint32_t) pGtd;
+	}else /* have no dummy TD attached to the ED */
+	{
+		HcdED(EdIdx)->hcED.HeadP.HeadTD = ((uint32_t) pGtd) ;
+	}
+	HcdED(EdIdx)->hcED.TailP = (uint32_t) pGtd;
+}
+
+/* Queues the transfer of a retired TD again from the ISR: the place holder takes the transfer and the retired TD
+ * becomes the new place holder, so the GTD pool is not touched and cannot race an allocation in task context */
+static __INLINE void RequeueGtd(uint8_t HostID, uint8_t EdIdx, PHCD_GeneralTransferDescriptor pGtd)
+{
+	PHCD_GeneralTransferDescriptor TailP = (PHCD_GeneralTransferDescriptor) HcdED(EdIdx)->hcED.TailP;
+
+	TailP->hcGTD.DirectionPID = pGtd->hcGTD.DirectionPID;
+	TailP->hcGTD.CurrentBufferPointer = pGtd->BufferStart;
+	TailP->hcGTD.BufferEnd = pGtd->hcGTD.BufferEnd;
+	TailP->BufferStart = pGtd->BufferStart;
+	TailP->TransferCount = TailP->QueuedLength = pGtd->QueuedLength;
+
+	HcdED(EdIdx)->status = HCD_STATUS_TRANSFER_QUEUED;
+	LinkPlaceHolderGtd(EdIdx, pGtd);
+
+	if (HcdED(EdIdx)->ListIndex == BULK_LIST_HEAD)
+	{
+		OHCI_REG(HostID)->HcCommandStatus |= HC_COMMAND_STATUS_BulkListFilled;
+	}
+}
 static HCD_STATUS AllocItdForEd(uint8_t EdIdx)
 {
 	uint32_t ItdIdx;
@@ -980,21 +1277,7 @@ static HCD_STATUS AllocItdForEd(uint8_t EdIdx)
 	
 	if (ItdIdx < MAX_ITD)
 	{
-		memset( HcdITD(ItdIdx), 0, sizeof(HCD_IsoTransferDescriptor) );
-		HcdITD(ItdIdx)->inUse = 1;
-		HcdITD(ItdIdx)->EdIdx = EdIdx;
-
-		HcdITD(ItdIdx)->ConditionCode = (uint32_t) HCD_STATUS_TRANSFER_NotAccessed;
-
-		/* link new ITD to the Endpoint */
-		if (HcdED(EdIdx)->hcED.TailP) /* already have place holder */
-		{
-			( (PHCD_IsoTransferDescriptor) HcdED(EdIdx)->hcED.TailP )->NextTD = (uint32_t) HcdITD(ItdIdx);
-		}else /* have no dummy TD attached to the ED */
-		{
-			HcdED(EdIdx)->hcED.HeadP.HeadTD = ((uint32_t) HcdITD(ItdIdx)) ;
-		}
-		HcdED(EdIdx)->hcED.TailP = (uint32_t) HcdITD(ItdIdx);
+		LinkPlaceHolderItd(EdIdx, HcdITD(ItdIdx));
 
 		return HCD_STATUS_OK;
 	}else	
@@ -1003,6 +1286,84 @@ static HCD_STATUS AllocItdForEd(uint8_t EdIdx)
 	}
 }
 
+static __INLINE void LinkPlaceHolderItd(uint8_t EdIdx, PHCD_IsoTransferDescriptor pItd)
+{
+	memset( pItd, 0, sizeof(HCD_IsoTransferDescriptor) );
+	pItd->inUse = 1;
+	pItd->EdIdx = EdIdx;
+
+	pItd->ConditionCode = (uint32_t) HCD_STATUS_TRANSFER_NotAccessed;
+
+	/* link new ITD to the Endpoint */
+	if (HcdED(EdIdx)->hcED.TailP) /* already have place holder */
+	{
+		( (PHCD_IsoTransferDescriptor) HcdED(EdIdx)->hcED.TailP )->NextTD = (uint32_t) pItd;
+	}else /* have no dummy TD attached to the ED */
+	{
+		HcdED(EdIdx)->hcED.HeadP.HeadTD = ((uint32_t) pItd) ;
+	}
+	HcdED(EdIdx)->hcED.TailP = (uint32_t) pItd;
+}
+
+/* Same as RequeueGtd for a retired ITD: the place holder takes the buffer with the new packet layout and is
+ * scheduled after the ITDs still queued, the retired ITD becomes the new place holder */
+static __INLINE void RequeueItd(uint8_t HostID, uint8_t EdIdx, PHCD_IsoTransferDescriptor pItd, const uint16_t* PacketLength, uint8_t PacketCount)
+{
+	PHCD_IsoTransferDescriptor TailP = (PHCD_IsoTransferDescriptor) HcdED(EdIdx)->hcED.TailP;
+
+	FillItd(TailP, pItd->BufferStart, PacketLength, PacketCount, IsoReserveFrames(HostID, EdIdx, PacketCount));
+
+	HcdED(EdIdx)->status = HCD_STATUS_TRANSFER_QUEUED;
+	LinkPlaceHolderItd(EdIdx, pItd);
+}
+
+/* Returns the starting frame of the next ITD of an isochronous ED and books its frames: ITDs follow each other
+ * without a gap, the first one of an idle ED (or one that would start in a frame already gone) takes the next frame */
+static __INLINE uint16_t IsoReserveFrames(uint8_t HostID, uint8_t EdIdx, uint8_t PacketCount)
+{
+	uint16_t Earliest = (uint16_t) (HcdGetFrameNumber(HostID) + 1);
+	uint16_t StartingFrame = HcdED(EdIdx)->NextFrame;
+	uint16_t Period = 1 << (HcdED(EdIdx)->Interval ? (HcdED(EdIdx)->Interval - 1) : 0);	/* ISO Interval is an exponent */
+
+	if ( (Align16(HcdED(EdIdx)->hcED.HeadP.HeadTD) == Align16(HcdED(EdIdx)->hcED.TailP)) ||
+		 ((int16_t) (StartingFrame - Earliest) < 0) )
+	{
+		StartingFrame = Earliest;
+	}
+
+	HcdED(EdIdx)->NextFrame = StartingFrame + PacketCount * Period;
+
+	return StartingFrame;
+}
+
+/* Bytes carried by each packet of a retired ITD. The status is the first error found, packets in error (or never
+ * sent because the ITD was late) count 0 bytes. A short IN packet (data underrun) is not an error. */
+static __INLINE HCD_STATUS IsoPacketLengths(uint8_t EdIdx, PHCD_IsoTransferDescriptor pItd, uint16_t* PacketLength)
+{
+	HCD_STATUS Status = (HCD_STATUS) pItd->ConditionCode;
+	uint32_t i;
+
+	for (i = 0; i <= pItd->FrameCount; i++)
+	{
+		uint16_t PSW = pItd->OffsetPSW[i];
+		uint8_t ConditionCode = PSW >> 12;
+
+		if ( (ConditionCode == HCD_STATUS_OK) || (ConditionCode == HCD_STATUS_TRANSFER_DataUnderrun) )
+		{
+			PacketLength[i] = (HcdED(EdIdx)->hcED.Direction == 2) ? (PSW & 0x7FF) : pItd->PacketLength[i];	/* OUT PSWs hold no size */
+		}else
+		{
+			PacketLength[i] = 0;
+			if (Status == HCD_STATUS_OK)
+			{
+				Status = (HCD_STATUS) ConditionCode;
+			}
+		}
+	}
+
+	return Status;
+}
+
 static __INLINE HCD_STATUS FreeED( uint8_t EdIdx ) 
 {
 	/* Remove Place holder TD */
@@ -41,11 +41,15 @@
 /*  OHCI C O N F I G U R A T I O N                        */
 /*=======================================================================*/
 #define MAX_ED								HCD_MAX_ENDPOINT
-#define MAX_GTD								(MAX_ED + 3)
-#define MAX_STATIC_ED						3 /* Serve as list head, fixed, not configurable */
+#define MAX_GTD								HCD_MAX_GTD
+#if INTERRUPT_LIST_ENABLE
+	#define MAX_STATIC_ED					(63 + 3) /* 63 interrupt tree nodes (1-32 ms) + ISO, Control and Bulk list heads */
+#else
+	#define MAX_STATIC_ED					3 /* Serve as list head, fixed, not configurable */
+#endif
 
 #if ISO_LIST_ENABLE
-	#define MAX_ITD								4
+	#define MAX_ITD								HCD_MAX_ITD
 #else
 	#define MAX_ITD								0
 #endif
@@ -106,6 +110,13 @@
 #define BULK_LIST_HEAD				(MAX_STATIC_ED-1)
 #define TD_MAX_XFER_LENGTH			0x2000
 
+/* Periodic bandwidth is accounted in full speed byte times per frame (1500 per 1 ms frame) */
+#define FRAME_BYTE_TIMES					1500
+#define PERIODIC_BANDWIDTH_MAX				((FRAME_BYTE_TIMES * PERIODIC_START) / FRAME_INTERVAL)	/* share left for periodic lists by HcPeriodicStart */
+#define INTERRUPT_PROTOCOL_OVERHEAD			13		/* USB 2.0 5.7.3: token, handshake, sync and EOP for a full speed interrupt transaction */
+#define LOW_SPEED_BANDWIDTH_FACTOR			8		/* a low speed byte takes 8 full speed byte times on the bus */
+#define INTERRUPT_LIST_NONE					0xFF	/* FindInterruptTransferListIndex: no list has enough bandwidth */
+
 #define TD_NoInterruptOnComplete	(7)
 /*=======================================================================*/
 /*  O H C I		R E G I S T E R S				*/
@@ -231,15 +242,18 @@ typedef struct st_HCD_EndpointDescriptor {	// 32 byte align
 
 	/*---------- Word 1 ----------*/
 	uint32_t inUse			: 1;
-	uint32_t ListIndex		: 7;	// 0: Interrupt/ISO, 1: Control, 2: bulk
+	uint32_t ListIndex		: 7;	// index of the static ED heading the list: interrupt tree node, ISO, Control or Bulk
 	uint32_t Interval		: 8;	/* Used by ISO, High speed Bulk/Control maximum NAK */
-	uint32_t 				: 0;	/* Force next member on next storage unit */
+	uint32_t NextFrame		: 16;	/* ISO: frame the next queued ITD starts in */
 	/*---------- End Word 1 ----------*/
 
 	__IO uint32_t status; 			// TODO status is updated by ISR --> is non-caching
 	uint16_t *pActualTransferCount; /* total transferred bytes of a usb request */
 
-	uint32_t reserved;
+	union {
+		HCD_TRANSFER_CALLBACK Callback;		/* called from the ISR on completion, see HcdSetTransferCallback */
+		HCD_ISO_CALLBACK IsoCallback;		/* same for isochronous EDs, see HcdSetIsoCallback */
+	};
 } HCD_EndpointDescriptor, *PHCD_EndpointDescriptor;
 
 typedef struct st_HC_GTD {	// 16 byte align
@@ -275,8 +289,9 @@ typedef struct st_HCD_GeneralTransferDescriptor {	// 32 byte align
 	uint16_t EdIdx;
 	uint16_t TransferCount;
 	
-	uint32_t reserved2;
-	uint32_t reserved3;
+	uint8_t* BufferStart;			/* first byte of the TD's buffer, CurrentBufferPointer is consumed by the HC */
+	uint16_t QueuedLength;			/* length the TD was queued with, TransferCount is overwritten on completion */
+	uint16_t reserved3;
 } HCD_GeneralTransferDescriptor, *PHCD_GeneralTransferDescriptor;
 
 typedef struct st_HCD_IsoTransferDescriptor {	// 64 byte align
@@ -313,7 +328,9 @@ typedef struct st_HCD_IsoTransferDescriptor {	// 64 byte align
 	uint16_t reserved3;
 	/*---------- End Word 10 ----------*/
 
-	uint32_t reserved2[6];
+	uint8_t* BufferStart;			/* first byte of the TD's buffer */
+	uint16_t PacketLength[8];		/* queued length of each packet, the HC writes the PSWs over the offsets */
+	uint32_t reserved2;
 }ATTR_ALIGNED(32)  HCD_IsoTransferDescriptor, *PHCD_IsoTransferDescriptor;
 
 /* Memory for OHCI Structures, docs for more information */
@@ -353,6 +370,8 @@ static __INLINE uint32_t Align16 (uint32_t Value);
 static __INLINE PHCD_EndpointDescriptor HcdED(uint8_t idx);
 static __INLINE PHCD_GeneralTransferDescriptor HcdGTD(uint8_t idx);
 static __INLINE PHCD_IsoTransferDescriptor HcdITD(uint8_t idx);
+static __INLINE bool IsIsoTd(PHC_GTD pTd);
+static __INLINE __IO uint32_t* DoneQueueLink(PHC_GTD pTd);
 static __INLINE bool IsIsoEndpoint( uint8_t EdIdx );
 static __INLINE bool IsInterruptEndpoint (uint8_t EdIdx);
 static void PipehandleCreate(uint32_t* pPipeHandle, uint8_t HostID, uint8_t idx);
@@ -360,15 +379,26 @@ static HCD_STATUS PipehandleParse(uint32_t Pipehandle, uint8_t* HostID, uint8_t*
 static __INLINE void BuildPeriodicStaticEdTree(uint8_t HostID);
 static __INLINE HCD_STATUS AllocEd(uint8_t DeviceAddr, HCD_USB_SPEED DeviceSpeed, uint8_t EndpointNumber, HCD_TRANSFER_TYPE TransferType, HCD_TRANSFER_DIR TransferDir, uint16_t MaxPacketSize, uint8_t Interval, uint32_t* pEdIdx);
 static __INLINE HCD_STATUS AllocGtdForEd(uint8_t EdIdx);
+static __INLINE void LinkPlaceHolderGtd(uint8_t EdIdx, PHCD_GeneralTransferDescriptor pGtd);
+static __INLINE void RequeueGtd(uint8_t HostID, uint8_t EdIdx, PHCD_GeneralTransferDescriptor pGtd);
 static __INLINE HCD_STATUS AllocItdForEd(uint8_t EdIdx);
+static __INLINE void LinkPlaceHolderItd(uint8_t EdIdx, PHCD_IsoTransferDescriptor pItd);
+static __INLINE void RequeueItd(uint8_t HostID, uint8_t EdIdx, PHCD_IsoTransferDescriptor pItd, const uint16_t* PacketLength, uint8_t PacketCount);
+static __INLINE uint16_t IsoReserveFrames(uint8_t HostID, uint8_t EdIdx, uint8_t PacketCount);
+static __INLINE HCD_STATUS IsoPacketLengths(uint8_t EdIdx, PHCD_IsoTransferDescriptor pItd, uint16_t* PacketLength);
 static __INLINE HCD_STATUS FreeED( uint8_t EdIdx );
 static __INLINE HCD_STATUS FreeGtd(PHCD_GeneralTransferDescriptor pGtd);
 static __INLINE HCD_STATUS FreeItd(PHCD_IsoTransferDescriptor pItd);
+static void WaitForNextFrame(uint8_t HostID);
 static __INLINE HCD_STATUS InsertEndpoint(uint8_t HostID, uint32_t EdIdx, uint8_t ListIndex);
 static __INLINE HCD_STATUS RemoveEndpoint(uint8_t HostID, uint32_t EdIdx);
-/*static __INLINE uint8_t FindInterruptTransferListIndex(uint8_t HostID, uint8_t Interval);*/
+static __INLINE uint32_t InterruptEndpointBandwidth(uint8_t EdIdx);
+static __INLINE uint8_t FindInterruptTransferListIndex(uint8_t HostID, uint8_t Interval, uint32_t Bandwidth);
 static HCD_STATUS QueueOneGTD (uint32_t EdIdx, uint8_t* const CurrentBufferPointer, uint32_t xferLen, uint8_t DirectionPID, uint8_t DataToggle, uint8_t IOC);
 static HCD_STATUS QueueGTDs (uint32_t EdIdx, uint8_t* dataBuff, uint32_t xferLen, uint8_t Direction);
+static void FillItd(PHCD_IsoTransferDescriptor pItd, uint8_t* dataBuff, const uint16_t* PacketLength, uint8_t PacketCount, uint16_t StartingFrame);
+static HCD_STATUS QueueOneITD(uint8_t HostID, uint32_t EdIdx, uint8_t* dataBuff, const uint16_t* PacketLength, uint8_t PacketCount);
+static HCD_STATUS QueueITDs(uint8_t HostID, uint32_t EdIdx, uint8_t* dataBuff, uint32_t xferLen);
 static HCD_STATUS WaitForTransferComplete( uint8_t EdIdx );
 
 #endif /*defined(__LPC_OHCI__)*/
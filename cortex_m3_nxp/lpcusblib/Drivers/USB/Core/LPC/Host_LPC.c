@@ -36,44 +36,42 @@
 static uint8_t CurrentHostID = 0;
 uint8_t USB_Host_ControlPipeSize[MAX_USB_CORE];
 
+/* Addresses in use by devices behind hubs, bit n of word n/32 for address n */
+static uint32_t USB_Host_UsedAddresses[MAX_USB_CORE][4];
+
 void USB_Host_SetDeviceSpeed(uint8_t hostid, HCD_USB_SPEED speed);
 HCD_USB_SPEED USB_Host_GetDeviceSpeed(uint8_t hostid);
 
+static bool USB_Host_WaitElapsed(const uint8_t corenum, const uint16_t StartFrame, const uint16_t MS);
+
 void USB_Host_ProcessNextHostState(uint8_t corenum)
 {
 	uint8_t ErrorCode    = HOST_ENUMERROR_NoError;
 	uint8_t SubErrorCode = HOST_ENUMERROR_NoError;
 
+	/* Waits run on the frame counter of the host controller, one frame per millisecond: each call checks
+	 * how many frames have gone since the wait began rather than counting calls */
+	static uint16_t WaitStartFrame;
 	static uint16_t WaitMSRemaining;
 	static uint8_t  PostWaitState;
 
 	switch (USB_HostState[corenum])
 	{
 		case HOST_STATE_WaitForDevice:
-			if (WaitMSRemaining)
-			{
-				if ((SubErrorCode = USB_Host_WaitMS(1)) != HOST_WAITERROR_Successful)
-				{
-					USB_HostState[corenum] = PostWaitState;
-					ErrorCode     = HOST_ENUMERROR_WaitStage;
-					break;
-				}
-
-				if (!(--WaitMSRemaining))
-				  USB_HostState[corenum] = PostWaitState;
-			}
+			if (USB_Host_WaitElapsed(corenum, WaitStartFrame, WaitMSRemaining))
+			  USB_HostState[corenum] = PostWaitState;
 			break;
 
 		case HOST_STATE_Powered:
+			WaitStartFrame  = HcdGetFrameNumber(corenum);
 			WaitMSRemaining = HOST_DEVICE_SETTLE_DELAY_MS;
 
 			USB_HostState[corenum] = HOST_STATE_Powered_WaitForDeviceSettle;
 			break;
 
 		case HOST_STATE_Powered_WaitForDeviceSettle:
-			if (WaitMSRemaining--)
+			if (!(USB_Host_WaitElapsed(corenum, WaitStartFrame, WaitMSRemaining)))
 			{
-				Delay_MS(1);
 				break;
 			}
 			else
@@ -194,10 +192,24 @@ void USB_Host_ProcessNextHostState(uint8_t corenum)
 
 		USB_ResetInterface(corenum);
 	}
+
+	/* Let other tasks run while no device is attached, between the enumeration steps and while a wait runs out */
+	if (USB_HostState[corenum] < HOST_STATE_Addressed)
+	{
+		HcdYield();
+	}
+}
+
+/* A wait of MS milliseconds begun at StartFrame is over once more than MS frames have started since: the frame
+ * the wait began in may have been almost over */
+static bool USB_Host_WaitElapsed(const uint8_t corenum, const uint16_t StartFrame, const uint16_t MS)
+{
+	return ((uint16_t) (HcdGetFrameNumber(corenum) - StartFrame) > MS);
 }
 
 uint8_t USB_Host_WaitMS(uint8_t MS)
 {
+	HcdDelayMS(MS);
 	return HOST_WAITERROR_Successful;
 }
 
@@ -222,10 +234,38 @@ void USB_Host_DeEnumerate(uint8_t HostId) /* Part of Interrupt Service Routine *
 		}
 	}
 
+	/* Devices behind a hub on this port are gone as well */
+	memset(USB_Host_UsedAddresses[HostId], 0, sizeof(USB_Host_UsedAddresses[HostId]));
+	Pipe_SetTargetDevice(HostId, 0, FULL_SPEED);
+
 	EVENT_USB_Host_DeviceUnattached(HostId);
 	USB_HostState[HostId] = HOST_STATE_Unattached;
 }
 
+uint8_t USB_Host_AllocateDeviceAddress(const uint8_t corenum)
+{
+	uint8_t Address;
+
+	for (Address = USB_HOST_DEVICEADDRESS + 1; Address < 128; Address++)
+	{
+		if (!(USB_Host_UsedAddresses[corenum][Address >> 5] & (1UL << (Address & 31))))
+		{
+			USB_Host_UsedAddresses[corenum][Address >> 5] |= (1UL << (Address & 31));
+			return Address;
+		}
+	}
+
+	return 0;
+}
+
+void USB_Host_FreeDeviceAddress(const uint8_t corenum, const uint8_t Address)
+{
+	if ((Address > USB_HOST_DEVICEADDRESS) && (Address < 128))
+	{
+		USB_Host_UsedAddresses[corenum][Address >> 5] &= ~(1UL << (Address & 31));
+	}
+}
+
 /********************************************************************//**
  * @brief
  * @param
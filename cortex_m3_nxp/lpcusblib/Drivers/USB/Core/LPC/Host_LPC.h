@@ -64,10 +64,9 @@
 
 	/* Public Interface - May be used in end-application: */
 		/* Macros: */
-			/** Indicates the fixed USB device address which any attached device is enumerated to when in
-			 *  host mode. As only one USB device may be attached to the LPC in host mode at any one time
-			 *  and that the address used is not important (other than the fact that it is non-zero), a
-			 *  fixed value is specified by the library.
+			/** Indicates the fixed USB device address which the device on the root port is enumerated to when in
+			 *  host mode. Devices behind a hub get their addresses from \ref USB_Host_AllocateDeviceAddress(),
+			 *  which never hands out this value.
 			 */
 			#define USB_HOST_DEVICEADDRESS                 1
 
@@ -137,6 +136,16 @@
 			uint8_t USB_Host_GetActiveHost(void);
 			extern uint8_t USB_Host_ControlPipeSize[MAX_USB_CORE];
 
+			/** Reserves a free USB address on the given host for a device attached behind a hub. All addresses
+			 *  are released again when the device on the root port is detached.
+			 *
+			 *  \return The reserved address (2 to 127), or 0 if none is left.
+			 */
+			uint8_t USB_Host_AllocateDeviceAddress(const uint8_t corenum);
+
+			/** Releases an address reserved with \ref USB_Host_AllocateDeviceAddress(). */
+			void USB_Host_FreeDeviceAddress(const uint8_t corenum, const uint8_t Address);
+
 		/* Inline Functions: */
 			#if !defined(NO_SOF_EVENTS)
 				/** Enables the host mode Start Of Frame events. When enabled, this causes the
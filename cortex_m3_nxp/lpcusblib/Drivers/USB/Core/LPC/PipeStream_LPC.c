@@ -95,6 +95,9 @@ uint8_t Pipe_Write_Stream_LE(const uint8_t corenum,
 			                 uint16_t* const BytesProcessed)
 {
 	uint8_t* DataStream = (uint8_t*) Buffer;
+	uint8_t  ErrorCode;
+	uint16_t Count;
+
 	if(BytesProcessed != NULL)
 	{
 		Length -= *BytesProcessed;
@@ -103,9 +106,28 @@ uint8_t Pipe_Write_Stream_LE(const uint8_t corenum,
 
 	while(Length)
 	{
-		Pipe_Write_8(corenum, *DataStream);
-		DataStream++;
-		Length--;
+		if (!(Pipe_IsReadWriteAllowed(corenum)))
+		{
+			/* Pipe buffer full: send it and wait, the caller's Pipe_ClearOUT() sends the last part */
+			Pipe_ClearOUT(corenum);
+
+			if ((ErrorCode = Pipe_WaitUntilReady(corenum)))
+			  return ErrorCode;
+		}
+		else
+		{
+			Count = MIN(Length, PipeInfo[corenum][pipeselected[corenum]].BufferSize -
+								PipeInfo[corenum][pipeselected[corenum]].ByteTransfered);
+			memcpy(&PipeInfo[corenum][pipeselected[corenum]].Buffer[PipeInfo[corenum][pipeselected[corenum]].ByteTransfered],
+				   DataStream, Count);
+			PipeInfo[corenum][pipeselected[corenum]].ByteTransfered += Count;
+
+			if (BytesProcessed != NULL)
+			  *BytesProcessed += Count;
+
+			DataStream += Count;
+			Length -= Count;
+		}
 	}
 
 	return PIPE_RWSTREAM_NoError;
@@ -149,6 +171,135 @@ uint8_t Pipe_Read_Stream_LE(const uint8_t corenum,
 
 	return PIPE_RWSTREAM_NoError;
 }
+
+/* Wait for the transfer queued on the selected pipe to be retired by the host controller */
+static uint8_t Pipe_WaitForChunk(const uint8_t corenum)
+{
+	HCD_STATUS status;
+
+	for (;;)
+	{
+		if (USB_HostState[corenum] == HOST_STATE_Unattached)
+		  return PIPE_RWSTREAM_DeviceDisconnected;
+
+		status = HcdGetPipeStatus(PipeInfo[corenum][pipeselected[corenum]].PipeHandle);
+
+		if (status == HCD_STATUS_OK)
+		  return PIPE_RWSTREAM_NoError;
+		else if (status == HCD_STATUS_TRANSFER_Stall)
+		  return PIPE_RWSTREAM_PipeStalled;
+		else if (status != HCD_STATUS_TRANSFER_QUEUED)
+		  return PIPE_RWSTREAM_Timeout; /* device not responding or bus error */
+	}
+}
+
+/* Queue the next chunk on the selected pipe, a transfer the host controller refuses ends the stream */
+static uint8_t Pipe_QueueChunk(const uint8_t corenum,
+                               uint8_t* const Buffer,
+                               const uint16_t Length,
+                               uint16_t* const Received)
+{
+	HCD_STATUS status = HcdDataTransfer(PipeInfo[corenum][pipeselected[corenum]].PipeHandle, Buffer, Length, Received);
+
+	if (status == HCD_STATUS_OK)
+	  return PIPE_RWSTREAM_NoError;
+	else if ((status == HCD_STATUS_DEVICE_DISCONNECTED) || (USB_HostState[corenum] == HOST_STATE_Unattached))
+	  return PIPE_RWSTREAM_DeviceDisconnected;
+	else
+	  return PIPE_RWSTREAM_PipeStalled;
+}
+
+uint8_t Pipe_Read_Stream_Chunked(const uint8_t corenum,
+                                 uint32_t Length,
+                                 uint16_t ChunkSize,
+                                 Pipe_StreamChunkCallback_t Callback,
+                                 void* const Context,
+                                 uint32_t* const BytesReceived)
+{
+	USB_Pipe_Data_t* Pipe = &PipeInfo[corenum][pipeselected[corenum]];
+	uint8_t*  ChunkBuffer[2];
+	uint16_t  ChunkLength[2];
+	uint16_t  ChunkReceived[2];
+	bool      OwnBuffers = true;
+	bool      DoubleBuffered;
+	uint8_t   Bank = 0;
+	uint8_t   Next;
+	uint8_t   ErrorCode = PIPE_RWSTREAM_NoError;
+	uint8_t   QueueError;
+
+	if (BytesReceived != NULL)
+	  *BytesReceived = 0;
+
+	ChunkSize = MIN(ChunkSize, PIPE_STREAM_MAX_CHUNK_SIZE);
+
+	ChunkBuffer[0] = USB_Memory_Alloc(ChunkSize);
+	ChunkBuffer[1] = (ChunkBuffer[0] != NULL) ? USB_Memory_Alloc(ChunkSize) : NULL;
+
+	if (ChunkBuffer[0] == NULL) /* Pool exhausted, use the pipe buffer without overlap */
+	{
+		ChunkBuffer[0] = Pipe->Buffer;
+		ChunkSize      = Pipe->BufferSize;
+		OwnBuffers     = false;
+	}
+
+	DoubleBuffered = (ChunkBuffer[1] != NULL);
+	if (!(DoubleBuffered))
+	  ChunkBuffer[1] = ChunkBuffer[0];
+
+	Pipe_ClearIN(corenum);
+
+	ChunkLength[0] = MIN(Length, ChunkSize);
+	Length        -= ChunkLength[0];
+
+	if (ChunkLength[0])
+	{
+		ChunkReceived[0] = 0;
+		ErrorCode = Pipe_QueueChunk(corenum, ChunkBuffer[0], ChunkLength[0], &ChunkReceived[0]);
+	}
+
+	while (ChunkLength[Bank] && (ErrorCode == PIPE_RWSTREAM_NoError))
+	{
+		if ((ErrorCode = Pipe_WaitForChunk(corenum)) != PIPE_RWSTREAM_NoError)
+		  break;
+
+		Next = Bank ^ 1;
+
+		/* A short packet terminates the data stage */
+		ChunkLength[Next] = (ChunkReceived[Bank] < ChunkLength[Bank]) ? 0 : MIN(Length, ChunkSize);
+		Length -= ChunkLength[Next];
+		ChunkReceived[Next] = 0;
+		QueueError = PIPE_RWSTREAM_NoError;
+
+		/* Keep the bus busy with the next chunk while the current one is processed, the current
+		 * chunk is complete and still handed over if the next one cannot be queued */
+		if (DoubleBuffered && ChunkLength[Next])
+		  QueueError = Pipe_QueueChunk(corenum, ChunkBuffer[Next], ChunkLength[Next], &ChunkReceived[Next]);
+
+		Callback(ChunkBuffer[Bank], ChunkReceived[Bank], Context);
+
+		if (BytesReceived != NULL)
+		  *BytesReceived += ChunkReceived[Bank];
+
+		if (!(DoubleBuffered) && ChunkLength[Next])
+		  QueueError = Pipe_QueueChunk(corenum, ChunkBuffer[Next], ChunkLength[Next], &ChunkReceived[Next]);
+
+		ErrorCode = QueueError;
+		Bank = Next;
+	}
+
+	if (OwnBuffers)
+	{
+		if (DoubleBuffered)
+		  USB_Memory_Free(ChunkBuffer[1]);
+
+		USB_Memory_Free(ChunkBuffer[0]);
+	}
+
+	Pipe_ClearIN(corenum);
+
+	return ErrorCode;
+}
+
 uint8_t Pipe_Write_Stream_BE(const void* const Buffer,
 			                             uint16_t Length,
 			                             uint16_t* const BytesProcessed)
@@ -342,6 +342,53 @@
 			                            uint16_t* const BytesProcessed) ATTR_NON_NULL_PTR_ARG(1) ATTR_ERROR("Function is not implemented yet");
 			//@}
 
+			/** \name Stream functions for chunked (double buffered) reception */
+			//@{
+
+			/** Type define for the chunk callback of \ref Pipe_Read_Stream_Chunked(). The callback is given each chunk
+			 *  in order, as soon as it has been received from the device. The chunk memory is only valid until the
+			 *  callback returns.
+			 *
+			 *  \param[in] Chunk    Pointer to the received data of the chunk.
+			 *  \param[in] Length   Number of valid bytes in the chunk.
+			 *  \param[in] Context  User context pointer given to \ref Pipe_Read_Stream_Chunked().
+			 */
+			typedef void (*Pipe_StreamChunkCallback_t)(const uint8_t* const Chunk,
+			                                           const uint16_t Length,
+			                                           void* const Context);
+
+			/** Maximum chunk size accepted by \ref Pipe_Read_Stream_Chunked(), so that every chunk is retired by the
+			 *  host controller as a single transfer.
+			 */
+			#define PIPE_STREAM_MAX_CHUNK_SIZE      4096
+
+			/** Reads the given number of bytes from the currently selected IN pipe, delivering the data to the given
+			 *  callback in chunks of \c ChunkSize bytes. Two chunk buffers are taken from the USB memory pool and used
+			 *  alternately: while the callback is processing one chunk, the host controller is already filling the
+			 *  other one, so bus transfer and data processing overlap. If the pool cannot provide two buffers the
+			 *  function falls back to a single buffer, and if it cannot provide any, to the pipe's own buffer.
+			 *
+			 *  The stream ends early, without error, when the device terminates the data with a short packet.
+			 *
+			 *  \param[in]  corenum        USB port number.
+			 *  \param[in]  Length         Total number of bytes to read from the pipe.
+			 *  \param[in]  ChunkSize      Size in bytes of each chunk, at most \ref PIPE_STREAM_MAX_CHUNK_SIZE. Should
+			 *                             be a multiple of the pipe's endpoint size.
+			 *  \param[in]  Callback       Function called for every received chunk.
+			 *  \param[in]  Context        User context pointer passed to the callback.
+			 *  \param[out] BytesReceived  Pointer to a location where the total number of bytes delivered to the
+			 *                             callback is stored, or \c NULL if not required.
+			 *
+			 *  \return A value from the \ref Pipe_Stream_RW_ErrorCodes_t enum.
+			 */
+			uint8_t Pipe_Read_Stream_Chunked(const uint8_t corenum,
+			                                 uint32_t Length,
+			                                 uint16_t ChunkSize,
+			                                 Pipe_StreamChunkCallback_t Callback,
+			                                 void* const Context,
+			                                 uint32_t* const BytesReceived) ATTR_NON_NULL_PTR_ARG(4);
+			//@}
+
 			/** \name Stream functions for EEPROM source/destination data */
 			//@{
 			
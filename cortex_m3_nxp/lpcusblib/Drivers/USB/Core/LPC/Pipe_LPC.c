@@ -38,6 +38,9 @@ USB_Pipe_Data_t PipeInfo[MAX_USB_CORE][PIPE_TOTAL_PIPES];
 HCD_USB_SPEED hostportspeed[MAX_USB_CORE];
 uint8_t hostselected;
 
+uint8_t pipetargetaddress[MAX_USB_CORE];		/* 0: the device on the root port */
+HCD_USB_SPEED pipetargetspeed[MAX_USB_CORE];
+
 bool Pipe_ConfigurePipe(const uint8_t corenum,
 						const uint8_t Number,
                         const uint8_t Type,
@@ -45,10 +48,31 @@ bool Pipe_ConfigurePipe(const uint8_t corenum,
                         const uint8_t EndpointNumber,
                         const uint16_t Size,
                         const uint8_t Banks)
+{
+	if (pipetargetaddress[corenum])
+	{
+		return Pipe_ConfigureDevicePipe(corenum, Number, pipetargetaddress[corenum], pipetargetspeed[corenum],
+										Type, Token, EndpointNumber, Size, Banks);
+	}
+
+	return Pipe_ConfigureDevicePipe(corenum, Number,
+									((Type == EP_TYPE_CONTROL && USB_HostState[corenum] < HOST_STATE_Default_PostAddressSet)) ? 0 : USB_HOST_DEVICEADDRESS,
+									hostportspeed[corenum], Type, Token, EndpointNumber, Size, Banks);
+}
+
+bool Pipe_ConfigureDevicePipe(const uint8_t corenum,
+							  const uint8_t Number,
+							  const uint8_t DeviceAddress,
+							  const HCD_USB_SPEED DeviceSpeed,
+							  const uint8_t Type,
+							  const uint8_t Token,
+							  const uint8_t EndpointNumber,
+							  const uint16_t Size,
+							  const uint8_t Banks)
 {
 	if ( HCD_STATUS_OK == HcdOpenPipe(corenum,				/* HostID */
-										((Type == EP_TYPE_CONTROL && USB_HostState[corenum] < HOST_STATE_Default_PostAddressSet)) ? 0 : USB_HOST_DEVICEADDRESS,		/* FIXME DeviceAddr */
-										hostportspeed[corenum],/* DeviceSpeed */
+										DeviceAddress,				/* DeviceAddr */
+										DeviceSpeed,				/* DeviceSpeed */
 										EndpointNumber,				/* EndpointNo */
 										(HCD_TRANSFER_TYPE) Type,	/* TransferType */
 										(HCD_TRANSFER_DIR) Token,	/* TransferDir */
@@ -64,11 +88,13 @@ bool Pipe_ConfigurePipe(const uint8_t corenum,
 		PipeInfo[corenum][Number].BufferSize = (Type == EP_TYPE_BULK || Type == EP_TYPE_CONTROL) ? PIPE_MAX_SIZE : Size; /* XXX Some devices could have configuration descriptor > 235 bytes (eps speaker, webcame). If not deal with those, not need to have such large pipe size for control */
 		PipeInfo[corenum][Number].Buffer = USB_Memory_Alloc( PipeInfo[corenum][Number].BufferSize );
 		PipeInfo[corenum][Number].EndponitAddress = EndpointNumber;
+		PipeInfo[corenum][Number].DeviceAddress = DeviceAddress;
 		if (PipeInfo[corenum][Number].Buffer == NULL)
 		{
 			return false;
 		}
 
+		pipeselected[corenum] = Number; /* configured pipe is left selected, as documented */
 		return true;
 	}else
 	{
@@ -88,6 +114,25 @@ void Pipe_ClosePipe(const uint8_t corenum, uint8_t pipenum)
 	}
 }
 
+void Pipe_SetTargetDevice(const uint8_t corenum, const uint8_t DeviceAddress, const HCD_USB_SPEED DeviceSpeed)
+{
+	pipetargetaddress[corenum] = DeviceAddress;
+	pipetargetspeed[corenum]   = DeviceSpeed;
+}
+
+void Pipe_CloseDevicePipes(const uint8_t corenum, const uint8_t DeviceAddress)
+{
+	uint8_t i;
+
+	for (i = 0; i < PIPE_TOTAL_PIPES; i++)
+	{
+		if ((PipeInfo[corenum][i].Buffer != NULL) && (PipeInfo[corenum][i].DeviceAddress == DeviceAddress))
+		{
+			Pipe_ClosePipe(corenum, i);
+		}
+	}
+}
+
 void Pipe_ClearPipes(void)
 {
 
@@ -152,5 +197,131 @@ bool Pipe_IsINReceived(const uint8_t corenum)
 	}
 }
 
+bool Pipe_StartINStream(const uint8_t corenum, HCD_TRANSFER_CALLBACK Callback)
+{
+	USB_Pipe_Data_t* Pipe = &PipeInfo[corenum][pipeselected[corenum]];
+
+	if (HCD_STATUS_OK != HcdSetTransferCallback(Pipe->PipeHandle, Callback))
+	{
+		return false;
+	}
+
+	Pipe->StartIdx = Pipe->ByteTransfered = 0;
+
+	return (HCD_STATUS_OK == HcdDataTransfer(Pipe->PipeHandle, Pipe->Buffer, HCD_ENDPOINT_MAXPACKET_XFER_LEN,
+											 &Pipe->ByteTransfered));
+}
+
+void Pipe_StopINStream(const uint8_t corenum)
+{
+	USB_Pipe_Data_t* Pipe = &PipeInfo[corenum][pipeselected[corenum]];
+
+	HcdSetTransferCallback(Pipe->PipeHandle, NULL);
+	HcdCancelTransfer(Pipe->PipeHandle);
+	Pipe->StartIdx = Pipe->ByteTransfered = 0;
+}
+
+bool Pipe_StartBulkINStream(const uint8_t corenum,
+							HCD_TRANSFER_CALLBACK Callback,
+							uint8_t* const Buffer,
+							const uint16_t TransferSize,
+							const uint8_t Transfers)
+{
+	USB_Pipe_Data_t* Pipe = &PipeInfo[corenum][pipeselected[corenum]];
+	bool Queued = true;
+	uint8_t i;
+
+	if (HCD_STATUS_OK != HcdSetTransferCallback(Pipe->PipeHandle, Callback))
+	{
+		return false;
+	}
+
+	Pipe->StartIdx = Pipe->ByteTransfered = 0;
+
+	/* The interrupt re-queues finished transfers on the same ED, keep it out until every transfer is queued */
+	HAL_DisableUSBInterrupt(corenum);
+	for (i = 0; (i < Transfers) && Queued; i++)
+	{
+		Queued = (HCD_STATUS_OK == HcdDataTransfer(Pipe->PipeHandle, Buffer + (uint32_t) i * TransferSize, TransferSize, NULL));
+	}
+	HAL_EnableUSBInterrupt(corenum);
+
+	if (!(Queued))
+	{
+		Pipe_StopINStream(corenum);
+	}
+
+	return Queued;
+}
+
+bool Pipe_QueueINStreamTransfer(const uint8_t corenum,
+								uint8_t* const Buffer,
+								const uint16_t TransferSize)
+{
+	bool Queued;
+
+	/* The TD pool and the ED tail are shared with the re-queuing done by the interrupt */
+	HAL_DisableUSBInterrupt(corenum);
+	Queued = (HCD_STATUS_OK == HcdDataTransfer(PipeInfo[corenum][pipeselected[corenum]].PipeHandle, Buffer, TransferSize, NULL));
+	HAL_EnableUSBInterrupt(corenum);
+
+	return Queued;
+}
+
+bool Pipe_StartOUTTransfer(const uint8_t corenum,
+						   uint8_t* const Buffer,
+						   const uint16_t Length)
+{
+	bool Queued;
+
+	/* The TD pool is shared with the streams the interrupt re-queues and frees */
+	HAL_DisableUSBInterrupt(corenum);
+	Queued = (HCD_STATUS_OK == HcdDataTransfer(PipeInfo[corenum][pipeselected[corenum]].PipeHandle, Buffer, Length, NULL));
+	HAL_EnableUSBInterrupt(corenum);
+
+	return Queued;
+}
+
+bool Pipe_StartISOStream(const uint8_t corenum,
+						 HCD_ISO_CALLBACK Callback,
+						 uint8_t* const Buffer,
+						 const uint16_t TransferSize,
+						 const uint16_t* const PacketLength,
+						 const uint8_t PacketCount,
+						 const uint8_t Transfers)
+{
+	uint32_t PipeHandle = PipeInfo[corenum][pipeselected[corenum]].PipeHandle;
+	bool Queued = true;
+	uint8_t i;
+
+	if (HCD_STATUS_OK != HcdSetIsoCallback(PipeHandle, Callback))
+	{
+		return false;
+	}
+
+	/* The interrupt re-queues finished transfers on the same ED, keep it out until every transfer is queued */
+	HAL_DisableUSBInterrupt(corenum);
+	for (i = 0; (i < Transfers) && Queued; i++)
+	{
+		Queued = (HCD_STATUS_OK == HcdIsoTransfer(PipeHandle, Buffer + (uint32_t) i * TransferSize, PacketLength, PacketCount));
+	}
+	HAL_EnableUSBInterrupt(corenum);
+
+	if (!(Queued))
+	{
+		Pipe_StopISOStream(corenum);
+	}
+
+	return Queued;
+}
+
+void Pipe_StopISOStream(const uint8_t corenum)
+{
+	uint32_t PipeHandle = PipeInfo[corenum][pipeselected[corenum]].PipeHandle;
+
+	HcdSetIsoCallback(PipeHandle, NULL);
+	HcdCancelTransfer(PipeHandle);
+}
+
 #endif
 
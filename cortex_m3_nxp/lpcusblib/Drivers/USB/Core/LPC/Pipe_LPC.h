@@ -198,11 +198,14 @@
 				uint16_t StartIdx;
 				uint16_t ByteTransfered;
 				uint8_t  EndponitAddress;	/* with direction */
+				uint8_t  DeviceAddress;		/* USB address of the device the pipe talks to */
 			} USB_Pipe_Data_t;
 
 
 			extern uint8_t hostselected;
 			extern HCD_USB_SPEED hostportspeed[];
+			extern uint8_t pipetargetaddress[];
+			extern HCD_USB_SPEED pipetargetspeed[];
 
 			extern uint8_t pipeselected[MAX_USB_CORE];
 			extern USB_Pipe_Data_t PipeInfo[MAX_USB_CORE][PIPE_TOTAL_PIPES];
@@ -348,14 +351,35 @@
 				return PipeInfo[corenum][pipeselected[corenum]].EndponitAddress;
 			}
 
-			/** Sets the period between interrupts for an INTERRUPT type pipe to a specified number of milliseconds.
+			/** Sets the period between interrupts for the currently selected INTERRUPT type pipe to a specified
+			 *  number of milliseconds. The host controller then polls the endpoint by itself at that rate, the
+			 *  period being rounded down to a power of two (1 to 32 ms) on OHCI hosts.
 			 *
+			 *  \param[in] corenum       USB port number.
 			 *  \param[in] Milliseconds  Number of milliseconds between each pipe poll.
+			 *
+			 *  \return Boolean \c true if the period was applied, \c false if the periodic schedule has no room left.
+			 */
+			static inline bool Pipe_SetInterruptPeriod(const uint8_t corenum, const uint8_t Milliseconds) ATTR_ALWAYS_INLINE;
+			static inline bool Pipe_SetInterruptPeriod(const uint8_t corenum, const uint8_t Milliseconds)
+			{
+				return (HcdSetPipeInterval(PipeInfo[corenum][pipeselected[corenum]].PipeHandle, Milliseconds) == HCD_STATUS_OK);
+			}
+
+			/** Sets the service period of the currently selected ISOCHRONOUS type pipe to 2^(Exponent - 1) frames, the
+			 *  encoding of the \c bInterval field of isochronous endpoint descriptors (feedback endpoints of audio devices
+			 *  give \c bRefresh, which translates to an exponent of \c bRefresh + 1). Transfers queued on a pipe with a
+			 *  period above one frame carry a single packet.
+			 *
+			 *  \param[in] corenum   USB port number.
+			 *  \param[in] Exponent  Period exponent, 1 for a packet every frame.
+			 *
+			 *  \return Boolean \c true if the period was applied, \c false otherwise.
 			 */
-			static inline void Pipe_SetInterruptPeriod(const uint8_t Milliseconds) ATTR_ALWAYS_INLINE;
-			static inline void Pipe_SetInterruptPeriod(const uint8_t Milliseconds)
+			static inline bool Pipe_SetIsochronousInterval(const uint8_t corenum, const uint8_t Exponent) ATTR_ALWAYS_INLINE;
+			static inline bool Pipe_SetIsochronousInterval(const uint8_t corenum, const uint8_t Exponent)
 			{
-				//TODO implement later
+				return (HcdSetPipeInterval(PipeInfo[corenum][pipeselected[corenum]].PipeHandle, Exponent) == HCD_STATUS_OK);
 			}
 
 			/** Returns a mask indicating which pipe's interrupt periods have elapsed, indicating that the pipe should
@@ -460,6 +484,140 @@
 //			static inline bool Pipe_IsINReceived(void) ATTR_WARN_UNUSED_RESULT ATTR_ALWAYS_INLINE;
 			bool Pipe_IsINReceived(const uint8_t corenum) ATTR_WARN_UNUSED_RESULT;
 
+			/** Hands every packet received on the currently selected IN pipe to a callback, called from the USB
+			 *  interrupt with the packet in the pipe buffer. The next IN transfer is queued by the interrupt itself as long
+			 *  as the callback returns \c true, so reports of an interrupt pipe reach the application without it polling
+			 *  \ref Pipe_IsINReceived(). The pipe must not be read with the other pipe functions while streaming.
+			 *
+			 *  \ingroup Group_PipePacketManagement_LPC
+			 *
+			 *  \param[in] Callback  Function called with the pipe handle, status, buffer and length of each packet.
+			 *
+			 *  \return Boolean \c true if the stream was started, \c false if the host controller driver has no
+			 *          completion callbacks for this pipe type, which is always the case with the EHCI driver.
+			 */
+			bool Pipe_StartINStream(const uint8_t corenum, HCD_TRANSFER_CALLBACK Callback);
+
+			/** Stops a stream started with \ref Pipe_StartINStream() on the currently selected pipe, cancelling the
+			 *  outstanding IN transfer.
+			 *
+			 *  \ingroup Group_PipePacketManagement_LPC
+			 */
+			void Pipe_StopINStream(const uint8_t corenum);
+
+			/** Starts streaming on the currently selected BULK or INTERRUPT type IN pipe with several transfers in flight.
+			 *  \c Transfers transfers of \c TransferSize bytes are queued, transfer \c n receiving into \c Buffer + \c n * \c TransferSize,
+			 *  so the host controller keeps the pipe busy while the USB interrupt hands each finished transfer to the callback.
+			 *  A transfer ends when full or on a short packet; the callback returns \c true to queue it again on the same buffer,
+			 *  or \c false to leave it idle until it is given back with \ref Pipe_QueueINStreamTransfer(). The stream is stopped
+			 *  with \ref Pipe_StopINStream().
+			 *
+			 *  \note The buffer must be taken from the USB RAM (\ref USB_Memory_Alloc()), \c TransferSize must be a multiple of the
+			 *        pipe's packet size of at most 4 KB, and each transfer takes one transfer descriptor of the host controller driver
+			 *        for as long as it is queued.
+			 *
+			 *  \ingroup Group_PipePacketManagement_LPC
+			 *
+			 *  \param[in] corenum       USB port number.
+			 *  \param[in] Callback      Function called with each finished transfer, returning \c true to queue it again.
+			 *  \param[in] Buffer        Buffer of the queued transfers.
+			 *  \param[in] TransferSize  Length in bytes of each transfer.
+			 *  \param[in] Transfers     Number of transfers queued.
+			 *
+			 *  \return Boolean \c true if the stream was started, \c false if the host controller driver refused a transfer,
+			 *          in which case nothing is left queued.
+			 */
+			bool Pipe_StartBulkINStream(const uint8_t corenum,
+			                            HCD_TRANSFER_CALLBACK Callback,
+			                            uint8_t* const Buffer,
+			                            const uint16_t TransferSize,
+			                            const uint8_t Transfers);
+
+			/** Queues one transfer again on a stream started with \ref Pipe_StartBulkINStream() on the currently selected pipe,
+			 *  after its callback returned \c false for it. Must not be called from the stream's callback.
+			 *
+			 *  \ingroup Group_PipePacketManagement_LPC
+			 *
+			 *  \param[in] corenum       USB port number.
+			 *  \param[in] Buffer        Buffer of the transfer, within the stream buffer.
+			 *  \param[in] TransferSize  Length in bytes of the transfer.
+			 *
+			 *  \return Boolean \c true if the transfer was queued, \c false otherwise.
+			 */
+			bool Pipe_QueueINStreamTransfer(const uint8_t corenum,
+			                                uint8_t* const Buffer,
+			                                const uint16_t TransferSize);
+
+			/** Queues a whole OUT transfer of the given buffer on the currently selected BULK type OUT pipe, bypassing the pipe
+			 *  buffer, so a batch built in place goes out as a single transfer. The host controller splits it into packets of the
+			 *  pipe's size, a last packet shorter than that ending the transfer; \ref Pipe_IsOUTTransferPending() tells when it
+			 *  is done and \ref Pipe_IsOUTReady() whether it succeeded.
+			 *
+			 *  \note The buffer must be taken from the USB RAM (\ref USB_Memory_Alloc()), must stay untouched until the transfer is
+			 *        done and must hold at most 4 KB. Only one transfer may be queued on the pipe at a time.
+			 *
+			 *  \ingroup Group_PipePacketManagement_LPC
+			 *
+			 *  \param[in] corenum  USB port number.
+			 *  \param[in] Buffer   Data to send.
+			 *  \param[in] Length   Length in bytes of the data, at least one byte.
+			 *
+			 *  \return Boolean \c true if the transfer was queued, \c false otherwise.
+			 */
+			bool Pipe_StartOUTTransfer(const uint8_t corenum,
+			                           uint8_t* const Buffer,
+			                           const uint16_t Length);
+
+			/** Determines if a transfer queued with \ref Pipe_StartOUTTransfer() on the currently selected pipe is still in progress.
+			 *
+			 *  \ingroup Group_PipePacketManagement_LPC
+			 *
+			 *  \return Boolean \c true while the transfer is queued, \c false once it has completed or failed.
+			 */
+			static inline bool Pipe_IsOUTTransferPending(const uint8_t corenum) ATTR_WARN_UNUSED_RESULT ATTR_ALWAYS_INLINE;
+			static inline bool Pipe_IsOUTTransferPending(const uint8_t corenum)
+			{
+				return HcdGetPipeStatus(PipeInfo[corenum][pipeselected[corenum]].PipeHandle) == HCD_STATUS_TRANSFER_QUEUED;
+			}
+
+			/** Starts streaming on the currently selected ISOCHRONOUS type pipe. \c Transfers transfers of \c PacketCount
+			 *  packets each are queued on consecutive frames, transfer \c n using the buffer at \c Buffer + \c n * \c TransferSize
+			 *  with the packet lengths given in \c PacketLength. Each finished transfer is then handed to the callback from the
+			 *  USB interrupt, which consumes (IN) or refills (OUT) the buffer and sets the packet lengths it is queued again
+			 *  with, so the stream keeps running without the application touching individual packets.
+			 *
+			 *  \note The buffer must be taken from the USB RAM (\ref USB_Memory_Alloc()) and each transfer must stay within
+			 *        two 4 KB pages.
+			 *
+			 *  \ingroup Group_PipePacketManagement_LPC
+			 *
+			 *  \param[in] corenum       USB port number.
+			 *  \param[in] Callback      Function called with each finished transfer, returning \c true to queue it again.
+			 *  \param[in] Buffer        Buffer of the queued transfers.
+			 *  \param[in] TransferSize  Distance in bytes between the buffers of two transfers.
+			 *  \param[in] PacketLength  Length of each packet of the first transfers.
+			 *  \param[in] PacketCount   Number of packets per transfer, up to \c HCD_ISO_MAX_PACKETS.
+			 *  \param[in] Transfers     Number of transfers kept queued.
+			 *
+			 *  \return Boolean \c true if the stream was started, \c false if the host controller driver refused a transfer,
+			 *          in which case nothing is left queued. The EHCI driver has no isochronous streams and always
+			 *          refuses.
+			 */
+			bool Pipe_StartISOStream(const uint8_t corenum,
+			                         HCD_ISO_CALLBACK Callback,
+			                         uint8_t* const Buffer,
+			                         const uint16_t TransferSize,
+			                         const uint16_t* const PacketLength,
+			                         const uint8_t PacketCount,
+			                         const uint8_t Transfers);
+
+			/** Stops a stream started with \ref Pipe_StartISOStream() on the currently selected pipe, cancelling the
+			 *  queued transfers. The stream buffer may be released once this returns.
+			 *
+			 *  \ingroup Group_PipePacketManagement_LPC
+			 */
+			void Pipe_StopISOStream(const uint8_t corenum);
+
 			/** Determines if the currently selected OUT pipe is ready to send an OUT packet to the attached device.
 			 *
 			 *  \ingroup Group_PipePacketManagement_LPC
@@ -868,7 +1026,42 @@
 			                        const uint8_t EndpointNumber,
 			                        const uint16_t Size,
 			                        const uint8_t Banks);
+
+			/** Configures a pipe like \ref Pipe_ConfigurePipe(), but to an explicitly given device address and speed
+			 *  instead of the device selected with \ref Pipe_SetTargetDevice(). Used by the hub class driver to reach
+			 *  devices behind a hub, including address 0 while such a device is being enumerated.
+			 *
+			 *  \param[in] DeviceAddress   USB address of the device the pipe talks to.
+			 *  \param[in] DeviceSpeed     Speed of that device, \c LOW_SPEED devices behind a full speed hub included.
+			 *
+			 *  \return Boolean \c true if the configuration succeeded, \c false otherwise.
+			 */
+			bool Pipe_ConfigureDevicePipe(const uint8_t corenum,
+										  const uint8_t Number,
+										  const uint8_t DeviceAddress,
+										  const HCD_USB_SPEED DeviceSpeed,
+										  const uint8_t Type,
+										  const uint8_t Token,
+										  const uint8_t EndpointNumber,
+										  const uint16_t Size,
+										  const uint8_t Banks);
+
+			/** Selects the device which pipes configured through \ref Pipe_ConfigurePipe() are bound to, so that the
+			 *  unmodified class drivers can set up their pipes on a device behind a hub. Pipes keep the device they were
+			 *  configured for, only later \ref Pipe_ConfigurePipe() calls are affected.
+			 *
+			 *  \param[in] DeviceAddress   USB address of the device, or 0 for the device on the root port.
+			 *  \param[in] DeviceSpeed     Speed of that device, ignored for the root port device.
+			 */
+			void Pipe_SetTargetDevice(const uint8_t corenum, const uint8_t DeviceAddress, const HCD_USB_SPEED DeviceSpeed);
+
 			void Pipe_ClosePipe(const uint8_t corenum, uint8_t pipenum);
+
+			/** Closes every open pipe bound to the given device address, e.g. once that device was unplugged from a hub.
+			 *
+			 *  \param[in] DeviceAddress   USB address of the device whose pipes are closed.
+			 */
+			void Pipe_CloseDevicePipes(const uint8_t corenum, const uint8_t DeviceAddress);
 			/** Spin-loops until the currently selected non-control pipe is ready for the next packed of data to be read
 			 *  or written to it, aborting in the case of an error condition (such as a timeout or device disconnect).
 			 *
@@ -61,6 +61,13 @@ void USB_USBTask(void)
 
 #if defined(USB_CAN_BE_DEVICE)
 static void USB_DeviceTask(void)
+{
+	#if !defined(INTERRUPT_CONTROL_ENDPOINT)
+	USB_DeviceControlTask();
+	#endif
+}
+
+void USB_DeviceControlTask(void)
 {
 	if (USB_DeviceState != DEVICE_STATE_Unattached)
 	{
@@ -172,6 +172,9 @@
 			 *
 			 *  If in device mode (only), the control endpoint can instead be managed via interrupts entirely by the library
 			 *  by defining the INTERRUPT_CONTROL_ENDPOINT token and passing it to the compiler via the -D switch.
+			 *  On the LPC17xx the USB interrupt then latches each SETUP packet and pends a lower priority interrupt
+			 *  (USB_CONTROL_IRQn) which processes the request, so that enumeration and class requests complete
+			 *  while the application is busy elsewhere; event handlers for control requests run in that interrupt.
 			 *
 			 *  \see \ref Group_Events for more information on the USB events.
 			 *
@@ -182,6 +185,10 @@
 	/* Private Interface - For use in library only: */
 	#if !defined(__DOXYGEN__)
 		/* Function Prototypes: */
+			#if defined(USB_CAN_BE_DEVICE)
+				void USB_DeviceControlTask(void);
+			#endif
+
 			#if defined(__INCLUDE_FROM_USBTASK_C)
 				#if defined(USB_CAN_BE_HOST)
 					static void USB_HostTask(void);
@@ -194,6 +201,7 @@
 
 		/* Macros: */
 			#define HOST_TASK_NONBLOCK_WAIT(CoreID, Duration, NextState) MACROS{ USB_HostState[(CoreID)]   = HOST_STATE_WaitForDevice; \
+			                                                             WaitStartFrame  = HcdGetFrameNumber(CoreID); \
 			                                                             WaitMSRemaining = (Duration);               \
 			                                                             PostWaitState   = (NextState);              }MACROE
 	#endif
@@ -394,6 +394,7 @@
 		#include "Class/AudioClass.h"
 		#include "Class/CDCClass.h"
 		#include "Class/HIDClass.h"
+		#include "Class/HubClass.h"
 		#include "Class/MassStorageClass.h"
 		#include "Class/MIDIClass.h"
 		#include "Class/PrinterClass.h"
@@ -56,7 +56,32 @@
 /** Size of share memory that a device uses to store data transfer to/ receive from host
  *  or a host uses to store data transfer to/ receive from device.
  */
-#define USBRAM_BUFFER_SIZE  			(4*1024)
+#define USBRAM_BUFFER_SIZE  			(8*1024)
+
+/** Number of pipes the host can have open at the same time, summed over every attached device.
+ *  Each device behind a hub takes its own control pipe plus its data pipes, e.g. a hub (control +
+ *  status) with a keyboard (control + report) and two flash drives (control + 2 bulk each) uses 10.
+ *  Bulk and control pipes each take PIPE_MAX_SIZE bytes from USBRAM_BUFFER_SIZE.
+ */
+#define HCD_MAX_ENDPOINT				12
+
+/** Number of general transfer descriptors the host driver has. Every control, bulk and interrupt pipe holds one as
+ *  place holder plus one per transfer it has queued: a control transfer takes up to 3, an interrupt IN stream 1 and a
+ *  CDC receive stream CDC_HOST_RX_TRANSFERS, an RNDIS stream RNDIS_HOST_RX_BUFFERS plus one for its send batch.
+ */
+#define HCD_MAX_GTD						(HCD_MAX_ENDPOINT + 6)
+
+/** Number of queue element transfer descriptors (32 bytes each) the EHCI host driver of the high speed parts has on
+ *  top of HCD_MAX_GTD. A bulk transfer is queued as a chain of qTDs of up to 20 KB each, so that it completes with a
+ *  single interrupt however long it is: a 256 KB MSC READ takes 13 of them.
+ */
+#define HCD_MAX_QTD_CHAIN				16
+
+/** Number of isochronous transfer descriptors (64 bytes each) the OHCI host driver has. Every isochronous pipe
+ *  holds one as place holder plus one per transfer it keeps queued: an audio stream takes AUDIO_HOST_STREAM_TRANSFERS + 1,
+ *  its feedback pipe 3, so capture plus playback with feedback fits in 11.
+ */
+#define HCD_MAX_ITD						12
 
 /** This option effects only on high speed parts that need to test full speed activities */
 #define USB_FORCED_FULLSPEED			0
@@ -64,6 +89,15 @@
 /** Define USE_USB_ROM_STACK = 1 to use MCU's internal ROM stack, 0 if otherwise */
 #define USE_USB_ROM_STACK				0
 
+/** Define USE_FREERTOS_DELAY = 1 to let host delays (port reset, device settle, enumeration waits) sleep
+ *  through vTaskDelay() while the FreeRTOS scheduler is running, 0 to always busy loop.
+ *  Delays taken before the scheduler is started or from an interrupt handler still busy loop.
+ *  Builds without FreeRTOS (e.g. the hostsim benchmark) pass -DUSE_FREERTOS_DELAY=0.
+ */
+#if !defined(USE_FREERTOS_DELAY)
+#define USE_FREERTOS_DELAY				1
+#endif
+
 /** Define the running USB port
  * To select USB port 0(USB0), use 0
  * To select USB port 1(USB1), use 1
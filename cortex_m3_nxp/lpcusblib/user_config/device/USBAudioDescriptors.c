@@ -0,0 +1,289 @@
+/*
+ * USBAudioDescriptors.c
+ *
+ * USB device, configuration and string descriptors of the USB speaker.
+ */
+
+#include "USBAudioDescriptors.h"
+
+/** Device descriptor structure. This descriptor, located in FLASH memory, describes the overall
+ *  device characteristics, including the supported USB version, control endpoint size and the
+ *  number of device configurations. The descriptor is read out by the USB host when the enumeration
+ *  process begins.
+ */
+static const USB_Descriptor_Device_t DeviceDescriptor = {
+	.Header                 = {.Size = sizeof(USB_Descriptor_Device_t), .Type = DTYPE_Device},
+
+	.USBSpecification       = VERSION_BCD(01.10),
+	.Class                  = USB_CSCP_NoDeviceClass,
+	.SubClass               = USB_CSCP_NoDeviceSubclass,
+	.Protocol               = USB_CSCP_NoDeviceProtocol,
+
+	.Endpoint0Size          = FIXED_CONTROL_ENDPOINT_SIZE,
+
+	.VendorID               = 0x1FC9,	/* NXP */
+	.ProductID              = 0x2049,
+	.ReleaseNumber          = VERSION_BCD(01.00),
+
+	.ManufacturerStrIndex   = 0x01,
+	.ProductStrIndex        = 0x02,
+	.SerialNumStrIndex      = NO_DESCRIPTOR,
+
+	.NumberOfConfigurations = FIXED_NUM_CONFIGURATIONS
+};
+
+/** Configuration descriptor structure. This descriptor, located in FLASH memory, describes the usage
+ *  of the device in one of its supported configurations, including information about any device interfaces
+ *  and endpoints. The descriptor is read out by the USB host during the enumeration process when selecting
+ *  a configuration so that the host may correctly communicate with the USB device.
+ */
+static const USB_Descriptor_Configuration_t ConfigurationDescriptor = {
+	.Config = {
+		.Header                   = {.Size = sizeof(USB_Descriptor_Configuration_Header_t), .Type = DTYPE_Configuration},
+
+		.TotalConfigurationSize   = sizeof(USB_Descriptor_Configuration_t),
+		.TotalInterfaces          = 2,
+
+		.ConfigurationNumber      = 1,
+		.ConfigurationStrIndex    = NO_DESCRIPTOR,
+
+		.ConfigAttributes         = USB_CONFIG_ATTR_BUSPOWERED,
+
+		.MaxPowerConsumption      = USB_CONFIG_POWER_MA(100)
+	},
+
+	.Audio_ControlInterface = {
+		.Header                   = {.Size = sizeof(USB_Descriptor_Interface_t), .Type = DTYPE_Interface},
+
+		.InterfaceNumber          = 0,
+		.AlternateSetting         = 0,
+
+		.TotalEndpoints           = 0,
+
+		.Class                    = AUDIO_CSCP_AudioClass,
+		.SubClass                 = AUDIO_CSCP_ControlSubclass,
+		.Protocol                 = AUDIO_CSCP_ControlProtocol,
+
+		.InterfaceStrIndex        = NO_DESCRIPTOR
+	},
+
+	.Audio_ControlInterface_SPC = {
+		.Header                   = {.Size = sizeof(USB_Audio_Descriptor_Interface_AC_t), .Type = DTYPE_CSInterface},
+		.Subtype                  = AUDIO_DSUBTYPE_CSInterface_Header,
+
+		.ACSpecification          = VERSION_BCD(01.00),
+		.TotalLength              = (sizeof(USB_Audio_Descriptor_Interface_AC_t) +
+									 sizeof(USB_Audio_Descriptor_InputTerminal_t) +
+									 sizeof(USB_Audio_Descriptor_OutputTerminal_t)),
+
+		.InCollection             = 1,
+		.InterfaceNumber          = 1,
+	},
+
+	.Audio_InputTerminal = {
+		.Header                   = {.Size = sizeof(USB_Audio_Descriptor_InputTerminal_t), .Type = DTYPE_CSInterface},
+		.Subtype                  = AUDIO_DSUBTYPE_CSInterface_InputTerminal,
+
+		.TerminalID               = 0x01,
+		.TerminalType             = AUDIO_TERMINAL_STREAMING,
+		.AssociatedOutputTerminal = 0x00,
+
+		.TotalChannels            = AUDIO_CHANNELS,
+		.ChannelConfig            = (AUDIO_CHANNEL_LEFT_FRONT | AUDIO_CHANNEL_RIGHT_FRONT),
+
+		.ChannelStrIndex          = NO_DESCRIPTOR,
+		.TerminalStrIndex         = NO_DESCRIPTOR
+	},
+
+	.Audio_OutputTerminal = {
+		.Header                   = {.Size = sizeof(USB_Audio_Descriptor_OutputTerminal_t), .Type = DTYPE_CSInterface},
+		.Subtype                  = AUDIO_DSUBTYPE_CSInterface_OutputTerminal,
+
+		.TerminalID               = 0x02,
+		.TerminalType             = AUDIO_TERMINAL_OUT_SPEAKER,
+		.AssociatedInputTerminal  = 0x00,
+
+		.SourceID                 = 0x01,
+
+		.TerminalStrIndex         = NO_DESCRIPTOR
+	},
+
+	.Audio_StreamInterface_Alt0 = {
+		.Header                   = {.Size = sizeof(USB_Descriptor_Interface_t), .Type = DTYPE_Interface},
+
+		.InterfaceNumber          = 1,
+		.AlternateSetting         = 0,
+
+		.TotalEndpoints           = 0,
+
+		.Class                    = AUDIO_CSCP_AudioClass,
+		.SubClass                 = AUDIO_CSCP_AudioStreamingSubclass,
+		.Protocol                 = AUDIO_CSCP_StreamingProtocol,
+
+		.InterfaceStrIndex        = NO_DESCRIPTOR
+	},
+
+	.Audio_StreamInterface_Alt1 = {
+		.Header                   = {.Size = sizeof(USB_Descriptor_Interface_t), .Type = DTYPE_Interface},
+
+		.InterfaceNumber          = 1,
+		.AlternateSetting         = 1,
+
+		.TotalEndpoints           = 2,
+
+		.Class                    = AUDIO_CSCP_AudioClass,
+		.SubClass                 = AUDIO_CSCP_AudioStreamingSubclass,
+		.Protocol                 = AUDIO_CSCP_StreamingProtocol,
+
+		.InterfaceStrIndex        = NO_DESCRIPTOR
+	},
+
+	.Audio_StreamInterface_SPC = {
+		.Header                   = {.Size = sizeof(USB_Audio_Descriptor_Interface_AS_t), .Type = DTYPE_CSInterface},
+		.Subtype                  = AUDIO_DSUBTYPE_CSInterface_General,
+
+		.TerminalLink             = 0x01,
+
+		.FrameDelay               = 1,
+		.AudioFormat              = 0x0001,	/* PCM */
+	},
+
+	.Audio_AudioFormat = {
+		.Header                   = {.Size = sizeof(USB_Audio_Descriptor_Format_t) +
+											 sizeof(ConfigurationDescriptor.Audio_AudioFormatSampleRates),
+									 .Type = DTYPE_CSInterface},
+		.Subtype                  = AUDIO_DSUBTYPE_CSInterface_FormatType,
+
+		.FormatType               = 0x01,	/* Type I */
+		.Channels                 = AUDIO_CHANNELS,
+
+		.SubFrameSize             = AUDIO_SAMPLE_BYTES,
+		.BitResolution            = AUDIO_SAMPLE_BYTES * 8,
+
+		.TotalDiscreteSampleRates = (sizeof(ConfigurationDescriptor.Audio_AudioFormatSampleRates) / sizeof(USB_Audio_SampleFreq_t)),
+	},
+
+	.Audio_AudioFormatSampleRates = {
+		AUDIO_SAMPLE_FREQ(AUDIO_SAMPLE_FREQUENCY),
+	},
+
+	.Audio_StreamEndpoint = {
+		.Endpoint = {
+			.Header               = {.Size = sizeof(USB_Audio_Descriptor_StreamEndpoint_Std_t), .Type = DTYPE_Endpoint},
+
+			.EndpointAddress      = (ENDPOINT_DIR_OUT | AUDIO_STREAM_EPNUM),
+			.Attributes           = (EP_TYPE_ISOCHRONOUS | ENDPOINT_ATTR_ASYNC | ENDPOINT_USAGE_DATA),
+			.EndpointSize         = AUDIO_STREAM_EPSIZE,
+			.PollingIntervalMS    = 0x01
+		},
+
+		.Refresh                  = 0,
+		.SyncEndpointNumber       = (ENDPOINT_DIR_IN | AUDIO_FEEDBACK_EPNUM)
+	},
+
+	.Audio_StreamEndpoint_SPC = {
+		.Header                   = {.Size = sizeof(USB_Audio_Descriptor_StreamEndpoint_Spc_t), .Type = DTYPE_CSEndpoint},
+		.Subtype                  = AUDIO_DSUBTYPE_CSEndpoint_General,
+
+		.Attributes               = (AUDIO_EP_ACCEPTS_SMALL_PACKETS | AUDIO_EP_SAMPLE_FREQ_CONTROL),
+
+		.LockDelayUnits           = 0x00,
+		.LockDelay                = 0x0000
+	},
+
+	.Audio_FeedbackEndpoint = {
+		.Endpoint = {
+			.Header               = {.Size = sizeof(USB_Audio_Descriptor_StreamEndpoint_Std_t), .Type = DTYPE_Endpoint},
+
+			.EndpointAddress      = (ENDPOINT_DIR_IN | AUDIO_FEEDBACK_EPNUM),
+			.Attributes           = (EP_TYPE_ISOCHRONOUS | ENDPOINT_ATTR_NO_SYNC | ENDPOINT_USAGE_FEEDBACK),
+			.EndpointSize         = AUDIO_DEVICE_FEEDBACK_SIZE,
+			.PollingIntervalMS    = 0x01
+		},
+
+		.Refresh                  = AUDIO_FEEDBACK_REFRESH,
+		.SyncEndpointNumber       = 0
+	}
+};
+
+/** Language descriptor structure. This descriptor, located in FLASH memory, is returned when the host requests
+ *  the string descriptor with index 0 (the first index). It is actually an array of 16-bit integers, which indicate
+ *  via the language ID table available at USB.org what languages the device supports for its string descriptors.
+ */
+static const uint8_t LanguageString[] = {
+	USB_STRING_LEN(1),
+	DTYPE_String,
+	WBVAL(LANGUAGE_ID_ENG),
+};
+
+/** Manufacturer descriptor string. This is a Unicode string containing the manufacturer's details in human readable
+ *  form, and is read out upon request by the host when the appropriate string ID is requested, listed in the Device
+ *  Descriptor.
+ */
+static const uint8_t ManufacturerString[] = {
+	USB_STRING_LEN(3),
+	DTYPE_String,
+	WBVAL('N'), WBVAL('X'), WBVAL('P'),
+};
+
+/** Product descriptor string. This is a Unicode string containing the product's details in human readable form,
+ *  and is read out upon request by the host when the appropriate string ID is requested, listed in the Device
+ *  Descriptor.
+ */
+static const uint8_t ProductString[] = {
+	USB_STRING_LEN(16),
+	DTYPE_String,
+	WBVAL('L'), WBVAL('P'), WBVAL('C'), WBVAL('1'), WBVAL('7'), WBVAL('x'), WBVAL('x'), WBVAL(' '),
+	WBVAL('S'), WBVAL('p'), WBVAL('e'), WBVAL('a'), WBVAL('k'), WBVAL('e'), WBVAL('r'), WBVAL(' '),
+};
+
+/** This function is called by the library when in device mode, and must be overridden (see library "USB Descriptors"
+ *  documentation) by the application code so that the address and size of a requested descriptor can be given
+ *  to the USB library. When the device receives a Get Descriptor request on the control endpoint, this function
+ *  is called so that the descriptor details can be passed back and the appropriate descriptor sent back to the
+ *  USB host.
+ */
+uint16_t CALLBACK_USB_GetDescriptor(const uint16_t wValue,
+									const uint8_t wIndex,
+									const void** const DescriptorAddress)
+{
+	const uint8_t  DescriptorType   = (wValue >> 8);
+	const uint8_t  DescriptorNumber = (wValue & 0xFF);
+
+	const void* Address = NULL;
+	uint16_t    Size    = NO_DESCRIPTOR;
+
+	switch (DescriptorType) {
+	case DTYPE_Device:
+		Address = &DeviceDescriptor;
+		Size    = sizeof(USB_Descriptor_Device_t);
+		break;
+
+	case DTYPE_Configuration:
+		Address = &ConfigurationDescriptor;
+		Size    = sizeof(USB_Descriptor_Configuration_t);
+		break;
+
+	case DTYPE_String:
+		switch (DescriptorNumber) {
+		case 0x00:
+			Address = LanguageString;
+			Size    = sizeof(LanguageString);
+			break;
+
+		case 0x01:
+			Address = ManufacturerString;
+			Size    = sizeof(ManufacturerString);
+			break;
+
+		case 0x02:
+			Address = ProductString;
+			Size    = sizeof(ProductString);
+			break;
+		}
+		break;
+	}
+
+	*DescriptorAddress = Address;
+	return Size;
+}
@@ -0,0 +1,61 @@
+/*
+ * USBAudioDescriptors.h
+ *
+ * USB device, configuration and string descriptors of the USB speaker: an
+ * Audio 1.0 control interface with a USB streaming input terminal and a
+ * speaker output terminal, and a streaming interface whose alternate setting
+ * 1 plays 48 kHz 16-bit stereo through an asynchronous isochronous OUT
+ * endpoint with an explicit feedback endpoint.
+ */
+
+#ifndef USER_CONFIG_DEVICE_USBAUDIODESCRIPTORS_H_
+#define USER_CONFIG_DEVICE_USBAUDIODESCRIPTORS_H_
+
+#include "USB.h"
+
+/* Endpoints of the speaker, taken from the fixed endpoint map of the LPC17xx:
+ * 3 is the only isochronous endpoint within the realized ones, so the stream
+ * takes its OUT half and the feedback its IN half.
+ */
+#define AUDIO_STREAM_EPNUM				3
+#define AUDIO_FEEDBACK_EPNUM			3
+
+/* Stream format. A packet holds the samples of one frame, with room for the
+ * extra sample frame the host sends now and then when asked for a faster rate.
+ */
+#define AUDIO_SAMPLE_FREQUENCY			48000
+#define AUDIO_CHANNELS					2
+#define AUDIO_SAMPLE_BYTES				2
+#define AUDIO_SAMPLE_FRAME_SIZE			(AUDIO_CHANNELS * AUDIO_SAMPLE_BYTES)
+#define AUDIO_STREAM_EPSIZE				(((AUDIO_SAMPLE_FREQUENCY / 1000) + 1) * AUDIO_SAMPLE_FRAME_SIZE)
+
+/* The host reads the feedback every 2^AUDIO_FEEDBACK_REFRESH frames */
+#define AUDIO_FEEDBACK_REFRESH			2
+
+/* Type define for the device configuration descriptor structure */
+typedef struct {
+	USB_Descriptor_Configuration_Header_t     Config;
+
+	/* Audio Control Interface */
+	USB_Descriptor_Interface_t                Audio_ControlInterface;
+	USB_Audio_Descriptor_Interface_AC_t       Audio_ControlInterface_SPC;
+	USB_Audio_Descriptor_InputTerminal_t      Audio_InputTerminal;
+	USB_Audio_Descriptor_OutputTerminal_t     Audio_OutputTerminal;
+
+	/* Audio Streaming Interface */
+	USB_Descriptor_Interface_t                Audio_StreamInterface_Alt0;
+	USB_Descriptor_Interface_t                Audio_StreamInterface_Alt1;
+	USB_Audio_Descriptor_Interface_AS_t       Audio_StreamInterface_SPC;
+	USB_Audio_Descriptor_Format_t             Audio_AudioFormat;
+	USB_Audio_SampleFreq_t                    Audio_AudioFormatSampleRates[1];
+	USB_Audio_Descriptor_StreamEndpoint_Std_t Audio_StreamEndpoint;
+	USB_Audio_Descriptor_StreamEndpoint_Spc_t Audio_StreamEndpoint_SPC;
+	USB_Audio_Descriptor_StreamEndpoint_Std_t Audio_FeedbackEndpoint;
+} USB_Descriptor_Configuration_t;
+
+uint16_t CALLBACK_USB_GetDescriptor(const uint16_t wValue,
+									const uint8_t wIndex,
+									const void** const DescriptorAddress)
+ATTR_WARN_UNUSED_RESULT ATTR_NON_NULL_PTR_ARG(3);
+
+#endif /* USER_CONFIG_DEVICE_USBAUDIODESCRIPTORS_H_ */
@@ -0,0 +1,122 @@
+/*
+ * USBAudioDevice.c
+ *
+ * USB speaker: the host plays 48 kHz 16-bit stereo to the device, which hands
+ * the samples to its output (a DAC) at the rate of its own clock. The host
+ * follows that rate through the feedback endpoint, so the clocks may differ
+ * without samples being dropped or repeated.
+ */
+
+#include <string.h>
+#include "USBAudioDevice.h"
+
+/** LPCUSBlib Audio Class driver interface configuration and state information. This structure is
+ *  passed to all Audio Class driver functions, so that multiple instances of the same class
+ *  within a device can be differentiated from one another.
+ */
+static USB_ClassInfo_Audio_Device_t Speaker_Audio_Interface = {
+	.Config = {
+		.StreamingInterfaceNumber = 1,
+
+		.DataOUTEndpointNumber    = AUDIO_STREAM_EPNUM,
+		.DataOUTEndpointSize      = AUDIO_STREAM_EPSIZE,
+
+		.FeedbackEndpointNumber   = AUDIO_FEEDBACK_EPNUM,
+	},
+};
+
+/* The stream holds the transfers the USB DMA moves the packets in, so it lives in the USB RAM */
+static Audio_Device_Stream_t Speaker_Stream __DATA(USBRAM_SECTION);
+static uint8_t Speaker_FIFO[SPEAKER_FIFO_MS * (AUDIO_SAMPLE_FREQUENCY / 1000) * AUDIO_SAMPLE_FRAME_SIZE] ATTR_ALIGNED(4);
+
+SPEAKER_HANDLE_T *Speaker_DeviceInit(void)
+{
+	/* Silence until the host starts the stream */
+	Speaker_Stream.SampleFrameSize = AUDIO_SAMPLE_FRAME_SIZE;
+
+#if defined(USB_CAN_BE_BOTH)
+	USB_CurrentMode = USB_MODE_Device;
+#endif
+	USB_Init();
+
+	return &Speaker_Audio_Interface;
+}
+
+void Speaker_DeviceTask(void)
+{
+	Audio_Device_USBTask(&Speaker_Audio_Interface);
+	USB_USBTask();
+}
+
+uint16_t Speaker_ReadSamples(int16_t *Buffer, uint16_t Count)
+{
+	return Audio_Device_ReadStreamSamples(&Speaker_Stream, Buffer, Count);
+}
+
+const Audio_Device_Stream_t *Speaker_GetStream(void)
+{
+	return &Speaker_Stream;
+}
+
+/** Event handler for the library USB Configuration Changed event. */
+void EVENT_USB_Device_ConfigurationChanged(void)
+{
+	Audio_Device_ConfigureEndpoints(&Speaker_Audio_Interface);
+}
+
+/** Event handler for the library USB Control Request reception event. */
+void EVENT_USB_Device_ControlRequest(void)
+{
+	Audio_Device_ProcessControlRequest(&Speaker_Audio_Interface);
+}
+
+/** Audio class driver event for the host selecting the alternate setting of the streaming interface. */
+void EVENT_Audio_Device_StreamStartStop(USB_ClassInfo_Audio_Device_t* const AudioInterfaceInfo)
+{
+	if (AudioInterfaceInfo->State.InterfaceEnabled) {
+		Audio_Device_StartStream(AudioInterfaceInfo, &Speaker_Stream, Speaker_FIFO, sizeof(Speaker_FIFO),
+								 AUDIO_SAMPLE_FREQUENCY, AUDIO_SAMPLE_FRAME_SIZE);
+	}
+	else {
+		Audio_Device_StopStream(&Speaker_Stream);
+	}
+}
+
+/** Audio class driver callback for the sampling frequency of the streaming endpoint, the only
+ *  property it has. The speaker plays at a single rate, which the host may only set again.
+ */
+bool CALLBACK_Audio_Device_GetSetEndpointProperty(USB_ClassInfo_Audio_Device_t* const AudioInterfaceInfo,
+												  const uint8_t EndpointProperty,
+												  const uint8_t EndpointAddress,
+												  const uint8_t EndpointControl,
+												  uint16_t* const DataLength,
+												  uint8_t* Data)
+{
+	if ((EndpointAddress != (ENDPOINT_DIR_OUT | AUDIO_STREAM_EPNUM)) ||
+		(EndpointControl != AUDIO_EPCONTROL_SamplingFreq)) {
+		return false;
+	}
+
+	switch (EndpointProperty) {
+	case AUDIO_REQ_SetCurrent:
+		if (DataLength != NULL) {
+			return (*DataLength >= 3) &&
+				   ((((uint32_t) Data[2] << 16) | ((uint32_t) Data[1] << 8) | Data[0]) == AUDIO_SAMPLE_FREQUENCY);
+		}
+		return true;
+
+	case AUDIO_REQ_GetCurrent:
+		if (DataLength != NULL) {
+			if (*DataLength < 3) {
+				return false;
+			}
+			Data[0] = (uint8_t) AUDIO_SAMPLE_FREQUENCY;
+			Data[1] = (uint8_t) (AUDIO_SAMPLE_FREQUENCY >> 8);
+			Data[2] = (uint8_t) (AUDIO_SAMPLE_FREQUENCY >> 16);
+			*DataLength = 3;
+		}
+		return true;
+	}
+
+	return false;
+}
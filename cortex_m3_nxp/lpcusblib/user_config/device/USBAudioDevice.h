@@ -0,0 +1,69 @@
+/*
+ * USBAudioDevice.h
+ *
+ * USB speaker: the host plays 48 kHz 16-bit stereo to the device, which hands
+ * the samples to its output (a DAC) at the rate of its own clock. The host
+ * follows that rate through the feedback endpoint, so the clocks may differ
+ * without samples being dropped or repeated.
+ */
+
+#ifndef USER_CONFIG_DEVICE_USBAUDIODEVICE_H_
+#define USER_CONFIG_DEVICE_USBAUDIODEVICE_H_
+
+#include "USB.h"
+#include "AudioClassDevice.h"
+#include "USBAudioDescriptors.h"
+
+/* Depth of the sample FIFO between the USB interrupt and the output, in ms.
+ * Playback starts once it is half full, so this is twice the latency added.
+ */
+#if !defined(SPEAKER_FIFO_MS)
+#define SPEAKER_FIFO_MS					16
+#endif
+
+/*****************************************************************************
+ * Private types/enumerations/variables
+ ****************************************************************************/
+
+/**
+ * @ingroup Speaker_Device
+ * @{
+ */
+
+typedef USB_ClassInfo_Audio_Device_t SPEAKER_HANDLE_T;
+
+/**
+ * @brief	Connect the speaker to the bus
+ * @return	Handle to the audio interface
+ */
+SPEAKER_HANDLE_T *Speaker_DeviceInit(void);
+
+/**
+ * @brief	Serve the control endpoint
+ * @return	Nothing
+ * @note	Call it from the main loop (or task). The samples themselves are
+ *			moved by the USB interrupt, a few frames at a time.
+ */
+void Speaker_DeviceTask(void);
+
+/**
+ * @brief	Take the next samples to play
+ * @param	Buffer	: Buffer for Count interleaved left and right 16-bit samples
+ * @param	Count	: Number of sample frames to take
+ * @return	Number of sample frames received from the host, the rest is silence
+ * @note	Call it from the output (DAC) interrupt, at the sample rate of the
+ *			device clock. The host is steered to that rate.
+ */
+uint16_t Speaker_ReadSamples(int16_t *Buffer, uint16_t Count);
+
+/**
+ * @brief	State and statistics of the playback stream
+ * @return	Pointer to the stream state, to be read only
+ */
+const Audio_Device_Stream_t *Speaker_GetStream(void);
+
+/**
+ * @}
+ */
+
+#endif /* USER_CONFIG_DEVICE_USBAUDIODEVICE_H_ */
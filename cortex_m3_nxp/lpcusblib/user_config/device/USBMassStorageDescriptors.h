@@ -0,0 +1,35 @@
+/*
+ * USBMassStorageDescriptors.h
+ *
+ * USB device, configuration and string descriptors of the SD card reader:
+ * one Mass Storage Bulk-Only interface with a bulk IN and a bulk OUT endpoint.
+ */
+
+#ifndef USER_CONFIG_DEVICE_USBMASSSTORAGEDESCRIPTORS_H_
+#define USER_CONFIG_DEVICE_USBMASSSTORAGEDESCRIPTORS_H_
+
+#include "USB.h"
+
+/* Endpoints of the mass storage interface. IN and OUT need different numbers
+ * on the LPC17xx, and both must be bulk endpoints of its fixed endpoint map.
+ */
+#define MASS_STORAGE_IN_EPNUM			2
+#define MASS_STORAGE_OUT_EPNUM			5
+#define MASS_STORAGE_IO_EPSIZE			64
+
+/* Type define for the device configuration descriptor structure */
+typedef struct {
+	USB_Descriptor_Configuration_Header_t Config;
+
+	/* Mass Storage Interface */
+	USB_Descriptor_Interface_t            MS_Interface;
+	USB_Descriptor_Endpoint_t             MS_DataInEndpoint;
+	USB_Descriptor_Endpoint_t             MS_DataOutEndpoint;
+} USB_Descriptor_Configuration_t;
+
+uint16_t CALLBACK_USB_GetDescriptor(const uint16_t wValue,
+									const uint8_t wIndex,
+									const void** const DescriptorAddress)
+ATTR_WARN_UNUSED_RESULT ATTR_NON_NULL_PTR_ARG(3);
+
+#endif /* USER_CONFIG_DEVICE_USBMASSSTORAGEDESCRIPTORS_H_ */
@@ -0,0 +1,424 @@
+/*
+ * USBMassStorageDevice.c
+ *
+ * SD card reader: exposes the SD card as a USB Mass Storage (Bulk-Only,
+ * SCSI transparent) device, so that logs written by the application can be
+ * downloaded without taking the card out.
+ */
+
+#include <string.h>
+#include "USBMassStorageDevice.h"
+
+/* SD card */
+#include "diskio.h"
+#include "sdcard.h"
+
+/* Not among the SCSI commands of MassStorageClassCommon.h */
+#define SCSI_CMD_START_STOP_UNIT		0x1B
+
+#define SDMSC_BLOCK_SIZE				SECTOR_SIZE
+#define SDMSC_CHUNK_SIZE				(SDMSC_CHUNK_BLOCKS * SDMSC_BLOCK_SIZE)
+
+/* Sets the sense data reported by the next REQUEST SENSE command */
+#define SDMSC_SET_SENSE(Key, Acode, Aqual)				\
+	do {												\
+		SenseData.SenseKey                 = (Key);		\
+		SenseData.AdditionalSenseCode      = (Acode);	\
+		SenseData.AdditionalSenseQualifier = (Aqual);	\
+	} while (0)
+
+/** LPCUSBlib Mass Storage Class driver interface configuration and state information. This structure is
+ *  passed to all Mass Storage Class driver functions, so that multiple instances of the same class
+ *  within a device can be differentiated from one another. The class driver moves the command blocks
+ *  and statuses in and out of it with the USB DMA, so it lives in the USB RAM.
+ */
+static USB_ClassInfo_MS_Device_t Disk_MS_Interface __DATA(USBRAM_SECTION) = {
+	.Config = {
+		.InterfaceNumber           = 0,
+
+		.DataINEndpointNumber      = MASS_STORAGE_IN_EPNUM,
+		.DataINEndpointSize        = MASS_STORAGE_IO_EPSIZE,
+		.DataINEndpointDoubleBank  = true,
+
+		.DataOUTEndpointNumber     = MASS_STORAGE_OUT_EPNUM,
+		.DataOUTEndpointSize       = MASS_STORAGE_IO_EPSIZE,
+		.DataOUTEndpointDoubleBank = true,
+
+		.TotalLUNs                 = 1,
+	},
+};
+
+/* Chunks of blocks on their way between the card and the bus. The USB DMA
+ * engine only reaches the AHB SRAM, so they live in the USB RAM.
+ */
+PRAGMA_ALIGN_4
+static uint8_t ChunkBuffer[2][SDMSC_CHUNK_SIZE] ATTR_ALIGNED(4) __DATA(USBRAM_SECTION);
+
+/* Structure to hold the sense data for the last issued SCSI command */
+static SCSI_Request_Sense_Response_t SenseData = {
+	.ResponseCode     = 0x70,
+	.AdditionalLength = 0x0A,
+};
+
+/* Structure to hold the SCSI response data to a SCSI INQUIRY command */
+static const SCSI_Inquiry_Response_t InquiryData = {
+	.DeviceType          = 0x00,	/* Direct access block device */
+	.PeripheralQualifier = 0,
+
+	.Removable           = true,
+
+	.Version             = 0,
+
+	.ResponseDataFormat  = 2,
+	.NormACA             = false,
+	.TrmTsk              = false,
+	.AERC                = false,
+
+	.AdditionalLength    = 0x1F,
+
+	.SoftReset           = false,
+	.CmdQue              = false,
+	.Linked              = false,
+	.Sync                = false,
+	.WideBus16Bit        = false,
+	.WideBus32Bit        = false,
+	.RelAddr             = false,
+
+	.VendorID            = "NXP     ",
+	.ProductID           = "SD Card Reader  ",
+	.RevisionID          = {'0', '.', '0', '0'},
+};
+
+DISK_HANDLE_T *SDMSC_DeviceInit(void)
+{
+	/* SD cards take up to 25 MHz in SPI mode, the driver switches to it once the card is initialized */
+	SD_SetClockRate(SDMSC_SPI_CLOCK_HZ);
+	MMC_disk_initialize();
+
+#if defined(USB_CAN_BE_BOTH)
+	USB_CurrentMode = USB_MODE_Device;
+#endif
+	USB_Init();
+
+	return &Disk_MS_Interface;
+}
+
+void SDMSC_DeviceTask(void)
+{
+	MS_Device_USBTask(&Disk_MS_Interface);
+	USB_USBTask();
+}
+
+/** Event handler for the library USB Configuration Changed event. */
+void EVENT_USB_Device_ConfigurationChanged(void)
+{
+	MS_Device_ConfigureEndpoints(&Disk_MS_Interface);
+}
+
+/** Event handler for the library USB Control Request reception event. */
+void EVENT_USB_Device_ControlRequest(void)
+{
+	MS_Device_ProcessControlRequest(&Disk_MS_Interface);
+}
+
+/* Sends a response of a few bytes in the data stage of the current command. It goes out
+ * from a chunk buffer, which is idle outside READ and WRITE commands.
+ */
+static void SDMSC_SendResponse(USB_ClassInfo_MS_Device_t* const MSInterfaceInfo,
+							   const void* Buffer, uint32_t Length)
+{
+	Length = MIN(Length, MSInterfaceInfo->State.CommandBlock.DataTransferLength);
+	if (Length == 0)
+		return;
+
+	memcpy(ChunkBuffer[0], Buffer, Length);
+	Endpoint_Write_DMA_Stream(ChunkBuffer[0], Length);
+
+	MSInterfaceInfo->State.CommandBlock.DataTransferLength -= Length;
+}
+
+/* Waits for the oldest transfer queued on the selected endpoint and takes its bytes off
+ * the data stage residue. Returns false, dropping whatever else is queued, if the host
+ * aborted the command meanwhile or if fewer than Expected bytes were transferred.
+ */
+static bool SDMSC_FinishDMA(USB_ClassInfo_MS_Device_t* const MSInterfaceInfo, uint16_t Expected)
+{
+	uint16_t Transferred;
+
+	while (!Endpoint_IsDMAComplete()) {
+		#if !defined(INTERRUPT_CONTROL_ENDPOINT)
+		USB_USBTask();
+		#endif
+
+		if (MSInterfaceInfo->State.IsMassStoreReset || (USB_DeviceState != DEVICE_STATE_Configured)) {
+			Endpoint_AbortDMA();
+			return false;
+		}
+	}
+
+	Transferred = Endpoint_ReleaseDMA();
+	MSInterfaceInfo->State.CommandBlock.DataTransferLength -= Transferred;
+
+	if (Transferred != Expected) {
+		Endpoint_AbortDMA();
+		return false;
+	}
+
+	return true;
+}
+
+/* Moves blocks from the card to the host. While the USB DMA sends one chunk, the
+ * next chunk is read from the card into the other buffer and queued behind it, so
+ * that the bus goes from one chunk to the next without waiting for the CPU.
+ */
+static bool SDMSC_ReadBlocks(USB_ClassInfo_MS_Device_t* const MSInterfaceInfo,
+							 uint32_t BlockAddress, uint16_t TotalBlocks)
+{
+	uint8_t  Cur = 0;
+	uint16_t InFlight[2] = {0, 0};
+
+	while (TotalBlocks) {
+		uint16_t Blocks = MIN(TotalBlocks, SDMSC_CHUNK_BLOCKS);
+
+		/* The buffer is free once the chunk queued from it before has been sent */
+		if (InFlight[Cur] && !SDMSC_FinishDMA(MSInterfaceInfo, InFlight[Cur]))
+			return false;
+		InFlight[Cur] = 0;
+
+		if (MMC_disk_read(ChunkBuffer[Cur], BlockAddress, Blocks) != RES_OK) {
+			SDMSC_SET_SENSE(SCSI_SENSE_KEY_MEDIUM_ERROR,
+							SCSI_ASENSE_NO_ADDITIONAL_INFORMATION,
+							SCSI_ASENSEQ_NO_QUALIFIER);
+			if (InFlight[Cur ^ 1])
+				SDMSC_FinishDMA(MSInterfaceInfo, InFlight[Cur ^ 1]);
+			return false;
+		}
+
+		Endpoint_StartDMA(ChunkBuffer[Cur], Blocks * SDMSC_BLOCK_SIZE);
+		InFlight[Cur] = Blocks * SDMSC_BLOCK_SIZE;
+
+#if !SDMSC_OVERLAP
+		if (!SDMSC_FinishDMA(MSInterfaceInfo, InFlight[Cur]))
+			return false;
+		InFlight[Cur] = 0;
+#endif
+
+		BlockAddress += Blocks;
+		TotalBlocks  -= Blocks;
+		Cur ^= 1;
+	}
+
+	/* The chunk in the current buffer was queued first */
+	return ((InFlight[Cur] == 0) || SDMSC_FinishDMA(MSInterfaceInfo, InFlight[Cur])) &&
+		   ((InFlight[Cur ^ 1] == 0) || SDMSC_FinishDMA(MSInterfaceInfo, InFlight[Cur ^ 1]));
+}
+
+/* Moves blocks from the host to the card. Both buffers are queued for reception up
+ * front; while one chunk is written to the card the USB DMA receives the next chunk
+ * into the other buffer, and the written buffer is queued again behind it.
+ */
+static bool SDMSC_WriteBlocks(USB_ClassInfo_MS_Device_t* const MSInterfaceInfo,
+							  uint32_t BlockAddress, uint16_t TotalBlocks)
+{
+	uint8_t  Cur = 0;
+	uint16_t InFlight[2] = {0, 0};
+	uint16_t Unqueued = TotalBlocks;
+	uint16_t Blocks;
+
+	InFlight[0] = MIN(Unqueued, SDMSC_CHUNK_BLOCKS) * SDMSC_BLOCK_SIZE;
+	Unqueued   -= InFlight[0] / SDMSC_BLOCK_SIZE;
+#if SDMSC_OVERLAP
+	InFlight[1] = MIN(Unqueued, SDMSC_CHUNK_BLOCKS) * SDMSC_BLOCK_SIZE;
+	Unqueued   -= InFlight[1] / SDMSC_BLOCK_SIZE;
+#endif
+
+	if (InFlight[0])
+		Endpoint_StartDMA(ChunkBuffer[0], InFlight[0]);
+	if (InFlight[1])
+		Endpoint_StartDMA(ChunkBuffer[1], InFlight[1]);
+
+	while (TotalBlocks) {
+		Blocks = InFlight[Cur] / SDMSC_BLOCK_SIZE;
+		if (!SDMSC_FinishDMA(MSInterfaceInfo, InFlight[Cur]))
+			return false;
+		InFlight[Cur] = 0;
+
+		if (MMC_disk_write(ChunkBuffer[Cur], BlockAddress, Blocks) != RES_OK) {
+			SDMSC_SET_SENSE(SCSI_SENSE_KEY_MEDIUM_ERROR,
+							SCSI_ASENSE_NO_ADDITIONAL_INFORMATION,
+							SCSI_ASENSEQ_NO_QUALIFIER);
+			if (InFlight[Cur ^ 1])
+				SDMSC_FinishDMA(MSInterfaceInfo, InFlight[Cur ^ 1]);
+			return false;
+		}
+
+		BlockAddress += Blocks;
+		TotalBlocks  -= Blocks;
+
+		if (Unqueued) {
+			InFlight[Cur] = MIN(Unqueued, SDMSC_CHUNK_BLOCKS) * SDMSC_BLOCK_SIZE;
+			Unqueued     -= InFlight[Cur] / SDMSC_BLOCK_SIZE;
+			Endpoint_StartDMA(ChunkBuffer[Cur], InFlight[Cur]);
+		}
+
+#if SDMSC_OVERLAP
+		Cur ^= 1;
+#endif
+	}
+
+	return true;
+}
+
+/* Decodes the block address and count of a READ(10), WRITE(10) or VERIFY(10) command
+ * and checks them against the card.
+ */
+static bool SDMSC_DecodeBlocks(USB_ClassInfo_MS_Device_t* const MSInterfaceInfo,
+							   uint32_t* BlockAddress, uint16_t* TotalBlocks)
+{
+	const uint8_t* CDB = MSInterfaceInfo->State.CommandBlock.SCSICommandData;
+	DWORD SectorCount;
+
+	*BlockAddress = ((uint32_t) CDB[2] << 24) | ((uint32_t) CDB[3] << 16) | ((uint32_t) CDB[4] << 8) | CDB[5];
+	*TotalBlocks  = ((uint16_t) CDB[7] << 8) | CDB[8];
+
+	if (MMC_disk_ioctl(GET_SECTOR_COUNT, &SectorCount) != RES_OK) {
+		SDMSC_SET_SENSE(SCSI_SENSE_KEY_NOT_READY,
+						SCSI_ASENSE_MEDIUM_NOT_PRESENT,
+						SCSI_ASENSEQ_NO_QUALIFIER);
+		return false;
+	}
+
+	if ((*BlockAddress >= SectorCount) || (*TotalBlocks > (SectorCount - *BlockAddress))) {
+		SDMSC_SET_SENSE(SCSI_SENSE_KEY_ILLEGAL_REQUEST,
+						SCSI_ASENSE_LOGICAL_BLOCK_ADDRESS_OUT_OF_RANGE,
+						SCSI_ASENSEQ_NO_QUALIFIER);
+		return false;
+	}
+
+	return true;
+}
+
+/** Mass Storage class driver callback function the reception of SCSI commands from the host, which must be processed.
+ *
+ *  \param[in] MSInterfaceInfo  Pointer to the Mass Storage class interface configuration structure being referenced
+ */
+bool CALLBACK_MS_Device_SCSICommandReceived(USB_ClassInfo_MS_Device_t* const MSInterfaceInfo)
+{
+	const uint8_t* CDB = MSInterfaceInfo->State.CommandBlock.SCSICommandData;
+	bool     CommandSuccess = false;
+	uint32_t BlockAddress;
+	uint16_t TotalBlocks;
+	DWORD    SectorCount;
+
+	/* Commands that touch the medium fail while there is no initialized card */
+	switch (CDB[0]) {
+	case SCSI_CMD_TEST_UNIT_READY:
+	case SCSI_CMD_READ_CAPACITY_10:
+	case SCSI_CMD_READ_10:
+	case SCSI_CMD_WRITE_10:
+	case SCSI_CMD_VERIFY_10:
+		if (MMC_disk_status() & STA_NOINIT) {
+			SDMSC_SET_SENSE(SCSI_SENSE_KEY_NOT_READY,
+							SCSI_ASENSE_MEDIUM_NOT_PRESENT,
+							SCSI_ASENSEQ_NO_QUALIFIER);
+			return false;
+		}
+		break;
+	}
+
+	switch (CDB[0]) {
+	case SCSI_CMD_INQUIRY:
+		/* Only the standard inquiry data is supported */
+		if ((CDB[1] & 0x03) || CDB[2]) {
+			SDMSC_SET_SENSE(SCSI_SENSE_KEY_ILLEGAL_REQUEST,
+							SCSI_ASENSE_INVALID_FIELD_IN_CDB,
+							SCSI_ASENSEQ_NO_QUALIFIER);
+			break;
+		}
+
+		SDMSC_SendResponse(MSInterfaceInfo, &InquiryData,
+						   MIN(sizeof(InquiryData), ((uint16_t) CDB[3] << 8) | CDB[4]));
+		CommandSuccess = true;
+		break;
+
+	case SCSI_CMD_REQUEST_SENSE:
+		SDMSC_SendResponse(MSInterfaceInfo, &SenseData, MIN(sizeof(SenseData), CDB[4]));
+		CommandSuccess = true;
+		break;
+
+	case SCSI_CMD_READ_CAPACITY_10:
+		if (MMC_disk_ioctl(GET_SECTOR_COUNT, &SectorCount) == RES_OK) {
+			const uint8_t Capacity[8] = {
+				(uint8_t) ((SectorCount - 1) >> 24), (uint8_t) ((SectorCount - 1) >> 16),
+				(uint8_t) ((SectorCount - 1) >> 8),  (uint8_t) (SectorCount - 1),
+				0, 0, (uint8_t) (SDMSC_BLOCK_SIZE >> 8), (uint8_t) SDMSC_BLOCK_SIZE
+			};
+
+			SDMSC_SendResponse(MSInterfaceInfo, Capacity, sizeof(Capacity));
+			CommandSuccess = true;
+		}
+		else {
+			SDMSC_SET_SENSE(SCSI_SENSE_KEY_NOT_READY,
+							SCSI_ASENSE_MEDIUM_NOT_PRESENT,
+							SCSI_ASENSEQ_NO_QUALIFIER);
+		}
+		break;
+
+	case SCSI_CMD_MODE_SENSE_6:
+		{
+			/* Mode parameter header only: no block descriptors nor pages, not write protected */
+			const uint8_t ModeHeader[4] = {0x03, 0x00, 0x00, 0x00};
+
+			SDMSC_SendResponse(MSInterfaceInfo, ModeHeader, MIN(sizeof(ModeHeader), CDB[4]));
+			CommandSuccess = true;
+		}
+		break;
+
+	case SCSI_CMD_READ_10:
+	case SCSI_CMD_WRITE_10:
+		if (!SDMSC_DecodeBlocks(MSInterfaceInfo, &BlockAddress, &TotalBlocks))
+			break;
+
+		/* The host must expect the whole data stage, in the direction of the command */
+		if ((((uint32_t) TotalBlocks * SDMSC_BLOCK_SIZE) > MSInterfaceInfo->State.CommandBlock.DataTransferLength) ||
+			(!(MSInterfaceInfo->State.CommandBlock.Flags & MS_COMMAND_DIR_DATA_IN) != (CDB[0] == SCSI_CMD_WRITE_10))) {
+			SDMSC_SET_SENSE(SCSI_SENSE_KEY_ILLEGAL_REQUEST,
+							SCSI_ASENSE_INVALID_FIELD_IN_CDB,
+							SCSI_ASENSEQ_NO_QUALIFIER);
+			break;
+		}
+
+		if (CDB[0] == SCSI_CMD_READ_10)
+			CommandSuccess = SDMSC_ReadBlocks(MSInterfaceInfo, BlockAddress, TotalBlocks);
+		else
+			CommandSuccess = SDMSC_WriteBlocks(MSInterfaceInfo, BlockAddress, TotalBlocks);
+		break;
+
+	case SCSI_CMD_VERIFY_10:
+		/* The card checks its own data, so only the range is verified */
+		CommandSuccess = SDMSC_DecodeBlocks(MSInterfaceInfo, &BlockAddress, &TotalBlocks);
+		break;
+
+	case SCSI_CMD_TEST_UNIT_READY:
+	case SCSI_CMD_PREVENT_ALLOW_MEDIUM_REMOVAL:
+	case SCSI_CMD_START_STOP_UNIT:
+	case SCSI_CMD_SEND_DIAGNOSTIC:
+		/* Nothing to do for the card */
+		CommandSuccess = true;
+		break;
+
+	default:
+		SDMSC_SET_SENSE(SCSI_SENSE_KEY_ILLEGAL_REQUEST,
+						SCSI_ASENSE_INVALID_COMMAND,
+						SCSI_ASENSEQ_NO_QUALIFIER);
+		break;
+	}
+
+	if (CommandSuccess) {
+		SDMSC_SET_SENSE(SCSI_SENSE_KEY_GOOD,
+						SCSI_ASENSE_NO_ADDITIONAL_INFORMATION,
+						SCSI_ASENSEQ_NO_QUALIFIER);
+	}
+
+	return CommandSuccess;
+}
@@ -0,0 +1,78 @@
+/*
+ * USBMassStorageDevice.h
+ *
+ * SD card reader: exposes the SD card as a USB Mass Storage (Bulk-Only,
+ * SCSI transparent) device, so that logs written by the application can be
+ * downloaded without taking the card out.
+ */
+
+#ifndef USER_CONFIG_DEVICE_USBMASSSTORAGEDEVICE_H_
+#define USER_CONFIG_DEVICE_USBMASSSTORAGEDEVICE_H_
+
+#include "USB.h"
+#include "MassStorageClassDevice.h"
+#include "USBMassStorageDescriptors.h"
+
+/* Blocks moved per SD command and per USB DMA transfer. Two buffers of this
+ * many 512 byte blocks are taken from the USB RAM.
+ */
+#if !defined(SDMSC_CHUNK_BLOCKS)
+#define SDMSC_CHUNK_BLOCKS				8
+#endif
+
+/* A chunk is queued as one Endpoint_StartDMA() transfer, whose length is 16 bits */
+#if (SDMSC_CHUNK_BLOCKS < 1) || (SDMSC_CHUNK_BLOCKS > 127)
+#error SDMSC_CHUNK_BLOCKS must be between 1 and 127
+#endif
+
+/* SSP clock for data transfers once the card is initialized, handed to the
+ * SD driver with SD_SetClockRate(). Its default of 1 MHz is far below what
+ * the card and the 12 Mbit/s bus can carry. The divider of the SSP is
+ * rounded up, so this is an upper bound.
+ */
+#if !defined(SDMSC_SPI_CLOCK_HZ)
+#define SDMSC_SPI_CLOCK_HZ				25000000
+#endif
+
+/* When set, the SD card is read (written) into one buffer while the USB DMA
+ * moves the other one, so that the card and the bus work at the same time.
+ * Clear it to move each chunk across both in turn, e.g. to measure what the
+ * overlap gains.
+ */
+#if !defined(SDMSC_OVERLAP)
+#define SDMSC_OVERLAP					1
+#endif
+
+/*****************************************************************************
+ * Private types/enumerations/variables
+ ****************************************************************************/
+
+/**
+ * @ingroup MassStorage_Device
+ * @{
+ */
+
+typedef USB_ClassInfo_MS_Device_t DISK_HANDLE_T;
+
+/**
+ * @brief	Initialize the SD card and connect the mass storage device to the bus
+ * @return	Handle to the mass storage interface
+ * @note	The device is connected even without a card, and then answers
+ *			the host's commands with MEDIUM NOT PRESENT.
+ */
+DISK_HANDLE_T *SDMSC_DeviceInit(void);
+
+/**
+ * @brief	Serve the mass storage interface and the control endpoint
+ * @return	Nothing
+ * @note	Call it from the main loop (or task) as often as possible. A
+ *			READ(10) or WRITE(10) command is served as a whole from within
+ *			the call.
+ */
+void SDMSC_DeviceTask(void);
+
+/**
+ * @}
+ */
+
+#endif /* USER_CONFIG_DEVICE_USBMASSSTORAGEDEVICE_H_ */
@@ -0,0 +1,46 @@
+/*
+ * USBRNDISDescriptors.h
+ *
+ * USB device, configuration and string descriptors of the USB Ethernet gadget:
+ * one RNDIS adapter, made of a CDC control interface with an interrupt
+ * notification endpoint and a data interface with a bulk IN and a bulk OUT
+ * endpoint.
+ */
+
+#ifndef USER_CONFIG_DEVICE_USBRNDISDESCRIPTORS_H_
+#define USER_CONFIG_DEVICE_USBRNDISDESCRIPTORS_H_
+
+#include "USB.h"
+
+/* Endpoints of the adapter, taken from the fixed endpoint map of the LPC17xx:
+ * 1 is an interrupt endpoint, 2 and 5 are bulk endpoints.
+ */
+#define RNDIS_NOTIFICATION_EPNUM		1
+#define RNDIS_TX_EPNUM					2
+#define RNDIS_RX_EPNUM					5
+#define RNDIS_NOTIFICATION_EPSIZE		8
+#define RNDIS_TXRX_EPSIZE				64
+
+/* Type define for the device configuration descriptor structure */
+typedef struct {
+	USB_Descriptor_Configuration_Header_t Config;
+
+	/* RNDIS Control Interface */
+	USB_Descriptor_Interface_t            CDC_CCI_Interface;
+	USB_CDC_Descriptor_FunctionalHeader_t CDC_Functional_Header;
+	USB_CDC_Descriptor_FunctionalACM_t    CDC_Functional_ACM;
+	USB_CDC_Descriptor_FunctionalUnion_t  CDC_Functional_Union;
+	USB_Descriptor_Endpoint_t             CDC_NotificationEndpoint;
+
+	/* RNDIS Data Interface */
+	USB_Descriptor_Interface_t            RNDIS_DCI_Interface;
+	USB_Descriptor_Endpoint_t             RNDIS_DataOutEndpoint;
+	USB_Descriptor_Endpoint_t             RNDIS_DataInEndpoint;
+} USB_Descriptor_Configuration_t;
+
+uint16_t CALLBACK_USB_GetDescriptor(const uint16_t wValue,
+									const uint8_t wIndex,
+									const void** const DescriptorAddress)
+ATTR_WARN_UNUSED_RESULT ATTR_NON_NULL_PTR_ARG(3);
+
+#endif /* USER_CONFIG_DEVICE_USBRNDISDESCRIPTORS_H_ */
@@ -0,0 +1,232 @@
+/*
+ * USBRNDISDevice.c
+ *
+ * USB Ethernet gadget: an RNDIS adapter through which the host reaches the
+ * services of the device (ARP, ping and the UDP echo service) at its own IP
+ * address.
+ */
+
+#include <string.h>
+#include "USBRNDISDevice.h"
+
+/* Ethernet II header */
+#define ETH_DST							0
+#define ETH_SRC							6
+#define ETH_TYPE						12
+#define ETH_HEADER_SIZE					14
+
+#define ETHERTYPE_IPV4					0x0800
+#define ETHERTYPE_ARP					0x0806
+
+/* ARP for IPv4 over Ethernet, after the Ethernet header */
+#define ARP_OPER						6
+#define ARP_SHA							8
+#define ARP_SPA							14
+#define ARP_THA							18
+#define ARP_TPA							24
+#define ARP_SIZE						28
+
+#define ARP_REQUEST						1
+#define ARP_REPLY						2
+
+/* IPv4 header, after the Ethernet header */
+#define IP_VHL							0
+#define IP_TOTAL_LENGTH					2
+#define IP_PROTOCOL						9
+#define IP_SRC							12
+#define IP_DST							16
+#define IP_HEADER_SIZE					20
+
+#define IP_PROTOCOL_ICMP				1
+#define IP_PROTOCOL_UDP					17
+
+/* ICMP and UDP headers, after the IPv4 header */
+#define ICMP_TYPE						0
+#define ICMP_CHECKSUM					2
+#define ICMP_ECHO_REPLY					0
+#define ICMP_ECHO_REQUEST				8
+
+#define UDP_SRC_PORT					0
+#define UDP_DST_PORT					2
+#define UDP_HEADER_SIZE					8
+
+#define GET_BE16(p)						((uint16_t) (((p)[0] << 8) | (p)[1]))
+#define PUT_BE16(p, v)					do { (p)[0] = (uint8_t) ((v) >> 8); (p)[1] = (uint8_t) (v); } while (0)
+
+static const uint8_t DeviceIPAddress[4]  = RNDIS_DEVICE_IP_ADDRESS;
+static const uint8_t DeviceMACAddress[6] = RNDIS_DEVICE_MAC_ADDRESS;
+static const uint8_t BroadcastMAC[6]     = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+/** LPCUSBlib RNDIS Class driver interface configuration and state information. This structure is
+ *  passed to all RNDIS Class driver functions, so that multiple instances of the same class
+ *  within a device can be differentiated from one another. Its frame pool is where the USB DMA
+ *  moves the frames to and from the host, so it lives in the USB RAM.
+ */
+static USB_ClassInfo_RNDIS_Device_t Ethernet_RNDIS_Interface __DATA(USBRAM_SECTION) = {
+	.Config = {
+		.ControlInterfaceNumber         = 0,
+
+		.DataINEndpointNumber           = RNDIS_TX_EPNUM,
+		.DataINEndpointSize             = RNDIS_TXRX_EPSIZE,
+		.DataINEndpointDoubleBank       = false,
+
+		.DataOUTEndpointNumber          = RNDIS_RX_EPNUM,
+		.DataOUTEndpointSize            = RNDIS_TXRX_EPSIZE,
+		.DataOUTEndpointDoubleBank      = false,
+
+		.NotificationEndpointNumber     = RNDIS_NOTIFICATION_EPNUM,
+		.NotificationEndpointSize       = RNDIS_NOTIFICATION_EPSIZE,
+		.NotificationEndpointDoubleBank = false,
+
+		.AdapterVendorDescription       = "LPCUSBlib RNDIS Adapter",
+		.AdapterMACAddress              = {RNDIS_ADAPTER_MAC_ADDRESS},
+	},
+};
+
+RNDIS_HANDLE_T *RNDIS_DeviceInit(void)
+{
+#if defined(USB_CAN_BE_BOTH)
+	USB_CurrentMode = USB_MODE_Device;
+#endif
+	USB_Init();
+
+	return &Ethernet_RNDIS_Interface;
+}
+
+static void SwapBytes(uint8_t *First, uint8_t *Second, uint8_t Length)
+{
+	uint8_t Byte;
+
+	while (Length--) {
+		Byte      = *First;
+		*First++  = *Second;
+		*Second++ = Byte;
+	}
+}
+
+/* Turns an ARP request for the address of the device into the reply */
+static bool ARP_Answer(uint8_t *Arp, uint16_t Length)
+{
+	if ((Length < ARP_SIZE) || (GET_BE16(&Arp[ARP_OPER]) != ARP_REQUEST) ||
+		memcmp(&Arp[ARP_TPA], DeviceIPAddress, sizeof(DeviceIPAddress))) {
+		return false;
+	}
+
+	PUT_BE16(&Arp[ARP_OPER], ARP_REPLY);
+	memcpy(&Arp[ARP_THA], &Arp[ARP_SHA], 10);
+	memcpy(&Arp[ARP_SHA], DeviceMACAddress, sizeof(DeviceMACAddress));
+	memcpy(&Arp[ARP_SPA], DeviceIPAddress, sizeof(DeviceIPAddress));
+	return true;
+}
+
+/* Turns an echo request (ping, or a datagram to the echo service) for the device
+ * into the reply. Only the addresses, ports and the ICMP type change: swapping
+ * leaves the IP header and UDP checksums as they are, and the ICMP one is adjusted
+ * for the new type (RFC 1624).
+ */
+static bool IP_Answer(uint8_t *Ip, uint16_t Length)
+{
+	uint16_t HeaderLength, TotalLength;
+	uint8_t  *Payload;
+	uint32_t Checksum;
+
+	if ((Length < IP_HEADER_SIZE) || ((Ip[IP_VHL] >> 4) != 4) ||
+		memcmp(&Ip[IP_DST], DeviceIPAddress, sizeof(DeviceIPAddress))) {
+		return false;
+	}
+
+	HeaderLength = (Ip[IP_VHL] & 0x0F) * 4;
+	TotalLength  = GET_BE16(&Ip[IP_TOTAL_LENGTH]);
+	if ((HeaderLength < IP_HEADER_SIZE) || (TotalLength > Length) || (TotalLength < HeaderLength)) {
+		return false;
+	}
+	Payload = &Ip[HeaderLength];
+
+	switch (Ip[IP_PROTOCOL]) {
+	case IP_PROTOCOL_ICMP:
+		if (((TotalLength - HeaderLength) < 4) || (Payload[ICMP_TYPE] != ICMP_ECHO_REQUEST)) {
+			return false;
+		}
+
+		Payload[ICMP_TYPE] = ICMP_ECHO_REPLY;
+		Checksum = GET_BE16(&Payload[ICMP_CHECKSUM]) + (ICMP_ECHO_REQUEST << 8);
+		Checksum = (Checksum & 0xFFFF) + (Checksum >> 16);
+		PUT_BE16(&Payload[ICMP_CHECKSUM], Checksum);
+		break;
+
+	case IP_PROTOCOL_UDP:
+		if (((TotalLength - HeaderLength) < UDP_HEADER_SIZE) || (GET_BE16(&Payload[UDP_DST_PORT]) != RNDIS_ECHO_PORT)) {
+			return false;
+		}
+
+		SwapBytes(&Payload[UDP_SRC_PORT], &Payload[UDP_DST_PORT], 2);
+		break;
+
+	default:
+		return false;
+	}
+
+	SwapBytes(&Ip[IP_SRC], &Ip[IP_DST], sizeof(DeviceIPAddress));
+	return true;
+}
+
+/* Turns a frame from the host into the answer to it, in place; false if it gets none */
+static bool ETH_Answer(RNDIS_Device_Packet_t *Packet)
+{
+	uint8_t *Frame = Packet->Data;
+
+	if ((Packet->Length < ETH_HEADER_SIZE) ||
+		(memcmp(&Frame[ETH_DST], DeviceMACAddress, sizeof(DeviceMACAddress)) &&
+		 memcmp(&Frame[ETH_DST], BroadcastMAC, sizeof(BroadcastMAC)))) {
+		return false;
+	}
+
+	switch (GET_BE16(&Frame[ETH_TYPE])) {
+	case ETHERTYPE_ARP:
+		if (!ARP_Answer(&Frame[ETH_HEADER_SIZE], Packet->Length - ETH_HEADER_SIZE)) {
+			return false;
+		}
+		break;
+
+	case ETHERTYPE_IPV4:
+		if (!IP_Answer(&Frame[ETH_HEADER_SIZE], Packet->Length - ETH_HEADER_SIZE)) {
+			return false;
+		}
+		break;
+
+	default:
+		return false;
+	}
+
+	memcpy(&Frame[ETH_DST], &Frame[ETH_SRC], sizeof(DeviceMACAddress));
+	memcpy(&Frame[ETH_SRC], DeviceMACAddress, sizeof(DeviceMACAddress));
+	return true;
+}
+
+void RNDIS_DeviceTask(void)
+{
+	RNDIS_Device_Packet_t Packet;
+
+	/* Each frame is answered in the buffer it came in, which goes back to the host by reference */
+	while (RNDIS_Device_GetPacket(&Ethernet_RNDIS_Interface, &Packet)) {
+		if (ETH_Answer(&Packet))
+			RNDIS_Device_QueuePacket(&Ethernet_RNDIS_Interface, &Packet);
+		else
+			RNDIS_Device_ReleasePacket(&Ethernet_RNDIS_Interface, &Packet);
+	}
+
+	RNDIS_Device_USBTask(&Ethernet_RNDIS_Interface);
+	USB_USBTask();
+}
+
+/** Event handler for the library USB Configuration Changed event. */
+void EVENT_USB_Device_ConfigurationChanged(void)
+{
+	RNDIS_Device_ConfigureEndpoints(&Ethernet_RNDIS_Interface);
+}
+
+/** Event handler for the library USB Control Request reception event. */
+void EVENT_USB_Device_ControlRequest(void)
+{
+	RNDIS_Device_ProcessControlRequest(&Ethernet_RNDIS_Interface);
+}
@@ -0,0 +1,66 @@
+/*
+ * USBRNDISDevice.h
+ *
+ * USB Ethernet gadget: an RNDIS adapter through which the host reaches the
+ * services of the device (ARP, ping and the UDP echo service) at its own IP
+ * address.
+ */
+
+#ifndef USER_CONFIG_DEVICE_USBRNDISDEVICE_H_
+#define USER_CONFIG_DEVICE_USBRNDISDEVICE_H_
+
+#include "USB.h"
+#include "RNDISClassDevice.h"
+#include "USBRNDISDescriptors.h"
+
+/* IPv4 address of the device, most significant byte first. The host gives its
+ * end of the link an address of the same subnet, e.g. 10.0.0.1/24.
+ */
+#if !defined(RNDIS_DEVICE_IP_ADDRESS)
+#define RNDIS_DEVICE_IP_ADDRESS			{10, 0, 0, 2}
+#endif
+
+/* MAC address of the device on the link, locally administered */
+#if !defined(RNDIS_DEVICE_MAC_ADDRESS)
+#define RNDIS_DEVICE_MAC_ADDRESS		{0x02, 0x00, 0x00, 0x00, 0x00, 0x01}
+#endif
+
+/* MAC address the adapter reports to the host, for its end of the link */
+#if !defined(RNDIS_ADAPTER_MAC_ADDRESS)
+#define RNDIS_ADAPTER_MAC_ADDRESS		{0x02, 0x00, 0x00, 0x00, 0x00, 0x02}
+#endif
+
+/* UDP port of the echo service (RFC 862) */
+#define RNDIS_ECHO_PORT					7
+
+/*****************************************************************************
+ * Private types/enumerations/variables
+ ****************************************************************************/
+
+/**
+ * @ingroup RNDIS_Device
+ * @{
+ */
+
+typedef USB_ClassInfo_RNDIS_Device_t RNDIS_HANDLE_T;
+
+/**
+ * @brief	Connect the adapter to the bus
+ * @return	Handle to the RNDIS interface
+ */
+RNDIS_HANDLE_T *RNDIS_DeviceInit(void);
+
+/**
+ * @brief	Answer the frames from the host, and serve the control endpoint
+ * @return	Nothing
+ * @note	Call it from the main loop (or task) as often as possible. It never
+ *			waits on the host: frames are answered in the buffer they were
+ *			received in, and the replies go out with the next ones queued.
+ */
+void RNDIS_DeviceTask(void);
+
+/**
+ * @}
+ */
+
+#endif /* USER_CONFIG_DEVICE_USBRNDISDEVICE_H_ */
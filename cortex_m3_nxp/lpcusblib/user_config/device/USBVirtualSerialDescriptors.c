@@ -0,0 +1,217 @@
+/*
+ * USBVirtualSerialDescriptors.c
+ *
+ * USB device, configuration and string descriptors of the USB to UART bridge.
+ * None of them is a multiple of the control endpoint size, so no descriptor
+ * needs a zero length packet to end its data stage.
+ */
+
+#include "USBVirtualSerialDescriptors.h"
+
+/** Device descriptor structure. This descriptor, located in FLASH memory, describes the overall
+ *  device characteristics, including the supported USB version, control endpoint size and the
+ *  number of device configurations. The descriptor is read out by the USB host when the enumeration
+ *  process begins.
+ */
+static const USB_Descriptor_Device_t DeviceDescriptor = {
+	.Header                 = {.Size = sizeof(USB_Descriptor_Device_t), .Type = DTYPE_Device},
+
+	.USBSpecification       = VERSION_BCD(01.10),
+	.Class                  = CDC_CSCP_CDCClass,
+	.SubClass               = CDC_CSCP_NoSpecificSubclass,
+	.Protocol               = CDC_CSCP_NoSpecificProtocol,
+
+	.Endpoint0Size          = FIXED_CONTROL_ENDPOINT_SIZE,
+
+	.VendorID               = 0x1FC9,	/* NXP */
+	.ProductID              = 0x2047,
+	.ReleaseNumber          = VERSION_BCD(01.00),
+
+	.ManufacturerStrIndex   = 0x01,
+	.ProductStrIndex        = 0x02,
+	.SerialNumStrIndex      = NO_DESCRIPTOR,
+
+	.NumberOfConfigurations = FIXED_NUM_CONFIGURATIONS
+};
+
+/** Configuration descriptor structure. This descriptor, located in FLASH memory, describes the usage
+ *  of the device in one of its supported configurations, including information about any device interfaces
+ *  and endpoints. The descriptor is read out by the USB host during the enumeration process when selecting
+ *  a configuration so that the host may correctly communicate with the USB device.
+ */
+static const USB_Descriptor_Configuration_t ConfigurationDescriptor = {
+	.Config = {
+		.Header                 = {.Size = sizeof(USB_Descriptor_Configuration_Header_t), .Type = DTYPE_Configuration},
+
+		.TotalConfigurationSize = sizeof(USB_Descriptor_Configuration_t),
+		.TotalInterfaces        = 2,
+
+		.ConfigurationNumber    = 1,
+		.ConfigurationStrIndex  = NO_DESCRIPTOR,
+
+		.ConfigAttributes       = USB_CONFIG_ATTR_BUSPOWERED,
+
+		.MaxPowerConsumption    = USB_CONFIG_POWER_MA(100)
+	},
+
+	.CDC_CCI_Interface = {
+		.Header                 = {.Size = sizeof(USB_Descriptor_Interface_t), .Type = DTYPE_Interface},
+
+		.InterfaceNumber        = 0,
+		.AlternateSetting       = 0,
+
+		.TotalEndpoints         = 1,
+
+		.Class                  = CDC_CSCP_CDCClass,
+		.SubClass               = CDC_CSCP_ACMSubclass,
+		.Protocol               = CDC_CSCP_ATCommandProtocol,
+
+		.InterfaceStrIndex      = NO_DESCRIPTOR
+	},
+
+	.CDC_Functional_Header = {
+		.Header                 = {.Size = sizeof(USB_CDC_Descriptor_FunctionalHeader_t), .Type = DTYPE_CSInterface},
+		.Subtype                = CDC_DSUBTYPE_CSInterface_Header,
+
+		.CDCSpecification       = VERSION_BCD(01.10),
+	},
+
+	.CDC_Functional_ACM = {
+		.Header                 = {.Size = sizeof(USB_CDC_Descriptor_FunctionalACM_t), .Type = DTYPE_CSInterface},
+		.Subtype                = CDC_DSUBTYPE_CSInterface_ACM,
+
+		.Capabilities           = 0x06,	/* SET_LINE_CODING, SET_CONTROL_LINE_STATE and SEND_BREAK */
+	},
+
+	.CDC_Functional_Union = {
+		.Header                 = {.Size = sizeof(USB_CDC_Descriptor_FunctionalUnion_t), .Type = DTYPE_CSInterface},
+		.Subtype                = CDC_DSUBTYPE_CSInterface_Union,
+
+		.MasterInterfaceNumber  = 0,
+		.SlaveInterfaceNumber   = 1,
+	},
+
+	.CDC_NotificationEndpoint = {
+		.Header                 = {.Size = sizeof(USB_Descriptor_Endpoint_t), .Type = DTYPE_Endpoint},
+
+		.EndpointAddress        = (ENDPOINT_DIR_IN | CDC_NOTIFICATION_EPNUM),
+		.Attributes             = (EP_TYPE_INTERRUPT | ENDPOINT_ATTR_NO_SYNC | ENDPOINT_USAGE_DATA),
+		.EndpointSize           = CDC_NOTIFICATION_EPSIZE,
+		.PollingIntervalMS      = 0xFF
+	},
+
+	.CDC_DCI_Interface = {
+		.Header                 = {.Size = sizeof(USB_Descriptor_Interface_t), .Type = DTYPE_Interface},
+
+		.InterfaceNumber        = 1,
+		.AlternateSetting       = 0,
+
+		.TotalEndpoints         = 2,
+
+		.Class                  = CDC_CSCP_CDCDataClass,
+		.SubClass               = CDC_CSCP_NoDataSubclass,
+		.Protocol               = CDC_CSCP_NoDataProtocol,
+
+		.InterfaceStrIndex      = NO_DESCRIPTOR
+	},
+
+	.CDC_DataOutEndpoint = {
+		.Header                 = {.Size = sizeof(USB_Descriptor_Endpoint_t), .Type = DTYPE_Endpoint},
+
+		.EndpointAddress        = (ENDPOINT_DIR_OUT | CDC_RX_EPNUM),
+		.Attributes             = (EP_TYPE_BULK | ENDPOINT_ATTR_NO_SYNC | ENDPOINT_USAGE_DATA),
+		.EndpointSize           = CDC_TXRX_EPSIZE,
+		.PollingIntervalMS      = 0x01
+	},
+
+	.CDC_DataInEndpoint = {
+		.Header                 = {.Size = sizeof(USB_Descriptor_Endpoint_t), .Type = DTYPE_Endpoint},
+
+		.EndpointAddress        = (ENDPOINT_DIR_IN | CDC_TX_EPNUM),
+		.Attributes             = (EP_TYPE_BULK | ENDPOINT_ATTR_NO_SYNC | ENDPOINT_USAGE_DATA),
+		.EndpointSize           = CDC_TXRX_EPSIZE,
+		.PollingIntervalMS      = 0x01
+	}
+};
+
+/** Language descriptor structure. This descriptor, located in FLASH memory, is returned when the host requests
+ *  the string descriptor with index 0 (the first index). It is actually an array of 16-bit integers, which indicate
+ *  via the language ID table available at USB.org what languages the device supports for its string descriptors.
+ */
+static const uint8_t LanguageString[] = {
+	USB_STRING_LEN(1),
+	DTYPE_String,
+	WBVAL(LANGUAGE_ID_ENG),
+};
+
+/** Manufacturer descriptor string. This is a Unicode string containing the manufacturer's details in human readable
+ *  form, and is read out upon request by the host when the appropriate string ID is requested, listed in the Device
+ *  Descriptor.
+ */
+static const uint8_t ManufacturerString[] = {
+	USB_STRING_LEN(3),
+	DTYPE_String,
+	WBVAL('N'), WBVAL('X'), WBVAL('P'),
+};
+
+/** Product descriptor string. This is a Unicode string containing the product's details in human readable form,
+ *  and is read out upon request by the host when the appropriate string ID is requested, listed in the Device
+ *  Descriptor.
+ */
+static const uint8_t ProductString[] = {
+	USB_STRING_LEN(16),
+	DTYPE_String,
+	WBVAL('L'), WBVAL('P'), WBVAL('C'), WBVAL('1'), WBVAL('7'), WBVAL('x'), WBVAL('x'), WBVAL(' '),
+	WBVAL('U'), WBVAL('S'), WBVAL('B'), WBVAL('-'), WBVAL('U'), WBVAL('A'), WBVAL('R'), WBVAL('T'),
+};
+
+/** This function is called by the library when in device mode, and must be overridden (see library "USB Descriptors"
+ *  documentation) by the application code so that the address and size of a requested descriptor can be given
+ *  to the USB library. When the device receives a Get Descriptor request on the control endpoint, this function
+ *  is called so that the descriptor details can be passed back and the appropriate descriptor sent back to the
+ *  USB host.
+ */
+uint16_t CALLBACK_USB_GetDescriptor(const uint16_t wValue,
+									const uint8_t wIndex,
+									const void** const DescriptorAddress)
+{
+	const uint8_t  DescriptorType   = (wValue >> 8);
+	const uint8_t  DescriptorNumber = (wValue & 0xFF);
+
+	const void* Address = NULL;
+	uint16_t    Size    = NO_DESCRIPTOR;
+
+	switch (DescriptorType) {
+	case DTYPE_Device:
+		Address = &DeviceDescriptor;
+		Size    = sizeof(USB_Descriptor_Device_t);
+		break;
+
+	case DTYPE_Configuration:
+		Address = &ConfigurationDescriptor;
+		Size    = sizeof(USB_Descriptor_Configuration_t);
+		break;
+
+	case DTYPE_String:
+		switch (DescriptorNumber) {
+		case 0x00:
+			Address = LanguageString;
+			Size    = sizeof(LanguageString);
+			break;
+
+		case 0x01:
+			Address = ManufacturerString;
+			Size    = sizeof(ManufacturerString);
+			break;
+
+		case 0x02:
+			Address = ProductString;
+			Size    = sizeof(ProductString);
+			break;
+		}
+		break;
+	}
+
+	*DescriptorAddress = Address;
+	return Size;
+}
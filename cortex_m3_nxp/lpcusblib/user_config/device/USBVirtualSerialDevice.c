@@ -0,0 +1,195 @@
+/*
+ * USBVirtualSerialDevice.c
+ *
+ * USB to UART bridge: a CDC ACM virtual COM port whose data goes out of and
+ * comes in on one of the UARTs, at the line coding the host sets.
+ */
+
+#include <string.h>
+#include "USBVirtualSerialDevice.h"
+
+#include "uart.h"
+
+#define VCOM_TX_RING_MASK				(VCOM_TX_RING_SIZE - 1)
+
+#if (VCOM_TX_RING_SIZE & VCOM_TX_RING_MASK)
+#error VCOM_TX_RING_SIZE must be a power of two
+#endif
+
+/** LPCUSBlib CDC Class driver interface configuration and state information. This structure is
+ *  passed to all CDC Class driver functions, so that multiple instances of the same class
+ *  within a device can be differentiated from one another. The class driver moves the data
+ *  in and out of its buffers with the USB DMA, so it lives in the USB RAM.
+ */
+static USB_ClassInfo_CDC_Device_t VCOM_Interface __DATA(USBRAM_SECTION) = {
+	.Config = {
+		.ControlInterfaceNumber         = 0,
+
+		.DataINEndpointNumber           = CDC_TX_EPNUM,
+		.DataINEndpointSize             = CDC_TXRX_EPSIZE,
+		.DataINEndpointDoubleBank       = false,
+
+		.DataOUTEndpointNumber          = CDC_RX_EPNUM,
+		.DataOUTEndpointSize            = CDC_TXRX_EPSIZE,
+		.DataOUTEndpointDoubleBank      = false,
+
+		.NotificationEndpointNumber     = CDC_NOTIFICATION_EPNUM,
+		.NotificationEndpointSize       = CDC_NOTIFICATION_EPSIZE,
+		.NotificationEndpointDoubleBank = false,
+
+		.DataINFlushLatency             = VCOM_FLUSH_LATENCY_MS,
+	},
+};
+
+/* Bytes from the host on their way to the UART. The indexes run freely and are
+ * masked on use; TxTail only moves on once the DMA transfer of the bytes has
+ * ended, so the GPDMA reads them from the ring itself.
+ */
+static uint8_t  TxRing[VCOM_TX_RING_SIZE];
+static uint32_t TxHead;
+static uint32_t TxTail;
+static uint32_t TxInFlight;
+
+VCOM_HANDLE_T *VCOM_DeviceInit(void)
+{
+	UARTInit(VCOM_UART_PORT, VCOM_DEFAULT_BAUDRATE);
+
+#if defined(USB_CAN_BE_BOTH)
+	USB_CurrentMode = USB_MODE_Device;
+#endif
+	USB_Init();
+
+	return &VCOM_Interface;
+}
+
+/* Receives from the host into the free space of the ring and sends the oldest
+ * bytes with the GPDMA, one contiguous run of the ring at a time.
+ */
+static void VCOM_HostToUart(void)
+{
+	uint32_t Offset;
+	uint32_t Contiguous;
+	uint16_t Received;
+
+	if (TxInFlight && !UARTSendDMABusy(VCOM_UART_PORT)) {
+		TxTail    += TxInFlight;
+		TxInFlight = 0;
+	}
+
+	while ((TxHead - TxTail) < VCOM_TX_RING_SIZE) {
+		Offset     = TxHead & VCOM_TX_RING_MASK;
+		Contiguous = MIN(VCOM_TX_RING_SIZE - (TxHead - TxTail), VCOM_TX_RING_SIZE - Offset);
+
+		Received = CDC_Device_ReceiveData(&VCOM_Interface, &TxRing[Offset], MIN(Contiguous, 0xFFFF));
+		if (Received == 0)
+			break;
+		TxHead += Received;
+	}
+
+	if (!TxInFlight && (TxHead != TxTail)) {
+		Offset     = TxTail & VCOM_TX_RING_MASK;
+		Contiguous = MIN(TxHead - TxTail, VCOM_TX_RING_SIZE - Offset);
+		TxInFlight = UARTSendDMA(VCOM_UART_PORT, &TxRing[Offset], Contiguous);
+	}
+}
+
+/* Moves what the UART received into the transmit buffer of the class driver, which
+ * sends it in full packets, or after the latency timer. Only the room left in the
+ * buffer is taken, so that the task never waits for the host to read; the receive
+ * buffer of the UART driver holds the rest meanwhile.
+ */
+static void VCOM_UartToHost(void)
+{
+	uint8_t  Chunk[CDC_TXRX_EPSIZE];
+	uint32_t Room;
+	uint32_t Count;
+
+	/* Nobody reads before the host opens the port */
+	if (!(VCOM_Interface.State.ControlLineStates.HostToDevice & CDC_CONTROL_LINE_OUT_DTR))
+		return;
+
+	Room = CDC_DEVICE_BUFFER_SIZE - VCOM_Interface.State.Transmit.Length;
+	if (Room == 0)
+		return;
+
+	Count = UARTReceive(VCOM_UART_PORT, Chunk, MIN(Room, sizeof(Chunk)));
+	if (Count)
+		CDC_Device_SendData(&VCOM_Interface, (const char *) Chunk, Count);
+}
+
+void VCOM_DeviceTask(void)
+{
+	VCOM_HostToUart();
+	VCOM_UartToHost();
+
+	CDC_Device_USBTask(&VCOM_Interface);
+	USB_USBTask();
+}
+
+/** Event handler for the library USB Configuration Changed event. */
+void EVENT_USB_Device_ConfigurationChanged(void)
+{
+	CDC_Device_ConfigureEndpoints(&VCOM_Interface);
+}
+
+/** Event handler for the library USB Control Request reception event. */
+void EVENT_USB_Device_ControlRequest(void)
+{
+	CDC_Device_ProcessControlRequest(&VCOM_Interface);
+}
+
+/** CDC class driver callback function the processing of changes to the line coding
+ *  sent from the host: the UART takes the same rate and character format. Only the UART
+ *  registers are written, without waiting for the transmitter to drain, so this is fine
+ *  from the control request interrupt when INTERRUPT_CONTROL_ENDPOINT is defined.
+ *
+ *  \param[in] CDCInterfaceInfo  Pointer to the CDC class interface configuration structure being referenced
+ */
+void EVENT_CDC_Device_LineEncodingChanged(USB_ClassInfo_CDC_Device_t* const CDCInterfaceInfo)
+{
+	uint8_t Lcr;
+
+	switch (CDCInterfaceInfo->State.LineEncoding.DataBits) {
+	case 5:
+		Lcr = LCR_WORD_LENGTH_5;
+		break;
+
+	case 6:
+		Lcr = LCR_WORD_LENGTH_6;
+		break;
+
+	case 7:
+		Lcr = LCR_WORD_LENGTH_7;
+		break;
+
+	default:
+		Lcr = LCR_WORD_LENGTH_8;
+		break;
+	}
+
+	switch (CDCInterfaceInfo->State.LineEncoding.ParityType) {
+	case CDC_PARITY_Odd:
+		Lcr |= LCR_PARITY_ENABLE | LCR_PARITY_ODD;
+		break;
+
+	case CDC_PARITY_Even:
+		Lcr |= LCR_PARITY_ENABLE | LCR_PARITY_EVEN;
+		break;
+
+	case CDC_PARITY_Mark:
+		Lcr |= LCR_PARITY_ENABLE | LCR_PARITY_MARK;
+		break;
+
+	case CDC_PARITY_Space:
+		Lcr |= LCR_PARITY_ENABLE | LCR_PARITY_SPACE;
+		break;
+	}
+
+	/* One and a half stop bits are what the UART sends for two with 5 bit words */
+	if (CDCInterfaceInfo->State.LineEncoding.CharFormat != CDC_LINEENCODING_OneStopBit)
+		Lcr |= LCR_STOP_BITS_2;
+
+	if (CDCInterfaceInfo->State.LineEncoding.BaudRateBPS)
+		UARTBaudrate(VCOM_UART_PORT, CDCInterfaceInfo->State.LineEncoding.BaudRateBPS);
+	UARTLineControl(VCOM_UART_PORT, Lcr);
+}
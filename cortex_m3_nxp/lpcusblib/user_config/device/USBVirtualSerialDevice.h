@@ -0,0 +1,69 @@
+/*
+ * USBVirtualSerialDevice.h
+ *
+ * USB to UART bridge: a CDC ACM virtual COM port whose data goes out of and
+ * comes in on one of the UARTs, at the line coding the host sets.
+ */
+
+#ifndef USER_CONFIG_DEVICE_USBVIRTUALSERIALDEVICE_H_
+#define USER_CONFIG_DEVICE_USBVIRTUALSERIALDEVICE_H_
+
+#include "USB.h"
+#include "CDCClassDevice.h"
+#include "USBVirtualSerialDescriptors.h"
+
+/* UART behind the virtual COM port. UART0 usually carries the console. */
+#if !defined(VCOM_UART_PORT)
+#define VCOM_UART_PORT					1
+#endif
+
+/* Line rate until the host sets the line coding */
+#if !defined(VCOM_DEFAULT_BAUDRATE)
+#define VCOM_DEFAULT_BAUDRATE			115200
+#endif
+
+/* Bytes from the host waiting for the UART, a power of two. The GPDMA sends
+ * them straight from the ring while the next ones are received behind them;
+ * once it is full the OUT endpoint NAKs and the host holds back.
+ */
+#if !defined(VCOM_TX_RING_SIZE)
+#define VCOM_TX_RING_SIZE				1024
+#endif
+
+/* Frames (ms) bytes from the UART may wait for more to fill an IN packet, like
+ * the latency timer of USB serial converters. A full packet goes at once.
+ */
+#if !defined(VCOM_FLUSH_LATENCY_MS)
+#define VCOM_FLUSH_LATENCY_MS			4
+#endif
+
+/*****************************************************************************
+ * Private types/enumerations/variables
+ ****************************************************************************/
+
+/**
+ * @ingroup VirtualSerial_Device
+ * @{
+ */
+
+typedef USB_ClassInfo_CDC_Device_t VCOM_HANDLE_T;
+
+/**
+ * @brief	Set up the UART and connect the virtual COM port to the bus
+ * @return	Handle to the CDC interface
+ */
+VCOM_HANDLE_T *VCOM_DeviceInit(void);
+
+/**
+ * @brief	Move data between the host and the UART, and serve the control endpoint
+ * @return	Nothing
+ * @note	Call it from the main loop (or task) as often as possible. It never
+ *			waits on the host nor on the UART.
+ */
+void VCOM_DeviceTask(void);
+
+/**
+ * @}
+ */
+
+#endif /* USER_CONFIG_DEVICE_USBVIRTUALSERIALDEVICE_H_ */
@@ -1,5 +1,6 @@
 #include "USBKeyboardHost.h"
 #include "uart.h"
+#include <string.h>
 
 
 /** LPCUSBlib HID Class driver interface configuration and state information. This structure is
@@ -19,71 +20,228 @@ static USB_ClassInfo_HID_Host_t Keyboard_HID_Interface = {
 	},
 };
 
+/* Raw boot reports, written by the USB interrupt (head) and read by the consumer (tail) */
+static USB_KeyboardReport_Data_t ReportQueue[KEYBOARD_REPORT_QUEUE_SIZE];
+static volatile uint8_t ReportHead;
+static volatile uint8_t ReportTail;
+static volatile uint32_t ReportsDropped;
+static SemaphoreHandle_t ReportSemaphore;
+
+/* Diffing stage state, only touched by the consumer */
+static USB_KeyboardReport_Data_t PreviousReport;
+static KeyboardHost_KeyEvent_t PendingEvents[8 + 2 * 6];
+static uint8_t PendingCount;
+static uint8_t PendingIndex;
+static volatile bool ResetState;
+static volatile bool ReportStreaming;
+
 void usbHostKeyboard(void *pvParameters)
 {
+	ReportSemaphore = xSemaphoreCreateBinary();
+
+#if defined(USB_CAN_BE_BOTH)
 	USB_CurrentMode = USB_MODE_Host;
+#endif
 	USB_Disable();
 	USB_Init();
 
+	/* Reports are queued from the USB interrupt, which must therefore be allowed to call the FreeRTOS API */
+	NVIC_SetPriority(USB_IRQn, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY);
+
 	UARTSendStr(0, "Keyboard Host Demo running.\r\n");
 
+	/* Only enumeration and attach/detach are handled here, key reports never wait for this loop */
 	while (1)
 	{
-		KeyboardHost_Task();
-		HID_Host_USBTask(&Keyboard_HID_Interface);
-		USB_USBTask();
+		KeyboardHost_USBTask();
+	}
+}
+
+/* One pass of the enumeration/attach loop of usbHostKeyboard() */
+void KeyboardHost_USBTask(void)
+{
+	uint8_t HostState;
+
+	HID_Host_USBTask(&Keyboard_HID_Interface);
+	USB_USBTask();
+
+	/* The enumeration steps time their own waits, only an idle or running host is polled slowly */
+	HostState = USB_HostState[Keyboard_HID_Interface.Config.PortNumber];
+	if ((HostState == HOST_STATE_Unattached) || (HostState == HOST_STATE_Configured))
+	{
+		vTaskDelay(KEYBOARD_USB_TASK_PERIOD_MS / portTICK_RATE_MS);
 	}
 }
 
-/* Keyboard management task */
-void KeyboardHost_Task(void)
+/* Key consumer task, prints the characters of pressed keys */
+void KeyboardHost_Task(void *pvParameters)
 {
-	uint8_t KeyCode;
+	KeyboardHost_KeyEvent_t Event;
 
-	if (USB_HostState[Keyboard_HID_Interface.Config.PortNumber] != HOST_STATE_Configured)
+	while (1)
+	{
+		char PressedKey = 0;
+
+		KeyboardHost_GetKeyEvent(&Event, portMAX_DELAY);
+
+		if (!(Event.Pressed))
+		{
+			continue;
+		}
+
+		/* Retrieve pressed key character if alphanumeric */
+		if ((Event.KeyCode >= HID_KEYBOARD_SC_A) && (Event.KeyCode <= HID_KEYBOARD_SC_Z))
+		{
+			PressedKey = (Event.KeyCode - HID_KEYBOARD_SC_A) +
+						 ((Event.Modifiers & (HID_KEYBOARD_MODIFER_LEFTSHIFT | HID_KEYBOARD_MODIFER_RIGHTSHIFT)) ? 'A' : 'a');
+		}
+		else if ((Event.KeyCode >= HID_KEYBOARD_SC_1_AND_EXCLAMATION) &&
+				 (Event.KeyCode  < HID_KEYBOARD_SC_0_AND_CLOSING_PARENTHESIS))
+		{
+			PressedKey = (Event.KeyCode - HID_KEYBOARD_SC_1_AND_EXCLAMATION) + '1';
+		}
+		else if (Event.KeyCode == HID_KEYBOARD_SC_0_AND_CLOSING_PARENTHESIS)
+		{
+			PressedKey = '0';
+		}
+		else if (Event.KeyCode == HID_KEYBOARD_SC_SPACE)
+		{
+			PressedKey = ' ';
+		}
+		else if (Event.KeyCode == HID_KEYBOARD_SC_ENTER)
+		{
+			PressedKey = '\n';
+		}
+
+		if (PressedKey) {
+			UARTPutChar(0, PressedKey);
+		}
+	}
+}
+
+/* Completion callback of the keyboard's IN pipe, runs in the USB interrupt */
+static bool KeyboardHost_ReportReceived(uint32_t PipeHandle, HCD_STATUS Status, uint8_t* Buffer, uint16_t Length)
+{
+	portBASE_TYPE TaskWoken = pdFALSE;
+	uint8_t       Next      = (ReportHead + 1) % KEYBOARD_REPORT_QUEUE_SIZE;
+
+	if (Status != HCD_STATUS_OK)
+	{
+		return false;
+	}
+
+	if (Length < sizeof(USB_KeyboardReport_Data_t))
+	{
+		return true;
+	}
+
+	if (Next == ReportTail)
+	{
+		ReportsDropped++;
+		return true;
+	}
+
+	memcpy(&ReportQueue[ReportHead], Buffer, sizeof(USB_KeyboardReport_Data_t));
+	ReportHead = Next;
+
+	xSemaphoreGiveFromISR(ReportSemaphore, &TaskWoken);
+	portEND_SWITCHING_ISR(TaskWoken);
+
+	return true;
+}
+
+static bool KeyboardHost_HasKey(const USB_KeyboardReport_Data_t* Report, const uint8_t KeyCode)
+{
+	uint8_t i;
+
+	for (i = 0; i < sizeof(Report->KeyCode); i++)
+	{
+		if (Report->KeyCode[i] == KeyCode)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void KeyboardHost_AddEvent(const uint8_t KeyCode, const uint8_t Modifiers, const bool Pressed)
+{
+	PendingEvents[PendingCount].KeyCode   = KeyCode;
+	PendingEvents[PendingCount].Modifiers = Modifiers;
+	PendingEvents[PendingCount].Pressed   = Pressed;
+	PendingCount++;
+}
+
+/* Turns the next report into press and release events, releases first */
+static void KeyboardHost_DiffReport(const USB_KeyboardReport_Data_t* Report)
+{
+	uint8_t Changed = (Report->Modifier ^ PreviousReport.Modifier);
+	uint8_t i;
+
+	PendingCount = PendingIndex = 0;
+
+	/* All six slots reporting ErrorRollOver means too many keys are down, keep the last known state */
+	if (Report->KeyCode[0] == HID_KEYBOARD_SC_ERROR_ROLLOVER)
 	{
 		return;
 	}
 
-	if (HID_Host_IsReportReceived(&Keyboard_HID_Interface))
+	for (i = 0; i < sizeof(Report->KeyCode); i++)
 	{
-		USB_KeyboardReport_Data_t KeyboardReport;
-		HID_Host_ReceiveReport(&Keyboard_HID_Interface, &KeyboardReport);
+		if (PreviousReport.KeyCode[i] && !(KeyboardHost_HasKey(Report, PreviousReport.KeyCode[i])))
+		{
+			KeyboardHost_AddEvent(PreviousReport.KeyCode[i], Report->Modifier, false);
+		}
+	}
 
-		KeyCode = KeyboardReport.KeyCode[0];
+	for (i = 0; i < 8; i++)
+	{
+		if (Changed & (1 << i))
+		{
+			KeyboardHost_AddEvent(HID_KEYBOARD_SC_LEFT_CONTROL + i, Report->Modifier, (Report->Modifier & (1 << i)) != 0);
+		}
+	}
 
-		if (KeyCode)
+	for (i = 0; i < sizeof(Report->KeyCode); i++)
+	{
+		if (Report->KeyCode[i] && !(KeyboardHost_HasKey(&PreviousReport, Report->KeyCode[i])))
 		{
-			char PressedKey = 0;
+			KeyboardHost_AddEvent(Report->KeyCode[i], Report->Modifier, true);
+		}
+	}
 
-			/* Retrieve pressed key character if alphanumeric */
-			if ((KeyCode >= HID_KEYBOARD_SC_A) && (KeyCode <= HID_KEYBOARD_SC_Z))
-			{
-				PressedKey = (KeyCode - HID_KEYBOARD_SC_A) + 'a';
-			}
-			else if ((KeyCode >= HID_KEYBOARD_SC_1_AND_EXCLAMATION) &
-					 (KeyCode  < HID_KEYBOARD_SC_0_AND_CLOSING_PARENTHESIS))
-			{
-				PressedKey = (KeyCode - HID_KEYBOARD_SC_1_AND_EXCLAMATION) + '1';
-			}
-			else if (KeyCode == HID_KEYBOARD_SC_0_AND_CLOSING_PARENTHESIS)
-			{
-				PressedKey = '0';
-			}
-			else if (KeyCode == HID_KEYBOARD_SC_SPACE)
-			{
-				PressedKey = ' ';
-			}
-			else if (KeyCode == HID_KEYBOARD_SC_ENTER)
+	PreviousReport = *Report;
+}
+
+bool KeyboardHost_GetKeyEvent(KeyboardHost_KeyEvent_t* const Event, const portTickType Wait)
+{
+	if (ResetState)
+	{
+		ResetState = false;
+		memset(&PreviousReport, 0x00, sizeof(PreviousReport));
+		PendingCount = PendingIndex = 0;
+	}
+
+	while (PendingIndex == PendingCount)
+	{
+		if (ReportTail == ReportHead)
+		{
+			if (xSemaphoreTake(ReportSemaphore, Wait) != pdTRUE)
 			{
-				PressedKey = '\n';
+				return false;
 			}
 
-			if (PressedKey) {
-				UARTPutChar(0, PressedKey);
-			}
+			continue;
 		}
+
+		KeyboardHost_DiffReport(&ReportQueue[ReportTail]);
+		ReportTail = (ReportTail + 1) % KEYBOARD_REPORT_QUEUE_SIZE;
 	}
+
+	*Event = PendingEvents[PendingIndex++];
+
+	return true;
 }
 
 /* This indicates that a device has been attached to the host,
@@ -98,6 +256,20 @@ void EVENT_USB_Host_DeviceAttached(const uint8_t corenum)
    and stops the library USB task management process. */
 void EVENT_USB_Host_DeviceUnattached(const uint8_t corenum)
 {
+	/* Stop the report stream unless the pipe was already closed with the device */
+	if (ReportStreaming)
+	{
+		uint8_t PrevPipe = Pipe_GetCurrentPipe(corenum);
+
+		ReportStreaming = false;
+		Pipe_SelectPipe(corenum, Keyboard_HID_Interface.Config.DataINPipeNumber);
+		if (Pipe_IsConfigured(corenum))
+		{
+			Pipe_StopINStream(corenum);
+		}
+		Pipe_SelectPipe(corenum, PrevPipe);
+	}
+
 	UARTSendStr(0, "\r\nDevice Unattached on USB port\r\n");
 }
 
@@ -106,19 +278,16 @@ void EVENT_USB_Host_DeviceUnattached(const uint8_t corenum)
    application. */
 void EVENT_USB_Host_DeviceEnumerationComplete(const uint8_t corenum)
 {
-	uint16_t ConfigDescriptorSize;
-	uint8_t  ConfigDescriptorData[512];
+	USB_Host_IndexedConfig_t* Config;
 
-	if (USB_Host_GetDeviceConfigDescriptor(corenum, 1,
-			&ConfigDescriptorSize, ConfigDescriptorData,
-			sizeof(ConfigDescriptorData)) != HOST_GETCONFIG_Successful)
+	if (USB_Host_GetIndexedConfigDescriptor(corenum, 1, &Config) != HOST_GETCONFIG_Successful)
 	{
 		UARTSendStr(0, "Error Retrieving Configuration Descriptor.\r\n");
 		return;
 	}
 
 	Keyboard_HID_Interface.Config.PortNumber = corenum;
-	if (HID_Host_ConfigurePipes(&Keyboard_HID_Interface, ConfigDescriptorSize, ConfigDescriptorData) != HID_ENUMERROR_NoError)
+	if (HID_Host_ConfigurePipesIndexed(&Keyboard_HID_Interface, Config) != HID_ENUMERROR_NoError)
 	{
 		UARTSendStr(0, "Attached Device Not a Valid Keyboard.\r\n");
 		return;
@@ -137,6 +306,16 @@ void EVENT_USB_Host_DeviceEnumerationComplete(const uint8_t corenum)
 		return;
 	}
 
+	/* Let the consumer start over from all keys up */
+	ResetState = true;
+	Pipe_SelectPipe(corenum, Keyboard_HID_Interface.Config.DataINPipeNumber);
+
+	if (!(Pipe_StartINStream(corenum, KeyboardHost_ReportReceived))) {
+		UARTSendStr(0, "Could not Start Report Stream.\r\n");
+		return;
+	}
+	ReportStreaming = true;
+
 	UARTSendStr(0, "Keyboard Enumerated.\r\n");
 }
 
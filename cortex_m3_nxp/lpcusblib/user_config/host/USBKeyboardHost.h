@@ -11,11 +11,31 @@
 #include "LPC17xx.h"
 #include "USB.h"
 
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+/* Raw reports buffered between the USB interrupt and the consumer */
+#define KEYBOARD_REPORT_QUEUE_SIZE		16
+/* Period of the enumeration/attach loop while no device is attached or once it is configured,
+   key reports do not depend on it */
+#define KEYBOARD_USB_TASK_PERIOD_MS		10
+
 /*****************************************************************************
  * Private types/enumerations/variables
  ****************************************************************************/
 
+typedef struct {
+	uint8_t KeyCode;		/* HID_KEYBOARD_SC_*, modifiers as HID_KEYBOARD_SC_LEFT_CONTROL..RIGHT_GUI */
+	uint8_t Modifiers;		/* HID_KEYBOARD_MODIFER_* mask after the event */
+	bool    Pressed;		/* true on press, false on release */
+} KeyboardHost_KeyEvent_t;
+
 void usbHostKeyboard(void *pvParameters);
-void KeyboardHost_Task(void);
+void KeyboardHost_USBTask(void);
+void KeyboardHost_Task(void *pvParameters);
+
+/* Blocks up to Wait ticks for the next key press or release, false on timeout */
+bool KeyboardHost_GetKeyEvent(KeyboardHost_KeyEvent_t* const Event, const portTickType Wait);
 
 #endif /* USER_CONFIG_USBKEYBOARDHOST_H_ */
@@ -177,18 +177,16 @@ void EVENT_USB_Host_DeviceUnattached(const uint8_t corenum)
  */
 void EVENT_USB_Host_DeviceEnumerationComplete(const uint8_t corenum)
 {
-	uint16_t ConfigDescriptorSize;
-	uint8_t  ConfigDescriptorData[512];
+	USB_Host_IndexedConfig_t* Config;
 	uint8_t text[128];
 
-	if (USB_Host_GetDeviceConfigDescriptor(corenum, 1, &ConfigDescriptorSize, ConfigDescriptorData,
-										   sizeof(ConfigDescriptorData)) != HOST_GETCONFIG_Successful) {
+	if (USB_Host_GetIndexedConfigDescriptor(corenum, 1, &Config) != HOST_GETCONFIG_Successful) {
 		UARTSendStr(0, "Error Retrieving Configuration Descriptor.\r\n");
 		return;
 	}
 
 	FlashDisk_MS_Interface.Config.PortNumber = corenum;
-	if (MS_Host_ConfigurePipes(&FlashDisk_MS_Interface, ConfigDescriptorSize, ConfigDescriptorData) != MS_ENUMERROR_NoError) {
+	if (MS_Host_ConfigurePipesIndexed(&FlashDisk_MS_Interface, Config) != MS_ENUMERROR_NoError) {
 		UARTSendStr(0, "Attached Device Not a Valid Mass Storage Device.\r\n");
 		return;
 	}
@@ -311,6 +309,8 @@ int FSUSB_DiskAcquire(DISK_HANDLE_T *hDisk)
 			USB_Host_SetDeviceConfiguration(hDisk->Config.PortNumber, 0);
 			return 0;
 		}
+
+		USB_Host_WaitMS(1);
 	}
 	printf("Done.\r\n");
 
@@ -347,6 +347,23 @@ int FSUSB_DiskReadSectors(DISK_HANDLE_T *hDisk, void *buff, uint32_t secStart, u
 	return 1;
 }
 
+/* Stream sectors to a callback, one chunk at a time */
+int FSUSB_DiskStreamSectors(DISK_HANDLE_T *hDisk, uint32_t secStart, uint32_t numSec,
+							Pipe_StreamChunkCallback_t callback, void *context)
+{
+	while (numSec) {
+		uint16_t cnt = (numSec > 0xFFFF) ? 0xFFFF : numSec;
+
+		if (MS_Host_ReadDeviceBlocksStream(hDisk, 0, secStart, cnt, DiskCapacity.BlockSize, callback, context)) {
+			printf("Error streaming device block.\r\n");
+			return 0;
+		}
+		secStart += cnt;
+		numSec -= cnt;
+	}
+	return 1;
+}
+
 /* Write Sectors */
 int FSUSB_DiskWriteSectors(DISK_HANDLE_T *hDisk, void *buff, uint32_t secStart, uint32_t numSec)
 {
@@ -360,8 +377,15 @@ int FSUSB_DiskWriteSectors(DISK_HANDLE_T *hDisk, void *buff, uint32_t secStart,
 /* Disk ready function */
 int FSUSB_DiskReadyWait(DISK_HANDLE_T *hDisk, int tout)
 {
-	volatile int i = tout * 100;
-	while (i--) {	/* Just delay */
+	uint16_t start = USB_Host_GetFrameNumber();
+
+	/* Poll the unit instead of burning a fixed delay, sleeping between polls under the RTOS.
+	 * The timeout runs on the frame counter, a sleep takes longer than the millisecond it asks for. */
+	while (MS_Host_TestUnitReady(hDisk, 0)) {
+		if ((uint16_t) (USB_Host_GetFrameNumber() - start) >= tout) {
+			return 0;
+		}
+		USB_Host_WaitMS(1);
 	}
 	return 1;
 }
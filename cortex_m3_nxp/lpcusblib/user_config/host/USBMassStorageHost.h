@@ -64,6 +64,20 @@ uint32_t FSUSB_DiskGetSectorSz(DISK_HANDLE_T *hDisk);
  */
 int FSUSB_DiskReadSectors(DISK_HANDLE_T *hDisk, void *buff, uint32_t secStart, uint32_t numSec);
 
+/**
+ * @brief	Streams sectors from USB mass storage disk to a callback
+ * @param	hDisk		: Handle to the USB disk
+ * @param	secStart	: Starting sector from which data be read
+ * @param	numSec		: Number of sectors to be read
+ * @param	callback	: Function called with each chunk of data as soon as it arrives
+ * @param	context		: User pointer passed to the callback
+ * @return	1 on success and 0 on failure
+ * @note	The next chunk is transferred by the host controller while the
+ *			callback processes the current one (see MS_HOST_STREAM_CHUNK_SIZE).
+ */
+int FSUSB_DiskStreamSectors(DISK_HANDLE_T *hDisk, uint32_t secStart, uint32_t numSec,
+							Pipe_StreamChunkCallback_t callback, void *context);
+
 /**
  * @brief	Write data to USB device sectors
  * @param	hDisk		: Handle to the USB disk
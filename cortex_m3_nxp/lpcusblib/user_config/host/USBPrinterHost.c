@@ -0,0 +1,298 @@
+/*
+ * USBPrinterHost.c
+ *
+ * Printer host print spooler: streams print jobs from FatFs files on the SD
+ * card, or from memory, to a USB printer.
+ */
+
+#include "USB.h"
+#include "USBPrinterHost.h"
+#include "PrinterClassHost.h"
+
+/* File System and HAL */
+#include "ff.h"
+#include "uart.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+
+/** LPCUSBlib Printer Class driver interface configuration and state information. This structure is
+ *  passed to all Printer Class driver functions, so that multiple instances of the same class
+ *  within a device can be differentiated from one another.
+ */
+static USB_ClassInfo_PRNT_Host_t Printer_PRNT_Interface = {
+	.Config = {
+		.DataINPipeNumber       = 1,
+		.DataINPipeDoubleBank   = false,
+
+		.DataOUTPipeNumber      = 2,
+		.DataOUTPipeDoubleBank  = false,
+		.PortNumber = 0,
+	},
+};
+
+static FATFS fatFS;	/* File system object */
+static FIL fileObj;	/* File object */
+
+static xQueueHandle jobQueue;
+static volatile bool printerReady;
+
+/* Source of a job read from a file */
+typedef struct {
+	FIL *fp;
+	FRESULT rc;
+} FSPRNT_FILE_T;
+
+/* Source of a job held in memory */
+typedef struct {
+	const uint8_t *data;
+	uint32_t left;
+} FSPRNT_MEMORY_T;
+
+void usbHostPrinter(void *pvParameters)
+{
+	FRESULT rc;
+	uint32_t size;
+	portTickType start;
+	TCHAR path[FSPRNT_PATH_MAX];
+	char debugBuf[64];
+
+	USB_CurrentMode = USB_MODE_Host;
+	USB_Disable();
+	USB_Init();
+
+	UARTSendStr(0, "Printer Host Demo running.\r\n");
+
+	rc = f_mount(&fatFS, FSPRNT_DRIVE, 1);
+	if (rc) {
+		UARTSendStr(0, "Unable to mount the SD card\r\n");
+		while (1);
+	}
+
+	while (1) {
+		FSPRNT_PrinterInsertWait(&Printer_PRNT_Interface);
+
+		/* Keep the bus going between jobs */
+		if (xQueueReceive(jobQueue, path, 10 / portTICK_RATE_MS) != pdTRUE) {
+			PRNT_Host_USBTask(&Printer_PRNT_Interface);
+			USB_USBTask();
+			continue;
+		}
+
+		start = xTaskGetTickCount();
+		if (!FSPRNT_PrintFile(&Printer_PRNT_Interface, path, &size)) {
+			sprintf(debugBuf, "Printing %s failed after %lu bytes.\r\n", path, size);
+			UARTSendStr(0, debugBuf);
+			continue;
+		}
+
+		sprintf(debugBuf, "%s: %lu bytes in %lu ms.\r\n", path, size,
+				(uint32_t) ((xTaskGetTickCount() - start) * portTICK_RATE_MS));
+		UARTSendStr(0, debugBuf);
+	}
+}
+
+/* Keeps the bus going while waiting, the way the pendrive demo does */
+int FSPRNT_PrinterInsertWait(PRINTER_HANDLE_T *hPrinter)
+{
+	while ((USB_HostState[hPrinter->Config.PortNumber] != HOST_STATE_Configured) || !printerReady) {
+		PRNT_Host_USBTask(hPrinter);
+		USB_USBTask();
+	}
+	return 1;
+}
+
+/** Event handler for the USB_DeviceAttached event. This indicates that a device has been attached to the host, and
+ *  starts the library USB task to begin the enumeration and USB management process.
+ */
+void EVENT_USB_Host_DeviceAttached(const uint8_t corenum)
+{
+	printf(("Device Attached on port %d\r\n"), corenum);
+}
+
+/** Event handler for the USB_DeviceUnattached event. This indicates that a device has been removed from the host, and
+ *  stops the library USB task management process.
+ */
+void EVENT_USB_Host_DeviceUnattached(const uint8_t corenum)
+{
+	printerReady = false;
+	printf(("\r\nDevice Unattached on port %d\r\n"), corenum);
+}
+
+/** Event handler for the USB_DeviceEnumerationComplete event. This indicates that a device has been successfully
+ *  enumerated by the host and is now ready to be used by the application.
+ */
+void EVENT_USB_Host_DeviceEnumerationComplete(const uint8_t corenum)
+{
+	USB_Host_IndexedConfig_t* Config;
+	char     DeviceIDString[128];
+
+	if (USB_Host_GetIndexedConfigDescriptor(corenum, 1, &Config) != HOST_GETCONFIG_Successful) {
+		UARTSendStr(0, "Error Retrieving Configuration Descriptor.\r\n");
+		return;
+	}
+
+	if (PRNT_Host_ConfigurePipes(&Printer_PRNT_Interface, Config->ConfigSize, Config->ConfigData) != PRNT_ENUMERROR_NoError) {
+		UARTSendStr(0, "Attached Device Not a Valid Printer Class Device.\r\n");
+		return;
+	}
+
+	if (USB_Host_SetDeviceConfiguration(Printer_PRNT_Interface.Config.PortNumber, 1) != HOST_SENDCONTROL_Successful) {
+		UARTSendStr(0, "Error Setting Device Configuration.\r\n");
+		return;
+	}
+
+	if (PRNT_Host_SetBidirectionalMode(&Printer_PRNT_Interface) != HOST_SENDCONTROL_Successful) {
+		UARTSendStr(0, "Error Setting Bidirectional Mode.\r\n");
+		USB_Host_SetDeviceConfiguration(Printer_PRNT_Interface.Config.PortNumber, 0);
+		return;
+	}
+
+	/* The ID string names the printer languages accepted */
+	if (PRNT_Host_GetDeviceID(&Printer_PRNT_Interface, DeviceIDString, sizeof(DeviceIDString)) == HOST_SENDCONTROL_Successful) {
+		printf("Printer ID: %s\r\n", DeviceIDString);
+	}
+
+	printerReady = true;
+	UARTSendStr(0, "Printer Enumerated.\r\n");
+}
+
+/** Event handler for the USB_HostError event. This indicates that a hardware error occurred while in host mode. */
+void EVENT_USB_Host_HostError(const uint8_t corenum, const uint8_t ErrorCode)
+{
+	USB_Disable();
+
+	printf(("Host Mode Error\r\n"
+			  " -- Error port %d\r\n"
+			  " -- Error Code %d\r\n" ), corenum, ErrorCode);
+
+	for (;; ) {}
+}
+
+/** Event handler for the USB_DeviceEnumerationFailed event. This indicates that a problem occurred while
+ *  enumerating an attached USB device.
+ */
+void EVENT_USB_Host_DeviceEnumerationFailed(const uint8_t corenum,
+											const uint8_t ErrorCode,
+											const uint8_t SubErrorCode)
+{
+	printf(("Dev Enum Error\r\n"
+			  " -- Error port %d\r\n"
+			  " -- Error Code %d\r\n"
+			  " -- Sub Error Code %d\r\n"
+			  " -- In State %d\r\n" ),
+			 corenum, ErrorCode, SubErrorCode, USB_HostState[corenum]);
+}
+
+/**
+ * Dummy callback function for DeviceStandardReq.c,
+ * this way i don't need remove files.
+ */
+uint16_t CALLBACK_USB_GetDescriptor(const uint16_t wValue,
+									const uint8_t wIndex,
+									const void * *const DescriptorAddress)
+{
+	return NO_DESCRIPTOR;
+}
+
+/* Get the printer data structure */
+PRINTER_HANDLE_T *FSPRNT_PrinterInit(void)
+{
+	if (jobQueue == NULL) {
+		jobQueue = xQueueCreate(FSPRNT_JOB_QUEUE_SIZE, FSPRNT_PATH_MAX * sizeof(TCHAR));
+	}
+	return &Printer_PRNT_Interface;
+}
+
+/* Hand a file to the spooler task */
+int FSPRNT_QueueJob(const TCHAR *path, portTickType wait)
+{
+	TCHAR job[FSPRNT_PATH_MAX];
+
+	if ((jobQueue == NULL) || (strlen(path) >= FSPRNT_PATH_MAX)) {
+		return 0;
+	}
+
+	strcpy(job, path);
+	return xQueueSend(jobQueue, job, wait) == pdTRUE;
+}
+
+/* Called for the next block of a file while the previous block is being sent */
+static uint16_t FSPRNT_ReadFile(uint8_t *const buffer, const uint16_t size, void *const context)
+{
+	FSPRNT_FILE_T *f = (FSPRNT_FILE_T *) context;
+	UINT br;
+
+	if (f->rc) {
+		return 0;
+	}
+
+	f->rc = f_read(f->fp, buffer, size, &br);
+	return f->rc ? 0 : br;
+}
+
+/* Called for the next block of a job in memory */
+static uint16_t FSPRNT_ReadMemory(uint8_t *const buffer, const uint16_t size, void *const context)
+{
+	FSPRNT_MEMORY_T *m = (FSPRNT_MEMORY_T *) context;
+	uint16_t n = (m->left < size) ? m->left : size;
+
+	memcpy(buffer, m->data, n);
+	m->data += n;
+	m->left -= n;
+	return n;
+}
+
+/* Print a file */
+int FSPRNT_PrintFile(PRINTER_HANDLE_T *hPrinter, const TCHAR *path, uint32_t *bytesSent)
+{
+	FSPRNT_FILE_T f = { .fp = &fileObj };
+	uint32_t sent;
+	uint8_t err;
+	FRESULT rc;
+
+	if (bytesSent) {
+		*bytesSent = 0;
+	}
+
+	rc = f_open(&fileObj, path, FA_READ);
+	if (rc) {
+		printf("Unable to open %s (%d)\r\n", path, rc);
+		return 0;
+	}
+
+	err = PRNT_Host_SpoolStream(hPrinter, FSPRNT_ReadFile, &f, &sent);
+	f_close(&fileObj);
+
+	if (bytesSent) {
+		*bytesSent = sent;
+	}
+
+	/* A read error ends the job early, the printer has only had part of it */
+	if (err || f.rc) {
+		printf("Error printing %s (USB %d, file %d, port status %02X)\r\n", path, err, f.rc, hPrinter->State.PortStatus);
+		return 0;
+	}
+	return 1;
+}
+
+/* Print a job held in memory */
+int FSPRNT_PrintBuffer(PRINTER_HANDLE_T *hPrinter, const void *data, uint32_t length, uint32_t *bytesSent)
+{
+	FSPRNT_MEMORY_T m = { .data = (const uint8_t *) data, .left = length };
+	uint32_t sent;
+	uint8_t err;
+
+	err = PRNT_Host_SpoolStream(hPrinter, FSPRNT_ReadMemory, &m, &sent);
+
+	if (bytesSent) {
+		*bytesSent = sent;
+	}
+
+	if (err) {
+		printf("Error printing from memory (USB %d, port status %02X)\r\n", err, hPrinter->State.PortStatus);
+		return 0;
+	}
+	return 1;
+}
@@ -0,0 +1,88 @@
+/*
+ * USBPrinterHost.h
+ *
+ * Printer host print spooler: streams print jobs from FatFs files on the SD
+ * card, or from memory, to a USB printer.
+ */
+
+#ifndef USER_CONFIG_HOST_USBPRINTERHOST_H_
+#define USER_CONFIG_HOST_USBPRINTERHOST_H_
+
+#include <string.h>
+#include "ffconf.h"
+#include "ff.h"
+#include "PrinterClassHost.h"
+
+#include "FreeRTOS.h"
+#include "queue.h"
+
+/* Print jobs waiting for the spooler */
+#define FSPRNT_JOB_QUEUE_SIZE			4
+/* Longest path of a queued print job, terminator included */
+#define FSPRNT_PATH_MAX					32
+/* Drive the print jobs are read from */
+#define FSPRNT_DRIVE					"1:"
+
+/*****************************************************************************
+ * Private types/enumerations/variables
+ ****************************************************************************/
+
+/**
+ * @ingroup Printer_Host
+ * @{
+ */
+
+typedef USB_ClassInfo_PRNT_Host_t PRINTER_HANDLE_T;
+
+/**
+ * @brief	Initialize the printer data structure and the job queue
+ * @return	Pointer to the printer data structure
+ * @note	Called before the scheduler starts, so that jobs may be queued
+ *			as soon as the tasks run.
+ */
+PRINTER_HANDLE_T *FSPRNT_PrinterInit(void);
+
+/**
+ * @brief	Wait for a printer to be attached and set to bidirectional mode
+ * @param	hPrinter	: Handle to the printer
+ * @return	1 on success and 0 on failure
+ */
+int FSPRNT_PrinterInsertWait(PRINTER_HANDLE_T *hPrinter);
+
+/**
+ * @brief	Queue a file for the spooler task to print
+ * @param	path	: Path of the file, copied into the queue
+ * @param	wait	: Ticks to wait for room in the queue
+ * @return	1 if the job was queued and 0 otherwise
+ */
+int FSPRNT_QueueJob(const TCHAR *path, portTickType wait);
+
+/**
+ * @brief	Print a file
+ * @param	hPrinter	: Handle to the printer
+ * @param	path		: Path of the file
+ * @param	bytesSent	: Pointer to where the number of bytes printed is written, may be NULL
+ * @return	1 on success and 0 on failure
+ * @note	The file is never held in memory as a whole: it is read with
+ *			f_read() straight into the spool buffers, one block while the
+ *			previous one is on its way to the printer.
+ */
+int FSPRNT_PrintFile(PRINTER_HANDLE_T *hPrinter, const TCHAR *path, uint32_t *bytesSent);
+
+/**
+ * @brief	Print a job held in memory
+ * @param	hPrinter	: Handle to the printer
+ * @param	data		: Pointer to the job
+ * @param	length		: Length of the job in bytes
+ * @param	bytesSent	: Pointer to where the number of bytes printed is written, may be NULL
+ * @return	1 on success and 0 on failure
+ */
+int FSPRNT_PrintBuffer(PRINTER_HANDLE_T *hPrinter, const void *data, uint32_t length, uint32_t *bytesSent);
+
+void usbHostPrinter(void *pvParameters);
+
+/**
+ * @}
+ */
+
+#endif /* USER_CONFIG_HOST_USBPRINTERHOST_H_ */
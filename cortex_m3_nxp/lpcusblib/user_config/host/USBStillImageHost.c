@@ -0,0 +1,364 @@
+/*
+ * USBStillImageHost.c
+ *
+ * Still Image (PTP) camera host: downloads camera objects straight to a
+ * FatFs file on the SD card.
+ */
+
+#include "USB.h"
+#include "USBStillImageHost.h"
+#include "StillImageClassHost.h"
+
+/* File System and HAL */
+#include "ff.h"
+#include "uart.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+/** LPCUSBlib Still Image Class driver interface configuration and state information. This structure is
+ *  passed to all Still Image Class driver functions, so that multiple instances of the same class
+ *  within a device can be differentiated from one another.
+ */
+static USB_ClassInfo_SI_Host_t DigitalCamera_SI_Interface = {
+	.Config = {
+		.DataINPipeNumber       = 1,
+		.DataINPipeDoubleBank   = false,
+
+		.DataOUTPipeNumber      = 2,
+		.DataOUTPipeDoubleBank  = false,
+
+		.EventsPipeNumber       = 3,
+		.EventsPipeDoubleBank   = false,
+		.PortNumber = 0,
+	},
+};
+
+/* Word aligned for the SD card driver, written to the file in whole blocks */
+static uint8_t buffer[FSSI_DOWNLOAD_BUFFER_SIZE] __attribute__ ((aligned(4)));
+static uint32_t objectHandles[FSSI_MAX_OBJECTS];
+
+static FATFS fatFS;	/* File system object */
+static FIL fileObj;	/* File object */
+
+/* State of a download, shared with the chunk callback */
+typedef struct {
+	FIL *fp;
+	uint32_t objectSize;	/* filled in by the class driver before the first chunk */
+	uint32_t fill;			/* bytes waiting in the staging buffer */
+	uint32_t written;		/* bytes written to the file */
+	bool started;
+	FRESULT rc;
+} FSSI_DOWNLOAD_T;
+
+/* State of a GetObjectHandles data phase: a count followed by that many handles */
+typedef struct {
+	uint32_t *handles;
+	uint32_t maxHandles;
+	uint32_t index;			/* word of the array being received, 0 being the count */
+	uint32_t stored;
+	uint8_t word[4];
+	uint8_t wordFill;
+} FSSI_HANDLES_T;
+
+void usbHostCamera(void *pvParameters)
+{
+	FRESULT rc;
+	uint32_t i, numHandles, size;
+	portTickType start;
+	TCHAR path[20];
+	char debugBuf[64];
+
+	USB_CurrentMode = USB_MODE_Host;
+	USB_Disable();
+	USB_Init();
+
+	UARTSendStr(0, "Still Image Host Demo running.\r\n");
+
+	rc = f_mount(&fatFS, FSSI_DRIVE, 1);
+	if (rc) {
+		UARTSendStr(0, "Unable to mount the SD card\r\n");
+		while (1);
+	}
+
+	FSSI_CameraInsertWait(&DigitalCamera_SI_Interface);
+
+	if (!FSSI_GetObjectHandles(&DigitalCamera_SI_Interface, objectHandles, FSSI_MAX_OBJECTS, &numHandles)) {
+		UARTSendStr(0, "Unable to list the camera objects\r\n");
+		while (1);
+	}
+
+	sprintf(debugBuf, "%lu objects on the camera.\r\n", numHandles);
+	UARTSendStr(0, debugBuf);
+
+	for (i = 0; i < numHandles; i++) {
+		sprintf(path, FSSI_DRIVE "%08lX.OBJ", objectHandles[i]);
+
+		start = xTaskGetTickCount();
+		if (!FSSI_DownloadObject(&DigitalCamera_SI_Interface, objectHandles[i], path, &size)) {
+			sprintf(debugBuf, "Download of %s failed after %lu bytes.\r\n", path, size);
+			UARTSendStr(0, debugBuf);
+			continue;
+		}
+
+		sprintf(debugBuf, "%s: %lu bytes in %lu ms.\r\n", path, size,
+				(uint32_t) ((xTaskGetTickCount() - start) * portTICK_RATE_MS));
+		UARTSendStr(0, debugBuf);
+	}
+
+	SI_Host_CloseSession(&DigitalCamera_SI_Interface);
+	UARTSendStr(0, "Example completed.\r\n");
+
+	while (1);
+}
+
+/* Keeps the bus going while waiting, the way the pendrive demo does */
+int FSSI_CameraInsertWait(CAMERA_HANDLE_T *hCamera)
+{
+	while ((USB_HostState[hCamera->Config.PortNumber] != HOST_STATE_Configured) || !hCamera->State.IsSessionOpen) {
+		SI_Host_USBTask(hCamera);
+		USB_USBTask();
+	}
+	return 1;
+}
+
+/** Event handler for the USB_DeviceAttached event. This indicates that a device has been attached to the host, and
+ *  starts the library USB task to begin the enumeration and USB management process.
+ */
+void EVENT_USB_Host_DeviceAttached(const uint8_t corenum)
+{
+	printf(("Device Attached on port %d\r\n"), corenum);
+}
+
+/** Event handler for the USB_DeviceUnattached event. This indicates that a device has been removed from the host, and
+ *  stops the library USB task management process.
+ */
+void EVENT_USB_Host_DeviceUnattached(const uint8_t corenum)
+{
+	printf(("\r\nDevice Unattached on port %d\r\n"), corenum);
+}
+
+/** Event handler for the USB_DeviceEnumerationComplete event. This indicates that a device has been successfully
+ *  enumerated by the host and is now ready to be used by the application.
+ */
+void EVENT_USB_Host_DeviceEnumerationComplete(const uint8_t corenum)
+{
+	USB_Host_IndexedConfig_t* Config;
+
+	if (USB_Host_GetIndexedConfigDescriptor(corenum, 1, &Config) != HOST_GETCONFIG_Successful) {
+		UARTSendStr(0, "Error Retrieving Configuration Descriptor.\r\n");
+		return;
+	}
+
+	if (SI_Host_ConfigurePipes(&DigitalCamera_SI_Interface, Config->ConfigSize, Config->ConfigData) != SI_ENUMERROR_NoError) {
+		UARTSendStr(0, "Attached Device Not a Valid Still Image Class Device.\r\n");
+		return;
+	}
+
+	if (USB_Host_SetDeviceConfiguration(DigitalCamera_SI_Interface.Config.PortNumber, 1) != HOST_SENDCONTROL_Successful) {
+		UARTSendStr(0, "Error Setting Device Configuration.\r\n");
+		return;
+	}
+
+	if (SI_Host_OpenSession(&DigitalCamera_SI_Interface) != PIPE_RWSTREAM_NoError) {
+		UARTSendStr(0, "Could not open PIMA session.\r\n");
+		USB_Host_SetDeviceConfiguration(DigitalCamera_SI_Interface.Config.PortNumber, 0);
+		return;
+	}
+
+	UARTSendStr(0, "Still Image Device Enumerated.\r\n");
+}
+
+/** Event handler for the USB_HostError event. This indicates that a hardware error occurred while in host mode. */
+void EVENT_USB_Host_HostError(const uint8_t corenum, const uint8_t ErrorCode)
+{
+	USB_Disable();
+
+	printf(("Host Mode Error\r\n"
+			  " -- Error port %d\r\n"
+			  " -- Error Code %d\r\n" ), corenum, ErrorCode);
+
+	for (;; ) {}
+}
+
+/** Event handler for the USB_DeviceEnumerationFailed event. This indicates that a problem occurred while
+ *  enumerating an attached USB device.
+ */
+void EVENT_USB_Host_DeviceEnumerationFailed(const uint8_t corenum,
+											const uint8_t ErrorCode,
+											const uint8_t SubErrorCode)
+{
+	printf(("Dev Enum Error\r\n"
+			  " -- Error port %d\r\n"
+			  " -- Error Code %d\r\n"
+			  " -- Sub Error Code %d\r\n"
+			  " -- In State %d\r\n" ),
+			 corenum, ErrorCode, SubErrorCode, USB_HostState[corenum]);
+}
+
+/**
+ * Dummy callback function for DeviceStandardReq.c,
+ * this way i don't need remove files.
+ */
+uint16_t CALLBACK_USB_GetDescriptor(const uint16_t wValue,
+									const uint8_t wIndex,
+									const void * *const DescriptorAddress)
+{
+	return NO_DESCRIPTOR;
+}
+
+/* Get the camera data structure */
+CAMERA_HANDLE_T *FSSI_CameraInit(void)
+{
+	return &DigitalCamera_SI_Interface;
+}
+
+/* Collect the handle array of a GetObjectHandles data phase, whatever the chunk boundaries */
+static void FSSI_HandlesChunk(const uint8_t *const chunk, const uint16_t length, void *const context)
+{
+	FSSI_HANDLES_T *h = (FSSI_HANDLES_T *) context;
+	uint16_t i;
+
+	for (i = 0; i < length; i++) {
+		h->word[h->wordFill++] = chunk[i];
+		if (h->wordFill < sizeof(h->word)) {
+			continue;
+		}
+		h->wordFill = 0;
+
+		/* The first word is the count, the class driver already gives the length of the data */
+		if (h->index++ && (h->stored < h->maxHandles)) {
+			h->handles[h->stored++] = h->word[0] | (h->word[1] << 8) | (h->word[2] << 16) | ((uint32_t) h->word[3] << 24);
+		}
+	}
+}
+
+/* List the objects of all stores */
+int FSSI_GetObjectHandles(CAMERA_HANDLE_T *hCamera, uint32_t *handles, uint32_t maxHandles, uint32_t *numHandles)
+{
+	FSSI_HANDLES_T h = { .handles = handles, .maxHandles = maxHandles };
+	uint32_t params[3] = {CPU_TO_LE32(0xFFFFFFFF), CPU_TO_LE32(0), CPU_TO_LE32(0)};
+
+	*numHandles = 0;
+
+	/* GetObjectHandles, every store, every format, every association */
+	if (SI_Host_SendCommand(hCamera, 0x1007, 3, params) ||
+		SI_Host_ReadDataStream(hCamera, FSSI_HandlesChunk, &h, NULL) ||
+		SI_Host_ReceiveResponse(hCamera)) {
+		printf("Error getting object handles.\r\n");
+		return 0;
+	}
+
+	*numHandles = h.stored;
+	return 1;
+}
+
+/* Write the staging buffer to the file */
+static void FSSI_Flush(FSSI_DOWNLOAD_T *d)
+{
+	UINT bw;
+
+	if (!d->fill || d->rc) {
+		return;
+	}
+
+	d->rc = f_write(d->fp, buffer, d->fill, &bw);
+	if (!d->rc && (bw != d->fill)) {
+		d->rc = FR_DENIED;		/* Volume full */
+	}
+	d->written += bw;
+	d->fill = 0;
+}
+
+/* Called with each chunk of the object while the host controller receives the next one */
+static void FSSI_DownloadChunk(const uint8_t *const chunk, const uint16_t length, void *const context)
+{
+	FSSI_DOWNLOAD_T *d = (FSSI_DOWNLOAD_T *) context;
+	const uint8_t *data = chunk;
+	uint16_t left = length;
+	uint32_t n;
+
+	/* After a write error the rest of the data phase is still received, to keep the session in step */
+	if (d->rc) {
+		return;
+	}
+
+	/* Allocating the whole cluster chain up front keeps the file contiguous where possible and saves
+	 * a FAT update every time a cluster fills */
+	if (!d->started) {
+		d->started = true;
+
+		if (d->objectSize != 0xFFFFFFFF) {
+			if ((d->rc = f_lseek(d->fp, d->objectSize)) == FR_OK) {
+				if (f_tell(d->fp) != d->objectSize) {
+					d->rc = FR_DENIED;	/* Volume full */
+				}
+				else {
+					d->rc = f_lseek(d->fp, 0);
+				}
+			}
+			if (d->rc) {
+				return;
+			}
+		}
+	}
+
+	while (left) {
+		n = FSSI_DOWNLOAD_BUFFER_SIZE - d->fill;
+		if (n > left) {
+			n = left;
+		}
+
+		memcpy(&buffer[d->fill], data, n);
+		d->fill += n;
+		data += n;
+		left -= n;
+
+		if (d->fill == FSSI_DOWNLOAD_BUFFER_SIZE) {
+			FSSI_Flush(d);
+			if (d->rc) {
+				return;
+			}
+		}
+	}
+}
+
+/* Download an object to a file */
+int FSSI_DownloadObject(CAMERA_HANDLE_T *hCamera, uint32_t objectHandle, const TCHAR *path, uint32_t *bytesWritten)
+{
+	FSSI_DOWNLOAD_T d = { .fp = &fileObj, .objectSize = 0xFFFFFFFF };
+	uint8_t err;
+	FRESULT rc;
+
+	if (bytesWritten) {
+		*bytesWritten = 0;
+	}
+
+	rc = f_open(&fileObj, path, FA_WRITE | FA_CREATE_ALWAYS);
+	if (rc) {
+		printf("Unable to create %s (%d)\r\n", path, rc);
+		return 0;
+	}
+
+	err = SI_Host_GetObject(hCamera, objectHandle, FSSI_DownloadChunk, &d, &d.objectSize);
+	FSSI_Flush(&d);
+
+	/* Drop the pre-allocated clusters past what was written */
+	if (err || d.rc || ((d.objectSize != 0xFFFFFFFF) && (d.written != d.objectSize))) {
+		printf("Error downloading object %08lX (USB %d, file %d)\r\n", objectHandle, err, d.rc);
+		if (f_lseek(&fileObj, d.written) == FR_OK) {
+			f_truncate(&fileObj);
+		}
+		f_close(&fileObj);
+		if (bytesWritten) {
+			*bytesWritten = d.written;
+		}
+		return 0;
+	}
+
+	rc = f_close(&fileObj);
+	if (bytesWritten) {
+		*bytesWritten = d.written;
+	}
+	return rc == FR_OK;
+}
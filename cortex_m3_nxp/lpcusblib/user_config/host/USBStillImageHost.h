@@ -0,0 +1,81 @@
+/*
+ * USBStillImageHost.h
+ *
+ * Still Image (PTP) camera host: downloads camera objects straight to a
+ * FatFs file on the SD card.
+ */
+
+#ifndef USER_CONFIG_HOST_USBSTILLIMAGEHOST_H_
+#define USER_CONFIG_HOST_USBSTILLIMAGEHOST_H_
+
+#include <string.h>
+#include "ffconf.h"
+#include "ff.h"
+#include "StillImageClassHost.h"
+
+/* Staging buffer between the USB chunks and f_write(). A power of two of at least
+ * one sector, so that every write starts on a sector and either fills whole
+ * clusters or stays within one. */
+#define FSSI_DOWNLOAD_BUFFER_SIZE		(4 * 1024)
+/* Object handles fetched by the demo */
+#define FSSI_MAX_OBJECTS				64
+/* Drive the objects are downloaded to */
+#define FSSI_DRIVE						"1:"
+
+/*****************************************************************************
+ * Private types/enumerations/variables
+ ****************************************************************************/
+
+/**
+ * @ingroup Still_Image_Host
+ * @{
+ */
+
+typedef USB_ClassInfo_SI_Host_t CAMERA_HANDLE_T;
+
+/**
+ * @brief	Initialize the camera data structure
+ * @return	Pointer to the camera data structure
+ */
+CAMERA_HANDLE_T *FSSI_CameraInit(void);
+
+/**
+ * @brief	Wait for a camera to be attached and its PTP session opened
+ * @param	hCamera	: Handle to the camera
+ * @return	1 on success and 0 on failure
+ */
+int FSSI_CameraInsertWait(CAMERA_HANDLE_T *hCamera);
+
+/**
+ * @brief	Get the handles of the objects held by the camera
+ * @param	hCamera		: Handle to the camera
+ * @param	handles		: Pointer to memory where the handles will be stored
+ * @param	maxHandles	: Number of handles that fit in the memory
+ * @param	numHandles	: Pointer to where the number of handles stored is written
+ * @return	1 on success and 0 on failure
+ * @note	Handles beyond maxHandles are read from the camera and dropped.
+ */
+int FSSI_GetObjectHandles(CAMERA_HANDLE_T *hCamera, uint32_t *handles, uint32_t maxHandles, uint32_t *numHandles);
+
+/**
+ * @brief	Download an object from the camera to a file
+ * @param	hCamera			: Handle to the camera
+ * @param	objectHandle	: Camera handle of the object
+ * @param	path			: Path of the file to create, replaced if it exists
+ * @param	bytesWritten	: Pointer to where the size of the file is written, may be NULL
+ * @return	1 on success and 0 on failure
+ * @note	The object is never held in memory as a whole: the PTP data phase
+ *			arrives in chunks of SI_HOST_STREAM_CHUNK_SIZE, and each full
+ *			FSSI_DOWNLOAD_BUFFER_SIZE block goes to f_write() while the next
+ *			chunk is being received. The file is pre-allocated to the object
+ *			size, and truncated to what was written if the download fails.
+ */
+int FSSI_DownloadObject(CAMERA_HANDLE_T *hCamera, uint32_t objectHandle, const TCHAR *path, uint32_t *bytesWritten);
+
+void usbHostCamera(void *pvParameters);
+
+/**
+ * @}
+ */
+
+#endif /* USER_CONFIG_HOST_USBSTILLIMAGEHOST_H_ */
@@ -0,0 +1,115 @@
+/*
+===============================================================================
+ Name        : cortex_m3_nxp.c
+ Author      : $(author)
+ Version     :
+ Copyright   : $(copyright)
+ Description : main definition
+===============================================================================
+*/
+
+#ifdef __USE_CMSIS
+	#include "LPC17xx.h"
+#endif
+
+#include <cr_section_macros.h>
+#include <stdio.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "uart.h"
+
+#include "USBAudioDevice.h"
+
+/* The DAC is updated from TIMER0 at the sample rate, the samples being taken
+ * from the speaker a millisecond at a time. The timer divides the core clock,
+ * so the output runs a little off 48 kHz (100 MHz / 2083 is 160 ppm fast):
+ * the feedback endpoint makes the host send at that rate.
+ */
+#define DAC_BLOCK_FRAMES		(AUDIO_SAMPLE_FREQUENCY / 1000)
+
+static int16_t DACBlock[DAC_BLOCK_FRAMES * AUDIO_CHANNELS];
+static uint16_t DACIndex = DAC_BLOCK_FRAMES;
+
+void TIMER0_IRQHandler(void)
+{
+	int32_t Mono;
+
+	LPC_TIM0->IR = 1;				/* MR0 interrupt */
+
+	if (DACIndex == DAC_BLOCK_FRAMES) {
+		Speaker_ReadSamples(DACBlock, DAC_BLOCK_FRAMES);
+		DACIndex = 0;
+	}
+
+	/* Mix to mono, and offset to the unsigned 10-bit range of the DAC */
+	Mono = (DACBlock[DACIndex * 2] + DACBlock[DACIndex * 2 + 1]) / 2;
+	LPC_DAC->DACR = ((uint32_t) (Mono + 32768) >> 6) << 6;
+	DACIndex++;
+}
+
+static void DACInit(void)
+{
+	/* P0.26 as AOUT */
+	LPC_PINCON->PINSEL1 = (LPC_PINCON->PINSEL1 & ~(3 << 20)) | (2 << 20);
+	LPC_DAC->DACR = 0x200 << 6;
+
+	/* TIMER0 at the core clock, interrupting and restarting on MR0 */
+	LPC_SC->PCLKSEL0 = (LPC_SC->PCLKSEL0 & ~(3 << 2)) | (1 << 2);
+	LPC_TIM0->TCR = 2;
+	LPC_TIM0->MR0 = (SystemCoreClock / AUDIO_SAMPLE_FREQUENCY) - 1;
+	LPC_TIM0->MCR = 3;
+	LPC_TIM0->TCR = 1;
+
+	NVIC_SetPriority(TIMER0_IRQn, 0);
+	NVIC_EnableIRQ(TIMER0_IRQn);
+}
+
+void blinkLed(void *pvParameters)
+{
+    LPC_GPIO0->FIODIR |= (1<<4);
+
+    while(1)
+    {
+        LPC_GPIO0->FIOSET = (1<<4);
+        vTaskDelay(500/portTICK_RATE_MS);
+        LPC_GPIO0->FIOCLR = (1<<4);
+        vTaskDelay(500/portTICK_RATE_MS);
+    }
+}
+
+void usbDeviceSpeaker(void *pvParameters)
+{
+	Speaker_DeviceInit();
+	DACInit();
+
+	UARTSendStr(0, "USB speaker running at 48 kHz.\r\n");
+
+	while (1) {
+		Speaker_DeviceTask();
+	}
+}
+
+int main(void)
+{
+	SystemCoreClockUpdate();
+
+	/* Initialize UART and Set UART port */
+	LPC_SC->PCLKSEL0 = (LPC_SC->PCLKSEL0 | (1<<4));
+	LPC_SC->PCLKSEL0 = (LPC_SC->PCLKSEL0 | (1<<6));
+	UARTInit(0, 115200);
+
+	/* create task to blink led */
+	xTaskCreate(blinkLed, "ledact", (configMINIMAL_STACK_SIZE / 4), NULL, tskIDLE_PRIORITY, NULL);
+
+	/* Create the task serving the control requests of the host, the samples move in interrupts */
+	xTaskCreate(usbDeviceSpeaker, "usb", (configMINIMAL_STACK_SIZE * 2), NULL, tskIDLE_PRIORITY, NULL);
+
+	/* Start the scheduler. */
+	vTaskStartScheduler();
+
+	while(1);
+
+    return 0 ;
+}
@@ -0,0 +1,87 @@
+/*
+===============================================================================
+ Name        : cortex_m3_nxp.c
+ Author      : $(author)
+ Version     :
+ Copyright   : $(copyright)
+ Description : main definition
+===============================================================================
+*/
+
+#ifdef __USE_CMSIS
+	#include "LPC17xx.h"
+#endif
+
+#include <cr_section_macros.h>
+#include <stdio.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "uart.h"
+#include "diskio.h"
+#include "sdcard.h"
+
+#include "USBMassStorageDevice.h"
+
+void blinkLed(void *pvParameters)
+{
+    LPC_GPIO0->FIODIR |= (1<<4);
+
+    while(1)
+    {
+        LPC_GPIO0->FIOSET = (1<<4);
+        vTaskDelay(500/portTICK_RATE_MS);
+        LPC_GPIO0->FIOCLR = (1<<4);
+        vTaskDelay(500/portTICK_RATE_MS);
+    }
+}
+
+void sdTimerSupport(void *pvParameters)
+{
+	while(1)
+	{
+		disk_timerproc();
+		vTaskDelay(10/portTICK_RATE_MS);
+	}
+}
+
+void usbDeviceMassStorage(void *pvParameters)
+{
+	SDMSC_DeviceInit();
+
+	if (MMC_disk_status() & STA_NOINIT)
+		UARTSendStr(0, "No SD card, the host will see an empty reader.\r\n");
+
+	UARTSendStr(0, "Mass Storage Device Demo running.\r\n");
+
+	while (1) {
+		SDMSC_DeviceTask();
+	}
+}
+
+int main(void)
+{
+	SystemCoreClockUpdate();
+
+	/* Initialize UART and Set UART port */
+	LPC_SC->PCLKSEL0 = (LPC_SC->PCLKSEL0 | (1<<4));
+	LPC_SC->PCLKSEL0 = (LPC_SC->PCLKSEL0 | (1<<6));
+	UARTInit(0, 115200);
+
+	/* create task to blink led */
+	xTaskCreate(blinkLed, "ledact", (configMINIMAL_STACK_SIZE / 4), NULL, tskIDLE_PRIORITY, NULL);
+
+	/* SD card timeouts and card detect */
+	xTaskCreate(sdTimerSupport, "sdtimer", (configMINIMAL_STACK_SIZE / 2), NULL, tskIDLE_PRIORITY + 1, NULL);
+
+	/* Create the task serving the SD card to the USB host */
+	xTaskCreate(usbDeviceMassStorage, "usb", (configMINIMAL_STACK_SIZE * 5), NULL, tskIDLE_PRIORITY, NULL);
+
+	/* Start the scheduler. */
+	vTaskStartScheduler();
+
+	while(1);
+
+    return 0 ;
+}
@@ -0,0 +1,70 @@
+/*
+===============================================================================
+ Name        : cortex_m3_nxp.c
+ Author      : $(author)
+ Version     :
+ Copyright   : $(copyright)
+ Description : main definition
+===============================================================================
+*/
+
+#ifdef __USE_CMSIS
+	#include "LPC17xx.h"
+#endif
+
+#include <cr_section_macros.h>
+#include <stdio.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "uart.h"
+
+#include "USBRNDISDevice.h"
+
+void blinkLed(void *pvParameters)
+{
+    LPC_GPIO0->FIODIR |= (1<<4);
+
+    while(1)
+    {
+        LPC_GPIO0->FIOSET = (1<<4);
+        vTaskDelay(500/portTICK_RATE_MS);
+        LPC_GPIO0->FIOCLR = (1<<4);
+        vTaskDelay(500/portTICK_RATE_MS);
+    }
+}
+
+void usbDeviceEthernet(void *pvParameters)
+{
+	RNDIS_DeviceInit();
+
+	UARTSendStr(0, "USB Ethernet gadget running at 10.0.0.2.\r\n");
+
+	while (1) {
+		RNDIS_DeviceTask();
+	}
+}
+
+int main(void)
+{
+	SystemCoreClockUpdate();
+
+	/* Initialize UART and Set UART port */
+	LPC_SC->PCLKSEL0 = (LPC_SC->PCLKSEL0 | (1<<4));
+	LPC_SC->PCLKSEL0 = (LPC_SC->PCLKSEL0 | (1<<6));
+	UARTInit(0, 115200);
+
+	/* create task to blink led */
+	xTaskCreate(blinkLed, "ledact", (configMINIMAL_STACK_SIZE / 4), NULL, tskIDLE_PRIORITY, NULL);
+
+	/* Create the task answering the host over the USB Ethernet link */
+	xTaskCreate(usbDeviceEthernet, "usb", (configMINIMAL_STACK_SIZE * 3), NULL, tskIDLE_PRIORITY, NULL);
+
+	/* Start the scheduler. */
+	vTaskStartScheduler();
+
+	while(1);
+
+    return 0 ;
+}
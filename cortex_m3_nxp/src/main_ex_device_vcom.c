@@ -0,0 +1,72 @@
+/*
+===============================================================================
+ Name        : cortex_m3_nxp.c
+ Author      : $(author)
+ Version     :
+ Copyright   : $(copyright)
+ Description : main definition
+===============================================================================
+*/
+
+#ifdef __USE_CMSIS
+	#include "LPC17xx.h"
+#endif
+
+#include <cr_section_macros.h>
+#include <stdio.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "uart.h"
+
+#include "USBVirtualSerialDevice.h"
+
+void blinkLed(void *pvParameters)
+{
+    LPC_GPIO0->FIODIR |= (1<<4);
+
+    while(1)
+    {
+        LPC_GPIO0->FIOSET = (1<<4);
+        vTaskDelay(500/portTICK_RATE_MS);
+        LPC_GPIO0->FIOCLR = (1<<4);
+        vTaskDelay(500/portTICK_RATE_MS);
+    }
+}
+
+void usbDeviceVirtualSerial(void *pvParameters)
+{
+	VCOM_DeviceInit();
+
+	UARTSendStr(0, "USB to UART bridge running.\r\n");
+
+	while (1) {
+		VCOM_DeviceTask();
+	}
+}
+
+int main(void)
+{
+	SystemCoreClockUpdate();
+
+	/* Initialize UART and Set UART port */
+	LPC_SC->PCLKSEL0 = (LPC_SC->PCLKSEL0 | (1<<4));
+	LPC_SC->PCLKSEL0 = (LPC_SC->PCLKSEL0 | (1<<6));
+	/* PCLK of the bridged UART at CCLK, for divisors close to the usual rates */
+	LPC_SC->PCLKSEL0 = (LPC_SC->PCLKSEL0 & ~(3<<8)) | (1<<8);
+	UARTInit(0, 115200);
+
+	/* create task to blink led */
+	xTaskCreate(blinkLed, "ledact", (configMINIMAL_STACK_SIZE / 4), NULL, tskIDLE_PRIORITY, NULL);
+
+	/* Create the task bridging the virtual COM port to the UART */
+	xTaskCreate(usbDeviceVirtualSerial, "usb", (configMINIMAL_STACK_SIZE * 3), NULL, tskIDLE_PRIORITY, NULL);
+
+	/* Start the scheduler. */
+	vTaskStartScheduler();
+
+	while(1);
+
+    return 0 ;
+}
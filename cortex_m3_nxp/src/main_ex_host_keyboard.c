@@ -47,9 +47,12 @@ int main(void)
 	/* create task to blink led */
 	xTaskCreate(blinkLed, "ledact", (configMINIMAL_STACK_SIZE / 4), NULL, tskIDLE_PRIORITY, NULL);
 
-	/* Create task to control Pendrive */
+	/* Create task to control Keyboard */
 	xTaskCreate(usbHostKeyboard, "usb", (configMINIMAL_STACK_SIZE * 5), NULL, tskIDLE_PRIORITY, NULL);
 
+	/* Key consumer, above the USB task so that key events are handled as soon as a report arrives */
+	xTaskCreate(KeyboardHost_Task, "keys", (configMINIMAL_STACK_SIZE * 2), NULL, (tskIDLE_PRIORITY + 1), NULL);
+
 	/* Start the scheduler. */
 	vTaskStartScheduler();
 
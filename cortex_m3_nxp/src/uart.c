@@ -1,12 +1,19 @@
 /***********************************************************************
  * $Id::                                                               $
  *
- * Project:	uart: Simple UART echo for LPCXpresso 1700
+ * Project:	uart: UART0 to UART3 driver for LPCXpresso 1700
  * File:	uart.c
  * Description:
+ * 			Interrupt driven driver for the four UARTs, each port
+ * 			described by the same register, IRQ and buffer tables.
+ * 			Received characters go to a ring buffer with error
+ * 			counts, transmitted ones are queued in a ring that the
+ * 			THRE interrupt drains a FIFO burst at a time. The GPDMA
+ * 			can take over either direction of a port: a channel
+ * 			drains the transmit ring, another goes round a two half
+ * 			receive buffer, and UARTSendDMA() sends a single block.
  * 			LPCXpresso Baseboard uses pins mapped to UART3 for
- * 			its USB-to-UART bridge. This application simply echos
- * 			all characters received.
+ * 			its USB-to-UART bridge.
  *
  ***********************************************************************
  * Software that is described herein is for illustrative purposes only
@@ -33,43 +40,380 @@
 #include "string.h"
 #include "uart.h"
 
-UARTFifo_t UART0Buffer, UART1Buffer, UART3Buffer;
+#define UART_PORTS		4
 
-static uint8_t fifo_put(UARTFifo_t *fifo, uint8_t c)
+/* The buffers of the ports the application gave some (see uart.h) */
+#define UART_BUFFERS(n) \
+	static uint8_t UART##n##RxData[UART##n##_BUFSIZE]; \
+	static uint8_t UART##n##TxData[UART##n##_TX_BUFSIZE]; \
+	UARTFifo_t UART##n##Buffer = { UART##n##RxData, UART##n##_BUFSIZE - 1 }; \
+	UARTTxFifo_t UART##n##TxBuffer = { UART##n##TxData, UART##n##_TX_BUFSIZE - 1 };
+
+#if UART0_BUFSIZE
+UART_BUFFERS(0)
+#define UART0_BUFFERS	&UART0Buffer, &UART0TxBuffer
+#else
+#define UART0_BUFFERS	NULL, NULL
+#endif
+#if UART1_BUFSIZE
+UART_BUFFERS(1)
+#define UART1_BUFFERS	&UART1Buffer, &UART1TxBuffer
+#else
+#define UART1_BUFFERS	NULL, NULL
+#endif
+#if UART2_BUFSIZE
+UART_BUFFERS(2)
+#define UART2_BUFFERS	&UART2Buffer, &UART2TxBuffer
+#else
+#define UART2_BUFFERS	NULL, NULL
+#endif
+#if UART3_BUFSIZE
+UART_BUFFERS(3)
+#define UART3_BUFFERS	&UART3Buffer, &UART3TxBuffer
+#else
+#define UART3_BUFFERS	NULL, NULL
+#endif
+
+/* The interrupt handlers pass their port as a constant: what they call is
+ * inlined into each, so registers and buffers are fixed addresses there */
+#define UART_FAST		static inline __attribute__((always_inline))
+
+/* What tells the ports apart, besides the registers (see uart_regs()) */
+typedef struct {
+	UARTFifo_t *rx;				/* NULL, as tx, for a port left out */
+	UARTTxFifo_t *tx;
+	IRQn_Type irq;
+	uint8_t pclksel;			/* PCLKSEL0 or PCLKSEL1 */
+	uint8_t pclk_shift;
+	uint32_t pconp;
+	uint8_t pinsel;				/* PINSEL0 to PINSEL4 */
+	uint32_t pin_mask;
+	uint32_t pin_func;
+} uart_port_t;
+
+static const uart_port_t uart_ports[UART_PORTS] = {
+	{ UART0_BUFFERS, UART0_IRQn, 0,  6, 1 << 3,  0, 0x000000F0, 0x00000050 },	/* TxD0 P0.2, RxD0 P0.3 */
+	{ UART1_BUFFERS, UART1_IRQn, 0,  8, 1 << 4,  4, 0x0000000F, 0x0000000A },	/* TxD1 P2.0, RxD1 P2.1 */
+	{ UART2_BUFFERS, UART2_IRQn, 1, 16, 1 << 24, 0, 0x00F00000, 0x00500000 },	/* TxD2 P0.10, RxD2 P0.11 */
+	{ UART3_BUFFERS, UART3_IRQn, 1, 18, 1 << 25, 0, 0x0000000F, 0x0000000A },	/* TxD3 P0.0, RxD3 P0.1 */
+};
+
+/* FCR is write only: the FIFO enable, DMA mode and trigger bits of each port */
+static uint8_t uart_fcr[UART_PORTS];
+
+#define UART_FCR_TRIGGER(level)	(((level) >= 14) ? FCR_TRIGGER_14 : ((level) >= 8) ? FCR_TRIGGER_8 : \
+								 ((level) >= 4) ? FCR_TRIGGER_4 : FCR_TRIGGER_1)
+
+UART_FAST uint8_t fifo_put(UARTFifo_t *fifo, uint8_t c)
 {
-	int next;
+	uint32_t head = fifo->head;
 
 	// check if FIFO has room
-	next = (fifo->head + 1) % UART_BUFSIZE;
-	if (next == fifo->tail) {
+	if (head - fifo->tail > fifo->mask) {
 		// full
 		return 0;
 	}
 
-	fifo->buffer[fifo->head] = c;
-	fifo->head = next;
+	fifo->buffer[head & fifo->mask] = c;
+	fifo->head = head + 1;
 
 	return 1;
 }
 
 static uint8_t fifo_get(UARTFifo_t *fifo, uint8_t *pc)
 {
-	int next;
+	uint32_t tail = fifo->tail;
 
 	// check if FIFO has data
-	if (fifo->head == fifo->tail) {
+	if (fifo->head == tail) {
 		return 0;
 	}
 
-	next = (fifo->tail + 1) % UART_BUFSIZE;
-
-	*pc = fifo->buffer[fifo->tail];
-	fifo->tail = next;
+	*pc = fifo->buffer[tail & fifo->mask];
+	fifo->tail = tail + 1;
 
 	return 1;
 }
 
+static UARTFifo_t *uart_fifo(uint32_t portNum)
+{
+	return (portNum < UART_PORTS) ? uart_ports[portNum].rx : NULL;
+}
+
+static UARTTxFifo_t *uart_tx_fifo(uint32_t portNum)
+{
+	return (portNum < UART_PORTS) ? uart_ports[portNum].tx : NULL;
+}
+
+/* The ports share the register layout, UART1 adds the modem registers */
+UART_FAST LPC_UART_TypeDef *uart_regs(uint32_t portNum)
+{
+	switch(portNum)
+	{
+	case 0:
+		return (LPC_UART_TypeDef *) LPC_UART0;
+	case 1:
+		return (LPC_UART_TypeDef *) LPC_UART1;
+	case 2:
+		return LPC_UART2;
+	case 3:
+		return LPC_UART3;
+	default:
+		return NULL;
+	}
+}
+
+/* UART0 to UART3 have consecutive interrupt numbers */
+#define UART_IRQ(portNum)	((IRQn_Type) (UART0_IRQn + (portNum)))
+
+/* GPDMA channels 4 to 7 carry the transmitters of UART0 to UART3, channels
+ * 0 to 3 their receivers */
+#define UART_DMA_CHANNEL(portNum)	(4 + (portNum))
+#define UART_DMA_RX_CHANNEL(portNum)	(portNum)
+#define UART_DMA_TX_REQUEST(portNum)	(8 + (2 * (portNum)))
+#define UART_DMA_RX_REQUEST(portNum)	(9 + (2 * (portNum)))
+
+#define DMA_CONTROL_SI		(1UL << 26)			/* source increment */
+#define DMA_CONTROL_DI		(1UL << 27)			/* destination increment */
+#define DMA_CONTROL_I		(1UL << 31)			/* terminal count interrupt */
+#define DMA_CONFIG_M2P		(1UL << 11)
+#define DMA_CONFIG_P2M		(2UL << 11)
+#define DMA_CONFIG_IE		(1UL << 14)			/* error interrupt */
+#define DMA_CONFIG_ITC		(1UL << 15)			/* terminal count interrupt */
+
+/* A GPDMA linked list item, in the order of the channel registers */
+typedef struct {
+	uint32_t src;
+	uint32_t dst;
+	uint32_t lli;
+	uint32_t control;
+} uart_lli_t;
+
+/* DMA mode of a port: the transmit ring drained by the transmit channel, and
+ * the receive channel going round a buffer made of two halves */
+typedef struct {
+	uint8_t tx_enabled;
+	uint32_t tx_length;			/* bytes of the ring the channel is moving, 0 when idle */
+	UARTRxCallback_t rx_callback;
+	uint8_t *rx_buffer;
+	uint32_t rx_half;			/* length of each half */
+	uint32_t rx_index;			/* half being filled */
+	uint32_t rx_done;			/* bytes of that half passed on already */
+	uint32_t rx_seen;			/* bytes of that half at the last UARTReceiveDMAIdle() */
+	uart_lli_t rx_lli[2];
+} uart_dma_t;
+
+static uart_dma_t uart_dma[UART_PORTS];
+
+static LPC_GPDMACH_TypeDef *uart_dma_channel(uint32_t portNum)
+{
+	switch(portNum)
+	{
+	case 0:
+		return LPC_GPDMACH4;
+	case 1:
+		return LPC_GPDMACH5;
+	case 2:
+		return LPC_GPDMACH6;
+	case 3:
+		return LPC_GPDMACH7;
+	default:
+		return NULL;
+	}
+}
+
+static LPC_GPDMACH_TypeDef *uart_dma_rx_channel(uint32_t portNum)
+{
+	switch(portNum)
+	{
+	case 0:
+		return LPC_GPDMACH0;
+	case 1:
+		return LPC_GPDMACH1;
+	case 2:
+		return LPC_GPDMACH2;
+	case 3:
+		return LPC_GPDMACH3;
+	default:
+		return NULL;
+	}
+}
+
+/* The channels the ports in DMA mode run; the others may belong to other
+ * drivers, whose interrupt status is theirs to clear */
+static uint32_t uart_dma_owned(void)
+{
+	uint32_t portNum, owned = 0;
+
+	for (portNum = 0; portNum < UART_PORTS; portNum++) {
+		if (uart_dma[portNum].tx_enabled)
+			owned |= 1 << UART_DMA_CHANNEL(portNum);
+		if (uart_dma[portNum].rx_callback)
+			owned |= 1 << UART_DMA_RX_CHANNEL(portNum);
+	}
+	return owned;
+}
+
+/* Powers the GPDMA, routes the requests of the port to it rather than to the
+ * timer matches and puts the FIFOs in DMA mode */
+static void uart_dma_setup(uint32_t portNum)
+{
+	LPC_SC->PCONP |= 1 << 29;							/* Power up the GPDMA */
+	LPC_SC->DMAREQSEL &= ~(3 << (2 * portNum));			/* UART Tx and Rx, not the timer matches */
+	LPC_GPDMA->DMACConfig = 0x01;						/* Enable, little endian */
+
+	uart_fcr[portNum] |= FCR_DMA_MODE;
+	uart_regs(portNum)->FCR = uart_fcr[portNum];		/* FIFO enabled in DMA mode, no reset */
+}
+
+/* Empties the receive FIFO, for the receive, the character timeout and the
+ * line status interrupts alike. LSR holds the errors of the character at the
+ * head of the FIFO, so it is read before each one. */
+UART_FAST void uart_rx_drain(LPC_UART_TypeDef *uart, UARTFifo_t *fifo)
+{
+	uint8_t lsr, c;
+
+	for (;;) {
+		lsr = uart->LSR;
+		if (lsr & LSR_OE)
+			fifo->errors.overrun++;
+		if (!(lsr & LSR_RDR))
+			break;
+
+		c = uart->RBR;
+		if (lsr & LSR_BI) {
+			fifo->errors.breaks++;
+			continue;
+		}
+		if (lsr & LSR_FE)
+			fifo->errors.framing++;
+		if (lsr & LSR_PE)
+			fifo->errors.parity++;
+		if (!fifo_put(fifo, c))
+			fifo->errors.dropped++;
+	}
+}
+
+/* On a THRE interrupt the transmit FIFO is empty: it takes a burst of queued
+ * bytes, and the interrupt is turned off once nothing is left to send */
+UART_FAST void uart_tx_refill(LPC_UART_TypeDef *uart, UARTTxFifo_t *fifo)
+{
+	uint32_t tail = fifo->tail;
+	uint32_t count = fifo->head - tail;
+
+	if (count > UART_TX_BURST)
+		count = UART_TX_BURST;
+
+	while (count--) {
+		uart->THR = fifo->buffer[tail & fifo->mask];
+		tail++;
+	}
+	fifo->tail = tail;
+
+	if (tail == fifo->head)
+		uart->IER &= ~IER_THRE;
+}
+
+/* Hands the oldest contiguous run of the transmit ring to the transmit
+ * channel; the terminal count interrupt frees it and starts the next one */
+static void uart_tx_dma_start(uint32_t portNum)
+{
+	UARTTxFifo_t *fifo = uart_tx_fifo(portNum);
+	LPC_GPDMACH_TypeDef *channel = uart_dma_channel(portNum);
+	uint32_t tail = fifo->tail;
+	uint32_t count = fifo->head - tail;
+
+	if (count > (fifo->mask + 1) - (tail & fifo->mask))
+		count = (fifo->mask + 1) - (tail & fifo->mask);
+	if (count > UART_DMA_MAX_LENGTH)
+		count = UART_DMA_MAX_LENGTH;
+
+	uart_dma[portNum].tx_length = count;
+	if (count == 0)
+		return;
+
+	channel->DMACCSrcAddr = (uint32_t) &fifo->buffer[tail & fifo->mask];
+	channel->DMACCDestAddr = (uint32_t) &uart_regs(portNum)->THR;
+	channel->DMACCLLI = 0;
+	channel->DMACCControl = count | DMA_CONTROL_SI | DMA_CONTROL_I;
+	channel->DMACCConfig = 0x01 | (UART_DMA_TX_REQUEST(portNum) << 6) | DMA_CONFIG_M2P | DMA_CONFIG_IE | DMA_CONFIG_ITC;
+}
+
+/* Queues up to Length bytes, waiting for room if wait is set. Enabling the THRE
+ * interrupt of an idle transmitter raises it, so the handler starts sending;
+ * in DMA mode an idle transmit channel is started instead. */
+static uint32_t uart_tx_write(uint32_t portNum, const uint8_t *BufferPtr, uint32_t Length, uint32_t wait)
+{
+	LPC_UART_TypeDef *uart = uart_regs(portNum);
+	UARTTxFifo_t *fifo = uart_tx_fifo(portNum);
+	uint32_t queued = 0;
+	uint32_t head, room, count;
+
+	if (fifo == NULL)
+		return 0;
+
+	while (queued < Length)
+	{
+		head = fifo->head;
+		room = (fifo->mask + 1) - (head - fifo->tail);
+		if (room == 0)
+		{
+			if (!wait)
+				break;
+			continue;				/* the interrupt handler makes room */
+		}
+
+		count = Length - queued;
+		if (count > room)
+			count = room;
+		queued += count;
+
+		while (count--)
+			fifo->buffer[head++ & fifo->mask] = *BufferPtr++;
+
+		if (uart_dma[portNum].tx_enabled)
+		{
+			NVIC_DisableIRQ(DMA_IRQn);
+			fifo->head = head;
+			if (uart_dma[portNum].tx_length == 0)
+				uart_tx_dma_start(portNum);
+			NVIC_EnableIRQ(DMA_IRQn);
+		}
+		else
+		{
+			NVIC_DisableIRQ(UART_IRQ(portNum));
+			fifo->head = head;
+			if (!(uart->IER & IER_THRE))
+				uart->IER |= IER_THRE;
+			NVIC_EnableIRQ(UART_IRQ(portNum));
+		}
+	}
+	return queued;
+}
+
+/* Body of the interrupt handlers */
+UART_FAST void uart_isr(uint32_t portNum)
+{
+  LPC_UART_TypeDef *uart = uart_regs(portNum);
+  uint8_t IIRValue;
+
+  if ( uart_ports[portNum].rx == NULL )
+	return;
+
+  IIRValue = uart->IIR;
 
+  IIRValue >>= 1;			/* skip pending bit in IIR */
+  IIRValue &= 0x07;			/* check bit 1~3, interrupt identification */
+  if ( IIRValue == IIR_RLS || IIRValue == IIR_RDA || IIRValue == IIR_CTI )
+  {
+	/* Line status, Receive Data Available or Character Time-out */
+	uart_rx_drain(uart, uart_ports[portNum].rx);
+  }
+  else if ( IIRValue == IIR_THRE )	/* THRE, the transmit FIFO is empty */
+  {
+	uart_tx_refill(uart, uart_ports[portNum].tx);
+  }
+}
 
 /*****************************************************************************
 ** Function name:		UART0_IRQHandler
@@ -82,17 +426,7 @@ static uint8_t fifo_get(UARTFifo_t *fifo, uint8_t *pc)
 *****************************************************************************/
 void UART0_IRQHandler (void)
 {
-  uint8_t IIRValue;
-
-  IIRValue = LPC_UART0->IIR;
-
-  IIRValue >>= 1;			/* skip pending bit in IIR */
-  IIRValue &= 0x07;			/* check bit 1~3, interrupt identification */
-  if ( IIRValue == IIR_RDA )	/* Receive Data Available */
-  {
-	/* Receive Data Available */
-	fifo_put(&UART0Buffer, LPC_UART0->RBR);
-  }
+  uart_isr(0);
 }
 
 /*****************************************************************************
@@ -106,22 +440,27 @@ void UART0_IRQHandler (void)
 *****************************************************************************/
 void UART1_IRQHandler (void)
 {
-  uint8_t IIRValue;
-
-  IIRValue = LPC_UART1->IIR;
+  uart_isr(1);
+}
 
-  IIRValue >>= 1;			/* skip pending bit in IIR */
-  IIRValue &= 0x07;			/* check bit 1~3, interrupt identification */
-  if ( IIRValue == IIR_RDA )	/* Receive Data Available */
-  {
-	/* Receive Data Available */
-	fifo_put(&UART1Buffer, LPC_UART1->RBR);
-  }
+/*****************************************************************************
+** Function name:		UART2_IRQHandler
+**
+** Descriptions:		UART2 interrupt handler
+**
+** parameters:			None
+** Returned value:		None
+**
+*****************************************************************************/
+void UART2_IRQHandler (void)
+{
+  uart_isr(2);
 }
+
 /*****************************************************************************
-** Function name:		UART0_IRQHandler
+** Function name:		UART3_IRQHandler
 **
-** Descriptions:		UART0 interrupt handler
+** Descriptions:		UART3 interrupt handler
 **
 ** parameters:			None
 ** Returned value:		None
@@ -129,19 +468,77 @@ void UART1_IRQHandler (void)
 *****************************************************************************/
 void UART3_IRQHandler (void)
 {
-  uint8_t IIRValue;
+  uart_isr(3);
+}
+
+/* PCLK of the port: CCLK/4 after reset */
+static uint32_t uart_pclk(uint32_t portNum)
+{
+	const uart_port_t *port = &uart_ports[portNum];
 
-  IIRValue = LPC_UART3->IIR;
+	switch (((&LPC_SC->PCLKSEL0)[port->pclksel] >> port->pclk_shift) & 0x03)
+	{
+	case 0x01:
+		return SystemCoreClock;
+	case 0x02:
+		return SystemCoreClock / 2;
+	case 0x03:
+		return SystemCoreClock / 8;
+	default:
+		return SystemCoreClock / 4;
+	}
+}
 
-  IIRValue >>= 1;			/* skip pending bit in IIR */
-  IIRValue &= 0x07;			/* check bit 1~3, interrupt identification */
-if ( IIRValue == IIR_RDA )	/* Receive Data Available */
-  {
-	/* Receive Data Available */
-	fifo_put(&UART3Buffer, LPC_UART3->RBR);
-  }
+/* Divisor latch and fractional divider closest to baudrate, which is
+ * pclk / (16 * DL * (1 + DIVADDVAL / MULVAL)) with 1 <= MULVAL <= 15 and
+ * DIVADDVAL < MULVAL; DL must be 3 or more while DIVADDVAL is not 0. The
+ * divisor alone (FDR 0x10) is kept unless a fraction gets closer. Returns
+ * the FDR value. */
+static uint8_t uart_divisors(uint32_t pclk, uint32_t baudrate, uint32_t *divisor)
+{
+	uint32_t mul, divadd, dl, denominator, rate, error;
+	uint32_t best_error = 0xFFFFFFFF;
+	uint8_t fdr = 0x10;
+
+	*divisor = 1;
+	if (baudrate == 0)
+		return fdr;
+
+	for (mul = 1; (mul <= 15) && best_error; mul++)
+	{
+		for (divadd = 0; (divadd < mul) && best_error; divadd++)
+		{
+			denominator = 16 * baudrate * (mul + divadd);
+			dl = ((pclk * mul) + (denominator / 2)) / denominator;
+			if ((dl == 0) || (dl > 0xFFFF) || (divadd && (dl < 3)))
+				continue;
+
+			rate = (pclk * mul) / (16 * dl * (mul + divadd));
+			error = (rate > baudrate) ? (rate - baudrate) : (baudrate - rate);
+			if (error < best_error)
+			{
+				best_error = error;
+				*divisor = dl;
+				fdr = (mul << 4) | divadd;
+			}
+		}
+	}
+	return fdr;
 }
 
+static void uart_set_baudrate(uint32_t portNum, uint32_t baudrate)
+{
+	LPC_UART_TypeDef *uart = uart_regs(portNum);
+	uint32_t dl;
+	uint8_t fdr;
+
+	fdr = uart_divisors(uart_pclk(portNum), baudrate, &dl);
+	uart->LCR |= LCR_DLAB;		/* the divisor latches sit behind DLAB */
+	uart->DLM = dl / 256;
+	uart->DLL = dl % 256;
+	uart->LCR &= ~LCR_DLAB;
+	uart->FDR = fdr;
+}
 
 /*****************************************************************************
 ** Function name:		UARTInit
@@ -149,226 +546,128 @@ if ( IIRValue == IIR_RDA )	/* Receive Data Available */
 ** Descriptions:		Initialize UART port, setup pin select,
 **						clock, parity, stop bits, FIFO, etc.
 **
-** parameters:			portNum(0 or 1) and UART baudrate
+** parameters:			portNum(0 to 3) and UART baudrate
 ** Returned value:		true or false, return false only if the
-**						interrupt handler can't be installed to the
-**						VIC table
+**						port does not exist or has no buffers
 **
 *****************************************************************************/
 uint32_t UARTInit( uint32_t PortNum, uint32_t baudrate )
 {
-  uint32_t Fdiv;
-  uint32_t pclkdiv, pclk;
+  const uart_port_t *port;
+  LPC_UART_TypeDef *uart;
+  volatile uint32_t *pinsel;
 
-  if ( PortNum == 0 )
-  {
-	LPC_PINCON->PINSEL0 &= ~0x000000F0;
-	LPC_PINCON->PINSEL0 |= 0x00000050;  /* RxD0 is P0.3 and TxD0 is P0.2 */
-	/* By default, the PCLKSELx value is zero, thus, the PCLK for
-	all the peripherals is 1/4 of the SystemFrequency. */
-	/* Bit 6~7 is for UART0 */
-	pclkdiv = (LPC_SC->PCLKSEL0 >> 6) & 0x03;
-	switch ( pclkdiv )
-	{
-	  case 0x00:
-	  default:
-		pclk = SystemCoreClock/4;
-		break;
-	  case 0x01:
-		pclk = SystemCoreClock;
-		break;
-	  case 0x02:
-		pclk = SystemCoreClock/2;
-		break;
-	  case 0x03:
-		pclk = SystemCoreClock/8;
-		break;
-	}
+  if ( (PortNum >= UART_PORTS) || (uart_ports[PortNum].rx == NULL) )
+	return (0);
 
-    LPC_UART0->LCR = 0x83;		/* 8 bits, no Parity, 1 Stop bit */
-	Fdiv = ( pclk / 16 ) / baudrate ;	/*baud rate */
-    LPC_UART0->DLM = Fdiv / 256;
-    LPC_UART0->DLL = Fdiv % 256;
-	LPC_UART0->LCR = 0x03;		/* DLAB = 0 */
-    LPC_UART0->FCR = 0x07;		/* Enable and reset TX and RX FIFO. */
+  port = &uart_ports[PortNum];
+  uart = uart_regs(PortNum);
+  pinsel = &(&LPC_PINCON->PINSEL0)[port->pinsel];
 
-   	NVIC_EnableIRQ(UART0_IRQn);
+  LPC_SC->PCONP |= port->pconp;
+  *pinsel = (*pinsel & ~port->pin_mask) | port->pin_func;
 
-    LPC_UART0->IER = IER_RBR;	/* Enable UART0 interrupt */
-    return (1);
-  }
-  else if ( PortNum == 1 )
-  {
-	LPC_PINCON->PINSEL4 &= ~0x0000000F;
-	LPC_PINCON->PINSEL4 |= 0x0000000A;	/* Enable RxD1 P2.1, TxD1 P2.0 */
-
-	/* By default, the PCLKSELx value is zero, thus, the PCLK for
-	all the peripherals is 1/4 of the SystemFrequency. */
-	/* Bit 8,9 are for UART1 */
-	pclkdiv = (LPC_SC->PCLKSEL0 >> 8) & 0x03;
-	switch ( pclkdiv )
-	{
-	  case 0x00:
-	  default:
-		pclk = SystemCoreClock/4;
-		break;
-	  case 0x01:
-		pclk = SystemCoreClock;
-		break;
-	  case 0x02:
-		pclk = SystemCoreClock/2;
-		break;
-	  case 0x03:
-		pclk = SystemCoreClock/8;
-		break;
-	}
+  uart->LCR = 0x03;		/* 8 bits, no Parity, 1 Stop bit */
+  uart_set_baudrate(PortNum, baudrate);
 
-    LPC_UART1->LCR = 0x83;		/* 8 bits, no Parity, 1 Stop bit */
-	Fdiv = ( pclk / 16 ) / baudrate ;	/*baud rate */
-    LPC_UART1->DLM = Fdiv / 256;
-    LPC_UART1->DLL = Fdiv % 256;
-	LPC_UART1->LCR = 0x03;		/* DLAB = 0 */
-    LPC_UART1->FCR = 0x07;		/* Enable and reset TX and RX FIFO. */
+  uart_fcr[PortNum] = FCR_FIFO_ENABLE | UART_FCR_TRIGGER(UART_RX_TRIGGER);
+  uart->FCR = uart_fcr[PortNum] | FCR_RX_RESET | FCR_TX_RESET;	/* Enable and reset TX and RX FIFO. */
 
-   	NVIC_EnableIRQ(UART1_IRQn);
+  port->rx->head = port->rx->tail = 0;
+  port->tx->head = port->tx->tail = 0;
+  memset(&port->rx->errors, 0, sizeof(UARTErrors_t));
 
-    LPC_UART1->IER = IER_RBR;	/* Enable UART1 interrupt */
-    return (1);
-  }
-  else if ( PortNum == 3 )
-  {
-	  LPC_PINCON->PINSEL0 &= ~0x0000000F;
-	  LPC_PINCON->PINSEL0 |=  0x0000000A;  /* RxD3 is P0.1 and TxD3 is P0.0 */
-	  LPC_SC->PCONP |= 1<<4 | 1<<25; //Enable PCUART1
-	  /* By default, the PCLKSELx value is zero, thus, the PCLK for
-		all the peripherals is 1/4 of the SystemFrequency. */
-	  /* Bit 6~7 is for UART3 */
-	  pclkdiv = (LPC_SC->PCLKSEL1 >> 18) & 0x03;
-	  switch ( pclkdiv )
-	  {
-	  case 0x00:
-	  default:
-		  pclk = SystemCoreClock/4;
-		  break;
-	  case 0x01:
-		  pclk = SystemCoreClock;
-		  break;
-	  case 0x02:
-		  pclk = SystemCoreClock/2;
-		  break;
-	  case 0x03:
-		  pclk = SystemCoreClock/8;
-		  break;
-	  }
-	  LPC_UART3->LCR = 0x83;		/* 8 bits, no Parity, 1 Stop bit */
-	  Fdiv = ( pclk / 16 ) / baudrate ;	/*baud rate */
-	  LPC_UART3->DLM = Fdiv / 256;
-	  LPC_UART3->DLL = Fdiv % 256;
-	  LPC_UART3->LCR = 0x03;		/* DLAB = 0 */
-	  LPC_UART3->FCR = 0x07;		/* Enable and reset TX and RX FIFO. */
-
-	  NVIC_EnableIRQ(UART3_IRQn);
-
-	  LPC_UART3->IER = IER_RBR;	/* Enable UART3 interrupt */
-	  return (1);
-  }
-  return(0);
+  NVIC_EnableIRQ(port->irq);
+
+  uart->IER = IER_RBR | IER_RLS;	/* Enable UART interrupt */
+  return (1);
 }
 
 /*****************************************************************************
 ** Function name:		UARTBaudrate
 **
-** Descriptions:		Set the baud rate for the given port.
+** Descriptions:		Set the baud rate for the given port, with the
+**						fractional divider when that gets closer.
 **                      This function needs to be called after changing
 **                      the SystemCoreClock.
 **
-** parameters:			portNum(0 or 1) and UART baudrate
+** parameters:			portNum(0 to 3) and UART baudrate
 ** Returned value:		none
 **
 *****************************************************************************/
 void UARTBaudrate( uint32_t PortNum, uint32_t baudrate )
 {
-  uint32_t Fdiv;
-  uint32_t pclkdiv, pclk;
+  if ( PortNum < UART_PORTS )
+	uart_set_baudrate(PortNum, baudrate);
+}
 
-  if ( PortNum == 0 )
-  {
-	pclkdiv = (LPC_SC->PCLKSEL0 >> 6) & 0x03;
-	switch ( pclkdiv )
-	{
-	  case 0x00:
-	  default:
-		pclk = SystemCoreClock/4;
-		break;
-	  case 0x01:
-		pclk = SystemCoreClock;
-		break;
-	  case 0x02:
-		pclk = SystemCoreClock/2;
-		break;
-	  case 0x03:
-		pclk = SystemCoreClock/8;
-		break;
-	}
+/*****************************************************************************
+** Function name:		UARTLineControl
+**
+** Descriptions:		Set the word length, parity and stop bits of
+**						the given port from the LCR_ bits in uart.h.
+**
+** parameters:			portNum and line control value
+** Returned value:		none
+**
+*****************************************************************************/
+void UARTLineControl( uint32_t portNum, uint8_t lcr )
+{
+  LPC_UART_TypeDef *uart = uart_regs(portNum);
 
-	Fdiv = ( pclk / 16 ) / baudrate ;	/*baud rate */
-    LPC_UART0->DLM = Fdiv / 256;
-    LPC_UART0->DLL = Fdiv % 256;
-  }
-  else if ( PortNum == 1 )
-  {
-	pclkdiv = (LPC_SC->PCLKSEL0 >> 8) & 0x03;
-	switch ( pclkdiv )
-	{
-	  case 0x00:
-	  default:
-		pclk = SystemCoreClock/4;
-		break;
-	  case 0x01:
-		pclk = SystemCoreClock;
-		break;
-	  case 0x02:
-		pclk = SystemCoreClock/2;
-		break;
-	  case 0x03:
-		pclk = SystemCoreClock/8;
-		break;
-	}
+  if ( uart != NULL )
+	uart->LCR = lcr & ~LCR_DLAB;
+}
 
- 	Fdiv = ( pclk / 16 ) / baudrate ;	/*baud rate */
-    LPC_UART1->DLM = Fdiv / 256;
-    LPC_UART1->DLL = Fdiv % 256;
-  }
-  else if ( PortNum == 3 )
+/*****************************************************************************
+** Function name:		UARTSetRxTrigger
+**
+** Descriptions:		Set the receive FIFO level that raises the receive
+**						interrupt: 1, 4, 8 or 14 characters, rounded down.
+**						A higher level means fewer interrupts, and less
+**						time before the FIFO overruns when the handler is
+**						held off.
+**
+** parameters:			portNum and trigger level
+** Returned value:		none
+**
+*****************************************************************************/
+void UARTSetRxTrigger( uint32_t portNum, uint32_t level )
+{
+  LPC_UART_TypeDef *uart = uart_regs(portNum);
+
+  if ( uart != NULL )
   {
-	  pclkdiv = (LPC_SC->PCLKSEL1 >> 18) & 0x03;
-	  switch ( pclkdiv )
-	  {
-	  case 0x00:
-	  default:
-		  pclk = SystemCoreClock/4;
-		  break;
-	  case 0x01:
-		  pclk = SystemCoreClock;
-		  break;
-	  case 0x02:
-		  pclk = SystemCoreClock/2;
-		  break;
-	  case 0x03:
-		  pclk = SystemCoreClock/8;
-		  break;
-	  }
-	  Fdiv = ( pclk / 16 ) / baudrate ;	/*baud rate */
-	  LPC_UART3->DLM = Fdiv / 256;
-	  LPC_UART3->DLL = Fdiv % 256;
+	uart_fcr[portNum] = (uart_fcr[portNum] & ~FCR_TRIGGER_14) | UART_FCR_TRIGGER(level);
+	uart->FCR = uart_fcr[portNum];
   }
 }
 
+/*****************************************************************************
+** Function name:		UARTGetErrors
+**
+** Descriptions:		Copy the receive error counters of the given port
+**
+** parameters:			portNum and counters to fill in
+** Returned value:		none
+**
+*****************************************************************************/
+void UARTGetErrors( uint32_t portNum, UARTErrors_t *errors )
+{
+  UARTFifo_t *fifo = uart_fifo(portNum);
+
+  if ( fifo != NULL )
+	*errors = fifo->errors;
+  else
+	memset(errors, 0, sizeof(UARTErrors_t));
+}
+
 /*****************************************************************************
 ** Function name:		UARTSend
 **
-** Descriptions:		Send a block of data to the UART 0 port based
-**						on the data length
+** Descriptions:		Queue a block of data for the UART port, waiting
+**						for room in the transmit buffer when it is full.
+**						The THRE interrupt sends it in the background.
 **
 ** parameters:			portNum, buffer pointer, and data length
 ** Returned value:		None
@@ -376,89 +675,32 @@ void UARTBaudrate( uint32_t PortNum, uint32_t baudrate )
 *****************************************************************************/
 void UARTSend( uint32_t portNum, uint8_t *BufferPtr, uint32_t Length )
 {
-  if ( portNum == 0 )
-  {
-    while ( Length != 0 )
-    {
-	  while (!(LPC_UART0->LSR & LSR_THRE));
-	  LPC_UART0->THR = *BufferPtr;
-	  BufferPtr++;
-	  Length--;
-	}
-  }
-  else if (portNum == 1)
-  {
-	while ( Length != 0 )
-    {
-	  while (!(LPC_UART1->LSR & LSR_THRE));
-	  LPC_UART1->THR = *BufferPtr;
-	  BufferPtr++;
-	  Length--;
-    }
-  }
-  else if ( portNum == 3 )
-  {
-    while ( Length != 0 )
-    {
-  	  while (!(LPC_UART3->LSR & LSR_THRE));
-	  LPC_UART3->THR = *BufferPtr;
-	  BufferPtr++;
-	  Length--;
-	}
-  }
+  uart_tx_write(portNum, BufferPtr, Length, 1);
   return;
 }
 
 /*****************************************************************************
 ** Function name:		UARTPutStr
 **
-** Descriptions:		Send a block of data to the UART 0 port based
-**						on the data length
+** Descriptions:		Queue a string for the UART port, with a carriage
+**						return before each line feed
 **
-** parameters:			portNum, buffer pointer, and data length
+** parameters:			portNum, string pointer
 ** Returned value:		None
 **
 *****************************************************************************/
 void UARTSendStr( uint32_t portNum, char *BufferPtr )
 {
-	uint32_t Length;
-
-	Length = strlen(BufferPtr);
-	  if ( portNum == 0 )
-	  {
-	    while ( Length != 0 )
-	    {
-	  	  while (!(LPC_UART0->LSR & LSR_THRE));
-		  if(*BufferPtr == '\n') LPC_UART0->THR = '\r';
-		  LPC_UART0->THR = *BufferPtr;
-		  BufferPtr++;
-		  Length--;
-		}
-	  }
-	  else if (portNum == 1)
-	  {
-		while ( Length != 0 )
-	    {
-		  while (!(LPC_UART1->LSR & LSR_THRE));
-		  if(*BufferPtr == '\n') LPC_UART1->THR = '\r';
-		  LPC_UART1->THR = *BufferPtr;
-		  BufferPtr++;
-		  Length--;
-	    }
-	  }
-	  else if ( portNum == 3 )
-	  {
-	    while ( Length != 0 )
-	    {
-	  	  while (!(LPC_UART3->LSR & LSR_THRE));
-		  if(*BufferPtr == '\n') LPC_UART3->THR = '\r';
-		  LPC_UART3->THR = *BufferPtr;
-		  BufferPtr++;
-		  Length--;
-		}
-	  }
-	  return;
+  char *lf;
 
+  while ( (lf = strchr(BufferPtr, '\n')) != NULL )
+  {
+	uart_tx_write(portNum, (uint8_t *) BufferPtr, lf - BufferPtr, 1);
+	uart_tx_write(portNum, (const uint8_t *) "\r\n", 2, 1);
+	BufferPtr = lf + 1;
+  }
+  uart_tx_write(portNum, (uint8_t *) BufferPtr, strlen(BufferPtr), 1);
+  return;
 }
 
 /*
@@ -467,21 +709,47 @@ void UARTSendStr( uint32_t portNum, char *BufferPtr )
 
 void UARTPutChar(uint32_t portNum, char c)
 {
-  if ( portNum == 0 )
-  {
-	  while (!(LPC_UART0->LSR & LSR_THRE));
-	  LPC_UART0->THR = c;
-  }
-  else if (portNum == 1)
-  {
-	  while (!(LPC_UART1->LSR & LSR_THRE));
-	  LPC_UART1->THR = c;
-  }
-  else if ( portNum == 3 )
-  {
-  	  while (!(LPC_UART3->LSR & LSR_THRE));
-	  LPC_UART3->THR = c;
-  }
+  uart_tx_write(portNum, (uint8_t *) &c, 1, 1);
+  return;
+}
+
+/*****************************************************************************
+** Function name:		UARTTransmit
+**
+** Descriptions:		Queue as much of a block as the transmit buffer
+**						takes, without waiting. Like UARTSend() it must not
+**						be called from a handler the UART interrupt cannot
+**						preempt, nor mixed with UARTSendDMA() on a port.
+**
+** parameters:			portNum, buffer pointer, and data length
+** Returned value:		Number of bytes queued
+**
+*****************************************************************************/
+uint32_t UARTTransmit( uint32_t portNum, const uint8_t *BufferPtr, uint32_t Length )
+{
+  return uart_tx_write(portNum, BufferPtr, Length, 0);
+}
+
+/*****************************************************************************
+** Function name:		UARTFlush
+**
+** Descriptions:		Wait until the queued data has left the shift
+**						register, e.g. before changing the baudrate
+**
+** parameters:			portNum
+** Returned value:		None
+**
+*****************************************************************************/
+void UARTFlush( uint32_t portNum )
+{
+  LPC_UART_TypeDef *uart = uart_regs(portNum);
+  UARTTxFifo_t *fifo = uart_tx_fifo(portNum);
+
+  if ( fifo == NULL )
+	return;
+
+  while ( fifo->head != fifo->tail );
+  while ( !(uart->LSR & LSR_TEMT) );
   return;
 }
 
@@ -497,30 +765,296 @@ void UARTPutChar(uint32_t portNum, char c)
 *****************************************************************************/
 char UARTGetChar( uint32_t portNum)
 {
-	UARTFifo_t *fifo;
+	UARTFifo_t *fifo = uart_fifo(portNum);
 	uint8_t c = '\0';
 
-	switch(portNum)
-	{
-	case 0:
-		fifo = &UART0Buffer;
-		break;
-	case 1:
-		fifo = &UART1Buffer;
-		break;
-	case 3:
-		fifo = &UART3Buffer;
-		break;
-	default:
-		fifo = NULL;
-		break;
-	}
 	if(fifo)
 		while(!fifo_get(fifo, &c));
 
 	return c;
 }
 
+/*****************************************************************************
+** Function name:		UARTReceive
+**
+** Descriptions:		Take up to Length characters received on the
+**                      given port. This function does not block.
+**
+** parameters:			portNum, buffer pointer, and buffer length
+** Returned value:		Number of characters taken
+**
+*****************************************************************************/
+uint32_t UARTReceive( uint32_t portNum, uint8_t *BufferPtr, uint32_t Length )
+{
+	UARTFifo_t *fifo = uart_fifo(portNum);
+	uint32_t count = 0;
+
+	if(fifo)
+		while((count < Length) && fifo_get(fifo, &BufferPtr[count]))
+			count++;
+
+	return count;
+}
+
+/*****************************************************************************
+** Function name:		UARTSendDMA
+**
+** Descriptions:		Start sending a block of data through the GPDMA
+**						channel of the port, with the UART FIFO in DMA
+**						mode. The buffer must stay untouched until
+**						UARTSendDMABusy() returns 0.
+**
+** parameters:			portNum, buffer pointer, and data length
+** Returned value:		Number of bytes queued, at most UART_DMA_MAX_LENGTH,
+**						0 while the previous block is still being sent
+**
+*****************************************************************************/
+uint32_t UARTSendDMA( uint32_t portNum, uint8_t *BufferPtr, uint32_t Length )
+{
+  LPC_UART_TypeDef *uart = uart_regs(portNum);
+  LPC_GPDMACH_TypeDef *channel = uart_dma_channel(portNum);
+
+  if ( (uart == NULL) || (Length == 0) || UARTSendDMABusy(portNum) )
+	return 0;
+  if ( Length > UART_DMA_MAX_LENGTH )
+	Length = UART_DMA_MAX_LENGTH;
+
+  uart_dma_setup(portNum);
+  LPC_GPDMA->DMACIntTCClear = 1 << UART_DMA_CHANNEL(portNum);
+  LPC_GPDMA->DMACIntErrClr = 1 << UART_DMA_CHANNEL(portNum);
+
+  channel->DMACCSrcAddr = (uint32_t) BufferPtr;
+  channel->DMACCDestAddr = (uint32_t) &uart->THR;
+  channel->DMACCLLI = 0;
+  channel->DMACCControl = Length | DMA_CONTROL_SI;		/* byte wide single transfers */
+  channel->DMACCConfig = 0x01 | (UART_DMA_TX_REQUEST(portNum) << 6) | DMA_CONFIG_M2P;
+
+  return Length;
+}
+
+/*****************************************************************************
+** Function name:		UARTSendDMABusy
+**
+** Descriptions:		Check whether the block passed to UARTSendDMA()
+**						is still being moved into the UART FIFO.
+**
+** parameters:			portNum
+** Returned value:		Non zero while the channel is enabled
+**
+*****************************************************************************/
+uint32_t UARTSendDMABusy( uint32_t portNum )
+{
+  if ( uart_dma_channel(portNum) == NULL )
+	return 0;
+
+  return LPC_GPDMA->DMACEnbldChns & (1 << UART_DMA_CHANNEL(portNum));
+}
+
+/*****************************************************************************
+** Function name:		DMA_IRQHandler
+**
+** Descriptions:		GPDMA interrupt handler: frees the run of the
+**						transmit ring a transmit channel has sent and
+**						passes each filled half of a receive buffer on.
+**						A transmit channel that failed gives its run up,
+**						a receive channel that failed hands the receiver
+**						back to the UART interrupt. Only the channels of
+**						the ports in DMA mode are looked at.
+**
+** parameters:			None
+** Returned value:		None
+**
+*****************************************************************************/
+void DMA_IRQHandler (void)
+{
+  uint32_t owned = uart_dma_owned();
+  uint32_t status = LPC_GPDMA->DMACIntTCStat & owned;
+  uint32_t errors = LPC_GPDMA->DMACIntErrStat & owned;
+  uint32_t portNum;
+  uart_dma_t *dma;
+
+  LPC_GPDMA->DMACIntTCClear = status;
+  LPC_GPDMA->DMACIntErrClr = errors;
+
+  for ( portNum = 0; portNum < UART_PORTS; portNum++ )
+  {
+	dma = &uart_dma[portNum];
+
+	if ( errors & (1 << UART_DMA_RX_CHANNEL(portNum)) )
+	{
+	  dma->rx_callback = NULL;
+	  uart_regs(portNum)->IER |= IER_RBR | IER_RLS;
+	}
+
+	/* A failed run is given up too: the channel stopped, how far it got is unknown */
+	if ( ((status | errors) & (1 << UART_DMA_CHANNEL(portNum))) && dma->tx_length )
+	{
+	  uart_tx_fifo(portNum)->tail += dma->tx_length;
+	  uart_tx_dma_start(portNum);
+	}
+
+	if ( (status & (1 << UART_DMA_RX_CHANNEL(portNum))) && dma->rx_callback )
+	{
+	  /* The channel has moved on to the other half by now */
+	  if ( dma->rx_done < dma->rx_half )
+		dma->rx_callback(portNum, &dma->rx_buffer[(dma->rx_index * dma->rx_half) + dma->rx_done],
+						 dma->rx_half - dma->rx_done);
+	  dma->rx_index ^= 1;
+	  dma->rx_done = 0;
+	  dma->rx_seen = 0;
+	}
+  }
+}
+
+/*****************************************************************************
+** Function name:		UARTTransmitDMA
+**
+** Descriptions:		Have the GPDMA send the transmit buffer of the port
+**						in place of the THRE interrupt, one interrupt per
+**						contiguous run of the buffer rather than per 16
+**						bytes. UARTSend() and the other senders queue as
+**						before. Waits for what was queued to be sent first.
+**						Not to be mixed with UARTSendDMA().
+**
+** parameters:			portNum, non zero to enable, zero to disable
+** Returned value:		None
+**
+*****************************************************************************/
+void UARTTransmitDMA( uint32_t portNum, uint32_t enable )
+{
+  LPC_UART_TypeDef *uart = uart_regs(portNum);
+
+  if ( uart_tx_fifo(portNum) == NULL )
+	return;
+
+  UARTFlush(portNum);
+  uart->IER &= ~IER_THRE;
+  if ( enable )
+  {
+	uart_dma_setup(portNum);
+	NVIC_EnableIRQ(DMA_IRQn);
+  }
+  uart_dma[portNum].tx_enabled = (enable != 0);
+}
+
+/*****************************************************************************
+** Function name:		UARTReceiveDMA
+**
+** Descriptions:		Have the GPDMA go round Buffer for good, taking the
+**						receiver off the interrupt handler. callback gets
+**						each half once it is full, from DMA_IRQHandler, and
+**						must be done with it before the channel comes back
+**						round to it, a half buffer time later.
+**						UARTReceiveDMAIdle() passes partly filled halves on.
+**						Stopped by UARTReceiveDMA() with a zero length.
+**
+** parameters:			portNum, buffer pointer, buffer length (even, at
+**						most twice UART_DMA_MAX_LENGTH) and callback
+** Returned value:		Length of each half, 0 if the length does not fit
+**
+*****************************************************************************/
+uint32_t UARTReceiveDMA( uint32_t portNum, uint8_t *BufferPtr, uint32_t Length, UARTRxCallback_t callback )
+{
+  LPC_UART_TypeDef *uart = uart_regs(portNum);
+  LPC_GPDMACH_TypeDef *channel = uart_dma_rx_channel(portNum);
+  uart_dma_t *dma = &uart_dma[portNum];
+  uint32_t half = Length / 2;
+  uint32_t i;
+
+  if ( uart_fifo(portNum) == NULL )
+	return 0;
+
+  /* Stop the channel and give the receiver back to the interrupt handler */
+  NVIC_DisableIRQ(DMA_IRQn);
+  channel->DMACCConfig = 0;
+  LPC_GPDMA->DMACIntTCClear = 1 << UART_DMA_RX_CHANNEL(portNum);
+  dma->rx_callback = NULL;
+  NVIC_EnableIRQ(DMA_IRQn);
+  uart->IER |= IER_RBR | IER_RLS;
+
+  if ( (half == 0) || (half > UART_DMA_MAX_LENGTH) || (callback == NULL) )
+	return 0;
+
+  /* Two items pointing at each other: a circular list over the two halves */
+  for ( i = 0; i < 2; i++ )
+  {
+	dma->rx_lli[i].src = (uint32_t) &uart->RBR;
+	dma->rx_lli[i].dst = (uint32_t) &BufferPtr[i * half];
+	dma->rx_lli[i].lli = (uint32_t) &dma->rx_lli[i ^ 1];
+	dma->rx_lli[i].control = half | DMA_CONTROL_DI | DMA_CONTROL_I;
+  }
+
+  dma->rx_buffer = BufferPtr;
+  dma->rx_half = half;
+  dma->rx_index = 0;
+  dma->rx_done = 0;
+  dma->rx_seen = 0;
+  dma->rx_callback = callback;
+
+  uart->IER &= ~(IER_RBR | IER_RLS);
+  uart_dma_setup(portNum);
+  LPC_GPDMA->DMACIntErrClr = 1 << UART_DMA_RX_CHANNEL(portNum);
+
+  channel->DMACCSrcAddr = dma->rx_lli[0].src;
+  channel->DMACCDestAddr = dma->rx_lli[0].dst;
+  channel->DMACCLLI = dma->rx_lli[0].lli;
+  channel->DMACCControl = dma->rx_lli[0].control;
+  channel->DMACCConfig = 0x01 | (UART_DMA_RX_REQUEST(portNum) << 1) | DMA_CONFIG_P2M | DMA_CONFIG_IE | DMA_CONFIG_ITC;
+
+  NVIC_EnableIRQ(DMA_IRQn);
+  return half;
+}
+
+/*****************************************************************************
+** Function name:		UARTReceiveDMAIdle
+**
+** Descriptions:		Line idle check of the DMA receiver, to be called
+**						periodically (e.g. from a tick): when nothing came
+**						in since the last call, the bytes of the half being
+**						filled that were not passed on yet go to the
+**						callback, one to two periods after the last one
+**						arrived. The period must be longer than the FIFO
+**						takes to reach its trigger level, and than the 4
+**						character times after which it hands the bytes
+**						below that level over. Also counts the overruns
+**						of the receive FIFO.
+**
+** parameters:			portNum
+** Returned value:		Number of bytes passed on
+**
+*****************************************************************************/
+uint32_t UARTReceiveDMAIdle( uint32_t portNum )
+{
+  LPC_GPDMACH_TypeDef *channel = uart_dma_rx_channel(portNum);
+  uart_dma_t *dma = &uart_dma[portNum];
+  uint32_t start, filled, count = 0;
+
+  if ( (uart_fifo(portNum) == NULL) || (dma->rx_callback == NULL) )
+	return 0;
+
+  if ( uart_regs(portNum)->LSR & LSR_OE )
+	uart_fifo(portNum)->errors.overrun++;
+
+  NVIC_DisableIRQ(DMA_IRQn);
+  start = (uint32_t) &dma->rx_buffer[dma->rx_index * dma->rx_half];
+  filled = channel->DMACCDestAddr - start;
+
+  /* A destination outside the half means it is full, its interrupt pending */
+  if ( filled < dma->rx_half )
+  {
+	if ( (filled == dma->rx_seen) && (filled > dma->rx_done) )
+	{
+	  count = filled - dma->rx_done;
+	  dma->rx_callback(portNum, (uint8_t *) start + dma->rx_done, count);
+	  dma->rx_done = filled;
+	}
+	dma->rx_seen = filled;
+  }
+  NVIC_EnableIRQ(DMA_IRQn);
+
+  return count;
+}
+
 /******************************************************************************
 **                            End Of File
 ******************************************************************************/